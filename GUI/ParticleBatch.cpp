@@ -0,0 +1,195 @@
+// Batch (command line) mode for the particle tool - see ParticleBatch.h
+//
+// This file and the game code it uses are native (not compiled with /clr), the same code the
+// game runs
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include "ParticleBatch.h"
+
+#include "../TankAssignment/Source/Common/Defines.h"
+#include "../TankAssignment/Source/Common/CTimer.h"
+#include "../TankAssignment/Source/Render/EmitterPool.h"
+#include "../TankAssignment/Source/Render/ParticlePresetFile.h"
+#include "../TankAssignment/Source/Data/CParseParticlePresets.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// Compiling
+//-----------------------------------------------------------------------------
+
+// Read authored presets from an XML file and write the compiled preset file. Returns false on failure
+bool CompilePresets( const string& sourceFileName, const string& compiledFileName )
+{
+	CParseParticlePresets parser;
+	vector<SParticlePreset> presets;
+	string error;
+	if (!parser.LoadPresets( sourceFileName, &presets, &error ) ||
+	    !CParticlePresetFile::Write( compiledFileName, presets, &error ))
+	{
+		cout << sourceFileName << ": " << error << endl;
+		return false;
+	}
+
+	// Read back what was written, as the game will
+	CParticlePresetFile check;
+	if (!check.Open( compiledFileName ) || check.GetNumPresets() != presets.size())
+	{
+		cout << compiledFileName << ": compiled file is not valid" << endl;
+		return false;
+	}
+	cout << sourceFileName << ": " << presets.size() << " presets -> " << compiledFileName
+	     << " (" << check.FileSize() << " bytes)" << endl;
+	for (TUInt32 preset = 0; preset < presets.size(); ++preset)
+	{
+		const SParticleEffectDesc& desc = presets[preset].desc;
+		cout << "  " << left << setw( 16 ) << presets[preset].name << right << " priority " << desc.priority
+		     << ", up to " << desc.maxParticles << " particles" << endl;
+	}
+	return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Benchmarking
+//-----------------------------------------------------------------------------
+
+// Frame time of the benchmark, as the game would run at 60Hz
+const TFloat32 kBenchFrameTime = 1.0f / 60.0f;
+
+// Distance between emitters, so effects are spread over an area as in the game
+const TFloat32 kBenchEmitterSpacing = 20.0f;
+
+// Simulate one preset with the given number of emitters for the given number of frames and
+// print the results. Each frame the live particles are gathered as they are for rendering
+void BenchPreset( const string& name, const SParticleEffectDesc& desc, TUInt32 numFrames, TUInt32 numEmitters )
+{
+	if (numEmitters == 0)
+	{
+		numEmitters = Max( 1u, Min( kMaxEmitters, kDefaultEffectParticles / desc.maxParticles ) );
+	}
+	numEmitters = Min( numEmitters, kMaxEmitters );
+
+	// Enough budget that the emitters are never culled, the preset's own limits are being tested
+	CEmitterPool pool( kMaxEmitters * kMaxEmitterParticles );
+	vector<SParticleVertex> vertices( pool.ParticleBudget() );
+	const TUInt32 gridSize = static_cast<TUInt32>(ceil( sqrt( static_cast<TFloat32>(numEmitters) ) ));
+
+	TUInt32 started = 0;
+	TUInt64 particlesUpdated = 0;
+	CTimer timer;
+	timer.Start();
+	for (TUInt32 frame = 0; frame < numFrames; ++frame)
+	{
+		// Keep the emitters running, restarting each position in turn
+		while (pool.NumActiveEmitters() < numEmitters)
+		{
+			TUInt32 position = started % numEmitters;
+			CVector3 emitterPosition( (position % gridSize) * kBenchEmitterSpacing, 0.0f,
+			                          (position / gridSize) * kBenchEmitterSpacing );
+			if (!pool.StartEffect( desc, emitterPosition ))  break;
+			++started;
+		}
+		particlesUpdated += pool.NumLiveParticles();
+		pool.Update( kBenchFrameTime );
+		pool.GatherParticles( &vertices[0] );
+	}
+	TFloat32 time = timer.GetTime();
+
+	// Particles are held once by the simulator (7 floats) and once for the vertex buffer
+	const TUInt32 peakParticles = pool.GetStats().peakParticles;
+	const TUInt32 bytesPerParticle = 7 * sizeof(TFloat32) + sizeof(SParticleVertex);
+	const TFloat32 frameTime = (numFrames > 0) ? time / numFrames : 0.0f;
+	cout << name << ": " << numEmitters << " emitters, " << numFrames << " frames, "
+	     << started << " effects started" << endl;
+	cout << "  " << fixed << setprecision( 3 ) << frameTime * 1000.0f << " ms/frame, "
+	     << setprecision( 1 ) << (time > 0.0f ? particlesUpdated / time / 1000000.0f : 0.0f) << "M particles/s" << endl;
+	cout << "  peak " << peakParticles << " particles (" << peakParticles / numEmitters << " per emitter), "
+	     << setprecision( 1 ) << peakParticles * bytesPerParticle / 1024.0f << " KB, "
+	     << numEmitters * desc.maxParticles * bytesPerParticle / 1024.0f << " KB reserved" << endl;
+	cout.unsetf( ios::floatfield );
+}
+
+// Benchmark the named preset in a compiled file, or all presets if no name is given. Returns
+// false if the file or preset can't be found
+bool BenchPresets( const string& fileName, const string& presetName, TUInt32 numFrames, TUInt32 numEmitters )
+{
+	CParticlePresetFile presets;
+	if (!presets.Open( fileName ))
+	{
+		cout << fileName << ": not a valid compiled preset file" << endl;
+		return false;
+	}
+
+	bool found = false;
+	for (TUInt32 preset = 0; preset < presets.GetNumPresets(); ++preset)
+	{
+		if (presetName.empty() || presetName == presets.GetPresetName( preset ))
+		{
+			BenchPreset( presets.GetPresetName( preset ), presets.GetPreset( preset ), numFrames, numEmitters );
+			found = true;
+		}
+	}
+	if (!found)
+	{
+		cout << fileName << ": no preset named '" << presetName << "'" << endl;
+	}
+	return found;
+}
+
+
+//-----------------------------------------------------------------------------
+// Command line
+//-----------------------------------------------------------------------------
+
+// Name of the compiled file for the given authored file (same name with a .pfx extension)
+string CompiledPresetFileName( const string& sourceFileName )
+{
+	string::size_type extension = sourceFileName.find_last_of( '.' );
+	string::size_type folder = sourceFileName.find_last_of( "\\/" );
+	if (extension == string::npos || (folder != string::npos && extension < folder))
+	{
+		return sourceFileName + ".pfx";
+	}
+	return sourceFileName.substr( 0, extension ) + ".pfx";
+}
+
+// Run the given batch command, returning the process exit code
+int RunParticleBatch( const vector<string>& args )
+{
+	if (args.size() >= 2 && args.size() <= 3 && args[0] == "compile")
+	{
+		string output = (args.size() == 3) ? args[2] : CompiledPresetFileName( args[1] );
+		return CompilePresets( args[1], output ) ? 0 : 1;
+	}
+
+	if (args.size() >= 2 && args[0] == "particle-bench")
+	{
+		string presetName;
+		TUInt32 numFrames = 600;
+		TUInt32 numEmitters = 0;
+		bool argsOK = true;
+		for (TUInt32 arg = 2; arg < args.size(); ++arg)
+		{
+			if      (args[arg] == "-frames" && arg + 1 < args.size())   numFrames = atoi( args[++arg].c_str() );
+			else if (args[arg] == "-emitters" && arg + 1 < args.size()) numEmitters = atoi( args[++arg].c_str() );
+			else if (args[arg][0] != '-' && presetName.empty())         presetName = args[arg];
+			else                                                       argsOK = false;
+		}
+		if (argsOK)
+		{
+			return BenchPresets( args[1], presetName, numFrames, numEmitters ) ? 0 : 1;
+		}
+	}
+
+	cout << "Usage: ParticleTool compile <presets.xml> [<presets.pfx>]" << endl;
+	cout << "       ParticleTool particle-bench <presets.pfx> [<preset>] [-frames <n>] [-emitters <n>]" << endl;
+	return 2;
+}
+
+
+} // namespace gen
@@ -0,0 +1,28 @@
+// Batch (command line) mode for the particle tool. Runs without the window or Direct3D, so
+// presets can be compiled and checked from build scripts:
+//
+//   ParticleTool compile <presets.xml> [<presets.pfx>]
+//     Read authored presets (see CParseParticlePresets.h), check them and write the compiled
+//     preset file the game loads (see ParticlePresetFile.h). The output defaults to the same
+//     name with a .pfx extension
+//
+//   ParticleTool particle-bench <presets.pfx> [<preset>] [-frames <n>] [-emitters <n>]
+//     Simulate a compiled preset (or all of them) on the CPU, exactly as the game's emitter
+//     pool does, for the given number of 60Hz frames (default 600). Emitters are restarted as
+//     they finish to keep the given number running (default as many as fit the game's effect
+//     budget). Reports the time per frame, particle throughput and peak particle memory
+
+#pragma once
+
+#include <vector>
+#include <string>
+using namespace std;
+
+namespace gen
+{
+
+// Run the given batch command (the command line arguments without the program name). Output
+// goes to standard output. Returns the process exit code, non-zero on failure
+int RunParticleBatch( const vector<string>& args );
+
+}
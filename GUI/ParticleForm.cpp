@@ -10,13 +10,16 @@
 // libraries that are available in C#, that you might remember from the 1st year
 
 #include <windows.h>
+#include <cstdio>
 #include "ParticleForm.h"
-#include "CTimer.h"
+#include "ParticleBatch.h"
+#include "../TankAssignment/Source/Common/CTimer.h"
 #include "../TankAssignment.h"
 
 
 using namespace System;
 using namespace System::Windows::Forms;
+using namespace System::Runtime::InteropServices;
 
 
 namespace gen
@@ -45,6 +48,24 @@ namespace gen
 	[STAThread]
 	void Main(array<String^>^ args)
 	{
+		// Any command line arguments run a batch command instead of the window (see ParticleBatch.h).
+		// This is a Windows program, so output goes to the console it was run from, if any
+		if (args->Length > 0)
+		{
+			if (AttachConsole(ATTACH_PARENT_PROCESS))
+			{
+				freopen("CONOUT$", "w", stdout);
+			}
+			std::vector<std::string> batchArgs;
+			for each (String^ arg in args)
+			{
+				IntPtr text = Marshal::StringToHGlobalAnsi(arg); // .NET string to C-style string
+				batchArgs.push_back(static_cast<const char*>(text.ToPointer()));
+				Marshal::FreeHGlobal(text);
+			}
+			Environment::Exit(RunParticleBatch(batchArgs));
+		}
+
 		// Enabling Windows visual effects before any controls are created
 		Application::EnableVisualStyles();
 		Application::SetCompatibleTextRenderingDefault(false);
@@ -10,7 +10,7 @@
 
 #include "Defines.h"
 #include "Input.h"
-#include "CTimer.h"
+#include "../../TankAssignment/Source/Common/CTimer.h"
 #include "CVector2.h"
 #include "TankAssignment.h"
 
@@ -0,0 +1,11 @@
+/*******************************************
+	BenchmarkMain.cpp
+
+	Entry point for the benchmark executable.
+	Benchmarks register themselves from their
+	own files, see e.g. MathBenchmark.cpp
+********************************************/
+
+#include <benchmark/benchmark.h>
+
+BENCHMARK_MAIN();
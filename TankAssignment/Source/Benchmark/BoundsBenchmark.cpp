@@ -0,0 +1,203 @@
+/*******************************************
+	BoundsBenchmark.cpp
+
+	Mesh bounds benchmarks. Sub-meshes of
+	random vertices with normals and texture
+	coordinates are bounded with the scalar
+	loop CMesh::PreProcess used to use, with
+	the SSE bounds functions, and with several
+	sub-meshes spread over a thread pool. The
+	SSE box is checked against the scalar one
+********************************************/
+
+#include <vector>
+#include <random>
+#include <benchmark/benchmark.h>
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "CThreadPool.h"
+#include "MeshData.h"
+#include "MeshBounds.h"
+
+using namespace gen;
+
+namespace
+{
+
+/////////////////////////////////////
+// Mesh data
+
+const TUInt32 kBoundsSeed = 0x3301u;
+
+// Vertex with position, normal and texture coordinate - the most common layout in the game
+const TUInt32 kVertexSize = 8 * sizeof(TFloat32);
+
+// A sub-mesh of random vertices in a stretched box, owning its vertex data. No faces are needed
+struct SRandomSubMesh
+{
+	SSubMesh subMesh;
+	std::vector<TUInt8> vertices;
+};
+
+void RandomSubMesh( const TUInt32 numVertices, const TUInt32 seed, SRandomSubMesh* data )
+{
+	std::mt19937 rng( kBoundsSeed + seed );
+	std::uniform_real_distribution<TFloat32> coord( -1.0f, 1.0f );
+	data->vertices.resize( numVertices * kVertexSize );
+	for (TUInt32 vertex = 0; vertex < numVertices; ++vertex)
+	{
+		TFloat32* values = reinterpret_cast<TFloat32*>(&data->vertices[vertex * kVertexSize]);
+		values[0] = 5.0f + 4.0f * coord( rng );
+		values[1] = 1.5f * coord( rng );
+		values[2] = -2.0f + 8.0f * coord( rng );
+		for (TUInt32 value = 3; value < 8; ++value)
+		{
+			values[value] = coord( rng );
+		}
+	}
+
+	SSubMesh& subMesh = data->subMesh;
+	subMesh = SSubMesh();
+	subMesh.numVertices = numVertices;
+	subMesh.vertices = data->vertices.data();
+	subMesh.vertexSize = kVertexSize;
+	subMesh.hasNormals = true;
+	subMesh.hasTextureCoords = true;
+}
+
+// Scalar loop over the vertices, as CMesh::PreProcess did before MeshBounds.h
+void ScalarBounds( const SSubMesh& subMesh, CVector3* minBounds, CVector3* maxBounds, TFloat32* radius )
+{
+	const TUInt8* vertex = subMesh.vertices;
+	*minBounds = *maxBounds = CVector3( reinterpret_cast<const TFloat32*>(vertex) );
+	*radius = minBounds->Length();
+	for (TUInt32 vert = 0; vert < subMesh.numVertices; ++vert)
+	{
+		CVector3 position( reinterpret_cast<const TFloat32*>(vertex) );
+		minBounds->x = Min( minBounds->x, position.x );
+		minBounds->y = Min( minBounds->y, position.y );
+		minBounds->z = Min( minBounds->z, position.z );
+		maxBounds->x = Max( maxBounds->x, position.x );
+		maxBounds->y = Max( maxBounds->y, position.y );
+		maxBounds->z = Max( maxBounds->z, position.z );
+		*radius = Max( *radius, position.Length() );
+		vertex += subMesh.vertexSize;
+	}
+}
+
+// Argument is number of vertices
+void BoundsArguments( benchmark::internal::Benchmark* b )
+{
+	for (int count = 256; count <= 262144; count *= 8)
+	{
+		b->Arg( count );
+	}
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Benchmarks
+-----------------------------------------------------------------------------------------*/
+
+void BM_Bounds_Scalar( benchmark::State& state )
+{
+	SRandomSubMesh data;
+	RandomSubMesh( static_cast<TUInt32>(state.range( 0 )), 0, &data );
+
+	CVector3 minBounds, maxBounds;
+	TFloat32 radius;
+	for (auto _ : state)
+	{
+		ScalarBounds( data.subMesh, &minBounds, &maxBounds, &radius );
+		benchmark::DoNotOptimize( radius );
+	}
+	state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+BENCHMARK( BM_Bounds_Scalar )->Apply( BoundsArguments );
+
+// Box, sphere and origin radius only - the same work as the scalar loop plus the sphere pass
+void BM_Bounds_SSE( benchmark::State& state )
+{
+	SRandomSubMesh data;
+	RandomSubMesh( static_cast<TUInt32>(state.range( 0 )), 0, &data );
+
+	// Box must match the scalar loop exactly
+	CVector3 minBounds, maxBounds;
+	TFloat32 radius;
+	ScalarBounds( data.subMesh, &minBounds, &maxBounds, &radius );
+
+	SMeshBounds bounds;
+	for (auto _ : state)
+	{
+		CalculateBounds( data.subMesh, &bounds, false );
+		benchmark::DoNotOptimize( bounds.radius );
+	}
+	if (bounds.minBounds != minBounds || bounds.maxBounds != maxBounds)
+	{
+		state.SkipWithError( "SSE bounds disagree with scalar loop" );
+	}
+	state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+BENCHMARK( BM_Bounds_SSE )->Apply( BoundsArguments );
+
+// Including the oriented box fit
+void BM_Bounds_SSEOrientedBox( benchmark::State& state )
+{
+	SRandomSubMesh data;
+	RandomSubMesh( static_cast<TUInt32>(state.range( 0 )), 0, &data );
+
+	SMeshBounds bounds;
+	for (auto _ : state)
+	{
+		CalculateBounds( data.subMesh, &bounds, true );
+		benchmark::DoNotOptimize( bounds.boxExtents );
+	}
+	state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+BENCHMARK( BM_Bounds_SSEOrientedBox )->Apply( BoundsArguments );
+
+// Arguments are total number of vertices and whether to use the thread pool
+void MeshBoundsArguments( benchmark::internal::Benchmark* b )
+{
+	for (int usePool = 0; usePool <= 1; ++usePool)
+	{
+		for (int count = 2048; count <= 262144; count *= 8)
+		{
+			b->Args( { count, usePool } );
+		}
+	}
+}
+
+// A mesh of eight sub-meshes over two nodes, as CMesh::PreProcess does it with and without a pool.
+// Second argument is 1 to use the pool
+void BM_Bounds_Mesh( benchmark::State& state )
+{
+	const TUInt32 kNumSubMeshes = 8;
+	const TUInt32 numVertices = static_cast<TUInt32>(state.range( 0 )) / kNumSubMeshes;
+	std::vector<SRandomSubMesh> data( kNumSubMeshes );
+	std::vector<SSubMesh> subMeshes( kNumSubMeshes );
+	for (TUInt32 subMesh = 0; subMesh < kNumSubMeshes; ++subMesh)
+	{
+		RandomSubMesh( numVertices, subMesh, &data[subMesh] );
+		data[subMesh].subMesh.node = subMesh % 2;
+		subMeshes[subMesh] = data[subMesh].subMesh;
+	}
+
+	CThreadPool pool;
+	CThreadPool* usePool = state.range( 1 ) ? &pool : 0;
+	std::vector<SMeshBounds> subMeshBounds( kNumSubMeshes ), nodeBounds( 2 );
+	SMeshBounds meshBounds;
+	for (auto _ : state)
+	{
+		CalculateMeshBounds( subMeshes.data(), kNumSubMeshes, 2, subMeshBounds.data(), nodeBounds.data(),
+		                     &meshBounds, usePool );
+		benchmark::DoNotOptimize( meshBounds.radius );
+	}
+	state.SetLabel( usePool ? "pool" : "single thread" );
+	state.counters["threads"] = static_cast<double>(usePool ? pool.NumThreads() : 1);
+	state.SetItemsProcessed( state.iterations() * numVertices * kNumSubMeshes );
+}
+BENCHMARK( BM_Bounds_Mesh )->Apply( MeshBoundsArguments )->UseRealTime();
+
+} // namespace
@@ -0,0 +1,166 @@
+/*******************************************
+	CullBenchmark.cpp
+
+	Frustum culling benchmarks. Runs without a
+	device: spheres are scattered over a map
+	and tested against cameras in a few fixed
+	poses. The number of visible spheres for
+	each pose is reported as a counter, and
+	checked against the one-at-a-time test
+********************************************/
+
+#include <vector>
+#include <random>
+#include <benchmark/benchmark.h>
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "Camera.h"
+#include "Frustum.h"
+
+using namespace gen;
+
+namespace
+{
+
+/////////////////////////////////////
+// Scene data
+
+const TUInt32 kCullSeed = 0x3301u;
+
+// Half-width of the square map spheres are scattered over
+const TFloat32 kMapHalfSize = 2000.0f;
+
+// Spheres for the benchmark, as structure of arrays (see CFrustum::CullSpheres)
+struct SSpheres
+{
+	std::vector<TFloat32> x, y, z, radius;
+};
+
+SSpheres RandomSpheres( const size_t count )
+{
+	std::mt19937 rng( kCullSeed );
+	std::uniform_real_distribution<TFloat32> pos( -kMapHalfSize, kMapHalfSize );
+	std::uniform_real_distribution<TFloat32> size( 1.0f, 10.0f );
+	SSpheres spheres;
+	for (size_t i = 0; i < count; ++i)
+	{
+		spheres.x.push_back( pos( rng ) );
+		spheres.y.push_back( 0.0f );
+		spheres.z.push_back( pos( rng ) );
+		spheres.radius.push_back( size( rng ) );
+	}
+	return spheres;
+}
+
+// Camera poses, selected by the second benchmark argument
+enum ECameraPose
+{
+	Pose_Overview,    // High above the map looking down at an angle - most spheres visible
+	Pose_GroundLevel, // Near the ground at the map edge, looking across it
+	Pose_Corner,      // In a corner facing outwards - almost nothing visible
+	NumPoses
+};
+
+const char* const kPoseNames[NumPoses] = { "Overview", "GroundLevel", "Corner" };
+
+CCamera MakeCamera( const int pose )
+{
+	switch (pose)
+	{
+	case Pose_Overview:
+		return CCamera( CVector3( 0.0f, 1500.0f, -2500.0f ), CVector3( ToRadians( 35.0f ), 0.0f, 0.0f ),
+		                1.0f, 20000.0f );
+	case Pose_GroundLevel:
+		return CCamera( CVector3( 0.0f, 30.0f, -kMapHalfSize ), CVector3( ToRadians( 15.0f ), 0.0f, 0.0f ),
+		                1.0f, 20000.0f );
+	default:
+		return CCamera( CVector3( kMapHalfSize, 30.0f, kMapHalfSize ), CVector3( 0.0f, ToRadians( 45.0f ), 0.0f ),
+		                1.0f, 20000.0f );
+	}
+}
+
+// Arguments are number of spheres and camera pose
+void CullArguments( benchmark::internal::Benchmark* b )
+{
+	for (int pose = 0; pose < NumPoses; ++pose)
+	{
+		for (int count = 64; count <= 65536; count *= 8)
+		{
+			b->Args( { count, pose } );
+		}
+	}
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Benchmarks
+-----------------------------------------------------------------------------------------*/
+
+// Test each sphere in turn with the scalar function
+void BM_Cull_Scalar( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const SSpheres spheres = RandomSpheres( n );
+	CCamera camera = MakeCamera( static_cast<int>(state.range( 1 )) );
+	const CFrustum frustum( &camera );
+	std::vector<TUInt32> visible( n );
+
+	TUInt32 numVisible = 0;
+	for (auto _ : state)
+	{
+		numVisible = 0;
+		for (TUInt32 i = 0; i < n; ++i)
+		{
+			if (frustum.IsSphereVisible( CVector3( spheres.x[i], spheres.y[i], spheres.z[i] ), spheres.radius[i] ))
+			{
+				visible[numVisible++] = i;
+			}
+		}
+		benchmark::DoNotOptimize( visible.data() );
+		benchmark::ClobberMemory();
+	}
+	state.SetLabel( kPoseNames[state.range( 1 )] );
+	state.counters["visible"] = static_cast<double>(numVisible);
+	state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+BENCHMARK( BM_Cull_Scalar )->Apply( CullArguments );
+
+// Batched SSE test, four spheres at a time
+void BM_Cull_Batched( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const SSpheres spheres = RandomSpheres( n );
+	CCamera camera = MakeCamera( static_cast<int>(state.range( 1 )) );
+	const CFrustum frustum( &camera );
+	std::vector<TUInt32> visible( n );
+
+	// Results must match the scalar test exactly
+	TUInt32 expected = 0;
+	for (TUInt32 i = 0; i < n; ++i)
+	{
+		if (frustum.IsSphereVisible( CVector3( spheres.x[i], spheres.y[i], spheres.z[i] ), spheres.radius[i] ))
+		{
+			++expected;
+		}
+	}
+
+	TUInt32 numVisible = 0;
+	for (auto _ : state)
+	{
+		numVisible = frustum.CullSpheres( spheres.x.data(), spheres.y.data(), spheres.z.data(),
+		                                  spheres.radius.data(), static_cast<TUInt32>(n), visible.data() );
+		benchmark::DoNotOptimize( visible.data() );
+		benchmark::ClobberMemory();
+	}
+	if (numVisible != expected)
+	{
+		state.SkipWithError( "Batched culling disagrees with scalar test" );
+	}
+	state.SetLabel( kPoseNames[state.range( 1 )] );
+	state.counters["visible"] = static_cast<double>(numVisible);
+	state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+BENCHMARK( BM_Cull_Batched )->Apply( CullArguments );
+
+} // namespace
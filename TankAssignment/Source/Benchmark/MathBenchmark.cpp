@@ -0,0 +1,510 @@
+/*******************************************
+	MathBenchmark.cpp
+
+	Google Benchmark microbenchmarks for the
+	Math library. Each benchmark runs over a
+	batch of pre-generated inputs so results
+	reflect throughput on realistic data sizes
+	rather than a single value held in cache
+
+	Run with JSON output for comparison:
+	  Benchmark.exe --benchmark_out=Math.json
+	                --benchmark_out_format=json
+	then see Tools\CompareBenchmarks.py
+********************************************/
+
+#include <vector>
+#include <random>
+#include <benchmark/benchmark.h>
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "CVector4.h"
+#include "CMatrix4x4.h"
+#include "CQuaternion.h"
+
+using namespace gen;
+
+namespace
+{
+
+/////////////////////////////////////
+// Input data
+
+// Fixed seed so every run (and every machine) benchmarks identical inputs
+const TUInt32 kBenchSeed = 0x3301u;
+
+// Batch sizes: small batches stay in L1, the largest spill to L2/L3
+const int kMinBatch = 16;
+const int kMaxBatch = 16384;
+
+std::vector<CVector3> RandomVectors( const size_t count, const TFloat32 range, const TUInt32 seed )
+{
+	std::mt19937 rng( seed );
+	std::uniform_real_distribution<TFloat32> dist( -range, range );
+	std::vector<CVector3> vectors( count );
+	for (auto& v : vectors)
+	{
+		v.Set( dist( rng ), dist( rng ), dist( rng ) );
+	}
+	return vectors;
+}
+
+// Affine matrices built from random position, rotation and (non-zero) scale
+std::vector<CMatrix4x4> RandomAffineMatrices( const size_t count, const TUInt32 seed )
+{
+	std::mt19937 rng( seed );
+	std::uniform_real_distribution<TFloat32> pos( -100.0f, 100.0f );
+	std::uniform_real_distribution<TFloat32> angle( -kfPi, kfPi );
+	std::uniform_real_distribution<TFloat32> scale( 0.5f, 2.0f );
+	std::vector<CMatrix4x4> matrices( count );
+	for (auto& m : matrices)
+	{
+		m.MakeAffineEuler( CVector3( pos( rng ), pos( rng ), pos( rng ) ),
+		                   CVector3( angle( rng ), angle( rng ), angle( rng ) ), kZXY,
+		                   CVector3( scale( rng ), scale( rng ), scale( rng ) ) );
+	}
+	return matrices;
+}
+
+std::vector<CQuaternion> RandomQuaternions( const size_t count, const TUInt32 seed )
+{
+	std::mt19937 rng( seed );
+	std::uniform_real_distribution<TFloat32> dist( -1.0f, 1.0f );
+	std::vector<CQuaternion> quats( count );
+	for (auto& q : quats)
+	{
+		q.Set( dist( rng ), dist( rng ), dist( rng ), dist( rng ) );
+		q.Normalise();
+	}
+	return quats;
+}
+
+// Standard batch size range shared by all benchmarks
+void BatchSizes( benchmark::internal::Benchmark* b )
+{
+	b->RangeMultiplier( 4 )->Range( kMinBatch, kMaxBatch );
+}
+
+// Report items (math operations) per second rather than batches per second
+void SetBatchItems( benchmark::State& state )
+{
+	state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Construction
+-----------------------------------------------------------------------------------------*/
+
+void BM_Matrix4x4_ConstructAffineEuler( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CVector3> positions = RandomVectors( n, 100.0f, kBenchSeed );
+	const std::vector<CVector3> angles = RandomVectors( n, kfPi, kBenchSeed + 1 );
+	std::vector<CMatrix4x4> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = CMatrix4x4( positions[i], angles[i] );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Matrix4x4_ConstructAffineEuler )->Apply( BatchSizes );
+
+void BM_Matrix4x4_ConstructQuaternion( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CQuaternion> quats = RandomQuaternions( n, kBenchSeed );
+	const std::vector<CVector3> positions = RandomVectors( n, 100.0f, kBenchSeed + 1 );
+	std::vector<CMatrix4x4> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = CMatrix4x4( quats[i], positions[i] );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Matrix4x4_ConstructQuaternion )->Apply( BatchSizes );
+
+
+/*-----------------------------------------------------------------------------------------
+	Multiplication
+-----------------------------------------------------------------------------------------*/
+
+void BM_Matrix4x4_Multiply( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CMatrix4x4> a = RandomAffineMatrices( n, kBenchSeed );
+	const std::vector<CMatrix4x4> b = RandomAffineMatrices( n, kBenchSeed + 1 );
+	std::vector<CMatrix4x4> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = a[i] * b[i];
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Matrix4x4_Multiply )->Apply( BatchSizes );
+
+void BM_Matrix4x4_MultiplyAffine( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CMatrix4x4> a = RandomAffineMatrices( n, kBenchSeed );
+	const std::vector<CMatrix4x4> b = RandomAffineMatrices( n, kBenchSeed + 1 );
+	std::vector<CMatrix4x4> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = MultiplyAffine( a[i], b[i] );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Matrix4x4_MultiplyAffine )->Apply( BatchSizes );
+
+// Transform a point into world space, e.g. a local offset on an entity
+void BM_Matrix4x4_TransformPoint( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CMatrix4x4> m = RandomAffineMatrices( n, kBenchSeed );
+	const std::vector<CVector3> p = RandomVectors( n, 100.0f, kBenchSeed + 1 );
+	std::vector<CVector3> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = m[i].TransformPoint( p[i] );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Matrix4x4_TransformPoint )->Apply( BatchSizes );
+
+
+/*-----------------------------------------------------------------------------------------
+	Inversion and Decomposition
+-----------------------------------------------------------------------------------------*/
+
+void BM_Matrix4x4_InverseAffine( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CMatrix4x4> m = RandomAffineMatrices( n, kBenchSeed );
+	std::vector<CMatrix4x4> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = InverseAffine( m[i] );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Matrix4x4_InverseAffine )->Apply( BatchSizes );
+
+void BM_Matrix4x4_Inverse( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CMatrix4x4> m = RandomAffineMatrices( n, kBenchSeed );
+	std::vector<CMatrix4x4> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = Inverse( m[i] );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Matrix4x4_Inverse )->Apply( BatchSizes );
+
+void BM_Matrix4x4_DecomposeAffineEuler( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CMatrix4x4> m = RandomAffineMatrices( n, kBenchSeed );
+	std::vector<CVector3> positions( n ), angles( n ), scales( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			m[i].DecomposeAffineEuler( &positions[i], &angles[i], &scales[i] );
+		}
+		benchmark::DoNotOptimize( angles.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Matrix4x4_DecomposeAffineEuler )->Apply( BatchSizes );
+
+
+/*-----------------------------------------------------------------------------------------
+	Quaternions
+-----------------------------------------------------------------------------------------*/
+
+void BM_Quaternion_Slerp( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CQuaternion> q0 = RandomQuaternions( n, kBenchSeed );
+	const std::vector<CQuaternion> q1 = RandomQuaternions( n, kBenchSeed + 1 );
+	std::vector<CQuaternion> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			Slerp( q0[i], q1[i], 0.3f, out[i] );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Quaternion_Slerp )->Apply( BatchSizes );
+
+void BM_Quaternion_NLerp( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CQuaternion> q0 = RandomQuaternions( n, kBenchSeed );
+	const std::vector<CQuaternion> q1 = RandomQuaternions( n, kBenchSeed + 1 );
+	std::vector<CQuaternion> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			NLerp( q0[i], q1[i], 0.3f, out[i] );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Quaternion_NLerp )->Apply( BatchSizes );
+
+
+/*-----------------------------------------------------------------------------------------
+	Vector Operations
+-----------------------------------------------------------------------------------------*/
+
+void BM_Vector3_Normalise( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CVector3> v = RandomVectors( n, 100.0f, kBenchSeed );
+	std::vector<CVector3> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = Normalise( v[i] );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Vector3_Normalise )->Apply( BatchSizes );
+
+void BM_Vector3_DotCross( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CVector3> a = RandomVectors( n, 100.0f, kBenchSeed );
+	const std::vector<CVector3> b = RandomVectors( n, 100.0f, kBenchSeed + 1 );
+	std::vector<CVector3> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = Cross( a[i], b[i] ) * Dot( a[i], b[i] );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Vector3_DotCross )->Apply( BatchSizes );
+
+// Typical movement update: position += velocity * dt
+void BM_Vector3_MultiplyAdd( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	std::vector<CVector3> positions = RandomVectors( n, 100.0f, kBenchSeed );
+	const std::vector<CVector3> velocities = RandomVectors( n, 10.0f, kBenchSeed + 1 );
+	const TFloat32 dt = 1.0f / 60.0f;
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			positions[i] += velocities[i] * dt;
+		}
+		benchmark::DoNotOptimize( positions.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Vector3_MultiplyAdd )->Apply( BatchSizes );
+
+void BM_Vector3_Distance( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CVector3> a = RandomVectors( n, 100.0f, kBenchSeed );
+	const std::vector<CVector3> b = RandomVectors( n, 100.0f, kBenchSeed + 1 );
+	std::vector<TFloat32> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = Distance( a[i], b[i] );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Vector3_Distance )->Apply( BatchSizes );
+
+
+/*-----------------------------------------------------------------------------------------
+	Fused Vector Kernels
+-----------------------------------------------------------------------------------------*/
+// Pairs of benchmarks computing the same result, first written as a chain of operators (as
+// in the original tank steering code) then using the fused inline kernels (MultiplyAdd)
+
+// Point on the near side of a target: target - Normalise(target - position) * spacing
+void BM_Vector3_SteeringChained( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CVector3> positions = RandomVectors( n, 100.0f, kBenchSeed );
+	const std::vector<CVector3> targets = RandomVectors( n, 100.0f, kBenchSeed + 1 );
+	const TFloat32 spacing = 10.0f;
+	std::vector<CVector3> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			CVector3 toTarget = Normalise( targets[i] - positions[i] );
+			out[i] = targets[i] - toTarget * spacing;
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Vector3_SteeringChained )->Apply( BatchSizes );
+
+void BM_Vector3_SteeringFused( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CVector3> positions = RandomVectors( n, 100.0f, kBenchSeed );
+	const std::vector<CVector3> targets = RandomVectors( n, 100.0f, kBenchSeed + 1 );
+	const TFloat32 spacing = 10.0f;
+	std::vector<CVector3> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = MultiplyAdd( targets[i], Normalise( targets[i] - positions[i] ), -spacing );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Vector3_SteeringFused )->Apply( BatchSizes );
+
+// Point along an axis, e.g. the end of a turret barrel: position + axis * length
+void BM_Vector3_OffsetChained( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CVector3> positions = RandomVectors( n, 100.0f, kBenchSeed );
+	const std::vector<CVector3> axes = RandomVectors( n, 1.0f, kBenchSeed + 1 );
+	std::vector<CVector3> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = positions[i] + axes[i] * 4.0f;
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Vector3_OffsetChained )->Apply( BatchSizes );
+
+void BM_Vector3_OffsetFused( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CVector3> positions = RandomVectors( n, 100.0f, kBenchSeed );
+	const std::vector<CVector3> axes = RandomVectors( n, 1.0f, kBenchSeed + 1 );
+	std::vector<CVector3> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = MultiplyAdd( positions[i], axes[i], 4.0f );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Vector3_OffsetFused )->Apply( BatchSizes );
+
+void BM_Vector3_Lerp( benchmark::State& state )
+{
+	const size_t n = static_cast<size_t>(state.range( 0 ));
+	const std::vector<CVector3> a = RandomVectors( n, 100.0f, kBenchSeed );
+	const std::vector<CVector3> b = RandomVectors( n, 100.0f, kBenchSeed + 1 );
+	std::vector<CVector3> out( n );
+
+	for (auto _ : state)
+	{
+		for (size_t i = 0; i < n; ++i)
+		{
+			out[i] = Lerp( a[i], b[i], 0.25f );
+		}
+		benchmark::DoNotOptimize( out.data() );
+		benchmark::ClobberMemory();
+	}
+	SetBatchItems( state );
+}
+BENCHMARK( BM_Vector3_Lerp )->Apply( BatchSizes );
+
+} // namespace
@@ -0,0 +1,111 @@
+/*******************************************
+	ParticleBenchmark.cpp
+
+	CPU particle update benchmarks. The array
+	of structures update that a straight port
+	of DX10ParticlesUpdate.gsh would use is
+	compared with CParticleSimulator on one
+	thread and over a thread pool, from the
+	200,000 particles of CParticalSystem up
+	to 2 million
+********************************************/
+
+#include <vector>
+#include <benchmark/benchmark.h>
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "CThreadPool.h"
+#include "ParticleSimulator.h"
+
+using namespace gen;
+
+namespace
+{
+
+/////////////////////////////////////
+// Particle data
+
+// Fixed frame time, as a 60Hz game would use
+const TFloat32 kParticleUpdateTime = 1.0f / 60.0f;
+
+// Particle as CParticalSystem holds it for the GPU
+struct SParticle
+{
+	CVector3 Position;
+	CVector3 Velocity;
+	TFloat32 Life;
+};
+
+// Argument is number of particles
+void ParticleArguments( benchmark::internal::Benchmark* b )
+{
+	b->Arg( 200000 );
+	b->Arg( 500000 );
+	b->Arg( 1000000 );
+	b->Arg( 2000000 );
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Benchmarks
+-----------------------------------------------------------------------------------------*/
+
+void BM_Particles_AoSScalar( benchmark::State& state )
+{
+	const TUInt32 numParticles = static_cast<TUInt32>(state.range( 0 ));
+	std::vector<SParticle> particles( numParticles );
+	for (TUInt32 p = 0; p < numParticles; ++p)
+	{
+		particles[p].Position = CVector3( Random( -10.0f, 10.0f ), Random( -50.0f, 50.0f ), Random( -10.0f, 10.0f ) );
+		particles[p].Velocity = CVector3( Random( -40.0f, 40.0f ), Random( 0.0f, 60.0f ), Random( -40.0f, 40.0f ) );
+		particles[p].Life = (5.0f * p) / numParticles;
+	}
+
+	const CVector3 gravity( 0.0f, kParticleGravity, 0.0f );
+	for (auto _ : state)
+	{
+		for (TUInt32 p = 0; p < numParticles; ++p)
+		{
+			particles[p].Life -= kParticleUpdateTime;
+			particles[p].Position += particles[p].Velocity * kParticleUpdateTime;
+			particles[p].Velocity += gravity * kParticleUpdateTime;
+		}
+		benchmark::DoNotOptimize( particles.data() );
+	}
+	state.SetItemsProcessed( state.iterations() * numParticles );
+	state.SetBytesProcessed( state.iterations() * numParticles * sizeof(SParticle) );
+}
+BENCHMARK( BM_Particles_AoSScalar )->Apply( ParticleArguments );
+
+void BM_Particles_SoA( benchmark::State& state )
+{
+	const TUInt32 numParticles = static_cast<TUInt32>(state.range( 0 ));
+	CParticleSimulator simulator( numParticles );
+	for (auto _ : state)
+	{
+		simulator.Update( kParticleUpdateTime );
+		benchmark::DoNotOptimize( simulator.NumLiveParticles() );
+	}
+	state.SetItemsProcessed( state.iterations() * numParticles );
+	state.SetBytesProcessed( state.iterations() * simulator.MemorySize() );
+}
+BENCHMARK( BM_Particles_SoA )->Apply( ParticleArguments );
+
+void BM_Particles_SoAPool( benchmark::State& state )
+{
+	const TUInt32 numParticles = static_cast<TUInt32>(state.range( 0 ));
+	CThreadPool pool;
+	CParticleSimulator simulator( numParticles, &pool );
+	for (auto _ : state)
+	{
+		simulator.Update( kParticleUpdateTime );
+		benchmark::DoNotOptimize( simulator.NumLiveParticles() );
+	}
+	state.counters["threads"] = static_cast<double>(pool.NumThreads());
+	state.SetItemsProcessed( state.iterations() * numParticles );
+	state.SetBytesProcessed( state.iterations() * simulator.MemorySize() );
+}
+BENCHMARK( BM_Particles_SoAPool )->Apply( ParticleArguments )->UseRealTime();
+
+} // namespace
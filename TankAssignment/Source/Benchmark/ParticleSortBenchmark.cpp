@@ -0,0 +1,151 @@
+/*******************************************
+	ParticleSortBenchmark.cpp
+
+	Back to front particle sort benchmarks.
+	std::sort by depth is compared with the
+	CParticleSorter radix sort on one thread
+	and over a thread pool, and with the
+	incremental re-sort of an unchanged order
+	and after a frame of particle movement
+********************************************/
+
+#include <vector>
+#include <algorithm>
+#include <benchmark/benchmark.h>
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "CThreadPool.h"
+#include "ParticleSimulator.h"
+#include "ParticleSort.h"
+
+using namespace gen;
+
+namespace
+{
+
+/////////////////////////////////////
+// Particle data
+
+// Fixed frame time, as a 60Hz game would use
+const TFloat32 kParticleUpdateTime = 1.0f / 60.0f;
+
+// Camera looking at the particle fountain from the side and above
+const CVector3 kViewPosition( 20.0f, 40.0f, -150.0f );
+CVector3 ViewDirection()
+{
+	CVector3 direction( -0.1f, -0.2f, 1.0f );
+	direction.Normalise();
+	return direction;
+}
+
+// Argument is number of particles
+void SortArguments( benchmark::internal::Benchmark* b )
+{
+	b->Arg( 200000 );
+	b->Arg( 500000 );
+	b->Arg( 1000000 );
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Benchmarks
+-----------------------------------------------------------------------------------------*/
+
+void BM_ParticleSort_StdSort( benchmark::State& state )
+{
+	const TUInt32 numParticles = static_cast<TUInt32>(state.range( 0 ));
+	CParticleSimulator simulator( numParticles );
+	const CVector3 viewDirection = ViewDirection();
+	std::vector<TFloat32> depths( numParticles );
+	std::vector<TUInt32> order( numParticles );
+	for (auto _ : state)
+	{
+		for (TUInt32 p = 0; p < numParticles; ++p)
+		{
+			CVector3 position( simulator.PositionsX()[p], simulator.PositionsY()[p], simulator.PositionsZ()[p] );
+			depths[p] = Dot( position - kViewPosition, viewDirection );
+			order[p] = p;
+		}
+		std::sort( order.begin(), order.end(), [&]( TUInt32 a, TUInt32 b ) { return depths[a] > depths[b]; } );
+		benchmark::DoNotOptimize( order.data() );
+	}
+	state.SetItemsProcessed( state.iterations() * numParticles );
+}
+BENCHMARK( BM_ParticleSort_StdSort )->Apply( SortArguments );
+
+void BM_ParticleSort_Radix( benchmark::State& state )
+{
+	const TUInt32 numParticles = static_cast<TUInt32>(state.range( 0 ));
+	CParticleSimulator simulator( numParticles );
+	CParticleSorter sorter( numParticles );
+	const CVector3 viewDirection = ViewDirection();
+	for (auto _ : state)
+	{
+		sorter.Invalidate();
+		benchmark::DoNotOptimize( sorter.Sort( simulator.PositionsX(), simulator.PositionsY(), simulator.PositionsZ(),
+		                                       numParticles, kViewPosition, viewDirection ) );
+	}
+	state.SetItemsProcessed( state.iterations() * numParticles );
+}
+BENCHMARK( BM_ParticleSort_Radix )->Apply( SortArguments );
+
+void BM_ParticleSort_RadixPool( benchmark::State& state )
+{
+	const TUInt32 numParticles = static_cast<TUInt32>(state.range( 0 ));
+	CThreadPool pool;
+	CParticleSimulator simulator( numParticles );
+	CParticleSorter sorter( numParticles, &pool );
+	const CVector3 viewDirection = ViewDirection();
+	for (auto _ : state)
+	{
+		sorter.Invalidate();
+		benchmark::DoNotOptimize( sorter.Sort( simulator.PositionsX(), simulator.PositionsY(), simulator.PositionsZ(),
+		                                       numParticles, kViewPosition, viewDirection ) );
+	}
+	state.counters["threads"] = static_cast<double>(pool.NumThreads());
+	state.SetItemsProcessed( state.iterations() * numParticles );
+}
+BENCHMARK( BM_ParticleSort_RadixPool )->Apply( SortArguments )->UseRealTime();
+
+// Particles that have not moved since the last sort (e.g. only the camera's distance changed),
+// the best case for the incremental re-sort
+void BM_ParticleSort_ResortStill( benchmark::State& state )
+{
+	const TUInt32 numParticles = static_cast<TUInt32>(state.range( 0 ));
+	CParticleSimulator simulator( numParticles );
+	CParticleSorter sorter( numParticles );
+	const CVector3 viewDirection = ViewDirection();
+	sorter.Sort( simulator.PositionsX(), simulator.PositionsY(), simulator.PositionsZ(), numParticles,
+	             kViewPosition, viewDirection );
+	for (auto _ : state)
+	{
+		benchmark::DoNotOptimize( sorter.Sort( simulator.PositionsX(), simulator.PositionsY(), simulator.PositionsZ(),
+		                                       numParticles, kViewPosition, viewDirection ) );
+	}
+	state.counters["resorts"] = static_cast<double>(sorter.GetStats().incrementalSorts);
+	state.SetItemsProcessed( state.iterations() * numParticles );
+}
+BENCHMARK( BM_ParticleSort_ResortStill )->Apply( SortArguments );
+
+// A simulator update then a sort each frame. The fountain's particles are fast and dense, so the
+// re-sort gives up and the cost is a radix sort plus the abandoned attempt
+void BM_ParticleSort_Frame( benchmark::State& state )
+{
+	const TUInt32 numParticles = static_cast<TUInt32>(state.range( 0 ));
+	CParticleSimulator simulator( numParticles );
+	CParticleSorter sorter( numParticles );
+	const CVector3 viewDirection = ViewDirection();
+	for (auto _ : state)
+	{
+		simulator.Update( kParticleUpdateTime );
+		benchmark::DoNotOptimize( sorter.Sort( simulator.PositionsX(), simulator.PositionsY(), simulator.PositionsZ(),
+		                                       numParticles, kViewPosition, viewDirection ) );
+	}
+	state.counters["resorts"] = static_cast<double>(sorter.GetStats().incrementalSorts);
+	state.counters["failed"] = static_cast<double>(sorter.GetStats().failedResorts);
+	state.SetItemsProcessed( state.iterations() * numParticles );
+}
+BENCHMARK( BM_ParticleSort_Frame )->Apply( SortArguments );
+
+} // namespace
@@ -0,0 +1,196 @@
+/*******************************************
+	RenderQueueBenchmark.cpp
+
+	Render queue benchmarks. Runs without a
+	device: a scene made of a few mesh types
+	in typical proportions is drawn with the
+	null backend, once in entity order as
+	CMesh::Render does and once through the
+	sorted, instanced render queue. Draw calls
+	and state changes are reported as counters
+********************************************/
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <benchmark/benchmark.h>
+
+#include "Defines.h"
+#include "CMatrix4x4.h"
+#include "RenderQueue.h"
+#include "RenderBackend.h"
+
+using namespace gen;
+
+namespace
+{
+
+/////////////////////////////////////
+// Scene data
+
+const TUInt32 kQueueSeed = 0x3301u;
+
+const TUInt32 kMaxSubMeshes = 4;
+
+// Description of a mesh - enough to generate the packets it would submit
+struct SMeshType
+{
+	const char*   name;
+	TUInt32       numSubMeshes;
+	ERenderMethod methods[kMaxSubMeshes]; // Render method of each sub-mesh's material
+	TUInt32       percentage;             // Share of the entities in the scene using this mesh
+};
+
+// Roughly the make up of the tank map: mostly scenery with a few tanks and the shells / ammo
+// they generate
+const SMeshType kMeshTypes[] =
+{
+	{ "Tree",     2, { PixelLitTex, CutoutPixelLitTex },                     55 },
+	{ "Building", 3, { PixelLitTex, PixelLitTex, PixelLit },                 5 },
+	{ "Tank",     4, { PixelLitTex, PixelLitTex, PixelLitTex, PixelLitTex }, 10 },
+	{ "Shell",    1, { PixelLit },                                           20 },
+	{ "Ammo",     1, { PlainTexture },                                       10 },
+};
+const TUInt32 kNumMeshTypes = sizeof(kMeshTypes) / sizeof(kMeshTypes[0]);
+
+// An entity in the synthetic scene - its mesh type and a world matrix for each sub-mesh
+struct SEntity
+{
+	TUInt32    meshType;
+	CMatrix4x4 matrices[kMaxSubMeshes];
+};
+
+// Entities in shuffled order, as the entity manager holds them in creation order
+std::vector<SEntity> RandomScene( const size_t count )
+{
+	std::mt19937 rng( kQueueSeed );
+	std::uniform_real_distribution<TFloat32> pos( -2000.0f, 2000.0f );
+
+	std::vector<SEntity> entities( count );
+	size_t entity = 0;
+	for (TUInt32 type = 0; type < kNumMeshTypes; ++type)
+	{
+		const size_t typeCount = (type == kNumMeshTypes - 1) ? count - entity
+		                                                      : count * kMeshTypes[type].percentage / 100;
+		for (size_t i = 0; i < typeCount && entity < count; ++i, ++entity)
+		{
+			entities[entity].meshType = type;
+			for (TUInt32 subMesh = 0; subMesh < kMaxSubMeshes; ++subMesh)
+			{
+				entities[entity].matrices[subMesh] = CMatrix4x4( CVector3( pos( rng ), 0.0f, pos( rng ) ) );
+			}
+		}
+	}
+	std::shuffle( entities.begin(), entities.end(), rng );
+	return entities;
+}
+
+void SetStatCounters( benchmark::State& state, const SRenderStats& stats )
+{
+	state.counters["draws"] = static_cast<double>(stats.drawCalls);
+	state.counters["states"] = static_cast<double>(stats.techniqueChanges + stats.materialChanges +
+	                                               stats.geometryChanges);
+	state.counters["instances"] = static_cast<double>(stats.instances);
+}
+
+
+/*-----------------------------------------------------------------------------------------
+	Benchmarks
+-----------------------------------------------------------------------------------------*/
+
+// Draw each sub-mesh of each entity in turn, setting all state every time (as CMesh::Render)
+void BM_Render_Immediate( benchmark::State& state )
+{
+	const std::vector<SEntity> entities = RandomScene( static_cast<size_t>(state.range( 0 )) );
+	CNullRenderBackend backend;
+
+	for (auto _ : state)
+	{
+		backend.Reset();
+		for (const SEntity& entity : entities)
+		{
+			const SMeshType& type = kMeshTypes[entity.meshType];
+			for (TUInt32 subMesh = 0; subMesh < type.numSubMeshes; ++subMesh)
+			{
+				backend.SetTechnique( type.methods[subMesh] );
+				backend.SetMaterial( 0, subMesh );
+				backend.SetGeometry( 0, subMesh, 0 );
+				backend.Draw( 0, subMesh, 0, &entity.matrices[subMesh], 1 );
+			}
+		}
+		benchmark::ClobberMemory();
+	}
+	SetStatCounters( state, backend.GetStats() );
+	state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+BENCHMARK( BM_Render_Immediate )->RangeMultiplier( 4 )->Range( 64, 16384 );
+
+// Submit every sub-mesh to the render queue, then sort and flush as instanced draws
+void BM_Render_Queued( benchmark::State& state )
+{
+	const std::vector<SEntity> entities = RandomScene( static_cast<size_t>(state.range( 0 )) );
+	CNullRenderBackend backend;
+	CRenderQueue queue;
+
+	for (auto _ : state)
+	{
+		backend.Reset();
+		for (const SEntity& entity : entities)
+		{
+			const SMeshType& type = kMeshTypes[entity.meshType];
+			for (TUInt32 subMesh = 0; subMesh < type.numSubMeshes; ++subMesh)
+			{
+				queue.Submit( type.methods[subMesh], entity.meshType, subMesh, subMesh, 0, 0, &entity.matrices[subMesh] );
+			}
+		}
+		queue.Flush( &backend );
+		benchmark::ClobberMemory();
+	}
+	SetStatCounters( state, backend.GetStats() );
+	state.SetItemsProcessed( state.iterations() * state.range( 0 ) );
+}
+BENCHMARK( BM_Render_Queued )->RangeMultiplier( 4 )->Range( 64, 16384 );
+
+// Check the queue draws every sub-mesh submitted, merging each distinct sub-mesh into one call
+void BM_Render_QueueMatchesImmediate( benchmark::State& state )
+{
+	const std::vector<SEntity> entities = RandomScene( static_cast<size_t>(state.range( 0 )) );
+	CNullRenderBackend backend( true );
+	CRenderQueue queue;
+
+	TUInt32 expected = 0;
+	for (const SEntity& entity : entities)
+	{
+		expected += kMeshTypes[entity.meshType].numSubMeshes;
+	}
+
+	for (auto _ : state)
+	{
+		backend.Reset();
+		for (const SEntity& entity : entities)
+		{
+			const SMeshType& type = kMeshTypes[entity.meshType];
+			for (TUInt32 subMesh = 0; subMesh < type.numSubMeshes; ++subMesh)
+			{
+				queue.Submit( type.methods[subMesh], entity.meshType, subMesh, subMesh, 0, 0, &entity.matrices[subMesh] );
+			}
+		}
+		queue.Flush( &backend );
+	}
+
+	// Each sub-mesh of each mesh type should be drawn in exactly one call
+	TUInt32 uniqueSubMeshes = 0;
+	for (TUInt32 type = 0; type < kNumMeshTypes; ++type)
+	{
+		uniqueSubMeshes += kMeshTypes[type].numSubMeshes;
+	}
+	if (backend.GetStats().instances != expected || backend.GetStats().drawCalls > uniqueSubMeshes)
+	{
+		state.SkipWithError( "Render queue lost or split draws" );
+	}
+	SetStatCounters( state, backend.GetStats() );
+	state.counters["commands"] = static_cast<double>(backend.Commands().size());
+}
+BENCHMARK( BM_Render_QueueMatchesImmediate )->Arg( 1024 );
+
+} // namespace
@@ -0,0 +1,316 @@
+/*******************************************
+	XFileBenchmark.cpp
+
+	.x file parsing benchmarks, over some of
+	the shipped meshes. Each pass opens the
+	file, visits every object and reads mesh
+	vertices and faces, once through the D3DX
+	file API the importer used to use and once
+	through the streaming parser. Vertex and
+	face totals are reported as counters, and
+	checked to agree between the two
+********************************************/
+
+#include <vector>
+#include <string>
+#include <cstring>
+#include <benchmark/benchmark.h>
+
+#ifdef _WIN32
+#define INITGUID
+#include <windows.h>
+#include <rmxfguid.h>
+#include <rmxftmpl.h>
+#include <d3dx9.h>
+#endif
+
+#include "Defines.h"
+#include "CVector3.h"
+#include "CMappedFile.h"
+#include "XFileParser.h"
+
+using namespace gen;
+
+namespace
+{
+
+/////////////////////////////////////
+// Test files
+
+// Benchmarks are run from the project folder
+const std::string kMediaFolder = "Media\\";
+
+// Selected by the benchmark argument - a range of sizes, text format with frames, materials
+// and references
+const char* const kFiles[] = { "Cube.x", "HoverTank01.x", "Tree.x", "Building.x", "tree1.x" };
+const int kNumFiles = sizeof(kFiles) / sizeof(kFiles[0]);
+
+// Totals read from a file, the same work is done for both APIs
+struct SMeshTotals
+{
+	TUInt32 numMeshes;
+	TUInt32 numVertices;
+	TUInt32 numFaces;
+};
+
+// Buffers reused between meshes so allocation is not measured
+struct SMeshBuffers
+{
+	std::vector<CVector3> vertices;
+	std::vector<TUInt32>  indices;
+};
+
+
+/////////////////////////////////////
+// Streaming parser
+
+// Visit all children of the current object, reading mesh data
+bool WalkParser( CXFileParser* parser, SMeshTotals* totals, SMeshBuffers* buffers )
+{
+	SXFileObject object;
+	while (parser->NextObject( &object ))
+	{
+		if (object.IsType( "Mesh" ))
+		{
+			TUInt32 numVertices, numFaces;
+			if (!parser->ReadUInt( &numVertices ))
+			{
+				return false;
+			}
+			buffers->vertices.resize( numVertices );
+			if (numVertices > 0 && !parser->ReadFloats( &buffers->vertices[0].x, numVertices * 3 ))
+			{
+				return false;
+			}
+			if (!parser->ReadUInt( &numFaces ))
+			{
+				return false;
+			}
+			buffers->indices.clear();
+			for (TUInt32 face = 0; face < numFaces; ++face)
+			{
+				TUInt32 numEdges, index;
+				if (!parser->ReadUInt( &numEdges ))
+				{
+					return false;
+				}
+				for (TUInt32 edge = 0; edge < numEdges; ++edge)
+				{
+					if (!parser->ReadUInt( &index ))
+					{
+						return false;
+					}
+					buffers->indices.push_back( index );
+				}
+			}
+			++totals->numMeshes;
+			totals->numVertices += numVertices;
+			totals->numFaces += numFaces;
+		}
+
+		// Children of this object, then its closing brace
+		WalkParser( parser, totals, buffers );
+	}
+	return !parser->HasFailed();
+}
+
+bool ParseFile( const std::string& fileName, SMeshTotals* totals, SMeshBuffers* buffers )
+{
+	SMeshTotals fileTotals = { 0, 0, 0 };
+	CXFileParser parser;
+	if (!parser.Open( fileName ) || !WalkParser( &parser, &fileTotals, buffers ))
+	{
+		return false;
+	}
+	*totals = fileTotals;
+	return true;
+}
+
+void BM_XFile_Parser( benchmark::State& state )
+{
+	const std::string fileName = kMediaFolder + kFiles[state.range( 0 )];
+	CMappedFile file;
+	if (!file.Open( fileName ))
+	{
+		state.SkipWithError( "Could not open file" );
+		return;
+	}
+	const TUInt32 fileSize = file.Size();
+	file.Close();
+
+	SMeshBuffers buffers;
+	SMeshTotals totals = { 0, 0, 0 };
+	for (auto _ : state)
+	{
+		if (!ParseFile( fileName, &totals, &buffers ))
+		{
+			state.SkipWithError( "Parse failed" );
+			break;
+		}
+		benchmark::DoNotOptimize( buffers.indices.data() );
+	}
+	state.SetLabel( kFiles[state.range( 0 )] );
+	state.counters["vertices"] = static_cast<double>(totals.numVertices);
+	state.counters["faces"] = static_cast<double>(totals.numFaces);
+	state.SetBytesProcessed( state.iterations() * fileSize );
+}
+BENCHMARK( BM_XFile_Parser )->DenseRange( 0, kNumFiles - 1 )->Unit( benchmark::kMicrosecond );
+
+
+#ifdef _WIN32
+
+/////////////////////////////////////
+// D3DX file API, as used by the importer before the streaming parser
+
+// Visit a data object and all its children, reading mesh data from locked buffers
+bool WalkD3DX( ID3DXFileData* data, SMeshTotals* totals, SMeshBuffers* buffers )
+{
+	GUID type;
+	SIZE_T size;
+	const void* lockedData;
+	if (FAILED(data->GetType( &type )) || FAILED(data->Lock( &size, &lockedData )))
+	{
+		return false;
+	}
+	if (type == TID_D3DRMMesh)
+	{
+		const TUInt8* meshData = static_cast<const TUInt8*>(lockedData);
+		DWORD numVertices, numFaces;
+		memcpy( &numVertices, meshData, 4 );
+		meshData += 4;
+		buffers->vertices.resize( numVertices );
+		memcpy( buffers->vertices.data(), meshData, numVertices * sizeof(CVector3) );
+		meshData += numVertices * sizeof(CVector3);
+		memcpy( &numFaces, meshData, 4 );
+		meshData += 4;
+		buffers->indices.clear();
+		for (DWORD face = 0; face < numFaces; ++face)
+		{
+			DWORD numEdges, index;
+			memcpy( &numEdges, meshData, 4 );
+			meshData += 4;
+			for (DWORD edge = 0; edge < numEdges; ++edge)
+			{
+				memcpy( &index, meshData, 4 );
+				meshData += 4;
+				buffers->indices.push_back( index );
+			}
+		}
+		++totals->numMeshes;
+		totals->numVertices += numVertices;
+		totals->numFaces += numFaces;
+	}
+	data->Unlock();
+
+	SIZE_T numChildren;
+	if (FAILED(data->GetChildren( &numChildren )))
+	{
+		return false;
+	}
+	for (SIZE_T child = 0; child < numChildren; ++child)
+	{
+		ID3DXFileData* childData;
+		if (FAILED(data->GetChild( child, &childData )))
+		{
+			return false;
+		}
+		bool ok = WalkD3DX( childData, totals, buffers );
+		childData->Release();
+		if (!ok)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool ParseFileD3DX( const std::string& fileName, SMeshTotals* totals, SMeshBuffers* buffers )
+{
+	// Set up the file object with the standard templates, as the importer did
+	ID3DXFile* xFile;
+	if (FAILED(D3DXFileCreate( &xFile )))
+	{
+		return false;
+	}
+	if (FAILED(xFile->RegisterTemplates( D3DRM_XTEMPLATES, D3DRM_XTEMPLATE_BYTES )) ||
+	    FAILED(xFile->RegisterTemplates( XSKINEXP_TEMPLATES, strlen( XSKINEXP_TEMPLATES ) )) ||
+	    FAILED(xFile->RegisterTemplates( XEXTENSIONS_TEMPLATES, strlen( XEXTENSIONS_TEMPLATES ) )))
+	{
+		xFile->Release();
+		return false;
+	}
+
+	ID3DXFileEnumObject* enumObject;
+	if (FAILED(xFile->CreateEnumObject( fileName.c_str(), D3DXF_FILELOAD_FROMFILE, &enumObject )))
+	{
+		xFile->Release();
+		return false;
+	}
+
+	SMeshTotals fileTotals = { 0, 0, 0 };
+	bool ok = true;
+	SIZE_T numChildren = 0;
+	enumObject->GetChildren( &numChildren );
+	for (SIZE_T child = 0; ok && child < numChildren; ++child)
+	{
+		ID3DXFileData* childData;
+		ok = SUCCEEDED(enumObject->GetChild( child, &childData ));
+		if (ok)
+		{
+			ok = WalkD3DX( childData, &fileTotals, buffers );
+			childData->Release();
+		}
+	}
+	enumObject->Release();
+	xFile->Release();
+
+	*totals = fileTotals;
+	return ok;
+}
+
+void BM_XFile_D3DX( benchmark::State& state )
+{
+	const std::string fileName = kMediaFolder + kFiles[state.range( 0 )];
+	CMappedFile file;
+	if (!file.Open( fileName ))
+	{
+		state.SkipWithError( "Could not open file" );
+		return;
+	}
+	const TUInt32 fileSize = file.Size();
+	file.Close();
+
+	// Results must match the streaming parser
+	SMeshBuffers buffers;
+	SMeshTotals expected;
+	if (!ParseFile( fileName, &expected, &buffers ))
+	{
+		state.SkipWithError( "Parse failed" );
+		return;
+	}
+
+	SMeshTotals totals = { 0, 0, 0 };
+	for (auto _ : state)
+	{
+		if (!ParseFileD3DX( fileName, &totals, &buffers ))
+		{
+			state.SkipWithError( "D3DX parse failed" );
+			break;
+		}
+		benchmark::DoNotOptimize( buffers.indices.data() );
+	}
+	if (totals.numMeshes != expected.numMeshes || totals.numVertices != expected.numVertices ||
+	    totals.numFaces != expected.numFaces)
+	{
+		state.SkipWithError( "D3DX and streaming parser disagree" );
+	}
+	state.SetLabel( kFiles[state.range( 0 )] );
+	state.counters["vertices"] = static_cast<double>(totals.numVertices);
+	state.counters["faces"] = static_cast<double>(totals.numFaces);
+	state.SetBytesProcessed( state.iterations() * fileSize );
+}
+BENCHMARK( BM_XFile_D3DX )->DenseRange( 0, kNumFiles - 1 )->Unit( benchmark::kMicrosecond );
+
+#endif // _WIN32
+
+} // namespace
@@ -24,6 +24,7 @@ using namespace std;
 
 #include "Defines.h"
 #include "Error.h"
+#include "MemoryTracker.h"
 
 namespace gen
 {
@@ -66,7 +67,8 @@ TUInt32 JOneAtATimeHash( const TUInt8* pKey, const TUInt32 iKeyLen );
 // A further restriction is that keys must not contain pointers (although values can). This is
 // because the hash function treats keys as a sequence of raw bytes, pointers are not followed
 // and the data pointed at will not be hashed
-template <class TKeyType, class TValueType>
+// The buckets and key/value pairs are counted against the given memory tag (see MemoryTracker.h)
+template <class TKeyType, class TValueType, EMemoryTag Tag = EMemoryTag::Other>
 class CHashTable
 {
 
@@ -87,7 +89,7 @@ public:
 
 		// Allocate initial hash table array
 		m_iSize = iInitialSize;
-		m_aBuckets = new TBucket[m_iSize];
+		m_aBuckets = TaggedNewArray<TBucket>( Tag, m_iSize );
 		GEN_ASSERT( m_aBuckets, "Fatal memory error reserving hash table memory" );
 
 		// Starting with no hash table entries
@@ -108,7 +110,7 @@ public:
 	// Destructor to free hash table memory
 	~CHashTable()
 	{
-		delete[] m_aBuckets;
+		TaggedDeleteArray( m_aBuckets );
 	}
 
 
@@ -277,8 +279,8 @@ private:
 	// A bucket is a list of key/value pairs that have the same hash index. The list only has
 	// more than one entry if there has been a collision from the hashing function
 	// Define a couple of types to make for better readability
-	typedef list<TKeyValuePair>        TBucket;
-	typedef typename TBucket::iterator TKeyValuePairIter;
+	typedef list<TKeyValuePair, CTaggedAllocator<TKeyValuePair, Tag>> TBucket;
+	typedef typename TBucket::iterator                                 TKeyValuePairIter;
 	// Use of templates is powerful, but can cause syntax headaches - the need for "typename"
 	// here is an example
 
@@ -340,7 +342,7 @@ private:
 
 		// Update size and create new set of buckets
 		m_iSize = iNewSize;
-		m_aBuckets = new TBucket[m_iSize];
+		m_aBuckets = TaggedNewArray<TBucket>( Tag, m_iSize );
 		GEN_ASSERT( m_aBuckets, "Fatal memory error reserving hash table memory" );
 
 		// Go through old buckets and set each key/value pair into new buckets
@@ -354,7 +356,7 @@ private:
 			}
 		}
 
-		delete[] aOldBuckets;
+		TaggedDeleteArray( aOldBuckets );
 
 		GEN_ENDGUARD;
 	}
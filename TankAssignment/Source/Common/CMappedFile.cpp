@@ -0,0 +1,106 @@
+/*******************************************
+	CMappedFile.cpp
+
+	Memory-mapped file implementation
+********************************************/
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "CMappedFile.h"
+
+namespace gen
+{
+
+CMappedFile::CMappedFile()
+{
+	m_Data = 0;
+	m_Size = 0;
+#ifdef _WIN32
+	m_File = INVALID_HANDLE_VALUE;
+	m_Mapping = 0;
+#endif
+}
+
+CMappedFile::~CMappedFile()
+{
+	Close();
+}
+
+
+// Map the given file, closing any file already open. Files of 4GB or more, and empty files, are
+// not supported. Returns false on failure
+bool CMappedFile::Open( const string& fileName )
+{
+	Close();
+
+#ifdef _WIN32
+	m_File = CreateFileA( fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+	                      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if (m_File == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx( m_File, &fileSize ) || fileSize.HighPart != 0 || fileSize.LowPart == 0)
+	{
+		Close();
+		return false;
+	}
+	m_Size = fileSize.LowPart;
+	m_Mapping = CreateFileMappingA( m_File, NULL, PAGE_READONLY, 0, 0, NULL );
+	if (!m_Mapping)
+	{
+		Close();
+		return false;
+	}
+	m_Data = static_cast<const TUInt8*>(MapViewOfFile( m_Mapping, FILE_MAP_READ, 0, 0, 0 ));
+#else
+	int file = open( fileName.c_str(), O_RDONLY );
+	if (file < 0)
+	{
+		return false;
+	}
+	struct stat fileInfo;
+	if (fstat( file, &fileInfo ) != 0 || fileInfo.st_size == 0 ||
+	    static_cast<TUInt64>(fileInfo.st_size) > 0xffffffffu)
+	{
+		close( file );
+		return false;
+	}
+	m_Size = static_cast<TUInt32>(fileInfo.st_size);
+	void* data = mmap( 0, m_Size, PROT_READ, MAP_PRIVATE, file, 0 );
+	close( file ); // Mapping remains valid after the file is closed
+	m_Data = (data == MAP_FAILED) ? 0 : static_cast<const TUInt8*>(data);
+#endif
+
+	if (!m_Data)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+// Unmap the file - pointers into the data are no longer valid
+void CMappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_Data)             UnmapViewOfFile( m_Data );
+	if (m_Mapping)          CloseHandle( m_Mapping );
+	if (m_File != INVALID_HANDLE_VALUE) CloseHandle( m_File );
+	m_Mapping = 0;
+	m_File = INVALID_HANDLE_VALUE;
+#else
+	if (m_Data) munmap( const_cast<TUInt8*>(m_Data), m_Size );
+#endif
+	m_Data = 0;
+	m_Size = 0;
+}
+
+
+} // namespace gen
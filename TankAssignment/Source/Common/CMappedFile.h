@@ -0,0 +1,80 @@
+/*******************************************
+	CMappedFile.h
+
+	A whole file mapped read-only into memory,
+	so its contents can be used in place with
+	no reading or copying. Pages are loaded by
+	the operating system as they are touched
+********************************************/
+
+#pragma once
+
+#include <string>
+using namespace std;
+
+#ifdef _WIN32
+	#include <Windows.h>
+#endif
+
+#include "Types.h"
+
+namespace gen
+{
+
+class CMappedFile
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	CMappedFile();
+	~CMappedFile();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CMappedFile( const CMappedFile& );
+	CMappedFile& operator=( const CMappedFile& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Map the given file, closing any file already open. Files of 4GB or more, and empty files,
+	// are not supported. Returns false on failure
+	bool Open( const string& fileName );
+
+	// Unmap the file - pointers into the data are no longer valid
+	void Close();
+
+	bool IsOpen() const
+	{
+		return m_Data != 0;
+	}
+
+	// Start and size of the mapped file, 0 if not open
+	const TUInt8* Data() const
+	{
+		return m_Data;
+	}
+	TUInt32 Size() const
+	{
+		return m_Size;
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	const TUInt8* m_Data;
+	TUInt32       m_Size;
+
+	// Operating system handles for the mapping
+#ifdef _WIN32
+	HANDLE        m_File;
+	HANDLE        m_Mapping;
+#endif
+};
+
+
+} // namespace gen
@@ -0,0 +1,133 @@
+/*******************************************
+	CThreadPool.cpp
+
+	Thread pool implementation
+********************************************/
+
+#include "CThreadPool.h"
+#include "Profiler.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+// Start the given number of worker threads. If 0 is given, start one fewer than the number of
+// hardware threads - the thread running a job also works on it
+CThreadPool::CThreadPool( TUInt32 numWorkers /*= 0*/ )
+{
+	m_Work = 0;
+	m_NumItems = 0;
+	m_NextItem = 0;
+	m_Job = 0;
+	m_WorkersBusy = 0;
+	m_Stop = false;
+
+	if (numWorkers == 0)
+	{
+		TUInt32 hardwareThreads = thread::hardware_concurrency(); // 0 if unknown
+		numWorkers = (hardwareThreads > 1) ? hardwareThreads - 1 : 0;
+	}
+	for (TUInt32 worker = 0; worker < numWorkers; ++worker)
+	{
+		m_Workers.push_back( thread( &CThreadPool::WorkerLoop, this ) );
+	}
+}
+
+// Stop and wait for the worker threads
+CThreadPool::~CThreadPool()
+{
+	{
+		lock_guard<mutex> lock( m_Mutex );
+		m_Stop = true;
+	}
+	m_JobReady.notify_all();
+	for (TUInt32 worker = 0; worker < m_Workers.size(); ++worker)
+	{
+		m_Workers[worker].join();
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Jobs
+//-----------------------------------------------------------------------------
+
+// Call work( item ) for each item from 0 to numItems - 1, shared between the workers and the
+// calling thread. Returns when all items are done
+void CThreadPool::ParallelFor( TUInt32 numItems, const function<void( TUInt32 )>& work )
+{
+	// Not worth waking the workers for a single item
+	if (m_Workers.empty() || numItems <= 1)
+	{
+		for (TUInt32 item = 0; item < numItems; ++item)
+		{
+			work( item );
+		}
+		return;
+	}
+
+	{
+		lock_guard<mutex> lock( m_Mutex );
+		m_Work = &work;
+		m_NumItems = numItems;
+		m_NextItem = 0;
+		m_WorkersBusy = static_cast<TUInt32>(m_Workers.size());
+		++m_Job;
+	}
+	m_JobReady.notify_all();
+
+	RunItems();
+
+	// All items have been taken, wait for the workers to finish the ones they are doing
+	unique_lock<mutex> lock( m_Mutex );
+	while (m_WorkersBusy > 0)
+	{
+		m_JobDone.wait( lock );
+	}
+	m_Work = 0;
+}
+
+// Worker thread function - waits for each job and works on it until told to stop
+void CThreadPool::WorkerLoop()
+{
+	GEN_PROFILE_THREAD( "Pool worker" );
+
+	TUInt32 lastJob = 0;
+	unique_lock<mutex> lock( m_Mutex );
+	while (true)
+	{
+		while (!m_Stop && m_Job == lastJob)
+		{
+			m_JobReady.wait( lock );
+		}
+		if (m_Stop)
+		{
+			return;
+		}
+		lastJob = m_Job;
+
+		lock.unlock();
+		RunItems();
+		lock.lock();
+
+		if (--m_WorkersBusy == 0)
+		{
+			m_JobDone.notify_one();
+		}
+	}
+}
+
+// Take items from the current job and do them until there are none left
+void CThreadPool::RunItems()
+{
+	for (TUInt32 item = m_NextItem++; item < m_NumItems; item = m_NextItem++)
+	{
+		(*m_Work)( item );
+	}
+}
+
+
+} // namespace gen
@@ -0,0 +1,90 @@
+/*******************************************
+	CThreadPool.h
+
+	A fixed set of worker threads that share
+	out the items of a job between them. Used
+	to spread independent loading work (e.g.
+	mesh imports) across the available cores
+********************************************/
+
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+using namespace std;
+
+#include "Defines.h"
+
+namespace gen
+{
+
+class CThreadPool
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Start the given number of worker threads. If 0 is given, start one fewer than the number of
+	// hardware threads - the thread running a job also works on it
+	CThreadPool( TUInt32 numWorkers = 0 );
+
+	// Stop and wait for the worker threads
+	~CThreadPool();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CThreadPool( const CThreadPool& );
+	CThreadPool& operator=( const CThreadPool& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Number of threads that work on each job, including the thread running it
+	TUInt32 NumThreads()
+	{
+		return static_cast<TUInt32>(m_Workers.size()) + 1;
+	}
+
+	// Call work( item ) for each item from 0 to numItems - 1, shared between the workers and the
+	// calling thread. Returns when all items are done. Items may run in any order and at the same
+	// time, so each must only change data of its own. Work must not use the pool itself
+	void ParallelFor( TUInt32 numItems, const function<void( TUInt32 )>& work );
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// Worker thread function - waits for each job and works on it until told to stop
+	void WorkerLoop();
+
+	// Take items from the current job and do them until there are none left
+	void RunItems();
+
+
+	// Worker threads
+	vector<thread>           m_Workers;
+
+	// Current job and the next item to take from it. Set while holding the mutex, then read
+	// without it by the threads working on the job
+	const function<void( TUInt32 )>* m_Work;
+	TUInt32                  m_NumItems;
+	atomic<TUInt32>          m_NextItem;
+
+	// Job control - the job number increases with each job so a worker knows when there is a new
+	// one. Workers count themselves off the job as they finish it
+	mutex                    m_Mutex;
+	condition_variable       m_JobReady;
+	condition_variable       m_JobDone;
+	TUInt32                  m_Job;
+	TUInt32                  m_WorkersBusy;
+	bool                     m_Stop;
+};
+
+
+} // namespace gen
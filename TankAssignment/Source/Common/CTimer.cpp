@@ -1,21 +1,25 @@
 /*******************************************
-	
+
 	CTimer.cpp
 
 	Timer class implementation
 
 ********************************************/
 
-#include "Windows.h"
 #include "CTimer.h"
 
 //////////////////////////////
 // Constructor
 
-CTimer::CTimer()
+CTimer::CTimer( gen::EClock clock /*= gen::EClock::Steady*/ )
 {
-	// Try to initialise performance timer, will use low-resolution timer on failure
-	m_HighRes = (QueryPerformanceFrequency( &m_HighResFreq ) != 0);
+	// Use the TSC if asked and it is reliable, the steady clock otherwise
+	if (clock == gen::EClock::Tsc && !gen::TscClockUsable())
+	{
+		clock = gen::EClock::Steady;
+	}
+	m_Clock = clock;
+	m_Frequency = gen::ClockTicksPerSecond( m_Clock );
 
 	// Reset and start the timer
 	Reset();
@@ -34,21 +38,9 @@ void CTimer::Start()
 		m_Running = true;
 
 		// Get restart time - add time passed since stop time to the start and lap times
-		// Select high or low-resolution timer
-		if (m_HighRes)
-		{
-			LARGE_INTEGER newHighResTime;
-			QueryPerformanceCounter( &newHighResTime );
-			m_HighResStart.QuadPart += (newHighResTime.QuadPart - m_HighResStop.QuadPart);
-			m_HighResLap.QuadPart += (newHighResTime.QuadPart - m_HighResStop.QuadPart);
-		}
-		else
-		{
-			DWORD newLowResTime;
-			newLowResTime = timeGetTime();
-			m_LowResStart += (newLowResTime - m_LowResStop);
-			m_LowResLap += (newLowResTime - m_LowResStop);
-		}
+		gen::TInt64 newTime = Now();
+		m_Start += (newTime - m_Stop);
+		m_Lap += (newTime - m_Stop);
 	}
 }
 
@@ -58,125 +50,35 @@ void CTimer::Stop()
 	m_Running = false;
 
 	// Get stop time
-	// Select high or low-resolution timer
-	if (m_HighRes)
-	{
-		QueryPerformanceCounter( &m_HighResStop );
-	}
-	else
-	{
-		m_LowResStop = timeGetTime();
-	}
+	m_Stop = Now();
 }
 
 // Reset the timer to zero
 void CTimer::Reset()
 {
 	// Reset start, lap and stop times to current time
-	// Select high or low-resolution timer
-	if (m_HighRes)
-	{
-		QueryPerformanceCounter( &m_HighResStart );
-		m_HighResLap = m_HighResStart;
-		m_HighResStop = m_HighResStart;
-	}
-	else
-	{
-		m_LowResStart = timeGetTime();
-		m_LowResLap = m_LowResStart;
-		m_LowResStop = m_LowResStart;
-	}
+	m_Start = Now();
+	m_Lap = m_Start;
+	m_Stop = m_Start;
 }
 
 
 //////////////////////////////
 // Timing
 
-// Get frequency of the timer being used (in counts per second)
-float CTimer::GetFrequency()
-{
-	// Select high or low-resolution timer
-	if (m_HighRes)
-	{
-		return static_cast<float>(m_HighResFreq.QuadPart);
-	}
-	else
-	{
-		return 1000.0f;
-	}
-}
-
-// Get time passed (seconds) since since timer was started or last reset
-float CTimer::GetTime()
+// Get ticks passed since timer was started or last reset
+gen::TInt64 CTimer::GetTicks()
 {
-	float fTime;
-	if (m_HighRes)
-	{
-
-		LARGE_INTEGER newHighResTime;
-		if (m_Running)
-		{
-			QueryPerformanceCounter( &newHighResTime );
-		}
-		else
-		{
-			newHighResTime = m_HighResStop;
-		}
-		double dTime = static_cast<double>(newHighResTime.QuadPart - m_HighResStart.QuadPart) /
-			           static_cast<double>(m_HighResFreq.QuadPart);
-		fTime = static_cast<float>(dTime);
-	}
-	else
-	{
-		DWORD newLowResTime;
-		if (m_Running)
-		{
-			newLowResTime = timeGetTime();
-		}
-		else
-		{
-			newLowResTime = m_LowResStop;
-		}
-		fTime = static_cast<float>(newLowResTime - m_LowResStart) / 1000.0f;
-	}
-
-	return fTime;
+	gen::TInt64 newTime = m_Running ? Now() : m_Stop;
+	return newTime - m_Start;
 }
 
-// Get time passed (seconds) since last call to this function. If this is the first call, then
-// the time since timer was started or the last reset is returned
-float CTimer::GetLapTime()
+// Get ticks passed since last call to this function. If this is the first call, then the ticks
+// since timer was started or the last reset are returned
+gen::TInt64 CTimer::GetLapTicks()
 {
-	float fTime;
-	if (m_HighRes)
-	{
-		LARGE_INTEGER newHighResTime;
-		if (m_Running)
-		{
-			QueryPerformanceCounter( &newHighResTime );
-		}
-		else
-		{
-			newHighResTime = m_HighResStop;
-		}
-		double dTime = static_cast<double>(newHighResTime.QuadPart - m_HighResLap.QuadPart) /
-			           static_cast<double>(m_HighResFreq.QuadPart);
-		fTime = static_cast<float>(dTime);
-		m_HighResLap = newHighResTime;
-	}
-	else
-	{
-		DWORD newLowResTime;
-		if (m_Running)
-		{
-			newLowResTime = timeGetTime();
-		}
-		else
-		{
-			newLowResTime = m_LowResStop;
-		}
-		fTime = static_cast<float>(newLowResTime - m_LowResLap) / 1000.0f;
-		m_LowResLap = newLowResTime;
-	}
-	return fTime;
+	gen::TInt64 newTime = m_Running ? Now() : m_Stop;
+	gen::TInt64 lapTicks = newTime - m_Lap;
+	m_Lap = newTime;
+	return lapTicks;
 }
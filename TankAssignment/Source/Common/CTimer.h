@@ -1,5 +1,5 @@
 /*******************************************
-	
+
 	CTimer.h
 
 	Timer class declarations
@@ -9,7 +9,8 @@
 #pragma once
 
 
-#include "Windows.h"
+#include "Defines.h"
+#include "Clock.h"
 
 class CTimer
 {
@@ -18,9 +19,11 @@ public:
 	//////////////////////////////
 	// Constructor
 
-	CTimer();
+	// Construct and start a timer reading the given clock (see Clock.h). The TSC clock is only
+	// used if TscClockUsable, otherwise the steady clock is used
+	CTimer( gen::EClock clock = gen::EClock::Steady );
+
 
-	
 	//////////////////////////////
 	// Timer control
 
@@ -37,38 +40,68 @@ public:
 	//////////////////////////////
 	// Timing
 
-	// Get frequency of the timer being used (in counts per second)
-	float GetFrequency();
+	// Get the clock being used
+	gen::EClock GetClock()
+	{
+		return m_Clock;
+	}
+
+	// Get frequency of the timer being used (in ticks per second)
+	gen::TFloat64 GetFrequency()
+	{
+		return m_Frequency;
+	}
+
+	// Get ticks passed since timer was started or last reset
+	gen::TInt64 GetTicks();
+
+	// Get ticks passed since last call to this function or GetLapTime. If this is the first call,
+	// then the ticks since timer was started or the last reset are returned
+	gen::TInt64 GetLapTicks();
 
 	// Get time passed (seconds) since since timer was started or last reset
-	float GetTime();
+	float GetTime()
+	{
+		return static_cast<float>(GetPreciseTime());
+	}
 
 	// Get time passed (seconds) since last call to this function. If this is the first call, then
 	// the time since timer was started or the last reset is returned
-	float GetLapTime();
+	float GetLapTime()
+	{
+		return static_cast<float>(GetPreciseLapTime());
+	}
+
+	// Double precision versions of GetTime and GetLapTime, for times too long to be kept accurately
+	// in a float (a float of seconds only counts in steps of 1ms after a few hours)
+	gen::TFloat64 GetPreciseTime()
+	{
+		return gen::TicksToSeconds( GetTicks(), m_Frequency );
+	}
+	gen::TFloat64 GetPreciseLapTime()
+	{
+		return gen::TicksToSeconds( GetLapTicks(), m_Frequency );
+	}
 
 
 private:
+	// Current clock reading
+	gen::TInt64 Now()
+	{
+		return gen::ClockTicks( m_Clock );
+	}
+
 	// Is the timer running
 	bool m_Running;
 
+	// Clock used and its frequency
+	gen::EClock   m_Clock;
+	gen::TFloat64 m_Frequency;
 
-	// Using high resolution timer and if so its frequency
-	bool          m_HighRes;
-	LARGE_INTEGER m_HighResFreq;
-
-	// Start time and last lap start time of high-resolution timer
-	LARGE_INTEGER m_HighResStart;
-	LARGE_INTEGER m_HighResLap;
-
-	// Time when high-resolution timer was stopped (if it has been)
-	LARGE_INTEGER m_HighResStop;
-
-
-	// Start time and last lap start time of low-resolution timer
-	DWORD m_LowResStart;
-	DWORD m_LowResLap;
+	// Start time and last lap start time
+	gen::TInt64 m_Start;
+	gen::TInt64 m_Lap;
 
-	// Time when low-resolution timer was stopped (if it has been)
-	DWORD m_LowResStop;
+	// Time when timer was stopped (if it has been)
+	gen::TInt64 m_Stop;
 };
@@ -0,0 +1,77 @@
+/*******************************************
+	Clock.cpp
+
+	Portable high-resolution clocks, see header
+********************************************/
+
+#include "Clock.h"
+
+#if defined(GEN_CLOCK_HAS_TSC) && !defined(_MSC_VER)
+	#include <cpuid.h>
+#endif
+
+namespace gen
+{
+
+// Time the TSC is compared with the steady clock to find its rate
+const TFloat64 kTscCalibrationSeconds = 0.02;
+
+// Measure the TSC rate against the steady clock over a short busy wait. Both clocks are read
+// back to back at each end, so the error is a few reads in millions of ticks
+static TFloat64 CalibrateTsc()
+{
+#ifdef GEN_CLOCK_HAS_TSC
+	TInt64 steadyStart = SteadyTicks();
+	TInt64 tscStart = TscTicks();
+	TInt64 steadyEnd = steadyStart + SecondsToTicks( kTscCalibrationSeconds, SteadyTicksPerSecond() );
+	TInt64 steadyNow;
+	do
+	{
+		steadyNow = SteadyTicks();
+	} while (steadyNow < steadyEnd);
+	TInt64 tscEnd = TscTicks();
+
+	return static_cast<TFloat64>(tscEnd - tscStart) / TicksToSeconds( steadyNow - steadyStart, SteadyTicksPerSecond() );
+#else
+	return SteadyTicksPerSecond();
+#endif
+}
+
+// TSC ticks per second, calibrated on the first call. Safe on any thread
+TFloat64 TscTicksPerSecond()
+{
+	static const TFloat64 ticksPerSecond = CalibrateTsc();
+	return ticksPerSecond;
+}
+
+// Whether the TSC is invariant - reported in bit 8 of EDX from CPUID leaf 0x80000007
+bool TscClockUsable()
+{
+#ifdef GEN_CLOCK_HAS_TSC
+	const unsigned int kInvariantTscLeaf = 0x80000007;
+	const unsigned int kInvariantTscBit = 1 << 8;
+	#ifdef _MSC_VER
+		int registers[4];
+		__cpuid( registers, 0x80000000 );
+		if (static_cast<unsigned int>(registers[0]) < kInvariantTscLeaf)
+		{
+			return false;
+		}
+		__cpuid( registers, kInvariantTscLeaf );
+		return (static_cast<unsigned int>(registers[3]) & kInvariantTscBit) != 0;
+	#else
+		unsigned int eax, ebx, ecx, edx;
+		if (__get_cpuid_max( 0x80000000, 0 ) < kInvariantTscLeaf)
+		{
+			return false;
+		}
+		__get_cpuid( kInvariantTscLeaf, &eax, &ebx, &ecx, &edx );
+		return (edx & kInvariantTscBit) != 0;
+	#endif
+#else
+	return false;
+#endif
+}
+
+
+} // namespace gen
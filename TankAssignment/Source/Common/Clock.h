@@ -0,0 +1,124 @@
+/*******************************************
+	Clock.h
+
+	Portable high-resolution clocks, read as
+	64-bit integer ticks so long runs lose no
+	precision. Two clocks are available:
+	- Steady: std::chrono::steady_clock,
+	  available everywhere
+	- TSC: the CPU's time stamp counter, read
+	  directly. Several times cheaper to read
+	  than the steady clock, for fine-grained
+	  instrumentation. Its rate is calibrated
+	  against the steady clock the first time
+	  it is needed. On CPUs without a time
+	  stamp counter it is the steady clock
+
+	Convert ticks to time with the helpers at
+	the end, using the rate of the clock read
+********************************************/
+
+#pragma once
+
+#include <chrono>
+using namespace std;
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+	#define GEN_CLOCK_HAS_TSC
+	#ifdef _MSC_VER
+		#include <intrin.h>
+	#else
+		#include <x86intrin.h>
+	#endif
+#endif
+
+#include "Defines.h"
+
+namespace gen
+{
+
+// Clocks that can be read
+enum class EClock
+{
+	Steady,
+	Tsc,
+};
+
+
+/////////////////////////////////////
+// Steady clock
+
+// Current time in steady clock ticks
+inline TInt64 SteadyTicks()
+{
+	return chrono::steady_clock::now().time_since_epoch().count();
+}
+
+inline TFloat64 SteadyTicksPerSecond()
+{
+	return static_cast<TFloat64>(chrono::steady_clock::period::den) / chrono::steady_clock::period::num;
+}
+
+
+/////////////////////////////////////
+// TSC clock
+
+// Current time in TSC ticks
+inline TInt64 TscTicks()
+{
+#ifdef GEN_CLOCK_HAS_TSC
+	return static_cast<TInt64>(__rdtsc());
+#else
+	return SteadyTicks();
+#endif
+}
+
+// TSC ticks per second. The first call calibrates the TSC against the steady clock, which takes
+// about 20ms, so call it during setup rather than the first time it is needed in a measurement
+TFloat64 TscTicksPerSecond();
+
+// Whether the TSC ticks at a constant rate whatever the power state of the CPU and is the same
+// on every core (an "invariant" TSC, on all x86 CPUs of the last decade or so). If not, TSC times
+// are unreliable and the steady clock should be used instead
+bool TscClockUsable();
+
+
+/////////////////////////////////////
+// Either clock
+
+inline TInt64 ClockTicks( EClock clock )
+{
+	return (clock == EClock::Tsc) ? TscTicks() : SteadyTicks();
+}
+
+inline TFloat64 ClockTicksPerSecond( EClock clock )
+{
+	return (clock == EClock::Tsc) ? TscTicksPerSecond() : SteadyTicksPerSecond();
+}
+
+
+/////////////////////////////////////
+// Conversions
+
+inline TFloat64 TicksToSeconds( TInt64 ticks, TFloat64 ticksPerSecond )
+{
+	return static_cast<TFloat64>(ticks) / ticksPerSecond;
+}
+
+inline TFloat64 TicksToMilliseconds( TInt64 ticks, TFloat64 ticksPerSecond )
+{
+	return static_cast<TFloat64>(ticks) * 1000.0 / ticksPerSecond;
+}
+
+inline TFloat64 TicksToMicroseconds( TInt64 ticks, TFloat64 ticksPerSecond )
+{
+	return static_cast<TFloat64>(ticks) * 1000000.0 / ticksPerSecond;
+}
+
+inline TInt64 SecondsToTicks( TFloat64 seconds, TFloat64 ticksPerSecond )
+{
+	return static_cast<TInt64>(seconds * ticksPerSecond + 0.5);
+}
+
+
+} // namespace gen
@@ -12,9 +12,11 @@
 **************************************************************************************************/
 #pragma once // Prevent file being included more than once (would cause errors)
 
-#include <Windows.h>
-#include <d3d10.h>  // Updated header files of course
-#include <d3dx10.h> // --"--
+#ifdef _WIN32
+	#include <Windows.h>
+	#include <d3d10.h>  // Updated header files of course
+	#include <d3dx10.h> // --"--
+#endif
 
 #ifndef GEN_DEFINES_H_INCLUDED
 #define GEN_DEFINES_H_INCLUDED
@@ -26,7 +28,9 @@ using namespace std;
 #if defined (_MSC_VER)
 	#include "MSDefines.h" // _MSC_VER is only defined on Microsoft compilers
 #else
-	#error "Unsupported OS/compiler - only Windows and Visual Studio supported at present"
+	// Other compilers only build the platform-neutral code (maths, X-File parsing, mesh files),
+	// which needs no more than the fixed size types
+	#include "Types.h"
 #endif
 
 namespace gen
@@ -120,7 +124,9 @@ inline void SetObjectName( const char* ) {}
 // this is not good practice - this is a kind of super-global variable. Would
 // be better to have a Device class responsible for this data. However, this
 // example aims for a minimum of code to help demonstrate the focus topic
+#ifdef _WIN32
 extern ID3D10Device* g_pd3dDevice; // New type for DX10
+#endif
 
 
 
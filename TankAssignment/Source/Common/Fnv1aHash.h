@@ -0,0 +1,39 @@
+/*******************************************
+	Fnv1aHash.h
+
+	64-bit FNV-1a hash (Fowler / Noll / Vo)
+	of a stream of bytes. Quick to calculate
+	and well mixed, but not for security -
+	used for hashes of files and of the
+	simulation state
+********************************************/
+
+#pragma once
+
+#include <cstddef>
+using namespace std;
+
+#include "Types.h"
+
+namespace gen
+{
+
+// Hash of no bytes, to start from
+const TUInt64 kFnv1aOffsetBasis = 14695981039346656037ull;
+
+// Each byte is xor'd into the hash, which is then multiplied by this
+const TUInt64 kFnv1aPrime = 1099511628211ull;
+
+// Continue a hash over the given bytes, returning the new hash
+inline TUInt64 Fnv1aHash( TUInt64 hash, const void* data, size_t numBytes )
+{
+	const TUInt8* bytes = static_cast<const TUInt8*>(data);
+	for (size_t byte = 0; byte < numBytes; ++byte)
+	{
+		hash = (hash ^ bytes[byte]) * kFnv1aPrime;
+	}
+	return hash;
+}
+
+
+} // namespace gen
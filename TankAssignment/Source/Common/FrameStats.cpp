@@ -0,0 +1,109 @@
+/*******************************************
+	FrameStats.cpp
+
+	Tick timing statistics, see header
+********************************************/
+
+#include <sstream>
+#include <iomanip>
+#include "FrameStats.h"
+
+namespace gen
+{
+
+// Names of each timing in reports
+static const char* const FrameStatNames[static_cast<TUInt32>(EFrameStat::NumStats)] = { "Update", "Render" };
+
+
+//-----------------------------------------------------------------------------
+// Constructor
+//-----------------------------------------------------------------------------
+
+// Construct with a rolling window of the given length in seconds, in one second slices (or ten
+// slices for shorter windows)
+CFrameStats::CFrameStats( TFloat32 windowTime /*= 10.0f*/ )
+{
+	TUInt32 numSlices = (windowTime >= 10.0f) ? static_cast<TUInt32>(windowTime) : 10;
+	for (TUInt32 stat = 0; stat < static_cast<TUInt32>(EFrameStat::NumStats); ++stat)
+	{
+		m_Times[stat] = CRollingHistogram( windowTime, numSlices );
+	}
+	m_NumTicks = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Recording
+//-----------------------------------------------------------------------------
+
+// Record the time in seconds a tick spent on the given work
+void CFrameStats::Record( EFrameStat stat, TFloat32 time )
+{
+	TFloat32 microseconds = (time > 0.0f) ? time * 1000000.0f + 0.5f : 0.0f;
+	m_Times[static_cast<TUInt32>(stat)].Record( static_cast<TUInt64>(microseconds) );
+}
+
+// End the current tick, which took the given time in seconds overall. Moves the window on
+void CFrameStats::EndTick( TFloat32 tickTime )
+{
+	for (TUInt32 stat = 0; stat < static_cast<TUInt32>(EFrameStat::NumStats); ++stat)
+	{
+		m_Times[stat].Advance( tickTime );
+	}
+	++m_NumTicks;
+}
+
+// Discard all times recorded
+void CFrameStats::Clear()
+{
+	for (TUInt32 stat = 0; stat < static_cast<TUInt32>(EFrameStat::NumStats); ++stat)
+	{
+		m_Times[stat].Clear();
+	}
+	m_NumTicks = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Queries
+//-----------------------------------------------------------------------------
+
+// Count, mean, percentiles and maximum of the given timing over the window, or the whole run
+SFrameStatSummary CFrameStats::Summary( EFrameStat stat, bool allTime /*= false*/ ) const
+{
+	const CLatencyHistogram& times = Histogram( stat, allTime );
+	SFrameStatSummary summary;
+	summary.count = times.Count();
+	summary.mean = static_cast<TFloat32>(times.Mean() / 1000000.0);
+	for (TUInt32 percentile = 0; percentile < kNumFramePercentiles; ++percentile)
+	{
+		summary.percentiles[percentile] = times.Percentile( kFramePercentiles[percentile] ) / 1000000.0f;
+	}
+	summary.max = times.Max() / 1000000.0f;
+	return summary;
+}
+
+// One line per timing recorded with its percentiles and maximum in milliseconds
+string CFrameStats::Report( bool allTime /*= false*/ ) const
+{
+	stringstream report;
+	report << fixed << setprecision( 3 );
+	for (TUInt32 stat = 0; stat < static_cast<TUInt32>(EFrameStat::NumStats); ++stat)
+	{
+		SFrameStatSummary summary = Summary( static_cast<EFrameStat>(stat), allTime );
+		if (summary.count == 0)
+		{
+			continue;
+		}
+		report << FrameStatNames[stat] << " ms:  mean " << summary.mean * 1000.0f;
+		for (TUInt32 percentile = 0; percentile < kNumFramePercentiles; ++percentile)
+		{
+			report << "  " << kFramePercentileNames[percentile] << ' ' << summary.percentiles[percentile] * 1000.0f;
+		}
+		report << "  max " << summary.max * 1000.0f << "  (" << summary.count << " ticks)" << endl;
+	}
+	return report.str();
+}
+
+
+} // namespace gen
@@ -0,0 +1,109 @@
+/*******************************************
+	FrameStats.h
+
+	Distribution of the time taken by each
+	tick's update and render, over a rolling
+	window and the whole run. Percentiles show
+	the spikes (entity creation, table resizes,
+	message bursts) that an average hides
+********************************************/
+
+#pragma once
+
+#include <string>
+using namespace std;
+
+#include "Defines.h"
+#include "LatencyHistogram.h"
+
+namespace gen
+{
+
+// Timings kept for each tick
+enum class EFrameStat : TUInt32
+{
+	Update,
+	Render,
+	NumStats
+};
+
+// Percentiles reported, with their names
+const TUInt32 kNumFramePercentiles = 4;
+const TFloat64 kFramePercentiles[kNumFramePercentiles] = { 50.0, 90.0, 99.0, 99.9 };
+const char* const kFramePercentileNames[kNumFramePercentiles] = { "p50", "p90", "p99", "p99.9" };
+
+// Summary of one timing, all times in seconds
+struct SFrameStatSummary
+{
+	TUInt64  count;
+	TFloat32 mean;
+	TFloat32 percentiles[kNumFramePercentiles]; // See kFramePercentiles
+	TFloat32 max;
+};
+
+
+class CFrameStats
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Construct with a rolling window of the given length in seconds
+	CFrameStats( TFloat32 windowTime = 10.0f );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Recording
+
+	// Record the time in seconds a tick spent on the given work
+	void Record( EFrameStat stat, TFloat32 time );
+
+	// End the current tick, which took the given time in seconds overall. Moves the window on
+	void EndTick( TFloat32 tickTime );
+
+	// Discard all times recorded
+	void Clear();
+
+
+	/////////////////////////////////////
+	// Queries
+
+	// Histogram of the given timing in microseconds over the window, or the whole run
+	const CLatencyHistogram& Histogram( EFrameStat stat, bool allTime = false ) const
+	{
+		const CRollingHistogram& times = m_Times[static_cast<TUInt32>(stat)];
+		return allTime ? times.AllTime() : times.Window();
+	}
+
+	// Count, mean, percentiles and maximum of the given timing over the window, or the whole run
+	SFrameStatSummary Summary( EFrameStat stat, bool allTime = false ) const;
+
+	// Ticks ended so far
+	TUInt64 NumTicks() const
+	{
+		return m_NumTicks;
+	}
+
+	TFloat32 WindowTime() const
+	{
+		return m_Times[0].WindowTime();
+	}
+
+	// One line per timing recorded (timings never recorded are left out) with its percentiles and
+	// maximum in milliseconds, over the window or the whole run
+	string Report( bool allTime = false ) const;
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	CRollingHistogram m_Times[static_cast<TUInt32>(EFrameStat::NumStats)]; // Microseconds
+	TUInt64           m_NumTicks;
+};
+
+
+} // namespace gen
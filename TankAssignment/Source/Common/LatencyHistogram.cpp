@@ -0,0 +1,157 @@
+/*******************************************
+	LatencyHistogram.cpp
+
+	Latency histograms, see header
+********************************************/
+
+#include <cstring>
+#include "LatencyHistogram.h"
+
+namespace gen
+{
+
+/*---------------------------------------------------------------------------------------------
+	CLatencyHistogram class
+---------------------------------------------------------------------------------------------*/
+
+// Construct an empty histogram
+CLatencyHistogram::CLatencyHistogram()
+{
+	Clear();
+}
+
+// Add all the values recorded in another histogram to this one
+void CLatencyHistogram::Add( const CLatencyHistogram& other )
+{
+	for (TUInt32 bucket = 0; bucket < kHistogramBuckets; ++bucket)
+	{
+		m_Counts[bucket] += other.m_Counts[bucket];
+	}
+	m_Count += other.m_Count;
+	m_Sum += other.m_Sum;
+	m_Max = (other.m_Max > m_Max) ? other.m_Max : m_Max;
+}
+
+// Remove the values recorded in another histogram, which must all have been added to this one
+void CLatencyHistogram::Subtract( const CLatencyHistogram& other )
+{
+	for (TUInt32 bucket = 0; bucket < kHistogramBuckets; ++bucket)
+	{
+		m_Counts[bucket] -= other.m_Counts[bucket];
+	}
+	m_Count -= other.m_Count;
+	m_Sum -= other.m_Sum;
+}
+
+// Discard all values
+void CLatencyHistogram::Clear()
+{
+	memset( m_Counts, 0, sizeof(m_Counts) );
+	m_Count = 0;
+	m_Sum = 0;
+	m_Max = 0;
+}
+
+
+// Value that the given percentage of recorded values are at or below, to within the bucket size
+TUInt64 CLatencyHistogram::Percentile( TFloat64 percent ) const
+{
+	if (m_Count == 0)
+	{
+		return 0;
+	}
+
+	// Rank of the value wanted, counting from 1. Rounded up so e.g. the 99.9th percentile of 100
+	// values is the largest
+	TFloat64 rank = m_Count * percent / 100.0;
+	TUInt64 target = static_cast<TUInt64>(rank);
+	if (target < rank || target == 0)
+	{
+		++target;
+	}
+	target = (target < m_Count) ? target : m_Count;
+
+	TUInt64 seen = 0;
+	for (TUInt32 bucket = 0; bucket < kHistogramBuckets; ++bucket)
+	{
+		seen += m_Counts[bucket];
+		if (seen >= target)
+		{
+			TUInt64 top = BucketTop( bucket );
+			return (top < m_Max) ? top : m_Max;
+		}
+	}
+	return m_Max;
+}
+
+// Largest value held in the given bucket
+TUInt64 CLatencyHistogram::BucketTop( TUInt32 bucket )
+{
+	if (bucket < 2 * kHistogramSubBuckets)
+	{
+		return bucket;
+	}
+	TUInt32 shift = bucket / kHistogramSubBuckets - 1;
+	TUInt64 subBucket = bucket % kHistogramSubBuckets + kHistogramSubBuckets;
+	return ((subBucket + 1) << shift) - 1;
+}
+
+
+/*---------------------------------------------------------------------------------------------
+	CRollingHistogram class
+---------------------------------------------------------------------------------------------*/
+
+// Construct for a window of the given length in seconds, split into the given number of slices
+CRollingHistogram::CRollingHistogram( TFloat32 windowTime /*= 10.0f*/, TUInt32 numSlices /*= 10*/ )
+{
+	numSlices = (numSlices > 0) ? numSlices : 1;
+	m_Slices.resize( numSlices );
+	m_CurrentSlice = 0;
+	m_SliceTime = windowTime / numSlices;
+	m_TimeInSlice = 0.0f;
+}
+
+// Move time forward by the given number of seconds, dropping slices that leave the window. The
+// largest value in the window is then the largest of the slices left
+void CRollingHistogram::Advance( TFloat32 time )
+{
+	m_TimeInSlice += time;
+	if (m_TimeInSlice < m_SliceTime)
+	{
+		return;
+	}
+
+	// A long pause may skip several slices, but there is no need to empty each more than once
+	TUInt32 numSlices = static_cast<TUInt32>(m_Slices.size());
+	TUInt32 slicesPassed = static_cast<TUInt32>(m_TimeInSlice / m_SliceTime);
+	m_TimeInSlice -= slicesPassed * m_SliceTime;
+	for (TUInt32 slice = 0; slice < slicesPassed && slice < numSlices; ++slice)
+	{
+		m_CurrentSlice = (m_CurrentSlice + 1) % numSlices;
+		m_Window.Subtract( m_Slices[m_CurrentSlice] );
+		m_Slices[m_CurrentSlice].Clear();
+	}
+
+	TUInt64 max = 0;
+	for (TUInt32 slice = 0; slice < numSlices; ++slice)
+	{
+		max = (m_Slices[slice].Max() > max) ? m_Slices[slice].Max() : max;
+	}
+	m_Window.SetMax( max );
+}
+
+// Discard all values
+void CRollingHistogram::Clear()
+{
+	for (TUInt32 slice = 0; slice < m_Slices.size(); ++slice)
+	{
+		m_Slices[slice].Clear();
+	}
+	m_Window.Clear();
+	m_AllTime.Clear();
+	m_CurrentSlice = 0;
+	m_TimeInSlice = 0.0f;
+}
+
+
+} // namespace gen
@@ -0,0 +1,201 @@
+/*******************************************
+	LatencyHistogram.h
+
+	Histograms of latencies (or any other
+	non-negative integer values) for tail
+	percentiles. Buckets are spaced like an
+	HDR histogram: exact for small values, then
+	a fixed number of buckets per power of two,
+	so every value is held to within 1% and
+	recording is a few instructions
+********************************************/
+
+#pragma once
+
+#include <vector>
+using namespace std;
+
+#include "Defines.h"
+
+namespace gen
+{
+
+// Buckets per power of two, as a power of two. 2^7 buckets gives values to within 1/128
+const TUInt32 kHistogramSubBucketBits = 7;
+const TUInt32 kHistogramSubBuckets = 1 << kHistogramSubBucketBits;
+
+// Largest value held - larger values are recorded as this
+const TUInt64 kHistogramMaxValue = 0xffffffffu;
+
+// Number of buckets needed to cover values up to kHistogramMaxValue
+const TUInt32 kHistogramBuckets = (32 - kHistogramSubBucketBits + 1) * kHistogramSubBuckets;
+
+
+/*---------------------------------------------------------------------------------------------
+	CLatencyHistogram class
+---------------------------------------------------------------------------------------------*/
+
+class CLatencyHistogram
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Construct an empty histogram
+	CLatencyHistogram();
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Recording
+
+	// Record a value, in whatever unit the histogram is used for (e.g. microseconds)
+	void Record( TUInt64 value )
+	{
+		value = (value < kHistogramMaxValue) ? value : kHistogramMaxValue;
+		++m_Counts[BucketIndex( value )];
+		++m_Count;
+		m_Sum += value;
+		m_Max = (value > m_Max) ? value : m_Max;
+	}
+
+	// Add all the values recorded in another histogram to this one
+	void Add( const CLatencyHistogram& other );
+
+	// Remove the values recorded in another histogram, which must all have been added to this one.
+	// The maximum is not changed, see SetMax
+	void Subtract( const CLatencyHistogram& other );
+
+	// Discard all values
+	void Clear();
+
+
+	/////////////////////////////////////
+	// Queries
+
+	TUInt64 Count() const
+	{
+		return m_Count;
+	}
+
+	// Largest value recorded, 0 if none
+	TUInt64 Max() const
+	{
+		return m_Max;
+	}
+
+	// Replace the largest value, e.g. after Subtract when the caller knows the largest that remains
+	void SetMax( TUInt64 max )
+	{
+		m_Max = max;
+	}
+
+	// Mean of the values recorded, 0 if none
+	TFloat64 Mean() const
+	{
+		return m_Count ? static_cast<TFloat64>(m_Sum) / m_Count : 0.0;
+	}
+
+	// Value that the given percentage (0 to 100) of recorded values are at or below, to within the
+	// bucket size. Reports the top of the bucket (never above the maximum) so tails are not
+	// understated. Returns 0 if there are no values
+	TUInt64 Percentile( TFloat64 percent ) const;
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// Bucket holding the given value. Values below 2 * kHistogramSubBuckets have a bucket each,
+	// above that each power of two is split into kHistogramSubBuckets buckets
+	static TUInt32 BucketIndex( TUInt64 value )
+	{
+		TUInt32 shift = 0;
+		while ((value >> shift) >= 2 * kHistogramSubBuckets)
+		{
+			++shift;
+		}
+		return shift * kHistogramSubBuckets + static_cast<TUInt32>(value >> shift);
+	}
+
+	// Largest value held in the given bucket
+	static TUInt64 BucketTop( TUInt32 bucket );
+
+
+	TUInt32  m_Counts[kHistogramBuckets];
+	TUInt64  m_Count;
+	TUInt64  m_Sum;
+	TUInt64  m_Max;
+};
+
+
+/*---------------------------------------------------------------------------------------------
+	CRollingHistogram class
+---------------------------------------------------------------------------------------------*/
+
+// Histogram of the values recorded over the last few seconds, plus one of all values. The window
+// is split into slices of equal time - when time moves past the end of the newest slice, the
+// oldest slice is dropped from the window. The window is kept up to date as values are recorded,
+// so querying it costs nothing extra
+class CRollingHistogram
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Construct for a window of the given length in seconds, split into the given number of slices
+	CRollingHistogram( TFloat32 windowTime = 10.0f, TUInt32 numSlices = 10 );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Record a value in the current slice
+	void Record( TUInt64 value )
+	{
+		m_Slices[m_CurrentSlice].Record( value );
+		m_Window.Record( value );
+		m_AllTime.Record( value );
+	}
+
+	// Move time forward by the given number of seconds, dropping slices that leave the window
+	void Advance( TFloat32 time );
+
+	// Values recorded over the window (the last windowTime seconds, to within a slice)
+	const CLatencyHistogram& Window() const
+	{
+		return m_Window;
+	}
+
+	// Every value recorded
+	const CLatencyHistogram& AllTime() const
+	{
+		return m_AllTime;
+	}
+
+	TFloat32 WindowTime() const
+	{
+		return m_SliceTime * m_Slices.size();
+	}
+
+	// Discard all values
+	void Clear();
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	vector<CLatencyHistogram> m_Slices;
+	TUInt32                   m_CurrentSlice;
+	TFloat32                  m_SliceTime;
+	TFloat32                  m_TimeInSlice;
+
+	CLatencyHistogram         m_Window; // Sum of the slices
+	CLatencyHistogram         m_AllTime;
+};
+
+
+} // namespace gen
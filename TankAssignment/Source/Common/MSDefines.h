@@ -20,6 +20,8 @@
 #include <string>
 using namespace std;
 
+#include "Types.h"
+
 namespace gen
 {
 
@@ -90,19 +92,7 @@ const string ksNewline = "\n";
 	Types
  ------------------------------------------------------------------------------------------------*/
 
-// Typedefs for fixed size types
-typedef signed char      TInt8;
-typedef signed short     TInt16;
-typedef signed int       TInt32;
-typedef signed __int64   TInt64;
-
-typedef unsigned char    TUInt8;
-typedef unsigned short   TUInt16;
-typedef unsigned int     TUInt32;
-typedef unsigned __int64 TUInt64;
-
-typedef float            TFloat32;
-typedef double           TFloat64;
+// Fixed size types are the same on all platforms, see Types.h
 
 
 /*------------------------------------------------------------------------------------------------
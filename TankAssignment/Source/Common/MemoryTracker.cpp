@@ -0,0 +1,154 @@
+/*******************************************
+	MemoryTracker.cpp
+
+	Memory used by each subsystem, see header
+********************************************/
+
+#include <sstream>
+#include <iomanip>
+
+#include "MemoryTracker.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// Global variables
+
+// Define a single memory tracker for the program. Zero initialised, see header
+CMemoryTracker MemoryTracker;
+
+// Names of each tag in reports
+static const char* const MemoryTagNames[static_cast<TUInt32>(EMemoryTag::NumTags)] =
+{
+	"Other", "Entities", "Entity matrices", "Entity look-up", "Messages", "Meshes", "Waypoints"
+};
+
+// Name of a tag in reports
+const char* MemoryTagName( EMemoryTag tag )
+{
+	return MemoryTagNames[static_cast<TUInt32>(tag)];
+}
+
+
+//-----------------------------------------------------------------------------
+// Counting
+//-----------------------------------------------------------------------------
+
+// End of a game tick, the per-tick counts are for the tick just ended. Main thread only
+void CMemoryTracker::EndTick()
+{
+	for (TUInt32 tag = 0; tag < static_cast<TUInt32>(EMemoryTag::NumTags); ++tag)
+	{
+		STagCounters& counters = m_Tags[tag];
+		TUInt64 allocations = counters.allocations.load( memory_order_relaxed );
+		TUInt64 bytes = counters.bytesAllocated.load( memory_order_relaxed );
+		counters.allocationsLastTick = allocations - counters.tickStartAllocations;
+		counters.bytesLastTick = bytes - counters.tickStartBytes;
+		counters.tickStartAllocations = allocations;
+		counters.tickStartBytes = bytes;
+	}
+}
+
+// Set each tag's peak to its current live bytes
+void CMemoryTracker::ResetPeaks()
+{
+	for (TUInt32 tag = 0; tag < static_cast<TUInt32>(EMemoryTag::NumTags); ++tag)
+	{
+		m_Tags[tag].peakBytes.store( m_Tags[tag].liveBytes.load( memory_order_relaxed ), memory_order_relaxed );
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Results
+//-----------------------------------------------------------------------------
+
+SMemoryTagStats CMemoryTracker::GetTagStats( EMemoryTag tag ) const
+{
+	const STagCounters& counters = m_Tags[static_cast<TUInt32>(tag)];
+	SMemoryTagStats stats;
+	stats.liveBytes = counters.liveBytes.load( memory_order_relaxed );
+	stats.peakBytes = counters.peakBytes.load( memory_order_relaxed );
+	stats.allocations = counters.allocations.load( memory_order_relaxed );
+	stats.frees = counters.frees.load( memory_order_relaxed );
+	stats.allocationsLastTick = counters.allocationsLastTick;
+	stats.bytesLastTick = counters.bytesLastTick;
+	return stats;
+}
+
+// Live bytes over all tags
+TInt64 CMemoryTracker::LiveBytes() const
+{
+	TInt64 live = 0;
+	for (TUInt32 tag = 0; tag < static_cast<TUInt32>(EMemoryTag::NumTags); ++tag)
+	{
+		live += m_Tags[tag].liveBytes.load( memory_order_relaxed );
+	}
+	return live;
+}
+
+// Allocations in the last tick over all tags
+TUInt64 CMemoryTracker::AllocationsLastTick() const
+{
+	TUInt64 allocations = 0;
+	for (TUInt32 tag = 0; tag < static_cast<TUInt32>(EMemoryTag::NumTags); ++tag)
+	{
+		allocations += m_Tags[tag].allocationsLastTick;
+	}
+	return allocations;
+}
+
+// One line per tag that has been used, sizes in KB
+string CMemoryTracker::Report() const
+{
+	stringstream report;
+	report << fixed << setprecision( 1 );
+	report << "Memory (" << LiveBytes() / 1024.0 << "KB live)" << endl;
+	report << "  " << left << setw( 18 ) << "Tag" << right << setw( 12 ) << "Live KB" << setw( 12 ) << "Peak KB"
+	       << setw( 10 ) << "Allocs" << setw( 10 ) << "Frees" << setw( 12 ) << "Allocs/tick" << setw( 12 )
+	       << "KB/tick" << endl;
+	for (TUInt32 tag = 0; tag < static_cast<TUInt32>(EMemoryTag::NumTags); ++tag)
+	{
+		SMemoryTagStats stats = GetTagStats( static_cast<EMemoryTag>(tag) );
+		if (stats.allocations == 0)
+		{
+			continue;
+		}
+		report << "  " << left << setw( 18 ) << MemoryTagNames[tag] << right << setw( 12 ) << stats.liveBytes / 1024.0
+		       << setw( 12 ) << stats.peakBytes / 1024.0 << setw( 10 ) << stats.allocations << setw( 10 ) << stats.frees
+		       << setw( 12 ) << stats.allocationsLastTick << setw( 12 ) << stats.bytesLastTick / 1024.0 << endl;
+	}
+	return report.str();
+}
+
+
+//-----------------------------------------------------------------------------
+// Tagged arrays
+//-----------------------------------------------------------------------------
+
+// Allocate memory counted against a tag, with the size and tag in a header before it
+void* TaggedAlloc( size_t bytes, EMemoryTag tag )
+{
+	static_assert(kTaggedHeaderSize >= sizeof(size_t) + sizeof(EMemoryTag), "Tagged header too small");
+	TUInt8* memory = static_cast<TUInt8*>(::operator new( bytes + kTaggedHeaderSize ));
+	*reinterpret_cast<size_t*>(memory) = bytes;
+	*reinterpret_cast<EMemoryTag*>(memory + sizeof(size_t)) = tag;
+	MemoryTracker.Allocated( tag, bytes );
+	return memory + kTaggedHeaderSize;
+}
+
+// Release memory from TaggedAlloc, 0 is ignored
+void TaggedFree( void* memory )
+{
+	if (!memory)
+	{
+		return;
+	}
+	TUInt8* header = static_cast<TUInt8*>(memory) - kTaggedHeaderSize;
+	MemoryTracker.Freed( *reinterpret_cast<EMemoryTag*>(header + sizeof(size_t)), *reinterpret_cast<size_t*>(header) );
+	::operator delete( header );
+}
+
+
+} // namespace gen
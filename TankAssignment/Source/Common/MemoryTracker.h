@@ -0,0 +1,272 @@
+/*******************************************
+	MemoryTracker.h
+
+	Memory used by each subsystem of the game.
+	Allocations are tagged with the subsystem
+	they belong to, and each tag counts its
+	live and peak bytes and how many
+	allocations it makes per tick - so growth
+	in a long run can be put down to the
+	subsystem responsible
+
+	Tagging is done by:
+	- GEN_MEMORY_TAG in a class, for objects
+	  created with new
+	- TaggedNewArray / TaggedDeleteArray, for
+	  arrays
+	- CTaggedAllocator, for STL containers
+	- Allocated / Freed directly, for memory
+	  allocated elsewhere but owned by a
+	  subsystem (e.g. imported mesh geometry)
+********************************************/
+
+#pragma once
+
+#include <string>
+#include <atomic>
+#include <new>
+using namespace std;
+
+#include "Defines.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// Tags
+
+// Subsystems memory is counted against
+enum class EMemoryTag : TUInt32
+{
+	Other,          // Untagged containers, e.g. a CHashTable not given a tag
+	Entities,       // Entity and template objects, and the containers holding them
+	EntityMatrices, // Node matrices of each entity
+	EntityLookUp,   // UID to entity hash table
+	Messages,       // Messages waiting to be fetched
+	Meshes,         // Mesh structures and the CPU copies of their geometry
+	Waypoints,      // Team waypoint lists
+	NumTags
+};
+
+// Name of a tag in reports
+const char* MemoryTagName( EMemoryTag tag );
+
+
+/////////////////////////////////////
+// Tracker
+
+// Counts for one tag
+struct SMemoryTagStats
+{
+	TInt64  liveBytes;
+	TInt64  peakBytes;
+	TUInt64 allocations;         // Over the whole run
+	TUInt64 frees;
+	TUInt64 allocationsLastTick; // In the last tick ended by EndTick
+	TUInt64 bytesLastTick;       // Allocated in the last tick
+};
+
+class CMemoryTracker
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// No constructor code - the tracker is zeroed before any constructors run, so other globals
+	// may allocate while they are constructed
+	CMemoryTracker() = default;
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CMemoryTracker( const CMemoryTracker& );
+	CMemoryTracker& operator=( const CMemoryTracker& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Counting
+
+	// Count an allocation or free of the given size against a tag. Safe on any thread
+	void Allocated( EMemoryTag tag, size_t bytes )
+	{
+		STagCounters& counters = m_Tags[static_cast<TUInt32>(tag)];
+		TInt64 live = counters.liveBytes.fetch_add( static_cast<TInt64>(bytes), memory_order_relaxed ) + bytes;
+		counters.allocations.fetch_add( 1, memory_order_relaxed );
+		counters.bytesAllocated.fetch_add( bytes, memory_order_relaxed );
+		TInt64 peak = counters.peakBytes.load( memory_order_relaxed );
+		while (live > peak && !counters.peakBytes.compare_exchange_weak( peak, live, memory_order_relaxed ))
+		{
+		}
+	}
+	void Freed( EMemoryTag tag, size_t bytes )
+	{
+		STagCounters& counters = m_Tags[static_cast<TUInt32>(tag)];
+		counters.liveBytes.fetch_sub( static_cast<TInt64>(bytes), memory_order_relaxed );
+		counters.frees.fetch_add( 1, memory_order_relaxed );
+	}
+
+	// End of a game tick, the per-tick counts are for the tick just ended. Main thread only
+	void EndTick();
+
+	// Set each tag's peak to its current live bytes, e.g. to find the peak of one part of a run
+	void ResetPeaks();
+
+
+	/////////////////////////////////////
+	// Results
+
+	SMemoryTagStats GetTagStats( EMemoryTag tag ) const;
+
+	// Live bytes and allocations in the last tick over all tags
+	TInt64 LiveBytes() const;
+	TUInt64 AllocationsLastTick() const;
+
+	// One line per tag that has been used, with its live and peak size, total allocations and frees,
+	// and allocations in the last tick
+	string Report() const;
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	struct STagCounters
+	{
+		atomic<TInt64>  liveBytes;
+		atomic<TInt64>  peakBytes;
+		atomic<TUInt64> allocations;
+		atomic<TUInt64> frees;
+		atomic<TUInt64> bytesAllocated;
+
+		// Totals when the last tick ended, and the allocations made in that tick
+		TUInt64         tickStartAllocations;
+		TUInt64         tickStartBytes;
+		TUInt64         allocationsLastTick;
+		TUInt64         bytesLastTick;
+	};
+
+	STagCounters m_Tags[static_cast<TUInt32>(EMemoryTag::NumTags)];
+};
+
+// Single memory tracker for the program
+extern CMemoryTracker MemoryTracker;
+
+
+/////////////////////////////////////
+// Tagged objects
+
+// Count objects of a class (and classes derived from it) created with new against the given tag.
+// Place in the class definition. The class must have a virtual destructor if objects are deleted
+// through a base pointer, so the size freed is that of the whole object
+#define GEN_MEMORY_TAG( tag ) \
+	static void* operator new( size_t bytes ) \
+	{ \
+		void* memory = ::operator new( bytes ); \
+		gen::MemoryTracker.Allocated( tag, bytes ); \
+		return memory; \
+	} \
+	static void operator delete( void* memory, size_t bytes ) \
+	{ \
+		gen::MemoryTracker.Freed( tag, bytes ); \
+		::operator delete( memory ); \
+	}
+
+
+/////////////////////////////////////
+// Tagged arrays
+
+// Allocate memory counted against a tag. The size and tag are kept in a header before the memory
+// returned, so TaggedFree needs only the pointer. Throws bad_alloc on failure, like new
+void* TaggedAlloc( size_t bytes, EMemoryTag tag );
+void TaggedFree( void* memory ); // 0 is ignored
+
+// Size of the header before memory from TaggedAlloc - keeps the alignment of the allocation
+const size_t kTaggedHeaderSize = 16;
+
+// Number of bytes requested from TaggedAlloc for the given memory
+inline size_t TaggedSize( const void* memory )
+{
+	return *reinterpret_cast<const size_t*>(static_cast<const TUInt8*>(memory) - kTaggedHeaderSize);
+}
+
+// Create an array of value initialised objects (zeroed if they have no constructor) counted against
+// a tag, the tagged version of new T[count](). Release with TaggedDeleteArray
+template <class T>
+T* TaggedNewArray( EMemoryTag tag, size_t count )
+{
+	T* array = static_cast<T*>(TaggedAlloc( count * sizeof(T), tag ));
+	for (size_t element = 0; element < count; ++element)
+	{
+		new (&array[element]) T();
+	}
+	return array;
+}
+
+// Destroy an array from TaggedNewArray, the tagged version of delete[]. 0 is ignored
+template <class T>
+void TaggedDeleteArray( T* array )
+{
+	if (!array)
+	{
+		return;
+	}
+	size_t count = TaggedSize( array ) / sizeof(T);
+	for (size_t element = count; element > 0; --element)
+	{
+		array[element - 1].~T();
+	}
+	TaggedFree( array );
+}
+
+
+/////////////////////////////////////
+// Tagged STL containers
+
+// Allocator for STL containers that counts what they allocate against a tag, e.g.
+// multimap<K, V, less<K>, CTaggedAllocator<pair<const K, V>, EMemoryTag::Messages>>
+template <class T, EMemoryTag Tag>
+class CTaggedAllocator
+{
+public:
+	typedef T value_type;
+
+	template <class U>
+	struct rebind
+	{
+		typedef CTaggedAllocator<U, Tag> other;
+	};
+
+	CTaggedAllocator() {}
+	template <class U>
+	CTaggedAllocator( const CTaggedAllocator<U, Tag>& ) {}
+
+	T* allocate( size_t count )
+	{
+		T* memory = static_cast<T*>(::operator new( count * sizeof(T) ));
+		MemoryTracker.Allocated( Tag, count * sizeof(T) );
+		return memory;
+	}
+
+	void deallocate( T* memory, size_t count )
+	{
+		MemoryTracker.Freed( Tag, count * sizeof(T) );
+		::operator delete( memory );
+	}
+};
+
+// All allocators with a tag share the same (global) counts, so any can free what another allocated
+template <class T, class U, EMemoryTag Tag>
+bool operator==( const CTaggedAllocator<T, Tag>&, const CTaggedAllocator<U, Tag>& )
+{
+	return true;
+}
+template <class T, class U, EMemoryTag Tag>
+bool operator!=( const CTaggedAllocator<T, Tag>&, const CTaggedAllocator<U, Tag>& )
+{
+	return false;
+}
+
+
+} // namespace gen
@@ -0,0 +1,342 @@
+/*******************************************
+	Profiler.cpp
+
+	Scoped timing zones, see header
+********************************************/
+
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "Profiler.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// Global variables
+
+// Define a single profiler for the program
+CProfiler Profiler;
+
+// Recording of the calling thread and its name, see CProfiler::CurrentThread
+static thread_local SProfileThread* CurrentProfileThread = 0;
+static thread_local const char*     CurrentThreadName = 0;
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+// Construct a profiler that is not recording
+CProfiler::CProfiler()
+{
+	m_Recording = false;
+	m_Clears = 0;
+	m_StartTicks = Ticks();
+}
+
+// Release every thread's recording. No zones may be open
+CProfiler::~CProfiler()
+{
+	for (TUInt32 thread = 0; thread < m_Threads.size(); ++thread)
+	{
+		delete m_Threads[thread];
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Recording
+//-----------------------------------------------------------------------------
+
+// Name the calling thread in exported traces, a string literal
+void CProfiler::SetThreadName( const char* name )
+{
+	CurrentThreadName = name;
+	if (CurrentProfileThread)
+	{
+		lock_guard<mutex> lock( m_ThreadsMutex );
+		CurrentProfileThread->name = name;
+	}
+}
+
+// Discard the zones recorded so far on all threads. Each thread's writer is unaffected, readers
+// just ignore the events before the point it had reached. Totals are zeroed by each thread when it
+// next ends a zone, until then readers ignore them
+void CProfiler::Clear()
+{
+	lock_guard<mutex> lock( m_ThreadsMutex );
+	for (TUInt32 thread = 0; thread < m_Threads.size(); ++thread)
+	{
+		m_Threads[thread]->clearedAt = m_Threads[thread]->written.load( memory_order_acquire );
+	}
+	m_Clears.fetch_add( 1, memory_order_relaxed );
+}
+
+// Recording of the calling thread, created when it first records a zone. Only threads that record
+// pay for a ring
+SProfileThread* CProfiler::CurrentThread()
+{
+	if (!CurrentProfileThread)
+	{
+		SProfileThread* thread = new SProfileThread;
+		thread->written = 0;
+		thread->clearedAt = 0;
+		thread->depth = 0;
+		thread->childTime[0] = 0;
+		memset( thread->totals, 0, sizeof(thread->totals) );
+		thread->totalsClears = m_Clears.load( memory_order_relaxed );
+
+		lock_guard<mutex> lock( m_ThreadsMutex );
+		thread->id = static_cast<TUInt32>(m_Threads.size()) + 1;
+		if (CurrentThreadName)
+		{
+			thread->name = CurrentThreadName;
+		}
+		else
+		{
+			thread->name = "Thread " + to_string( thread->id );
+		}
+		m_Threads.push_back( thread );
+		CurrentProfileThread = thread;
+	}
+	return CurrentProfileThread;
+}
+
+// Open a zone on the calling thread, returning the thread's recording and the zone's depth. The
+// depth is counted past kMaxProfileDepth so it unwinds correctly, but deeper zones are not recorded
+SProfileThread* CProfiler::BeginZone( TUInt32* depth )
+{
+	SProfileThread* thread = CurrentThread();
+	*depth = ++thread->depth;
+	if (*depth <= kMaxProfileDepth)
+	{
+		thread->childTime[*depth] = 0;
+	}
+	return thread;
+}
+
+// Close a zone opened by BeginZone, recording it in the thread's ring. The event is written before
+// the count is published, so a reader never sees a half-written event as new
+void CProfiler::EndZone( SProfileThread* thread, TUInt32 depth, const char* name, TInt64 start )
+{
+	thread->depth = depth - 1;
+	if (depth > kMaxProfileDepth)
+	{
+		return;
+	}
+	TInt64 duration = Ticks() - start;
+	thread->childTime[depth - 1] += duration;
+
+	TUInt64 written = thread->written.load( memory_order_relaxed );
+	SProfileEvent& event = thread->events[written & (kProfileRingSize - 1)];
+	event.name = name;
+	event.start = start;
+	event.duration = duration;
+	event.selfTime = duration - thread->childTime[depth];
+	thread->written.store( written + 1, memory_order_release );
+
+	// Add to the total for this name. Names are string literals, so the same zone always has the
+	// same pointer and the look-up rarely probes more than once
+	TUInt32 clears = Profiler.m_Clears.load( memory_order_relaxed );
+	if (thread->totalsClears != clears)
+	{
+		memset( thread->totals, 0, sizeof(thread->totals) );
+		thread->totalsClears = clears;
+	}
+	TUInt32 slot = static_cast<TUInt32>(reinterpret_cast<uintptr_t>(name) >> 2);
+	for (TUInt32 probe = 0; probe < kMaxProfileZoneNames; ++probe, ++slot)
+	{
+		SProfileZoneTotal& total = thread->totals[slot & (kMaxProfileZoneNames - 1)];
+		if (!total.name)
+		{
+			total.name = name;
+		}
+		if (total.name == name)
+		{
+			++total.calls;
+			total.totalTime += duration;
+			total.selfTime += event.selfTime;
+			total.maxTime = max( total.maxTime, duration );
+			break;
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Results
+//-----------------------------------------------------------------------------
+
+// Copy every thread's recorded events, oldest first. Threads carry on recording while their ring
+// is copied, so the count is read again afterwards and any events the writer may have reached in
+// the meantime are dropped from the copy
+vector<CProfiler::SThreadCapture> CProfiler::Capture() const
+{
+	lock_guard<mutex> lock( m_ThreadsMutex );
+	vector<SThreadCapture> captures( m_Threads.size() );
+	for (TUInt32 thread = 0; thread < m_Threads.size(); ++thread)
+	{
+		const SProfileThread& recording = *m_Threads[thread];
+		SThreadCapture& capture = captures[thread];
+		capture.id = recording.id;
+		capture.name = recording.name;
+
+		TUInt64 last = recording.written.load( memory_order_acquire );
+		TUInt64 first = max( recording.clearedAt, (last > kProfileRingSize) ? last - kProfileRingSize : 0 );
+		capture.events.reserve( static_cast<size_t>(last - first) );
+		for (TUInt64 event = first; event < last; ++event)
+		{
+			capture.events.push_back( recording.events[event & (kProfileRingSize - 1)] );
+		}
+
+		// The writer may be part way through the event after the count just read, which overwrites
+		// the event kProfileRingSize before it
+		TUInt64 reached = recording.written.load( memory_order_acquire ) + 1;
+		if (reached > first + kProfileRingSize)
+		{
+			TUInt64 overwritten = min( reached - kProfileRingSize - first, last - first );
+			capture.events.erase( capture.events.begin(), capture.events.begin() + static_cast<size_t>(overwritten) );
+		}
+	}
+	return captures;
+}
+
+// Each zone name recorded since the last Clear and its times, most self time first. Threads whose
+// totals predate the last Clear have recorded nothing since
+vector<SProfileZoneStats> CProfiler::GetZoneStats() const
+{
+	lock_guard<mutex> lock( m_ThreadsMutex );
+	TUInt32 clears = m_Clears.load( memory_order_relaxed );
+
+	// Names are string literals, but the same name may be at different addresses in different files
+	map<string, SProfileZoneStats> zones;
+	for (TUInt32 thread = 0; thread < m_Threads.size(); ++thread)
+	{
+		const SProfileThread& recording = *m_Threads[thread];
+		if (recording.totalsClears != clears)
+		{
+			continue;
+		}
+		for (TUInt32 slot = 0; slot < kMaxProfileZoneNames; ++slot)
+		{
+			const SProfileZoneTotal& total = recording.totals[slot];
+			if (!total.name || total.calls == 0)
+			{
+				continue;
+			}
+			SProfileZoneStats& zone = zones[total.name];
+			if (zone.name.empty())
+			{
+				zone.name = total.name;
+				zone.calls = 0;
+				zone.totalTime = 0;
+				zone.selfTime = 0;
+				zone.maxTime = 0;
+			}
+			zone.calls += total.calls;
+			zone.totalTime += total.totalTime;
+			zone.selfTime += total.selfTime;
+			zone.maxTime = max( zone.maxTime, total.maxTime );
+		}
+	}
+
+	vector<SProfileZoneStats> stats;
+	for (auto zone = zones.begin(); zone != zones.end(); ++zone)
+	{
+		stats.push_back( zone->second );
+	}
+	sort( stats.begin(), stats.end(),
+	      []( const SProfileZoneStats& a, const SProfileZoneStats& b ) { return a.selfTime > b.selfTime; } );
+	return stats;
+}
+
+// Table of the zones with the most self time, one per line
+string CProfiler::SummaryReport( TUInt32 maxZones /*= 20*/ ) const
+{
+	vector<SProfileZoneStats> stats = GetZoneStats();
+	const TFloat64 msPerTick = 1000.0 / TicksPerSecond();
+
+	stringstream report;
+	report << fixed << setprecision( 3 );
+	report << "Profile (" << stats.size() << " zones)" << endl;
+	report << "  " << left << setw( 28 ) << "Zone" << right << setw( 9 ) << "Calls" << setw( 12 ) << "Total ms"
+	       << setw( 12 ) << "Self ms" << setw( 12 ) << "Mean ms" << setw( 12 ) << "Max ms" << endl;
+	for (TUInt32 zone = 0; zone < stats.size() && zone < maxZones; ++zone)
+	{
+		const SProfileZoneStats& z = stats[zone];
+		report << "  " << left << setw( 28 ) << z.name.substr( 0, 27 ) << right << setw( 9 ) << z.calls
+		       << setw( 12 ) << z.totalTime * msPerTick << setw( 12 ) << z.selfTime * msPerTick
+		       << setw( 12 ) << z.totalTime * msPerTick / z.calls << setw( 12 ) << z.maxTime * msPerTick << endl;
+	}
+	return report.str();
+}
+
+
+// Write a string as a JSON string, with quotes
+static void WriteJSONString( ostream& out, const string& text )
+{
+	out << '"';
+	for (TUInt32 c = 0; c < text.length(); ++c)
+	{
+		char ch = text[c];
+		if (ch == '"' || ch == '\\')
+		{
+			out << '\\' << ch;
+		}
+		else if (static_cast<unsigned char>(ch) < 0x20)
+		{
+			out << "\\u" << hex << setw( 4 ) << setfill( '0' ) << static_cast<int>(ch) << dec << setfill( ' ' );
+		}
+		else
+		{
+			out << ch;
+		}
+	}
+	out << '"';
+}
+
+// Write the recorded zones of all threads to a Chrome trace event (JSON) file. Zones are complete
+// ("X") events in microseconds from the creation of the profiler, threads are named with metadata
+// ("M") events. Returns false if the file cannot be written
+bool CProfiler::WriteChromeTrace( const string& fileName ) const
+{
+	vector<SThreadCapture> captures = Capture();
+	const TFloat64 usPerTick = 1000000.0 / TicksPerSecond();
+
+	ofstream file( fileName.c_str(), ios::trunc );
+	if (!file)
+	{
+		return false;
+	}
+	file << fixed << setprecision( 3 );
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first = true;
+	for (TUInt32 thread = 0; thread < captures.size(); ++thread)
+	{
+		const SThreadCapture& capture = captures[thread];
+		file << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"pid\":1,\"tid\":" << capture.id
+		     << ",\"name\":\"thread_name\",\"args\":{\"name\":";
+		WriteJSONString( file, capture.name );
+		file << "}}";
+		first = false;
+
+		for (TUInt32 event = 0; event < capture.events.size(); ++event)
+		{
+			const SProfileEvent& e = capture.events[event];
+			file << ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":" << capture.id << ",\"name\":";
+			WriteJSONString( file, e.name );
+			file << ",\"ts\":" << (e.start - m_StartTicks) * usPerTick << ",\"dur\":" << e.duration * usPerTick << "}";
+		}
+	}
+	file << "\n]}\n";
+	return static_cast<bool>(file);
+}
+
+
+} // namespace gen
@@ -0,0 +1,290 @@
+/*******************************************
+	Profiler.h
+
+	Scoped timing zones for the hot paths of
+	the game. Each thread records the zones it
+	completes in a ring buffer of its own, with
+	no locks, so the last few seconds of every
+	thread are always available, and keeps a
+	running total for each zone name. The rings
+	are exported as a Chrome trace
+	(chrome://tracing or ui.perfetto.dev), the
+	totals are summarised as a table of the most
+	expensive zones
+
+	Zones are only compiled in when GEN_PROFILE
+	is defined, otherwise the macros below are
+	empty and cost nothing. Zones are timed with
+	the steady clock, or with the cheaper TSC
+	clock if GEN_PROFILE_TSC is also defined
+	(only for CPUs with an invariant TSC, see
+	Clock.h)
+********************************************/
+
+#pragma once
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+using namespace std;
+
+#include "Defines.h"
+#include "Clock.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// Zone macros
+
+// Time from here to the end of the enclosing scope as a zone with the given name, which must be a
+// string literal (only the pointer is stored)
+#define GEN_PROFILE_CONCAT_INNER( a, b ) a##b
+#define GEN_PROFILE_CONCAT( a, b ) GEN_PROFILE_CONCAT_INNER( a, b )
+#ifdef GEN_PROFILE
+	#define GEN_PROFILE_ZONE( name ) gen::CProfileZone GEN_PROFILE_CONCAT( profileZone, __LINE__ )( name )
+	#define GEN_PROFILE_THREAD( name ) gen::Profiler.SetThreadName( name )
+#else
+	#define GEN_PROFILE_ZONE( name )
+	#define GEN_PROFILE_THREAD( name )
+#endif
+
+
+/////////////////////////////////////
+// Recorded data
+
+// Zones each thread keeps - the oldest are overwritten. At a few hundred zones per frame this is
+// several seconds of the main thread. Must be a power of 2
+const TUInt32 kProfileRingSize = 32768;
+
+// Deepest nesting of zones recorded. Zones nested deeper are not recorded, their time counts as self
+// time of the deepest zone around them
+const TUInt32 kMaxProfileDepth = 32;
+
+// Different zone names each thread keeps totals for, zones with names beyond this are only in the
+// ring. Must be a power of 2
+const TUInt32 kMaxProfileZoneNames = 256;
+
+// A completed zone. Times are in profiler ticks, see CProfiler::TicksPerSecond
+struct SProfileEvent
+{
+	const char* name;
+	TInt64      start;
+	TInt64      duration;
+	TInt64      selfTime; // Duration less that of the zones inside it
+};
+
+// Times of every zone with one name on one thread since the profiler was last cleared
+struct SProfileZoneTotal
+{
+	const char* name; // 0 for an unused entry
+	TUInt64     calls;
+	TInt64      totalTime;
+	TInt64      selfTime;
+	TInt64      maxTime;
+};
+
+// Zones recorded by one thread. Only that thread writes to it, readers take a copy of the ring
+// and then discard any events that were overwritten while copying
+struct SProfileThread
+{
+	SProfileEvent   events[kProfileRingSize];
+	atomic<TUInt64> written;    // Number of events ever written, the next goes at written % kProfileRingSize
+	TUInt64         clearedAt;  // Events before this were discarded by CProfiler::Clear
+	TUInt32         id;         // Order threads were first seen, 1 for the first
+	string          name;
+
+	// Totals by zone name, open addressed on the name's pointer. Unlike the ring they cover the
+	// whole recording. Zeroed by the thread itself when it sees the profiler has been cleared
+	SProfileZoneTotal totals[kMaxProfileZoneNames];
+	TUInt32           totalsClears; // CProfiler clear count when the totals were last zeroed
+
+	// Zones currently open on this thread (including any too deep to record) and the time spent in
+	// zones inside each recorded one
+	TUInt32         depth;
+	TInt64          childTime[kMaxProfileDepth + 1];
+};
+
+// Zone with the given name summed over a recording
+struct SProfileZoneStats
+{
+	string  name;
+	TUInt64 calls;
+	TInt64  totalTime;
+	TInt64  selfTime;
+	TInt64  maxTime;
+};
+
+
+/////////////////////////////////////
+// Profiler
+
+class CProfiler
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Construct a profiler that is not recording
+	CProfiler();
+
+	// Release every thread's recording. No zones may be open
+	~CProfiler();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CProfiler( const CProfiler& );
+	CProfiler& operator=( const CProfiler& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Recording
+
+	// Zones are only recorded while recording is on. Zones already open when it is turned off
+	// are still recorded when they end
+	void SetRecording( bool recording )
+	{
+		m_Recording.store( recording, memory_order_relaxed );
+	}
+	bool IsRecording() const
+	{
+		return m_Recording.load( memory_order_relaxed );
+	}
+
+	// Name the calling thread in exported traces, a string literal. Threads are named "Thread n"
+	// otherwise
+	void SetThreadName( const char* name );
+
+	// Discard the zones recorded so far on all threads. Safe while other threads record
+	void Clear();
+
+
+	/////////////////////////////////////
+	// Timing
+
+	// Current time in profiler ticks
+	static TInt64 Ticks()
+	{
+#ifdef GEN_PROFILE_TSC
+		return TscTicks();
+#else
+		return SteadyTicks();
+#endif
+	}
+
+	static TFloat64 TicksPerSecond()
+	{
+#ifdef GEN_PROFILE_TSC
+		return TscTicksPerSecond();
+#else
+		return SteadyTicksPerSecond();
+#endif
+	}
+
+
+	/////////////////////////////////////
+	// Results
+
+	// Each zone name recorded since the last Clear and its times, most self time first. Taken from
+	// each thread's totals, so it covers zones long gone from the rings. Totals read while threads
+	// are recording may be a zone or two behind
+	vector<SProfileZoneStats> GetZoneStats() const;
+
+	// Table of the zones with the most self time, one per line, with their call count, total,
+	// self, mean and longest times
+	string SummaryReport( TUInt32 maxZones = 20 ) const;
+
+	// Write the recorded zones of all threads to a Chrome trace event (JSON) file. Returns false
+	// if the file cannot be written
+	bool WriteChromeTrace( const string& fileName ) const;
+
+
+	/////////////////////////////////////
+	// Zone recording (used by CProfileZone)
+
+	// Open a zone on the calling thread, returning the thread's recording and the zone's depth
+	SProfileThread* BeginZone( TUInt32* depth );
+
+	// Close a zone opened by BeginZone, recording it
+	static void EndZone( SProfileThread* thread, TUInt32 depth, const char* name, TInt64 start );
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// A thread's events copied from its ring
+	struct SThreadCapture
+	{
+		TUInt32               id;
+		string                name;
+		vector<SProfileEvent> events;
+	};
+
+	// Recording of the calling thread, created when it first records a zone
+	SProfileThread* CurrentThread();
+
+	// Copy every thread's recorded events, oldest first
+	vector<SThreadCapture> Capture() const;
+
+
+	atomic<bool>            m_Recording;
+	atomic<TUInt32>         m_Clears; // Number of calls to Clear, see SProfileThread::totalsClears
+
+	// All threads that have recorded zones. Threads are only added (under the mutex), and their
+	// recordings are kept after they exit
+	mutable mutex           m_ThreadsMutex;
+	vector<SProfileThread*> m_Threads;
+
+	// Time the profiler was created, exported times are relative to it
+	TInt64                  m_StartTicks;
+};
+
+// Single profiler for the program
+extern CProfiler Profiler;
+
+
+/////////////////////////////////////
+// Scoped zone
+
+// Records the time from its construction to its destruction as a zone, if the profiler is
+// recording when it is constructed. Use through GEN_PROFILE_ZONE
+class CProfileZone
+{
+public:
+	CProfileZone( const char* name )
+	{
+		m_Thread = 0;
+		if (Profiler.IsRecording())
+		{
+			m_Name = name;
+			m_Thread = Profiler.BeginZone( &m_Depth );
+			m_Start = CProfiler::Ticks();
+		}
+	}
+
+	~CProfileZone()
+	{
+		if (m_Thread)
+		{
+			CProfiler::EndZone( m_Thread, m_Depth, m_Name, m_Start );
+		}
+	}
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CProfileZone( const CProfileZone& );
+	CProfileZone& operator=( const CProfileZone& );
+
+	SProfileThread* m_Thread; // 0 if not recorded
+	const char*     m_Name;
+	TUInt32         m_Depth;
+	TInt64          m_Start;
+};
+
+
+} // namespace gen
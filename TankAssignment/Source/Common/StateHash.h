@@ -0,0 +1,74 @@
+/*******************************************
+	StateHash.h
+
+	64-bit hash of simulation state, to check
+	that a change to the game keeps its
+	behaviour exactly - two runs with the same
+	input give the same hash at every tick only
+	if every value hashed was bit-for-bit the
+	same. Floats are hashed by their bits, so
+	hashes only match between builds that do
+	their floating point the same way (same
+	compiler and settings)
+********************************************/
+
+#pragma once
+
+#include <string>
+using namespace std;
+
+#include "Defines.h"
+#include "Fnv1aHash.h"
+
+namespace gen
+{
+
+// Accumulates a 64-bit FNV-1a hash of the values added to it, in the order they are added
+class CStateHash
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	CStateHash()
+	{
+		m_Hash = kFnv1aOffsetBasis;
+	}
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Add the bytes of a value without pointers or padding (numbers, enums, vectors, matrices)
+	template <class T>
+	void Add( const T& value )
+	{
+		AddBytes( &value, sizeof(T) );
+	}
+
+	// Add the characters of a string and its length, so "ab"+"c" and "a"+"bc" differ
+	void Add( const string& value )
+	{
+		Add( static_cast<TUInt32>(value.length()) );
+		AddBytes( value.data(), value.length() );
+	}
+
+	void AddBytes( const void* data, size_t numBytes )
+	{
+		m_Hash = Fnv1aHash( m_Hash, data, numBytes );
+	}
+
+	TUInt64 Value() const
+	{
+		return m_Hash;
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+	TUInt64 m_Hash;
+};
+
+
+} // namespace gen
@@ -0,0 +1,35 @@
+/*******************************************
+	Types.h
+
+	Fixed size types, the same on every
+	compiler and platform. Code that only
+	needs these (file formats, parsers) can
+	include this rather than Defines.h, which
+	brings in Windows and DirectX
+********************************************/
+
+#ifndef GEN_TYPES_H_INCLUDED
+#define GEN_TYPES_H_INCLUDED
+
+#include <cstdint>
+
+namespace gen
+{
+
+typedef int8_t   TInt8;
+typedef int16_t  TInt16;
+typedef int32_t  TInt32;
+typedef int64_t  TInt64;
+
+typedef uint8_t  TUInt8;
+typedef uint16_t TUInt16;
+typedef uint32_t TUInt32;
+typedef uint64_t TUInt64;
+
+typedef float    TFloat32;
+typedef double   TFloat64;
+
+
+} // namespace gen
+
+#endif // GEN_TYPES_H_INCLUDED
@@ -11,7 +11,13 @@
 		V1.0    Created 04/08/05 - LN
 **************************************************************************************************/
 
+#include <sys/stat.h>
+#include <cstdio>
+#include <cctype>
+#include <vector>
+
 #include "Utility.h"
+#include "Fnv1aHash.h"
 
 namespace gen
 {
@@ -57,4 +63,95 @@ string LastDelimitedSubstr
 }
 
 
+/*------------------------------------------------------------------------------------------------
+	File utilities
+ ------------------------------------------------------------------------------------------------*/
+
+// Return a file path in a standard form so different ways of writing the same path compare equal:
+// lower case, backslash separators with no repeats, and "." / "dir\.." parts removed
+string NormalisePath
+(
+	const string& sPath
+)
+{
+	// Split into parts, dropping empty and "." parts and resolving ".." against the previous part
+	vector<string> parts;
+	string part;
+	for (string::size_type i = 0; i <= sPath.length(); ++i)
+	{
+		if (i == sPath.length() || sPath[i] == '\\' || sPath[i] == '/')
+		{
+			if (part == ".." && !parts.empty() && parts.back() != "..")
+			{
+				parts.pop_back();
+			}
+			else if (!part.empty() && part != ".")
+			{
+				parts.push_back( part );
+			}
+			part.clear();
+		}
+		else
+		{
+			part += static_cast<char>(tolower( static_cast<unsigned char>(sPath[i]) ));
+		}
+	}
+
+	string normalised = (!sPath.empty() && (sPath[0] == '\\' || sPath[0] == '/')) ? "\\" : "";
+	for (TUInt32 i = 0; i < parts.size(); ++i)
+	{
+		if (i > 0) normalised += '\\';
+		normalised += parts[i];
+	}
+	return normalised;
+}
+
+// Get the size and last modification time of a file, which together identify a version of the
+// file for checking if data derived from it is out of date. Returns false if the file is missing
+bool GetFileStamp
+(
+	const string& sFileName,
+	TUInt64*      pSize,
+	TUInt64*      pModifiedTime
+)
+{
+	struct stat fileInfo;
+	if (stat( sFileName.c_str(), &fileInfo ) != 0)
+	{
+		return false;
+	}
+	*pSize = static_cast<TUInt64>(fileInfo.st_size);
+	*pModifiedTime = static_cast<TUInt64>(fileInfo.st_mtime);
+	return true;
+}
+
+// Get a 64-bit hash (FNV-1a) of the whole contents of a file, to detect identical files stored
+// under different names. Returns false if the file cannot be read
+bool GetFileHash
+(
+	const string& sFileName,
+	TUInt64*      pHash
+)
+{
+	FILE* file = fopen( sFileName.c_str(), "rb" );
+	if (!file)
+	{
+		return false;
+	}
+
+	TUInt64 hash = kFnv1aOffsetBasis;
+	TUInt8 buffer[16384];
+	size_t bytesRead;
+	while ((bytesRead = fread( buffer, 1, sizeof(buffer), file )) > 0)
+	{
+		hash = Fnv1aHash( hash, buffer, bytesRead );
+	}
+	bool readOK = !ferror( file );
+	fclose( file );
+
+	*pHash = hash;
+	return readOK;
+}
+
+
 } // namespace gen
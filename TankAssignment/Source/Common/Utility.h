@@ -98,6 +98,35 @@ string LastDelimitedSubstr
 );
 
 
+/*------------------------------------------------------------------------------------------------
+	File utilities
+ ------------------------------------------------------------------------------------------------*/
+
+// Return a file path in a standard form so different ways of writing the same path compare equal:
+// lower case, backslash separators with no repeats, and "." / "dir\.." parts removed
+string NormalisePath
+(
+	const string& sPath
+);
+
+// Get the size and last modification time of a file, which together identify a version of the
+// file for checking if data derived from it is out of date. Returns false if the file is missing
+bool GetFileStamp
+(
+	const string& sFileName,
+	TUInt64*      pSize,
+	TUInt64*      pModifiedTime
+);
+
+// Get a 64-bit hash (FNV-1a) of the whole contents of a file, to detect identical files stored
+// under different names. Returns false if the file cannot be read
+bool GetFileHash
+(
+	const string& sFileName,
+	TUInt64*      pHash
+);
+
+
 } // namespace gen
 
 #endif // GEN_UTILITY_H_INCLUDED
@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////
+//  CParseGoldenRuns.cpp
+//  A class to read golden runs (see GoldenRuns.h) from
+//  an XML file
+///////////////////////////////////////////////////////////
+
+#include <cstdlib>
+
+#include "CParseGoldenRuns.h"
+
+namespace gen
+{
+
+/*---------------------------------------------------------------------------------------------
+	Constructors / Destructors
+---------------------------------------------------------------------------------------------*/
+
+CParseGoldenRuns::CParseGoldenRuns()
+{
+	m_Runs = 0;
+	m_InRun = false;
+}
+
+
+/*---------------------------------------------------------------------------------------------
+	Loading
+---------------------------------------------------------------------------------------------*/
+
+// Read all the runs in the given file, replacing the contents of the runs vector
+bool CParseGoldenRuns::LoadRuns( const string& fileName, vector<SGoldenRun>* runs, string* error /*= 0*/ )
+{
+	runs->clear();
+	m_Runs = runs;
+	m_InRun = false;
+	m_Error = "";
+
+	bool parsed = ParseFile( fileName );
+	if (!parsed && m_Error.empty())
+	{
+		m_Error = "cannot read or parse " + fileName;
+	}
+	m_Runs = 0;
+
+	if (!m_Error.empty())
+	{
+		if (error)  *error = m_Error;
+		return false;
+	}
+	return true;
+}
+
+
+/*---------------------------------------------------------------------------------------------
+	Callback Functions
+---------------------------------------------------------------------------------------------*/
+
+// Callback function called when the parser meets the start of a new element (the opening tag)
+void CParseGoldenRuns::StartElt( const string& eltName, SAttribute* attrs )
+{
+	if (eltName == "Run")
+	{
+		// New run with the defaults described in the header
+		SGoldenRun run;
+		run.name = GetAttribute( attrs, "Name" );
+		run.numTanks = GetAttributeInt( attrs, "Tanks", 8 );
+		run.numTeams = GetAttributeInt( attrs, "Teams", 2 );
+		run.seed = GetAttributeInt( attrs, "Seed", 1 );
+		run.updateTime = GetAttributeFloat( attrs, "UpdateTime", 1.0f / 60.0f );
+		run.numTicks = GetAttributeInt( attrs, "Ticks", 1200 );
+		run.checkpointTicks = GetAttributeInt( attrs, "CheckpointTicks", 100 );
+		run.maxSlowdown = GetAttributeFloat( attrs, "MaxSlowdown", 10.0f );
+		if (run.numTicks == 0 && m_Error.empty())
+		{
+			m_Error = "run '" + run.name + "' has no ticks";
+		}
+		m_Runs->push_back( run );
+		m_InRun = true;
+		return;
+	}
+	if (!m_InRun)
+	{
+		return;
+	}
+
+	// Parts of the current run
+	SGoldenRun& run = m_Runs->back();
+	if (eltName == "Checkpoint")
+	{
+		SGoldenCheckpoint checkpoint;
+		checkpoint.tick = GetAttributeInt( attrs, "Tick" );
+		string hash = GetAttribute( attrs, "Hash" );
+		char* hashEnd;
+		checkpoint.hash = strtoull( hash.c_str(), &hashEnd, 16 );
+		if ((hash.empty() || *hashEnd != '\0') && m_Error.empty())
+		{
+			m_Error = "run '" + run.name + "' has checkpoint hash '" + hash + "' that is not hex";
+		}
+		run.checkpoints.push_back( checkpoint );
+	}
+	else if (eltName == "Phase")
+	{
+		SGoldenPhase phase;
+		phase.name = GetAttribute( attrs, "Name" );
+		phase.ms = GetAttributeFloat( attrs, "Ms" );
+		run.phases.push_back( phase );
+	}
+}
+
+// Callback function called when the parser meets the end of an element (the closing tag)
+void CParseGoldenRuns::EndElt( const string& eltName )
+{
+	if (eltName == "Run")
+	{
+		m_InRun = false;
+	}
+}
+
+
+} // namespace gen
@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////
+//  CParseGoldenRuns.h
+//  A class to read golden runs (see GoldenRuns.h) from
+//  an XML file
+///////////////////////////////////////////////////////////
+
+#ifndef GEN_C_PARSE_GOLDEN_RUNS_H_INCLUDED
+#define GEN_C_PARSE_GOLDEN_RUNS_H_INCLUDED
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "../Common/Defines.h"
+#include "GoldenRuns.h"
+#include "CParseXML.h"
+
+namespace gen
+{
+
+/*---------------------------------------------------------------------------------------------
+	CParseGoldenRuns class
+---------------------------------------------------------------------------------------------*/
+// A XML parser to read golden runs, in this form (any attribute left out takes the value shown):
+//
+//	<GoldenRuns>
+//	  <Run Name="" Tanks="8" Teams="2" Seed="1" UpdateTime="0.0166666675" Ticks="1200"
+//	       CheckpointTicks="100" MaxSlowdown="10">
+//	    <Checkpoint Tick="100" Hash="0123456789abcdef"/>    Hash in hex, one per checkpoint
+//	    <Phase Name="Update" Ms="0"/>                       One per phase timed
+//	  </Run>
+//	</GoldenRuns>
+//
+// A run with no checkpoints or phases has not been recorded yet, see WriteGoldenRuns
+class CParseGoldenRuns : public CParseXML
+{
+
+/*---------------------------------------------------------------------------------------------
+	Constructors / Destructors
+---------------------------------------------------------------------------------------------*/
+public:
+	CParseGoldenRuns();
+
+
+/*-----------------------------------------------------------------------------------------
+	Public interface
+-----------------------------------------------------------------------------------------*/
+public:
+
+	// Read all the runs in the given file, replacing the contents of the runs vector. Returns
+	// false on file or parse error, or if a run has no ticks or a hash is not hex, with a reason
+	// in the error string if one is given
+	bool LoadRuns( const string& fileName, vector<SGoldenRun>* runs, string* error = 0 );
+
+
+/*-----------------------------------------------------------------------------------------
+	Private interface
+-----------------------------------------------------------------------------------------*/
+private:
+
+	/*---------------------------------------------------------------------------------------------
+		Callback functions
+	---------------------------------------------------------------------------------------------*/
+
+	// Callback function called when the parser meets the start of a new element (the opening tag)
+	void StartElt( const string& eltName, SAttribute* attrs );
+
+	// Callback function called when the parser meets the end of an element (the closing tag)
+	void EndElt( const string& eltName );
+
+
+	/*---------------------------------------------------------------------------------------------
+		Data
+	---------------------------------------------------------------------------------------------*/
+
+	// Runs read so far, the last one is being read while m_InRun is set
+	vector<SGoldenRun>* m_Runs;
+	bool                m_InRun;
+
+	// First problem found with the file content, empty if none
+	string m_Error;
+};
+
+
+} // namespace gen
+
+#endif // GEN_C_PARSE_GOLDEN_RUNS_H_INCLUDED
@@ -8,12 +8,14 @@
 
 #include "../Math/BaseMath.h"
 #include "../Scene/Entity.h"
+#include "../Common/CTimer.h"
+#include "../Common/Profiler.h"
 #include "CParseLevel.h"
 
 namespace gen
 {
 
-extern vector<vector<CVector3>> TeamWaypoints;
+extern TTeamWaypoints TeamWaypoints;
 
 /*---------------------------------------------------------------------------------------------
 	Constructors / Destructors
@@ -42,6 +44,8 @@ CParseLevel::CParseLevel( CEntityManager* entityManager, CTeamManager* teamManag
 	m_PosRand = false;
 	m_PosRandValue = CVector3::kOrigin;
 	m_Rot = CVector3::kOrigin;
+	m_RotRand = false;
+	m_RotRandValue = CVector3::kOrigin;
 	m_Scale = CVector3(1.0f, 1.0f, 1.0f);
 
 	// Waypoint state
@@ -49,6 +53,52 @@ CParseLevel::CParseLevel( CEntityManager* entityManager, CTeamManager* teamManag
 }
 
 
+/*---------------------------------------------------------------------------------------------
+	Loading
+---------------------------------------------------------------------------------------------*/
+
+// Parse the given level file and set up its templates, entities and waypoints. Loading is in
+// phases: the whole file is parsed first, then the meshes of all templates are read together on
+// the given thread pool (may be 0), then the templates and entities are created. Optionally
+// returns the time taken by each phase. Returns false on file or parse error
+bool CParseLevel::LoadLevel( const string& fileName, CThreadPool* pool, SLevelLoadTimes* times /*= 0*/ )
+{
+	GEN_PROFILE_ZONE( "CParseLevel::LoadLevel" );
+	CTimer timer;
+	SLevelLoadTimes phaseTimes;
+
+	// Parsing only declares templates and entities
+	m_TemplateDecls.clear();
+	m_EntityDecls.clear();
+	m_TankNames.clear();
+	bool parsed = ParseFile( fileName );
+	phaseTimes.parse = timer.GetLapTime();
+
+	// Read each distinct mesh once, all at the same time
+	vector<string> meshFiles;
+	for (TUInt32 decl = 0; decl < m_TemplateDecls.size(); ++decl)
+	{
+		meshFiles.push_back( m_TemplateDecls[decl].mesh );
+	}
+	m_EntityManager->AssetCache().PrepareMeshes( meshFiles, pool );
+	phaseTimes.layouts = timer.GetLapTime();
+
+	CreateTemplates();
+	phaseTimes.templates = timer.GetLapTime();
+
+	CreateEntities();
+	phaseTimes.entities = timer.GetLapTime();
+
+	m_TemplateDecls.clear();
+	m_EntityDecls.clear();
+	if (times)
+	{
+		*times = phaseTimes;
+	}
+	return parsed;
+}
+
+
 /*---------------------------------------------------------------------------------------------
 	Callback Functions
 ---------------------------------------------------------------------------------------------*/
@@ -120,23 +170,31 @@ void CParseLevel::EndElt( const string& eltName )
 // Called when the parser meets the start of an element (opening tag) in the templates section
 void CParseLevel::TemplatesStartElt( const string& eltName, SAttribute* attrs )
 {
-	// Started reading a new entity template - get type, name and mesh
+	// Started reading a new entity template - get type, name and mesh. Templates are created after
+	// parsing, when the meshes of all of them can be read together
 	if (eltName == "EntityTemplate")
 	{
 		// Get attributes held in the tag
 		m_TemplateType = GetAttribute( attrs, "Type" );
 		m_TemplateName = GetAttribute( attrs, "Name" );
 		m_TemplateMesh = GetAttribute( attrs, "Mesh" );
+
+		STemplateDecl decl;
+		decl.type = m_TemplateType;
+		decl.name = m_TemplateName;
+		decl.mesh = m_TemplateMesh;
 		if (m_TemplateType == "Tank")
 		{
-			m_EntityManager->CreateTankTemplate(m_TemplateType, m_TemplateName, m_TemplateMesh,
-				GetAttributeFloat(attrs, "MaxSpeed"), GetAttributeFloat(attrs, "Acceleration"), GetAttributeFloat(attrs, "TurnSpeed"),
-				GetAttributeFloat(attrs, "TurretTurnSpeed"), GetAttributeFloat(attrs, "MaxHP"), GetAttributeFloat(attrs, "ShellDamage"),
-				GetAttributeFloat(attrs, "ShellAmmo"));
+			decl.maxSpeed = GetAttributeFloat(attrs, "MaxSpeed");
+			decl.acceleration = GetAttributeFloat(attrs, "Acceleration");
+			decl.turnSpeed = GetAttributeFloat(attrs, "TurnSpeed");
+			decl.turretTurnSpeed = GetAttributeFloat(attrs, "TurretTurnSpeed");
+			decl.maxHP = GetAttributeFloat(attrs, "MaxHP");
+			decl.shellDamage = GetAttributeFloat(attrs, "ShellDamage");
+			decl.shellAmmo = GetAttributeFloat(attrs, "ShellAmmo");
 			m_TankNames.push_back(m_TemplateName);
 		}
-		else
-			m_EntityManager->CreateTemplate( m_TemplateType, m_TemplateName, m_TemplateMesh );
+		m_TemplateDecls.push_back(decl);
 	}
 }
 
@@ -234,45 +292,22 @@ void CParseLevel::EntitiesStartElt( const string& eltName, SAttribute* attrs )
 // Called when the parser meets the end of an element (closing tag) in the entities section
 void CParseLevel::EntitiesEndElt( const string& eltName )
 {
-	// Finished reading entity - set its position
+	// Finished reading entity - entities are created after parsing, once their templates exist
 	if (eltName == "Entity")
 	{
-		CVector3 PosRand = CVector3::kOrigin;
-		CVector3 RotRand = CVector3::kOrigin;
-		for (int i = 0; i < m_EntityNumber; ++i)
-		{
-			// Create a new entity
-			TEntityUID entityUID;
-			auto result = find(begin(m_TankNames), end(m_TankNames), m_EntityType);
-			if (result != end(m_TankNames))
-			{
-				entityUID = m_EntityManager->CreateTank(m_EntityType, m_TankTeam, m_EntityName);
-			}
-			else if (m_EntityType == "Ammo Cube")
-			{
-				entityUID = m_EntityManager->CreatePowerup(m_EntityType, m_EntityName);
-			}
-			else
-				entityUID = m_EntityManager->CreateEntity(m_EntityType, m_EntityName);
-
-			m_Entity = m_EntityManager->GetEntity(entityUID);
-
-			// random per instance
-			if (m_PosRand)
-			{
-				PosRand.x = Random(-m_PosRandValue.x, m_PosRandValue.x);
-				PosRand.y = Random(-m_PosRandValue.y, m_PosRandValue.y);
-				PosRand.z = Random(-m_PosRandValue.z, m_PosRandValue.z);
-			}
-			if (m_RotRand)
-			{
-				RotRand.x = Random(-m_RotRandValue.x, m_RotRandValue.x);
-				RotRand.y = Random(-m_RotRandValue.y, m_RotRandValue.y);
-				RotRand.z = Random(-m_RotRandValue.z, m_RotRandValue.z);
-			}
-
-			m_Entity->Matrix().MakeAffineEuler(m_Pos + PosRand, m_Rot + RotRand, kZXY, m_Scale);
-		}
+		SEntityDecl decl;
+		decl.type = m_EntityType;
+		decl.name = m_EntityName;
+		decl.team = m_TankTeam;
+		decl.number = m_EntityNumber;
+		decl.pos = m_Pos;
+		decl.posRand = m_PosRand;
+		decl.posRandValue = m_PosRandValue;
+		decl.rot = m_Rot;
+		decl.rotRand = m_RotRand;
+		decl.rotRandValue = m_RotRandValue;
+		decl.scale = m_Scale;
+		m_EntityDecls.push_back(decl);
 	}
 }
 
@@ -281,11 +316,11 @@ void CParseLevel::WaypointsStartElt(const string& eltName, SAttribute* attrs)
 	// Started reading a new waypoints
 	if (eltName == "Waypoints")
 	{
-		TeamWaypoints.empty();
+		TeamWaypoints.clear();
 	}
 	else if (eltName == "List")
 	{
-		m_List.empty();
+		m_List.clear();
 	}
 	else if (eltName == "Waypoint")
 	{
@@ -305,6 +340,75 @@ void CParseLevel::WaypointsEndElt(const string& eltName)
 	}
 }
 
+/*---------------------------------------------------------------------------------------------
+	Creation
+---------------------------------------------------------------------------------------------*/
+
+// Create the declared templates, their meshes should already be prepared
+void CParseLevel::CreateTemplates()
+{
+	GEN_PROFILE_ZONE( "CParseLevel::CreateTemplates" );
+	for (TUInt32 entityTemplate = 0; entityTemplate < m_TemplateDecls.size(); ++entityTemplate)
+	{
+		const STemplateDecl& decl = m_TemplateDecls[entityTemplate];
+		if (decl.type == "Tank")
+		{
+			m_EntityManager->CreateTankTemplate(decl.type, decl.name, decl.mesh,
+				decl.maxSpeed, decl.acceleration, decl.turnSpeed, decl.turretTurnSpeed, decl.maxHP,
+				decl.shellDamage, decl.shellAmmo);
+		}
+		else
+			m_EntityManager->CreateTemplate( decl.type, decl.name, decl.mesh );
+	}
+}
+
+// Create the declared entities, their templates must already exist
+void CParseLevel::CreateEntities()
+{
+	GEN_PROFILE_ZONE( "CParseLevel::CreateEntities" );
+	for (TUInt32 entity = 0; entity < m_EntityDecls.size(); ++entity)
+	{
+		const SEntityDecl& decl = m_EntityDecls[entity];
+		CVector3 PosRand = CVector3::kOrigin;
+		CVector3 RotRand = CVector3::kOrigin;
+		for (int i = 0; i < decl.number; ++i)
+		{
+			// Create a new entity
+			TEntityUID entityUID;
+			auto result = find(begin(m_TankNames), end(m_TankNames), decl.type);
+			if (result != end(m_TankNames))
+			{
+				entityUID = m_EntityManager->CreateTank(decl.type, decl.team, decl.name);
+			}
+			else if (decl.type == "Ammo Cube")
+			{
+				entityUID = m_EntityManager->CreatePowerup(decl.type, decl.name);
+			}
+			else
+				entityUID = m_EntityManager->CreateEntity(decl.type, decl.name);
+
+			m_Entity = m_EntityManager->GetEntity(entityUID);
+
+			// random per instance
+			if (decl.posRand)
+			{
+				PosRand.x = Random(-decl.posRandValue.x, decl.posRandValue.x);
+				PosRand.y = Random(-decl.posRandValue.y, decl.posRandValue.y);
+				PosRand.z = Random(-decl.posRandValue.z, decl.posRandValue.z);
+			}
+			if (decl.rotRand)
+			{
+				RotRand.x = Random(-decl.rotRandValue.x, decl.rotRandValue.x);
+				RotRand.y = Random(-decl.rotRandValue.y, decl.rotRandValue.y);
+				RotRand.z = Random(-decl.rotRandValue.z, decl.rotRandValue.z);
+			}
+
+			m_Entity->Matrix().MakeAffineEuler(decl.pos + PosRand, decl.rot + RotRand, kZXY, decl.scale);
+		}
+	}
+}
+
+
 //****************************************************************************/
 //  Component Code
 //****************************************************************************/
@@ -19,10 +19,26 @@ using namespace std;
 #include "../Scene/EntityManager.h"
 #include "CParseXML.h"
 #include "../Scene/TeamManager.h"
+#include "../Common/CThreadPool.h"
+#include "../Common/MemoryTracker.h"
 
 namespace gen
 {
 
+// Waypoints of one team, and of every team (see TeamWaypoints)
+typedef vector<CVector3, CTaggedAllocator<CVector3, EMemoryTag::Waypoints>> TWaypointList;
+typedef vector<TWaypointList, CTaggedAllocator<TWaypointList, EMemoryTag::Waypoints>> TTeamWaypoints;
+
+// Time taken (seconds) by each phase of CParseLevel::LoadLevel
+struct SLevelLoadTimes
+{
+	TFloat32 parse;     // Reading the XML and collecting the template and entity declarations
+	TFloat32 layouts;   // Reading the layouts of all template meshes (on the thread pool)
+	TFloat32 templates; // Creating the templates from the prepared meshes
+	TFloat32 entities;  // Creating the entities
+};
+
+
 /*---------------------------------------------------------------------------------------------
 	CParseLevel class
 ---------------------------------------------------------------------------------------------*/
@@ -31,7 +47,8 @@ namespace gen
 // class calls functions (overridden) in this class when it encounters the start and end of
 // elements in the XML (opening and closing tags). These functions then perform appropriate
 // setup. This is an event driven system, requiring this class to store state - the entity /
-// template / member variables it is currently building
+// template / member variables it is currently building. Templates and entities are only
+// declared during parsing, use LoadLevel to parse the file and then create them
 class CParseLevel : public CParseXML
 {
 
@@ -42,6 +59,19 @@ public:
 	// Constructor gets a pointer to the entity manager and initialises state variables
 	CParseLevel(CEntityManager* entityManager, CTeamManager* teamManager);
 	
+
+/*-----------------------------------------------------------------------------------------
+	Public interface
+-----------------------------------------------------------------------------------------*/
+public:
+
+	// Parse the given level file and set up its templates, entities and waypoints. Loading is in
+	// phases: the whole file is parsed first, then the meshes of all templates are read together on
+	// the given thread pool (may be 0), then the templates and entities are created. Optionally
+	// returns the time taken by each phase. Returns false on file or parse error, anything read
+	// before the error is still set up
+	bool LoadLevel( const string& fileName, CThreadPool* pool, SLevelLoadTimes* times = 0 );
+
 /*-----------------------------------------------------------------------------------------
 	Private interface
 -----------------------------------------------------------------------------------------*/
@@ -60,6 +90,39 @@ private:
 		Waypoints
 	};
 
+	// A template read from the file, created once the meshes of all templates have been prepared
+	struct STemplateDecl
+	{
+		string   type;
+		string   name;
+		string   mesh;
+
+		// Tank templates only
+		TFloat32 maxSpeed;
+		TFloat32 acceleration;
+		TFloat32 turnSpeed;
+		TFloat32 turretTurnSpeed;
+		TFloat32 maxHP;
+		TFloat32 shellDamage;
+		TFloat32 shellAmmo;
+	};
+
+	// An entity (or group of identical entities) read from the file, created after the templates
+	struct SEntityDecl
+	{
+		string   type;
+		string   name;
+		int      team;
+		TInt32   number;
+		CVector3 pos;
+		bool     posRand;
+		CVector3 posRandValue;
+		CVector3 rot;
+		bool     rotRand;
+		CVector3 rotRandValue;
+		CVector3 scale;
+	};
+
 
 	/*---------------------------------------------------------------------------------------------
 		Callback functions
@@ -101,6 +164,17 @@ private:
 	void ComponentsStartElt( const string& typeName, SAttribute* attrs );
 
 
+	/*---------------------------------------------------------------------------------------------
+		Creation
+	---------------------------------------------------------------------------------------------*/
+
+	// Create the declared templates, their meshes should already be prepared
+	void CreateTemplates();
+
+	// Create the declared entities, their templates must already exist
+	void CreateEntities();
+
+
 	/*---------------------------------------------------------------------------------------------
 		Data
 	---------------------------------------------------------------------------------------------*/
@@ -112,6 +186,10 @@ private:
 
 	vector<string> m_TankNames; // list of names of tanks for creating tank entity
 
+	// Templates and entities read but not yet created, in file order
+	vector<STemplateDecl> m_TemplateDecls;
+	vector<SEntityDecl>   m_EntityDecls;
+
 	// File state
 	EFileSection m_CurrentSection;
 
@@ -135,7 +213,7 @@ private:
 	CVector3 m_Scale;
 
 	// Current waypoint state (i.e. latest values read during parsing)
-	vector<CVector3> m_List;		// list of positions to be pushed to extern TeamWaypoints
+	TWaypointList m_List;		// list of positions to be pushed to extern TeamWaypoints
 	CVector3         m_WaypointPos;
 };
 
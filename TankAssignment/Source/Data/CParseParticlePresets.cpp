@@ -0,0 +1,146 @@
+///////////////////////////////////////////////////////////
+//  CParseParticlePresets.cpp
+//  A class to read particle effect presets from an XML
+//  file, for the particle tool to compile
+///////////////////////////////////////////////////////////
+
+#include "CParseParticlePresets.h"
+
+namespace gen
+{
+
+// Names of the emitter shapes, indexed by EEmitterShape
+static const char* const kShapeNames[] = { "Point", "Sphere", "Box", "Disc" };
+static_assert( sizeof(kShapeNames) / sizeof(kShapeNames[0]) == static_cast<int>(EEmitterShape::NumShapes),
+               "One name needed for each emitter shape" );
+
+
+/*---------------------------------------------------------------------------------------------
+	Constructors / Destructors
+---------------------------------------------------------------------------------------------*/
+
+CParseParticlePresets::CParseParticlePresets()
+{
+	m_Presets = 0;
+	m_InPreset = false;
+}
+
+
+/*---------------------------------------------------------------------------------------------
+	Loading
+---------------------------------------------------------------------------------------------*/
+
+// Read all the presets in the given file, replacing the contents of the presets vector
+bool CParseParticlePresets::LoadPresets( const string& fileName, vector<SParticlePreset>* presets,
+                                         string* error /*= 0*/ )
+{
+	presets->clear();
+	m_Presets = presets;
+	m_InPreset = false;
+	m_Error = "";
+
+	bool parsed = ParseFile( fileName );
+	if (!parsed && m_Error.empty())
+	{
+		m_Error = "cannot read or parse " + fileName;
+	}
+	m_Presets = 0;
+
+	if (!m_Error.empty())
+	{
+		if (error)  *error = m_Error;
+		return false;
+	}
+	return true;
+}
+
+
+/*---------------------------------------------------------------------------------------------
+	Callback Functions
+---------------------------------------------------------------------------------------------*/
+
+// Callback function called when the parser meets the start of a new element (the opening tag)
+void CParseParticlePresets::StartElt( const string& eltName, SAttribute* attrs )
+{
+	if (eltName == "Preset")
+	{
+		// New preset with the defaults described in the header
+		SParticlePreset preset;
+		preset.name = GetAttribute( attrs, "Name" );
+		SParticleEffectDesc& desc = preset.desc;
+		desc.priority = GetAttributeInt( attrs, "Priority", 1 );
+		desc.maxParticles = GetAttributeInt( attrs, "MaxParticles", 256 );
+		desc.burstParticles = 0;
+		desc.emitRate = 0.0f;
+		desc.emitTime = 0.0f;
+		desc.minLife = desc.maxLife = 1.0f;
+		desc.minSpeed = desc.maxSpeed = 0.0f;
+		desc.upSpeed = 0.0f;
+		desc.shape = EEmitterShape::Point;
+		desc.shapeSize = 0.0f;
+		desc.acceleration = CVector3( 0.0f, kParticleGravity, 0.0f );
+		desc.drag = 0.0f;
+		m_Presets->push_back( preset );
+		m_InPreset = true;
+		return;
+	}
+	if (!m_InPreset)
+	{
+		return;
+	}
+
+	// Parts of the current preset
+	SParticlePreset& preset = m_Presets->back();
+	SParticleEffectDesc& desc = preset.desc;
+	if (eltName == "Emit")
+	{
+		desc.burstParticles = GetAttributeInt( attrs, "Burst", 0 );
+		desc.emitRate = GetAttributeFloat( attrs, "Rate" );
+		desc.emitTime = GetAttributeFloat( attrs, "Time" );
+	}
+	else if (eltName == "Shape")
+	{
+		string type = GetAttribute( attrs, "Type", kShapeNames[0] );
+		TUInt32 shape = 0;
+		while (shape < static_cast<TUInt32>(EEmitterShape::NumShapes) && type != kShapeNames[shape])
+		{
+			++shape;
+		}
+		if (shape == static_cast<TUInt32>(EEmitterShape::NumShapes) && m_Error.empty())
+		{
+			m_Error = "preset '" + preset.name + "' has unknown shape '" + type + "'";
+		}
+		desc.shape = static_cast<EEmitterShape>(shape);
+		desc.shapeSize = GetAttributeFloat( attrs, "Size" );
+	}
+	else if (eltName == "Life")
+	{
+		desc.minLife = GetAttributeFloat( attrs, "Min", 1.0f );
+		desc.maxLife = GetAttributeFloat( attrs, "Max", 1.0f );
+	}
+	else if (eltName == "Speed")
+	{
+		desc.minSpeed = GetAttributeFloat( attrs, "Min" );
+		desc.maxSpeed = GetAttributeFloat( attrs, "Max" );
+		desc.upSpeed = GetAttributeFloat( attrs, "Up" );
+	}
+	else if (eltName == "Forces")
+	{
+		desc.acceleration.x = GetAttributeFloat( attrs, "X" );
+		desc.acceleration.y = GetAttributeFloat( attrs, "Y", kParticleGravity );
+		desc.acceleration.z = GetAttributeFloat( attrs, "Z" );
+		desc.drag = GetAttributeFloat( attrs, "Drag" );
+	}
+}
+
+// Callback function called when the parser meets the end of an element (the closing tag)
+void CParseParticlePresets::EndElt( const string& eltName )
+{
+	if (eltName == "Preset")
+	{
+		m_InPreset = false;
+	}
+}
+
+
+} // namespace gen
@@ -0,0 +1,91 @@
+///////////////////////////////////////////////////////////
+//  CParseParticlePresets.h
+//  A class to read particle effect presets from an XML
+//  file, for the particle tool to compile
+///////////////////////////////////////////////////////////
+
+#ifndef GEN_C_PARSE_PARTICLE_PRESETS_H_INCLUDED
+#define GEN_C_PARSE_PARTICLE_PRESETS_H_INCLUDED
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "../Common/Defines.h"
+#include "../Render/ParticlePresetFile.h"
+#include "CParseXML.h"
+
+namespace gen
+{
+
+/*---------------------------------------------------------------------------------------------
+	CParseParticlePresets class
+---------------------------------------------------------------------------------------------*/
+// A XML parser to read authored particle presets, in this form (any element or attribute left
+// out takes the value shown):
+//
+//	<ParticlePresets>
+//	  <Preset Name="Smoke" Priority="1" MaxParticles="256">
+//	    <Emit Burst="0" Rate="0" Time="0"/>          Particles at the start, per second and for how long
+//	    <Shape Type="Point" Size="0"/>               Point, Sphere, Box or Disc
+//	    <Life Min="1" Max="1"/>                      Seconds
+//	    <Speed Min="0" Max="0" Up="0"/>              Random direction, plus upwards
+//	    <Forces X="0" Y="-9.8" Z="0" Drag="0"/>      Acceleration, and velocity lost per second
+//	  </Preset>
+//	</ParticlePresets>
+//
+// The game does not read these files, they are compiled to a CParticlePresetFile first
+class CParseParticlePresets : public CParseXML
+{
+
+/*---------------------------------------------------------------------------------------------
+	Constructors / Destructors
+---------------------------------------------------------------------------------------------*/
+public:
+	CParseParticlePresets();
+
+
+/*-----------------------------------------------------------------------------------------
+	Public interface
+-----------------------------------------------------------------------------------------*/
+public:
+
+	// Read all the presets in the given file, replacing the contents of the presets vector.
+	// Presets are not checked (CParticlePresetFile::Write does that). Returns false on file or
+	// parse error, or if a preset has an unknown shape, with a reason in the error string if
+	// one is given
+	bool LoadPresets( const string& fileName, vector<SParticlePreset>* presets, string* error = 0 );
+
+
+/*-----------------------------------------------------------------------------------------
+	Private interface
+-----------------------------------------------------------------------------------------*/
+private:
+
+	/*---------------------------------------------------------------------------------------------
+		Callback functions
+	---------------------------------------------------------------------------------------------*/
+
+	// Callback function called when the parser meets the start of a new element (the opening tag)
+	void StartElt( const string& eltName, SAttribute* attrs );
+
+	// Callback function called when the parser meets the end of an element (the closing tag)
+	void EndElt( const string& eltName );
+
+
+	/*---------------------------------------------------------------------------------------------
+		Data
+	---------------------------------------------------------------------------------------------*/
+
+	// Presets read so far, the last one is being read while m_InPreset is set
+	vector<SParticlePreset>* m_Presets;
+	bool                     m_InPreset;
+
+	// First problem found with the file content, empty if none
+	string m_Error;
+};
+
+
+} // namespace gen
+
+#endif // GEN_C_PARSE_PARTICLE_PRESETS_H_INCLUDED
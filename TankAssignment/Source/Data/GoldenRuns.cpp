@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////
+//  GoldenRuns.cpp
+//  Fixed runs of the game with recorded state hashes and
+//  times, see header
+///////////////////////////////////////////////////////////
+
+#include <fstream>
+#include <iomanip>
+
+#include "GoldenRuns.h"
+
+namespace gen
+{
+
+// Write the runs to an XML file that CParseGoldenRuns can read
+bool WriteGoldenRuns( const string& fileName, const vector<SGoldenRun>& runs )
+{
+	ofstream file( fileName.c_str(), ios::trunc );
+	if (!file)
+	{
+		return false;
+	}
+
+	file << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
+	file << "<!-- Golden runs: state hashes and phase times recorded by TankAssignment -golden-record -->\n";
+	file << "<GoldenRuns>\n";
+	for (TUInt32 r = 0; r < runs.size(); ++r)
+	{
+		const SGoldenRun& run = runs[r];
+		file << "  <Run Name=\"" << run.name << "\" Tanks=\"" << run.numTanks << "\" Teams=\"" << run.numTeams
+		     << "\" Seed=\"" << run.seed << "\" UpdateTime=\"" << setprecision( 9 ) << run.updateTime
+		     << "\" Ticks=\"" << run.numTicks << "\" CheckpointTicks=\"" << run.checkpointTicks
+		     << "\" MaxSlowdown=\"" << setprecision( 6 ) << run.maxSlowdown << "\">\n";
+		for (TUInt32 c = 0; c < run.checkpoints.size(); ++c)
+		{
+			file << "    <Checkpoint Tick=\"" << run.checkpoints[c].tick << "\" Hash=\"" << hex << setfill( '0' )
+			     << setw( 16 ) << run.checkpoints[c].hash << dec << setfill( ' ' ) << "\"/>\n";
+		}
+		file << fixed << setprecision( 3 );
+		for (TUInt32 p = 0; p < run.phases.size(); ++p)
+		{
+			file << "    <Phase Name=\"" << run.phases[p].name << "\" Ms=\"" << run.phases[p].ms << "\"/>\n";
+		}
+		file.unsetf( ios::floatfield );
+		file << "  </Run>\n";
+	}
+	file << "</GoldenRuns>\n";
+
+	return file.good();
+}
+
+
+} // namespace gen
@@ -0,0 +1,63 @@
+///////////////////////////////////////////////////////////
+//  GoldenRuns.h
+//  Fixed runs of the game with the state hashes and
+//  times recorded from a known good build, so a change
+//  can be checked to keep the game's behaviour exactly
+//  and to not make it slower
+///////////////////////////////////////////////////////////
+
+#ifndef GEN_GOLDEN_RUNS_H_INCLUDED
+#define GEN_GOLDEN_RUNS_H_INCLUDED
+
+#include <string>
+#include <vector>
+using namespace std;
+
+#include "../Common/Defines.h"
+
+namespace gen
+{
+
+// State hash (see CStateHash) expected after the given number of updates
+struct SGoldenCheckpoint
+{
+	TUInt32 tick;
+	TUInt64 hash;
+};
+
+// Wall time expected for one phase of a run
+struct SGoldenPhase
+{
+	string   name;
+	TFloat32 ms;
+};
+
+// A generated level (see ScenarioForTanks) run headless with every tank started, for a fixed
+// number of updates of a fixed time. Checkpoints and phase times are empty until recorded
+struct SGoldenRun
+{
+	string   name;
+	TUInt32  numTanks;
+	TUInt32  numTeams;
+	TUInt32  seed;            // Seeds both the level generator and rand()
+	TFloat32 updateTime;
+	TUInt32  numTicks;
+	TUInt32  checkpointTicks; // Updates between checkpoints
+	TFloat32 maxSlowdown;     // Percentage a phase may be slower than recorded before the run fails
+
+	vector<SGoldenCheckpoint> checkpoints;
+	vector<SGoldenPhase>      phases;
+};
+
+// Phases shorter than this are too short to time reliably, so a phase only fails if it is also
+// slower by at least this many milliseconds
+const TFloat32 kGoldenMinSlowdownMs = 1.0f;
+
+// Write the runs to an XML file that CParseGoldenRuns can read. The update time is written in
+// full so it reads back exactly. Returns false if the file cannot be written
+bool WriteGoldenRuns( const string& fileName, const vector<SGoldenRun>& runs );
+
+
+} // namespace gen
+
+#endif // GEN_GOLDEN_RUNS_H_INCLUDED
@@ -0,0 +1,199 @@
+///////////////////////////////////////////////////////////
+//  ScenarioGenerator.cpp
+//  Writes level files of any size for CParseLevel, see
+//  header
+///////////////////////////////////////////////////////////
+
+#include <fstream>
+#include <iomanip>
+#include <random>
+#include <cmath>
+
+#include "../Math/BaseMath.h"
+#include "ScenarioGenerator.h"
+
+namespace gen
+{
+
+// The templates of Entities.xml, written to every generated level
+static const char* const ScenarioTemplates[] =
+{
+	"<EntityTemplate Type=\"Scenery\" Name=\"Skybox\" Mesh=\"Skybox.x\"/>",
+	"<EntityTemplate Type=\"Scenery\" Name=\"Floor\" Mesh=\"Floor.x\"/>",
+	"<EntityTemplate Type=\"Scenery\" Name=\"Building\" Mesh=\"Building.x\"/>",
+	"<EntityTemplate Type=\"Scenery\" Name=\"Tree\" Mesh=\"Tree1.x\"/>",
+	"<EntityTemplate Type=\"Tank\" Name=\"Rouge Battle Tank\" Mesh=\"HoverTank01.x\" MaxSpeed=\"24.0\" Acceleration=\"2.2\" TurnSpeed=\"2.0\" TurretTurnSpeed=\"1.0471975511965977461542144610932\" MaxHP=\"100\" ShellDamage=\"20\" ShellAmmo=\"20\"/>",
+	"<EntityTemplate Type=\"Tank\" Name=\"Rogue Scout\" Mesh=\"HoverTank02.x\" MaxSpeed=\"30.0\" Acceleration=\"2.8\" TurnSpeed=\"2.6\" TurretTurnSpeed=\"1.5707963267948966192313216916397\" MaxHP=\"80\" ShellDamage=\"15\" ShellAmmo=\"30\"/>",
+	"<EntityTemplate Type=\"Tank\" Name=\"Rogue Heavy Tank\" Mesh=\"HoverTank03.x\" MaxSpeed=\"18.0\" Acceleration=\"1.6\" TurnSpeed=\"1.3\" TurretTurnSpeed=\"0.78539816339744830961566084581988\" MaxHP=\"120\" ShellDamage=\"35\" ShellAmmo=\"15\"/>",
+	"<EntityTemplate Type=\"Tank\" Name=\"Rogue Armed Tank\" Mesh=\"HoverTank04.x\" MaxSpeed=\"16.0\" Acceleration=\"1.0\" TurnSpeed=\"1.0\" TurretTurnSpeed=\"0.62831853071795864769252867665590\" MaxHP=\"150\" ShellDamage=\"50\" ShellAmmo=\"10\"/>",
+	"<EntityTemplate Type=\"Tank\" Name=\"Oberon Oppressor\" Mesh=\"HoverTank05.x\" MaxSpeed=\"30.0\" Acceleration=\"2.8\" TurnSpeed=\"2.6\" TurretTurnSpeed=\"1.5707963267948966192313216916397\" MaxHP=\"80\" ShellDamage=\"15\" ShellAmmo=\"30\"/>",
+	"<EntityTemplate Type=\"Tank\" Name=\"Oberon MkI\" Mesh=\"HoverTank06.x\" MaxSpeed=\"24.0\" Acceleration=\"2.2\" TurnSpeed=\"2.0\" TurretTurnSpeed=\"1.0471975511965977461542144610932\" MaxHP=\"100\" ShellDamage=\"20\" ShellAmmo=\"20\"/>",
+	"<EntityTemplate Type=\"Tank\" Name=\"Oberon MkII\" Mesh=\"HoverTank07.x\" MaxSpeed=\"18.0\" Acceleration=\"1.6\" TurnSpeed=\"1.3\" TurretTurnSpeed=\"0.78539816339744830961566084581988\" MaxHP=\"120\" ShellDamage=\"35\" ShellAmmo=\"15\"/>",
+	"<EntityTemplate Type=\"Tank\" Name=\"Oberon Black\" Mesh=\"HoverTank08.x\" MaxSpeed=\"16.0\" Acceleration=\"1.0\" TurnSpeed=\"1.0\" TurretTurnSpeed=\"0.62831853071795864769252867665590\" MaxHP=\"150\" ShellDamage=\"50\" ShellAmmo=\"10\"/>",
+	"<EntityTemplate Type=\"Projectile\" Name=\"Shell Type 1\" Mesh=\"Bullet.x\"/>",
+	"<EntityTemplate Type=\"Powerup\" Name=\"Ammo Cube\" Mesh=\"Cube.x\"/>",
+};
+
+// Tank templates used by even and odd teams
+const TUInt32 kTankTypesPerSide = 4;
+static const char* const ScenarioTankTypes[2][kTankTypesPerSide] =
+{
+	{ "Rouge Battle Tank", "Rogue Scout", "Rogue Heavy Tank", "Rogue Armed Tank" },
+	{ "Oberon Oppressor", "Oberon MkI", "Oberon MkII", "Oberon Black" },
+};
+
+// Entities.xml: 8 tanks in 2 teams, 10 powerups and 100 trees on a map of about 250m x 250m
+const TUInt32  kBaseTanks = 8;
+const TFloat32 kBaseMapSize = 250.0f;
+const TFloat32 kBasePowerupsPerTank = 10.0f / kBaseTanks;
+const TFloat32 kBaseSceneryDensity = 20.0f;
+const TUInt32  kBaseWaypoints = 6;
+
+// Space between tanks in a team's starting block, the same as the team formations
+const TFloat32 kScenarioTankSpacing = 15.0f;
+
+// Trees and powerups are kept this far from the building at the centre
+const TFloat32 kScenarioClearRadius = 15.0f;
+
+
+// Description of a level with the given number of tanks and the same density of everything as
+// Entities.xml
+SScenarioDesc ScenarioForTanks( TUInt32 numTanks, TUInt32 numTeams /*= 2*/, TUInt32 seed /*= 1*/ )
+{
+	SScenarioDesc desc;
+	desc.numTeams = Max( numTeams, 1u );
+	desc.tanksPerTeam = (numTanks + desc.numTeams - 1) / desc.numTeams;
+	desc.numPowerups = static_cast<TUInt32>(desc.numTeams * desc.tanksPerTeam * kBasePowerupsPerTank + 0.5f);
+	desc.sceneryDensity = kBaseSceneryDensity;
+	desc.mapSize = kBaseMapSize * sqrt( static_cast<TFloat32>(desc.numTeams * desc.tanksPerTeam) / kBaseTanks );
+	desc.mapSize = Max( desc.mapSize, kBaseMapSize );
+	desc.numWaypoints = kBaseWaypoints;
+	desc.seed = seed;
+	return desc;
+}
+
+
+// Write one entity with a position and Y rotation (degrees), and optionally a team and scale
+static void WriteEntity( ofstream& file, const char* type, const string& name, TFloat32 x, TFloat32 y,
+                         TFloat32 z, TFloat32 rotY, TInt32 team = -1, TFloat32 scale = 1.0f )
+{
+	file << "    <Entity Type=\"" << type << "\" Name=\"" << name << "\"";
+	if (team >= 0)
+	{
+		file << " Team=\"" << team << "\"";
+	}
+	file << ">\n";
+	file << "      <Position X=\"" << x << "\" Y=\"" << y << "\" Z=\"" << z << "\"/>\n";
+	file << "      <Rotation X=\"0.0\" Y=\"" << rotY << "\" Z=\"0.0\"/>\n";
+	if (scale != 1.0f)
+	{
+		file << "      <Scale X=\"" << scale << "\" Y=\"" << scale << "\" Z=\"" << scale << "\"/>\n";
+	}
+	file << "    </Entity>\n";
+}
+
+// Write a level with the given description to an XML file that CParseLevel can load. Every
+// position is written out rather than left to the parser's Randomise, so a level is the same
+// each time it is loaded
+bool WriteScenario( const string& fileName, const SScenarioDesc& desc )
+{
+	ofstream file( fileName.c_str(), ios::trunc );
+	if (!file)
+	{
+		return false;
+	}
+	mt19937 random( desc.seed );
+	uniform_real_distribution<TFloat32> mapPos( -desc.mapSize * 0.5f, desc.mapSize * 0.5f );
+	uniform_real_distribution<TFloat32> angle( 0.0f, 360.0f );
+	file << fixed << setprecision( 1 );
+
+	file << "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n";
+	file << "<!-- Generated level: " << desc.numTeams << " teams of " << desc.tanksPerTeam << " tanks, "
+	     << desc.numPowerups << " powerups, " << desc.mapSize << "m map, seed " << desc.seed << " -->\n";
+	file << "<Level>\n";
+
+	file << "  <Templates>\n";
+	for (TUInt32 t = 0; t < sizeof(ScenarioTemplates) / sizeof(ScenarioTemplates[0]); ++t)
+	{
+		file << "    " << ScenarioTemplates[t] << "\n";
+	}
+	file << "  </Templates>\n";
+
+	file << "  <Entities>\n";
+	file << "    <Entity Type=\"Skybox\" Name=\"Skybox\">\n";
+	file << "      <Position X=\"0.0\" Y=\"-10000.0\" Z=\"0.0\"/>\n";
+	file << "      <Scale X=\"10.0\" Y=\"10.0\" Z=\"10.0\"/>\n";
+	file << "    </Entity>\n";
+	file << "    <Entity Type=\"Floor\" Name=\"Floor\">\n";
+	file << "    </Entity>\n";
+	WriteEntity( file, "Building", "Building", 0.0f, 0.0f, 0.0f, 0.0f );
+
+	// Each team's tanks in a square block centred on its start, which are spaced evenly around a
+	// circle about the building. Team 0 starts on the -X side like Entities.xml
+	const TFloat32 startRadius = desc.mapSize * 0.3f;
+	const TUInt32 blockWidth = static_cast<TUInt32>(ceil( sqrt( static_cast<TFloat32>(desc.tanksPerTeam) ) ));
+	const TFloat32 blockOffset = (blockWidth - 1) * kScenarioTankSpacing * 0.5f;
+	for (TUInt32 team = 0; team < desc.numTeams; ++team)
+	{
+		TFloat32 teamAngle = kfPi + 2.0f * kfPi * team / desc.numTeams;
+		TFloat32 startX = startRadius * cos( teamAngle );
+		TFloat32 startZ = startRadius * sin( teamAngle );
+		TFloat32 facing = ToDegrees( atan2( -startX, -startZ ) );
+		string namePrefix = string( 1, static_cast<char>('A' + team % 26) ) + "-";
+		for (TUInt32 tank = 0; tank < desc.tanksPerTeam; ++tank)
+		{
+			TFloat32 x = startX + (tank % blockWidth) * kScenarioTankSpacing - blockOffset;
+			TFloat32 z = startZ + (tank / blockWidth) * kScenarioTankSpacing - blockOffset;
+			WriteEntity( file, ScenarioTankTypes[team % 2][tank % kTankTypesPerSide],
+			             namePrefix + to_string( tank + 1 ), x, 0.5f, z, facing, static_cast<TInt32>(team) );
+		}
+	}
+
+	// Trees and powerups scattered over the map, clear of the building
+	TUInt32 numTrees = static_cast<TUInt32>(desc.sceneryDensity * desc.mapSize * desc.mapSize / 10000.0f);
+	for (TUInt32 entity = 0; entity < numTrees + desc.numPowerups; ++entity)
+	{
+		TFloat32 x, z;
+		do
+		{
+			x = mapPos( random );
+			z = mapPos( random );
+		} while (x * x + z * z < kScenarioClearRadius * kScenarioClearRadius);
+
+		if (entity < numTrees)
+		{
+			WriteEntity( file, "Tree", "Tree", x, 0.0f, z, angle( random ) );
+		}
+		else
+		{
+			WriteEntity( file, "Ammo Cube", "Ammo Cube", x, 0.5f, z, angle( random ), -1, 0.1f );
+		}
+	}
+	file << "  </Entities>\n";
+
+	// Each team patrols a ring halfway between its start and the building. Tanks need at least one
+	file << "  <Waypoints>\n";
+	const TFloat32 waypointRadius = desc.mapSize * 0.1f;
+	const TUInt32 numWaypoints = Max( desc.numWaypoints, 1u );
+	for (TUInt32 team = 0; team < desc.numTeams; ++team)
+	{
+		TFloat32 teamAngle = kfPi + 2.0f * kfPi * team / desc.numTeams;
+		TFloat32 centreX = startRadius * 0.5f * cos( teamAngle );
+		TFloat32 centreZ = startRadius * 0.5f * sin( teamAngle );
+		file << "    <List>\n";
+		for (TUInt32 waypoint = 0; waypoint < numWaypoints; ++waypoint)
+		{
+			TFloat32 waypointAngle = 2.0f * kfPi * waypoint / numWaypoints;
+			file << "      <Waypoint X=\"" << centreX + waypointRadius * cos( waypointAngle ) << "\" Y=\"0.5\" Z=\""
+			     << centreZ + waypointRadius * sin( waypointAngle ) << "\"/>\n";
+		}
+		file << "    </List>\n";
+	}
+	file << "  </Waypoints>\n";
+	file << "</Level>\n";
+
+	return static_cast<bool>(file);
+}
+
+
+} // namespace gen
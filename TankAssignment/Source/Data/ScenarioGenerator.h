@@ -0,0 +1,45 @@
+///////////////////////////////////////////////////////////
+//  ScenarioGenerator.h
+//  Writes level files of any size for CParseLevel, so
+//  the game can be measured with many more tanks than
+//  the hand-made level has
+///////////////////////////////////////////////////////////
+
+#ifndef GEN_SCENARIO_GENERATOR_H_INCLUDED
+#define GEN_SCENARIO_GENERATOR_H_INCLUDED
+
+#include <string>
+using namespace std;
+
+#include "../Common/Defines.h"
+
+namespace gen
+{
+
+// Size and make-up of a generated level. The level has the same templates, skybox, floor and
+// building as Entities.xml. Each team starts in a square block on a circle around the building,
+// facing it, and patrols a ring of waypoints between its start and the building
+struct SScenarioDesc
+{
+	TUInt32  numTeams;       // Tanks use the Rogue templates in even teams, the Oberon ones in odd
+	TUInt32  tanksPerTeam;
+	TUInt32  numPowerups;
+	TFloat32 sceneryDensity; // Trees per 10,000 square metres (100m x 100m)
+	TFloat32 mapSize;        // Width and depth of the square map in metres, centred on the building
+	TUInt32  numWaypoints;   // Per team
+	TUInt32  seed;           // The same description and seed always give the same level
+};
+
+// Description of a level with the given number of tanks (rounded up to a whole number per team)
+// and the same density of tanks, powerups and trees as Entities.xml - the map grows with the
+// number of tanks. Entities.xml has 8 tanks in 2 teams
+SScenarioDesc ScenarioForTanks( TUInt32 numTanks, TUInt32 numTeams = 2, TUInt32 seed = 1 );
+
+// Write a level with the given description to an XML file that CParseLevel can load. Returns
+// false if the file cannot be written
+bool WriteScenario( const string& fileName, const SScenarioDesc& desc );
+
+
+} // namespace gen
+
+#endif // GEN_SCENARIO_GENERATOR_H_INCLUDED
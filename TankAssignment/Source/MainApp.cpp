@@ -6,13 +6,29 @@
 
 #include <windows.h>
 #include <windowsx.h>
+#include <psapi.h>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+using namespace std;
+
 #include <d3d10.h>
 #include <d3dx10.h>
 
 #include "Defines.h"
 #include "Input.h"
 #include "CTimer.h"
+#include "Profiler.h"
+#include "FrameStats.h"
+#include "MemoryTracker.h"
+#include "Messenger.h"
+#include "EntityManager.h"
+#include "ScenarioGenerator.h"
+#include "GoldenRuns.h"
+#include "CParseGoldenRuns.h"
 #include "CVector2.h"
+#include "BaseMath.h"
 #include "TankAssignment.h"
 
 namespace gen
@@ -60,6 +76,28 @@ CVector2 MousePixel;
 // Game timer
 CTimer Timer;
 
+// Times the update and render within each tick for the frame statistics
+CTimer TickTimer;
+
+// Update and render times of each tick
+extern CFrameStats FrameStats;
+
+// Messenger class for sending messages to and between entities
+extern CMessenger Messenger;
+
+// Entities of the current level
+extern CEntityManager EntityManager;
+
+// Level written for each size of a scaling run, and the tank counts run
+static const string ScalingLevelFile = "Scaling.xml";
+static const TUInt32 ScalingTankCounts[] = { 8, 32, 128, 512, 2048, 10000 };
+
+// Zones listed under each size of a scaling run, most self time first
+static const TUInt32 ScalingZonesShown = 6;
+
+// Level written for each golden run
+static const string GoldenLevelFile = "Golden.xml";
+
 
 
 //-----------------------------------------------------------------------------
@@ -199,6 +237,306 @@ void D3DShutdown()
 }
 
 
+//-----------------------------------------------------------------------------
+// Headless running
+//-----------------------------------------------------------------------------
+
+// Run the scene for a fixed number of updates with no window or device, then write the setup
+// and update times to standard output (redirect it to a file to see them). Mesh geometry is
+// never loaded, only the layouts
+void RunHeadless( TUInt32 numUpdates, TFloat32 updateTime )
+{
+	Timer.Reset();
+	bool setupOK = SimulationSetup();
+	float setupTime = Timer.GetLapTime();
+	if (setupOK)
+	{
+		TickTimer.Reset();
+		for (TUInt32 update = 0; update < numUpdates; ++update)
+		{
+			UpdateScene( updateTime );
+			float tickTime = TickTimer.GetLapTime();
+			FrameStats.Record( EFrameStat::Update, tickTime );
+			FrameStats.EndTick( tickTime );
+		}
+	}
+	TFloat64 runTime = Timer.GetPreciseLapTime();
+	SceneShutdown();
+
+	if (!setupOK)
+	{
+		cout << "Headless run: scene setup failed" << endl;
+		return;
+	}
+	cout << "Headless run: " << numUpdates << " updates of " << updateTime << "s" << endl;
+	cout << "Setup time:  " << setupTime * 1000.0f << "ms" << endl;
+	cout << StartupReport();
+	cout << "Update time: " << runTime * 1000.0 << "ms (" << runTime * 1000.0 / Max( numUpdates, 1u )
+	     << "ms per update)" << endl;
+	cout << FrameStats.Report( true );
+	cout << Messenger.Report();
+	cout << MemoryTracker.Report();
+	if (Profiler.IsRecording())
+	{
+		cout << SaveProfile();
+	}
+}
+
+
+// Memory committed by the process (private bytes) and the most it has had in physical memory
+static void GetProcessMemory( TUInt64* privateBytes, TUInt64* peakWorkingSet )
+{
+	PROCESS_MEMORY_COUNTERS_EX counters;
+	ZeroMemory( &counters, sizeof(counters) );
+	GetProcessMemoryInfo( GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters), sizeof(counters) );
+	*privateBytes = counters.PrivateUsage;
+	*peakWorkingSet = counters.PeakWorkingSetSize;
+}
+
+// Run generated levels of increasing size (see ScalingTankCounts, up to the given number of tanks)
+// headless, each for a fixed number of updates with every tank started, and write a table to
+// standard output: setup time, updates per second, update time percentiles and memory for each
+// size, then the zones that took most time per update. Zones are recorded throughout, so the
+// times include the profiler's cost (well under a microsecond per zone)
+void RunScalingSuite( TUInt32 numUpdates, TFloat32 updateTime, TUInt32 numTeams, TUInt32 maxTanks )
+{
+	bool wasRecording = Profiler.IsRecording();
+	Profiler.SetRecording( true );
+	numUpdates = Max( numUpdates, 1u );
+	numTeams = Max( numTeams, 1u );
+
+	cout << "Scaling run: " << numUpdates << " updates of " << updateTime << "s per level, " << numTeams
+	     << " teams" << endl;
+	cout << fixed << setprecision( 2 );
+	cout << setw( 7 ) << "Tanks" << setw( 10 ) << "Entities" << setw( 10 ) << "Setup ms" << setw( 10 )
+	     << "Updates/s" << setw( 9 ) << "p50 ms" << setw( 9 ) << "p99 ms" << setw( 9 ) << "Max ms" << setw( 12 )
+	     << "Level MB" << setw( 12 ) << "Peak MB" << endl;
+	for (TUInt32 size = 0; size < sizeof(ScalingTankCounts) / sizeof(ScalingTankCounts[0]); ++size)
+	{
+		if (ScalingTankCounts[size] > maxTanks)
+		{
+			break;
+		}
+		SScenarioDesc desc = ScenarioForTanks( ScalingTankCounts[size], numTeams );
+		if (!WriteScenario( ScalingLevelFile, desc ))
+		{
+			cout << "Cannot write " << ScalingLevelFile << endl;
+			break;
+		}
+
+		TUInt64 privateBefore, privateAfter, peakWorkingSet;
+		GetProcessMemory( &privateBefore, &peakWorkingSet );
+		Timer.Reset();
+		bool setupOK = SimulationSetup( ScalingLevelFile );
+		float setupTime = Timer.GetLapTime();
+		TUInt32 numEntities = EntityManager.NumEntities();
+
+		// Only the updates are measured
+		FrameStats.Clear();
+		Messenger.ResetStats();
+		Profiler.Clear();
+		StartAllTanks();
+		TickTimer.Reset();
+		for (TUInt32 update = 0; setupOK && update < numUpdates; ++update)
+		{
+			UpdateScene( updateTime );
+			float tickTime = TickTimer.GetLapTime();
+			FrameStats.Record( EFrameStat::Update, tickTime );
+			FrameStats.EndTick( tickTime );
+		}
+		TFloat64 runTime = Timer.GetPreciseLapTime();
+		vector<SProfileZoneStats> zones = Profiler.GetZoneStats();
+		GetProcessMemory( &privateAfter, &peakWorkingSet );
+		SceneShutdown();
+
+		if (!setupOK)
+		{
+			cout << setw( 7 ) << desc.numTeams * desc.tanksPerTeam << "  scene setup failed" << endl;
+			break;
+		}
+		SFrameStatSummary updates = FrameStats.Summary( EFrameStat::Update, true );
+		cout << setw( 7 ) << desc.numTeams * desc.tanksPerTeam << setw( 10 ) << numEntities << setw( 10 )
+		     << setupTime * 1000.0f << setw( 10 ) << numUpdates / Max( runTime, 0.000001 )
+		     << setw( 9 ) << updates.percentiles[0] * 1000.0f << setw( 9 ) << updates.percentiles[2] * 1000.0f
+		     << setw( 9 ) << updates.max * 1000.0f
+		     << setw( 12 ) << (static_cast<TInt64>(privateAfter) - static_cast<TInt64>(privateBefore)) / 1048576.0
+		     << setw( 12 ) << peakWorkingSet / 1048576.0 << endl;
+
+		const TFloat64 msPerTick = 1000.0 / CProfiler::TicksPerSecond();
+		for (TUInt32 zone = 0; zone < zones.size() && zone < ScalingZonesShown; ++zone)
+		{
+			cout << "         " << left << setw( 28 ) << zones[zone].name.substr( 0, 27 ) << right << setw( 9 )
+			     << zones[zone].selfTime * msPerTick / numUpdates << " ms self per update, "
+			     << zones[zone].calls / numUpdates << " calls" << endl;
+		}
+	}
+	Profiler.SetRecording( wasRecording );
+}
+
+
+//-----------------------------------------------------------------------------
+// Golden runs
+//-----------------------------------------------------------------------------
+
+// Run the game as described by a golden run (see SGoldenRun) and return the state hash at each
+// checkpoint and the time of each phase: setup, update and shutdown. Hashing is not included in
+// the update time. Returns false if the level cannot be written or set up
+static bool MeasureGoldenRun( const SGoldenRun& run, vector<SGoldenCheckpoint>* checkpoints,
+                              vector<SGoldenPhase>* phases )
+{
+	checkpoints->clear();
+	phases->clear();
+	if (!WriteScenario( GoldenLevelFile, ScenarioForTanks( run.numTanks, run.numTeams, run.seed ) ))
+	{
+		return false;
+	}
+
+	// Tanks and level randomisation use rand(), so seed it for the same game every time
+	srand( run.seed );
+	CTimer timer;
+	bool setupOK = SimulationSetup( GoldenLevelFile );
+	TInt64 setupTicks = timer.GetLapTicks();
+	TInt64 updateTicks = 0;
+	if (setupOK)
+	{
+		StartAllTanks();
+		for (TUInt32 tick = 1; tick <= run.numTicks; ++tick)
+		{
+			UpdateScene( run.updateTime );
+			if (tick == run.numTicks || (run.checkpointTicks && tick % run.checkpointTicks == 0))
+			{
+				updateTicks += timer.GetLapTicks();
+				SGoldenCheckpoint checkpoint = { tick, SceneStateHash() };
+				checkpoints->push_back( checkpoint );
+				timer.GetLapTicks();
+			}
+		}
+	}
+	SceneShutdown();
+	TInt64 shutdownTicks = timer.GetLapTicks();
+
+	SGoldenPhase setup = { "Setup", static_cast<TFloat32>(TicksToMilliseconds( setupTicks, timer.GetFrequency() )) };
+	SGoldenPhase update = { "Update", static_cast<TFloat32>(TicksToMilliseconds( updateTicks, timer.GetFrequency() )) };
+	SGoldenPhase shutdown = { "Shutdown", static_cast<TFloat32>(TicksToMilliseconds( shutdownTicks, timer.GetFrequency() )) };
+	phases->push_back( setup );
+	phases->push_back( update );
+	phases->push_back( shutdown );
+	return setupOK;
+}
+
+// Run each golden run in the given file headless and write the results to standard output. When
+// checking, a run fails if its state hash differs from the recorded one at any checkpoint - the
+// game's behaviour has changed - or if a phase is slower than recorded by more than the run's
+// maximum slowdown (and kGoldenMinSlowdownMs). When recording, the hashes and times measured
+// replace those in the file. Returns true if every run passed (or was recorded)
+bool RunGoldenSuite( const string& fileName, bool record )
+{
+	vector<SGoldenRun> runs;
+	CParseGoldenRuns parser;
+	string error;
+	if (!parser.LoadRuns( fileName, &runs, &error ))
+	{
+		cout << "Golden runs: " << error << endl;
+		return false;
+	}
+
+	cout << (record ? "Recording " : "Checking ") << runs.size() << " golden runs from " << fileName << endl;
+	cout << fixed << setprecision( 2 );
+	bool passed = true;
+	for (TUInt32 r = 0; r < runs.size(); ++r)
+	{
+		SGoldenRun& run = runs[r];
+		cout << run.name << ": " << run.numTanks << " tanks, " << run.numTicks << " updates of " << run.updateTime
+		     << "s, seed " << run.seed << endl;
+
+		vector<SGoldenCheckpoint> checkpoints;
+		vector<SGoldenPhase> phases;
+		if (!MeasureGoldenRun( run, &checkpoints, &phases ))
+		{
+			cout << "  FAILED: scene setup failed" << endl;
+			passed = false;
+			continue;
+		}
+		if (record)
+		{
+			run.checkpoints = checkpoints;
+			run.phases = phases;
+			for (TUInt32 p = 0; p < phases.size(); ++p)
+			{
+				cout << "  " << left << setw( 10 ) << phases[p].name << right << setw( 10 ) << phases[p].ms << " ms" << endl;
+			}
+			continue;
+		}
+
+		// Behaviour - every recorded checkpoint must be measured with the same hash, and no more
+		// measured - a different count means the run no longer matches its recording
+		if (run.checkpoints.empty())
+		{
+			cout << "  FAILED: not recorded (use -golden-record)" << endl;
+			passed = false;
+			continue;
+		}
+		if (checkpoints.size() != run.checkpoints.size())
+		{
+			cout << "  FAILED: " << checkpoints.size() << " checkpoints measured but " << run.checkpoints.size()
+			     << " recorded (Ticks or CheckpointTicks changed since recording?)" << endl;
+			passed = false;
+		}
+		TUInt32 matched = 0;
+		while (matched < run.checkpoints.size() && matched < checkpoints.size() &&
+		       run.checkpoints[matched].tick == checkpoints[matched].tick &&
+		       run.checkpoints[matched].hash == checkpoints[matched].hash)
+		{
+			++matched;
+		}
+		if (matched == run.checkpoints.size() && matched == checkpoints.size())
+		{
+			cout << "  Behaviour unchanged through " << run.checkpoints.back().tick << " updates" << endl;
+		}
+		else if (matched < run.checkpoints.size() && matched < checkpoints.size())
+		{
+			cout << "  FAILED: behaviour changed by update " << run.checkpoints[matched].tick << " (hash " << hex
+			     << run.checkpoints[matched].hash << " recorded, " << checkpoints[matched].hash << dec << " now)"
+			     << endl;
+			passed = false;
+		}
+
+		// Times - compared by phase name, phases not recorded are only shown
+		for (TUInt32 p = 0; p < phases.size(); ++p)
+		{
+			cout << "  " << left << setw( 10 ) << phases[p].name << right << setw( 10 ) << phases[p].ms << " ms";
+			TUInt32 recorded = 0;
+			while (recorded < run.phases.size() && run.phases[recorded].name != phases[p].name)
+			{
+				++recorded;
+			}
+			if (recorded == run.phases.size() || run.phases[recorded].ms <= 0.0f)
+			{
+				cout << endl;
+				continue;
+			}
+			TFloat32 recordedMs = run.phases[recorded].ms;
+			TFloat32 change = (phases[p].ms - recordedMs) * 100.0f / recordedMs;
+			cout << "  (recorded " << recordedMs << " ms, " << showpos << change << noshowpos << "%)";
+			if (change > run.maxSlowdown && phases[p].ms - recordedMs >= kGoldenMinSlowdownMs)
+			{
+				cout << "  FAILED: more than " << run.maxSlowdown << "% slower";
+				passed = false;
+			}
+			cout << endl;
+		}
+	}
+
+	if (record && !WriteGoldenRuns( fileName, runs ))
+	{
+		cout << "Cannot write " << fileName << endl;
+		return false;
+	}
+	cout << (record ? "Recorded" : (passed ? "PASSED" : "FAILED")) << endl;
+	return passed;
+}
+
+
 } // namespace gen
 
 
@@ -281,9 +619,63 @@ LRESULT WINAPI MsgProc( HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam )
     return DefWindowProc( hWnd, msg, wParam, lParam );
 }
 
-// Windows main function
-INT WINAPI WinMain( HINSTANCE hInst, HINSTANCE, LPSTR, INT )
+// Windows main function. Command line options:
+//   -headless      Update the scene with no window or rendering, then exit (see RunHeadless)
+//   -updates <n>   Number of updates for a headless run (default 1000)
+//   -dt <seconds>  Fixed update time for a headless run (default 1/60)
+//   -profile       Record profiler zones from startup. A headless run writes them out at the end,
+//                  otherwise F7 does (F6 turns recording on / off)
+//   -scaling       Run generated levels of increasing size headless (see RunScalingSuite), using
+//                  -updates (default 300 here) and -dt for each
+//   -teams <n>     Number of teams in the levels of a scaling run (default 2)
+//   -tanks <n>     Largest number of tanks in a scaling run (default 10000)
+//   -golden <file> Check the golden runs in the file (see RunGoldenSuite), exit code 1 if any fail
+//   -golden-record <file>  Run the golden runs in the file and record their hashes and times in it
+INT WINAPI WinMain( HINSTANCE hInst, HINSTANCE, LPSTR cmdLine, INT )
 {
+	GEN_PROFILE_THREAD( "Main" );
+
+	bool headless = false;
+	bool scaling = false;
+	gen::TUInt32 numUpdates = 0;
+	gen::TFloat32 updateTime = 1.0f / 60.0f;
+	gen::TUInt32 numTeams = 2;
+	gen::TUInt32 maxTanks = 10000;
+	string goldenFile;
+	bool goldenRecord = false;
+	istringstream options( cmdLine );
+	string option;
+	while (options >> option)
+	{
+		if      (option == "-headless") headless = true;
+		else if (option == "-updates")  options >> numUpdates;
+		else if (option == "-dt")       options >> updateTime;
+		else if (option == "-profile")  gen::Profiler.SetRecording( true );
+		else if (option == "-scaling")  scaling = true;
+		else if (option == "-teams")    options >> numTeams;
+		else if (option == "-tanks")    options >> maxTanks;
+		else if (option == "-golden")   options >> goldenFile;
+		else if (option == "-golden-record")
+		{
+			options >> goldenFile;
+			goldenRecord = true;
+		}
+	}
+	if (!goldenFile.empty())
+	{
+		return gen::RunGoldenSuite( goldenFile, goldenRecord ) ? 0 : 1;
+	}
+	if (scaling)
+	{
+		gen::RunScalingSuite( numUpdates ? numUpdates : 300, updateTime, numTeams, maxTanks );
+		return 0;
+	}
+	if (headless)
+	{
+		gen::RunHeadless( numUpdates ? numUpdates : 1000, updateTime );
+		return 0;
+	}
+
     // Register the window class
     WNDCLASSEX wc = { sizeof(WNDCLASSEX), CS_CLASSDC, MsgProc, 0L, 0L,
                       GetModuleHandle(NULL), LoadIcon( NULL, IDI_APPLICATION ),
@@ -302,6 +694,8 @@ INT WINAPI WinMain( HINSTANCE hInst, HINSTANCE, LPSTR, INT )
         // Prepare the scene
         if (gen::SceneSetup())
         {
+            OutputDebugStringA( gen::StartupReport().c_str() );
+
             // Show the window
             ShowWindow( hWnd, SW_SHOWDEFAULT );
             UpdateWindow( hWnd );
@@ -323,8 +717,12 @@ INT WINAPI WinMain( HINSTANCE hInst, HINSTANCE, LPSTR, INT )
 				{
 					// Render and update the scene - using variable timing
 					float updateTime = gen::Timer.GetLapTime();
+					gen::TickTimer.GetLapTime();
                     gen::RenderScene( updateTime );
+					gen::FrameStats.Record( gen::EFrameStat::Render, gen::TickTimer.GetLapTime() );
 					gen::UpdateScene( updateTime );
+					gen::FrameStats.Record( gen::EFrameStat::Update, gen::TickTimer.GetLapTime() );
+					gen::FrameStats.EndTick( updateTime );
 
 					// Toggle fullscreen / windowed
 					if (gen::KeyHit( gen::Key_F1 ))
@@ -343,6 +741,8 @@ INT WINAPI WinMain( HINSTANCE hInst, HINSTANCE, LPSTR, INT )
 				}
             }
         }
+	    OutputDebugStringA( gen::FrameStats.Report( true ).c_str() );
+	    OutputDebugStringA( gen::MemoryTracker.Report().c_str() );
 	    gen::SceneShutdown();
     }
 	gen::D3DShutdown();
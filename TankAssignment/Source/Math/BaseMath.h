@@ -22,7 +22,7 @@
 #include "../Common/Error.h"
 
 //TODO
-// Vectors: Hermite / Catmull-Rom, Lerp, Barycentric
+// Vectors: Hermite / Catmull-Rom, Barycentric
 // Matrices: ReflectioninPlane, shadow, transform plane
 // All: Packing, alignment, improve efficiency (SSE etc)
 
@@ -76,7 +76,7 @@ enum ERoundingMethod
 // Many versions provided here to allow mixing of parameter types for these basic functions
 
 inline TUInt32 Abs( const TInt32 x ) { return abs( static_cast<int>(x) ); }
-inline TUInt64 Abs( const TInt64 x ) { return _abs64( x ); }
+inline TUInt64 Abs( const TInt64 x ) { return llabs( x ); }
 inline TFloat32 Abs( const TFloat32 x ) { return fabsf( x ); }
 inline TFloat64 Abs( const TFloat64 x ) { return fabs( x ); }
 
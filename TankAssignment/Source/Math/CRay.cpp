@@ -1,25 +1,34 @@
 #include "CRay.h"
+#include "../Common/Profiler.h"
 
 gen::CRay::CRay(CEntityManager* entityManager)
 {
 	m_EntityManager = entityManager;
 }
 
-bool gen::CRay::HitBuilding(CVector3 origin, CVector3 direction, CVector3 target)
+bool gen::CRay::HitBuilding(const CVector3& origin, const CVector3& direction, const CVector3& target)
 {
-	if (Distance(origin, m_Building->Position()) - m_BuildingOuterSphere < Distance(origin, target))
+	GEN_PROFILE_ZONE("CRay::HitBuilding");
+
+	const CVector3& buildingPos = m_Building->Position();
+	if (Distance(origin, buildingPos) - m_BuildingOuterSphere < Distance(origin, target))
 	{
+		// one divide per axis, the slab distances below are then multiplies
+		const float invDirX = 1.0f / direction.x;
+		const float invDirY = 1.0f / direction.y;
+		const float invDirZ = 1.0f / direction.z;
+
 		// check on plane first
-		const float x1 = m_Building->Position().x + m_BuildingBounds[0], x2 = m_Building->Position().x + m_BuildingBounds[3];
-		const float y1 = m_Building->Position().y + m_BuildingBounds[1], y2 = m_Building->Position().y + m_BuildingBounds[4];
+		const float x1 = buildingPos.x + m_BuildingBounds[0], x2 = buildingPos.x + m_BuildingBounds[3];
+		const float y1 = buildingPos.y + m_BuildingBounds[1], y2 = buildingPos.y + m_BuildingBounds[4];
 
-		float tmin = (x1 - origin.x) / direction.x;
-		float tmax = (x2 - origin.x) / direction.x;
+		float tmin = (x1 - origin.x) * invDirX;
+		float tmax = (x2 - origin.x) * invDirX;
 		if (tmin > tmax)
 			swap(tmin, tmax);
 
-		float tymin = (y1 - origin.y) / direction.y;
-		float tymax = (y2 - origin.y) / direction.y;
+		float tymin = (y1 - origin.y) * invDirY;
+		float tymax = (y2 - origin.y) * invDirY;
 		if (tymin > tymax)
 			swap(tymin, tymax);
 
@@ -33,10 +42,10 @@ bool gen::CRay::HitBuilding(CVector3 origin, CVector3 direction, CVector3 target
 			tmax = tymax;
 
 		// add z to make cube
-		float z1 = m_Building->Position().z + m_BuildingBounds[2], z2 = m_Building->Position().z + m_BuildingBounds[5];
+		const float z1 = buildingPos.z + m_BuildingBounds[2], z2 = buildingPos.z + m_BuildingBounds[5];
 
-		float tzmin = (z1 - origin.z) / direction.z;
-		float tzmax = (z2 - origin.z) / direction.z;
+		float tzmin = (z1 - origin.z) * invDirZ;
+		float tzmax = (z2 - origin.z) * invDirZ;
 		if (tzmin > tzmax)
 			swap(tzmin, tzmax);
 		
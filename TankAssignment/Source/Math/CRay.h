@@ -21,7 +21,7 @@ private:
 	float m_BuildingOuterSphere;			// a sphere around the building for simple calucations
 public:
 	CRay(CEntityManager* entityManager);
-	bool HitBuilding(CVector3 origin, CVector3 direction, CVector3 target);
+	bool HitBuilding(const CVector3& origin, const CVector3& direction, const CVector3& target);
 	void Setup();	// Setup ray after map has loaded
 	~CRay();
 };
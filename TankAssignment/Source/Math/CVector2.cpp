@@ -60,24 +60,6 @@ void CVector2::Normalise()
 }
 
 
-// Return unit length vector in the same direction as given one
-CVector2 Normalise( const CVector2& v )
-{
-	TFloat32 lengthSq = v.x*v.x + v.y*v.y;
-
-	// Ensure vector is not zero length (use BaseMath.h float approx. fn with default epsilon)
-	if ( gen::IsZero( lengthSq ) )
-	{
-		return CVector2(0.0f, 0.0f);
-	}
-	else
-	{
-		TFloat32 invLength = InvSqrt( lengthSq );
-		return CVector2(v.x * invLength, v.y * invLength);
-	}
-}
-
-
 /*-----------------------------------------------------------------------------------------
 	Point related functions
 -----------------------------------------------------------------------------------------*/
@@ -102,33 +84,6 @@ TFloat32 CVector2::DistanceToSquared( const CVector2& p )
 }
 
 
-// Return distance from one point to another - non-member version
-TFloat32 Distance
-(
-	const CVector2& p1,
-	const CVector2& p2
-)
-{
-	TFloat32 distX = p1.x - p2.x;
-	TFloat32 distY = p1.y - p2.y;
-	return Sqrt( distX*distX + distY*distY );
-}
-
-// Return squared distance from one point to another - non-member version
-// More efficient than Distance when exact length is not required (e.g. for comparisons)
-// Use InvSqrt( DistanceSquared(...) ) to calculate 1 / distance more efficiently
-TFloat32 DistanceSquared
-(
-	const CVector2& p1,
-	const CVector2& p2
-)
-{
-	TFloat32 distX = p1.x - p2.x;
-	TFloat32 distY = p1.y - p2.y;
-	return distX*distX + distY*distY;
-}
-
-
 /*---------------------------------------------------------------------------------------------
 	Static constants
 ---------------------------------------------------------------------------------------------*/
@@ -83,20 +83,7 @@ public:
 	// Require explicit conversion from CVector4 (see above)
 
 
-	// Copy constructor
-    CVector2( const CVector2& v ) : x( v.x ), y( v.y )
-	{}
-
-	// Assignment operator
-    CVector2& operator=( const CVector2& v )
-	{
-		if ( this != &v )
-		{
-			x = v.x;
-			y = v.y;
-		}
-		return *this;
-	}
+	// Copy constructor and assignment are left to the compiler (see CVector3)
 
 
 	/*-----------------------------------------------------------------------------------------
@@ -450,6 +437,30 @@ inline CVector2 Cross3D
 	return CVector2(v1.y*v2.x - v1.x*v2.y, v1.x*v2.y - v1.y*v2.x);
 }
 
+// Return v1 + v2 * s in a single step. Use for offsets along a direction (e.g. a point ahead of
+// an entity: MultiplyAdd( position, facing, distance )) or movement (position, velocity, dt)
+inline CVector2 MultiplyAdd
+(
+	const CVector2& v1,
+	const CVector2& v2,
+	const TFloat32  s
+)
+{
+	return CVector2(v1.x + v2.x*s, v1.y + v2.y*s);
+}
+
+// Linear interpolation between two vectors: returns v1 when t = 0 and v2 when t = 1
+inline CVector2 Lerp
+(
+	const CVector2& v1,
+	const CVector2& v2,
+	const TFloat32  t
+)
+{
+	return CVector2(v1.x + (v2.x - v1.x)*t, v1.y + (v2.y - v1.y)*t);
+}
+
+
 /*-----------------------------------------------------------------------------------------
 	Non-Member Length operations
 -----------------------------------------------------------------------------------------*/
@@ -469,7 +480,21 @@ inline TFloat32 LengthSquared( const CVector2& v )
 }
 
 // Return unit length vector in the same direction as given one
-CVector2 Normalise( const CVector2& v );
+inline CVector2 Normalise( const CVector2& v )
+{
+	TFloat32 lengthSq = v.x*v.x + v.y*v.y;
+
+	// Ensure vector is not zero length (use BaseMath.h float approx. fn with default epsilon)
+	if ( gen::IsZero( lengthSq ) )
+	{
+		return CVector2(0.0f, 0.0f);
+	}
+	else
+	{
+		TFloat32 invLength = InvSqrt( lengthSq );
+		return CVector2(v.x * invLength, v.y * invLength);
+	}
+}
 
 
 /*-----------------------------------------------------------------------------------------
@@ -477,20 +502,30 @@ CVector2 Normalise( const CVector2& v );
 -----------------------------------------------------------------------------------------*/
 
 // Return distance from one point to another - non-member version
-TFloat32 Distance
+inline TFloat32 Distance
 (
 	const CVector2& p1,
 	const CVector2& p2
-);
+)
+{
+	TFloat32 distX = p1.x - p2.x;
+	TFloat32 distY = p1.y - p2.y;
+	return Sqrt( distX*distX + distY*distY );
+}
 
 // Return squared distance from one point to another - non-member version
 // More efficient than Distance when exact length is not required (e.g. for comparisons)
 // Use InvSqrt( DistanceSquared(...) ) to calculate 1 / distance more efficiently
-TFloat32 DistanceSquared
+inline TFloat32 DistanceSquared
 (
 	const CVector2& p1,
 	const CVector2& p2
-);
+)
+{
+	TFloat32 distX = p1.x - p2.x;
+	TFloat32 distY = p1.y - p2.y;
+	return distX*distX + distY*distY;
+}
 
 
 } // namespace gen
@@ -55,24 +55,6 @@ void CVector3::Normalise()
 }
 
 
-// Return unit length vector in the same direction as given one
-CVector3 Normalise( const CVector3& v )
-{
-	TFloat32 lengthSq = v.x*v.x + v.y*v.y + v.z*v.z;
-
-	// Ensure vector is not zero length (use BaseMath.h float approx. fn with default epsilon)
-	if ( gen::IsZero( lengthSq ) )
-	{
-		return CVector3(0.0f, 0.0f, 0.0f);
-	}
-	else
-	{
-		TFloat32 invLength = InvSqrt( lengthSq );
-		return CVector3(v.x * invLength, v.y * invLength, v.z * invLength);
-	}
-}
-
-
 /*-----------------------------------------------------------------------------------------
 	Point related functions
 -----------------------------------------------------------------------------------------*/
@@ -99,35 +81,6 @@ TFloat32 CVector3::DistanceToSquared( const CVector3& p )
 }
 
 
-// Return distance from one point to another - non-member version
-TFloat32 Distance
-(
-	const CVector3& p1,
-	const CVector3& p2
-)
-{
-	TFloat32 distX = p1.x - p2.x;
-	TFloat32 distY = p1.y - p2.y;
-	TFloat32 distZ = p1.z - p2.z;
-	return Sqrt( distX*distX + distY*distY + distZ*distZ );
-}
-
-// Return squared distance from one point to another - non-member version
-// More efficient than Distance when exact length is not required (e.g. for comparisons)
-// Use InvSqrt( DistanceSquared(...) ) to calculate 1 / distance more efficiently
-TFloat32 DistanceSquared
-(
-	const CVector3& p1,
-	const CVector3& p2
-)
-{
-	TFloat32 distX = p1.x - p2.x;
-	TFloat32 distY = p1.y - p2.y;
-	TFloat32 distZ = p1.z - p2.z;
-	return distX*distX + distY*distY + distZ*distZ;
-}
-
-
 /*---------------------------------------------------------------------------------------------
 	Static constants
 ---------------------------------------------------------------------------------------------*/
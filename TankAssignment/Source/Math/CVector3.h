@@ -90,21 +90,9 @@ public:
 	// Require explicit conversion from CVector4 (see above)
 
 
-	// Copy constructor, construct from CVector3
-    CVector3( const CVector3& v ) : x( v.x ), y( v.y ), z( v.z )
-	{}
-
-	// Assignment operator
-    CVector3& operator=( const CVector3& v )
-	{
-		if ( this != &v )
-		{
-			x = v.x;
-			y = v.y;
-			z = v.z;
-		}
-		return *this;
-	}
+	// Copy constructor and assignment are left to the compiler. This keeps the class trivially
+	// copyable so temporaries in vector expressions can stay in registers and loops over arrays
+	// of vectors can be vectorised (a user-defined assignment with a self-test prevents both)
 
 
 	/*-----------------------------------------------------------------------------------------
@@ -464,6 +452,29 @@ inline CVector3 Cross
 	return CVector3(v1.y*v2.z - v1.z*v2.y, v1.z*v2.x - v1.x*v2.z, v1.x*v2.y - v1.y*v2.x);
 }
 
+// Return v1 + v2 * s in a single step. Use for offsets along a direction (e.g. a point ahead of
+// an entity: MultiplyAdd( position, facing, distance )) or movement (position, velocity, dt)
+inline CVector3 MultiplyAdd
+(
+	const CVector3& v1,
+	const CVector3& v2,
+	const TFloat32  s
+)
+{
+	return CVector3(v1.x + v2.x*s, v1.y + v2.y*s, v1.z + v2.z*s);
+}
+
+// Linear interpolation between two vectors: returns v1 when t = 0 and v2 when t = 1
+inline CVector3 Lerp
+(
+	const CVector3& v1,
+	const CVector3& v2,
+	const TFloat32  t
+)
+{
+	return CVector3(v1.x + (v2.x - v1.x)*t, v1.y + (v2.y - v1.y)*t, v1.z + (v2.z - v1.z)*t);
+}
+
 
 /*-----------------------------------------------------------------------------------------
 	Non-Member Length operations
@@ -484,7 +495,21 @@ inline TFloat32 LengthSquared( const CVector3& v )
 }
 
 // Return unit length vector in the same direction as given one
-CVector3 Normalise( const CVector3& v );
+inline CVector3 Normalise( const CVector3& v )
+{
+	TFloat32 lengthSq = v.x*v.x + v.y*v.y + v.z*v.z;
+
+	// Ensure vector is not zero length (use BaseMath.h float approx. fn with default epsilon)
+	if ( gen::IsZero( lengthSq ) )
+	{
+		return CVector3(0.0f, 0.0f, 0.0f);
+	}
+	else
+	{
+		TFloat32 invLength = InvSqrt( lengthSq );
+		return CVector3(v.x * invLength, v.y * invLength, v.z * invLength);
+	}
+}
 
 
 /*-----------------------------------------------------------------------------------------
@@ -492,20 +517,32 @@ CVector3 Normalise( const CVector3& v );
 -----------------------------------------------------------------------------------------*/
 
 // Return distance from one point to another - non-member version
-TFloat32 Distance
+inline TFloat32 Distance
 (
 	const CVector3& p1,
 	const CVector3& p2
-);
+)
+{
+	TFloat32 distX = p1.x - p2.x;
+	TFloat32 distY = p1.y - p2.y;
+	TFloat32 distZ = p1.z - p2.z;
+	return Sqrt( distX*distX + distY*distY + distZ*distZ );
+}
 
 // Return squared distance from one point to another - non-member version
 // More efficient than Distance when exact length is not required (e.g. for comparisons)
 // Use InvSqrt( DistanceSquared(...) ) to calculate 1 / distance more efficiently
-TFloat32 DistanceSquared
+inline TFloat32 DistanceSquared
 (
 	const CVector3& p1,
 	const CVector3& p2
-);
+)
+{
+	TFloat32 distX = p1.x - p2.x;
+	TFloat32 distY = p1.y - p2.y;
+	TFloat32 distZ = p1.z - p2.z;
+	return distX*distX + distY*distY + distZ*distZ;
+}
 
 
 } // namespace gen
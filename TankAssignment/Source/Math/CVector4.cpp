@@ -42,24 +42,6 @@ void CVector4::Normalise()
 }
 
 
-// Return unit length vector in the same direction as given one - non-member function
-CVector4 Normalise( const CVector4& v )
-{
-	TFloat32 lengthSq = v.x*v.x + v.y*v.y + v.z*v.z + v.w*v.w;
-
-	// Ensure vector is not zero length (use BaseMath.h float approx. fn with default epsilon)
-	if ( gen::IsZero( lengthSq ) )
-	{
-		return CVector4(0.0f, 0.0f, 0.0f, 0.0f);
-	}
-	else
-	{
-		TFloat32 invLength = InvSqrt( lengthSq );
-		return CVector4(v.x * invLength, v.y * invLength, v.z * invLength, v.w * invLength);
-	}
-}
-
-
 /*---------------------------------------------------------------------------------------------
 	Static constants
 ---------------------------------------------------------------------------------------------*/
@@ -96,22 +96,7 @@ public:
 	// Require explicit conversion from CVector3 (see above)
 
 
-	// Copy constructor
-    CVector4( const CVector4& v ) : x( v.x ), y( v.y ), z( v.z ), w( v.w )
-	{}
-
-	// Assignment operator
-    CVector4& operator=( const CVector4& v )
-	{
-		if ( this != &v )
-		{
-			x = v.x;
-			y = v.y;
-			z = v.z;
-			w = v.w;
-		}
-		return *this;
-	}
+	// Copy constructor and assignment are left to the compiler (see CVector3)
 
 
 	/*-----------------------------------------------------------------------------------------
@@ -483,6 +468,30 @@ inline CVector4 Cross
 	                v1.w*v2.x - v1.x*v2.w, v1.x*v2.y - v1.y*v2.x);
 }
 
+// Return v1 + v2 * s in a single step. Use for offsets along a direction (e.g. a point ahead of
+// an entity: MultiplyAdd( position, facing, distance )) or movement (position, velocity, dt)
+inline CVector4 MultiplyAdd
+(
+	const CVector4& v1,
+	const CVector4& v2,
+	const TFloat32  s
+)
+{
+	return CVector4(v1.x + v2.x*s, v1.y + v2.y*s, v1.z + v2.z*s, v1.w + v2.w*s);
+}
+
+// Linear interpolation between two vectors: returns v1 when t = 0 and v2 when t = 1
+inline CVector4 Lerp
+(
+	const CVector4& v1,
+	const CVector4& v2,
+	const TFloat32  t
+)
+{
+	return CVector4(v1.x + (v2.x - v1.x)*t, v1.y + (v2.y - v1.y)*t,
+	                v1.z + (v2.z - v1.z)*t, v1.w + (v2.w - v1.w)*t);
+}
+
 
 /*-----------------------------------------------------------------------------------------
 	Non-Member Length operations
@@ -503,7 +512,21 @@ inline TFloat32 LengthSquared( const CVector4& v )
 }
 
 // Return unit length vector in the same direction as given one
-CVector4 Normalise( const CVector4& v );
+inline CVector4 Normalise( const CVector4& v )
+{
+	TFloat32 lengthSq = v.x*v.x + v.y*v.y + v.z*v.z + v.w*v.w;
+
+	// Ensure vector is not zero length (use BaseMath.h float approx. fn with default epsilon)
+	if ( gen::IsZero( lengthSq ) )
+	{
+		return CVector4(0.0f, 0.0f, 0.0f, 0.0f);
+	}
+	else
+	{
+		TFloat32 invLength = InvSqrt( lengthSq );
+		return CVector4(v.x * invLength, v.y * invLength, v.z * invLength, v.w * invLength);
+	}
+}
 
 
 
@@ -0,0 +1,246 @@
+/*******************************************
+	MeshCook.cpp
+
+	Offline mesh cooker. Imports X-Files with
+	the same pipeline as the game and writes
+	the cooked version beside each one (see
+	Render/MeshFile.h), which the game maps
+	directly instead of importing the X-File
+********************************************/
+
+#include <iostream>
+#include <vector>
+#include <string>
+using namespace std;
+
+#include "Defines.h"
+#include "Utility.h"
+#include "CImportXFile.h"
+#include "MeshFile.h"
+#include "MeshBounds.h"
+#include "MeshOptimiser.h"
+#include "MeshSimplifier.h"
+#include "RenderMethod.h"
+
+namespace gen
+{
+
+// Referred to by RenderMethod.cpp - the cooker never creates a device
+ID3D10Device* g_pd3dDevice = 0;
+
+// Folder for all texture and mesh files
+extern const string MediaFolder;
+
+
+//-----------------------------------------------------------------------------
+// Cooking
+//-----------------------------------------------------------------------------
+
+// Print the vertex cache efficiency of a sub-mesh (see MeshOptimiser.h), optionally with its
+// efficiency before optimisation for comparison
+void PrintCacheStats( TUInt32 subMesh, const SVertexCacheStats& stats, const SVertexCacheStats* before = 0 )
+{
+	cout << "  sub-mesh " << subMesh << ": " << stats.numFaces << " triangles, " << stats.numVertices << " vertices";
+	if (before)
+	{
+		cout << ", ACMR " << before->acmr << " -> " << stats.acmr << ", ATVR " << before->atvr << " -> " << stats.atvr << endl;
+	}
+	else
+	{
+		cout << ", ACMR " << stats.acmr << ", ATVR " << stats.atvr << endl;
+	}
+}
+
+// Cook a single X-File, writing the cooked file beside it. Files already cooked from the current
+// version of the X-File are skipped unless forced. Optionally prints the vertex cache efficiency
+// of each sub-mesh. Returns false on failure
+bool CookMesh( const string& sourceFileName, bool force, bool stats )
+{
+	string cookedFileName = CMeshFile::CookedFileName( sourceFileName );
+
+	TUInt64 sourceSize, sourceTime;
+	if (!GetFileStamp( sourceFileName, &sourceSize, &sourceTime ))
+	{
+		cout << sourceFileName << ": file not found" << endl;
+		return false;
+	}
+	if (!force)
+	{
+		CMeshFile existing;
+		if (existing.Open( cookedFileName ) &&
+		    existing.SourceSize() == sourceSize && existing.SourceTime() == sourceTime)
+		{
+			cout << sourceFileName << ": up to date" << endl;
+			for (TUInt32 subMesh = 0; stats && subMesh < existing.GetNumSubMeshes(); ++subMesh)
+			{
+				SSubMesh subMeshData;
+				existing.GetSubMesh( subMesh, &subMeshData, false );
+				PrintCacheStats( subMesh, AnalyseVertexCache( subMeshData ) );
+			}
+			return true;
+		}
+	}
+
+	// Run the import pipeline exactly as CMesh::Load does
+	CImportXFile importFile;
+	if (!importFile.IsXFile( sourceFileName ) || importFile.ImportFile( sourceFileName ) != kSuccess)
+	{
+		cout << sourceFileName << ": not a valid X-File" << endl;
+		return false;
+	}
+
+	vector<SMeshNode> nodes( importFile.GetNumNodes() );
+	for (TUInt32 node = 0; node < nodes.size(); ++node)
+	{
+		importFile.GetNode( node, &nodes[node] );
+	}
+
+	vector<SMeshMaterial> materials( importFile.GetNumMaterials() );
+	for (TUInt32 material = 0; material < materials.size(); ++material)
+	{
+		importFile.GetMaterial( material, &materials[material] );
+	}
+
+	// Tangents are calculated now for render methods that need them. Sub-meshes are optimised
+	// separately from the import to measure the improvement
+	vector<SSubMesh> subMeshes;
+	vector<SVertexCacheStats> statsBefore, statsAfter;
+	bool importOK = true;
+	TUInt32 numVertices = 0, numFaces = 0;
+	for (TUInt32 subMesh = 0; subMesh < importFile.GetNumSubMeshes(); ++subMesh)
+	{
+		bool needTangents = RenderMethodUsesTangents( importFile.GetSubMeshRenderMethod( subMesh ) );
+		SSubMesh subMeshData;
+		if (importFile.GetSubMesh( subMesh, &subMeshData, needTangents, false ) != kSuccess)
+		{
+			importOK = false;
+			break;
+		}
+		statsBefore.push_back( AnalyseVertexCache( subMeshData ) );
+		OptimiseSubMesh( &subMeshData );
+		statsAfter.push_back( AnalyseVertexCache( subMeshData ) );
+		subMeshes.push_back( subMeshData );
+		numVertices += subMeshData.numVertices;
+		numFaces += subMeshData.numFaces;
+		if (subMeshData.numVertices == 0)
+		{
+			importOK = false; // CMesh rejects empty sub-meshes
+		}
+	}
+
+	bool cookOK = false;
+	TUInt32 numLods = 1;
+	if (importOK && !nodes.empty() && !subMeshes.empty())
+	{
+		// Bounds calculated in the same way as CMesh::PreProcess, and levels of detail as
+		// CMesh::CreateLods, so the game need do neither when loading
+		vector<SMeshBounds> nodeBounds( nodes.size() ), subMeshBounds( subMeshes.size() );
+		SMeshBounds meshBounds;
+		vector<SSubMeshLod> subMeshLods;
+		SMeshLod lods[kiMaxMeshLods];
+		cookOK = CalculateMeshBounds( &subMeshes[0], static_cast<TUInt32>(subMeshes.size()),
+		                              static_cast<TUInt32>(nodes.size()), &subMeshBounds[0], &nodeBounds[0], &meshBounds );
+		if (cookOK)
+		{
+			numLods = SimplifyMesh( &subMeshes[0], static_cast<TUInt32>(subMeshes.size()), &subMeshLods, lods );
+			cookOK = CMeshFile::Write( cookedFileName, sourceSize, sourceTime, nodes, materials, subMeshes,
+			                           nodeBounds, subMeshBounds, meshBounds, numLods, subMeshLods );
+		}
+	}
+	for (TUInt32 subMesh = 0; subMesh < subMeshes.size(); ++subMesh)
+	{
+		delete[] subMeshes[subMesh].vertices;
+		delete[] subMeshes[subMesh].faces;
+		delete[] subMeshes[subMesh].largeFaces;
+	}
+
+	if (!cookOK)
+	{
+		cout << sourceFileName << ": failed to cook" << endl;
+		return false;
+	}
+	cout << sourceFileName << ": " << nodes.size() << " nodes, " << materials.size() << " materials, "
+	     << subMeshes.size() << " sub-meshes, " << numVertices << " vertices, " << numFaces << " triangles, "
+	     << numLods << " levels of detail" << endl;
+	for (TUInt32 subMesh = 0; stats && subMesh < subMeshes.size(); ++subMesh)
+	{
+		PrintCacheStats( subMesh, statsAfter[subMesh], &statsBefore[subMesh] );
+	}
+	return true;
+}
+
+// Cook all X-Files in a folder (not including sub-folders). Returns false if any fail
+bool CookFolder( const string& folder, bool force, bool stats )
+{
+	string path = folder;
+	if (!path.empty() && path[path.length() - 1] != '\\' && path[path.length() - 1] != '/')
+	{
+		path += '\\';
+	}
+
+	WIN32_FIND_DATAA findData;
+	HANDLE find = FindFirstFileA( (path + "*.x").c_str(), &findData );
+	if (find == INVALID_HANDLE_VALUE)
+	{
+		cout << path << ": no X-Files found" << endl;
+		return false;
+	}
+	bool allOK = true;
+	do
+	{
+		if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+		{
+			allOK = CookMesh( path + findData.cFileName, force, stats ) && allOK;
+		}
+	} while (FindNextFileA( find, &findData ));
+	FindClose( find );
+	return allOK;
+}
+
+
+} // namespace gen
+
+
+//-----------------------------------------------------------------------------
+// Main function - outside of namespace
+//-----------------------------------------------------------------------------
+
+// Command line: MeshCook [-force] [-stats] [file.x | folder]...
+//   Cooks the given X-Files and all X-Files in the given folders, or all X-Files in the media
+//   folder if none are given. Run from the folder containing the game executable
+//   -force   Cook files even if the cooked version is up to date
+//   -stats   Print the vertex cache efficiency (ACMR / ATVR) of each sub-mesh, before and after
+//            optimisation for files cooked
+// Returns non-zero if any file failed to cook
+int main( int argc, char* argv[] )
+{
+	bool force = false;
+	bool stats = false;
+	vector<string> targets;
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		string option = argv[arg];
+		if      (option == "-force") force = true;
+		else if (option == "-stats") stats = true;
+		else                         targets.push_back( option );
+	}
+	if (targets.empty())
+	{
+		targets.push_back( gen::MediaFolder );
+	}
+
+	bool allOK = true;
+	for (gen::TUInt32 target = 0; target < targets.size(); ++target)
+	{
+		DWORD attributes = GetFileAttributesA( targets[target].c_str() );
+		if (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY))
+		{
+			allOK = gen::CookFolder( targets[target], force, stats ) && allOK;
+		}
+		else
+		{
+			allOK = gen::CookMesh( targets[target], force, stats ) && allOK;
+		}
+	}
+	return allOK ? 0 : 1;
+}
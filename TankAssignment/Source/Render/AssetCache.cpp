@@ -0,0 +1,446 @@
+/*******************************************
+	AssetCache.cpp
+
+	Asset cache implementation
+********************************************/
+
+#include <algorithm>
+#include <d3dx10.h>
+
+#include "AssetCache.h"
+#include "MeshFile.h"
+#include "../Common/Utility.h"
+#include "../Common/CTimer.h"
+
+namespace gen
+{
+
+// Get reference to global variables from another source file
+extern ID3D10Device* g_pd3dDevice;
+
+// Folder for all texture and mesh files
+extern const string MediaFolder;
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+// Construct an empty cache that keeps the CPU copy of all mesh geometry and fully compresses
+// mesh vertices
+CAssetCache::CAssetCache()
+{
+	m_CpuDataSize = 0;
+	m_CpuDataBudget = ~static_cast<TUInt64>(0);
+	m_VertexCompression.positions = true;
+	m_VertexCompression.normals = true;
+	m_VertexCompression.textureCoords = true;
+	ResetStats();
+}
+
+// Release any assets still in the cache. Meshes first as they hold references to textures
+CAssetCache::~CAssetCache()
+{
+	while (!m_Meshes.empty())
+	{
+		CMeshHandle* mesh = *m_Meshes.begin();
+		mesh->m_RefCount = 1;
+		ReleaseMesh( mesh );
+	}
+	while (!m_Textures.empty())
+	{
+		STexture* texture = m_Textures.begin()->second;
+		texture->refCount = 1;
+		ReleaseTexture( texture->view );
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Meshes
+//-----------------------------------------------------------------------------
+
+// Get a handle to the given mesh file (relative to the media folder), with its layout loaded.
+// The geometry is loaded on first use as usual. Returns 0 if the mesh file can't be read.
+// Each successful call must be matched by a call to ReleaseMesh
+CMeshHandle* CAssetCache::AcquireMesh( const string& fileName )
+{
+	string path = NormalisePath( fileName );
+	CMeshHandle* mesh = FindMesh( path );
+	if (!mesh)
+	{
+		// Not known by this name, look for the same file under another name
+		TUInt64 contentHash;
+		bool hasContentHash = GetMeshHash( fileName, &contentHash );
+		if (hasContentHash)
+		{
+			mesh = FindMeshByContent( path, contentHash );
+			if (mesh)  ++m_Stats.contentMatches;
+		}
+
+		// New mesh
+		if (!mesh)
+		{
+			mesh = new CMeshHandle( fileName, this );
+			if (!mesh->LoadLayout())
+			{
+				++m_Stats.meshMisses;
+				delete mesh;
+				return 0;
+			}
+			mesh->m_ContentHash = contentHash;
+			mesh->m_HasContentHash = hasContentHash;
+			AddMesh( mesh, path );
+		}
+	}
+
+	// Meshes added by PrepareMeshes have no users yet, the first user counts as a miss
+	if (mesh->m_RefCount == 0) ++m_Stats.meshMisses;
+	else                       ++m_Stats.meshHits;
+	++mesh->m_RefCount;
+	return mesh;
+}
+
+// Release a handle from AcquireMesh. The mesh is destroyed when its last user releases it
+void CAssetCache::ReleaseMesh( CMeshHandle* mesh )
+{
+	if (!mesh || --mesh->m_RefCount > 0)
+	{
+		return;
+	}
+
+	RemoveEntries( m_MeshPaths, mesh );
+	if (mesh->m_HasContentHash)
+	{
+		m_MeshHashes.erase( mesh->m_ContentHash );
+	}
+	m_Meshes.erase( mesh );
+
+	// Stop tracking its CPU geometry if not already evicted
+	for (list<CMeshHandle*>::iterator cpuMesh = m_CpuDataMeshes.begin(); cpuMesh != m_CpuDataMeshes.end(); ++cpuMesh)
+	{
+		if (*cpuMesh == mesh)
+		{
+			m_CpuDataSize -= mesh->m_Mesh->CpuDataSize();
+			m_CpuDataMeshes.erase( cpuMesh );
+			break;
+		}
+	}
+
+	delete mesh; // Releases the mesh's textures back to this cache
+}
+
+
+// Add the layouts of the given mesh files (relative to the media folder) to the cache, without
+// acquiring them, so later calls to AcquireMesh for these files find them ready. The files are
+// read on the given thread pool (or this thread if 0). Meshes already in the cache are skipped, and
+// files that can't be read are left for AcquireMesh to report
+void CAssetCache::PrepareMeshes( const vector<string>& fileNames, CThreadPool* pool )
+{
+	// Each new path once only
+	vector<CMeshHandle*> newMeshes;
+	vector<string> newPaths;
+	for (TUInt32 file = 0; file < fileNames.size(); ++file)
+	{
+		string path = NormalisePath( fileNames[file] );
+		if (!FindMesh( path ) && find( newPaths.begin(), newPaths.end(), path ) == newPaths.end())
+		{
+			newMeshes.push_back( new CMeshHandle( fileNames[file], this ) );
+			newPaths.push_back( path );
+		}
+	}
+
+	// Reading each file only changes its own handle, so they can all be read at once
+	vector<TUInt8> layoutLoaded( newMeshes.size() );
+	auto prepareMesh = [&]( TUInt32 item )
+	{
+		CMeshHandle* mesh = newMeshes[item];
+		mesh->m_HasContentHash = GetMeshHash( mesh->FileName(), &mesh->m_ContentHash );
+		layoutLoaded[item] = mesh->LoadLayout();
+	};
+	TUInt32 numNewMeshes = static_cast<TUInt32>(newMeshes.size());
+	if (pool)
+	{
+		pool->ParallelFor( numNewMeshes, prepareMesh );
+	}
+	else
+	{
+		for (TUInt32 item = 0; item < numNewMeshes; ++item)
+		{
+			prepareMesh( item );
+		}
+	}
+
+	// Add to the cache in the original order, dropping any that turn out to be the same file as a
+	// mesh already added
+	for (TUInt32 item = 0; item < numNewMeshes; ++item)
+	{
+		CMeshHandle* mesh = newMeshes[item];
+		if (!layoutLoaded[item] || (mesh->m_HasContentHash && FindMeshByContent( newPaths[item], mesh->m_ContentHash )))
+		{
+			delete mesh;
+			continue;
+		}
+		AddMesh( mesh, newPaths[item] );
+	}
+}
+
+// Load the geometry of all meshes in use that are not loaded yet (requires a device). The mesh
+// files are imported on the given thread pool (or this thread if 0), then the DirectX resources and
+// textures are created on this thread. Optionally returns the time taken (seconds) by each of
+// these stages. Returns false if any mesh failed to load
+bool CAssetCache::LoadAllMeshes( CThreadPool* pool, TFloat32* importTime /*= 0*/, TFloat32* resourceTime /*= 0*/ )
+{
+	vector<CMeshHandle*> meshes;
+	for (set<CMeshHandle*>::iterator mesh = m_Meshes.begin(); mesh != m_Meshes.end(); ++mesh)
+	{
+		if ((*mesh)->m_RefCount > 0 && !(*mesh)->IsLoaded())
+		{
+			meshes.push_back( *mesh );
+		}
+	}
+	TUInt32 numMeshes = static_cast<TUInt32>(meshes.size());
+
+	// Meshes are imported in parallel where there are enough of them to occupy the pool. With
+	// fewer they are imported one at a time, each spreading its sub-meshes over the pool instead
+	CTimer timer;
+	auto importMesh = [&]( TUInt32 item )
+	{
+		meshes[item]->Import();
+	};
+	if (pool && numMeshes >= pool->NumThreads())
+	{
+		pool->ParallelFor( numMeshes, importMesh );
+	}
+	else
+	{
+		for (TUInt32 item = 0; item < numMeshes; ++item)
+		{
+			meshes[item]->Import( pool );
+		}
+	}
+	if (importTime) *importTime = timer.GetLapTime();
+
+	// Completes the imported meshes, retrying (and reporting) any that failed to import
+	bool success = true;
+	for (TUInt32 item = 0; item < numMeshes; ++item)
+	{
+		success = meshes[item]->Load() && success;
+	}
+	if (resourceTime) *resourceTime = timer.GetLapTime();
+
+	return success;
+}
+
+
+//-----------------------------------------------------------------------------
+// Textures
+//-----------------------------------------------------------------------------
+
+// Get the given texture file (relative to the media folder). Requires a device. Returns 0 if
+// the texture fails to load. Each successful call must be matched by a call to ReleaseTexture
+ID3D10ShaderResourceView* CAssetCache::AcquireTexture( const string& fileName )
+{
+	string path = NormalisePath( fileName );
+	map<string, STexture*>::iterator byPath = m_TexturePaths.find( path );
+	if (byPath != m_TexturePaths.end())
+	{
+		++m_Stats.textureHits;
+		++byPath->second->refCount;
+		return byPath->second->view;
+	}
+
+	// Not known by this name, look for the same file under another name
+	TUInt64 contentHash;
+	string fullFileName = MediaFolder + fileName;
+	bool hasContentHash = GetFileHash( fullFileName, &contentHash );
+	if (hasContentHash)
+	{
+		map<TUInt64, STexture*>::iterator byContent = m_TextureHashes.find( contentHash );
+		if (byContent != m_TextureHashes.end())
+		{
+			++m_Stats.textureHits;
+			++m_Stats.contentMatches;
+			++byContent->second->refCount;
+			m_TexturePaths[path] = byContent->second;
+			return byContent->second->view;
+		}
+	}
+
+	// New texture
+	++m_Stats.textureMisses;
+	ID3D10ShaderResourceView* view;
+	if (FAILED( D3DX10CreateShaderResourceViewFromFile( g_pd3dDevice, fullFileName.c_str(), NULL, NULL, &view, NULL ) ))
+	{
+		return 0;
+	}
+	STexture* texture = new STexture;
+	texture->view = view;
+	texture->refCount = 1;
+	texture->contentHash = contentHash;
+	texture->hasContentHash = hasContentHash;
+	m_Textures[view] = texture;
+	m_TexturePaths[path] = texture;
+	if (hasContentHash)
+	{
+		m_TextureHashes[contentHash] = texture;
+	}
+	return view;
+}
+
+// Release a texture from AcquireTexture. The texture is released when its last user releases it
+void CAssetCache::ReleaseTexture( ID3D10ShaderResourceView* view )
+{
+	map<ID3D10ShaderResourceView*, STexture*>::iterator entry = m_Textures.find( view );
+	if (entry == m_Textures.end())
+	{
+		return;
+	}
+	STexture* texture = entry->second;
+	if (--texture->refCount > 0)
+	{
+		return;
+	}
+
+	RemoveEntries( m_TexturePaths, texture );
+	if (texture->hasContentHash)
+	{
+		m_TextureHashes.erase( texture->contentHash );
+	}
+	m_Textures.erase( entry );
+	texture->view->Release();
+	delete texture;
+}
+
+
+//-----------------------------------------------------------------------------
+// CPU geometry eviction
+//-----------------------------------------------------------------------------
+
+// Set the total size of CPU geometry copies to keep - when exceeded, copies are released from the
+// meshes loaded longest ago. Evicts immediately if already over the budget
+void CAssetCache::SetCpuDataBudget( TUInt64 bytes )
+{
+	m_CpuDataBudget = bytes;
+	EvictCpuData();
+}
+
+// Called by a mesh handle from this cache when its mesh has been loaded
+void CAssetCache::MeshLoaded( CMeshHandle* mesh )
+{
+	m_CpuDataMeshes.push_back( mesh );
+	m_CpuDataSize += mesh->m_Mesh->CpuDataSize();
+	EvictCpuData();
+}
+
+// Release CPU geometry from the meshes loaded longest ago until within the budget
+void CAssetCache::EvictCpuData()
+{
+	while (m_CpuDataSize > m_CpuDataBudget && !m_CpuDataMeshes.empty())
+	{
+		CMesh* mesh = m_CpuDataMeshes.front()->m_Mesh;
+		m_CpuDataMeshes.pop_front();
+
+		TUInt32 size = mesh->CpuDataSize();
+		mesh->ReleaseCpuData();
+		m_CpuDataSize -= size;
+		++m_Stats.meshesEvicted;
+		m_Stats.bytesEvicted += size;
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Support functions
+//-----------------------------------------------------------------------------
+
+// Find a mesh in the cache by normalised path. Returns 0 if not found
+CMeshHandle* CAssetCache::FindMesh( const string& path )
+{
+	map<string, CMeshHandle*>::iterator byPath = m_MeshPaths.find( path );
+	return (byPath != m_MeshPaths.end()) ? byPath->second : 0;
+}
+
+// Find a mesh in the cache by content hash, adding the given path for it if found - the same file
+// under another name. Returns 0 if not found. Not counted as a content match, the caller counts it
+// if the mesh is handed out
+CMeshHandle* CAssetCache::FindMeshByContent( const string& path, TUInt64 contentHash )
+{
+	map<TUInt64, CMeshHandle*>::iterator byContent = m_MeshHashes.find( contentHash );
+	if (byContent == m_MeshHashes.end())
+	{
+		return 0;
+	}
+	m_MeshPaths[path] = byContent->second;
+	return byContent->second;
+}
+
+// Add a new mesh, with its layout loaded and content hash set, to the cache under the given path
+void CAssetCache::AddMesh( CMeshHandle* mesh, const string& path )
+{
+	m_Meshes.insert( mesh );
+	m_MeshPaths[path] = mesh;
+	if (mesh->m_HasContentHash)
+	{
+		m_MeshHashes[mesh->m_ContentHash] = mesh;
+	}
+}
+
+// Get the content hash of a mesh file (relative to the media folder). Uses the cooked file if the
+// mesh is only available cooked. Returns false if neither can be read
+bool CAssetCache::GetMeshHash( const string& fileName, TUInt64* contentHash )
+{
+	string fullFileName = MediaFolder + fileName;
+	return GetFileHash( fullFileName, contentHash ) ||
+	       GetFileHash( CMeshFile::CookedFileName( fullFileName ), contentHash );
+}
+
+void CAssetCache::ResetStats()
+{
+	m_Stats.meshHits = 0;
+	m_Stats.meshMisses = 0;
+	m_Stats.textureHits = 0;
+	m_Stats.textureMisses = 0;
+	m_Stats.contentMatches = 0;
+	m_Stats.meshesEvicted = 0;
+	m_Stats.bytesEvicted = 0;
+}
+
+// Get the geometry memory used by all loaded meshes, see CMesh::GetMemoryUsage
+SMeshMemory CAssetCache::GetMeshMemory()
+{
+	SMeshMemory total = { 0, 0, 0, 0, 0, 0 };
+	for (set<CMeshHandle*>::iterator mesh = m_Meshes.begin(); mesh != m_Meshes.end(); ++mesh)
+	{
+		if (!(*mesh)->IsLoaded())  continue;
+		SMeshMemory memory = (*mesh)->Get()->GetMemoryUsage();
+		total.gpuVertices += memory.gpuVertices;
+		total.gpuVerticesFull += memory.gpuVerticesFull;
+		total.gpuIndices += memory.gpuIndices;
+		total.cpuVertices += memory.cpuVertices;
+		total.cpuVerticesFull += memory.cpuVerticesFull;
+		total.cpuIndices += memory.cpuIndices;
+	}
+	return total;
+}
+
+// Remove all entries for the given asset from a path or content map
+template <class TMap, class TAsset>
+void CAssetCache::RemoveEntries( TMap& entries, TAsset asset )
+{
+	typename TMap::iterator entry = entries.begin();
+	while (entry != entries.end())
+	{
+		if (entry->second == asset)
+		{
+			entries.erase( entry++ );
+		}
+		else
+		{
+			++entry;
+		}
+	}
+}
+
+
+} // namespace gen
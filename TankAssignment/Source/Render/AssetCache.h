@@ -0,0 +1,218 @@
+/*******************************************
+	AssetCache.h
+
+	Shares meshes and textures between their
+	users so each file is loaded only once.
+	Assets are found by file path, or failing
+	that by file contents, and are released
+	when their last user releases them
+********************************************/
+
+#pragma once
+
+#include <map>
+#include <list>
+#include <set>
+#include <vector>
+#include <string>
+using namespace std;
+
+#include <d3d10.h>
+
+#include "../Common/Defines.h"
+#include "../Common/CThreadPool.h"
+#include "MeshHandle.h"
+
+namespace gen
+{
+
+// Counts of cache activity since the cache was created or the stats were reset
+struct SAssetCacheStats
+{
+	TUInt32 meshHits;        // Mesh requests given a mesh that was already in the cache
+	TUInt32 meshMisses;      // Mesh requests that created a new mesh
+	TUInt32 textureHits;     // Same for textures
+	TUInt32 textureMisses;
+	TUInt32 contentMatches;  // Hits found by file contents - the same file under another name
+	TUInt32 meshesEvicted;   // Meshes whose CPU copy of their geometry has been released
+	TUInt64 bytesEvicted;    // Total size of the geometry released
+};
+
+
+class CAssetCache
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Construct an empty cache that keeps the CPU copy of all mesh geometry and fully compresses
+	// mesh vertices
+	CAssetCache();
+
+	// Release any assets still in the cache
+	~CAssetCache();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CAssetCache( const CAssetCache& );
+	CAssetCache& operator=( const CAssetCache& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Meshes
+
+	// Get a handle to the given mesh file (relative to the media folder), with its layout loaded.
+	// The geometry is loaded on first use as usual. Returns 0 if the mesh file can't be read.
+	// Each successful call must be matched by a call to ReleaseMesh
+	CMeshHandle* AcquireMesh( const string& fileName );
+
+	// Release a handle from AcquireMesh. The mesh is destroyed when its last user releases it
+	void ReleaseMesh( CMeshHandle* mesh );
+
+	// Add the layouts of the given mesh files (relative to the media folder) to the cache, without
+	// acquiring them, so later calls to AcquireMesh for these files find them ready. The files are
+	// read on the given thread pool (or this thread if 0)
+	void PrepareMeshes( const vector<string>& fileNames, CThreadPool* pool );
+
+	// Load the geometry of all meshes in use that are not loaded yet (requires a device). The mesh
+	// files are imported on the given thread pool (or this thread if 0), then the DirectX resources
+	// and textures are created on this thread. Optionally returns the time taken (seconds) by each
+	// of these stages. Returns false if any mesh failed to load
+	bool LoadAllMeshes( CThreadPool* pool, TFloat32* importTime = 0, TFloat32* resourceTime = 0 );
+
+
+	// Set the compression of the vertices of meshes loaded from now on (see VertexCompression.h)
+	void SetVertexCompression( const SVertexCompression& compression )
+	{
+		m_VertexCompression = compression;
+	}
+	const SVertexCompression& GetVertexCompression()
+	{
+		return m_VertexCompression;
+	}
+
+
+	/////////////////////////////////////
+	// Textures
+
+	// Get the given texture file (relative to the media folder). Requires a device. Returns 0 if
+	// the texture fails to load. Each successful call must be matched by a call to ReleaseTexture
+	ID3D10ShaderResourceView* AcquireTexture( const string& fileName );
+
+	// Release a texture from AcquireTexture. The texture is released when its last user releases it
+	void ReleaseTexture( ID3D10ShaderResourceView* texture );
+
+
+	/////////////////////////////////////
+	// CPU geometry eviction
+
+	// Meshes keep a CPU copy of their geometry after it has been sent to the GPU, for triangle and
+	// vertex enumeration. Set the total size of these copies to keep - when exceeded, copies are
+	// released from the meshes loaded longest ago. Evicts immediately if already over the budget
+	void SetCpuDataBudget( TUInt64 bytes );
+
+	// Total size of the CPU geometry currently held by loaded meshes
+	TUInt64 CpuDataSize()
+	{
+		return m_CpuDataSize;
+	}
+
+
+	/////////////////////////////////////
+	// Statistics
+
+	const SAssetCacheStats& GetStats()
+	{
+		return m_Stats;
+	}
+
+	void ResetStats();
+
+	// Get the geometry memory used by all loaded meshes, see CMesh::GetMemoryUsage
+	SMeshMemory GetMeshMemory();
+
+	// Number of distinct meshes / textures in the cache
+	TUInt32 NumMeshes()
+	{
+		return static_cast<TUInt32>(m_Meshes.size());
+	}
+	TUInt32 NumTextures()
+	{
+		return static_cast<TUInt32>(m_Textures.size());
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	/////////////////////////////////////
+	// Types
+
+	// A cached texture and the number of users it has
+	struct STexture
+	{
+		ID3D10ShaderResourceView* view;
+		TUInt32                   refCount;
+		TUInt64                   contentHash;
+		bool                      hasContentHash;
+	};
+
+
+	/////////////////////////////////////
+	// Support functions
+
+	// Called by a mesh handle from this cache when its mesh has been loaded
+	friend class CMeshHandle;
+	void MeshLoaded( CMeshHandle* mesh );
+
+	// Release CPU geometry from the meshes loaded longest ago until within the budget
+	void EvictCpuData();
+
+	// Find a mesh in the cache by normalised path, or by content hash (adding the path for it).
+	// Return 0 if not found
+	CMeshHandle* FindMesh( const string& path );
+	CMeshHandle* FindMeshByContent( const string& path, TUInt64 contentHash );
+
+	// Add a new mesh, with its layout loaded and content hash set, to the cache under the given path
+	void AddMesh( CMeshHandle* mesh, const string& path );
+
+	// Get the content hash of a mesh file (relative to the media folder). Uses the cooked file if
+	// the mesh is only available cooked. Returns false if neither can be read
+	static bool GetMeshHash( const string& fileName, TUInt64* contentHash );
+
+	// Remove all entries for the given asset from a path or content map
+	template <class TMap, class TAsset>
+	static void RemoveEntries( TMap& entries, TAsset asset );
+
+
+	/////////////////////////////////////
+	// Data
+
+	// All meshes in the cache, and the same meshes by normalised path (several paths may refer to
+	// one mesh) and by content hash. Each mesh handle holds its own reference count
+	set<CMeshHandle*>          m_Meshes;
+	map<string, CMeshHandle*>  m_MeshPaths;
+	map<TUInt64, CMeshHandle*> m_MeshHashes;
+
+	// Textures in the same way, all textures are held by the texture itself to find them on release
+	map<ID3D10ShaderResourceView*, STexture*> m_Textures;
+	map<string, STexture*>                    m_TexturePaths;
+	map<TUInt64, STexture*>                   m_TextureHashes;
+
+	// Loaded meshes still holding CPU geometry, in the order loaded, and the total size held
+	list<CMeshHandle*> m_CpuDataMeshes;
+	TUInt64            m_CpuDataSize;
+	TUInt64            m_CpuDataBudget;
+
+	// Compression of the vertices of meshes as they are loaded
+	SVertexCompression m_VertexCompression;
+
+	SAssetCacheStats   m_Stats;
+};
+
+
+} // namespace gen
@@ -12,21 +12,45 @@
 **************************************************************************************************/
 
 #include <algorithm>
-#include <numeric>
+#include <cstring>
 using namespace std;
 
-#define INITGUID
-#include <windows.h>
-#include <dxfile.h>
-#include <rmxfguid.h>
-#include <rmxftmpl.h>
-
 #include "../Common/Error.h"
 #include "CImportXFile.h"
+#include "MeshOptimiser.h"
+#include "RenderMethod.h"
 
 namespace gen
 {
 
+/*-----------------------------------------------------------------------------------------
+	Local helpers
+-----------------------------------------------------------------------------------------*/
+
+// Marks entries in index maps and hash tables that have not been set
+static const TUInt32 kUnusedIndex = 0xffffffff;
+
+// Hash of a pair of indices, for tables with power of 2 sizes (well mixed low bits)
+static TUInt32 HashIndexPair( const TUInt32 iA, const TUInt32 iB )
+{
+	TUInt32 iHash = iA * 0x9e3779b1 ^ iB * 0x85ebca77;
+	return iHash ^ (iHash >> 15);
+}
+
+// Continue a hash over the bit patterns of some floats
+static TUInt32 HashFloats( const TFloat32* pfValues, const TUInt32 iNumValues, TUInt32 iHash )
+{
+	for (TUInt32 i = 0; i < iNumValues; ++i)
+	{
+		TUInt32 iBits;
+		memcpy( &iBits, &pfValues[i], sizeof(iBits) );
+		iHash = (iHash ^ iBits) * 0x01000193;
+		iHash ^= iHash >> 13;
+	}
+	return iHash ^ (iHash >> 16);
+}
+
+
 /*-----------------------------------------------------------------------------------------
 	CImportXFile public member functions
 -----------------------------------------------------------------------------------------*/
@@ -69,9 +93,9 @@ bool CImportXFile::IsXFile
 // Possible return values:
 //		kSuccess:			...
 //		kFileError:			Missing file or not an X-file
-//		kInvalidData:		The file could not be parsed correctly, or contains invalid data
+//		kInvalidData:		The file could not be parsed correctly, or contains invalid data.
+//						Compressed X-files are not supported
 //		kOutOfSystemMemory:	...
-//		kSystemFailure:		X-file API failure
 EImportError CImportXFile::ImportFile
 (
 	const string& sFileName
@@ -90,29 +114,15 @@ EImportError CImportXFile::ImportFile
 		return kFileError;
 	}
 
-	// Create X-File object
-	ID3DXFile* pXFile;
-	EImportError eError = PrepareXFileObject( &pXFile );
-	if (eError != kSuccess)
-	{
-		return eError;
-	}
-
-	// Get X-File enumerator
-	ID3DXFileEnumObject* pXFileEnumer;
-	eError = GetXFileEnumerator( sFileName, pXFile, &pXFileEnumer );
-	if (eError != kSuccess)
+	// Map the file for parsing in place - compressed X-files are not supported
+	CXFileParser parser;
+	if (!parser.Open( sFileName ))
 	{
-		pXFile->Release();
-		return eError;
+		return kInvalidData;
 	}
 
 	// Parse X file to create frame hierachy and meshes
-	eError = ParseXFile( pXFileEnumer );
-
-	// Release X-File interfaces
-	pXFileEnumer->Release();
-	pXFile->Release();
+	EImportError eError = ParseXFile( &parser );
 
 	// Check for errors
 	if (eError != kSuccess)
@@ -166,7 +176,8 @@ ERenderMethod CImportXFile::GetSubMeshRenderMethod( const TUInt32 iSubMesh ) con
 
 
 // Get the specification and data for given sub-mesh, returned through a pointer. May request
-// tangents to be calculated
+// tangents to be calculated. Faces and vertices are reordered for rendering unless not required.
+// Sub-meshes with more vertices than 16-bit indices can address are returned with large faces
 // Possible return values:
 //		kSuccess:			...
 //		kOutOfSystemMemory:	...
@@ -174,7 +185,8 @@ EImportError CImportXFile::GetSubMesh
 (
 	const TUInt32 iSubMesh,
 	SSubMesh*     pOutSubMesh,
-	bool          bTangents /*= false*/
+	bool          bTangents /*= false*/,
+	bool          bOptimise /*= true*/
 ) const
 {
 	GEN_GUARD;
@@ -318,9 +330,18 @@ EImportError CImportXFile::GetSubMesh
 		}
 	}
 
-	// Pre-size face array
+	// Pre-size face array - 32-bit indices if there are too many vertices for 16-bit ones
 	pOutSubMesh->numFaces = static_cast<TUInt32>(m_Meshes[iSubMesh].faces.size());
-	pOutSubMesh->faces = new SMeshFace[pOutSubMesh->numFaces];
+	pOutSubMesh->faces = 0;
+	pOutSubMesh->largeFaces = 0;
+	if (pOutSubMesh->numVertices > kiMaxSmallFaceVertices)
+	{
+		pOutSubMesh->largeFaces = new SMeshLargeFace[pOutSubMesh->numFaces];
+	}
+	else
+	{
+		pOutSubMesh->faces = new SMeshFace[pOutSubMesh->numFaces];
+	}
 
 	// Get material from material map (all faces in sub-mesh have the same material at this point)
 	pOutSubMesh->material = m_Meshes[iSubMesh].materialMap.front();
@@ -330,12 +351,26 @@ EImportError CImportXFile::GetSubMesh
 	TXFileFaces::const_iterator itFaceEnd = m_Meshes[iSubMesh].faces.end();
 	for (TUInt32 iFace = 0; iFace < pOutSubMesh->numFaces; ++iFace)
 	{
-		pOutSubMesh->faces[iFace].aiVertex[0] = itFace->aiVertex[0];
-		pOutSubMesh->faces[iFace].aiVertex[1] = itFace->aiVertex[1];
-		pOutSubMesh->faces[iFace].aiVertex[2] = itFace->aiVertex[2];
+		for (TUInt32 iIndex = 0; iIndex < 3; ++iIndex)
+		{
+			if (pOutSubMesh->largeFaces)
+			{
+				pOutSubMesh->largeFaces[iFace].aiVertex[iIndex] = itFace->aiVertex[iIndex];
+			}
+			else
+			{
+				pOutSubMesh->faces[iFace].aiVertex[iIndex] = static_cast<TUInt16>(itFace->aiVertex[iIndex]);
+			}
+		}
 		++itFace;
 	}
 
+	// Reorder for the GPU's vertex cache and fetch
+	if (bOptimise)
+	{
+		OptimiseSubMesh( pOutSubMesh );
+	}
+
 	return kSuccess;
 
 	GEN_ENDGUARD;
@@ -399,127 +434,6 @@ void CImportXFile::GetMaterial
 }
 
 
-/*-----------------------------------------------------------------------------------------
-	X-File API support
------------------------------------------------------------------------------------------*/
-
-// Prepare and return an X-file object
-// Possible return values:
-//		kSuccess:			...
-//		kOutOfSystemMemory:	...
-//		kSystemFailure:		Problem registering X-file templates or other API error
-EImportError CImportXFile::PrepareXFileObject
-(
-	ID3DXFile** ppXFile
-)
-{
-	GEN_GUARD;
-
-	HRESULT xFileError = D3DXFileCreate( ppXFile );
-	if (xFileError != S_OK)
-	{
-		*ppXFile = 0;
-		switch (xFileError)
-		{
-		case E_OUTOFMEMORY:
-			return kOutOfSystemMemory;
-
-		case E_POINTER:
-			GEN_ERROR( "Invalid parameter to D3DXFileCreate" );
-
-		default:
-			return kSystemFailure;
-		}
-	}
-
-    // Register templates for d3drm, skinning and patch extensions.
-    xFileError = (*ppXFile)->RegisterTemplates( (void*)D3DRM_XTEMPLATES, D3DRM_XTEMPLATE_BYTES );
-	if (xFileError != S_OK)
-	{
-        (*ppXFile)->Release();
-		*ppXFile = 0;
-		switch (xFileError)
-		{
-		case D3DXFERR_BADVALUE: 
-			GEN_ERROR( "Invalid parameter to RegisterTemplates" );
-
-		default:
-			return kSystemFailure;
-		}
-    }
-
-    xFileError = (*ppXFile)->RegisterTemplates( (void*)XSKINEXP_TEMPLATES, strlen(XSKINEXP_TEMPLATES) );
-	if (xFileError != S_OK)
-	{
-        (*ppXFile)->Release();
-		switch (xFileError)
-		{
-		case D3DXFERR_BADVALUE:
-			GEN_ERROR( "Invalid parameter to RegisterTemplates" );
-
-		default:
-			return kSystemFailure;
-		}
-    }
-
-    xFileError = (*ppXFile)->RegisterTemplates( (void*)XEXTENSIONS_TEMPLATES, strlen(XEXTENSIONS_TEMPLATES) );
-	if (xFileError != S_OK)
-	{
-        (*ppXFile)->Release();
-		*ppXFile = 0;
-		switch (xFileError)
-		{
-		case D3DXFERR_BADVALUE:
-			GEN_ERROR( "Invalid parameter to RegisterTemplates" );
-
-		default:
-			return kInvalidData;
-		}
-    }
-
-	return kSuccess;
-
-	GEN_ENDGUARD;
-}
-
-
-// Prepare and return an X-file enumerator given a filename and an X-file object
-// Possible return values:
-//		kSuccess:			...
-//		kInvalidData:		The file could not be parsed correctly, or contains invalid data
-//		kSystemFailure:		X-file API error
-EImportError CImportXFile::GetXFileEnumerator
-(
-	const string&         sFilename,
-	ID3DXFile*            pXFile,
-	ID3DXFileEnumObject** ppXFileEnumer
-)
-{
-	GEN_GUARD;
-
-	HRESULT xFileError =
-		pXFile->CreateEnumObject( (LPVOID)sFilename.c_str(), DXFILELOAD_FROMFILE, ppXFileEnumer );
-	if (xFileError != S_OK)
-	{
-		switch (xFileError)
-		{
-		case D3DXFERR_PARSEERROR:
-			return kInvalidData;
-
-		case D3DXFERR_BADVALUE:
-			GEN_ERROR( "Invalid parameter to CreateEnumObject" );
-
-		default:
-			return kSystemFailure;
-		}
-	}
-
-	return kSuccess;
-
-	GEN_ENDGUARD;
-}
-
-
 /*-----------------------------------------------------------------------------------------
 	X-File parsing
 -----------------------------------------------------------------------------------------*/
@@ -531,7 +445,7 @@ EImportError CImportXFile::GetXFileEnumerator
 //		kInvalidData:		The file could not be parsed correctly, or contains invalid data
 EImportError CImportXFile::ParseXFile
 (
-	ID3DXFileEnumObject* pXFileEnumer
+	CXFileParser* pParser
 )
 {
 	GEN_GUARD;
@@ -547,63 +461,56 @@ EImportError CImportXFile::ParseXFile
 	m_Frames[0].defaultMatrix = CMatrix4x4::kIdentity;
 	m_Frames[0].offsetMatrix = CMatrix4x4::kIdentity;
 
-	// Get number of child objects for the current object
-	TUInt32 iNumChildren;
-	EImportError eError = GetXFileNumChildren( pXFileEnumer, &iNumChildren );
-	if (eError != kSuccess)
+	// For each top level object
+	SXFileObject child;
+	while (pParser->NextObject( &child ))
 	{
-		return kInvalidData;
-	}
+		EImportError eError = kSuccess;
 
-	// For each child object
-	for (TUInt32 iChild = 0; iChild < iNumChildren; ++iChild)
-	{
-		// Get child data and ID
-		ID3DXFileData* pChildData;
-		GUID childGUID;
-		eError = GetXFileChild( pXFileEnumer, iChild, &pChildData, &childGUID );
-		if (eError != kSuccess)
-		{
-			return kInvalidData;
-		}
-		
 		// Found child frame
-		if (childGUID == TID_D3DRMFrame)
+		if (child.IsType( "Frame" ))
 		{
 			++m_Frames[0].iNumChildren;
-			eError = ParseXFileFrame( pChildData, 0 );
+			eError = ParseXFileFrame( pParser, child, 0 );
 		}
 
 		// Found child frame transformation matrix
-		else if (childGUID == TID_D3DRMFrameTransformMatrix)
+		else if (child.IsType( "FrameTransformMatrix" ))
 		{
-			CMatrix4x4 transMat;
-			TUInt32 iSize = 16 * sizeof(TFloat32);
-			TUInt8* pDest = reinterpret_cast<TUInt8*>(&m_Frames[0].defaultMatrix.e00);
-			eError = CopyXFileData( pChildData, pDest, &iSize );
+			if (!pParser->ReadFloats( &m_Frames[0].defaultMatrix.e00, 16 ))
+			{
+				eError = kInvalidData;
+			}
 		}
 
 		// Found child mesh
-		else if (childGUID == TID_D3DRMMesh)
+		else if (child.IsType( "Mesh" ))
 		{
-			eError = ParseXFileMesh( pChildData, 0 );
+			eError = ParseXFileMesh( pParser, 0 );
 		}
 
-		// Release current child data before moving to the next or quiting on error
-		pChildData->Release();
+		// Skip anything not read above before moving to the next child
+		if (eError == kSuccess && !pParser->EndObject( child ))
+		{
+			eError = kInvalidData;
+		}
 
 		// Return any errors found
 		if (eError != kSuccess)
 		{
 			return eError;
 		}
-	}		
+	}
+	if (pParser->HasFailed())
+	{
+		return kInvalidData;
+	}
 
 	// Make a single global material list for all meshes
 	MakeGlobalMaterialList();
 	
 	// Validate bones and match them to their frames
-	eError = ProcessBones();
+	EImportError eError = ProcessBones();
 	if (eError != kSuccess)
 	{
 		return eError;
@@ -622,8 +529,9 @@ EImportError CImportXFile::ParseXFile
 //		kInvalidData:		The file could not be parsed correctly, or contains invalid data
 EImportError CImportXFile::ParseXFileFrame
 (
-	ID3DXFileData* pXFileData,
-	const TUInt32  iParentFrame
+	CXFileParser*       pParser,
+	const SXFileObject& frame,
+	const TUInt32       iParentFrame
 )
 {
 	GEN_GUARD;
@@ -632,71 +540,58 @@ EImportError CImportXFile::ParseXFileFrame
 	TUInt32 iCurrFrame = static_cast<TUInt32>(m_Frames.size());
 	m_Frames.push_back( SXFileFrame() );
 
-	// Get name for frame
-	EImportError eError = GetXFileDataName( pXFileData, m_Frames[iCurrFrame].sName );
-	if (eError != kSuccess)
-	{
-		return eError;
-	}
-
-	// Initialise other frame values
+	// Initialise frame values
+	m_Frames[iCurrFrame].sName = frame.Name();
 	m_Frames[iCurrFrame].iDepth = m_Frames[iParentFrame].iDepth + 1;
 	m_Frames[iCurrFrame].iParentIndex = iParentFrame;
 	m_Frames[iCurrFrame].iNumChildren = 0;
 	m_Frames[iCurrFrame].defaultMatrix = CMatrix4x4::kIdentity;
 	m_Frames[iCurrFrame].offsetMatrix = CMatrix4x4::kIdentity;
 
-	// Get number of child objects for the current object
-	TUInt32 iNumChildren;
-	eError = GetXFileNumChildren( pXFileData, &iNumChildren );
-	if (eError != kSuccess)
-	{
-		return kInvalidData;
-	}
-
 	// For each child object
-	for (TUInt32 iChild = 0; iChild < iNumChildren; ++iChild)
+	SXFileObject child;
+	while (pParser->NextObject( &child ))
 	{
-		// Get child data and ID
-		ID3DXFileData* pChildData;
-		GUID childGUID;
-		eError = GetXFileChild( pXFileData, iChild, &pChildData, &childGUID );
-		if (eError != kSuccess)
-		{
-			return kInvalidData;
-		}
-		
+		EImportError eError = kSuccess;
+
 		// Found child frame
-		if (childGUID == TID_D3DRMFrame)
+		if (child.IsType( "Frame" ))
 		{
 			++m_Frames[iCurrFrame].iNumChildren;
-			eError = ParseXFileFrame( pChildData, iCurrFrame );
+			eError = ParseXFileFrame( pParser, child, iCurrFrame );
 		}
 
 		// Found child frame transformation matrix
-		else if (childGUID == TID_D3DRMFrameTransformMatrix)
+		else if (child.IsType( "FrameTransformMatrix" ))
 		{
-			CMatrix4x4 transMat;
-			TUInt32 iSize = 16 * sizeof(TFloat32);
-			TUInt8* pDest = reinterpret_cast<TUInt8*>(&m_Frames[iCurrFrame].defaultMatrix.e00);
-			eError = CopyXFileData( pChildData, pDest, &iSize );
+			if (!pParser->ReadFloats( &m_Frames[iCurrFrame].defaultMatrix.e00, 16 ))
+			{
+				eError = kInvalidData;
+			}
 		}
 
 		// Found child mesh
-		else if (childGUID == TID_D3DRMMesh)
+		else if (child.IsType( "Mesh" ))
 		{
-			eError = ParseXFileMesh( pChildData, iCurrFrame );
+			eError = ParseXFileMesh( pParser, iCurrFrame );
 		}
 
-		// Release current child data before moving to the next or quiting on error
-		pChildData->Release();
+		// Skip anything not read above before moving to the next child
+		if (eError == kSuccess && !pParser->EndObject( child ))
+		{
+			eError = kInvalidData;
+		}
 
 		// Return any errors found
 		if (eError != kSuccess)
 		{
 			return eError;
 		}
-	}		
+	}
+	if (pParser->HasFailed())
+	{
+		return kInvalidData;
+	}
 
 	return kSuccess;
 
@@ -707,8 +602,8 @@ EImportError CImportXFile::ParseXFileFrame
 // Create a new mesh in the given frame and parse its data from the X-File
 EImportError CImportXFile::ParseXFileMesh
 (
-	ID3DXFileData* pXFileData,
-	const TUInt32  iCurrFrame
+	CXFileParser* pParser,
+	const TUInt32 iCurrFrame
 )
 {
 	GEN_GUARD;
@@ -724,7 +619,7 @@ EImportError CImportXFile::ParseXFileMesh
 	m_Meshes[iCurrMesh].iMaxBonesPerFace = 0;
 
 	// Read vertices and faces for the mesh
-	EImportError eError = ReadMeshData( pXFileData, iCurrMesh );
+	EImportError eError = ReadMeshData( pParser, iCurrMesh );
 	if (eError != kSuccess)
 	{
 		return eError;
@@ -733,72 +628,56 @@ EImportError CImportXFile::ParseXFileMesh
 	// Counter for bones read from child data objects
 	TUInt32 iCurrBone = 0; 
 
-	// Get number of child objects for the current object
-	TUInt32 iNumChildren;
-	eError = GetXFileNumChildren( pXFileData, &iNumChildren );
-	if (eError != kSuccess)
-	{
-		return kInvalidData;
-	}
-
 	// For each child object
-	for (TUInt32 iChild = 0; iChild < iNumChildren; ++iChild)
+	SXFileObject child;
+	while (pParser->NextObject( &child ))
 	{
-		// Get child data and ID
-		ID3DXFileData* pChildData;
-		GUID childGUID;
-		eError = GetXFileChild( pXFileData, iChild, &pChildData, &childGUID );
-		if (eError != kSuccess)
-		{
-			return kInvalidData;
-		}
-
 		// Found normal data
-		if (childGUID == TID_D3DRMMeshNormals)
+		if (child.IsType( "MeshNormals" ))
 		{
-			eError = ReadNormalData( pChildData, iCurrMesh );
+			eError = ReadNormalData( pParser, iCurrMesh );
 		}
 
 		// Found texture coordinate data
-		else if (childGUID == TID_D3DRMMeshTextureCoords)
+		else if (child.IsType( "MeshTextureCoords" ))
 		{
-			eError = ReadTextureUVData( pChildData, iCurrMesh );
+			eError = ReadTextureUVData( pParser, iCurrMesh );
 		}
 
 		// Found vertex colour data
-		else if (childGUID == TID_D3DRMMeshVertexColors)
+		else if (child.IsType( "MeshVertexColors" ))
 		{
-			eError = ReadVertexColourData( pChildData, iCurrMesh );
+			eError = ReadVertexColourData( pParser, iCurrMesh );
 		}
 
 		// Found material list
-		else if (childGUID == TID_D3DRMMeshMaterialList)
+		else if (child.IsType( "MeshMaterialList" ))
 		{
-			eError = ReadMaterialData( pChildData, iCurrMesh );
+			eError = ReadMaterialData( pParser, iCurrMesh );
 		}
 
 		// Found vertex duplication list
-		else if (childGUID == DXFILEOBJ_VertexDuplicationIndices)
+		else if (child.IsType( "VertexDuplicationIndices" ))
 		{
-			eError = ReadDuplicationData( pChildData, iCurrMesh );
+			eError = ReadDuplicationData( pParser, iCurrMesh );
 		}
 
 		// Found face adjacency data
-		else if (childGUID == DXFILEOBJ_FaceAdjacency)
+		else if (child.IsType( "FaceAdjacency" ))
 		{
-			eError = ReadAdjacencyData( pChildData, iCurrMesh );
+			eError = ReadAdjacencyData( pParser, iCurrMesh );
 		}
 
 		// Found skinning definition
-		else if (childGUID == DXFILEOBJ_XSkinMeshHeader)
+		else if (child.IsType( "XSkinMeshHeader" ))
 		{
-			eError = ReadSkinDefnData( pChildData, iCurrMesh );
+			eError = ReadSkinDefnData( pParser, iCurrMesh );
 		}
 
 		// Found skin weights
-		else if (childGUID == DXFILEOBJ_SkinWeights)
+		else if (child.IsType( "SkinWeights" ))
 		{
-			eError = ReadSkinWeightsData( pChildData, iCurrMesh, iCurrBone );
+			eError = ReadSkinWeightsData( pParser, iCurrMesh, iCurrBone );
 			++iCurrBone;
 		}
 
@@ -808,13 +687,20 @@ EImportError CImportXFile::ParseXFileMesh
 			eError = kSuccess; // Won't flag this as failure though
 		}
 
+		// Skip anything not read above before moving to the next child
+		if (eError == kSuccess && !pParser->EndObject( child ))
+		{
+			eError = kInvalidData;
+		}
+
 		if (eError != kSuccess)
 		{
 			return eError;
 		}
-
-		// Release current child data before moving to the next
-		pChildData->Release();
+	}
+	if (pParser->HasFailed())
+	{
+		return kInvalidData;
 	}
 
 	// Check if not enough bones
@@ -836,71 +722,103 @@ EImportError CImportXFile::ParseXFileMesh
 	X-File template parsing
 -----------------------------------------------------------------------------------------*/
 
-// Read vertex and face data from a mesh template
-EImportError CImportXFile::ReadMeshData
+// Read a polygon list, converting each polygon into triangles. Used for the faces of a mesh
+// and its normals, indices must be less than the given number of vertices or normals. Original
+// number of edges of each face is returned if required, otherwise the face edges must match
+// those given
+// Possible return values:
+//		kInvalidData:		The file could not be parsed correctly, or contains invalid data
+EImportError CImportXFile::ReadFaceData
 (
-	ID3DXFileData* pXFileData,
-	const TUInt32  iMesh
+	CXFileParser* pParser,
+	const TUInt32 iNumIndices,
+	TXFileFaces*  pFaces,
+	TXFileInts*   pFaceEdges,
+	bool          bReadEdges
 )
 {
 	GEN_GUARD;
 
-	// Lock mesh data pointer
-	TUInt32 iMeshDataSize = 0;
-	const TUInt8* pMeshDataStart;
-	EImportError eError = LockXFileData( pXFileData, &pMeshDataStart, &iMeshDataSize );
-	if (eError != kSuccess)
+	TUInt32 iNumFaces;
+	if (!pParser->ReadUInt( &iNumFaces ) || (!bReadEdges && iNumFaces != pFaceEdges->size()))
 	{
 		return kInvalidData;
 	}
-	const TUInt8* pMeshData = pMeshDataStart;
-
-	// Get vertices
-	TUInt32 iNumVertices;
-	ReadXFileLockedUInt( pMeshData, &iNumVertices );
-	m_Meshes[iMesh].vertices.resize( iNumVertices );
-	for (TUInt32 iVertex = 0; iVertex < iNumVertices; ++iVertex)
+	if (bReadEdges)
 	{
-		TUInt8* pDest = reinterpret_cast<TUInt8*>(&m_Meshes[iMesh].vertices[iVertex]);
-		ReadXFileLockedData( pMeshData, pDest, sizeof(CVector3) );
+		pFaceEdges->resize( iNumFaces );
 	}
 
-	// Read faces - they can be general polygons - convert them all to triangles
-	TUInt32 iNumFaces;
-	ReadXFileLockedUInt( pMeshData, &iNumFaces );
-	m_Meshes[iMesh].origFaceEdges.resize( iNumFaces ); // See below
 	for (TUInt32 iFace = 0; iFace < iNumFaces; ++iFace)
 	{
 		TUInt32 iNumEdges;
-		ReadXFileLockedUInt( pMeshData, &iNumEdges );
+		if (!pParser->ReadUInt( &iNumEdges ))
+		{
+			return kInvalidData;
+		}
 
-		// Store original number of edges for normal face validation below
-		m_Meshes[iMesh].origFaceEdges[iFace] = iNumEdges;
+		// Store original number of edges for validation of other face lists, or check against it
+		if (bReadEdges)
+		{
+			(*pFaceEdges)[iFace] = iNumEdges;
+		}
+		else if (iNumEdges != (*pFaceEdges)[iFace])
+		{
+			return kInvalidData;
+		}
 
 		// Read first index of polygon, then use successive pairs of indices to form triangles
 		// with this first one
 		TUInt32 iFirstIndex, iIndexA, iIndexB;
-		ReadXFileLockedUInt( pMeshData, &iFirstIndex );
-		ReadXFileLockedUInt( pMeshData, &iIndexA );
+		if (!pParser->ReadUInt( &iFirstIndex ) || !pParser->ReadUInt( &iIndexA ) ||
+		    iFirstIndex >= iNumIndices || iIndexA >= iNumIndices)
+		{
+			return kInvalidData;
+		}
 		for (TUInt32 iEdge = 2; iEdge < iNumEdges; ++iEdge)
 		{
-			ReadXFileLockedUInt( pMeshData, &iIndexB );
+			if (!pParser->ReadUInt( &iIndexB ) || iIndexB >= iNumIndices)
+			{
+				return kInvalidData;
+			}
 			SXFileFace face = { iFirstIndex, iIndexA, iIndexB };
-			m_Meshes[iMesh].faces.push_back( face );
+			pFaces->push_back( face );
 			iIndexA = iIndexB;
 		}
 	}
 
-	// Unlock mesh data
-	pXFileData->Unlock();
+	return kSuccess;
+
+	GEN_ENDGUARD;
+}
+
+
+// Read vertex and face data from a mesh template
+EImportError CImportXFile::ReadMeshData
+(
+	CXFileParser* pParser,
+	const TUInt32 iMesh
+)
+{
+	GEN_GUARD;
 
-	// Validate amount of data read
-	if (static_cast<TUInt32>(pMeshData - pMeshDataStart) != iMeshDataSize)
+	// Get vertices
+	TUInt32 iNumVertices;
+	if (!pParser->ReadUInt( &iNumVertices ))
+	{
+		return kInvalidData;
+	}
+	m_Meshes[iMesh].vertices.resize( iNumVertices );
+	if (iNumVertices > 0 && !pParser->ReadFloats( &m_Meshes[iMesh].vertices[0].x, iNumVertices * 3 ))
 	{
 		return kInvalidData;
 	}
 
-	return kSuccess;
+	// Read faces - they can be general polygons - convert them all to triangles. Store original
+	// number of edges for normal face validation below
+	return ReadFaceData( pParser, iNumVertices, &m_Meshes[iMesh].faces,
+	                     &m_Meshes[iMesh].origFaceEdges, true );
+
 	GEN_ENDGUARD;
 }
 
@@ -908,8 +826,8 @@ EImportError CImportXFile::ReadMeshData
 // Read a normal data mesh template
 EImportError CImportXFile::ReadNormalData
 (
-	ID3DXFileData* pXFileData,
-	const TUInt32  iMesh
+	CXFileParser* pParser,
+	const TUInt32 iMesh
 )
 {
 	GEN_GUARD;
@@ -920,64 +838,22 @@ EImportError CImportXFile::ReadNormalData
 		return kInvalidData;
 	}
 
-	// Get normal data
-	const TUInt8* pNormalData;
-	EImportError eError = LockXFileData( pXFileData, &pNormalData );
-	if (eError != kSuccess)
-	{
-		return kInvalidData;
-	}
-
 	// Read normals
 	TUInt32 iNumNormals;
-	ReadXFileLockedUInt( pNormalData, &iNumNormals );
-	m_Meshes[iMesh].normals.resize( iNumNormals );
-	for (TUInt32 iNormal = 0; iNormal < iNumNormals; ++iNormal)
-	{
-		TUInt8* pDest = reinterpret_cast<TUInt8*>(&m_Meshes[iMesh].normals[iNormal]);
-		ReadXFileLockedData( pNormalData, pDest, sizeof(CVector3) );
-	}
-
-	// Verify that normal face list matches face list
-	TUInt32 iNumNormalFaces;
-	ReadXFileLockedUInt( pNormalData, &iNumNormalFaces );
-	if (iNumNormalFaces != m_Meshes[iMesh].origFaceEdges.size())
+	if (!pParser->ReadUInt( &iNumNormals ))
 	{
-		pXFileData->Unlock();
 		return kInvalidData;
 	}
-
-	// Read normal faces - they can be general polygons - convert them all to triangles
-	for (TUInt32 iFace = 0; iFace < iNumNormalFaces; ++iFace)
+	m_Meshes[iMesh].normals.resize( iNumNormals );
+	if (iNumNormals > 0 && !pParser->ReadFloats( &m_Meshes[iMesh].normals[0].x, iNumNormals * 3 ))
 	{
-		TUInt32 iNumEdges;
-		ReadXFileLockedUInt( pNormalData, &iNumEdges );
-
-		// Check number of edges against original face data
-		if (iNumEdges != m_Meshes[iMesh].origFaceEdges[iFace])
-		{
-			pXFileData->Unlock();
-			return kInvalidData;
-		}
-
-		// Read first index of polygon, then use successive pairs of indices to form triangles
-		// with this first one
-		TUInt32 iFirstIndex, iIndexA, iIndexB;
-		ReadXFileLockedUInt( pNormalData, &iFirstIndex );
-		ReadXFileLockedUInt( pNormalData, &iIndexA );
-		for (TUInt32 iEdge = 2; iEdge < iNumEdges; ++iEdge)
-		{
-			ReadXFileLockedUInt( pNormalData, &iIndexB );
-			SXFileFace face = { iFirstIndex, iIndexA, iIndexB };
-			m_Meshes[iMesh].normalFaces.push_back( face );
-			iIndexA = iIndexB;
-		}
+		return kInvalidData;
 	}
 
-	// Finished with normal data
-	pXFileData->Unlock();
-
-	return kSuccess;
+	// Read normal faces - they can be general polygons - convert them all to triangles. Verify
+	// that normal face list matches original face list
+	return ReadFaceData( pParser, iNumNormals, &m_Meshes[iMesh].normalFaces,
+	                     &m_Meshes[iMesh].origFaceEdges, false );
 
 	GEN_ENDGUARD;
 }
@@ -985,8 +861,8 @@ EImportError CImportXFile::ReadNormalData
 // Read a texture coordinate mesh template
 EImportError CImportXFile::ReadTextureUVData
 (
-	ID3DXFileData* pXFileData,
-	const TUInt32  iMesh
+	CXFileParser* pParser,
+	const TUInt32 iMesh
 )
 {
 	GEN_GUARD;
@@ -997,32 +873,20 @@ EImportError CImportXFile::ReadTextureUVData
 		return kInvalidData;
 	}
 
-	// Get texture coordinate data
-	const TUInt8* pTexCoordData;
-	EImportError eError = LockXFileData( pXFileData, &pTexCoordData );
-	if (eError != kSuccess)
-	{
-		return kInvalidData;
-	}
-
 	// Read texture coordinates
 	TUInt32 iNumTextureCoords;
-	ReadXFileLockedUInt( pTexCoordData, &iNumTextureCoords );
-	if (iNumTextureCoords != m_Meshes[iMesh].vertices.size())
+	if (!pParser->ReadUInt( &iNumTextureCoords ) ||
+	    iNumTextureCoords != m_Meshes[iMesh].vertices.size())
 	{
-		pXFileData->Unlock();
 		return kInvalidData;
 	}
 	m_Meshes[iMesh].textureCoords.resize( iNumTextureCoords );
-	for (TUInt32 iUV = 0; iUV < iNumTextureCoords; ++iUV)
+	if (iNumTextureCoords > 0 &&
+	    !pParser->ReadFloats( &m_Meshes[iMesh].textureCoords[0].fU, iNumTextureCoords * 2 ))
 	{
-		TUInt8* pDest = reinterpret_cast<TUInt8*>(&m_Meshes[iMesh].textureCoords[iUV]);
-		ReadXFileLockedData( pTexCoordData, pDest, sizeof(SXFileUV) );
+		return kInvalidData;
 	}
 
-	// Finished with texture coordinate data
-	pXFileData->Unlock();
-
 	return kSuccess;
 
 	GEN_ENDGUARD;
@@ -1031,8 +895,8 @@ EImportError CImportXFile::ReadTextureUVData
 // Read a vertex colour mesh template, any vertices not assigned a colour will get white
 EImportError CImportXFile::ReadVertexColourData
 (
-	ID3DXFileData* pXFileData,
-	const TUInt32  iMesh
+	CXFileParser* pParser,
+	const TUInt32 iMesh
 )
 {
 	GEN_GUARD;
@@ -1043,18 +907,13 @@ EImportError CImportXFile::ReadVertexColourData
 		return kInvalidData;
 	}
 
-	// Get vertex colour data
-	const TUInt8* pVertexColourData;
-	EImportError eError = LockXFileData( pXFileData, &pVertexColourData );
-	if (eError != kSuccess)
+	// Read vertex colours
+	TUInt32 iNumVertexColours;
+	if (!pParser->ReadUInt( &iNumVertexColours ))
 	{
 		return kInvalidData;
 	}
 
-	// Read vertex colours
-	TUInt32 iNumVertexColours;
-	ReadXFileLockedUInt( pVertexColourData, &iNumVertexColours );
-
 	// All colours default to white if not assigned
 	// TODO: Could split mesh into sections with and without vertex colours - not worth it?
 	SXFileRGBAColour defaultColour = { 1.0f, 1.0f, 1.0f, 1.0f };
@@ -1062,24 +921,23 @@ EImportError CImportXFile::ReadVertexColourData
 	for (TUInt32 iColour = 0; iColour < iNumVertexColours; ++iColour)
 	{
 		TUInt32 iVertexIndex;
-		ReadXFileLockedUInt( pVertexColourData, &iVertexIndex );
-		TUInt8* pDest = reinterpret_cast<TUInt8*>(&m_Meshes[iMesh].vertexColours[iVertexIndex]);
-		ReadXFileLockedData( pVertexColourData, pDest, sizeof(SXFileRGBAColour) );
+		if (!pParser->ReadUInt( &iVertexIndex ) || iVertexIndex >= iNumVertexColours ||
+		    !pParser->ReadFloats( &m_Meshes[iMesh].vertexColours[iVertexIndex].fRed, 4 ))
+		{
+			return kInvalidData;
+		}
 	}
 
-	// Finished with vertex colour data
-	pXFileData->Unlock();
-
 	return kSuccess;
 
 	GEN_ENDGUARD;
 }
 
-// Read a vertex colour mesh template
+// Read a material list mesh template
 EImportError CImportXFile::ReadMaterialData
 (
-	ID3DXFileData* pXFileData,
-	const TUInt32  iMesh
+	CXFileParser* pParser,
+	const TUInt32 iMesh
 )
 {
 	GEN_GUARD;
@@ -1090,17 +948,12 @@ EImportError CImportXFile::ReadMaterialData
 		return kInvalidData;
 	}
 
-	// Get material data
-	const TUInt8* pMaterialData;
-	EImportError eError = LockXFileData( pXFileData, &pMaterialData );
-	if (eError != kSuccess)
+	// Read number of materials and initialise material list
+	TUInt32 iNumMaterials;
+	if (!pParser->ReadUInt( &iNumMaterials ))
 	{
 		return kInvalidData;
 	}
-
-	// Read number of materials and initialise material list
-	TUInt32 iNumMaterials;
-	ReadXFileLockedUInt( pMaterialData, &iNumMaterials );
 	for (TUInt32 iMaterial = 0; iMaterial < iNumMaterials; ++iMaterial)
 	{
 		SXFileMaterial material = 
@@ -1117,14 +970,20 @@ EImportError CImportXFile::ReadMaterialData
 	// Read face materials - matching the original face list before it was split into triangles.
 	// Will convert to match the new (triangle-only) face list
 	TUInt32 iNumFaceMaterials;
-	ReadXFileLockedUInt( pMaterialData, &iNumFaceMaterials );
+	if (!pParser->ReadUInt( &iNumFaceMaterials ))
+	{
+		return kInvalidData;
+	}
 
 	// Handle undocumented case with only one face material - all faces use same material
 	if (iNumFaceMaterials == 1 && m_Meshes[iMesh].origFaceEdges.size() != 1)
 	{
 		// Read the single face material
 		TUInt32 iFaceMaterial;
-		ReadXFileLockedUInt( pMaterialData, &iFaceMaterial );
+		if (!pParser->ReadUInt( &iFaceMaterial ))
+		{
+			return kInvalidData;
+		}
 
 		// Create a full face material list from this value
 		m_Meshes[iMesh].faceMaterials.resize( m_Meshes[iMesh].faces.size(), iFaceMaterial );
@@ -1133,7 +992,6 @@ EImportError CImportXFile::ReadMaterialData
 	{
 		if (iNumFaceMaterials != m_Meshes[iMesh].origFaceEdges.size())
 		{
-			pXFileData->Unlock();
 			return kInvalidData;
 		}
 		m_Meshes[iMesh].faceMaterials.resize( m_Meshes[iMesh].faces.size() );
@@ -1141,7 +999,10 @@ EImportError CImportXFile::ReadMaterialData
 		for (TUInt32 iOrigFace = 0; iOrigFace < iNumFaceMaterials; ++iOrigFace)
 		{
 			TUInt32 iMaterial;
-			ReadXFileLockedUInt( pMaterialData, &iMaterial );
+			if (!pParser->ReadUInt( &iMaterial ))
+			{
+				return kInvalidData;
+			}
 			m_Meshes[iMesh].faceMaterials[iFace] = iMaterial;
 			++iFace;
 			for (TUInt32 iEdge = 3; iEdge < m_Meshes[iMesh].origFaceEdges[iOrigFace]; ++iEdge)
@@ -1152,121 +1013,66 @@ EImportError CImportXFile::ReadMaterialData
 		}
 	}
 
-	// Finished with material data
-	pXFileData->Unlock();
-
 
-	// Counter for materials read from optional data objects
+	// Counter for materials read from child objects
 	TUInt32 iMaterialsRead = 0;
 
-	// Get number of child objects for the current object
-	TUInt32 iNumMatListChildren;
-	eError = GetXFileNumChildren( pXFileData, &iNumMatListChildren );
-	if (eError != kSuccess)
+	// For each child object - materials may be given in place or as references to materials
+	// elsewhere in the file, the parser returns both in the same way
+	SXFileObject matListChild;
+	while (pParser->NextObject( &matListChild ))
 	{
-		return kInvalidData;
-	}
-
-	// For each child object
-	for (TUInt32 iMatListChild = 0; iMatListChild < iNumMatListChildren; ++iMatListChild)
-	{
-		// Get child data and ID
-		ID3DXFileData* pMatListChildData;
-		GUID matListChildGUID;
-		eError = GetXFileChild( pXFileData, iMatListChild, &pMatListChildData, &matListChildGUID );
-		if (eError != kSuccess)
-		{
-			return kInvalidData;
-		}
-
 		// Found material in material list
-		if (matListChildGUID == TID_D3DRMMaterial)
+		if (matListChild.IsType( "Material" ))
 		{
 			// Check if too many materials
 			if (iMaterialsRead >= m_Meshes[iMesh].materials.size())
 			{
-				pMatListChildData->Release();
 				return kInvalidData;
 			}
 
-			// Read material name
-			EImportError eError =
-				GetXFileDataName( pMatListChildData, m_Meshes[iMesh].materials[iMaterialsRead].sName );
-			if (eError != kSuccess)
+			// Read material name, then face colour, specular power, specular and emissive colours
+			SXFileMaterial& material = m_Meshes[iMesh].materials[iMaterialsRead];
+			material.sName = matListChild.Name();
+			if (!pParser->ReadFloats( &material.faceColour.fRed, 4 ) ||
+			    !pParser->ReadFloat( &material.fSpecularPower ) ||
+			    !pParser->ReadFloats( &material.specularColour.fRed, 3 ) ||
+			    !pParser->ReadFloats( &material.emmisiveColour.fRed, 3 ))
 			{
-				pMatListChildData->Release();
-				return kInvalidData;
-			}
-
-			// Get material data (11 floats in material template up to optional data)
-			// Fills in all of SXFileMaterial between name & texture name TODO a bit dodgy
-			TUInt32 iSize = 11 * sizeof(TFloat32);
-			TUInt8* pDest = 
-				reinterpret_cast<TUInt8*>(&m_Meshes[iMesh].materials[iMaterialsRead].faceColour);
-			CopyXFileData( pMatListChildData, pDest, &iSize );
-
-
-			// Get number of child objects for the current object
-			TUInt32 iNumMatChildren;
-			eError = GetXFileNumChildren( pMatListChildData, &iNumMatChildren );
-			if (eError != kSuccess)
-			{
-				pMatListChildData->Release();
 				return kInvalidData;
 			}
 
 			// For each child object
-			for (TUInt32 iMatChild = 0; iMatChild < iNumMatChildren; ++iMatChild)
+			SXFileObject matChild;
+			while (pParser->NextObject( &matChild ))
 			{
-				// Get child data and ID
-				ID3DXFileData* pMatChildData;
-				GUID matChildGUID;
-				eError = GetXFileChild( pMatListChildData, iMatChild,
-				                        &pMatChildData, &matChildGUID );
-				if (eError != kSuccess)
-				{
-					pMatListChildData->Release();
-					return kInvalidData;
-				}
-
 				// Found texture filename in material
-				if (matChildGUID == TID_D3DRMTextureFilename)
+				if (matChild.IsType( "TextureFilename" ) &&
+				    !pParser->ReadString( &material.sTextureName ))
 				{
-					const TUInt8* pFileNameData;
-					EImportError eError = LockXFileData( pMatChildData, &pFileNameData );
-					if (eError != kSuccess)
-					{
-						pMatChildData->Release();
-						pMatListChildData->Release();
-						return kInvalidData;
-					}
-					m_Meshes[iMesh].materials[iMaterialsRead].sTextureName = 
-						reinterpret_cast<const char*>(pFileNameData);
-					pMatChildData->Unlock();
+					return kInvalidData;
 				}
 
-				// Found unknown material data
-				else
+				// Ignore unknown material data
+				if (!pParser->EndObject( matChild ))
 				{
-					// Ignore
+					return kInvalidData;
 				}
-
-				// Release material child data before moving to the next
-				pMatChildData->Release();
 			}
 
-			// Increase nubmer of materials that have been found and read
+			// Increase number of materials that have been found and read
 			++iMaterialsRead;
 		}
 
-		// Found unknown material list data
-		else
+		// Ignore unknown material list data
+		if (!pParser->EndObject( matListChild ))
 		{
-			// Ignore
+			return kInvalidData;
 		}
-
-		// Release material list child data before moving to the next
-		pMatListChildData->Release();
+	}
+	if (pParser->HasFailed())
+	{
+		return kInvalidData;
 	}
 
 	// Check if not enough materials
@@ -1283,8 +1089,8 @@ EImportError CImportXFile::ReadMaterialData
 // Read a vertex duplication mesh template
 EImportError CImportXFile::ReadDuplicationData
 (
-	ID3DXFileData* pXFileData,
-	const TUInt32  iMesh
+	CXFileParser* pParser,
+	const TUInt32 iMesh
 )
 {
 	GEN_GUARD;
@@ -1295,32 +1101,23 @@ EImportError CImportXFile::ReadDuplicationData
 		return kInvalidData;
 	}
 
-	// Get vertex duplication data
-	const TUInt8* pDuplicationData;
-	EImportError eError = LockXFileData( pXFileData, &pDuplicationData );
-	if (eError != kSuccess)
-	{
-		return kInvalidData;
-	}
-
 	// Read duplicaton indices, also fetch number of unique vertices
 	TUInt32 iNumDuplicationIndices;
-	ReadXFileLockedUInt( pDuplicationData, &iNumDuplicationIndices );
-	if (iNumDuplicationIndices != m_Meshes[iMesh].vertices.size())
+	if (!pParser->ReadUInt( &iNumDuplicationIndices ) ||
+	    iNumDuplicationIndices != m_Meshes[iMesh].vertices.size() ||
+	    !pParser->ReadUInt( &m_Meshes[iMesh].iNumUniqueVertices ))
 	{
-		pXFileData->Unlock();
 		return kInvalidData;
 	}
-	ReadXFileLockedUInt( pDuplicationData, &m_Meshes[iMesh].iNumUniqueVertices );
 	m_Meshes[iMesh].duplicateIndices.resize( iNumDuplicationIndices );
 	for (TUInt32 iIndex = 0; iIndex < iNumDuplicationIndices; ++iIndex)
 	{
-		ReadXFileLockedUInt( pDuplicationData, &m_Meshes[iMesh].duplicateIndices[iIndex] );
+		if (!pParser->ReadUInt( &m_Meshes[iMesh].duplicateIndices[iIndex] ))
+		{
+			return kInvalidData;
+		}
 	}
 
-	// Finished with vertex duplication data
-	pXFileData->Unlock();
-
 	return kSuccess;
 
 	GEN_ENDGUARD;
@@ -1330,8 +1127,8 @@ EImportError CImportXFile::ReadDuplicationData
 // TODO: Unknown usage
 EImportError CImportXFile::ReadAdjacencyData
 (
-	ID3DXFileData* pXFileData,
-	const TUInt32  iMesh
+	CXFileParser* pParser,
+	const TUInt32 iMesh
 )
 {
 	GEN_GUARD;
@@ -1342,26 +1139,21 @@ EImportError CImportXFile::ReadAdjacencyData
 		return kInvalidData;
 	}
 
-	// Get face adjacency data
-	const TUInt8* pAdjacencyData;
-	EImportError eError = LockXFileData( pXFileData, &pAdjacencyData );
-	if (eError != kSuccess)
+	// Read face adjacency list
+	TUInt32 iNumAdjacencyIndices;
+	if (!pParser->ReadUInt( &iNumAdjacencyIndices ))
 	{
 		return kInvalidData;
 	}
-
-	// Read face adjacency list
-	TUInt32 iNumAdjacencyIndices;
-	ReadXFileLockedUInt( pAdjacencyData, &iNumAdjacencyIndices );
 	m_Meshes[iMesh].adjacencyIndices.resize( iNumAdjacencyIndices );
 	for (TUInt32 iIndex = 0; iIndex < iNumAdjacencyIndices; ++iIndex)
 	{
-		ReadXFileLockedUInt( pAdjacencyData, &m_Meshes[iMesh].adjacencyIndices[iIndex] );
+		if (!pParser->ReadUInt( &m_Meshes[iMesh].adjacencyIndices[iIndex] ))
+		{
+			return kInvalidData;
+		}
 	}
 
-	// Finished with face adjacency data
-	pXFileData->Unlock();
-
 	return kSuccess;
 
 	GEN_ENDGUARD;
@@ -1370,8 +1162,8 @@ EImportError CImportXFile::ReadAdjacencyData
 // Read skinning header mesh template
 EImportError CImportXFile::ReadSkinDefnData
 (
-	ID3DXFileData* pXFileData,
-	const TUInt32  iMesh
+	CXFileParser* pParser,
+	const TUInt32 iMesh
 )
 {
 	GEN_GUARD;
@@ -1382,21 +1174,17 @@ EImportError CImportXFile::ReadSkinDefnData
 		return kInvalidData;
 	}
 
-	// Get skinning definition data
-	const TUInt8* pSkinDefnData;
-	EImportError eError = LockXFileData( pXFileData, &pSkinDefnData );
-	if (eError != kSuccess)
+	// Read maximum weights info and number of bones used (all WORDs in the template)
+	TUInt32 iMaxBonesPerVertex, iMaxBonesPerFace, iNumBones;
+	if (!pParser->ReadUInt( &iMaxBonesPerVertex ) || !pParser->ReadUInt( &iMaxBonesPerFace ) ||
+	    !pParser->ReadUInt( &iNumBones ) || iNumBones > 0xffff)
 	{
 		return kInvalidData;
 	}
+	m_Meshes[iMesh].iMaxBonesPerVertex = static_cast<TUInt16>(iMaxBonesPerVertex);
+	m_Meshes[iMesh].iMaxBonesPerFace = static_cast<TUInt16>(iMaxBonesPerFace);
 
-	// Read maximum weights info
-	ReadXFileLockedUInt16( pSkinDefnData, &m_Meshes[iMesh].iMaxBonesPerVertex );
-	ReadXFileLockedUInt16( pSkinDefnData, &m_Meshes[iMesh].iMaxBonesPerFace );
-
-	// Get number of bones used and initialise bone structures
-	TUInt16 iNumBones;
-	ReadXFileLockedUInt16( pSkinDefnData, &iNumBones );
+	// Initialise bone structures
 	for (TUInt32 iBone = 0; iBone < iNumBones; ++iBone)
 	{
 		SXFileBone bone;
@@ -1405,9 +1193,6 @@ EImportError CImportXFile::ReadSkinDefnData
 		m_Meshes[iMesh].bones.push_back( bone );
 	}
 
-	// Finished with skinning definition data
-	pXFileData->Unlock();
-
 	return kSuccess;
 
 	GEN_ENDGUARD;
@@ -1416,9 +1201,9 @@ EImportError CImportXFile::ReadSkinDefnData
 // Read a skinning weights mesh template
 EImportError CImportXFile::ReadSkinWeightsData
 (
-	ID3DXFileData* pXFileData,
-	const TUInt32  iMesh,
-	const TUInt32  iBone
+	CXFileParser* pParser,
+	const TUInt32 iMesh,
+	const TUInt32 iBone
 )
 {
 	GEN_GUARD;
@@ -1428,284 +1213,43 @@ EImportError CImportXFile::ReadSkinWeightsData
 	{
 		return kInvalidData;
 	}
+	SXFileBone& bone = m_Meshes[iMesh].bones[iBone];
 
-	// Get skin weights data
-	const TUInt8* pSkinWeightData;
-	EImportError eError = LockXFileData( pXFileData, &pSkinWeightData );
-	if (eError != kSuccess)
+	// Read name of bone and number of weights
+	TUInt32 iNumWeights;
+	if (!pParser->ReadString( &bone.sFrameName ) || !pParser->ReadUInt( &iNumWeights ))
 	{
 		return kInvalidData;
 	}
-
-	// Read name of bone
-	m_Meshes[iMesh].bones[iBone].sFrameName = reinterpret_cast<const char*>(pSkinWeightData);
-	pSkinWeightData += m_Meshes[iMesh].bones[iBone].sFrameName.length() + 1;
-
-	// Read number of weights
-	TUInt32 iNumWeights;
-	ReadXFileLockedUInt( pSkinWeightData, &iNumWeights );
-	m_Meshes[iMesh].bones[iBone].weights.resize( iNumWeights );
+	bone.weights.resize( iNumWeights );
 
 	// Read skinning indices, weights and offset matrix
 	for (TUInt32 iIndex = 0; iIndex < iNumWeights; ++iIndex)
 	{
-		ReadXFileLockedUInt( pSkinWeightData,
-		                     &m_Meshes[iMesh].bones[iBone].weights[iIndex].iVertexIndex );
-	}
-
-	for (TUInt32 iWeight = 0; iWeight < iNumWeights; ++iWeight)
-	{
-		TUInt8* pDest = 
-			reinterpret_cast<TUInt8*>(&m_Meshes[iMesh].bones[iBone].weights[iWeight].fWeight);
-		ReadXFileLockedData( pSkinWeightData, pDest, sizeof(TFloat32) );
-	}
-
-	TUInt8* pDest = reinterpret_cast<TUInt8*>(&m_Meshes[iMesh].bones[iBone].offsetMatrix);
-	ReadXFileLockedData( pSkinWeightData, pDest, 16 * sizeof(TFloat32) );
-
-	// Finished with skin weight data
-	pXFileData->Unlock();
-
-	return kSuccess;
-
-	GEN_ENDGUARD;
-}
-
-
-/*-----------------------------------------------------------------------------------------
-	X-File parsing
------------------------------------------------------------------------------------------*/
-
-EImportError CImportXFile::GetXFileNumChildren
-(
-	ID3DXFileEnumObject* pXFileEnumer, 
-	TUInt32*             iNumChildren
-)
-{
-	GEN_GUARD;
-
-	HRESULT xFileError = pXFileEnumer->GetChildren( reinterpret_cast<DWORD*>(iNumChildren) );
-	if (xFileError != S_OK)
-	{
-		return kInvalidData;
-	}
-
-	return kSuccess;
-
-	GEN_ENDGUARD;
-}
-
-EImportError CImportXFile::GetXFileNumChildren
-(
-	ID3DXFileData* pXFileData,
-	TUInt32*       iNumChildren
-)
-{
-	GEN_GUARD;
-
-	HRESULT xFileError = pXFileData->GetChildren( reinterpret_cast<DWORD*>(iNumChildren) );
-	if (xFileError != S_OK)
-	{
-		return kInvalidData;
-	}
-
-	return kSuccess;
-
-	GEN_ENDGUARD;
-}
-
-
-EImportError CImportXFile::GetXFileChild
-(
-	ID3DXFileEnumObject* pXFileEnumer,
-	const TUInt32        iChild, 
-	ID3DXFileData**      ppChildData, 
-	GUID*                pChildGUID
-)
-{
-	GEN_GUARD;
-
-	HRESULT xFileError = pXFileEnumer->GetChild( iChild, ppChildData );
-	if (xFileError != S_OK)
-	{
-		GEN_ASSERT( xFileError != D3DXFERR_NOMOREOBJECTS, "Invalid child ID" );
-		return kInvalidData;
-	}
-
-	xFileError = (*ppChildData)->GetType( pChildGUID );
-	GEN_ASSERT( xFileError == S_OK, "Failure getting X-File GUID" );
-
-	return kSuccess;
-
-	GEN_ENDGUARD;
-}
-
-EImportError CImportXFile::GetXFileChild
-(
-	ID3DXFileData*  pXFileData,
-	const TUInt32   iChild, 
-	ID3DXFileData** ppChildData, 
-	GUID*           pChildGUID
-)
-{
-	GEN_GUARD;
-
-	HRESULT xFileError = pXFileData->GetChild( iChild, ppChildData );
-	if (xFileError != S_OK)
-	{
-		GEN_ASSERT( xFileError != D3DXFERR_NOMOREOBJECTS, "Invalid child ID" );
-		return kInvalidData;
-	}
-
-	xFileError = (*ppChildData)->GetType( pChildGUID );
-	GEN_ASSERT( xFileError == S_OK, "Failure getting X-File GUID" );
-
-	return kSuccess;
-
-	GEN_ENDGUARD;
-}
-
-
-EImportError CImportXFile::GetXFileDataName
-(
-	ID3DXFileData* pXFileData,
-	string&        sName
-)
-{
-	GEN_GUARD;
-
-	DWORD iDataSize;
-	HRESULT xFileError = pXFileData->GetName( NULL, &iDataSize );
-	if (!iDataSize)
-	{
-		sName = "";
-	}
-	else
-	{
-		char* szName = new char[iDataSize];
-		if (!szName)
+		if (!pParser->ReadUInt( &bone.weights[iIndex].iVertexIndex ))
 		{
-			return kOutOfSystemMemory;
+			return kInvalidData;
 		}
-		xFileError = pXFileData->GetName( szName, &iDataSize );
-		GEN_ASSERT( xFileError == S_OK, "Failure getting X-File name" );
-		sName = szName;
-		delete[] szName;
 	}
 
-	return kSuccess;
-
-	GEN_ENDGUARD;
-}
-
-
-EImportError CImportXFile::LockXFileData
-(
-	ID3DXFileData* pXFileData,
-    const TUInt8** ppLockData,
-    TUInt32*       pSize /*= 0*/
-)
-{
-	GEN_GUARD;
- 
-	DWORD iActualSize;
-	HRESULT xFileError = 
-		pXFileData->Lock( &iActualSize, reinterpret_cast<const void**>(ppLockData) );
-	GEN_ASSERT( xFileError == S_OK, "Unexpected failure in Lock" );
-	if (pSize)
-	{
-		if (*pSize != 0 && *pSize != iActualSize)
+	for (TUInt32 iWeight = 0; iWeight < iNumWeights; ++iWeight)
+	{
+		if (!pParser->ReadFloat( &bone.weights[iWeight].fWeight ))
 		{
-			pXFileData->Unlock();
 			return kInvalidData;
 		}
-		*pSize = iActualSize;
 	}
 
-	return kSuccess;
-
-	GEN_ENDGUARD;
-}
-
-void CImportXFile::UnlockXFileData
-(
-	ID3DXFileData* pXFileData
-)
-{
-	GEN_GUARD;
- 
-	pXFileData->Unlock();
-
-	GEN_ENDGUARD;
-}
-
-
-EImportError CImportXFile::CopyXFileData
-(
-	ID3DXFileData* pXFileData,
-    TUInt8*        pDest,
-    TUInt32*       pSize
-)
-{
-	GEN_GUARD;
- 
-	const TUInt8* pLockData;
-	EImportError eError = LockXFileData( pXFileData, &pLockData, pSize );
-	if (eError != kSuccess)
+	if (!pParser->ReadFloats( &bone.offsetMatrix.e00, 16 ))
 	{
-		return eError;
+		return kInvalidData;
 	}
-	memcpy( pDest, pLockData, *pSize );
-	UnlockXFileData( pXFileData );
 
 	return kSuccess;
 
 	GEN_ENDGUARD;
 }
 
-void CImportXFile::ReadXFileLockedData
-(
-	const TUInt8*& pMeshData,
-	TUInt8*        pDest,
-	const TUInt32  iSize
-)
-{
-	GEN_GUARD;
- 
-	memcpy( pDest, pMeshData, iSize );
-	pMeshData += iSize;
-
-	GEN_ENDGUARD;
-}
-
-void CImportXFile::ReadXFileLockedUInt
-(
-	const TUInt8*& pMeshData,
-	TUInt32*       piDest
-)
-{
-	GEN_GUARD;
- 
-	memcpy( piDest, pMeshData, 4 );
-	pMeshData += 4;
-
-	GEN_ENDGUARD;
-}
-
-void CImportXFile::ReadXFileLockedUInt16
-(
-	const TUInt8*& pMeshData,
-	TUInt16*       piDest
-)
-{
-	GEN_GUARD;
- 
-	memcpy( piDest, pMeshData, 2 );
-	pMeshData += 2;
-
-	GEN_ENDGUARD;
-}
-
 
 /*-----------------------------------------------------------------------------------------
 	X-file type support
@@ -1751,100 +1295,131 @@ void CImportXFile::MatchFaceLists
 
 	if (!mesh.normals.empty())
 	{
-		// Maximum vertices (and normals) possible is the total number of indices in the original
-		// face lists (if each index was different). Use std library accumulate from <numeric>
-		TUInt32 iMaxVertices = accumulate( mesh.origFaceEdges.begin(), 
-		                                   mesh.origFaceEdges.end(), 0 );
+		TUInt32 iNumVertices = static_cast<TUInt32>(mesh.vertices.size());
 
-		// Create empty vertex and normal maps - use max vertex value as unused marker
-		TXFileInts vertexMap( iMaxVertices, iMaxVertices );
-		TXFileInts normalMap( iMaxVertices, iMaxVertices );
+		// The first normal used with each vertex is kept on the original vertex
+		TXFileInts vertexNormal( iNumVertices, kUnusedIndex );
 
-		// Table of vertex duplicates created by this process, each entry is next copy of vertex
-		TXFileInts vertexDup( iMaxVertices, iMaxVertices );
+		// Any other normal used with a vertex needs a copy of the vertex. Copies are added in the
+		// order first seen, and found again through a hash table of vertex/normal index pairs that
+		// holds copy numbers. Table size is a power of 2, kept at most half full
+		TXFileInts copySource;
+		TXFileInts copyNormal;
+		TXFileInts copyTable( 64, kUnusedIndex );
 
-		// May need to duplicate vertices, count from original number of vertices
-		TUInt32 iNewNumVertices = static_cast<TUInt32>(mesh.vertices.size()); 
-
-		// Create vertex and normal mapping tables
 		for (TUInt32 iFace = 0; iFace != mesh.faces.size(); ++iFace)
 		{
 			// Unclutter code with references to current faces (vertex and normal)
 			SXFileFace& vertexFace = mesh.faces[iFace];
-			SXFileFace& normalFace = mesh.normalFaces[iFace];
+			const SXFileFace& normalFace = mesh.normalFaces[iFace];
 
 			// For each face edge
 			for (int i = 0; i < 3; ++i)
 			{
-				// Will try to use vertex face index for the normal face index, if unused then OK
-				if (normalMap[vertexFace.aiVertex[i]] == iMaxVertices) 
+				TUInt32 iVertex = vertexFace.aiVertex[i];
+				TUInt32 iNormal = normalFace.aiVertex[i];
+
+				// Use the vertex face index for both vertices and normals if possible
+				if (vertexNormal[iVertex] == kUnusedIndex)
 				{
-					// Use the vertex face index for both vertices and normals
-					vertexMap[vertexFace.aiVertex[i]] = vertexFace.aiVertex[i];
-					normalMap[vertexFace.aiVertex[i]] = normalFace.aiVertex[i];
+					vertexNormal[iVertex] = iNormal;
+					continue;
 				}
-				// otherwise the vertex face index has already been used...
-				else
+				if (vertexNormal[iVertex] == iNormal)
 				{
-					// See if the normal face index is correct for this vertex or the duplicates
-					// already created
-					TUInt32 iVert = vertexFace.aiVertex[i];
-					while (normalMap[iVert] != normalFace.aiVertex[i] &&
-					       vertexDup[iVert] != iMaxVertices)
-					{
-						iVert = vertexDup[iVert];
-					}
-					// Can't find correct normal face index on any of this vertices copies, so
-					// create another copy
-					if (normalMap[iVert] != normalFace.aiVertex[i])
-					{
-						// Add new vertex index
-						vertexMap[iNewNumVertices] = vertexFace.aiVertex[i];
-						normalMap[iNewNumVertices] = normalFace.aiVertex[i];
-						vertexDup[iVert] = iNewNumVertices;
-
-						// Update the face indices to point at this new vertex
-						vertexFace.aiVertex[i] = iNewNumVertices;
-						++iNewNumVertices;
-					}
-					else
+					continue;
+				}
+
+				// Otherwise look for an existing copy of the vertex with this normal
+				TUInt32 iMask = static_cast<TUInt32>(copyTable.size()) - 1;
+				TUInt32 iSlot = HashIndexPair( iVertex, iNormal ) & iMask;
+				while (copyTable[iSlot] != kUnusedIndex &&
+				       (copySource[copyTable[iSlot]] != iVertex ||
+				        copyNormal[copyTable[iSlot]] != iNormal))
+				{
+					iSlot = (iSlot + 1) & iMask;
+				}
+
+				// Can't find one, so create another copy
+				if (copyTable[iSlot] == kUnusedIndex)
+				{
+					copyTable[iSlot] = static_cast<TUInt32>(copySource.size());
+					copySource.push_back( iVertex );
+					copyNormal.push_back( iNormal );
+
+					// Grow the table when half full, reinserting the copies
+					if (copySource.size() * 2 > copyTable.size())
 					{
-						// Update the face indices to point at appropriate vertex duplicate
-						vertexFace.aiVertex[i] = iVert;
+						copyTable.assign( copyTable.size() * 2, kUnusedIndex );
+						iMask = static_cast<TUInt32>(copyTable.size()) - 1;
+						for (TUInt32 iCopy = 0; iCopy < copySource.size(); ++iCopy)
+						{
+							iSlot = HashIndexPair( copySource[iCopy], copyNormal[iCopy] ) & iMask;
+							while (copyTable[iSlot] != kUnusedIndex)
+							{
+								iSlot = (iSlot + 1) & iMask;
+							}
+							copyTable[iSlot] = iCopy;
+						}
+						iSlot = HashIndexPair( iVertex, iNormal ) & iMask;
+						while (copyTable[iSlot] != copySource.size() - 1)
+						{
+							iSlot = (iSlot + 1) & iMask;
+						}
 					}
 				}
+
+				// Update the face indices to point at the copy
+				vertexFace.aiVertex[i] = iNumVertices + copyTable[iSlot];
 			}
 		}
 
-		// Add any required duplicate vertex data (if necessary)
-		TUInt32 iOldNumVertices = static_cast<TUInt32>(mesh.vertices.size());
-		if (iNewNumVertices > iOldNumVertices)
+		// Add any required duplicate vertex data, copies follow the original vertices
+		TUInt32 iNumCopies = static_cast<TUInt32>(copySource.size());
+		if (iNumCopies > 0)
 		{
-			// For every added vertex...
-			for (TUInt32 iVertex = iOldNumVertices; iVertex < iNewNumVertices; ++iVertex)
+			mesh.vertices.reserve( iNumVertices + iNumCopies );
+			for (TUInt32 iCopy = 0; iCopy < iNumCopies; ++iCopy)
+			{
+				mesh.vertices.push_back( mesh.vertices[copySource[iCopy]] );
+			}
+			if (!mesh.textureCoords.empty())
 			{
-				// Use the vertex map to duplicate the various vertex data
-				mesh.vertices.push_back( mesh.vertices[vertexMap[iVertex]] );
-				if (!mesh.textureCoords.empty())
+				mesh.textureCoords.reserve( iNumVertices + iNumCopies );
+				for (TUInt32 iCopy = 0; iCopy < iNumCopies; ++iCopy)
 				{
-					mesh.textureCoords.push_back( mesh.textureCoords[vertexMap[iVertex]] );
+					mesh.textureCoords.push_back( mesh.textureCoords[copySource[iCopy]] );
 				}
-				if (!mesh.vertexColours.empty())
+			}
+			if (!mesh.vertexColours.empty())
+			{
+				mesh.vertexColours.reserve( iNumVertices + iNumCopies );
+				for (TUInt32 iCopy = 0; iCopy < iNumCopies; ++iCopy)
 				{
-					mesh.vertexColours.push_back( mesh.vertexColours[vertexMap[iVertex]] );
+					mesh.vertexColours.push_back( mesh.vertexColours[copySource[iCopy]] );
 				}
-				if (!mesh.duplicateIndices.empty())
+			}
+			if (!mesh.duplicateIndices.empty())
+			{
+				mesh.duplicateIndices.reserve( iNumVertices + iNumCopies );
+				for (TUInt32 iCopy = 0; iCopy < iNumCopies; ++iCopy)
 				{
-					mesh.duplicateIndices.push_back( mesh.duplicateIndices[vertexMap[iVertex]] );
+					mesh.duplicateIndices.push_back( mesh.duplicateIndices[copySource[iCopy]] );
 				}
 			}
 		}
 
-		// Build full updated normal list and replace original normals
-		TXFileVectors newNormals( iNewNumVertices );
-		for (TUInt32 iNormal = 0; iNormal < iNewNumVertices; ++iNormal)
+		// Build full updated normal list and replace original normals. Vertices not used by any
+		// face have no normal
+		TXFileVectors newNormals( iNumVertices + iNumCopies );
+		for (TUInt32 iVertex = 0; iVertex < iNumVertices; ++iVertex)
+		{
+			newNormals[iVertex] = (vertexNormal[iVertex] == kUnusedIndex) ? CVector3::kOrigin :
+			                      mesh.normals[vertexNormal[iVertex]];
+		}
+		for (TUInt32 iCopy = 0; iCopy < iNumCopies; ++iCopy)
 		{
-			newNormals[iNormal] = mesh.normals[normalMap[iNormal]];
+			newNormals[iNumVertices + iCopy] = mesh.normals[copyNormal[iCopy]];
 		}
 		mesh.normals.swap( newNormals );
 	}
@@ -1984,68 +1559,197 @@ EImportError CImportXFile::ProcessBones()
 	Mesh processing
 -----------------------------------------------------------------------------------------*/
 
-// Split each mesh into a set of meshes - each of which contains only a single material
+// Split each mesh into a set of meshes - each of which contains only a single material. Faces
+// are bucketed by material in a single pass, then each new mesh takes the vertices its faces use,
+// welding together any vertices with identical data
 void CImportXFile::SplitMeshes()
 {
 	GEN_GUARD;
 
-	TUInt32 iNumOrigMeshes = static_cast<TUInt32>(m_Meshes.size());
-	for (TUInt32 iMesh = 0; iMesh < iNumOrigMeshes; ++iMesh)
+	TXFileMeshes splitMeshes;
+	TXFileInts materialStart;
+	TXFileInts materialFaces;
+	TXFileInts vertexMaterial;
+	TXFileInts vertexMap;
+	TXFileInts newVertexSource;
+	TXFileInts weldTable;
+
+	for (TUInt32 iMesh = 0; iMesh < m_Meshes.size(); ++iMesh)
 	{
-		TUInt32 iMaxVertices = static_cast<TUInt32>(m_Meshes[iMesh].vertices.size());
+		// Unclutter code with a reference to the mesh 
+		const SXFileMesh& mesh = m_Meshes[iMesh];
+		TUInt32 iNumVertices = static_cast<TUInt32>(mesh.vertices.size());
+		TUInt32 iNumMaterials = static_cast<TUInt32>(mesh.materials.size());
+		TUInt32 iNumFaces = static_cast<TUInt32>(mesh.faceMaterials.size());
+
+		// Bucket the faces by material, keeping file order within each material (counting sort).
+		// Faces with invalid material indices are dropped
+		materialStart.assign( iNumMaterials + 1, 0 );
+		for (TUInt32 iFace = 0; iFace < iNumFaces; ++iFace)
+		{
+			if (mesh.faceMaterials[iFace] < iNumMaterials)
+			{
+				++materialStart[mesh.faceMaterials[iFace] + 1];
+			}
+		}
+		for (TUInt32 iMaterial = 0; iMaterial < iNumMaterials; ++iMaterial)
+		{
+			materialStart[iMaterial + 1] += materialStart[iMaterial];
+		}
+		materialFaces.resize( materialStart[iNumMaterials] );
+		TXFileInts nextFace( materialStart.begin(), materialStart.end() - 1 );
+		for (TUInt32 iFace = 0; iFace < iNumFaces; ++iFace)
+		{
+			if (mesh.faceMaterials[iFace] < iNumMaterials)
+			{
+				materialFaces[nextFace[mesh.faceMaterials[iFace]]++] = iFace;
+			}
+		}
 
-		for (TUInt32 iMaterial = 0; iMaterial < m_Meshes[iMesh].materials.size(); ++iMaterial)
+		// Vertices already taken by the current material, marked with the material index so the
+		// map doesn't need clearing between materials
+		vertexMaterial.assign( iNumVertices, kUnusedIndex );
+		vertexMap.resize( iNumVertices );
+
+		for (TUInt32 iMaterial = 0; iMaterial < iNumMaterials; ++iMaterial)
 		{
-			SXFileMesh newMesh;
-			newMesh.iParentFrame = m_Meshes[iMesh].iParentFrame;
-			newMesh.materials.push_back( m_Meshes[iMesh].materials[iMaterial] );
-			newMesh.materialMap.push_back( m_Meshes[iMesh].materialMap[iMaterial] );
+			TUInt32 iFirstFace = materialStart[iMaterial];
+			TUInt32 iNumMaterialFaces = materialStart[iMaterial + 1] - iFirstFace;
+			if (iNumMaterialFaces == 0)
+			{
+				continue;
+			}
 
-			TXFileInts vertexMap( iMaxVertices, iMaxVertices );
+			splitMeshes.push_back( SXFileMesh() );
+			SXFileMesh& newMesh = splitMeshes.back();
+			newMesh.iParentFrame = mesh.iParentFrame;
+			newMesh.materials.push_back( mesh.materials[iMaterial] );
+			newMesh.materialMap.push_back( mesh.materialMap[iMaterial] );
+			newMesh.faceMaterials.assign( iNumMaterialFaces, 0 );
+			newMesh.faces.resize( iNumMaterialFaces );
+
+			// Hash table of new vertices by their data, holding new vertex indices. Power of 2
+			// size, at most half full
+			TUInt32 iMaxNewVertices = Min( iNumMaterialFaces * 3, iNumVertices );
+			TUInt32 iTableSize = 16;
+			while (iTableSize < iMaxNewVertices * 2)
+			{
+				iTableSize *= 2;
+			}
+			weldTable.assign( iTableSize, kUnusedIndex );
+			TUInt32 iMask = iTableSize - 1;
+			newVertexSource.clear();
 
-			for (TUInt32 iFace = 0; iFace < m_Meshes[iMesh].faceMaterials.size(); ++iFace)
+			for (TUInt32 iFace = 0; iFace < iNumMaterialFaces; ++iFace)
 			{
-				if (m_Meshes[iMesh].faceMaterials[iFace] == iMaterial)
+				const SXFileFace& face = mesh.faces[materialFaces[iFirstFace + iFace]];
+				for (TUInt32 iIndex = 0; iIndex < 3; ++iIndex)
 				{
-					newMesh.faceMaterials.push_back( 0 );
-					SXFileFace newFace;
-					for (TUInt32 iIndex = 0; iIndex < 3; ++iIndex)
+					TUInt32 iVert = face.aiVertex[iIndex];
+					if (vertexMaterial[iVert] != iMaterial)
 					{
-						TUInt32 iVert = m_Meshes[iMesh].faces[iFace].aiVertex[iIndex];
-						if (vertexMap[iVert] == iMaxVertices)
+						// First use of this vertex by the material - look for an identical vertex
+						// already added, otherwise add it
+						TUInt32 iSlot = HashVertex( mesh, iVert ) & iMask;
+						while (weldTable[iSlot] != kUnusedIndex &&
+						       !VerticesEqual( mesh, newVertexSource[weldTable[iSlot]], iVert ))
 						{
-							vertexMap[iVert] = static_cast<TUInt32>(newMesh.vertices.size());
-							newMesh.vertices.push_back( m_Meshes[iMesh].vertices[iVert] );
-							if (m_Meshes[iMesh].normals.size() > 0)
-							{
-								newMesh.normals.push_back( m_Meshes[iMesh].normals[iVert] );
-							}
-							if (m_Meshes[iMesh].textureCoords.size() > 0)
-							{
-								newMesh.textureCoords.push_back( m_Meshes[iMesh].textureCoords[iVert] );
-							}
-							if (m_Meshes[iMesh].vertexColours.size() > 0)
-							{
-								newMesh.vertexColours.push_back( m_Meshes[iMesh].vertexColours[iVert] );
-							}
+							iSlot = (iSlot + 1) & iMask;
 						}
-						newFace.aiVertex[iIndex] = vertexMap[iVert];
+						if (weldTable[iSlot] == kUnusedIndex)
+						{
+							weldTable[iSlot] = static_cast<TUInt32>(newVertexSource.size());
+							newVertexSource.push_back( iVert );
+						}
+						vertexMaterial[iVert] = iMaterial;
+						vertexMap[iVert] = weldTable[iSlot];
 					}
-					newMesh.faces.push_back( newFace );
+					newMesh.faces[iFace].aiVertex[iIndex] = vertexMap[iVert];
 				}
 			}
-			if (newMesh.vertices.size() > 0)
+
+			// Copy the data for the new vertices
+			TUInt32 iNumNewVertices = static_cast<TUInt32>(newVertexSource.size());
+			newMesh.vertices.resize( iNumNewVertices );
+			for (TUInt32 iVert = 0; iVert < iNumNewVertices; ++iVert)
+			{
+				newMesh.vertices[iVert] = mesh.vertices[newVertexSource[iVert]];
+			}
+			if (!mesh.normals.empty())
 			{
-				m_Meshes.push_back( newMesh );
+				newMesh.normals.resize( iNumNewVertices );
+				for (TUInt32 iVert = 0; iVert < iNumNewVertices; ++iVert)
+				{
+					newMesh.normals[iVert] = mesh.normals[newVertexSource[iVert]];
+				}
+			}
+			if (!mesh.textureCoords.empty())
+			{
+				newMesh.textureCoords.resize( iNumNewVertices );
+				for (TUInt32 iVert = 0; iVert < iNumNewVertices; ++iVert)
+				{
+					newMesh.textureCoords[iVert] = mesh.textureCoords[newVertexSource[iVert]];
+				}
+			}
+			if (!mesh.vertexColours.empty())
+			{
+				newMesh.vertexColours.resize( iNumNewVertices );
+				for (TUInt32 iVert = 0; iVert < iNumNewVertices; ++iVert)
+				{
+					newMesh.vertexColours[iVert] = mesh.vertexColours[newVertexSource[iVert]];
+				}
 			}
 		}
 	}
-	m_Meshes.erase( m_Meshes.begin(), m_Meshes.begin() + iNumOrigMeshes );
+	m_Meshes.swap( splitMeshes );
 
 	GEN_ENDGUARD;
 }
 
 
+// Hash of the data of a vertex in the given mesh - position and any normal, UV or colour
+TUInt32 CImportXFile::HashVertex
+(
+	const SXFileMesh& mesh,
+	const TUInt32     iVertex
+)
+{
+	TUInt32 iHash = HashFloats( &mesh.vertices[iVertex].x, 3, 0 );
+	if (!mesh.normals.empty())
+	{
+		iHash = HashFloats( &mesh.normals[iVertex].x, 3, iHash );
+	}
+	if (!mesh.textureCoords.empty())
+	{
+		iHash = HashFloats( &mesh.textureCoords[iVertex].fU, 2, iHash );
+	}
+	if (!mesh.vertexColours.empty())
+	{
+		iHash = HashFloats( &mesh.vertexColours[iVertex].fRed, 4, iHash );
+	}
+	return iHash;
+}
+
+// Test if two vertices in the given mesh have identical data (bitwise, so 0 and -0 differ)
+bool CImportXFile::VerticesEqual
+(
+	const SXFileMesh& mesh,
+	const TUInt32     iVertexA,
+	const TUInt32     iVertexB
+)
+{
+	return !memcmp( &mesh.vertices[iVertexA], &mesh.vertices[iVertexB], sizeof(CVector3) ) &&
+	       (mesh.normals.empty() ||
+	        !memcmp( &mesh.normals[iVertexA], &mesh.normals[iVertexB], sizeof(CVector3) )) &&
+	       (mesh.textureCoords.empty() ||
+	        !memcmp( &mesh.textureCoords[iVertexA], &mesh.textureCoords[iVertexB],
+	                 sizeof(SXFileUV) )) &&
+	       (mesh.vertexColours.empty() ||
+	        !memcmp( &mesh.vertexColours[iVertexA], &mesh.vertexColours[iVertexB],
+	                 sizeof(SXFileRGBAColour) ));
+}
+
+
 // Create a list of tangent vectors for the given mesh. The tangent vector is the direction of
 // a vertex's texture U axis in model-space. Returns true on success
 bool CImportXFile::CalculateTangents
@@ -16,12 +16,11 @@
 
 #include <vector>
 using namespace std;
-#include <d3d9.h>
-#include <d3dx9.h>
 
 #include "../Math/CVector3.h"
 #include "../Math/CMatrix4x4.h"
-#include "Mesh.h"
+#include "MeshData.h"
+#include "XFileParser.h"
 
 namespace gen
 {
@@ -75,9 +74,9 @@ public:
 	// Possible return values:
 	//		kSuccess:			...
 	//		kFileError:			Missing file or not an X-file
-	//		kInvalidData:		The file could not be parsed correctly, or contains invalid data
+	//		kInvalidData:		The file could not be parsed correctly, or contains invalid data.
+	//						Compressed X-files are not supported
 	//		kOutOfSystemMemory:	...
-	//		kSystemFailure:		X-file API failure
 	EImportError ImportFile
 	(
 		const string& sXName
@@ -111,15 +110,18 @@ public:
 	ERenderMethod GetSubMeshRenderMethod( const TUInt32 iSubMesh ) const;
 		
 	// Get the specification and data for given submesh, returned through a pointer. May request
-	// tangents to be calculated
+	// tangents to be calculated. Faces and vertices are reordered for rendering unless not
+	// required (see MeshOptimiser.h). Sub-meshes with more vertices than 16-bit indices can address
+	// are returned with large faces
 	// Possible return values:
 	//		kSuccess:			...
 	//		kOutOfSystemMemory:	...
-	EImportError CImportXFile::GetSubMesh
+	EImportError GetSubMesh
 	(
 		const TUInt32 iSubMesh,
 		SSubMesh*     pSubMesh,
-		bool          bTangents = false
+		bool          bTangents = false,
+		bool          bOptimise = true
 	) const;
 
 
@@ -327,32 +329,6 @@ private:
 	typedef vector<SXFileMesh> TXFileMeshes;
 
 
-	/////////////////////////////////////
-	// X-File API support
-
-	// Prepare and return an X-file object
-	// Possible return values:
-	//		kSuccess:			...
-	//		kOutOfSystemMemory:	...
-	//		kSystemFailure:		Problem registering X-file templates or other API error
-	EImportError PrepareXFileObject
-	(
-		ID3DXFile** ppXFile
-	);
-
-	// Prepare and return an X-file enumerator given a filename and an X-file object
-	// Possible return values:
-	//		kSuccess:			...
-	//		kInvalidData:		The file could not be parsed correctly, or contains invalid data
-	//		kSystemFailure:		X-file API error
-	EImportError GetXFileEnumerator
-	(
-		const string&         sFilename,
-		ID3DXFile*            pXFile,
-		ID3DXFileEnumObject** ppXFileEnumer
-	);
-
-
 	/////////////////////////////////////
 	// X-File parsing
 
@@ -363,7 +339,7 @@ private:
 	//		kInvalidData:		The file could not be parsed correctly, or contains invalid data
 	EImportError ParseXFile
 	(
-		ID3DXFileEnumObject* pXFileEnumer
+		CXFileParser* pParser
 	);
 
 	// Create a new frame and parse the X-File to add all the contained frames and meshes. Any
@@ -373,163 +349,98 @@ private:
 	//		kInvalidData:		The file could not be parsed correctly, or contains invalid data
 	EImportError ParseXFileFrame
 	(
-		ID3DXFileData* pXFileData,
-		const TUInt32  iParentFrame
+		CXFileParser*       pParser,
+		const SXFileObject& frame,
+		const TUInt32       iParentFrame
 	);
 
 
 	// X-File parsing - collect mesh data
 	EImportError ParseXFileMesh
 	(
-		ID3DXFileData* pXFileData,
-		const TUInt32  iCurrFrame
+		CXFileParser* pParser,
+		const TUInt32 iCurrFrame
 	);
 
 
 	/////////////////////////////////////
 	// X-File template parsing
 
+	// Read a polygon list, converting each polygon into triangles. Used for the faces of a mesh
+	// and its normals, indices must be less than the given number of vertices or normals. Original
+	// number of edges of each face is returned if required, otherwise the face edges must match
+	// those given
+	EImportError ReadFaceData
+	(
+		CXFileParser* pParser,
+		const TUInt32 iNumIndices,
+		TXFileFaces*  pFaces,
+		TXFileInts*   pFaceEdges,
+		bool          bReadEdges
+	);
+
 	// Read vertex and face data from a mesh template
 	EImportError ReadMeshData
 	(
-		ID3DXFileData* pXFileData,
-		const TUInt32  iMesh
+		CXFileParser* pParser,
+		const TUInt32 iMesh
 	);
 
 	// Read a normal data mesh template
 	EImportError ReadNormalData
 	(
-		ID3DXFileData* pXFileData,
-		const TUInt32  iMesh
+		CXFileParser* pParser,
+		const TUInt32 iMesh
 	);
 
 	// Read a texture coordinate mesh template
 	EImportError ReadTextureUVData
 	(
-		ID3DXFileData* pXFileData,
-		const TUInt32  iMesh
+		CXFileParser* pParser,
+		const TUInt32 iMesh
 	);
 
 	// Read a vertex colour mesh template
 	EImportError ReadVertexColourData
 	(
-		ID3DXFileData* pXFileData,
-		const TUInt32  iMesh
+		CXFileParser* pParser,
+		const TUInt32 iMesh
 	);
 
-	// Read a vertex colour mesh template
+	// Read a material list mesh template
 	EImportError ReadMaterialData
 	(
-		ID3DXFileData* pXFileData,
-		const TUInt32  iMesh
+		CXFileParser* pParser,
+		const TUInt32 iMesh
 	);
 
 	// Read a vertex duplication mesh template
 	EImportError ReadDuplicationData
 	(
-		ID3DXFileData* pXFileData,
-		const TUInt32  iMesh
+		CXFileParser* pParser,
+		const TUInt32 iMesh
 	);
 
 	// Read a adjacancy data mesh template
 	EImportError ReadAdjacencyData
 	(
-		ID3DXFileData* pXFileData,
-		const TUInt32  iMesh
+		CXFileParser* pParser,
+		const TUInt32 iMesh
 	);
 
 	// Read skinning header mesh template
 	EImportError ReadSkinDefnData
 	(
-		ID3DXFileData* pXFileData,
-		const TUInt32  iMesh
+		CXFileParser* pParser,
+		const TUInt32 iMesh
 	);
 
 	// Read a skinning weights mesh template
 	EImportError ReadSkinWeightsData
 	(
-		ID3DXFileData* pXFileData,
-		const TUInt32  iMesh,
-		const TUInt32  iBone
-	);
-
-
-	/////////////////////////////////////
-	// X-File parsing support
-
-	EImportError GetXFileNumChildren
-	(
-		ID3DXFileEnumObject* pXFileEnumer, 
-		TUInt32*             iNumChildren
-	);
-
-	EImportError GetXFileNumChildren
-	(
-		ID3DXFileData* pXFileData,
-		TUInt32*       iNumChildren
-	);
-
-
-	EImportError GetXFileChild
-	(
-		ID3DXFileEnumObject* pXFileEnumer,
-		const TUInt32        iChild, 
-		ID3DXFileData**      ppChildData, 
-		GUID*                pChildGUID
-	);
-
-	EImportError GetXFileChild
-	(
-		ID3DXFileData*  pXFileData,
-		const TUInt32   iChild, 
-		ID3DXFileData** ppChildData, 
-		GUID*           pChildGUID
-	);
-
-
-	EImportError GetXFileDataName
-	(
-		ID3DXFileData* pXFileData,
-		string&        sName
-	);
-
-
-	EImportError LockXFileData
-	(
-		ID3DXFileData* pXFileData,
-		const TUInt8** ppLockData,
-		TUInt32*       pSize = 0
-	);
-
-	void UnlockXFileData
-	(
-		ID3DXFileData* pXFileData
-	);
-
-	EImportError CopyXFileData
-	(
-		ID3DXFileData* pXFileData,
-		TUInt8*        pDest,
-		TUInt32*       pSize
-	);
-
-	void ReadXFileLockedData
-	(
-		const   TUInt8*& pMeshData,
-		TUInt8*	         pDest,
-		const   TUInt32  iSize
-	);
-
-	void ReadXFileLockedUInt
-	(
-		const TUInt8*& pMeshData,
-		TUInt32*       piDest
-	);
-
-	void ReadXFileLockedUInt16
-	(
-		const TUInt8*& pMeshData,
-		TUInt16*       piDest
+		CXFileParser* pParser,
+		const TUInt32 iMesh,
+		const TUInt32 iBone
 	);
 
 
@@ -562,9 +473,25 @@ private:
 	/////////////////////////////////////
 	// Mesh processing
 
-	// Split each mesh into a set of meshes - each of which contains only a single material
+	// Split each mesh into a set of meshes - each of which contains only a single material,
+	// welding together identical vertices
 	void SplitMeshes();
 
+	// Hash of the data of a vertex in the given mesh - position and any normal, UV or colour
+	static TUInt32 HashVertex
+	(
+		const SXFileMesh& mesh,
+		const TUInt32     iVertex
+	);
+
+	// Test if two vertices in the given mesh have identical data
+	static bool VerticesEqual
+	(
+		const SXFileMesh& mesh,
+		const TUInt32     iVertexA,
+		const TUInt32     iVertexB
+	);
+
 	// Create a list of tangent vectors for the given mesh. The tangent vector is the direction of
 	// a vertex's texture U axis in model-space. Returns true on success
 	bool CalculateTangents
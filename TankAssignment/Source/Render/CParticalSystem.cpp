@@ -108,10 +108,13 @@ CParticalSystem::CParticalSystem()
 CParticalSystem::~CParticalSystem()
 {
 	// Release DirectX allocated objects
+	delete EffectSorter;
+	SAFE_RELEASE(EffectBuffer);
 	SAFE_RELEASE(ParticleBufferTo);
 	SAFE_RELEASE(ParticleBufferFrom);
 	SAFE_RELEASE(ParticleLayout);
 	SAFE_RELEASE(GS_ConstBuffer);
+	SAFE_RELEASE(PS_TexPremultiplied);
 	SAFE_RELEASE(PS_TexOnly);
 	SAFE_RELEASE(GS_ParticlesDraw);
 	SAFE_RELEASE(GS_ParticlesUpdate);
@@ -121,6 +124,45 @@ CParticalSystem::~CParticalSystem()
 }
 
 void CParticalSystem::Render()
+{
+	DrawParticles(ParticleBufferFrom, NumParticles);
+}
+
+// Copy the live particles of the CPU effects into the dynamic buffer and draw them like the GPU ones.
+// If sorting, the particles are gathered into the staging copy and written to the buffer furthest first
+void CParticalSystem::RenderEffects(const CEmitterPool& effects)
+{
+	if (!EffectBuffer || effects.NumLiveParticles() == 0 || effects.ParticleBudget() > EffectBufferSize)
+		return;
+
+	SParticleVertex* vertices;
+	if (FAILED(EffectBuffer->Map(D3D10_MAP_WRITE_DISCARD, 0, (void**)&vertices)))
+		return;
+	unsigned int numParticles;
+	if (SortEffects)
+	{
+		numParticles = effects.GatherParticles(&EffectStaging[0]);
+		CVector3 viewDirection = MainCamera->Matrix().ZAxis();
+		viewDirection.Normalise();
+		const TUInt32* order = EffectSorter->Sort(&EffectStaging[0], numParticles, MainCamera->Position(), viewDirection);
+		for (unsigned int p = 0; p < numParticles; ++p)
+		{
+			vertices[p] = EffectStaging[order[p]];
+		}
+	}
+	else
+	{
+		numParticles = effects.GatherParticles(vertices);
+	}
+	EffectBuffer->Unmap();
+
+	DrawParticles(EffectBuffer, numParticles, SortEffects);
+
+	// The effect file sets its own shaders, but not a geometry shader
+	SetGeometryShader(0);
+}
+
+void CParticalSystem::DrawParticles(ID3D10Buffer* buffer, unsigned int numParticles, bool sorted /*= false*/)
 {
 	//////////////////////////
 	// Particle Rendering
@@ -130,7 +172,8 @@ void CParticalSystem::Render()
 	// The pixel shader is a very simple texture-only shader
 	SetVertexShader(VS_PassThruGS);
 	SetGeometryShader(GS_ParticlesDraw);
-	SetPixelShader(PS_TexOnly);
+	SetPixelShader(sorted ? PS_TexPremultiplied : PS_TexOnly);
+	SetGeometryConstantBuffer(GS_ConstBuffer);
 
 	// Set constants for geometry shader, it needs the view/projection matrix to transform the
 	// particles to 2D. It also needs the inverse view matrix (the camera's world matrix effectively)
@@ -143,22 +186,26 @@ void CParticalSystem::Render()
 	GS_Consts->InvViewMatrix = invViewMatrix;
 	GS_ConstBuffer->Unmap();
 
-	// Select a texture and set up additive blending (using helper function above)
+	// Select a texture and set up additive blending (using helper function above), which doesn't need
+	// sorting. Sorted particles use premultiplied alpha blending, which only looks right back to front
 	SetTexture(0, ParticleTexture);
-	BlendEnable(true, D3D10_BLEND_ONE, D3D10_BLEND_ONE);
+	if (sorted)
+		BlendEnable(true, D3D10_BLEND_ONE, D3D10_BLEND_INV_SRC_ALPHA);
+	else
+		BlendEnable(true, D3D10_BLEND_ONE, D3D10_BLEND_ONE);
 	DepthStencilEnable(true, false, false); // Fix sorting for blending
 
 	// Set up particle vertex buffer / layout
 	unsigned int particleVertexSize = sizeof(SParticle);
 	unsigned int offset = 0;
-	g_pd3dDevice->IASetVertexBuffers(0, 1, &ParticleBufferFrom, &particleVertexSize, &offset);
+	g_pd3dDevice->IASetVertexBuffers(0, 1, &buffer, &particleVertexSize, &offset);
 	g_pd3dDevice->IASetInputLayout(ParticleLayout);
 
 	// Indicate that this is a point list and render it
 	g_pd3dDevice->IASetPrimitiveTopology(D3D10_PRIMITIVE_TOPOLOGY_POINTLIST);
-	g_pd3dDevice->Draw(NumParticles, 0);
+	g_pd3dDevice->Draw(numParticles, 0);
 
-	// Disable additive blending
+	// Disable blending
 	DepthStencilEnable();
 	BlendEnable(false);
 }
@@ -202,14 +249,15 @@ void CParticalSystem::Update(TFloat32 updateTime)
 	ParticleBufferTo = temp;
 }
 
-bool CParticalSystem::Setup()
+bool CParticalSystem::Setup(TUInt32 maxEffectParticles /*= kDefaultEffectParticles*/)
 {
 	if (!LoadVertexShader("Source\\Render\\PassThruGS.vsh", &VS_PassThruGS, &VSCode_PassThruGS) ||
 		!LoadStreamOutGeometryShader("Source\\Render\\DX10ParticlesUpdate.gsh", ParticleStreamOutDecl,
 			sizeof(ParticleStreamOutDecl) / sizeof(D3D10_SO_DECLARATION_ENTRY),
 			sizeof(SParticle), &GS_ParticlesUpdate) ||
 		!LoadGeometryShader("Source\\Render\\DX10ParticlesDraw.gsh", &GS_ParticlesDraw) ||
-		!LoadPixelShader("Source\\Render\\TexOnly.psh", &PS_TexOnly))
+		!LoadPixelShader("Source\\Render\\TexOnly.psh", &PS_TexOnly) ||
+		!LoadPixelShader("Source\\Render\\TexPremultiplied.psh", &PS_TexPremultiplied))
 		return false;
 
 	// Create constant buffers to access global variables in shaders. The buffers sized to hold the structures
@@ -261,6 +309,20 @@ bool CParticalSystem::Setup()
 	}
 	delete[] particles;
 
+	// Dynamic buffer for the CPU effects, rewritten by the CPU each frame
+	static_assert(sizeof(SParticleVertex) == sizeof(SParticle), "CPU effect particles must match the vertex layout");
+	bufferDesc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
+	bufferDesc.Usage = D3D10_USAGE_DYNAMIC;
+	bufferDesc.ByteWidth = maxEffectParticles * sizeof(SParticle);
+	bufferDesc.CPUAccessFlags = D3D10_CPU_ACCESS_WRITE;
+	if (FAILED(g_pd3dDevice->CreateBuffer(&bufferDesc, 0, &EffectBuffer)))
+		return false;
+	EffectBufferSize = maxEffectParticles;
+
+	// Staging copy and sorter for sorted effects. The effects are few enough to sort on the main thread
+	EffectStaging.resize(maxEffectParticles);
+	EffectSorter = new CParticleSorter(maxEffectParticles);
+
 	return true;
 }
 
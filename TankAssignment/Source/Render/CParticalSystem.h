@@ -1,5 +1,7 @@
 #pragma once
 #include "Shader.h"   // Vertex / pixel shader support
+#include "EmitterPool.h" // CPU particle effects
+#include "ParticleSort.h" // Back to front order for blended effects
 
 namespace gen
 {
@@ -15,6 +17,7 @@ private:
 	ID3D10GeometryShader* GS_ParticlesUpdate = NULL;
 	ID3D10GeometryShader* GS_ParticlesDraw = NULL;
 	ID3D10PixelShader*    PS_TexOnly = NULL;
+	ID3D10PixelShader*    PS_TexPremultiplied = NULL;
 
 	// Retained vertex shader code for DX10
 	ID3D10Blob* VSCode_PassThruGS = NULL;
@@ -101,6 +104,17 @@ private:
 	ID3D10Buffer* ParticleBufferFrom;
 	ID3D10Buffer* ParticleBufferTo;
 
+	// Dynamic buffer of the same layout that the live particles of the CPU effects are copied into
+	// each frame, and the number of particles it holds
+	ID3D10Buffer* EffectBuffer = NULL;
+	unsigned int  EffectBufferSize = 0;
+
+	// Sorted effects are drawn back to front with alpha blending rather than additively. They are
+	// gathered into a staging copy, sorted, then copied to the buffer in order
+	bool                    SortEffects = false;
+	CParticleSorter*        EffectSorter = NULL;
+	vector<SParticleVertex> EffectStaging;
+
 	// Third specification is for the data that will be updated using the stream out stage. This array indicates which
 	// outputs of the vertex or geometry shader will be streamed back into GPU memory. Again, in this case the structure
 	// below must match the SParticle structure above (although more complex stream out arrangements are possible)
@@ -113,14 +127,31 @@ private:
 	};
 
 
+	// Draw the given particle buffer with the particle draw shaders. Additive blending is used
+	// unless the particles are sorted back to front, when premultiplied alpha blending is used
+	void DrawParticles(ID3D10Buffer* buffer, unsigned int numParticles, bool sorted = false);
+
 public:
 	CParticalSystem();
 	~CParticalSystem();
 
 	void Render();
 	void Update(TFloat32 updateTime);
-	bool Setup();
+	bool Setup(TUInt32 maxEffectParticles = kDefaultEffectParticles);
 	void ResetParticles();
+
+	// Draw the live particles of the given CPU effects (the effects are updated by their owner)
+	void RenderEffects(const CEmitterPool& effects);
+
+	// Draw the CPU effects sorted back to front with alpha blending, or unsorted and additive
+	void SetSortEffects(bool sort)
+	{
+		SortEffects = sort;
+	}
+	bool GetSortEffects() const
+	{
+		return SortEffects;
+	}
 };
 }
 
@@ -8,7 +8,9 @@
 #ifndef GEN_COLOUR_H_INCLUDED
 #define GEN_COLOUR_H_INCLUDED
 
-#include <d3dx9.h>
+#ifdef _WIN32
+	#include <d3dx9.h>
+#endif
 
 #include "../Common/Defines.h"
 
@@ -34,6 +36,7 @@ struct SColourRGBA
 inline SColourRGBA operator*( const SColourRGBA& c, const TFloat32 s ) { return SColourRGBA(c.r*s, c.g*s, c.b*s, c.a); }
 inline SColourRGBA operator*( const TFloat32 s, const SColourRGBA& c ) { return SColourRGBA(c.r*s, c.g*s, c.b*s, c.a); }
 
+#ifdef _WIN32
 // Reinterpret a SColourRGBA as a D3DXCOLOR - in various forms (const & ptr)
 inline D3DXCOLOR& ToD3DXCOLOR( SColourRGBA& colour )
 {
@@ -44,6 +47,7 @@ inline const D3DXCOLOR& ToD3DXCOLOR( const SColourRGBA& colour )
 {
 	return *reinterpret_cast<const D3DXCOLOR*>(&colour);
 }
+#endif
 
 
 } // namespace gen
@@ -0,0 +1,352 @@
+/*******************************************
+	EmitterPool.cpp
+
+	Particle effect emitter pool, see header
+********************************************/
+
+#include "EmitterPool.h"
+#include "../Common/Profiler.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// Effect descriptions
+//-----------------------------------------------------------------------------
+
+// Indexed by EParticleEffect. Deaths matter most, then pickups (rare and tell the player
+// something), then impacts (frequent and short). Used unless replaced by presets
+static const SParticleEffectDesc kEffectDescs[] =
+{
+	//  priority  max  burst  rate   time  life        speed        up     shape                     forces
+	{   1,        96,  64,      0.0f, 0.0f, 0.3f, 0.8f,  5.0f, 15.0f,  4.0f, EEmitterShape::Point, 0.0f,
+	    CVector3( 0.0f, kParticleGravity, 0.0f ), 0.0f }, // ShellImpact
+	{   3,       512, 256,    400.0f, 0.5f, 1.0f, 2.0f, 10.0f, 30.0f, 15.0f, EEmitterShape::Point, 0.0f,
+	    CVector3( 0.0f, kParticleGravity, 0.0f ), 0.0f }, // TankDeath
+	{   2,       128,   0,    200.0f, 0.5f, 0.5f, 1.0f,  1.0f,  3.0f,  8.0f, EEmitterShape::Point, 0.0f,
+	    CVector3( 0.0f, kParticleGravity, 0.0f ), 0.0f }, // AmmoPickup
+};
+static_assert( sizeof(kEffectDescs) / sizeof(kEffectDescs[0]) == static_cast<int>(EParticleEffect::NumEffects),
+               "One description needed for each particle effect" );
+
+// Indexed by EParticleEffect
+static const char* const kEffectNames[] =
+{
+	"ShellImpact",
+	"TankDeath",
+	"AmmoPickup",
+};
+static_assert( sizeof(kEffectNames) / sizeof(kEffectNames[0]) == static_cast<int>(EParticleEffect::NumEffects),
+               "One name needed for each particle effect" );
+
+const char* ParticleEffectName( EParticleEffect effect )
+{
+	return kEffectNames[static_cast<int>(effect)];
+}
+
+// Whether an effect description can be used by an emitter
+bool IsValidEffectDesc( const SParticleEffectDesc& desc )
+{
+	return desc.maxParticles > 0 && desc.maxParticles <= kMaxEmitterParticles &&
+	       desc.shape < EEmitterShape::NumShapes && desc.shapeSize >= 0.0f &&
+	       desc.emitRate >= 0.0f && desc.emitTime >= 0.0f && desc.drag >= 0.0f &&
+	       desc.minLife <= desc.maxLife && desc.minSpeed <= desc.maxSpeed;
+}
+
+
+//-----------------------------------------------------------------------------
+// Construction
+//-----------------------------------------------------------------------------
+
+// Construct a pool of emitters sharing the given particle budget. All memory is allocated here
+CEmitterPool::CEmitterPool( TUInt32 particleBudget /*= kDefaultEffectParticles*/ )
+	: m_Particles( kMaxEmitters * kMaxEmitterParticles )
+{
+	for (TUInt32 effect = 0; effect < static_cast<TUInt32>(EParticleEffect::NumEffects); ++effect)
+	{
+		m_EffectDescs[effect] = &kEffectDescs[effect];
+	}
+
+	m_ParticleBudget = Min( particleBudget, kMaxEmitters * kMaxEmitterParticles );
+	m_ParticlesReserved = 0;
+	m_NumLive = 0;
+
+	m_NumActive = 0;
+	m_NumFree = kMaxEmitters;
+	for (TUInt32 emitter = 0; emitter < kMaxEmitters; ++emitter)
+	{
+		m_Free[emitter] = kMaxEmitters - 1 - emitter; // Lowest index used first
+	}
+	ResetStats();
+}
+
+
+//-----------------------------------------------------------------------------
+// Effects
+//-----------------------------------------------------------------------------
+
+// Start an effect at the given world position, culling lower priority emitters to make room if
+// necessary. Returns false if the effect could not be started
+bool CEmitterPool::StartEffect( EParticleEffect effect, const CVector3& position )
+{
+	return StartEffect( *m_EffectDescs[static_cast<int>(effect)], position );
+}
+
+// Start an effect from any description, which must stay valid while the effect is running
+bool CEmitterPool::StartEffect( const SParticleEffectDesc& effectDesc, const CVector3& position )
+{
+	const SParticleEffectDesc* desc = &effectDesc;
+	if (!IsValidEffectDesc( *desc ))
+	{
+		++m_Stats.effectsDropped;
+		return false;
+	}
+	if (!CanMakeRoom( *desc ))
+	{
+		++m_Stats.effectsDropped;
+		return false;
+	}
+	while (m_NumFree == 0 || m_ParticlesReserved + desc->maxParticles > m_ParticleBudget)
+	{
+		CullEmitter( desc->priority );
+	}
+
+	TUInt32 emitterIndex = m_Free[--m_NumFree];
+	m_Active[m_NumActive++] = emitterIndex;
+	m_ParticlesReserved += desc->maxParticles;
+
+	SEmitter& emitter = m_Emitters[emitterIndex];
+	emitter.desc = desc;
+	emitter.position = position;
+	emitter.age = 0.0f;
+	emitter.spawnCarry = 0.0f;
+	emitter.nextParticle = 0;
+	emitter.numUsed = 0;
+	emitter.numLive = 0;
+	for (TUInt32 particle = 0; particle < desc->burstParticles; ++particle)
+	{
+		SpawnParticle( emitter, emitterIndex );
+	}
+	m_NumLive += emitter.numLive;
+
+	++m_Stats.effectsStarted;
+	m_Stats.peakEmitters = Max( m_Stats.peakEmitters, m_NumActive );
+	return true;
+}
+
+// Replace the description used for an effect, 0 for the built-in one
+bool CEmitterPool::SetEffectDesc( EParticleEffect effect, const SParticleEffectDesc* desc )
+{
+	if (desc && !IsValidEffectDesc( *desc ))
+	{
+		return false;
+	}
+	m_EffectDescs[static_cast<int>(effect)] = desc ? desc : &kEffectDescs[static_cast<int>(effect)];
+	return true;
+}
+
+// Stop all effects immediately
+void CEmitterPool::StopAll()
+{
+	while (m_NumActive > 0)
+	{
+		StopEmitter( m_NumActive - 1 );
+	}
+	m_NumLive = 0;
+}
+
+// Spawn and move the particles of each emitter, recycling emitters whose effect is over. Existing
+// particles are moved before new ones are spawned, so new particles start at the emitter
+void CEmitterPool::Update( TFloat32 updateTime )
+{
+	GEN_PROFILE_ZONE( "CEmitterPool::Update" );
+
+	m_NumLive = 0;
+	TUInt32 active = 0;
+	while (active < m_NumActive)
+	{
+		TUInt32 emitterIndex = m_Active[active];
+		SEmitter& emitter = m_Emitters[emitterIndex];
+		const SParticleEffectDesc& desc = *emitter.desc;
+
+		emitter.numLive = m_Particles.UpdateRange( emitterIndex * kMaxEmitterParticles, emitter.numUsed, updateTime,
+		                                           desc.acceleration, desc.drag );
+
+		// Only the part of this update inside the emitting time spawns particles
+		TFloat32 emitTime = Max( Min( emitter.age + updateTime, desc.emitTime ) - emitter.age, 0.0f );
+		emitter.age += updateTime;
+		emitter.spawnCarry += desc.emitRate * emitTime;
+		while (emitter.spawnCarry >= 1.0f)
+		{
+			SpawnParticle( emitter, emitterIndex );
+			emitter.spawnCarry -= 1.0f;
+		}
+
+		if (emitter.age >= desc.emitTime && emitter.numLive == 0)
+		{
+			StopEmitter( active ); // Last active emitter moves into this position
+		}
+		else
+		{
+			m_NumLive += emitter.numLive;
+			++active;
+		}
+	}
+	m_Stats.peakParticles = Max( m_Stats.peakParticles, m_NumLive );
+}
+
+// Copy the live particles of all emitters to the output. Returns the number copied
+TUInt32 CEmitterPool::GatherParticles( SParticleVertex* output ) const
+{
+	TUInt32 numParticles = 0;
+	for (TUInt32 active = 0; active < m_NumActive; ++active)
+	{
+		TUInt32 emitterIndex = m_Active[active];
+		numParticles += m_Particles.GatherLive( emitterIndex * kMaxEmitterParticles, m_Emitters[emitterIndex].numUsed,
+		                                        output + numParticles );
+	}
+	return numParticles;
+}
+
+
+//-----------------------------------------------------------------------------
+// Support functions
+//-----------------------------------------------------------------------------
+
+// Spawn a particle of an emitter, replacing the oldest if the ring is full
+void CEmitterPool::SpawnParticle( SEmitter& emitter, TUInt32 emitterIndex )
+{
+	const SParticleEffectDesc& desc = *emitter.desc;
+	TUInt32 particle = emitterIndex * kMaxEmitterParticles + emitter.nextParticle;
+
+	// A replaced particle may still be alive
+	CVector3 oldPosition, oldVelocity;
+	TFloat32 oldLife = 0.0f;
+	if (emitter.nextParticle < emitter.numUsed)
+	{
+		m_Particles.GetParticle( particle, &oldPosition, &oldVelocity, &oldLife );
+	}
+
+	// Random direction from a point in a cube, upwards if too near the centre to normalise
+	CVector3 direction( Random( -1.0f, 1.0f ), Random( -1.0f, 1.0f ), Random( -1.0f, 1.0f ) );
+	TFloat32 length = direction.Length();
+	direction = (length > 0.001f) ? direction * (1.0f / length) : CVector3::kYAxis;
+
+	CVector3 velocity = direction * Random( desc.minSpeed, desc.maxSpeed ) + CVector3::kYAxis * desc.upSpeed;
+	m_Particles.SetParticle( particle, emitter.position + SpawnOffset( desc ), velocity,
+	                         Random( desc.minLife, desc.maxLife ) );
+
+	if (oldLife <= 0.0f)  ++emitter.numLive;
+	emitter.numUsed = Max( emitter.numUsed, emitter.nextParticle + 1 );
+	emitter.nextParticle = (emitter.nextParticle + 1) % desc.maxParticles;
+}
+
+// Random offset from the emitter position within the spawn shape of an effect
+CVector3 CEmitterPool::SpawnOffset( const SParticleEffectDesc& desc )
+{
+	const TFloat32 size = desc.shapeSize;
+	switch (desc.shape)
+	{
+	case EEmitterShape::Sphere:
+	{
+		// Rejection sampling keeps the points evenly spread, few tries are needed
+		CVector3 offset;
+		do
+		{
+			offset.Set( Random( -1.0f, 1.0f ), Random( -1.0f, 1.0f ), Random( -1.0f, 1.0f ) );
+		} while (offset.LengthSquared() > 1.0f);
+		return offset * size;
+	}
+	case EEmitterShape::Box:
+		return CVector3( Random( -size, size ), Random( -size, size ), Random( -size, size ) );
+	case EEmitterShape::Disc:
+	{
+		CVector3 offset;
+		do
+		{
+			offset.Set( Random( -1.0f, 1.0f ), 0.0f, Random( -1.0f, 1.0f ) );
+		} while (offset.LengthSquared() > 1.0f);
+		return offset * size;
+	}
+	default:
+		return CVector3::kZero;
+	}
+}
+
+// Stop the active emitter at the given position in the active list, returning it to the pool.
+// The last active emitter takes its place in the list
+void CEmitterPool::StopEmitter( TUInt32 active )
+{
+	TUInt32 emitterIndex = m_Active[active];
+	m_ParticlesReserved -= m_Emitters[emitterIndex].desc->maxParticles;
+	m_Active[active] = m_Active[--m_NumActive];
+	m_Free[m_NumFree++] = emitterIndex;
+}
+
+// Whether there is an emitter and enough of the particle budget for an effect, or would be once
+// every emitter of the same or lower priority was culled. Checked before culling any, so running
+// effects are not lost for one that cannot start anyway
+bool CEmitterPool::CanMakeRoom( const SParticleEffectDesc& desc ) const
+{
+	TUInt32 numEmitters = m_NumFree;
+	TUInt32 particlesReserved = m_ParticlesReserved;
+	for (TUInt32 active = 0; active < m_NumActive; ++active)
+	{
+		const SParticleEffectDesc& activeDesc = *m_Emitters[m_Active[active]].desc;
+		if (activeDesc.priority <= desc.priority)
+		{
+			++numEmitters;
+			particlesReserved -= activeDesc.maxParticles;
+		}
+	}
+	return numEmitters > 0 && particlesReserved + desc.maxParticles <= m_ParticleBudget;
+}
+
+// Stop the lowest priority emitter of at most the given priority, the oldest if several. Returns
+// false if there is none
+bool CEmitterPool::CullEmitter( TUInt32 maxPriority )
+{
+	TUInt32 cull = m_NumActive;
+	for (TUInt32 active = 0; active < m_NumActive; ++active)
+	{
+		const SEmitter& emitter = m_Emitters[m_Active[active]];
+		if (emitter.desc->priority > maxPriority)  continue;
+		if (cull == m_NumActive)
+		{
+			cull = active;
+			continue;
+		}
+		const SEmitter& current = m_Emitters[m_Active[cull]];
+		if (emitter.desc->priority < current.desc->priority ||
+		    (emitter.desc->priority == current.desc->priority && emitter.age > current.age))
+		{
+			cull = active;
+		}
+	}
+	if (cull == m_NumActive)
+	{
+		return false;
+	}
+
+	m_NumLive -= m_Emitters[m_Active[cull]].numLive;
+	StopEmitter( cull );
+	++m_Stats.emittersCulled;
+	return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Statistics
+//-----------------------------------------------------------------------------
+
+void CEmitterPool::ResetStats()
+{
+	m_Stats.effectsStarted = 0;
+	m_Stats.effectsDropped = 0;
+	m_Stats.emittersCulled = 0;
+	m_Stats.peakEmitters = 0;
+	m_Stats.peakParticles = 0;
+}
+
+
+} // namespace gen
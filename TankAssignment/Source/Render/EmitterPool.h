@@ -0,0 +1,229 @@
+/*******************************************
+	EmitterPool.h
+
+	Particle effects started by gameplay events
+	(shell impacts, tank deaths, ammo pickups).
+	A fixed pool of emitters shares a global
+	particle budget - when it is used up, the
+	lowest priority emitters are culled. Nothing
+	is allocated after construction
+********************************************/
+
+#pragma once
+
+#include "../Common/Defines.h"
+#include "../Math/CVector3.h"
+#include "ParticleSimulator.h"
+
+namespace gen
+{
+
+// Kinds of effect, each with a description in EmitterPool.cpp
+enum class EParticleEffect
+{
+	ShellImpact, // Shell hitting a tank (Msg_TankHit)
+	TankDeath,   // Tank turret blown off (EState::Dying)
+	AmmoPickup,  // Ammo powerup collected (Msg_GiveAmmo)
+	NumEffects
+};
+
+// Area around the emitter position that particles are spawned in
+enum class EEmitterShape : TUInt32
+{
+	Point,
+	Sphere, // Inside a sphere of radius shapeSize
+	Box,    // Inside a cube of half width shapeSize
+	Disc,   // On a horizontal disc of radius shapeSize
+	NumShapes
+};
+
+// How an emitter for an effect spawns and moves its particles. Only 32-bit members, so it can be
+// stored in compiled preset files and used in place (see ParticlePresetFile.h)
+struct SParticleEffectDesc
+{
+	TUInt32  priority;       // Emitters of higher priority are kept when over budget
+	TUInt32  maxParticles;   // Particle budget of each emitter, at most kMaxEmitterParticles
+	TUInt32  burstParticles; // Particles spawned when the effect starts...
+	TFloat32 emitRate;       // ...then this many per second...
+	TFloat32 emitTime;       // ...for this long (seconds)
+	TFloat32 minLife, maxLife;   // Life of each particle (seconds)
+	TFloat32 minSpeed, maxSpeed; // Speed of each particle in a random direction...
+	TFloat32 upSpeed;            // ...plus this upwards
+	EEmitterShape shape;         // Where particles are spawned...
+	TFloat32      shapeSize;     // ...and the size of the area
+	CVector3      acceleration;  // Constant forces on each particle, usually just gravity
+	TFloat32      drag;          // Proportion of velocity lost per second
+};
+
+// Size of the pool, and the most particles a single emitter can have
+const TUInt32 kMaxEmitters = 256;
+const TUInt32 kMaxEmitterParticles = 512;
+
+// Default global particle budget - enough for dozens of effects at once
+const TUInt32 kDefaultEffectParticles = 32768;
+
+// Name of an effect, used to find its preset in a compiled preset file
+const char* ParticleEffectName( EParticleEffect effect );
+
+// Whether an effect description can be used by an emitter - particle counts within the limits,
+// a known shape and no minimum above its maximum
+bool IsValidEffectDesc( const SParticleEffectDesc& desc );
+
+// Counts of emitter activity since the pool was created or the stats were reset
+struct SEmitterPoolStats
+{
+	TUInt32 effectsStarted;  // Effects given an emitter
+	TUInt32 effectsDropped;  // Effects not started as higher priority emitters left no room
+	TUInt32 emittersCulled;  // Emitters stopped early to make room for others
+	TUInt32 peakEmitters;    // Most emitters running at once
+	TUInt32 peakParticles;   // Most live particles at once
+};
+
+
+class CEmitterPool
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Construct a pool of kMaxEmitters emitters sharing the given particle budget (at most
+	// kMaxEmitters * kMaxEmitterParticles). All memory is allocated here
+	CEmitterPool( TUInt32 particleBudget = kDefaultEffectParticles );
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CEmitterPool( const CEmitterPool& );
+	CEmitterPool& operator=( const CEmitterPool& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Effects
+
+	// Start an effect at the given world position. If there is no free emitter or not enough of
+	// the particle budget left, emitters of the same or lower priority are culled to make room -
+	// lowest priority first, oldest first within a priority. Returns false, culling nothing, if
+	// the effect could not be started as culling all those emitters would not make enough room
+	bool StartEffect( EParticleEffect effect, const CVector3& position );
+
+	// Start an effect from any description, which must stay valid while the effect is running.
+	// Returns false if the description is not valid (see IsValidEffectDesc) or as above
+	bool StartEffect( const SParticleEffectDesc& desc, const CVector3& position );
+
+	// Replace the description used for an effect, e.g. with one from a preset file. It must stay
+	// valid while the pool is in use. Pass 0 to go back to the built-in description. Returns false
+	// if the description is not valid, leaving the effect unchanged
+	bool SetEffectDesc( EParticleEffect effect, const SParticleEffectDesc* desc );
+
+	const SParticleEffectDesc& GetEffectDesc( EParticleEffect effect ) const
+	{
+		return *m_EffectDescs[static_cast<int>(effect)];
+	}
+
+	// Stop all effects immediately
+	void StopAll();
+
+	// Spawn and move the particles of each emitter, recycling emitters whose effect is over
+	void Update( TFloat32 updateTime );
+
+	// Copy the live particles of all emitters to the output, which must have space for
+	// ParticleBudget() particles. Returns the number copied
+	TUInt32 GatherParticles( SParticleVertex* output ) const;
+
+
+	/////////////////////////////////////
+	// Statistics
+
+	TUInt32 ParticleBudget() const
+	{
+		return m_ParticleBudget;
+	}
+
+	// Number of emitters running and particles alive, as of the last update
+	TUInt32 NumActiveEmitters() const
+	{
+		return m_NumActive;
+	}
+	TUInt32 NumLiveParticles() const
+	{
+		return m_NumLive;
+	}
+
+	const SEmitterPoolStats& GetStats() const
+	{
+		return m_Stats;
+	}
+
+	void ResetStats();
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	/////////////////////////////////////
+	// Types
+
+	// An emitter running an effect. Uses the particles of the simulator from its index times
+	// kMaxEmitterParticles, as a ring of the effect's maxParticles
+	struct SEmitter
+	{
+		const SParticleEffectDesc* desc;
+		CVector3 position;
+		TFloat32 age;          // Seconds since the effect started
+		TFloat32 spawnCarry;   // Fraction of a particle left over from the last spawn
+		TUInt32  nextParticle; // Next particle in the ring to spawn
+		TUInt32  numUsed;      // Particles in the ring spawned at least once
+		TUInt32  numLive;      // Particles alive as of the last update
+	};
+
+
+	/////////////////////////////////////
+	// Support functions
+
+	// Spawn a particle of an emitter, replacing the oldest if the ring is full
+	void SpawnParticle( SEmitter& emitter, TUInt32 emitterIndex );
+
+	// Random offset from the emitter position within the spawn shape of an effect
+	static CVector3 SpawnOffset( const SParticleEffectDesc& desc );
+
+	// Stop the active emitter at the given position in the active list, returning it to the pool
+	void StopEmitter( TUInt32 active );
+
+	// Whether culling emitters of the same or lower priority could make room for an effect
+	bool CanMakeRoom( const SParticleEffectDesc& desc ) const;
+
+	// Stop the lowest priority emitter of at most the given priority, the oldest if several.
+	// Returns false if there is none
+	bool CullEmitter( TUInt32 maxPriority );
+
+
+	/////////////////////////////////////
+	// Data
+
+	// Description used for each kind of effect
+	const SParticleEffectDesc* m_EffectDescs[static_cast<int>(EParticleEffect::NumEffects)];
+
+	// Emitters and the particles they share
+	SEmitter           m_Emitters[kMaxEmitters];
+	CParticleSimulator m_Particles;
+
+	// Indices of running emitters (first m_NumActive) and free emitters (first m_NumFree)
+	TUInt32 m_Active[kMaxEmitters];
+	TUInt32 m_NumActive;
+	TUInt32 m_Free[kMaxEmitters];
+	TUInt32 m_NumFree;
+
+	// Global budget, the part of it taken by the running emitters' maxParticles and the number
+	// of particles alive
+	TUInt32 m_ParticleBudget;
+	TUInt32 m_ParticlesReserved;
+	TUInt32 m_NumLive;
+
+	SEmitterPoolStats m_Stats;
+};
+
+
+} // namespace gen
@@ -8,7 +8,11 @@
 #include <d3dx10.h>
 #include "Mesh.h"
 #include "CImportXFile.h"
+#include "MeshFile.h"
+#include "AssetCache.h"
 #include "RenderMethod.h"
+#include "../Scene/Frustum.h"
+#include "../Common/Profiler.h"
 
 namespace gen
 {
@@ -25,11 +29,17 @@ extern const string MediaFolder;
 // Constructor / destructor
 //-----------------------------------------------------------------------------
 
+// Unique mesh IDs are provided using a single increasing integer
+atomic<TUInt32> CMesh::m_NextMeshID( 0 );
+
 // Model constructor
 CMesh::CMesh()
 {
 	// Initialise member variables
+	m_MeshID = m_NextMeshID++;
 	m_HasGeometry = false;
+	m_HasCpuData = false;
+	m_Cache = 0;
 
 	m_NumNodes = 0;
 	m_Nodes = 0;
@@ -37,9 +47,16 @@ CMesh::CMesh()
 	m_NumSubMeshes = 0;
 	m_SubMeshes = 0;
 	m_SubMeshesDX = 0;
+	m_File = 0;
+	m_FullCpuVertexSize = 0;
+	m_TrackedCpuData = 0;
 
 	m_NumMaterials = 0;
 	m_Materials = 0;
+
+	m_NumLods = 1;
+	m_Lods[0].error = 0.0f;
+	m_Lods[0].numTriangles = 0;
 }
 
 // Model destructor
@@ -56,33 +73,185 @@ void CMesh::ReleaseResources()
 	{
 		for (TUInt32 texture = 0; texture < m_Materials[material].numTextures; ++texture)
 		{
-			if (m_Materials[material].textures[texture]) m_Materials[material].textures[texture]->Release();
+			ID3D10ShaderResourceView* textureView = m_Materials[material].textures[texture];
+			if (!textureView)  continue;
+			if (m_Cache)       m_Cache->ReleaseTexture( textureView );
+			else               textureView->Release();
 		}
 	}
-	delete[] m_Materials;
+	TaggedDeleteArray( m_Materials );
 	m_Materials = 0;
 	m_NumMaterials = 0;
+	m_ImportedMaterials.clear();
 
-	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+	// DirectX sub-meshes are zeroed on creation, so any not yet created have nothing to release
+	for (TUInt32 subMesh = 0; m_SubMeshesDX && subMesh < m_NumSubMeshes; ++subMesh)
 	{
-		if (m_SubMeshesDX[subMesh].indexBuffer)	 m_SubMeshesDX[subMesh].indexBuffer->Release();
+		for (TUInt32 lod = 0; lod < kiMaxMeshLods; ++lod)
+		{
+			if (m_SubMeshesDX[subMesh].indexBuffer[lod]) m_SubMeshesDX[subMesh].indexBuffer[lod]->Release();
+		}
 		if (m_SubMeshesDX[subMesh].vertexBuffer) m_SubMeshesDX[subMesh].vertexBuffer->Release();
 		if (m_SubMeshesDX[subMesh].vertexLayout) m_SubMeshesDX[subMesh].vertexLayout->Release();
 	}
-	delete[] m_SubMeshesDX;
-	delete[] m_SubMeshes;
+	ReleaseCpuData();
+	TaggedDeleteArray( m_SubMeshesDX );
+	TaggedDeleteArray( m_SubMeshes );
 	m_SubMeshesDX = 0;
 	m_SubMeshes = 0;
 	m_NumSubMeshes = 0;
 
-	delete[] m_Nodes;
+	TaggedDeleteArray( m_Nodes );
 	m_Nodes = 0;
 	m_NumNodes = 0;
 
+	m_ImportedLods.clear();
+	m_NumLods = 1;
+	m_Lods[0].numTriangles = 0;
+
+	m_SubMeshBounds.clear();
+	m_NodeBounds.clear();
+
 	m_HasGeometry = false;
 }
 
 
+//-----------------------------------------------------------------------------
+// CPU geometry
+//-----------------------------------------------------------------------------
+
+// Size in bytes of the CPU copy of the geometry kept after loading, for triangle and vertex
+// enumeration. 0 once released
+TUInt32 CMesh::CpuDataSize()
+{
+	if (!m_HasCpuData)
+	{
+		return 0;
+	}
+	TUInt32 size = 0;
+	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+	{
+		size += m_SubMeshes[subMesh].numVertices * m_SubMeshes[subMesh].vertexSize +
+		        GetFaceDataSize( m_SubMeshes[subMesh] );
+	}
+	return size;
+}
+
+// Get the memory used by the geometry of the mesh once its resources are created, along with
+// what it would use with uncompressed vertices and a full CPU copy
+SMeshMemory CMesh::GetMemoryUsage()
+{
+	SMeshMemory memory = { 0, 0, 0, 0, 0, 0 };
+	for (TUInt32 subMesh = 0; m_SubMeshesDX && subMesh < m_NumSubMeshes; ++subMesh)
+	{
+		const SSubMeshDX& subMeshDX = m_SubMeshesDX[subMesh];
+		memory.gpuVertices += subMeshDX.numVertices * subMeshDX.vertexSize;
+		memory.gpuVerticesFull += subMeshDX.numVertices * subMeshDX.fullVertexSize;
+		TUInt32 indexSize = (subMeshDX.indexFormat == DXGI_FORMAT_R16_UINT) ? sizeof(TUInt16) : sizeof(TUInt32);
+		for (TUInt32 lod = 0; lod < m_NumLods; ++lod)
+		{
+			memory.gpuIndices += subMeshDX.numIndices[lod] * indexSize;
+		}
+		if (m_HasCpuData)
+		{
+			memory.cpuVertices += m_SubMeshes[subMesh].numVertices * m_SubMeshes[subMesh].vertexSize;
+			memory.cpuIndices += GetFaceDataSize( m_SubMeshes[subMesh] );
+		}
+	}
+	if (m_HasCpuData)
+	{
+		memory.cpuVerticesFull = m_FullCpuVertexSize;
+	}
+	return memory;
+}
+
+// Replace the CPU copy of each sub-mesh's vertices with just their positions. Faces from a cooked
+// file are copied too, so the file can be closed
+void CMesh::StripCpuData()
+{
+	if (!m_HasCpuData)
+	{
+		return;
+	}
+	m_FullCpuVertexSize = 0;
+	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+	{
+		SSubMesh& subMeshData = m_SubMeshes[subMesh];
+		m_FullCpuVertexSize += subMeshData.numVertices * subMeshData.vertexSize;
+
+		TUInt8* positions = new TUInt8[subMeshData.numVertices * 3 * sizeof(TFloat32)];
+		ExtractPositions( subMeshData, reinterpret_cast<TFloat32*>(positions) );
+		if (m_File)
+		{
+			// Face data belongs to the mapped file
+			if (subMeshData.largeFaces)
+			{
+				SMeshLargeFace* faces = new SMeshLargeFace[subMeshData.numFaces];
+				memcpy( faces, subMeshData.largeFaces, GetFaceDataSize( subMeshData ) );
+				subMeshData.largeFaces = faces;
+			}
+			else
+			{
+				SMeshFace* faces = new SMeshFace[subMeshData.numFaces];
+				memcpy( faces, subMeshData.faces, GetFaceDataSize( subMeshData ) );
+				subMeshData.faces = faces;
+			}
+		}
+		else
+		{
+			delete[] subMeshData.vertices;
+		}
+
+		subMeshData.vertices = positions;
+		subMeshData.vertexSize = 3 * sizeof(TFloat32);
+		subMeshData.hasSkinningData = subMeshData.hasNormals = subMeshData.hasTangents = false;
+		subMeshData.hasTextureCoords = subMeshData.hasVertexColours = false;
+	}
+	delete m_File;
+	m_File = 0;
+	TrackCpuData();
+}
+
+// Release the CPU copy of the geometry to save memory - rendering is unaffected, but triangle
+// and vertex enumeration will return nothing. Sub-mesh counts are kept
+void CMesh::ReleaseCpuData()
+{
+	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+	{
+		// Imported sub-mesh data is owned by the mesh, cooked data belongs to the mapped file
+		if (!m_File)
+		{
+			delete[] m_SubMeshes[subMesh].vertices;
+			delete[] m_SubMeshes[subMesh].faces;
+			delete[] m_SubMeshes[subMesh].largeFaces;
+		}
+		m_SubMeshes[subMesh].vertices = 0;
+		m_SubMeshes[subMesh].faces = 0;
+		m_SubMeshes[subMesh].largeFaces = 0;
+	}
+	delete m_File;
+	m_File = 0;
+	m_HasCpuData = false;
+	TrackCpuData();
+}
+
+// Update the memory tracker with the size of the CPU geometry owned by the mesh. Geometry in a
+// mapped cooked file is not counted
+void CMesh::TrackCpuData()
+{
+	TUInt32 size = m_File ? 0 : CpuDataSize();
+	if (size > m_TrackedCpuData)
+	{
+		MemoryTracker.Allocated( EMemoryTag::Meshes, size - m_TrackedCpuData );
+	}
+	else if (size < m_TrackedCpuData)
+	{
+		MemoryTracker.Freed( EMemoryTag::Meshes, m_TrackedCpuData - size );
+	}
+	m_TrackedCpuData = size;
+}
+
+
 //-----------------------------------------------------------------------------
 // Geometry access / enumeration
 //-----------------------------------------------------------------------------
@@ -114,55 +283,12 @@ void CMesh::BeginEnumTriangles()
 // triangle was successfully returned, false if there are no more triangles to enumerate
 bool CMesh::GetTriangle( CVector3* pVertex1, CVector3* pVertex2, CVector3* pVertex3 )
 {
-	// If enumerated all meshes then finished
-	if (m_EnumTriMesh >= m_NumSubMeshes)
+	// Nothing to enumerate once the geometry has been released
+	if (!m_HasCpuData)
 	{
 		return false;
 	}
-
-	// If enumerated all triangles in current mesh...
-	if (m_EnumTri >= m_SubMeshes[m_EnumTriMesh].numFaces)
-	{
-		// Move to next mesh - finished if no more meshes
-		++m_EnumTriMesh;
-		if (m_EnumTriMesh >= m_NumSubMeshes)
-		{
-			return false;
-		}
-		m_EnumTri = 0; // Start at first triangle of next mesh
-	}
-
-	// Get current face from submesh
-	SMeshFace face = m_SubMeshes[m_EnumTriMesh].faces[m_EnumTri];
-
-	// Get pointer to vertex refered to by first face index - deal with flexible vertex size
-	TUInt8* pVertexData = m_SubMeshes[m_EnumTriMesh].vertices + 
-	                      face.aiVertex[0] * m_SubMeshes[m_EnumTriMesh].vertexSize;
-
-	// Copy vertex coordinate to output pointer
-	// Assuming first three floats are the vertex coord x,y & z. See comment in CMesh::PreProcess
-	TFloat32* pVertexCoord = reinterpret_cast<TFloat32*>(pVertexData);
-	pVertex1->x = *pVertexCoord++;
-	pVertex1->y = *pVertexCoord++;
-	pVertex1->z = *pVertexCoord;
-
-	// Get second vertex coordinate
-	pVertexData = m_SubMeshes[m_EnumTriMesh].vertices +
-	              face.aiVertex[1] * m_SubMeshes[m_EnumTriMesh].vertexSize;
-	pVertexCoord = reinterpret_cast<TFloat32*>(pVertexData);
-	pVertex2->x = *pVertexCoord++;
-	pVertex2->y = *pVertexCoord++;
-	pVertex2->z = *pVertexCoord;
-
-	// Get third vertex coordinate
-	pVertexData = m_SubMeshes[m_EnumTriMesh].vertices +
-	              face.aiVertex[2] * m_SubMeshes[m_EnumTriMesh].vertexSize;
-	pVertexCoord = reinterpret_cast<TFloat32*>(pVertexData);
-	pVertex2->x = *pVertexCoord++;
-	pVertex2->y = *pVertexCoord++;
-	pVertex2->z = *pVertexCoord;
-
-	return true;
+	return GetNextTriangle( m_SubMeshes, m_NumSubMeshes, &m_EnumTriMesh, &m_EnumTri, pVertex1, pVertex2, pVertex3 );
 }
 
 
@@ -193,36 +319,12 @@ void CMesh::BeginEnumVertices()
 // there are no more vertices to enumerate
 bool CMesh::GetVertex( CVector3* pVertex )
 {
-	// If enumerated all meshes then finished
-	if (m_EnumVertMesh >= m_NumSubMeshes)
+	// Nothing to enumerate once the geometry has been released
+	if (!m_HasCpuData)
 	{
 		return false;
 	}
-
-	// If enumerated all vertices in current mesh...
-	if (m_EnumVert >= m_SubMeshes[m_EnumVertMesh].numVertices)
-	{
-		// Move to next mesh - finished if no more meshes
-		++m_EnumVertMesh;
-		if (m_EnumVertMesh >= m_NumSubMeshes)
-		{
-			return false;
-		}
-		m_EnumVert = 0; // Start at first vertex of next mesh
-	}
-
-	// Get pointer to current vertex in current mesh - deal with flexible vertex size
-	TUInt8* pVertexData = m_SubMeshes[m_EnumVertMesh].vertices + 
-	                      m_EnumVert * m_SubMeshes[m_EnumVertMesh].vertexSize;
-
-	// Copy vertex coordinate to output pointer
-	// Assuming first three floats are the vertex coord x,y & z. See comment in CMesh::PreProcess
-	TFloat32* pVertexCoord = reinterpret_cast<TFloat32*>(pVertexData);
-	pVertex->x = *pVertexCoord++;
-	pVertex->y = *pVertexCoord++;
-	pVertex->z = *pVertexCoord;
-
-	return true;
+	return GetNextVertex( m_SubMeshes, m_NumSubMeshes, &m_EnumVertMesh, &m_EnumVert, pVertex );
 }
 
 
@@ -230,9 +332,46 @@ bool CMesh::GetVertex( CVector3* pVertex )
 // Creation
 //-----------------------------------------------------------------------------
 
-// Create the model from an X-File, returns true on success
-bool CMesh::Load( const string& fileName )
+// Import the mesh from an X-File, preparing its geometry on the CPU ready for CreateResources.
+// Uses the cooked version of the file (see MeshFile.h) instead if there is one and it is up to
+// date. Needs no device so may be called on any thread. Returns false on failure
+bool CMesh::Import( const string& fileName, CThreadPool* pool /*= 0*/ )
 {
+	GEN_PROFILE_ZONE( "CMesh::Import" );
+
+	// Release any existing geometry
+	ReleaseResources();
+
+	// Cooked file has all import processing done and the bounds precalculated. Its geometry is used
+	// in place, so it stays open (mapped) until the mesh is released
+	CMeshFile* meshFile = new CMeshFile;
+	if (meshFile->OpenForMesh( fileName ))
+	{
+		m_File = meshFile;
+		if (!CreateFromSource( *meshFile ))
+		{
+			ReleaseResources();
+			return false;
+		}
+		m_MinBounds = meshFile->MinBounds();
+		m_MaxBounds = meshFile->MaxBounds();
+		m_BoundingRadius = meshFile->BoundingRadius();
+		m_SubMeshBounds.resize( m_NumSubMeshes );
+		for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+		{
+			meshFile->GetSubMeshBounds( subMesh, &m_SubMeshBounds[subMesh] );
+		}
+		m_NodeBounds.resize( m_NumNodes );
+		for (TUInt32 node = 0; node < m_NumNodes; ++node)
+		{
+			meshFile->GetNodeBounds( node, &m_NodeBounds[node] );
+		}
+		ReadLods( *meshFile );
+		TrackCpuData();
+		return true;
+	}
+	delete meshFile;
+
 	// Create a X-File import helper class
 	CImportXFile importFile;
 
@@ -257,83 +396,136 @@ bool CMesh::Load( const string& fileName )
 		return false;
 	}
 
-	// Release any existing geometry
-	if (m_HasGeometry)
+	if (!CreateFromSource( importFile ))
 	{
 		ReleaseResources();
+		return false;
 	}
 
-	// Get node data from import class
-	m_NumNodes = importFile.GetNumNodes();
-	m_Nodes = new SMeshNode[m_NumNodes];
-	if (!m_Nodes)
+	// Geometry pre-processing - just calculating bounding volumes in this example
+	if (!PreProcess( pool ))
 	{
+		ReleaseResources();
 		return false;
 	}
-	for (TUInt32 node = 0; node < m_NumNodes; ++node)
+	CreateLods();
+	TrackCpuData();
+	return true;
+}
+
+// Create the DirectX materials (loading their textures) and sub-meshes for geometry prepared by
+// Import. Requires a device. If an asset cache is given, textures are shared through it and its
+// vertex compression is used. The CPU copy of the geometry is then stripped down to the vertex
+// positions and faces. Returns false on failure
+bool CMesh::CreateResources( CAssetCache* cache /*= 0*/ )
+{
+	GEN_PROFILE_ZONE( "CMesh::CreateResources" );
+
+	if (m_HasGeometry)
 	{
-		importFile.GetNode( node, &m_Nodes[node] );
+		return true;
 	}
-
-	// Get material data from import class, also load textures
-	TUInt32 requiredMaterials = importFile.GetNumMaterials();
-	m_Materials = new SMeshMaterialDX[requiredMaterials];
-	if (!m_Materials)
+	if (m_NumSubMeshes == 0)
 	{
-		ReleaseResources();
-		return false;
+		return false; // Not imported
 	}
+	m_Cache = cache;
+
+	// Materials first, sub-meshes need to know their render method
+	TUInt32 requiredMaterials = static_cast<TUInt32>(m_ImportedMaterials.size());
+	m_Materials = TaggedNewArray<SMeshMaterialDX>( EMemoryTag::Meshes, requiredMaterials );
 	for (m_NumMaterials = 0; m_NumMaterials < requiredMaterials; ++m_NumMaterials)
 	{
-		SMeshMaterial importMaterial; 
-		importFile.GetMaterial( m_NumMaterials, &importMaterial );
-		if (!CreateMaterialDX( importMaterial, &m_Materials[m_NumMaterials] ))
+		if (!CreateMaterialDX( m_ImportedMaterials[m_NumMaterials], &m_Materials[m_NumMaterials] ))
 		{
 			ReleaseResources();
 			return false;
 		}
 	}
+	m_ImportedMaterials.clear();
 
-	// Get submesh data from import class - convert to DirectX data for rendering
-	// but retain original data for easy access to vertices / faces
-	TUInt32 requiredSubMeshes = importFile.GetNumSubMeshes();
-	m_SubMeshes = new SSubMesh[requiredSubMeshes];
-	m_SubMeshesDX = new SSubMeshDX[requiredSubMeshes];
-	if (!m_SubMeshes || !m_SubMeshesDX)
+	// Convert sub-meshes to DirectX data for rendering. Zeroed so a partly created array can be released
+	const SVertexCompression& compression = cache ? cache->GetVertexCompression() : kNoVertexCompression;
+	m_SubMeshesDX = TaggedNewArray<SSubMeshDX>( EMemoryTag::Meshes, m_NumSubMeshes );
+	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+	{
+		const SSubMeshLod* subMeshLods = (m_NumLods > 1) ? &m_ImportedLods[subMesh * (kiMaxMeshLods - 1)] : 0;
+		if (!CreateSubMeshDX( m_SubMeshes[subMesh], m_SubMeshBounds[subMesh], subMeshLods, compression,
+		                      &m_SubMeshesDX[subMesh] ))
+		{
+			ReleaseResources();
+			return false;
+		}
+	}
+	m_ImportedLods.clear();
+
+	// Retain positions and faces for easy access to vertices / triangles, the rest is on the GPU
+	StripCpuData();
+
+	m_HasGeometry = true;
+	return true;
+}
+
+// Get nodes, materials and sub-meshes from an imported X-File or a cooked mesh file, which
+// provide the same data access functions. Only CPU data is created, materials are kept in their
+// imported form. Returns false on failure, leaving partly created data for the caller to release
+template <class TSource>
+bool CMesh::CreateFromSource( const TSource& source )
+{
+	// Sub-mesh data from either source is retained until released
+	m_HasCpuData = true;
+
+	// Get node data from source
+	m_NumNodes = source.GetNumNodes();
+	m_Nodes = TaggedNewArray<SMeshNode>( EMemoryTag::Meshes, m_NumNodes );
+	if (!m_Nodes)
+	{
+		return false;
+	}
+	for (TUInt32 node = 0; node < m_NumNodes; ++node)
+	{
+		source.GetNode( node, &m_Nodes[node] );
+	}
+
+	// Get material data from source, textures are loaded when the resources are created
+	m_ImportedMaterials.resize( source.GetNumMaterials() );
+	for (TUInt32 material = 0; material < m_ImportedMaterials.size(); ++material)
+	{
+		source.GetMaterial( material, &m_ImportedMaterials[material] );
+	}
+
+	// Get submesh data from source
+	TUInt32 requiredSubMeshes = source.GetNumSubMeshes();
+	m_SubMeshes = TaggedNewArray<SSubMesh>( EMemoryTag::Meshes, requiredSubMeshes );
+	if (!m_SubMeshes)
 	{
-		ReleaseResources();
 		return false;
 	}
 	for (m_NumSubMeshes = 0; m_NumSubMeshes < requiredSubMeshes; ++m_NumSubMeshes)
 	{
 		// Determine if the render method for this mesh needs tangents
-		ERenderMethod meshMethod = importFile.GetSubMeshRenderMethod( m_NumSubMeshes );
+		ERenderMethod meshMethod = source.GetSubMeshRenderMethod( m_NumSubMeshes );
 		bool needTangents = RenderMethodUsesTangents( meshMethod );
 
-		importFile.GetSubMesh( m_NumSubMeshes, &m_SubMeshes[m_NumSubMeshes], needTangents );
-		if (!CreateSubMeshDX( m_SubMeshes[m_NumSubMeshes], &m_SubMeshesDX[m_NumSubMeshes] ))
+		if (source.GetSubMesh( m_NumSubMeshes, &m_SubMeshes[m_NumSubMeshes], needTangents ) != kSuccess)
 		{
-			ReleaseResources();
 			return false;
 		}
 	}
 
-	// Geometry pre-processing - just calculating bounding box in this example
-	if (!PreProcess())
-	{
-		ReleaseResources();
-		return false;
-	}
-
-	m_HasGeometry = true;
 	return true;
 }
 
-// Creates a DirectX specific sub-mesh from an imported sub-mesh (mesh materials must already have been prepared as we need to know render method to setup vertex data)
+// Creates a DirectX specific sub-mesh from an imported sub-mesh (mesh materials must already have been prepared as we need to know render method to setup vertex data).
+// The simplified faces for each level of detail above 0 are also given, or 0 if the mesh has no levels. The vertices
+// are stored with the given compression, as far as the sub-mesh allows (see VertexCompression.h)
 bool CMesh::CreateSubMeshDX
 (
-	const SSubMesh& subMesh,
-	SSubMeshDX*     subMeshDX
+	const SSubMesh&           subMesh,
+	const SMeshBounds&        bounds,
+	const SSubMeshLod*        subMeshLods,
+	const SVertexCompression& compression,
+	SSubMeshDX*               subMeshDX
 )
 {
 	// Copy node and material
@@ -342,21 +534,30 @@ bool CMesh::CreateSubMeshDX
 
 	// Buffer sizes
 	subMeshDX->numVertices = subMesh.numVertices;
-	subMeshDX->numIndices = subMesh.numFaces * 3; // Using triangle lists, so always 3 indexes per face
+	subMeshDX->numIndices[0] = subMesh.numFaces * 3; // Using triangle lists, so always 3 indexes per face
+
+	// Layout of the vertices once compressed, and how the shaders decode them. Also the size the
+	// vertices would have had uncompressed, for memory reports
+	SCompressedLayout layout, fullLayout;
+	GetCompressedLayout( subMesh, bounds, compression, &layout );
+	GetCompressedLayout( subMesh, bounds, kNoVertexCompression, &fullLayout );
+	subMeshDX->positionScale = layout.positionScale;
+	subMeshDX->positionOffset = layout.positionOffset;
+	subMeshDX->octahedralNormals = layout.compression.normals;
+	subMeshDX->fullVertexSize = fullLayout.vertexSize;
 
 	// Create vertex element list & layout.
 	unsigned int numElts = 0;
-	unsigned int offset = 0;
 
 	// Position is always required
 	subMeshDX->vertexElts[numElts].SemanticName = "POSITION";   // Semantic in HLSL (what is this data for)
 	subMeshDX->vertexElts[numElts].SemanticIndex = 0;           // Index to add to semantic (a count for this kind of data, when using multiple of the same type, e.g. TEXCOORD0, TEXCOORD1)
-	subMeshDX->vertexElts[numElts].Format = DXGI_FORMAT_R32G32B32_FLOAT; // Type of data - this one will be a float3 in the shader. Most data communicated as though it were colours
-	subMeshDX->vertexElts[numElts].AlignedByteOffset = offset;  // Offset of element from start of vertex data (e.g. if we have position (float3), uv (float2) then normal, the normal's offset is 5 floats = 5*4 = 20)
+	subMeshDX->vertexElts[numElts].Format = layout.compression.positions ? DXGI_FORMAT_R16G16B16A16_UNORM  // Type of data - this one will be a float3 in the shader. Most data communicated as though it were colours.
+	                                                                      : DXGI_FORMAT_R32G32B32_FLOAT; // Compressed positions are 0->1 over the sub-mesh box
+	subMeshDX->vertexElts[numElts].AlignedByteOffset = layout.offsets.position;  // Offset of element from start of vertex data (e.g. if we have position (float3), uv (float2) then normal, the normal's offset is 5 floats = 5*4 = 20)
 	subMeshDX->vertexElts[numElts].InputSlot = 0;               // For when using multiple vertex buffers (e.g. instancing - an advanced topic)
 	subMeshDX->vertexElts[numElts].InputSlotClass = D3D10_INPUT_PER_VERTEX_DATA; // Use this value for most cases (only changed for instancing)
 	subMeshDX->vertexElts[numElts].InstanceDataStepRate = 0;                     // --"--
-	offset += 12;
 	++numElts;
 
 	// Repeat for each kind of vertex data
@@ -365,56 +566,51 @@ bool CMesh::CreateSubMeshDX
 		subMeshDX->vertexElts[numElts].SemanticName = "BLENDWEIGHT";
 		subMeshDX->vertexElts[numElts].SemanticIndex = 0;
 		subMeshDX->vertexElts[numElts].Format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-		subMeshDX->vertexElts[numElts].AlignedByteOffset = offset;
+		subMeshDX->vertexElts[numElts].AlignedByteOffset = layout.offsets.skinning;
 		subMeshDX->vertexElts[numElts].InputSlot = 0;
 		subMeshDX->vertexElts[numElts].InputSlotClass = D3D10_INPUT_PER_VERTEX_DATA;
 		subMeshDX->vertexElts[numElts].InstanceDataStepRate = 0;
-		offset += 16;
 		++numElts;
 		subMeshDX->vertexElts[numElts].SemanticName = "BLENDINDICES";
 		subMeshDX->vertexElts[numElts].SemanticIndex = 0;
 		subMeshDX->vertexElts[numElts].Format = DXGI_FORMAT_R8G8B8A8_UINT;
-		subMeshDX->vertexElts[numElts].AlignedByteOffset = offset;
+		subMeshDX->vertexElts[numElts].AlignedByteOffset = layout.offsets.skinning + 16;
 		subMeshDX->vertexElts[numElts].InputSlot = 0;
 		subMeshDX->vertexElts[numElts].InputSlotClass = D3D10_INPUT_PER_VERTEX_DATA;
 		subMeshDX->vertexElts[numElts].InstanceDataStepRate = 0;
-		offset += 4;
 		++numElts;
 	}
 	if (subMesh.hasNormals)
 	{
 		subMeshDX->vertexElts[numElts].SemanticName = "NORMAL";
 		subMeshDX->vertexElts[numElts].SemanticIndex = 0;
-		subMeshDX->vertexElts[numElts].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		subMeshDX->vertexElts[numElts].AlignedByteOffset = offset;
+		subMeshDX->vertexElts[numElts].Format = layout.compression.normals ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+		subMeshDX->vertexElts[numElts].AlignedByteOffset = layout.offsets.normal;
 		subMeshDX->vertexElts[numElts].InputSlot = 0;
 		subMeshDX->vertexElts[numElts].InputSlotClass = D3D10_INPUT_PER_VERTEX_DATA;
 		subMeshDX->vertexElts[numElts].InstanceDataStepRate = 0;
-		offset += 12;
 		++numElts;
 	}
 	if (subMesh.hasTangents)
 	{
 		subMeshDX->vertexElts[numElts].SemanticName = "TANGENT";
 		subMeshDX->vertexElts[numElts].SemanticIndex = 0;
-		subMeshDX->vertexElts[numElts].Format = DXGI_FORMAT_R32G32B32_FLOAT;
-		subMeshDX->vertexElts[numElts].AlignedByteOffset = offset;
+		subMeshDX->vertexElts[numElts].Format = layout.compression.normals ? DXGI_FORMAT_R16G16_SNORM : DXGI_FORMAT_R32G32B32_FLOAT;
+		subMeshDX->vertexElts[numElts].AlignedByteOffset = layout.offsets.tangent;
 		subMeshDX->vertexElts[numElts].InputSlot = 0;
 		subMeshDX->vertexElts[numElts].InputSlotClass = D3D10_INPUT_PER_VERTEX_DATA;
 		subMeshDX->vertexElts[numElts].InstanceDataStepRate = 0;
-		offset += 12;
 		++numElts;
 	}
 	if (subMesh.hasTextureCoords)
 	{
 		subMeshDX->vertexElts[numElts].SemanticName = "TEXCOORD";
 		subMeshDX->vertexElts[numElts].SemanticIndex = 0;
-		subMeshDX->vertexElts[numElts].Format = DXGI_FORMAT_R32G32_FLOAT;
-		subMeshDX->vertexElts[numElts].AlignedByteOffset = offset;
+		subMeshDX->vertexElts[numElts].Format = layout.compression.textureCoords ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT;
+		subMeshDX->vertexElts[numElts].AlignedByteOffset = layout.offsets.textureCoord;
 		subMeshDX->vertexElts[numElts].InputSlot = 0;
 		subMeshDX->vertexElts[numElts].InputSlotClass = D3D10_INPUT_PER_VERTEX_DATA;
 		subMeshDX->vertexElts[numElts].InstanceDataStepRate = 0;
-		offset += 8;
 		++numElts;
 	}
 	if (subMesh.hasVertexColours)
@@ -422,14 +618,13 @@ bool CMesh::CreateSubMeshDX
 		subMeshDX->vertexElts[numElts].SemanticName = "COLOR";
 		subMeshDX->vertexElts[numElts].SemanticIndex = 0;
 		subMeshDX->vertexElts[numElts].Format = DXGI_FORMAT_R8G8B8A8_UNORM; // A RGBA colour with 1 byte (0-255) per component
-		subMeshDX->vertexElts[numElts].AlignedByteOffset = offset;
+		subMeshDX->vertexElts[numElts].AlignedByteOffset = layout.offsets.colour;
 		subMeshDX->vertexElts[numElts].InputSlot = 0;
 		subMeshDX->vertexElts[numElts].InputSlotClass = D3D10_INPUT_PER_VERTEX_DATA;
 		subMeshDX->vertexElts[numElts].InstanceDataStepRate = 0;
-		offset += 4;
 		++numElts;
 	}
-	subMeshDX->vertexSize = offset;
+	subMeshDX->vertexSize = layout.vertexSize;
 
 	// Given the vertex element list, pass it to DirectX to create a vertex layout. We also need to pass an example of a technique that will
 	// render this model. We will only be able to render this model with techniques that have the same vertex input as the example we use here
@@ -439,7 +634,9 @@ bool CMesh::CreateSubMeshDX
 	g_pd3dDevice->CreateInputLayout( subMeshDX->vertexElts, numElts, PassDesc.pIAInputSignature, PassDesc.IAInputSignatureSize, &subMeshDX->vertexLayout );
 
 
-	// Create the vertex buffer and fill it with the sub-mesh vertex data
+	// Create the vertex buffer and fill it with the compressed sub-mesh vertex data
+	vector<TUInt8> vertices( subMeshDX->numVertices * subMeshDX->vertexSize );
+	CompressVertices( subMesh, layout, &vertices[0] );
 	D3D10_BUFFER_DESC bufferDesc;
 	bufferDesc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
 	bufferDesc.Usage = D3D10_USAGE_DEFAULT; // Not a dynamic buffer
@@ -447,28 +644,73 @@ bool CMesh::CreateSubMeshDX
 	bufferDesc.CPUAccessFlags = 0;   // Indicates that CPU won't access this buffer at all after creation
 	bufferDesc.MiscFlags = 0;
 	D3D10_SUBRESOURCE_DATA initData; // Initial data
-	initData.pSysMem = subMesh.vertices;   
+	initData.pSysMem = &vertices[0];
 	if (FAILED( g_pd3dDevice->CreateBuffer( &bufferDesc, &initData, &subMeshDX->vertexBuffer )))
 	{
 		return false;
 	}
 
 
-	// Create the index buffer - assuming 2-byte (WORD) index data
+	// Create the index buffer - 2-byte (WORD) index data unless the sub-mesh has too many vertices
+	subMeshDX->indexFormat = subMesh.largeFaces ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
 	bufferDesc.BindFlags = D3D10_BIND_INDEX_BUFFER;
 	bufferDesc.Usage = D3D10_USAGE_DEFAULT;
-	bufferDesc.ByteWidth = subMeshDX->numIndices * sizeof(WORD);
+	bufferDesc.ByteWidth = GetFaceDataSize( subMesh );
 	bufferDesc.CPUAccessFlags = 0;
 	bufferDesc.MiscFlags = 0;
-	initData.pSysMem = subMesh.faces;   
-	if (FAILED( g_pd3dDevice->CreateBuffer( &bufferDesc, &initData, &subMeshDX->indexBuffer )))
+	initData.pSysMem = subMesh.largeFaces ? static_cast<const void*>(subMesh.largeFaces) : subMesh.faces;
+	if (FAILED( g_pd3dDevice->CreateBuffer( &bufferDesc, &initData, &subMeshDX->indexBuffer[0] )))
 	{
 		return false;
 	}
 
+	// Index buffers for the simplified levels of detail, drawn with the same vertex buffer
+	for (TUInt32 lod = 1; lod < m_NumLods; ++lod)
+	{
+		const vector<TUInt32>& indices = subMeshLods[lod - 1].indices;
+		subMeshDX->numIndices[lod] = static_cast<TUInt32>(indices.size());
+		if (!CreateIndexBufferDX( indices, *subMeshDX, &subMeshDX->indexBuffer[lod] ))
+		{
+			return false;
+		}
+	}
+
 	return true;
 }
 
+// Create an index buffer in the sub-mesh's index format from a list of 32-bit indices. An empty
+// list (a sub-mesh simplified away completely) gives no buffer
+bool CMesh::CreateIndexBufferDX
+(
+	const vector<TUInt32>& indices,
+	const SSubMeshDX&      subMeshDX,
+	ID3D10Buffer**         indexBuffer
+)
+{
+	*indexBuffer = 0;
+	if (indices.empty())
+	{
+		return true;
+	}
+
+	vector<TUInt16> smallIndices;
+	D3D10_SUBRESOURCE_DATA initData;
+	initData.pSysMem = &indices[0];
+	if (subMeshDX.indexFormat == DXGI_FORMAT_R16_UINT)
+	{
+		smallIndices.assign( indices.begin(), indices.end() );
+		initData.pSysMem = &smallIndices[0];
+	}
+
+	D3D10_BUFFER_DESC bufferDesc;
+	bufferDesc.BindFlags = D3D10_BIND_INDEX_BUFFER;
+	bufferDesc.Usage = D3D10_USAGE_DEFAULT;
+	bufferDesc.ByteWidth = static_cast<UINT>(indices.size()) * (smallIndices.empty() ? sizeof(TUInt32) : sizeof(TUInt16));
+	bufferDesc.CPUAccessFlags = 0;
+	bufferDesc.MiscFlags = 0;
+	return SUCCEEDED( g_pd3dDevice->CreateBuffer( &bufferDesc, &initData, indexBuffer ) );
+}
+
 // Creates a DirectX specific material from an imported material
 bool CMesh::CreateMaterialDX
 (
@@ -495,7 +737,15 @@ bool CMesh::CreateMaterialDX
 	for (TUInt32 texture = 0; texture < material.numTextures; ++texture)
 	{
 		string fullFileName = MediaFolder + material.textureFileNames[texture];
-		if (FAILED( D3DX10CreateShaderResourceViewFromFile( g_pd3dDevice, fullFileName.c_str(), NULL, NULL, &materialDX->textures[texture], NULL ) ))
+		if (m_Cache)
+		{
+			materialDX->textures[texture] = m_Cache->AcquireTexture( material.textureFileNames[texture] );
+		}
+		else if (FAILED( D3DX10CreateShaderResourceViewFromFile( g_pd3dDevice, fullFileName.c_str(), NULL, NULL, &materialDX->textures[texture], NULL ) ))
+		{
+			materialDX->textures[texture] = 0;
+		}
+		if (!materialDX->textures[texture])
 		{
 			string errorMsg = "Error loading texture " + fullFileName;
 			SystemMessageBox( errorMsg.c_str(), "Mesh Error" );
@@ -506,87 +756,72 @@ bool CMesh::CreateMaterialDX
 }
 
 
-// Pre-processing after loading, returns true on success - just calculates bounding box here
-// Rejects mesh if no sub-meshes or any empty sub-meshes
-bool CMesh::PreProcess()
+// Pre-processing after loading, returns true on success - just calculates bounding volumes here,
+// sub-meshes on the thread pool if given. Rejects mesh if no sub-meshes or any empty sub-meshes
+bool CMesh::PreProcess( CThreadPool* pool /*= 0*/ )
 {
-	// Ensure at least one non-empty sub-mesh
-	if (m_NumSubMeshes == 0 || m_SubMeshes[0].numVertices == 0)
+	// Ensure at least one sub-mesh, and reject mesh if it contains empty sub-meshes
+	if (m_NumSubMeshes == 0)
 	{
 		return false;
 	}
-
-	// Set initial bounds from first vertex
-	// Assuming first three floats are the vertex coord x,y & z. Would be better to support
-	// a flexible data type system like DirectX vertex declarations (D3DVERTEXELEMENT9)
-	TFloat32* pVertexCoord = reinterpret_cast<TFloat32*>(m_SubMeshes[0].vertices);
-	m_MinBounds.x = m_MaxBounds.x = *pVertexCoord++;
-	m_MinBounds.y = m_MaxBounds.y = *pVertexCoord++;
-	m_MinBounds.z = m_MaxBounds.z = *pVertexCoord;
-	m_BoundingRadius = m_MinBounds.Length();
-
-	// Go through all submeshes ...
 	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
 	{
-		// Reject mesh if it contains empty sub-meshes
 		if (m_SubMeshes[subMesh].numVertices == 0)
 		{
 			return false;
 		}
+	}
 
-		// Go through all vertices
-		TUInt8* pVertex = m_SubMeshes[subMesh].vertices;
-		for (TUInt32 vert = 0; vert < m_SubMeshes[subMesh].numVertices; ++vert)
-		{
-			// Get vertex coord as vector
-			pVertexCoord = reinterpret_cast<TFloat32*>(pVertex); // Assume float x,y,z coord again
-			CVector3 vertex;
-			vertex.x = *pVertexCoord++;
-			vertex.y = *pVertexCoord++;
-			vertex.z = *pVertexCoord;
-			
-			// Compare vertex against current bounds, updating bounds where necessary
-			if (vertex.x < m_MinBounds.x)
-			{
-				m_MinBounds.x = vertex.x;
-			}
-			if (vertex.x > m_MaxBounds.x)
-			{
-				m_MaxBounds.x = vertex.x;
-			}
-			++pVertexCoord;
+	// Bounds of each sub-mesh and node, and of the whole mesh (see MeshBounds.h). The vertex
+	// positions are found from the vertex layout of each sub-mesh
+	m_SubMeshBounds.resize( m_NumSubMeshes );
+	m_NodeBounds.resize( m_NumNodes );
+	SMeshBounds meshBounds;
+	if (!CalculateMeshBounds( m_SubMeshes, m_NumSubMeshes, m_NumNodes, &m_SubMeshBounds[0], &m_NodeBounds[0],
+	                          &meshBounds, pool ))
+	{
+		return false;
+	}
+	m_MinBounds = meshBounds.minBounds;
+	m_MaxBounds = meshBounds.maxBounds;
+	m_BoundingRadius = meshBounds.originRadius;
 
-			if (vertex.y < m_MinBounds.y)
-			{
-				m_MinBounds.y = vertex.y;
-			}
-			if (vertex.y > m_MaxBounds.y)
-			{
-				m_MaxBounds.y = vertex.y;
-			}
-			++pVertexCoord;
+	return true;
+}
 
-			if (vertex.z < m_MinBounds.z)
-			{
-				m_MinBounds.z = vertex.z;
-			}
-			if (vertex.z > m_MaxBounds.z)
-			{
-				m_MaxBounds.z = vertex.z;
-			}
 
-			TFloat32 length = vertex.Length();
-			if (length > m_BoundingRadius)
-			{
-				m_BoundingRadius = length;
-			}
+// Generate the simplified levels of detail from the imported sub-meshes, see SimplifyMesh
+void CMesh::CreateLods()
+{
+	m_NumLods = SimplifyMesh( m_SubMeshes, m_NumSubMeshes, &m_ImportedLods, m_Lods );
+}
 
-			// Step to next vertex (flexible vertex size)
-			pVertex += m_SubMeshes[subMesh].vertexSize;
-		}
+// Get the levels of detail stored in a cooked mesh file, which were generated with SimplifyMesh
+// when it was cooked
+void CMesh::ReadLods( const CMeshFile& meshFile )
+{
+	m_ImportedLods.clear();
+	m_NumLods = meshFile.GetNumLods();
+	m_Lods[0].error = 0.0f;
+	m_Lods[0].numTriangles = GetNumTriangles();
+	if (m_NumLods == 1)
+	{
+		return;
 	}
 
-	return true;
+	m_ImportedLods.resize( m_NumSubMeshes * (kiMaxMeshLods - 1) );
+	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+	{
+		for (TUInt32 lod = 1; lod < m_NumLods; ++lod)
+		{
+			meshFile.GetSubMeshLod( subMesh, lod, &m_ImportedLods[subMesh * (kiMaxMeshLods - 1) + lod - 1] );
+		}
+	}
+	for (TUInt32 lod = 1; lod < m_NumLods; ++lod)
+	{
+		m_Lods[lod] = CombineSubMeshLods( m_ImportedLods, m_NumSubMeshes, lod );
+	}
 }
 
 
@@ -609,12 +844,8 @@ void CMesh::Render(	CMatrix4x4* matrices )
 		SetRenderMethod( material.renderMethod, &material.diffuseColour, &material.specularColour, material.specularPower, material.textures, &matrices[subMeshDX.node] );
 		ID3D10EffectTechnique* technique = GetRenderMethodTechnique( material.renderMethod );
 
-		// Select vertex and index buffer for sub-mesh - assuming all geometry data is triangle lists
-		UINT offset = 0;
-		g_pd3dDevice->IASetVertexBuffers( 0, 1, &subMeshDX.vertexBuffer, &subMeshDX.vertexSize, &offset );
-		g_pd3dDevice->IASetInputLayout(subMeshDX.vertexLayout );
-		g_pd3dDevice->IASetIndexBuffer(subMeshDX.indexBuffer, DXGI_FORMAT_R16_UINT, 0 );
-		g_pd3dDevice->IASetPrimitiveTopology( D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+		// Select vertex and index buffer for sub-mesh
+		SetGeometryDX( subMesh );
 
 		// Render the sub-mesh. Geometry buffers and shader variables, just select the technique for this method and draw.
 		D3D10_TECHNIQUE_DESC techDesc;
@@ -622,11 +853,77 @@ void CMesh::Render(	CMatrix4x4* matrices )
 		for( UINT p = 0; p < techDesc.Passes; ++p )
 		{
 			technique->GetPassByIndex( p )->Apply( 0 );
-			g_pd3dDevice->DrawIndexed( subMeshDX.numIndices, 0, 0 );
+			g_pd3dDevice->DrawIndexed( subMeshDX.numIndices[0], 0, 0 );
 		}
-		g_pd3dDevice->DrawIndexed( subMeshDX.numIndices, 0, 0 );
 	}
 }
 
+// Add a draw for each sub-mesh to the given render queue at the given level of detail, using the
+// given matrix list as a hierarchy (must be one matrix per node). The matrices must remain valid
+// until the queue is flushed. If a frustum is given, sub-meshes whose bounding spheres are outside
+// it are skipped. Returns the number of triangles submitted
+TUInt32 CMesh::Submit( CMatrix4x4* matrices, CRenderQueue* queue, TUInt32 lod /*= 0*/,
+                       const CFrustum* frustum /*= 0*/ )
+{
+	if (!m_HasGeometry) return 0;
+
+	// With a single sub-mesh the caller's culling of the whole mesh is enough
+	if (m_NumSubMeshes == 1)
+	{
+		frustum = 0;
+	}
+
+	lod = Min( lod, m_NumLods - 1 );
+	TUInt32 numTriangles = 0;
+	for (TUInt32 subMesh = 0; subMesh < m_NumSubMeshes; ++subMesh)
+	{
+		// Small sub-meshes may have been simplified away at the coarser levels
+		const SSubMeshDX& subMeshDX = m_SubMeshesDX[subMesh];
+		if (subMeshDX.numIndices[lod] == 0) continue;
+
+		// Bounding sphere moved into world space by the node matrix, scaled by its largest scale
+		if (frustum)
+		{
+			const SMeshBounds& bounds = m_SubMeshBounds[subMesh];
+			const CMatrix4x4& matrix = matrices[subMeshDX.node];
+			TFloat32 maxScaleSq = Max( matrix.XAxis().LengthSquared(),
+			                      Max( matrix.YAxis().LengthSquared(), matrix.ZAxis().LengthSquared() ) );
+			if (!frustum->IsSphereVisible( matrix.TransformPoint( bounds.centre ), bounds.radius * Sqrt( maxScaleSq ) ))
+			{
+				continue;
+			}
+		}
+
+		queue->Submit( m_Materials[subMeshDX.material].renderMethod, m_MeshID, subMeshDX.material, subMesh, lod,
+		               this, &matrices[subMeshDX.node] );
+		numTriangles += subMeshDX.numIndices[lod] / 3;
+	}
+	return numTriangles;
+}
+
+// Set the shader variables for the given material, for following draws (used by the render
+// backend - the world matrix is set separately for each draw)
+void CMesh::SetMaterialDX( TUInt32 material )
+{
+	SMeshMaterialDX& materialDX = m_Materials[material];
+	CMatrix4x4 worldMatrix = CMatrix4x4::kIdentity; // Render methods also set a world matrix, replaced by each draw
+	SetRenderMethod( materialDX.renderMethod, &materialDX.diffuseColour, &materialDX.specularColour, materialDX.specularPower,
+	                 materialDX.textures, &worldMatrix );
+}
+
+// Select the vertex / index buffers of the given sub-mesh and level of detail for following draws,
+// along with the shader decoding of its vertices
+void CMesh::SetGeometryDX( TUInt32 subMesh, TUInt32 lod /*= 0*/ )
+{
+	// Assuming all geometry data is triangle lists
+	SSubMeshDX& subMeshDX = m_SubMeshesDX[subMesh];
+	SetVertexDecoding( subMeshDX.positionScale, subMeshDX.positionOffset, subMeshDX.octahedralNormals );
+	UINT offset = 0;
+	g_pd3dDevice->IASetVertexBuffers( 0, 1, &subMeshDX.vertexBuffer, &subMeshDX.vertexSize, &offset );
+	g_pd3dDevice->IASetInputLayout( subMeshDX.vertexLayout );
+	g_pd3dDevice->IASetIndexBuffer( subMeshDX.indexBuffer[lod], subMeshDX.indexFormat, 0 );
+	g_pd3dDevice->IASetPrimitiveTopology( D3D10_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+}
+
 
 } // namespace gen
\ No newline at end of file
@@ -7,18 +7,39 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <atomic>
 using namespace std;
 
 #include <d3d10.h>
 
 #include "../Common/Defines.h"
+#include "../Common/MemoryTracker.h"
 #include "../Math/CVector3.h"
 #include "../Math/CMatrix4x4.h"
 #include "MeshData.h"
+#include "MeshSimplifier.h"
+#include "MeshBounds.h"
+#include "VertexCompression.h"
 #include "../Scene/Camera.h"
+#include "RenderQueue.h"
 
 namespace gen
 {
+
+class CMeshFile;
+class CAssetCache;
+class CFrustum;
+
+// Memory in bytes used by the geometry of a mesh once its DirectX resources are created. The
+// "full" sizes are those the vertices would use uncompressed on the GPU and complete on the CPU
+struct SMeshMemory
+{
+	TUInt64 gpuVertices, gpuVerticesFull;
+	TUInt64 gpuIndices;
+	TUInt64 cpuVertices, cpuVerticesFull;
+	TUInt64 cpuIndices;
+};
 	
 // Mesh class
 class CMesh
@@ -38,6 +59,9 @@ private:
 public:
 	~CMesh();
 
+	// Meshes, their arrays and their CPU geometry are counted against the meshes memory tag
+	GEN_MEMORY_TAG( EMemoryTag::Meshes )
+
 
 /*-----------------------------------------------------------------------------------------
 	Public interface
@@ -63,6 +87,17 @@ public:
 		return m_BoundingRadius;
 	}
 
+	// Bounds of a single sub-mesh, or of all the sub-meshes controlled by a node, in the model
+	// space of the node (see MeshBounds.h). Nodes without sub-meshes have empty bounds
+	const SMeshBounds& GetSubMeshBounds( TUInt32 subMesh )
+	{
+		return m_SubMeshBounds[subMesh];
+	}
+	const SMeshBounds& GetNodeBounds( TUInt32 node )
+	{
+		return m_NodeBounds[node];
+	}
+
 
 	// Return total number of triangles in the mesh
 	TUInt32 GetNumTriangles();
@@ -90,6 +125,50 @@ public:
 	bool GetVertex( CVector3* pVertex );
 
 
+	/////////////////////////////////////
+	// Sub-mesh access
+
+	// Number unique to this mesh, used to group draws of the same mesh in the render queue
+	TUInt32 GetMeshID()
+	{
+		return m_MeshID;
+	}
+
+	TUInt32 GetNumSubMeshes()
+	{
+		return m_NumSubMeshes;
+	}
+
+	TUInt32 GetSubMeshNumIndices( TUInt32 subMesh, TUInt32 lod = 0 )
+	{
+		return m_SubMeshesDX[subMesh].numIndices[lod];
+	}
+
+
+	/////////////////////////////////////
+	// Levels of detail
+
+	// Number of levels of detail, including the full detail level 0. Further levels are
+	// simplified versions of the mesh, generated on import (see MeshSimplifier.h)
+	TUInt32 GetNumLods()
+	{
+		return m_NumLods;
+	}
+
+	// How far the surface of the given level has moved from the full detail mesh, in model units
+	// (see SSubMeshLod). Used to choose the level from the size it would appear on screen
+	TFloat32 GetLodError( TUInt32 lod )
+	{
+		return m_Lods[lod].error;
+	}
+
+	// Number of triangles drawn for the given level
+	TUInt32 GetLodNumTriangles( TUInt32 lod )
+	{
+		return m_Lods[lod].numTriangles;
+	}
+
+
 	/////////////////////////////////////
 	// Hierarchy access
 
@@ -107,8 +186,49 @@ public:
 	/////////////////////////////////////
 	// Creation
 
-	// Load the mesh from an X-File
-	bool Load( const string& fileName );
+	// Load the mesh from an X-File. Uses the cooked version of the file (see MeshFile.h) instead if
+	// there is one and it is up to date. If an asset cache is given, textures are shared through it
+	bool Load( const string& fileName, CAssetCache* cache = 0 )
+	{
+		return Import( fileName ) && CreateResources( cache );
+	}
+
+	// Loading in two stages. Import reads the file and prepares the geometry on the CPU - it needs
+	// no device, so meshes can be imported on several threads at once. CreateResources then loads
+	// the textures and creates the DirectX data, on the device's thread. Returns false on failure,
+	// when the mesh is left empty
+	// If a thread pool is given, the sub-meshes are processed on it - Import must not then be
+	// called from a job on the same pool
+	bool Import( const string& fileName, CThreadPool* pool = 0 );
+	bool CreateResources( CAssetCache* cache = 0 );
+
+
+	/////////////////////////////////////
+	// CPU geometry
+
+	// Size in bytes of the CPU copy of the geometry kept after loading, for triangle and vertex
+	// enumeration. 0 once released
+	TUInt32 CpuDataSize();
+
+	// Release the CPU copy of the geometry to save memory - rendering is unaffected, but triangle
+	// and vertex enumeration will return nothing
+	void ReleaseCpuData();
+
+private:
+	// Update the memory tracker with the size of the CPU geometry owned by the mesh. Call after any
+	// change to it - the geometry is allocated by the importers, so is not tagged itself
+	void TrackCpuData();
+
+public:
+
+	// Get the memory used by the geometry of the mesh once its resources are created, along with
+	// what it would use with uncompressed vertices and a full CPU copy
+	SMeshMemory GetMemoryUsage();
+
+	bool HasCpuData()
+	{
+		return m_HasCpuData;
+	}
 
 
 	/////////////////////////////////////
@@ -117,6 +237,19 @@ public:
 	// Render the model using the given matrix list as a hierarchy (must be one matrix per node)
 	void Render( CMatrix4x4* matrices );
 
+	// Add a draw for each sub-mesh to the given render queue at the given level of detail, using
+	// the given matrix list as a hierarchy (must be one matrix per node). The matrices must remain
+	// valid until the queue is flushed. If a frustum is given, sub-meshes whose bounding spheres
+	// are outside it are skipped. Returns the number of triangles submitted
+	TUInt32 Submit( CMatrix4x4* matrices, CRenderQueue* queue, TUInt32 lod = 0, const CFrustum* frustum = 0 );
+
+	// Set the shader variables for the given material, for following draws (used by the render
+	// backend - the world matrix is set separately for each draw)
+	void SetMaterialDX( TUInt32 material );
+
+	// Select the vertex / index buffers of the given sub-mesh and level of detail for following draws
+	void SetGeometryDX( TUInt32 subMesh, TUInt32 lod = 0 );
+
 
 /*-----------------------------------------------------------------------------------------
 	Private interface
@@ -143,10 +276,19 @@ private:
 		D3D10_INPUT_ELEMENT_DESC vertexElts[MAX_VERTEX_ELTS];
 		ID3D10InputLayout*       vertexLayout; // Layout of a vertex (derived from above array)
 		unsigned int             vertexSize;   // Size of vertex calculated from contained elements
-
-		// Index data for the sub-mesh stored in a index buffer and the number of indices in the buffer
-		ID3D10Buffer*            indexBuffer;
-		TUInt32                  numIndices;
+		unsigned int             fullVertexSize; // Size the vertex would be without compression
+
+		// Shader decoding of the compressed vertices, see SCompressedLayout
+		CVector3                 positionScale;
+		CVector3                 positionOffset;
+		bool                     octahedralNormals;
+
+		// Index data for the sub-mesh stored in a index buffer for each level of detail, the number of
+		// indices in each buffer and their format (16-bit unless the sub-mesh has too many vertices).
+		// All levels use the same vertex buffer
+		ID3D10Buffer*            indexBuffer[kiMaxMeshLods];
+		TUInt32                  numIndices[kiMaxMeshLods];
+		DXGI_FORMAT              indexFormat;
 	};
 
 
@@ -178,23 +320,58 @@ private:
 	);
 
 	// Creates a DirectX specific sub-mesh from an imported sub-mesh (mesh materials must already have been prepared as we need to know render method to setup vertex data)
+	// The vertices are compressed as requested, positions relative to the given sub-mesh bounds
 	bool CreateSubMeshDX
 	(
-		const SSubMesh& subMesh,
-		SSubMeshDX*     subMeshDX
+		const SSubMesh&           subMesh,
+		const SMeshBounds&        bounds,
+		const SSubMeshLod*        subMeshLods,
+		const SVertexCompression& compression,
+		SSubMeshDX*               subMeshDX
 	);
 
+	// Create an index buffer in the sub-mesh's index format from a list of 32-bit indices
+	bool CreateIndexBufferDX
+	(
+		const vector<TUInt32>& indices,
+		const SSubMeshDX&      subMeshDX,
+		ID3D10Buffer**         indexBuffer
+	);
+
+
+	// Get nodes, materials and sub-meshes from an imported X-File or a cooked mesh file, which
+	// provide the same data access functions
+	template <class TSource>
+	bool CreateFromSource( const TSource& source );
+
+	// Pre-processing after loading, sub-meshes are processed on the thread pool if given
+	bool PreProcess( CThreadPool* pool = 0 );
+
+	// Generate the simplified levels of detail from the imported sub-meshes
+	void CreateLods();
 
-	// Pre-processing after loading
-	bool PreProcess();
+	// Get the levels of detail stored in a cooked mesh file instead of generating them
+	void ReadLods( const CMeshFile& meshFile );
+
+	// Replace the CPU copy of each sub-mesh's vertices with just their positions once the DirectX
+	// sub-meshes are created. Faces from a cooked file are copied so the file can be closed
+	void StripCpuData();
 
 
 	/*---------------------------------------------------------------------------------------------
 		Data
 	---------------------------------------------------------------------------------------------*/
 
-	// Does this mesh have any geometry to render
+	// Unique ID for this mesh, and the ID to give the next mesh constructed
+	TUInt32          m_MeshID;
+	static atomic<TUInt32> m_NextMeshID; // Meshes may be constructed on several threads
+
+	// Does this mesh have any geometry to render, and is the CPU copy of the geometry still held
 	bool             m_HasGeometry;
+	bool             m_HasCpuData;
+
+	// Cache providing the textures, 0 if the mesh loaded its own
+	CAssetCache*     m_Cache;
 
 	// Hierarchy for mesh - stored as a depth-first list of nodes, see SMeshNode defn in MeshData.h
 	TUInt32          m_NumNodes;
@@ -205,7 +382,19 @@ private:
 	SSubMesh*        m_SubMeshes;    // Original sub-mesh data (dynamically allocated array)
 	SSubMeshDX*      m_SubMeshesDX;  // DirectX sub-mesh data (vertex / index buffers)
 
-	// Materials used in mesh
+	// Cooked mesh file the mesh was loaded from, or 0 if imported from an X-File. Kept open until
+	// the DirectX sub-meshes are created as the original sub-mesh data above points into it
+	CMeshFile*       m_File;
+
+	// Size in bytes of the CPU vertex data before it was stripped to positions
+	TUInt32          m_FullCpuVertexSize;
+
+	// Size in bytes of the CPU geometry owned by the mesh (not a mapped file) as last counted in
+	// the memory tracker, see TrackCpuData
+	TUInt32          m_TrackedCpuData;
+
+	// Materials used in mesh. Imported materials are held until the DirectX versions are created
+	vector<SMeshMaterial> m_ImportedMaterials;
 	TUInt32          m_NumMaterials;
 	SMeshMaterialDX* m_Materials;    // Dynamically allocated array
 
@@ -216,6 +405,16 @@ private:
 	// Bounding sphere radius (from (0,0,0) in model space)
 	TFloat32         m_BoundingRadius;
 
+	// Bounds of each sub-mesh and each node, see MeshBounds.h
+	vector<SMeshBounds> m_SubMeshBounds;
+	vector<SMeshBounds> m_NodeBounds;
+
+	// Levels of detail, level 0 is the full mesh. The simplified faces of each sub-mesh for levels
+	// 1 and above (kiMaxMeshLods - 1 entries per sub-mesh) are held until the index buffers are created
+	TUInt32             m_NumLods;
+	SMeshLod            m_Lods[kiMaxMeshLods];
+	vector<SSubMeshLod> m_ImportedLods;
+
 	// Data to support vertex / triangle enumeration
 	TUInt32          m_EnumTriMesh;  // Current mesh being enumerated for triangles
 	TUInt32          m_EnumTri;      // Current triangle (within above mesh) being enumerated
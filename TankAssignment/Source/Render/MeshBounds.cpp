@@ -0,0 +1,523 @@
+/*******************************************
+	MeshBounds.cpp
+
+	Mesh bounding volume implementation
+********************************************/
+
+#include <xmmintrin.h> // SSE intrinsics
+#include <cfloat>
+
+#include "MeshBounds.h"
+#include "../Math/BaseMath.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// SSE support
+//-----------------------------------------------------------------------------
+
+// Load a vertex position into an SSE register (w = 0), reading only its three floats so the last
+// vertex can be loaded whatever follows it
+static inline __m128 LoadPosition( const TUInt8* position )
+{
+	const __m128 xy = _mm_loadl_pi( _mm_setzero_ps(), reinterpret_cast<const __m64*>(position) );
+	const __m128 z = _mm_load_ss( reinterpret_cast<const float*>(position) + 2 );
+	return _mm_movelh_ps( xy, z );
+}
+
+// Load the positions of four vertices starting at the given one, as separate registers of x, y
+// and z (structure of arrays). Vertices past the end repeat the last one, which leaves minimums
+// and maximums unchanged
+static inline void LoadPositions
+(
+	const TUInt8* positions,
+	TUInt32       stride,
+	TUInt32       vertex,
+	TUInt32       numVertices,
+	__m128*       x,
+	__m128*       y,
+	__m128*       z
+)
+{
+	const TUInt32 last = numVertices - 1;
+	__m128 p0 = LoadPosition( positions + vertex * stride );
+	__m128 p1 = LoadPosition( positions + Min( vertex + 1, last ) * stride );
+	__m128 p2 = LoadPosition( positions + Min( vertex + 2, last ) * stride );
+	__m128 p3 = LoadPosition( positions + Min( vertex + 3, last ) * stride );
+	_MM_TRANSPOSE4_PS( p0, p1, p2, p3 );
+	*x = p0;
+	*y = p1;
+	*z = p2;
+}
+
+// Reduce the four lanes of a register to one value
+static inline TFloat32 HorizontalMin( __m128 v )
+{
+	v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(2, 3, 0, 1) ) );
+	v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(1, 0, 3, 2) ) );
+	return _mm_cvtss_f32( v );
+}
+static inline TFloat32 HorizontalMax( __m128 v )
+{
+	v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(2, 3, 0, 1) ) );
+	v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(1, 0, 3, 2) ) );
+	return _mm_cvtss_f32( v );
+}
+static inline TFloat32 HorizontalSum( __m128 v )
+{
+	v = _mm_add_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(2, 3, 0, 1) ) );
+	v = _mm_add_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE(1, 0, 3, 2) ) );
+	return _mm_cvtss_f32( v );
+}
+
+
+//-----------------------------------------------------------------------------
+// Oriented boxes
+//-----------------------------------------------------------------------------
+
+// Set the oriented box of the bounds to their axis-aligned box
+static void SetAxisAlignedBox( SMeshBounds* bounds )
+{
+	bounds->boxCentre = (bounds->minBounds + bounds->maxBounds) * 0.5f;
+	bounds->boxAxes[0] = CVector3::kXAxis;
+	bounds->boxAxes[1] = CVector3::kYAxis;
+	bounds->boxAxes[2] = CVector3::kZAxis;
+	bounds->boxExtents = (bounds->maxBounds - bounds->minBounds) * 0.5f;
+}
+
+static TFloat32 BoxVolume( const CVector3& extents )
+{
+	return extents.x * extents.y * extents.z;
+}
+
+// Get the eigenvectors of a symmetric 3x3 matrix with Jacobi rotations, each rotation zeroing one
+// off-diagonal element. The matrix is destroyed. Converges in a few sweeps for 3x3
+static void SymmetricEigenvectors( TFloat64 a[3][3], CVector3 axes[3] )
+{
+	TFloat64 v[3][3] = { { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 }, { 0.0, 0.0, 1.0 } };
+	for (TUInt32 sweep = 0; sweep < 16; ++sweep)
+	{
+		TFloat64 offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+		TFloat64 diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+		if (offDiagonal <= diagonal * 1e-24)
+		{
+			break;
+		}
+
+		for (TUInt32 p = 0; p < 2; ++p)
+		{
+			for (TUInt32 q = p + 1; q < 3; ++q)
+			{
+				if (a[p][q] == 0.0)
+				{
+					continue;
+				}
+
+				// Rotation angle to zero a[p][q]
+				TFloat64 theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+				TFloat64 t = 1.0 / (Abs( theta ) + Sqrt( theta * theta + 1.0 ));
+				if (theta < 0.0)
+				{
+					t = -t;
+				}
+				TFloat64 c = 1.0 / Sqrt( t * t + 1.0 );
+				TFloat64 s = t * c;
+
+				for (TUInt32 k = 0; k < 3; ++k)
+				{
+					TFloat64 akp = a[k][p], akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+				for (TUInt32 k = 0; k < 3; ++k)
+				{
+					TFloat64 apk = a[p][k], aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+				for (TUInt32 k = 0; k < 3; ++k)
+				{
+					TFloat64 vkp = v[k][p], vkq = v[k][q];
+					v[k][p] = c * vkp - s * vkq;
+					v[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+
+	// Eigenvectors are the columns, made exactly orthonormal
+	axes[0] = Normalise( CVector3( static_cast<TFloat32>(v[0][0]), static_cast<TFloat32>(v[1][0]), static_cast<TFloat32>(v[2][0]) ) );
+	axes[1] = CVector3( static_cast<TFloat32>(v[0][1]), static_cast<TFloat32>(v[1][1]), static_cast<TFloat32>(v[2][1]) );
+	axes[1] = Normalise( axes[1] - axes[0] * Dot( axes[1], axes[0] ) );
+	axes[2] = Cross( axes[0], axes[1] );
+}
+
+// Fit an oriented box to the principal axes of the vertex positions (the eigenvectors of their
+// covariance), keeping it if it is smaller than the axis-aligned box. The box centre and sphere
+// must already be calculated
+static void FitOrientedBox( const TUInt8* positions, TUInt32 stride, TUInt32 numVertices, SMeshBounds* bounds )
+{
+	// Covariance of the positions. Sums are relative to the box centre to keep them small. Lanes
+	// past the last vertex are masked out of the sums
+	const __m128 centreX = _mm_set1_ps( bounds->centre.x );
+	const __m128 centreY = _mm_set1_ps( bounds->centre.y );
+	const __m128 centreZ = _mm_set1_ps( bounds->centre.z );
+	const __m128 laneIndex = _mm_set_ps( 3.0f, 2.0f, 1.0f, 0.0f );
+	__m128 sumX = _mm_setzero_ps(), sumY = _mm_setzero_ps(), sumZ = _mm_setzero_ps();
+	__m128 sumXX = _mm_setzero_ps(), sumXY = _mm_setzero_ps(), sumXZ = _mm_setzero_ps();
+	__m128 sumYY = _mm_setzero_ps(), sumYZ = _mm_setzero_ps(), sumZZ = _mm_setzero_ps();
+	for (TUInt32 vertex = 0; vertex < numVertices; vertex += 4)
+	{
+		__m128 x, y, z;
+		LoadPositions( positions, stride, vertex, numVertices, &x, &y, &z );
+		const __m128 inUse = _mm_cmplt_ps( laneIndex, _mm_set1_ps( static_cast<TFloat32>(numVertices - vertex) ) );
+		x = _mm_and_ps( _mm_sub_ps( x, centreX ), inUse );
+		y = _mm_and_ps( _mm_sub_ps( y, centreY ), inUse );
+		z = _mm_and_ps( _mm_sub_ps( z, centreZ ), inUse );
+		sumX = _mm_add_ps( sumX, x );
+		sumY = _mm_add_ps( sumY, y );
+		sumZ = _mm_add_ps( sumZ, z );
+		sumXX = _mm_add_ps( sumXX, _mm_mul_ps( x, x ) );
+		sumXY = _mm_add_ps( sumXY, _mm_mul_ps( x, y ) );
+		sumXZ = _mm_add_ps( sumXZ, _mm_mul_ps( x, z ) );
+		sumYY = _mm_add_ps( sumYY, _mm_mul_ps( y, y ) );
+		sumYZ = _mm_add_ps( sumYZ, _mm_mul_ps( y, z ) );
+		sumZZ = _mm_add_ps( sumZZ, _mm_mul_ps( z, z ) );
+	}
+	const TFloat64 invNum = 1.0 / numVertices;
+	const TFloat64 meanX = HorizontalSum( sumX ) * invNum;
+	const TFloat64 meanY = HorizontalSum( sumY ) * invNum;
+	const TFloat64 meanZ = HorizontalSum( sumZ ) * invNum;
+	TFloat64 covariance[3][3];
+	covariance[0][0] = HorizontalSum( sumXX ) * invNum - meanX * meanX;
+	covariance[0][1] = HorizontalSum( sumXY ) * invNum - meanX * meanY;
+	covariance[0][2] = HorizontalSum( sumXZ ) * invNum - meanX * meanZ;
+	covariance[1][1] = HorizontalSum( sumYY ) * invNum - meanY * meanY;
+	covariance[1][2] = HorizontalSum( sumYZ ) * invNum - meanY * meanZ;
+	covariance[2][2] = HorizontalSum( sumZZ ) * invNum - meanZ * meanZ;
+	covariance[1][0] = covariance[0][1];
+	covariance[2][0] = covariance[0][2];
+	covariance[2][1] = covariance[1][2];
+
+	CVector3 axes[3];
+	SymmetricEigenvectors( covariance, axes );
+
+	// Extent of the positions along each axis
+	TFloat32 minExtent[3], maxExtent[3];
+	for (TUInt32 axis = 0; axis < 3; ++axis)
+	{
+		const __m128 axisX = _mm_set1_ps( axes[axis].x );
+		const __m128 axisY = _mm_set1_ps( axes[axis].y );
+		const __m128 axisZ = _mm_set1_ps( axes[axis].z );
+		__m128 minDot = _mm_set1_ps( FLT_MAX );
+		__m128 maxDot = _mm_set1_ps( -FLT_MAX );
+		for (TUInt32 vertex = 0; vertex < numVertices; vertex += 4)
+		{
+			__m128 x, y, z;
+			LoadPositions( positions, stride, vertex, numVertices, &x, &y, &z );
+			__m128 dot = _mm_mul_ps( x, axisX );
+			dot = _mm_add_ps( dot, _mm_mul_ps( y, axisY ) );
+			dot = _mm_add_ps( dot, _mm_mul_ps( z, axisZ ) );
+			minDot = _mm_min_ps( minDot, dot );
+			maxDot = _mm_max_ps( maxDot, dot );
+		}
+		minExtent[axis] = HorizontalMin( minDot );
+		maxExtent[axis] = HorizontalMax( maxDot );
+	}
+
+	CVector3 extents( (maxExtent[0] - minExtent[0]) * 0.5f, (maxExtent[1] - minExtent[1]) * 0.5f,
+	                  (maxExtent[2] - minExtent[2]) * 0.5f );
+	if (BoxVolume( extents ) < BoxVolume( bounds->boxExtents ))
+	{
+		bounds->boxCentre = axes[0] * ((minExtent[0] + maxExtent[0]) * 0.5f) +
+		                    axes[1] * ((minExtent[1] + maxExtent[1]) * 0.5f) +
+		                    axes[2] * ((minExtent[2] + maxExtent[2]) * 0.5f);
+		bounds->boxAxes[0] = axes[0];
+		bounds->boxAxes[1] = axes[1];
+		bounds->boxAxes[2] = axes[2];
+		bounds->boxExtents = extents;
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Bounds calculation
+//-----------------------------------------------------------------------------
+
+// Set bounds that contain nothing
+void ClearBounds( SMeshBounds* bounds )
+{
+	bounds->minBounds = CVector3::kZero;
+	bounds->maxBounds = CVector3::kZero;
+	bounds->centre = CVector3::kZero;
+	bounds->radius = -1.0f;
+	bounds->originRadius = 0.0f;
+	SetAxisAlignedBox( bounds );
+}
+
+// Calculate the bounds of the vertices of a sub-mesh. The positions are read four vertices at a
+// time into x, y and z registers, and minimums and maximums taken across all of them before
+// reducing to single values
+void CalculateBounds( const SSubMesh& subMesh, SMeshBounds* bounds, bool fitOrientedBox /*= true*/ )
+{
+	ClearBounds( bounds );
+	const TUInt32 numVertices = subMesh.numVertices;
+	if (numVertices == 0)
+	{
+		return;
+	}
+	const TUInt8* positions = subMesh.vertices + GetVertexLayout( subMesh ).position;
+	const TUInt32 stride = subMesh.vertexSize;
+
+	// Box and distance from the origin
+	__m128 minX = _mm_set1_ps( FLT_MAX ), minY = minX, minZ = minX;
+	__m128 maxX = _mm_set1_ps( -FLT_MAX ), maxY = maxX, maxZ = maxX;
+	__m128 maxLengthSq = _mm_setzero_ps();
+	for (TUInt32 vertex = 0; vertex < numVertices; vertex += 4)
+	{
+		__m128 x, y, z;
+		LoadPositions( positions, stride, vertex, numVertices, &x, &y, &z );
+		minX = _mm_min_ps( minX, x );
+		minY = _mm_min_ps( minY, y );
+		minZ = _mm_min_ps( minZ, z );
+		maxX = _mm_max_ps( maxX, x );
+		maxY = _mm_max_ps( maxY, y );
+		maxZ = _mm_max_ps( maxZ, z );
+		__m128 lengthSq = _mm_mul_ps( x, x );
+		lengthSq = _mm_add_ps( lengthSq, _mm_mul_ps( y, y ) );
+		lengthSq = _mm_add_ps( lengthSq, _mm_mul_ps( z, z ) );
+		maxLengthSq = _mm_max_ps( maxLengthSq, lengthSq );
+	}
+	bounds->minBounds = CVector3( HorizontalMin( minX ), HorizontalMin( minY ), HorizontalMin( minZ ) );
+	bounds->maxBounds = CVector3( HorizontalMax( maxX ), HorizontalMax( maxY ), HorizontalMax( maxZ ) );
+	bounds->originRadius = Sqrt( HorizontalMax( maxLengthSq ) );
+
+	// Sphere around the box centre - not the smallest sphere, but close and quick to find
+	bounds->centre = (bounds->minBounds + bounds->maxBounds) * 0.5f;
+	const __m128 centreX = _mm_set1_ps( bounds->centre.x );
+	const __m128 centreY = _mm_set1_ps( bounds->centre.y );
+	const __m128 centreZ = _mm_set1_ps( bounds->centre.z );
+	__m128 maxDistanceSq = _mm_setzero_ps();
+	for (TUInt32 vertex = 0; vertex < numVertices; vertex += 4)
+	{
+		__m128 x, y, z;
+		LoadPositions( positions, stride, vertex, numVertices, &x, &y, &z );
+		x = _mm_sub_ps( x, centreX );
+		y = _mm_sub_ps( y, centreY );
+		z = _mm_sub_ps( z, centreZ );
+		__m128 distanceSq = _mm_mul_ps( x, x );
+		distanceSq = _mm_add_ps( distanceSq, _mm_mul_ps( y, y ) );
+		distanceSq = _mm_add_ps( distanceSq, _mm_mul_ps( z, z ) );
+		maxDistanceSq = _mm_max_ps( maxDistanceSq, distanceSq );
+	}
+	bounds->radius = Sqrt( HorizontalMax( maxDistanceSq ) );
+
+	SetAxisAlignedBox( bounds );
+	if (fitOrientedBox)
+	{
+		FitOrientedBox( positions, stride, numVertices, bounds );
+	}
+}
+
+
+// Expand bounds to contain another set of bounds in the same space
+void MergeBounds( SMeshBounds* bounds, const SMeshBounds& add )
+{
+	if (add.IsEmpty())
+	{
+		return;
+	}
+	if (bounds->IsEmpty())
+	{
+		*bounds = add;
+		return;
+	}
+
+	bounds->minBounds = CVector3( Min( bounds->minBounds.x, add.minBounds.x ), Min( bounds->minBounds.y, add.minBounds.y ),
+	                              Min( bounds->minBounds.z, add.minBounds.z ) );
+	bounds->maxBounds = CVector3( Max( bounds->maxBounds.x, add.maxBounds.x ), Max( bounds->maxBounds.y, add.maxBounds.y ),
+	                              Max( bounds->maxBounds.z, add.maxBounds.z ) );
+	bounds->originRadius = Max( bounds->originRadius, add.originRadius );
+
+	// Smallest sphere containing both spheres
+	CVector3 offset = add.centre - bounds->centre;
+	TFloat32 distance = Length( offset );
+	if (distance + add.radius <= bounds->radius)
+	{
+		// Already contains the other sphere
+	}
+	else if (distance + bounds->radius <= add.radius)
+	{
+		bounds->centre = add.centre;
+		bounds->radius = add.radius;
+	}
+	else
+	{
+		TFloat32 radius = (distance + bounds->radius + add.radius) * 0.5f;
+		bounds->centre += offset * ((radius - bounds->radius) / distance);
+		bounds->radius = radius;
+	}
+
+	// Oriented box keeps the axes of the larger box, extended to the corners of both boxes
+	const SMeshBounds* boxes[2] = { bounds, &add };
+	TUInt32 larger = (BoxVolume( add.boxExtents ) > BoxVolume( bounds->boxExtents )) ? 1 : 0;
+	CVector3 axes[3] = { boxes[larger]->boxAxes[0], boxes[larger]->boxAxes[1], boxes[larger]->boxAxes[2] };
+	TFloat32 minExtent[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	TFloat32 maxExtent[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (TUInt32 box = 0; box < 2; ++box)
+	{
+		const SMeshBounds& boxBounds = *boxes[box];
+		for (TUInt32 corner = 0; corner < 8; ++corner)
+		{
+			CVector3 point = boxBounds.boxCentre +
+			                 boxBounds.boxAxes[0] * ((corner & 1) ? boxBounds.boxExtents.x : -boxBounds.boxExtents.x) +
+			                 boxBounds.boxAxes[1] * ((corner & 2) ? boxBounds.boxExtents.y : -boxBounds.boxExtents.y) +
+			                 boxBounds.boxAxes[2] * ((corner & 4) ? boxBounds.boxExtents.z : -boxBounds.boxExtents.z);
+			for (TUInt32 axis = 0; axis < 3; ++axis)
+			{
+				TFloat32 dot = Dot( point, axes[axis] );
+				minExtent[axis] = Min( minExtent[axis], dot );
+				maxExtent[axis] = Max( maxExtent[axis], dot );
+			}
+		}
+	}
+	SetAxisAlignedBox( bounds );
+	CVector3 extents( (maxExtent[0] - minExtent[0]) * 0.5f, (maxExtent[1] - minExtent[1]) * 0.5f,
+	                  (maxExtent[2] - minExtent[2]) * 0.5f );
+	if (BoxVolume( extents ) < BoxVolume( bounds->boxExtents ))
+	{
+		bounds->boxCentre = axes[0] * ((minExtent[0] + maxExtent[0]) * 0.5f) +
+		                    axes[1] * ((minExtent[1] + maxExtent[1]) * 0.5f) +
+		                    axes[2] * ((minExtent[2] + maxExtent[2]) * 0.5f);
+		bounds->boxAxes[0] = axes[0];
+		bounds->boxAxes[1] = axes[1];
+		bounds->boxAxes[2] = axes[2];
+		bounds->boxExtents = extents;
+	}
+}
+
+
+// Calculate the bounds of each sub-mesh, each node and the whole mesh. Sub-meshes only write
+// their own bounds so can be done in parallel, the merging is cheap and done afterwards
+bool CalculateMeshBounds
+(
+	const SSubMesh* subMeshes,
+	TUInt32         numSubMeshes,
+	TUInt32         numNodes,
+	SMeshBounds*    subMeshBounds,
+	SMeshBounds*    nodeBounds,
+	SMeshBounds*    meshBounds,
+	CThreadPool*    pool /*= 0*/
+)
+{
+	auto calculateSubMesh = [&]( TUInt32 subMesh )
+	{
+		CalculateBounds( subMeshes[subMesh], &subMeshBounds[subMesh] );
+	};
+	if (pool && numSubMeshes > 1)
+	{
+		pool->ParallelFor( numSubMeshes, calculateSubMesh );
+	}
+	else
+	{
+		for (TUInt32 subMesh = 0; subMesh < numSubMeshes; ++subMesh)
+		{
+			calculateSubMesh( subMesh );
+		}
+	}
+
+	for (TUInt32 node = 0; node < numNodes; ++node)
+	{
+		ClearBounds( &nodeBounds[node] );
+	}
+	for (TUInt32 subMesh = 0; subMesh < numSubMeshes; ++subMesh)
+	{
+		if (subMeshes[subMesh].node < numNodes)
+		{
+			MergeBounds( &nodeBounds[subMeshes[subMesh].node], subMeshBounds[subMesh] );
+		}
+	}
+
+	ClearBounds( meshBounds );
+	for (TUInt32 node = 0; node < numNodes; ++node)
+	{
+		MergeBounds( meshBounds, nodeBounds[node] );
+	}
+	return !meshBounds->IsEmpty();
+}
+
+
+//-----------------------------------------------------------------------------
+// Intersection tests
+//-----------------------------------------------------------------------------
+
+// Return true if a sphere in the same space as the bounds touches the oriented box. Finds the
+// squared distance from the sphere centre to the nearest point of the box, one axis at a time
+bool SphereIntersectsBox( const SMeshBounds& bounds, const CVector3& centre, TFloat32 radius )
+{
+	if (bounds.IsEmpty())
+	{
+		return false;
+	}
+	const CVector3 offset = centre - bounds.boxCentre;
+	const TFloat32 extents[3] = { bounds.boxExtents.x, bounds.boxExtents.y, bounds.boxExtents.z };
+	TFloat32 distanceSq = 0.0f;
+	for (TUInt32 axis = 0; axis < 3; ++axis)
+	{
+		TFloat32 outside = Abs( Dot( offset, bounds.boxAxes[axis] ) ) - extents[axis];
+		if (outside > 0.0f)
+		{
+			distanceSq += outside * outside;
+		}
+	}
+	return distanceSq <= radius * radius;
+}
+
+// Return true if a sphere moving from start to end touches the oriented box. Clips the segment
+// against the slab between each pair of faces of the grown box - it hits if any part is left
+bool SegmentIntersectsBox( const SMeshBounds& bounds, const CVector3& start, const CVector3& end, TFloat32 radius )
+{
+	if (bounds.IsEmpty())
+	{
+		return false;
+	}
+	const CVector3 offset = start - bounds.boxCentre;
+	const CVector3 direction = end - start;
+	const TFloat32 extents[3] = { bounds.boxExtents.x, bounds.boxExtents.y, bounds.boxExtents.z };
+	TFloat32 tMin = 0.0f;
+	TFloat32 tMax = 1.0f;
+	for (TUInt32 axis = 0; axis < 3; ++axis)
+	{
+		TFloat32 extent = extents[axis] + radius;
+		TFloat32 position = Dot( offset, bounds.boxAxes[axis] );
+		TFloat32 speed = Dot( direction, bounds.boxAxes[axis] );
+		if (Abs( speed ) < kfEpsilon)
+		{
+			// Parallel to this slab, so inside it all the way or not at all
+			if (Abs( position ) > extent)
+			{
+				return false;
+			}
+			continue;
+		}
+		TFloat32 tEnter = (-extent - position) / speed;
+		TFloat32 tExit = (extent - position) / speed;
+		if (tEnter > tExit)
+		{
+			TFloat32 t = tEnter;
+			tEnter = tExit;
+			tExit = t;
+		}
+		tMin = Max( tMin, tEnter );
+		tMax = Min( tMax, tExit );
+		if (tMin > tMax)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+} // namespace gen
@@ -0,0 +1,88 @@
+/*******************************************
+	MeshBounds.h
+
+	Bounding volumes of sub-meshes and of the
+	mesh nodes that control them: axis-aligned
+	box, sphere and oriented box. Calculated on
+	import with SSE min/max reductions over the
+	vertex positions, sub-meshes in parallel
+********************************************/
+
+#pragma once
+
+#include "../Common/Defines.h"
+#include "../Common/CThreadPool.h"
+#include "../Math/CVector3.h"
+#include "MeshData.h"
+
+namespace gen
+{
+
+// Bounds of a set of vertices, in the model space of the node controlling them. Bounds with no
+// vertices (e.g. a node with no sub-meshes) have a negative radius, see IsEmpty
+struct SMeshBounds
+{
+	// Axis-aligned box
+	CVector3 minBounds;
+	CVector3 maxBounds;
+
+	// Sphere around the centre of the box
+	CVector3 centre;
+	TFloat32 radius;
+
+	// Radius of a sphere around the node origin (0,0,0), as used for the whole mesh bounds
+	TFloat32 originRadius;
+
+	// Oriented box - centre, unit axes and the half size along each axis. The same as the
+	// axis-aligned box unless an oriented box was fitted and found to be smaller
+	CVector3 boxCentre;
+	CVector3 boxAxes[3];
+	CVector3 boxExtents;
+
+	bool IsEmpty() const
+	{
+		return radius < 0.0f;
+	}
+};
+
+
+// Set bounds that contain nothing
+void ClearBounds( SMeshBounds* bounds );
+
+// Calculate the bounds of the vertices of a sub-mesh. The oriented box is fitted to the principal
+// axes of the vertices if requested (two extra passes), otherwise it is the axis-aligned box
+void CalculateBounds( const SSubMesh& subMesh, SMeshBounds* bounds, bool fitOrientedBox = true );
+
+// Expand bounds to contain another set of bounds in the same space
+void MergeBounds( SMeshBounds* bounds, const SMeshBounds& add );
+
+// Calculate the bounds of each sub-mesh, each node (its sub-meshes merged) and the whole mesh.
+// The mesh bounds merge the node bounds without moving them into the root space, so are only
+// suitable where the nodes may rotate about their origins (see CEntityTemplate::CullRadius).
+// Sub-meshes are processed on the given thread pool if there is one - this must not be called
+// from a job on the same pool. Returns false if there are no vertices
+bool CalculateMeshBounds
+(
+	const SSubMesh* subMeshes,
+	TUInt32         numSubMeshes,
+	TUInt32         numNodes,
+	SMeshBounds*    subMeshBounds, // numSubMeshes entries
+	SMeshBounds*    nodeBounds,    // numNodes entries
+	SMeshBounds*    meshBounds,
+	CThreadPool*    pool = 0
+);
+
+
+/////////////////////////////////////
+// Intersection tests
+
+// Return true if a sphere in the same space as the bounds touches the oriented box
+bool SphereIntersectsBox( const SMeshBounds& bounds, const CVector3& centre, TFloat32 radius );
+
+// Return true if a sphere moving along a line segment in the same space as the bounds touches the
+// oriented box on the way. The box is grown by the radius on each axis, so near the box's edges
+// and corners this is slightly generous compared with the swept sphere
+bool SegmentIntersectsBox( const SMeshBounds& bounds, const CVector3& start, const CVector3& end, TFloat32 radius );
+
+
+} // namespace gen
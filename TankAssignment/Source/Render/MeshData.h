@@ -15,7 +15,6 @@ using namespace std;
 #include "../Common/Defines.h"
 #include "Colour.h"
 #include "../Math/CMatrix4x4.h"
-#include "RenderMethod.h"
 
 namespace gen
 {
@@ -43,6 +42,14 @@ struct SMeshFace
 };
 typedef vector<SMeshFace> TMeshFaces;
 
+// A face with 32-bit vertex indices, used instead of SMeshFace by sub-meshes with more vertices
+// than 16-bit indices can address
+struct SMeshLargeFace
+{
+	TUInt32 aiVertex[3];
+};
+const TUInt32 kiMaxSmallFaceVertices = 65536;
+
 // A sub-mesh is a single block of geometry that uses the same material. It contains a set of faces
 // and vertices and is controlled by a single node. The vertices are pointed to as raw bytes,
 // because of the flexibility of vertex data
@@ -56,10 +63,132 @@ struct SSubMesh
 	bool       hasSkinningData, hasNormals, hasTangents, // Components of each vertex
 	           hasTextureCoords, hasVertexColours;       // (Vertex coordinate assumed)
 	TUInt32    numFaces;
-	SMeshFace* faces;
+	SMeshFace* faces;           // Faces with 16-bit indices, 0 if the sub-mesh uses large faces
+	SMeshLargeFace* largeFaces; // Faces with 32-bit indices, only used by sub-meshes with more
+	                            // than kiMaxSmallFaceVertices vertices (0 otherwise)
+};
+
+// Byte offsets of the components of each vertex of a sub-mesh. Components are stored in this
+// order (see CImportXFile::GetSubMesh), those not present have offset kNoVertexComponent
+const TUInt32 kNoVertexComponent = 0xffffffff;
+struct SVertexLayout
+{
+	TUInt32 position;     // float x, y, z - always present
+	TUInt32 skinning;     // float weights[4], uint8 bone indices[4]
+	TUInt32 normal;       // float x, y, z
+	TUInt32 tangent;      // float x, y, z
+	TUInt32 textureCoord; // float u, v
+	TUInt32 colour;       // float r, g, b, a
 };
 
+// Get the layout of the vertices of a sub-mesh from the components it has
+inline SVertexLayout GetVertexLayout( const SSubMesh& subMesh )
+{
+	SVertexLayout layout;
+	TUInt32 offset = 0;
+	layout.position = offset;
+	offset += 3 * sizeof(TFloat32);
+	layout.skinning = subMesh.hasSkinningData ? offset : kNoVertexComponent;
+	offset += subMesh.hasSkinningData ? 4 * sizeof(TFloat32) + sizeof(TUInt32) : 0;
+	layout.normal = subMesh.hasNormals ? offset : kNoVertexComponent;
+	offset += subMesh.hasNormals ? 3 * sizeof(TFloat32) : 0;
+	layout.tangent = subMesh.hasTangents ? offset : kNoVertexComponent;
+	offset += subMesh.hasTangents ? 3 * sizeof(TFloat32) : 0;
+	layout.textureCoord = subMesh.hasTextureCoords ? offset : kNoVertexComponent;
+	offset += subMesh.hasTextureCoords ? 2 * sizeof(TFloat32) : 0;
+	layout.colour = subMesh.hasVertexColours ? offset : kNoVertexComponent;
+	return layout;
+}
+
+// Get the size of a whole vertex of a sub-mesh from the components it has, see SVertexLayout
+inline TUInt32 GetVertexSize( const SSubMesh& subMesh )
+{
+	return static_cast<TUInt32>(3 * sizeof(TFloat32) +
+	                            (subMesh.hasSkinningData ? 4 * sizeof(TFloat32) + sizeof(TUInt32) : 0) +
+	                            (subMesh.hasNormals ? 3 * sizeof(TFloat32) : 0) +
+	                            (subMesh.hasTangents ? 3 * sizeof(TFloat32) : 0) +
+	                            (subMesh.hasTextureCoords ? 2 * sizeof(TFloat32) : 0) +
+	                            (subMesh.hasVertexColours ? 4 * sizeof(TFloat32) : 0));
+}
+
+// Get the index of a vertex of a face in a sub-mesh, whichever face type the sub-mesh uses
+inline TUInt32 GetFaceVertex( const SSubMesh& subMesh, TUInt32 face, TUInt32 corner )
+{
+	return subMesh.largeFaces ? subMesh.largeFaces[face].aiVertex[corner] : subMesh.faces[face].aiVertex[corner];
+}
+
+// Size in bytes of the face data of a sub-mesh
+inline TUInt32 GetFaceDataSize( const SSubMesh& subMesh )
+{
+	return subMesh.numFaces * static_cast<TUInt32>(subMesh.largeFaces ? sizeof(SMeshLargeFace) : sizeof(SMeshFace));
+}
 
+// Get the position of a vertex of a sub-mesh
+inline CVector3 GetVertexPosition( const SSubMesh& subMesh, TUInt32 vertex )
+{
+	const TUInt8* vertexData = subMesh.vertices + vertex * subMesh.vertexSize + GetVertexLayout( subMesh ).position;
+	return CVector3( reinterpret_cast<const TFloat32*>(vertexData) );
+}
+
+// Get the next triangle from a list of sub-meshes, for an enumeration whose current sub-mesh and
+// face are given (both 0 to start). Sub-meshes without faces are skipped. Fills the three vertex
+// positions and moves the enumeration on to the following face. Returns false if there are no
+// more triangles
+inline bool GetNextTriangle( const SSubMesh* subMeshes, TUInt32 numSubMeshes, TUInt32* subMesh, TUInt32* face,
+                             CVector3* vertex1, CVector3* vertex2, CVector3* vertex3 )
+{
+	while (*subMesh < numSubMeshes && *face >= subMeshes[*subMesh].numFaces)
+	{
+		++*subMesh;
+		*face = 0;
+	}
+	if (*subMesh >= numSubMeshes)
+	{
+		return false;
+	}
+
+	const SSubMesh& subMeshData = subMeshes[*subMesh];
+	*vertex1 = GetVertexPosition( subMeshData, GetFaceVertex( subMeshData, *face, 0 ) );
+	*vertex2 = GetVertexPosition( subMeshData, GetFaceVertex( subMeshData, *face, 1 ) );
+	*vertex3 = GetVertexPosition( subMeshData, GetFaceVertex( subMeshData, *face, 2 ) );
+	++*face;
+	return true;
+}
+
+// Get the next vertex position from a list of sub-meshes, for an enumeration whose current
+// sub-mesh and vertex are given (both 0 to start). Sub-meshes without vertices are skipped. Moves
+// the enumeration on to the following vertex. Returns false if there are no more vertices
+inline bool GetNextVertex( const SSubMesh* subMeshes, TUInt32 numSubMeshes, TUInt32* subMesh, TUInt32* vertex,
+                           CVector3* position )
+{
+	while (*subMesh < numSubMeshes && *vertex >= subMeshes[*subMesh].numVertices)
+	{
+		++*subMesh;
+		*vertex = 0;
+	}
+	if (*subMesh >= numSubMeshes)
+	{
+		return false;
+	}
+
+	*position = GetVertexPosition( subMeshes[*subMesh], *vertex );
+	++*vertex;
+	return true;
+}
+
+
+
+// Customisable list of render methods available for use in materials and implemented in
+// RenderMethod.cpp/.h. This list can be changed to to support new rendering methods
+enum ERenderMethod
+{
+	PlainColour        = 0,
+	PlainTexture       = 1,
+	PixelLit           = 2,
+	PixelLitTex        = 3,
+	CutoutPixelLitTex  = 4,
+	NumRenderMethods  // Leave this entry at end
+};
 
 const TUInt32 kiMaxTextures = 4;
 
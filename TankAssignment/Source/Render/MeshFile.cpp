@@ -0,0 +1,593 @@
+/*******************************************
+	MeshFile.cpp
+
+	Cooked mesh file implementation
+********************************************/
+
+#include <fstream>
+#include <cstring>
+
+#include "MeshFile.h"
+#include "../Common/Utility.h"
+
+namespace gen
+{
+
+// Folder for all texture and mesh files
+extern const string MediaFolder;
+
+// Layout of the file must not depend on the compiler
+static_assert( sizeof(SMeshFileHeader) == 104, "Mesh file header layout changed" );
+static_assert( sizeof(SMeshFileNode) == 144, "Mesh file node layout changed" );
+static_assert( sizeof(SMeshFileMaterial) == 60, "Mesh file material layout changed" );
+static_assert( sizeof(SMeshFileSubMesh) == 68, "Mesh file sub-mesh layout changed" );
+static_assert( sizeof(SMeshFileBounds) == 104, "Mesh file bounds layout changed" );
+static_assert( sizeof(SMeshFace) == 6, "Mesh face layout changed" );
+static_assert( sizeof(SMeshLargeFace) == 12, "Mesh face layout changed" );
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+CMeshFile::CMeshFile()
+{
+	m_Data = 0;
+	m_Size = 0;
+}
+
+CMeshFile::~CMeshFile()
+{
+	Close();
+}
+
+
+//-----------------------------------------------------------------------------
+// Opening / closing
+//-----------------------------------------------------------------------------
+
+// Name of the cooked file for the given X-File (same name with a .mesh extension)
+string CMeshFile::CookedFileName( const string& sourceFileName )
+{
+	string::size_type extension = sourceFileName.find_last_of( '.' );
+	string::size_type folder = sourceFileName.find_last_of( "\\/" );
+	if (extension == string::npos || (folder != string::npos && extension < folder))
+	{
+		return sourceFileName + ".mesh";
+	}
+	return sourceFileName.substr( 0, extension ) + ".mesh";
+}
+
+// Open the cooked file for the given mesh file (relative to the media folder). Fails if there
+// is no cooked file, or if the X-File is present and has changed since it was cooked
+bool CMeshFile::OpenForMesh( const string& meshFileName )
+{
+	string sourceFileName = MediaFolder + meshFileName;
+	if (!Open( CookedFileName( sourceFileName ) ))
+	{
+		return false;
+	}
+
+	// A missing X-File is fine - cooked files can be shipped alone
+	TUInt64 sourceSize, sourceTime;
+	if (GetFileStamp( sourceFileName, &sourceSize, &sourceTime ) &&
+	    (sourceSize != SourceSize() || sourceTime != SourceTime()))
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+// Map the given cooked file and check its contents are valid. Returns false on failure
+bool CMeshFile::Open( const string& fileName )
+{
+	Close();
+	if (!m_File.Open( fileName ) || m_File.Size() < sizeof(SMeshFileHeader))
+	{
+		Close();
+		return false;
+	}
+	m_Data = m_File.Data();
+	m_Size = m_File.Size();
+
+	if (!Validate())
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+// Unmap the file - any sub-mesh data returned is no longer valid
+void CMeshFile::Close()
+{
+	m_File.Close();
+	m_Data = 0;
+	m_Size = 0;
+}
+
+
+// Check every vertex index of the given faces is below the number of vertices
+template <class TFace>
+static bool FaceIndicesValid( const TFace* faces, TUInt32 numFaces, TUInt32 numVertices )
+{
+	for (TUInt32 face = 0; face < numFaces; ++face)
+	{
+		if (faces[face].aiVertex[0] >= numVertices || faces[face].aiVertex[1] >= numVertices ||
+		    faces[face].aiVertex[2] >= numVertices)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Set the vertex components of a sub-mesh from its file flags (EMeshFileVertexFlags)
+static void ReadVertexFlags( TUInt32 vertexFlags, SSubMesh* pSubMesh )
+{
+	pSubMesh->hasSkinningData = (vertexFlags & kMeshFileSkinning) != 0;
+	pSubMesh->hasNormals = (vertexFlags & kMeshFileNormals) != 0;
+	pSubMesh->hasTangents = (vertexFlags & kMeshFileTangents) != 0;
+	pSubMesh->hasTextureCoords = (vertexFlags & kMeshFileTextureCoords) != 0;
+	pSubMesh->hasVertexColours = (vertexFlags & kMeshFileVertexColours) != 0;
+}
+
+// Check all counts, offsets, strings and face indices in the file lie within it, that vertex
+// sizes match their components and that nodes are in parent-before-child order
+bool CMeshFile::Validate() const
+{
+	const SMeshFileHeader* header = Header();
+	if (memcmp( header->magic, kMeshFileMagic, sizeof(kMeshFileMagic) ) != 0 ||
+	    header->version != kMeshFileVersion || header->fileSize != m_Size ||
+	    header->numNodes == 0 || header->numSubMeshes == 0 ||
+	    header->numLods == 0 || header->numLods > kiMaxMeshLods)
+	{
+		return false;
+	}
+
+	// Use 64-bit sums so large counts can't wrap around
+	const TUInt64 size = m_Size;
+	if (static_cast<TUInt64>(header->nodesOffset) + header->numNodes * static_cast<TUInt64>(sizeof(SMeshFileNode)) > size ||
+	    static_cast<TUInt64>(header->materialsOffset) + header->numMaterials * static_cast<TUInt64>(sizeof(SMeshFileMaterial)) > size ||
+	    static_cast<TUInt64>(header->subMeshesOffset) + header->numSubMeshes * static_cast<TUInt64>(sizeof(SMeshFileSubMesh)) > size ||
+	    static_cast<TUInt64>(header->nodeBoundsOffset) + header->numNodes * static_cast<TUInt64>(sizeof(SMeshFileBounds)) > size ||
+	    static_cast<TUInt64>(header->subMeshBoundsOffset) + header->numSubMeshes * static_cast<TUInt64>(sizeof(SMeshFileBounds)) > size ||
+	    static_cast<TUInt64>(header->stringsOffset) + header->stringsSize > size ||
+	    header->nodesOffset % kMeshFileAlignment != 0 || header->materialsOffset % kMeshFileAlignment != 0 ||
+	    header->subMeshesOffset % kMeshFileAlignment != 0 || header->nodeBoundsOffset % kMeshFileAlignment != 0 ||
+	    header->subMeshBoundsOffset % kMeshFileAlignment != 0)
+	{
+		return false;
+	}
+
+	// String table must end with a terminator so no string can run past it
+	if (header->stringsSize == 0 || m_Data[header->stringsOffset + header->stringsSize - 1] != 0)
+	{
+		return false;
+	}
+
+	// Each node's parent must come before it (the root is its own parent). Code walking the
+	// hierarchy in one pass relies on this, e.g. CEntityTemplate::CalculateCullRadius
+	const SMeshFileNode* nodes = reinterpret_cast<const SMeshFileNode*>(m_Data + header->nodesOffset);
+	for (TUInt32 node = 0; node < header->numNodes; ++node)
+	{
+		bool parentValid = (node == 0) ? nodes[node].parent == 0 : nodes[node].parent < node;
+		if (nodes[node].nameOffset >= header->stringsSize || !parentValid)
+		{
+			return false;
+		}
+	}
+
+	const SMeshFileMaterial* materials = reinterpret_cast<const SMeshFileMaterial*>(m_Data + header->materialsOffset);
+	for (TUInt32 material = 0; material < header->numMaterials; ++material)
+	{
+		if (materials[material].renderMethod >= NumRenderMethods || materials[material].numTextures > kiMaxTextures)
+		{
+			return false;
+		}
+		for (TUInt32 texture = 0; texture < materials[material].numTextures; ++texture)
+		{
+			if (materials[material].textureNameOffsets[texture] >= header->stringsSize)
+			{
+				return false;
+			}
+		}
+	}
+
+	const SMeshFileSubMesh* subMeshes = reinterpret_cast<const SMeshFileSubMesh*>(m_Data + header->subMeshesOffset);
+	for (TUInt32 subMesh = 0; subMesh < header->numSubMeshes; ++subMesh)
+	{
+		const SMeshFileSubMesh& fileSubMesh = subMeshes[subMesh];
+		TUInt32 faceSize = (fileSubMesh.vertexFlags & kMeshFileLargeFaces) ? sizeof(SMeshLargeFace) : sizeof(SMeshFace);
+		SSubMesh components;
+		ReadVertexFlags( fileSubMesh.vertexFlags, &components );
+		if (fileSubMesh.node >= header->numNodes || fileSubMesh.material >= header->numMaterials ||
+		    fileSubMesh.numVertices == 0 || fileSubMesh.vertexSize != GetVertexSize( components ) ||
+		    fileSubMesh.verticesOffset % kMeshFileAlignment != 0 || fileSubMesh.facesOffset % kMeshFileAlignment != 0 ||
+		    static_cast<TUInt64>(fileSubMesh.verticesOffset) + fileSubMesh.numVertices * static_cast<TUInt64>(fileSubMesh.vertexSize) > size ||
+		    static_cast<TUInt64>(fileSubMesh.facesOffset) + fileSubMesh.numFaces * static_cast<TUInt64>(faceSize) > size)
+		{
+			return false;
+		}
+
+		// Faces are used directly for collision and index buffers, so every index must be a vertex
+		bool facesValid = (fileSubMesh.vertexFlags & kMeshFileLargeFaces) ?
+			FaceIndicesValid( reinterpret_cast<const SMeshLargeFace*>(m_Data + fileSubMesh.facesOffset), fileSubMesh.numFaces, fileSubMesh.numVertices ) :
+			FaceIndicesValid( reinterpret_cast<const SMeshFace*>(m_Data + fileSubMesh.facesOffset), fileSubMesh.numFaces, fileSubMesh.numVertices );
+		if (!facesValid)
+		{
+			return false;
+		}
+
+		// Likewise the faces of each level of detail
+		for (TUInt32 lod = 0; lod < header->numLods - 1; ++lod)
+		{
+			TUInt32 lodFacesOffset = fileSubMesh.lodFacesOffset[lod];
+			TUInt32 lodNumFaces = fileSubMesh.lodNumFaces[lod];
+			if (lodFacesOffset % kMeshFileAlignment != 0 ||
+			    static_cast<TUInt64>(lodFacesOffset) + lodNumFaces * static_cast<TUInt64>(faceSize) > size)
+			{
+				return false;
+			}
+			facesValid = (fileSubMesh.vertexFlags & kMeshFileLargeFaces) ?
+				FaceIndicesValid( reinterpret_cast<const SMeshLargeFace*>(m_Data + lodFacesOffset), lodNumFaces, fileSubMesh.numVertices ) :
+				FaceIndicesValid( reinterpret_cast<const SMeshFace*>(m_Data + lodFacesOffset), lodNumFaces, fileSubMesh.numVertices );
+			if (!facesValid)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Data access
+//-----------------------------------------------------------------------------
+
+void CMeshFile::GetNode( const TUInt32 iNode, SMeshNode* const pNode ) const
+{
+	const SMeshFileNode& fileNode = reinterpret_cast<const SMeshFileNode*>(m_Data + Header()->nodesOffset)[iNode];
+	pNode->name = String( fileNode.nameOffset );
+	pNode->depth = fileNode.depth;
+	pNode->parent = fileNode.parent;
+	pNode->numChildren = fileNode.numChildren;
+	memcpy( &pNode->positionMatrix.e00, fileNode.positionMatrix, sizeof(fileNode.positionMatrix) );
+	memcpy( &pNode->invMeshOffset.e00, fileNode.invMeshOffset, sizeof(fileNode.invMeshOffset) );
+}
+
+ERenderMethod CMeshFile::GetSubMeshRenderMethod( const TUInt32 iSubMesh ) const
+{
+	const SMeshFileSubMesh& fileSubMesh = reinterpret_cast<const SMeshFileSubMesh*>(m_Data + Header()->subMeshesOffset)[iSubMesh];
+	const SMeshFileMaterial& fileMaterial = reinterpret_cast<const SMeshFileMaterial*>(m_Data + Header()->materialsOffset)[fileSubMesh.material];
+	return static_cast<ERenderMethod>(fileMaterial.renderMethod);
+}
+
+// Vertex and face pointers refer directly to the file data. Tangents are included when the
+// file is cooked if the sub-mesh's render method needs them, so the last parameter is ignored
+EImportError CMeshFile::GetSubMesh( const TUInt32 iSubMesh, SSubMesh* pSubMesh, bool /*bTangents*/ ) const
+{
+	const SMeshFileSubMesh& fileSubMesh = reinterpret_cast<const SMeshFileSubMesh*>(m_Data + Header()->subMeshesOffset)[iSubMesh];
+	pSubMesh->node = fileSubMesh.node;
+	pSubMesh->material = fileSubMesh.material;
+	pSubMesh->numVertices = fileSubMesh.numVertices;
+	pSubMesh->vertexSize = fileSubMesh.vertexSize;
+	ReadVertexFlags( fileSubMesh.vertexFlags, pSubMesh );
+	pSubMesh->numFaces = fileSubMesh.numFaces;
+
+	// Mapping is read-only, SSubMesh only uses non-const pointers for imported data it owns
+	pSubMesh->vertices = const_cast<TUInt8*>(m_Data + fileSubMesh.verticesOffset);
+	TUInt8* faces = const_cast<TUInt8*>(m_Data + fileSubMesh.facesOffset);
+	bool largeFaces = (fileSubMesh.vertexFlags & kMeshFileLargeFaces) != 0;
+	pSubMesh->faces = largeFaces ? 0 : reinterpret_cast<SMeshFace*>(faces);
+	pSubMesh->largeFaces = largeFaces ? reinterpret_cast<SMeshLargeFace*>(faces) : 0;
+	return kSuccess;
+}
+
+// Copy faces from the file to a list of 32-bit indices
+template <class TFace>
+static void ReadIndices( const TFace* faces, TUInt32 numFaces, vector<TUInt32>* indices )
+{
+	indices->resize( numFaces * 3 );
+	for (TUInt32 face = 0; face < numFaces; ++face)
+	{
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			(*indices)[face * 3 + corner] = faces[face].aiVertex[corner];
+		}
+	}
+}
+
+// Get a simplified level of detail (1 and above) of a sub-mesh. Its faces are copied out as
+// 32-bit indices
+void CMeshFile::GetSubMeshLod( const TUInt32 iSubMesh, const TUInt32 lod, SSubMeshLod* pLod ) const
+{
+	const SMeshFileSubMesh& fileSubMesh = reinterpret_cast<const SMeshFileSubMesh*>(m_Data + Header()->subMeshesOffset)[iSubMesh];
+	const TUInt8* faces = m_Data + fileSubMesh.lodFacesOffset[lod - 1];
+	if (fileSubMesh.vertexFlags & kMeshFileLargeFaces)
+	{
+		ReadIndices( reinterpret_cast<const SMeshLargeFace*>(faces), fileSubMesh.lodNumFaces[lod - 1], &pLod->indices );
+	}
+	else
+	{
+		ReadIndices( reinterpret_cast<const SMeshFace*>(faces), fileSubMesh.lodNumFaces[lod - 1], &pLod->indices );
+	}
+	pLod->error = fileSubMesh.lodErrors[lod - 1];
+}
+
+// Copy bounds from their file form
+static void ReadBounds( const SMeshFileBounds& fileBounds, SMeshBounds* pBounds )
+{
+	pBounds->minBounds = CVector3( fileBounds.minBounds );
+	pBounds->maxBounds = CVector3( fileBounds.maxBounds );
+	pBounds->centre = CVector3( fileBounds.centre );
+	pBounds->radius = fileBounds.radius;
+	pBounds->originRadius = fileBounds.originRadius;
+	pBounds->boxCentre = CVector3( fileBounds.boxCentre );
+	pBounds->boxAxes[0] = CVector3( &fileBounds.boxAxes[0] );
+	pBounds->boxAxes[1] = CVector3( &fileBounds.boxAxes[3] );
+	pBounds->boxAxes[2] = CVector3( &fileBounds.boxAxes[6] );
+	pBounds->boxExtents = CVector3( fileBounds.boxExtents );
+}
+
+void CMeshFile::GetNodeBounds( const TUInt32 iNode, SMeshBounds* pBounds ) const
+{
+	ReadBounds( reinterpret_cast<const SMeshFileBounds*>(m_Data + Header()->nodeBoundsOffset)[iNode], pBounds );
+}
+
+void CMeshFile::GetSubMeshBounds( const TUInt32 iSubMesh, SMeshBounds* pBounds ) const
+{
+	ReadBounds( reinterpret_cast<const SMeshFileBounds*>(m_Data + Header()->subMeshBoundsOffset)[iSubMesh], pBounds );
+}
+
+void CMeshFile::GetMaterial( const TUInt32 iMaterial, SMeshMaterial* const pMaterial ) const
+{
+	const SMeshFileMaterial& fileMaterial = reinterpret_cast<const SMeshFileMaterial*>(m_Data + Header()->materialsOffset)[iMaterial];
+	pMaterial->renderMethod = static_cast<ERenderMethod>(fileMaterial.renderMethod);
+	pMaterial->diffuseColour = SColourRGBA( fileMaterial.diffuseColour[0], fileMaterial.diffuseColour[1],
+	                                        fileMaterial.diffuseColour[2], fileMaterial.diffuseColour[3] );
+	pMaterial->specularColour = SColourRGBA( fileMaterial.specularColour[0], fileMaterial.specularColour[1],
+	                                         fileMaterial.specularColour[2], fileMaterial.specularColour[3] );
+	pMaterial->specularPower = fileMaterial.specularPower;
+	pMaterial->numTextures = fileMaterial.numTextures;
+	for (TUInt32 texture = 0; texture < fileMaterial.numTextures; ++texture)
+	{
+		pMaterial->textureFileNames[texture] = String( fileMaterial.textureNameOffsets[texture] );
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Writing
+//-----------------------------------------------------------------------------
+
+// Append a string to a string table, returning its offset
+static TUInt32 AddString( vector<char>& strings, const string& s )
+{
+	TUInt32 offset = static_cast<TUInt32>(strings.size());
+	strings.insert( strings.end(), s.begin(), s.end() );
+	strings.push_back( 0 );
+	return offset;
+}
+
+// Copy a vector into a float array
+static void WriteVector( const CVector3& v, TFloat32* pOut )
+{
+	pOut[0] = v.x;
+	pOut[1] = v.y;
+	pOut[2] = v.z;
+}
+
+// Convert bounds to their file form
+static void WriteBounds( const SMeshBounds& bounds, SMeshFileBounds* pFileBounds )
+{
+	WriteVector( bounds.minBounds, pFileBounds->minBounds );
+	WriteVector( bounds.maxBounds, pFileBounds->maxBounds );
+	WriteVector( bounds.centre, pFileBounds->centre );
+	pFileBounds->radius = bounds.radius;
+	pFileBounds->originRadius = bounds.originRadius;
+	WriteVector( bounds.boxCentre, pFileBounds->boxCentre );
+	WriteVector( bounds.boxAxes[0], &pFileBounds->boxAxes[0] );
+	WriteVector( bounds.boxAxes[1], &pFileBounds->boxAxes[3] );
+	WriteVector( bounds.boxAxes[2], &pFileBounds->boxAxes[6] );
+	WriteVector( bounds.boxExtents, pFileBounds->boxExtents );
+}
+
+// Copy a list of 32-bit indices into the file as faces of the given form and index type
+template <class TFace, class TIndex>
+static void WriteIndices( const vector<TUInt32>& indices, TFace* faces )
+{
+	for (TUInt32 face = 0; face < indices.size() / 3; ++face)
+	{
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			faces[face].aiVertex[corner] = static_cast<TIndex>(indices[face * 3 + corner]);
+		}
+	}
+}
+
+// Round up an offset to the alignment used for blocks in the file
+static TUInt32 AlignOffset( TUInt32 offset )
+{
+	return (offset + kMeshFileAlignment - 1) & ~(kMeshFileAlignment - 1);
+}
+
+// Write a cooked mesh file from imported mesh data. Sub-meshes must be in their final form
+// (tangents calculated where needed), with their levels of detail laid out as by SimplifyMesh.
+// Returns false on failure
+bool CMeshFile::Write
+(
+	const string&                fileName,
+	TUInt64                      sourceSize,
+	TUInt64                      sourceTime,
+	const vector<SMeshNode>&     nodes,
+	const vector<SMeshMaterial>& materials,
+	const vector<SSubMesh>&      subMeshes,
+	const vector<SMeshBounds>&   nodeBounds,
+	const vector<SMeshBounds>&   subMeshBounds,
+	const SMeshBounds&           meshBounds,
+	TUInt32                      numLods,
+	const vector<SSubMeshLod>&   subMeshLods
+)
+{
+	if (nodes.empty() || subMeshes.empty() || nodeBounds.size() != nodes.size() ||
+	    subMeshBounds.size() != subMeshes.size() || numLods == 0 || numLods > kiMaxMeshLods ||
+	    (numLods > 1 && subMeshLods.size() != subMeshes.size() * (kiMaxMeshLods - 1)))
+	{
+		return false;
+	}
+
+	// Convert nodes and materials, collecting strings
+	vector<char> strings;
+	vector<SMeshFileNode> fileNodes( nodes.size() );
+	for (TUInt32 node = 0; node < nodes.size(); ++node)
+	{
+		SMeshFileNode& fileNode = fileNodes[node];
+		fileNode.nameOffset = AddString( strings, nodes[node].name );
+		fileNode.depth = nodes[node].depth;
+		fileNode.parent = nodes[node].parent;
+		fileNode.numChildren = nodes[node].numChildren;
+		memcpy( fileNode.positionMatrix, &nodes[node].positionMatrix.e00, sizeof(fileNode.positionMatrix) );
+		memcpy( fileNode.invMeshOffset, &nodes[node].invMeshOffset.e00, sizeof(fileNode.invMeshOffset) );
+	}
+
+	vector<SMeshFileMaterial> fileMaterials( materials.size() );
+	for (TUInt32 material = 0; material < materials.size(); ++material)
+	{
+		const SMeshMaterial& source = materials[material];
+		SMeshFileMaterial& fileMaterial = fileMaterials[material];
+		memset( &fileMaterial, 0, sizeof(fileMaterial) );
+		fileMaterial.renderMethod = source.renderMethod;
+		memcpy( fileMaterial.diffuseColour, &source.diffuseColour.r, sizeof(fileMaterial.diffuseColour) );
+		memcpy( fileMaterial.specularColour, &source.specularColour.r, sizeof(fileMaterial.specularColour) );
+		fileMaterial.specularPower = source.specularPower;
+		fileMaterial.numTextures = Min( source.numTextures, kiMaxTextures );
+		for (TUInt32 texture = 0; texture < fileMaterial.numTextures; ++texture)
+		{
+			fileMaterial.textureNameOffsets[texture] = AddString( strings, source.textureFileNames[texture] );
+		}
+	}
+	strings.push_back( 0 ); // Ensure table is never empty
+
+	vector<SMeshFileBounds> fileNodeBounds( nodeBounds.size() );
+	for (TUInt32 node = 0; node < nodeBounds.size(); ++node)
+	{
+		WriteBounds( nodeBounds[node], &fileNodeBounds[node] );
+	}
+	vector<SMeshFileBounds> fileSubMeshBounds( subMeshBounds.size() );
+	for (TUInt32 subMesh = 0; subMesh < subMeshBounds.size(); ++subMesh)
+	{
+		WriteBounds( subMeshBounds[subMesh], &fileSubMeshBounds[subMesh] );
+	}
+
+	// Lay out the file
+	SMeshFileHeader header;
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, kMeshFileMagic, sizeof(kMeshFileMagic) );
+	header.version = kMeshFileVersion;
+	header.sourceSize = sourceSize;
+	header.sourceTime = sourceTime;
+	header.numNodes = static_cast<TUInt32>(fileNodes.size());
+	header.numMaterials = static_cast<TUInt32>(fileMaterials.size());
+	header.numSubMeshes = static_cast<TUInt32>(subMeshes.size());
+	header.nodesOffset = AlignOffset( sizeof(SMeshFileHeader) );
+	header.materialsOffset = AlignOffset( header.nodesOffset + header.numNodes * sizeof(SMeshFileNode) );
+	header.subMeshesOffset = AlignOffset( header.materialsOffset + header.numMaterials * sizeof(SMeshFileMaterial) );
+	header.nodeBoundsOffset = AlignOffset( header.subMeshesOffset + header.numSubMeshes * sizeof(SMeshFileSubMesh) );
+	header.subMeshBoundsOffset = AlignOffset( header.nodeBoundsOffset + header.numNodes * sizeof(SMeshFileBounds) );
+	header.stringsOffset = AlignOffset( header.subMeshBoundsOffset + header.numSubMeshes * sizeof(SMeshFileBounds) );
+	header.stringsSize = static_cast<TUInt32>(strings.size());
+	WriteVector( meshBounds.minBounds, header.minBounds );
+	WriteVector( meshBounds.maxBounds, header.maxBounds );
+	header.boundingRadius = meshBounds.originRadius;
+	header.numLods = numLods;
+
+	TUInt32 offset = header.stringsOffset + header.stringsSize;
+	vector<SMeshFileSubMesh> fileSubMeshes( subMeshes.size() );
+	for (TUInt32 subMesh = 0; subMesh < subMeshes.size(); ++subMesh)
+	{
+		const SSubMesh& source = subMeshes[subMesh];
+		SMeshFileSubMesh& fileSubMesh = fileSubMeshes[subMesh];
+		fileSubMesh.node = source.node;
+		fileSubMesh.material = source.material;
+		fileSubMesh.numVertices = source.numVertices;
+		fileSubMesh.vertexSize = source.vertexSize;
+		fileSubMesh.vertexFlags = (source.hasSkinningData  ? kMeshFileSkinning : 0) |
+		                          (source.hasNormals       ? kMeshFileNormals : 0) |
+		                          (source.hasTangents      ? kMeshFileTangents : 0) |
+		                          (source.hasTextureCoords ? kMeshFileTextureCoords : 0) |
+		                          (source.hasVertexColours ? kMeshFileVertexColours : 0) |
+		                          (source.largeFaces       ? kMeshFileLargeFaces : 0);
+		fileSubMesh.numFaces = source.numFaces;
+		fileSubMesh.verticesOffset = AlignOffset( offset );
+		fileSubMesh.facesOffset = AlignOffset( fileSubMesh.verticesOffset + source.numVertices * source.vertexSize );
+		offset = fileSubMesh.facesOffset + GetFaceDataSize( source );
+
+		TUInt32 faceSize = static_cast<TUInt32>(source.largeFaces ? sizeof(SMeshLargeFace) : sizeof(SMeshFace));
+		for (TUInt32 lod = 0; lod < kiMaxMeshLods - 1; ++lod)
+		{
+			fileSubMesh.lodNumFaces[lod] = 0;
+			fileSubMesh.lodFacesOffset[lod] = 0;
+			fileSubMesh.lodErrors[lod] = 0.0f;
+			if (lod < numLods - 1)
+			{
+				const SSubMeshLod& sourceLod = subMeshLods[subMesh * (kiMaxMeshLods - 1) + lod];
+				fileSubMesh.lodNumFaces[lod] = static_cast<TUInt32>(sourceLod.indices.size()) / 3;
+				fileSubMesh.lodFacesOffset[lod] = AlignOffset( offset );
+				fileSubMesh.lodErrors[lod] = sourceLod.error;
+				offset = fileSubMesh.lodFacesOffset[lod] + fileSubMesh.lodNumFaces[lod] * faceSize;
+			}
+		}
+	}
+	header.fileSize = offset;
+
+	// Build the file in memory then write in one go
+	vector<TUInt8> data( header.fileSize, 0 );
+	memcpy( &data[0], &header, sizeof(header) );
+	memcpy( &data[header.nodesOffset], &fileNodes[0], fileNodes.size() * sizeof(SMeshFileNode) );
+	if (!fileMaterials.empty())
+	{
+		memcpy( &data[header.materialsOffset], &fileMaterials[0], fileMaterials.size() * sizeof(SMeshFileMaterial) );
+	}
+	memcpy( &data[header.subMeshesOffset], &fileSubMeshes[0], fileSubMeshes.size() * sizeof(SMeshFileSubMesh) );
+	memcpy( &data[header.nodeBoundsOffset], &fileNodeBounds[0], fileNodeBounds.size() * sizeof(SMeshFileBounds) );
+	memcpy( &data[header.subMeshBoundsOffset], &fileSubMeshBounds[0], fileSubMeshBounds.size() * sizeof(SMeshFileBounds) );
+	memcpy( &data[header.stringsOffset], &strings[0], strings.size() );
+	for (TUInt32 subMesh = 0; subMesh < subMeshes.size(); ++subMesh)
+	{
+		const SSubMesh& source = subMeshes[subMesh];
+		memcpy( &data[fileSubMeshes[subMesh].verticesOffset], source.vertices, source.numVertices * source.vertexSize );
+		if (source.numFaces > 0)
+		{
+			const void* faces = source.largeFaces ? static_cast<const void*>(source.largeFaces) : source.faces;
+			memcpy( &data[fileSubMeshes[subMesh].facesOffset], faces, GetFaceDataSize( source ) );
+		}
+		for (TUInt32 lod = 0; lod < numLods - 1; ++lod)
+		{
+			const vector<TUInt32>& indices = subMeshLods[subMesh * (kiMaxMeshLods - 1) + lod].indices;
+			TUInt8* faces = &data[0] + fileSubMeshes[subMesh].lodFacesOffset[lod];
+			if (source.largeFaces)
+			{
+				WriteIndices<SMeshLargeFace, TUInt32>( indices, reinterpret_cast<SMeshLargeFace*>(faces) );
+			}
+			else
+			{
+				WriteIndices<SMeshFace, TUInt16>( indices, reinterpret_cast<SMeshFace*>(faces) );
+			}
+		}
+	}
+
+	ofstream file( fileName.c_str(), ios::binary | ios::trunc );
+	if (!file)
+	{
+		return false;
+	}
+	file.write( reinterpret_cast<const char*>(&data[0]), data.size() );
+	return static_cast<bool>(file);
+}
+
+
+} // namespace gen
@@ -0,0 +1,292 @@
+/*******************************************
+	MeshFile.h
+
+	Cooked binary mesh files, written by the
+	MeshCook tool from X-Files. Holds the
+	output of the whole import pipeline plus
+	the bounds, and is memory-mapped when read
+	so sub-mesh vertex / index data is used in
+	place without copying
+********************************************/
+
+#pragma once
+
+#include <vector>
+#include <string>
+using namespace std;
+
+#include "../Common/Defines.h"
+#include "../Common/CMappedFile.h"
+#include "../Math/CVector3.h"
+#include "MeshData.h"
+#include "MeshBounds.h"
+#include "MeshSimplifier.h"
+#include "CImportXFile.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// File format
+
+// A cooked mesh file is a header followed by arrays of nodes, materials and sub-meshes, the
+// bounds of each node and sub-mesh, a table of null-terminated strings, then the vertex and index
+// data of each sub-mesh followed by the index data of its simplified levels of detail. Offsets are
+// in bytes from the start of the file, arrays and geometry blocks start on 16 byte boundaries.
+// Data is stored little-endian as on all our target machines. Change the version if the format
+// changes - old files will be ignored and the X-File used instead until they are cooked again
+const char    kMeshFileMagic[4] = { 'T', 'M', 'S', 'H' };
+const TUInt32 kMeshFileVersion = 4;
+const TUInt32 kMeshFileAlignment = 16;
+
+struct SMeshFileHeader
+{
+	char     magic[4];       // kMeshFileMagic
+	TUInt32  version;        // kMeshFileVersion
+	TUInt64  sourceSize;     // Size and modification time of the X-File this was cooked from,
+	TUInt64  sourceTime;     // used to detect when it needs cooking again
+	TUInt32  fileSize;       // Size of whole file, to detect truncation
+
+	TUInt32  numNodes;
+	TUInt32  nodesOffset;
+	TUInt32  numMaterials;
+	TUInt32  materialsOffset;
+	TUInt32  numSubMeshes;
+	TUInt32  subMeshesOffset;
+	TUInt32  nodeBoundsOffset;    // numNodes SMeshFileBounds
+	TUInt32  subMeshBoundsOffset; // numSubMeshes SMeshFileBounds
+	TUInt32  stringsOffset;
+	TUInt32  stringsSize;
+
+	TFloat32 minBounds[3];   // Bounds as calculated by CMesh::PreProcess
+	TFloat32 maxBounds[3];
+	TFloat32 boundingRadius;
+
+	TUInt32  numLods;        // Levels of detail including the full detail level 0, see SimplifyMesh
+	TUInt32  reserved;       // Zero, keeps the header size a multiple of 8 bytes
+};
+
+// Bounds of a node or sub-mesh, see SMeshBounds
+struct SMeshFileBounds
+{
+	TFloat32 minBounds[3];
+	TFloat32 maxBounds[3];
+	TFloat32 centre[3];
+	TFloat32 radius;         // Negative if empty
+	TFloat32 originRadius;
+	TFloat32 boxCentre[3];
+	TFloat32 boxAxes[9];
+	TFloat32 boxExtents[3];
+};
+
+struct SMeshFileNode
+{
+	TUInt32  nameOffset;     // Offset into string table
+	TUInt32  depth;
+	TUInt32  parent;
+	TUInt32  numChildren;
+	TFloat32 positionMatrix[16];
+	TFloat32 invMeshOffset[16];
+};
+
+struct SMeshFileMaterial
+{
+	TUInt32  renderMethod;   // ERenderMethod
+	TFloat32 diffuseColour[4];
+	TFloat32 specularColour[4];
+	TFloat32 specularPower;
+	TUInt32  numTextures;
+	TUInt32  textureNameOffsets[kiMaxTextures]; // Offsets into string table
+};
+
+// Components present in each vertex of a sub-mesh (vertex coordinate always present), and whether
+// its faces use 32-bit indices
+enum EMeshFileVertexFlags
+{
+	kMeshFileSkinning       = 1 << 0,
+	kMeshFileNormals        = 1 << 1,
+	kMeshFileTangents       = 1 << 2,
+	kMeshFileTextureCoords  = 1 << 3,
+	kMeshFileVertexColours  = 1 << 4,
+	kMeshFileLargeFaces     = 1 << 5,
+};
+
+struct SMeshFileSubMesh
+{
+	TUInt32  node;
+	TUInt32  material;
+	TUInt32  numVertices;
+	TUInt32  vertexSize;
+	TUInt32  vertexFlags;    // Combination of EMeshFileVertexFlags
+	TUInt32  numFaces;
+	TUInt32  verticesOffset; // numVertices * vertexSize bytes
+	TUInt32  facesOffset;    // numFaces SMeshFace (or SMeshLargeFace) structures
+
+	// Simplified levels of detail 1 and above (the first numLods - 1 entries are used). Their faces
+	// are stored in the same form as the full faces, see SSubMeshLod for the errors
+	TUInt32  lodNumFaces[kiMaxMeshLods - 1];
+	TUInt32  lodFacesOffset[kiMaxMeshLods - 1];
+	TFloat32 lodErrors[kiMaxMeshLods - 1];
+};
+
+
+/////////////////////////////////////
+// Mesh file reader
+
+// Reads a cooked mesh file through a read-only memory mapping. Provides the same data access as
+// CImportXFile, so CMesh can be created from either. Sub-meshes returned point into the mapping,
+// so the file must stay open while they are in use
+class CMeshFile
+{
+public:
+	/////////////////////////////////////
+	// Constructors/Destructors
+
+	CMeshFile();
+	~CMeshFile();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CMeshFile( const CMeshFile& );
+	CMeshFile& operator=( const CMeshFile& );
+
+
+public:
+	/////////////////////////////////////
+	// Opening / closing
+
+	// Name of the cooked file for the given X-File (same name with a .mesh extension)
+	static string CookedFileName( const string& sourceFileName );
+
+	// Open the cooked file for the given mesh file (relative to the media folder). Fails if there
+	// is no cooked file, or if the X-File is present and has changed since it was cooked
+	bool OpenForMesh( const string& meshFileName );
+
+	// Map the given cooked file and check its contents are valid. Returns false on failure
+	bool Open( const string& fileName );
+
+	// Unmap the file - any sub-mesh data returned is no longer valid
+	void Close();
+
+	bool IsOpen() const
+	{
+		return m_Data != 0;
+	}
+
+
+	/////////////////////////////////////
+	// Data access - see CImportXFile
+
+	TUInt32 GetNumNodes() const
+	{
+		return Header()->numNodes;
+	}
+	void GetNode( const TUInt32 iNode, SMeshNode* const pNode ) const;
+
+	TUInt32 GetNumSubMeshes() const
+	{
+		return Header()->numSubMeshes;
+	}
+	ERenderMethod GetSubMeshRenderMethod( const TUInt32 iSubMesh ) const;
+
+	// Vertex and face pointers refer directly to the file data. Tangents are included when the
+	// file is cooked if the sub-mesh's render method needs them, so the last parameter is ignored
+	EImportError GetSubMesh( const TUInt32 iSubMesh, SSubMesh* pSubMesh, bool bTangents = false ) const;
+
+	TUInt32 GetNumMaterials() const
+	{
+		return Header()->numMaterials;
+	}
+	void GetMaterial( const TUInt32 iMaterial, SMeshMaterial* const pMaterial ) const;
+
+	// Levels of detail made when the file was cooked, including the full detail level 0
+	TUInt32 GetNumLods() const
+	{
+		return Header()->numLods;
+	}
+
+	// Get a simplified level of detail (1 and above) of a sub-mesh. Its faces are copied out as
+	// 32-bit indices
+	void GetSubMeshLod( const TUInt32 iSubMesh, const TUInt32 lod, SSubMeshLod* pLod ) const;
+
+
+	// Stamp of the X-File this was cooked from
+	TUInt64 SourceSize() const
+	{
+		return Header()->sourceSize;
+	}
+	TUInt64 SourceTime() const
+	{
+		return Header()->sourceTime;
+	}
+
+	// Precalculated bounds
+	CVector3 MinBounds() const
+	{
+		return CVector3( Header()->minBounds );
+	}
+	CVector3 MaxBounds() const
+	{
+		return CVector3( Header()->maxBounds );
+	}
+	TFloat32 BoundingRadius() const
+	{
+		return Header()->boundingRadius;
+	}
+
+	// Precalculated bounds of each node and sub-mesh
+	void GetNodeBounds( const TUInt32 iNode, SMeshBounds* pBounds ) const;
+	void GetSubMeshBounds( const TUInt32 iSubMesh, SMeshBounds* pBounds ) const;
+
+
+	/////////////////////////////////////
+	// Writing
+
+	// Write a cooked mesh file from imported mesh data. Sub-meshes must be in their final form
+	// (tangents calculated where needed), with their levels of detail laid out as by SimplifyMesh.
+	// Returns false on failure
+	static bool Write
+	(
+		const string&                fileName,
+		TUInt64                      sourceSize,
+		TUInt64                      sourceTime,
+		const vector<SMeshNode>&     nodes,
+		const vector<SMeshMaterial>& materials,
+		const vector<SSubMesh>&      subMeshes,
+		const vector<SMeshBounds>&   nodeBounds,
+		const vector<SMeshBounds>&   subMeshBounds,
+		const SMeshBounds&           meshBounds,
+		TUInt32                      numLods,
+		const vector<SSubMeshLod>&   subMeshLods
+	);
+
+
+private:
+	/////////////////////////////////////
+	// Support functions
+
+	const SMeshFileHeader* Header() const
+	{
+		return reinterpret_cast<const SMeshFileHeader*>(m_Data);
+	}
+
+	const char* String( TUInt32 offset ) const
+	{
+		return reinterpret_cast<const char*>(m_Data + Header()->stringsOffset + offset);
+	}
+
+	// Check all counts, offsets, strings and face indices in the file lie within it, that vertex
+	// sizes match their components and that nodes are in parent-before-child order
+	bool Validate() const;
+
+
+	/////////////////////////////////////
+	// Data
+
+	CMappedFile   m_File;
+	const TUInt8* m_Data; // Start of mapped file, 0 if not open
+	TUInt32       m_Size;
+};
+
+
+} // namespace gen
@@ -0,0 +1,68 @@
+/*******************************************
+	MeshHandle.cpp
+
+	Mesh handle implementation
+********************************************/
+
+#include "MeshHandle.h"
+#include "AssetCache.h"
+
+namespace gen
+{
+
+// Load the mesh geometry if it hasn't been already (requires a device). Returns false if the
+// mesh fails to load - a message is shown the first time only
+bool CMeshHandle::Load()
+{
+	if (m_Mesh)
+	{
+		return true;
+	}
+	if (m_LoadFailed)
+	{
+		return false;
+	}
+
+	if (!Import() || !m_ImportedMesh->CreateResources( m_Cache ))
+	{
+		delete m_ImportedMesh;
+		m_ImportedMesh = 0;
+		m_LoadFailed = true;
+		string errorMsg = "Error loading mesh " + m_FileName;
+		SystemMessageBox( errorMsg.c_str(), "Mesh Error" );
+		return false;
+	}
+	m_Mesh = m_ImportedMesh;
+	m_ImportedMesh = 0;
+	if (m_Cache)
+	{
+		m_Cache->MeshLoaded( this );
+	}
+	return true;
+}
+
+// Do the device-free first stage of Load, importing the mesh file (see CMesh::Import). May be
+// called on any thread, but only one thread per handle. Returns false if the import fails
+bool CMeshHandle::Import( CThreadPool* pool /*= 0*/ )
+{
+	if (m_Mesh || m_ImportedMesh)
+	{
+		return true;
+	}
+	if (m_LoadFailed)
+	{
+		return false;
+	}
+
+	CMesh* mesh = new CMesh();
+	if (!mesh->Import( m_FileName, pool ))
+	{
+		delete mesh;
+		return false;
+	}
+	m_ImportedMesh = mesh;
+	return true;
+}
+
+
+} // namespace gen
@@ -0,0 +1,127 @@
+/*******************************************
+	MeshHandle.h
+
+	Reference to a mesh file that loads the
+	mesh geometry only when it is first used.
+	The mesh layout (nodes and bounds) is
+	available without loading the mesh.
+	Handles are shared between users of the
+	same mesh, see AssetCache.h
+********************************************/
+
+#pragma once
+
+#include <string>
+using namespace std;
+
+#include "../Common/Defines.h"
+#include "Mesh.h"
+#include "MeshLayout.h"
+
+namespace gen
+{
+
+class CAssetCache;
+
+class CMeshHandle
+{
+public:
+	/////////////////////////////////////
+	// Constructors/Destructors
+
+	// Refer to the given mesh file (relative to the media folder) - nothing is loaded yet. If a
+	// cache is given, it supplies the mesh's textures and is told when the mesh is loaded
+	CMeshHandle( const string& fileName, CAssetCache* cache = 0 )
+	{
+		m_FileName = fileName;
+		m_Cache = cache;
+		m_Mesh = 0;
+		m_ImportedMesh = 0;
+		m_LoadFailed = false;
+		m_RefCount = 0;
+		m_ContentHash = 0;
+		m_HasContentHash = false;
+	}
+
+	~CMeshHandle()
+	{
+		delete m_Mesh;
+		delete m_ImportedMesh;
+	}
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CMeshHandle( const CMeshHandle& );
+	CMeshHandle& operator=( const CMeshHandle& );
+
+
+public:
+	/////////////////////////////////////
+	// Loading
+
+	// Get the mesh layout, from the layout file beside the mesh if it is up to date. Must be
+	// called before using Layout. Returns false if the mesh file could not be read
+	bool LoadLayout()
+	{
+		return m_Layout.Prepare( m_FileName );
+	}
+
+	// Load the mesh geometry if it hasn't been already (requires a device). Returns false if the
+	// mesh fails to load - a message is shown the first time only
+	bool Load();
+
+	// Do the device-free first stage of Load, importing the mesh file (see CMesh::Import). May be
+	// called on any thread, but only one thread per handle. Load completes the mesh. Returns false
+	// if the import fails, in which case Load will try again and report the failure. The mesh is
+	// processed on the given thread pool if there is one - then it must not be called from a job
+	// on the same pool
+	bool Import( CThreadPool* pool = 0 );
+
+
+	/////////////////////////////////////
+	// Access
+
+	const string& FileName()
+	{
+		return m_FileName;
+	}
+
+	const CMeshLayout& Layout()
+	{
+		return m_Layout;
+	}
+
+	bool IsLoaded()
+	{
+		return m_Mesh != 0;
+	}
+
+	// Return the mesh, loading it on first use. Returns 0 if the mesh could not be loaded
+	CMesh* Get()
+	{
+		if (!m_Mesh)
+		{
+			Load();
+		}
+		return m_Mesh;
+	}
+
+
+private:
+	// The asset cache counts references to the handle and identifies it by content
+	friend class CAssetCache;
+
+	string       m_FileName;
+	CAssetCache* m_Cache;
+	CMeshLayout  m_Layout;
+	CMesh*       m_Mesh;           // 0 until loaded
+	CMesh*       m_ImportedMesh;   // Mesh imported but not yet loaded, see Import
+	bool         m_LoadFailed;     // Don't retry (or report again) a mesh that failed to load
+
+	TUInt32      m_RefCount;
+	TUInt64      m_ContentHash;
+	bool         m_HasContentHash;
+};
+
+
+} // namespace gen
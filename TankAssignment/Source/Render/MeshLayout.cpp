@@ -0,0 +1,288 @@
+/*******************************************
+	MeshLayout.cpp
+
+	Mesh layout implementation
+********************************************/
+
+#include <fstream>
+#include <iomanip>
+
+#include "MeshLayout.h"
+#include "CImportXFile.h"
+#include "MeshFile.h"
+#include "../Common/Utility.h"
+
+namespace gen
+{
+
+// Folder for all texture and mesh files
+extern const string MediaFolder;
+
+// Layout files are named after the mesh with this extension added, and begin with this
+// header. Change the version if the format changes so old files are rebuilt
+static const string LayoutExtension = ".layout";
+static const string LayoutHeader = "MeshLayout";
+static const TUInt32 LayoutVersion = 2;
+
+
+//-----------------------------------------------------------------------------
+// Construction
+//-----------------------------------------------------------------------------
+
+// Construct an empty layout (a single node at the origin with no size)
+CMeshLayout::CMeshLayout()
+{
+	SMeshNode root;
+	root.depth = 0;
+	root.parent = 0;
+	root.numChildren = 0;
+	root.positionMatrix = CMatrix4x4::kIdentity;
+	root.invMeshOffset = CMatrix4x4::kIdentity;
+	m_Nodes.push_back( root );
+
+	m_MinBounds = CVector3::kZero;
+	m_MaxBounds = CVector3::kZero;
+	m_BoundingRadius = 0.0f;
+	m_NodeBounds.resize( 1 );
+	ClearBounds( &m_NodeBounds[0] );
+}
+
+
+//-----------------------------------------------------------------------------
+// Creation
+//-----------------------------------------------------------------------------
+
+// Get the layout for the given mesh file (relative to the media folder). Uses the cooked mesh file
+// or the layout file beside the mesh if either is up to date, otherwise imports the mesh and
+// writes a new layout file
+bool CMeshLayout::Prepare( const string& meshFileName )
+{
+	if (LoadCooked( meshFileName ) || Load( meshFileName ))
+	{
+		return true;
+	}
+	if (!Import( meshFileName ))
+	{
+		return false;
+	}
+	Save( meshFileName ); // Not an error if this fails (e.g. read-only media), just slower next time
+	return true;
+}
+
+
+// Import the layout from the given X-File - no DirectX resources are created
+bool CMeshLayout::Import( const string& meshFileName )
+{
+	CImportXFile importFile;
+	string fullFileName = MediaFolder + meshFileName;
+	if (!importFile.IsXFile( fullFileName ) || importFile.ImportFile( fullFileName ) != kSuccess)
+	{
+		return false;
+	}
+
+	TUInt32 numNodes = importFile.GetNumNodes();
+	TUInt32 numSubMeshes = importFile.GetNumSubMeshes();
+	if (numNodes == 0 || numSubMeshes == 0)
+	{
+		return false;
+	}
+	m_Nodes.resize( numNodes );
+	for (TUInt32 node = 0; node < numNodes; ++node)
+	{
+		importFile.GetNode( node, &m_Nodes[node] );
+	}
+
+	// Bounds calculated in the same way as CMesh::PreProcess
+	vector<SSubMesh> subMeshes( numSubMeshes );
+	bool importOK = true;
+	for (TUInt32 subMesh = 0; subMesh < numSubMeshes && importOK; ++subMesh)
+	{
+		importOK = (importFile.GetSubMesh( subMesh, &subMeshes[subMesh], false, false ) == kSuccess);
+	}
+	vector<SMeshBounds> subMeshBounds( numSubMeshes );
+	m_NodeBounds.resize( numNodes );
+	SMeshBounds meshBounds;
+	if (importOK)
+	{
+		importOK = CalculateMeshBounds( &subMeshes[0], numSubMeshes, numNodes, &subMeshBounds[0], &m_NodeBounds[0],
+		                                &meshBounds );
+		m_MinBounds = meshBounds.minBounds;
+		m_MaxBounds = meshBounds.maxBounds;
+		m_BoundingRadius = meshBounds.originRadius;
+	}
+
+	for (TUInt32 subMesh = 0; subMesh < numSubMeshes; ++subMesh)
+	{
+		delete[] subMeshes[subMesh].vertices;
+		delete[] subMeshes[subMesh].faces;
+		delete[] subMeshes[subMesh].largeFaces;
+	}
+	return importOK;
+}
+
+
+// Get the layout from the cooked version of the given mesh file (see MeshFile.h). Only the header
+// and nodes are read from the mapping. Fails if there is no up to date cooked file
+bool CMeshLayout::LoadCooked( const string& meshFileName )
+{
+	CMeshFile meshFile;
+	if (!meshFile.OpenForMesh( meshFileName ))
+	{
+		return false;
+	}
+
+	m_Nodes.resize( meshFile.GetNumNodes() );
+	for (TUInt32 node = 0; node < meshFile.GetNumNodes(); ++node)
+	{
+		meshFile.GetNode( node, &m_Nodes[node] );
+	}
+	m_MinBounds = meshFile.MinBounds();
+	m_MaxBounds = meshFile.MaxBounds();
+	m_BoundingRadius = meshFile.BoundingRadius();
+	m_NodeBounds.resize( meshFile.GetNumNodes() );
+	for (TUInt32 node = 0; node < meshFile.GetNumNodes(); ++node)
+	{
+		meshFile.GetNodeBounds( node, &m_NodeBounds[node] );
+	}
+	return true;
+}
+
+// Read the layout file for the given mesh file. Fails if there is no layout file or the mesh has
+// changed since it was written
+bool CMeshLayout::Load( const string& meshFileName )
+{
+	TUInt64 sourceSize, sourceTime;
+	if (!GetFileStamp( MediaFolder + meshFileName, &sourceSize, &sourceTime ))
+	{
+		return false;
+	}
+
+	ifstream file( LayoutFileName( meshFileName ).c_str() );
+	string header;
+	TUInt32 version;
+	TUInt64 fileSize, fileTime;
+	if (!(file >> header >> version >> fileSize >> fileTime) || header != LayoutHeader ||
+	    version != LayoutVersion || fileSize != sourceSize || fileTime != sourceTime)
+	{
+		return false;
+	}
+
+	TUInt32 numNodes;
+	file >> m_MinBounds.x >> m_MinBounds.y >> m_MinBounds.z
+	     >> m_MaxBounds.x >> m_MaxBounds.y >> m_MaxBounds.z >> m_BoundingRadius >> numNodes;
+	if (!file || numNodes == 0)
+	{
+		return false;
+	}
+
+	vector<SMeshNode> nodes( numNodes );
+	vector<SMeshBounds> nodeBounds( numNodes );
+	for (TUInt32 node = 0; node < numNodes; ++node)
+	{
+		// Node bounds on a line of their own
+		SMeshBounds& bounds = nodeBounds[node];
+		file >> bounds.minBounds.x >> bounds.minBounds.y >> bounds.minBounds.z
+		     >> bounds.maxBounds.x >> bounds.maxBounds.y >> bounds.maxBounds.z
+		     >> bounds.centre.x >> bounds.centre.y >> bounds.centre.z >> bounds.radius >> bounds.originRadius
+		     >> bounds.boxCentre.x >> bounds.boxCentre.y >> bounds.boxCentre.z;
+		for (TUInt32 axis = 0; axis < 3; ++axis)
+		{
+			file >> bounds.boxAxes[axis].x >> bounds.boxAxes[axis].y >> bounds.boxAxes[axis].z;
+		}
+		file >> bounds.boxExtents.x >> bounds.boxExtents.y >> bounds.boxExtents.z;
+
+		SMeshNode& meshNode = nodes[node];
+		file >> meshNode.parent >> meshNode.depth >> meshNode.numChildren;
+		TFloat32* position = &meshNode.positionMatrix.e00;
+		TFloat32* invOffset = &meshNode.invMeshOffset.e00;
+		for (TUInt32 element = 0; element < 16; ++element)
+		{
+			file >> position[element];
+		}
+		for (TUInt32 element = 0; element < 16; ++element)
+		{
+			file >> invOffset[element];
+		}
+
+		// Name is the rest of the line (may be empty)
+		getline( file, meshNode.name );
+		if (!meshNode.name.empty() && meshNode.name[0] == ' ')
+		{
+			meshNode.name.erase( 0, 1 );
+		}
+		if (!file || meshNode.parent >= numNodes)
+		{
+			return false;
+		}
+	}
+
+	m_Nodes.swap( nodes );
+	m_NodeBounds.swap( nodeBounds );
+	return true;
+}
+
+// Write the layout file for the given mesh file
+bool CMeshLayout::Save( const string& meshFileName )
+{
+	TUInt64 sourceSize, sourceTime;
+	if (!GetFileStamp( MediaFolder + meshFileName, &sourceSize, &sourceTime ))
+	{
+		return false;
+	}
+
+	ofstream file( LayoutFileName( meshFileName ).c_str() );
+	if (!file)
+	{
+		return false;
+	}
+
+	// Floats written with enough digits to read back exactly
+	file << setprecision( 9 );
+	file << LayoutHeader << ' ' << LayoutVersion << ' ' << sourceSize << ' ' << sourceTime << '\n';
+	file << m_MinBounds.x << ' ' << m_MinBounds.y << ' ' << m_MinBounds.z << ' '
+	     << m_MaxBounds.x << ' ' << m_MaxBounds.y << ' ' << m_MaxBounds.z << ' ' << m_BoundingRadius << '\n';
+	file << m_Nodes.size() << '\n';
+	for (TUInt32 node = 0; node < m_Nodes.size(); ++node)
+	{
+		const SMeshBounds& bounds = m_NodeBounds[node];
+		file << bounds.minBounds.x << ' ' << bounds.minBounds.y << ' ' << bounds.minBounds.z << ' '
+		     << bounds.maxBounds.x << ' ' << bounds.maxBounds.y << ' ' << bounds.maxBounds.z << ' '
+		     << bounds.centre.x << ' ' << bounds.centre.y << ' ' << bounds.centre.z << ' '
+		     << bounds.radius << ' ' << bounds.originRadius << ' '
+		     << bounds.boxCentre.x << ' ' << bounds.boxCentre.y << ' ' << bounds.boxCentre.z;
+		for (TUInt32 axis = 0; axis < 3; ++axis)
+		{
+			file << ' ' << bounds.boxAxes[axis].x << ' ' << bounds.boxAxes[axis].y << ' ' << bounds.boxAxes[axis].z;
+		}
+		file << ' ' << bounds.boxExtents.x << ' ' << bounds.boxExtents.y << ' ' << bounds.boxExtents.z << '\n';
+
+		const SMeshNode& meshNode = m_Nodes[node];
+		file << meshNode.parent << ' ' << meshNode.depth << ' ' << meshNode.numChildren;
+		const TFloat32* position = &meshNode.positionMatrix.e00;
+		const TFloat32* invOffset = &meshNode.invMeshOffset.e00;
+		for (TUInt32 element = 0; element < 16; ++element)
+		{
+			file << ' ' << position[element];
+		}
+		for (TUInt32 element = 0; element < 16; ++element)
+		{
+			file << ' ' << invOffset[element];
+		}
+		file << ' ' << meshNode.name << '\n';
+	}
+
+	return static_cast<bool>(file);
+}
+
+
+//-----------------------------------------------------------------------------
+// Support functions
+//-----------------------------------------------------------------------------
+
+string CMeshLayout::LayoutFileName( const string& meshFileName )
+{
+	return MediaFolder + meshFileName + LayoutExtension;
+}
+
+
+} // namespace gen
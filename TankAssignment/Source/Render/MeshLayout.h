@@ -0,0 +1,108 @@
+/*******************************************
+	MeshLayout.h
+
+	The node hierarchy and bounds of a mesh,
+	without any geometry. Enough for entities
+	to be created, updated and culled without
+	loading the mesh itself. Stored in a small
+	text file beside each mesh so it does not
+	need to be imported again
+********************************************/
+
+#pragma once
+
+#include <vector>
+#include <string>
+using namespace std;
+
+#include "../Common/Defines.h"
+#include "../Math/CVector3.h"
+#include "MeshData.h"
+#include "MeshBounds.h"
+
+namespace gen
+{
+
+class CMeshLayout
+{
+public:
+	/////////////////////////////////////
+	// Constructor
+
+	// Construct an empty layout (a single node at the origin with no size)
+	CMeshLayout();
+
+
+	/////////////////////////////////////
+	// Creation
+
+	// Get the layout for the given mesh file (relative to the media folder). Uses the cooked mesh
+	// file or the layout file beside the mesh if either is up to date, otherwise imports the mesh
+	// and writes a new layout file
+	bool Prepare( const string& meshFileName );
+
+	// Import the layout from the given X-File - no DirectX resources are created
+	bool Import( const string& meshFileName );
+
+	// Get the layout from the cooked version of the mesh file (see MeshFile.h). Fails if there is
+	// no up to date cooked file
+	bool LoadCooked( const string& meshFileName );
+
+	// Read / write the layout file for the given mesh file. Reading fails if there is no layout
+	// file or the mesh has changed since it was written
+	bool Load( const string& meshFileName );
+	bool Save( const string& meshFileName );
+
+
+	/////////////////////////////////////
+	// Access
+
+	TUInt32 GetNumNodes() const
+	{
+		return static_cast<TUInt32>(m_Nodes.size());
+	}
+
+	const SMeshNode& GetNode( TUInt32 node ) const
+	{
+		return m_Nodes[node];
+	}
+
+	// Get minimum and maximum bounds (axis-aligned)
+	const CVector3& MinBounds() const
+	{
+		return m_MinBounds;
+	}
+	const CVector3& MaxBounds() const
+	{
+		return m_MaxBounds;
+	}
+
+	// Get radius of bounding sphere (from (0,0,0) in model space)
+	TFloat32 BoundingRadius() const
+	{
+		return m_BoundingRadius;
+	}
+
+	// Bounds of the sub-meshes controlled by a node, in the node's model space (see MeshBounds.h)
+	const SMeshBounds& GetNodeBounds( TUInt32 node ) const
+	{
+		return m_NodeBounds[node];
+	}
+
+
+private:
+	// Name of the layout file for a mesh
+	static string LayoutFileName( const string& meshFileName );
+
+	// Hierarchy for mesh - depth-first list of nodes, see SMeshNode in MeshData.h
+	vector<SMeshNode> m_Nodes;
+
+	// Bounds as calculated by CMesh, for the whole mesh and each node
+	CVector3 m_MinBounds;
+	CVector3 m_MaxBounds;
+	TFloat32 m_BoundingRadius;
+	vector<SMeshBounds> m_NodeBounds;
+};
+
+
+} // namespace gen
@@ -0,0 +1,426 @@
+/*******************************************
+	MeshOptimiser.cpp
+
+	Mesh optimiser implementation
+********************************************/
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+#include "MeshOptimiser.h"
+#include "../Math/CVector3.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// Face ordering for the vertex cache
+//-----------------------------------------------------------------------------
+
+// Forsyth's method scores vertices by their position in a simulated LRU cache and by how many
+// faces still need them, then repeatedly adds the face whose vertices score highest. These are
+// the tuning values from the original description of the method
+static const TUInt32  kOptimiserCacheSize = 32;
+static const TFloat32 kCacheDecayPower = 1.5f;
+static const TFloat32 kLastFaceScore = 0.75f;
+static const TFloat32 kValenceBoostScale = 2.0f;
+static const TFloat32 kValenceBoostPower = 0.5f;
+
+// Score of a vertex at the given cache position (negative if not in the cache) that is used by
+// the given number of faces not yet added
+static TFloat32 VertexScore( TInt32 cachePosition, TUInt32 remainingFaces )
+{
+	if (remainingFaces == 0)
+	{
+		return -1.0f; // Vertex not needed again
+	}
+
+	TFloat32 score = 0.0f;
+	if (cachePosition >= 0)
+	{
+		// Vertices of the last face added score the same whatever their order, so the next face
+		// added is not biased towards one edge of it
+		if (cachePosition < 3)
+		{
+			score = kLastFaceScore;
+		}
+		else
+		{
+			TFloat32 scale = 1.0f / static_cast<TFloat32>(kOptimiserCacheSize - 3);
+			score = pow( 1.0f - (cachePosition - 3) * scale, kCacheDecayPower );
+		}
+	}
+
+	// Boost vertices with few faces left, to finish them off rather than leave lone faces behind
+	score += kValenceBoostScale * pow( static_cast<TFloat32>(remainingFaces), -kValenceBoostPower );
+	return score;
+}
+
+// Reorder a triangle list for vertex cache reuse
+static void OptimiseFaceOrder( vector<TUInt32>& indices, TUInt32 numVertices )
+{
+	TUInt32 numFaces = static_cast<TUInt32>(indices.size() / 3);
+	if (numFaces < 2)
+	{
+		return;
+	}
+
+	// Faces using each vertex, as one list with a start offset for each vertex. The faces not yet
+	// added are kept at the start of each vertex's part of the list
+	vector<TUInt32> remainingFaces( numVertices, 0 );
+	for (TUInt32 index = 0; index < indices.size(); ++index)
+	{
+		++remainingFaces[indices[index]];
+	}
+	vector<TUInt32> facesStart( numVertices + 1, 0 );
+	for (TUInt32 vertex = 0; vertex < numVertices; ++vertex)
+	{
+		facesStart[vertex + 1] = facesStart[vertex] + remainingFaces[vertex];
+	}
+	vector<TUInt32> vertexFaces( indices.size() );
+	vector<TUInt32> fill( facesStart.begin(), facesStart.end() - 1 );
+	for (TUInt32 index = 0; index < indices.size(); ++index)
+	{
+		vertexFaces[fill[indices[index]]++] = index / 3;
+	}
+
+	// Initial scores
+	vector<TInt32> cachePosition( numVertices, -1 );
+	vector<TFloat32> vertexScore( numVertices );
+	for (TUInt32 vertex = 0; vertex < numVertices; ++vertex)
+	{
+		vertexScore[vertex] = VertexScore( -1, remainingFaces[vertex] );
+	}
+	vector<TFloat32> faceScore( numFaces );
+	vector<bool> faceAdded( numFaces, false );
+	TInt32 bestFace = 0;
+	for (TUInt32 face = 0; face < numFaces; ++face)
+	{
+		faceScore[face] = vertexScore[indices[face * 3]] + vertexScore[indices[face * 3 + 1]] +
+		                  vertexScore[indices[face * 3 + 2]];
+		if (faceScore[face] > faceScore[bestFace])
+		{
+			bestFace = face;
+		}
+	}
+
+	vector<TUInt32> newIndices;
+	newIndices.reserve( indices.size() );
+	vector<TUInt32> cache, newCache;
+	cache.reserve( kOptimiserCacheSize + 3 );
+	newCache.reserve( kOptimiserCacheSize + 3 );
+	TUInt32 nextFace = 0; // Where to look for a face when there is no good candidate near the cache
+
+	for (TUInt32 numAdded = 0; numAdded < numFaces; ++numAdded)
+	{
+		// At a dead end (no face uses a cached vertex), continue with the next face in the original order
+		if (bestFace < 0)
+		{
+			while (faceAdded[nextFace])
+			{
+				++nextFace;
+			}
+			bestFace = nextFace;
+		}
+
+		// Add the face, removing it from the faces left for each of its vertices
+		faceAdded[bestFace] = true;
+		newCache.clear();
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			TUInt32 vertex = indices[bestFace * 3 + corner];
+			newIndices.push_back( vertex );
+
+			TUInt32* faces = &vertexFaces[facesStart[vertex]];
+			TUInt32 last = --remainingFaces[vertex];
+			for (TUInt32 face = 0; face <= last; ++face)
+			{
+				if (faces[face] == static_cast<TUInt32>(bestFace))
+				{
+					swap( faces[face], faces[last] );
+					break;
+				}
+			}
+
+			if (find( newCache.begin(), newCache.end(), vertex ) == newCache.end())
+			{
+				newCache.push_back( vertex );
+			}
+		}
+
+		// The face's vertices move to the front of the cache. Vertices pushed off the end are kept
+		// in the list for now so their scores get updated
+		for (TUInt32 entry = 0; entry < cache.size(); ++entry)
+		{
+			if (find( newCache.begin(), newCache.end(), cache[entry] ) == newCache.end())
+			{
+				newCache.push_back( cache[entry] );
+			}
+		}
+
+		// Rescore vertices whose cache position has changed, then the faces still using them
+		for (TUInt32 entry = 0; entry < newCache.size(); ++entry)
+		{
+			TUInt32 vertex = newCache[entry];
+			cachePosition[vertex] = (entry < kOptimiserCacheSize) ? static_cast<TInt32>(entry) : -1;
+			vertexScore[vertex] = VertexScore( cachePosition[vertex], remainingFaces[vertex] );
+		}
+		bestFace = -1;
+		TFloat32 bestScore = 0.0f;
+		for (TUInt32 entry = 0; entry < newCache.size(); ++entry)
+		{
+			TUInt32 vertex = newCache[entry];
+			const TUInt32* faces = &vertexFaces[facesStart[vertex]];
+			for (TUInt32 face = 0; face < remainingFaces[vertex]; ++face)
+			{
+				TUInt32 f = faces[face];
+				faceScore[f] = vertexScore[indices[f * 3]] + vertexScore[indices[f * 3 + 1]] +
+				               vertexScore[indices[f * 3 + 2]];
+				if (faceScore[f] > bestScore)
+				{
+					bestFace = f;
+					bestScore = faceScore[f];
+				}
+			}
+		}
+
+		if (newCache.size() > kOptimiserCacheSize)
+		{
+			newCache.resize( kOptimiserCacheSize );
+		}
+		cache.swap( newCache );
+	}
+
+	indices.swap( newIndices );
+}
+
+
+//-----------------------------------------------------------------------------
+// Cluster ordering for overdraw
+//-----------------------------------------------------------------------------
+
+// Position of a vertex in a sub-mesh, found from the sub-mesh's vertex layout
+static CVector3 VertexPosition( const SSubMesh& subMesh, TUInt32 vertex )
+{
+	const TUInt8* vertexData = subMesh.vertices + vertex * subMesh.vertexSize;
+	return CVector3( reinterpret_cast<const TFloat32*>(vertexData + GetVertexLayout( subMesh ).position) );
+}
+
+// A run of faces that is drawn together, and its sort key
+struct SFaceCluster
+{
+	TUInt32  start;
+	TUInt32  end;
+	TFloat32 outwardness;
+
+	// Sort most outward-facing clusters first
+	bool operator<( const SFaceCluster& other ) const
+	{
+		return outwardness > other.outwardness;
+	}
+};
+
+// Split a cache-ordered triangle list into clusters at the points where the vertex cache starts
+// again (all of a face's vertices miss), so reordering the clusters barely affects cache reuse.
+// Then sort the clusters so those facing out from the centre of the mesh draw first - they are
+// more likely to be in front and hide the rest, reducing overdraw
+static void OrderClustersForOverdraw( vector<TUInt32>& indices, const SSubMesh& subMesh )
+{
+	TUInt32 numFaces = static_cast<TUInt32>(indices.size() / 3);
+
+	// Find cluster boundaries with a simulated FIFO cache - a vertex is in the cache if fewer than
+	// the cache size vertices have been added since it was
+	vector<SFaceCluster> clusters;
+	vector<TUInt32> cacheTime( subMesh.numVertices, 0 );
+	TUInt32 time = kiVertexCacheSize;
+	for (TUInt32 face = 0; face < numFaces; ++face)
+	{
+		TUInt32 misses = 0;
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			TUInt32 vertex = indices[face * 3 + corner];
+			if (time - cacheTime[vertex] >= kiVertexCacheSize)
+			{
+				cacheTime[vertex] = time++;
+				++misses;
+			}
+		}
+		if (face == 0 || misses == 3)
+		{
+			if (!clusters.empty())
+			{
+				clusters.back().end = face;
+			}
+			SFaceCluster cluster = { face, numFaces, 0.0f };
+			clusters.push_back( cluster );
+		}
+	}
+	if (clusters.size() < 2)
+	{
+		return;
+	}
+
+	// Area-weighted centre of each cluster and of the whole mesh, and the average normal of each
+	// cluster (the cross product of two edges has length twice the face area)
+	vector<CVector3> clusterCentres( clusters.size(), CVector3::kOrigin );
+	vector<CVector3> clusterNormals( clusters.size(), CVector3::kOrigin );
+	vector<TFloat32> clusterAreas( clusters.size(), 0.0f );
+	CVector3 meshCentre = CVector3::kOrigin;
+	TFloat32 meshArea = 0.0f;
+	for (TUInt32 cluster = 0; cluster < clusters.size(); ++cluster)
+	{
+		for (TUInt32 face = clusters[cluster].start; face < clusters[cluster].end; ++face)
+		{
+			CVector3 v0 = VertexPosition( subMesh, indices[face * 3] );
+			CVector3 v1 = VertexPosition( subMesh, indices[face * 3 + 1] );
+			CVector3 v2 = VertexPosition( subMesh, indices[face * 3 + 2] );
+			CVector3 normal = Cross( v1 - v0, v2 - v0 );
+			TFloat32 area = normal.Length();
+			clusterCentres[cluster] += (v0 + v1 + v2) * (area / 3.0f);
+			clusterNormals[cluster] += normal;
+			clusterAreas[cluster] += area;
+		}
+		meshCentre += clusterCentres[cluster];
+		meshArea += clusterAreas[cluster];
+	}
+	if (meshArea <= 0.0f)
+	{
+		return; // All faces degenerate
+	}
+	meshCentre /= meshArea;
+
+	for (TUInt32 cluster = 0; cluster < clusters.size(); ++cluster)
+	{
+		TFloat32 normalLength = clusterNormals[cluster].Length();
+		if (clusterAreas[cluster] > 0.0f && normalLength > 0.0f)
+		{
+			CVector3 centre = clusterCentres[cluster] / clusterAreas[cluster];
+			clusters[cluster].outwardness = Dot( centre - meshCentre, clusterNormals[cluster] ) / normalLength;
+		}
+	}
+
+	// Rebuild the list in cluster order, keeping the original order for equal clusters
+	stable_sort( clusters.begin(), clusters.end() );
+	vector<TUInt32> newIndices;
+	newIndices.reserve( indices.size() );
+	for (TUInt32 cluster = 0; cluster < clusters.size(); ++cluster)
+	{
+		newIndices.insert( newIndices.end(), indices.begin() + clusters[cluster].start * 3,
+		                   indices.begin() + clusters[cluster].end * 3 );
+	}
+	indices.swap( newIndices );
+}
+
+
+//-----------------------------------------------------------------------------
+// Vertex ordering for fetch
+//-----------------------------------------------------------------------------
+
+// Renumber the vertices of a sub-mesh in the order the triangle list first uses them, moving the
+// vertex data to match. Any unused vertices are moved to the end
+static void OptimiseVertexOrder( vector<TUInt32>& indices, SSubMesh* subMesh )
+{
+	const TUInt32 kUnused = ~0u;
+	vector<TUInt32> newVertex( subMesh->numVertices, kUnused );
+	TUInt32 nextVertex = 0;
+	for (TUInt32 index = 0; index < indices.size(); ++index)
+	{
+		TUInt32& vertex = newVertex[indices[index]];
+		if (vertex == kUnused)
+		{
+			vertex = nextVertex++;
+		}
+		indices[index] = vertex;
+	}
+	for (TUInt32 vertex = 0; vertex < subMesh->numVertices; ++vertex)
+	{
+		if (newVertex[vertex] == kUnused)
+		{
+			newVertex[vertex] = nextVertex++;
+		}
+	}
+
+	TUInt32 vertexSize = subMesh->vertexSize;
+	TUInt8* vertices = new TUInt8[subMesh->numVertices * vertexSize];
+	for (TUInt32 vertex = 0; vertex < subMesh->numVertices; ++vertex)
+	{
+		memcpy( vertices + newVertex[vertex] * vertexSize, subMesh->vertices + vertex * vertexSize, vertexSize );
+	}
+	delete[] subMesh->vertices;
+	subMesh->vertices = vertices;
+}
+
+
+//-----------------------------------------------------------------------------
+// Public functions
+//-----------------------------------------------------------------------------
+
+// Reorder the faces and vertices of a sub-mesh for rendering: for vertex cache reuse, then to
+// reduce overdraw, then for vertex fetch. The sub-mesh must own its data
+void OptimiseSubMesh( SSubMesh* subMesh )
+{
+	if (subMesh->numFaces == 0)
+	{
+		return;
+	}
+
+	// Work on a plain index list whatever the face type
+	vector<TUInt32> indices( subMesh->numFaces * 3 );
+	for (TUInt32 face = 0; face < subMesh->numFaces; ++face)
+	{
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			indices[face * 3 + corner] = GetFaceVertex( *subMesh, face, corner );
+		}
+	}
+
+	OptimiseFaceOrder( indices, subMesh->numVertices );
+	OrderClustersForOverdraw( indices, *subMesh );
+	OptimiseVertexOrder( indices, subMesh );
+
+	for (TUInt32 face = 0; face < subMesh->numFaces; ++face)
+	{
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			TUInt32 vertex = indices[face * 3 + corner];
+			if (subMesh->largeFaces) subMesh->largeFaces[face].aiVertex[corner] = vertex;
+			else                     subMesh->faces[face].aiVertex[corner] = static_cast<TUInt16>(vertex);
+		}
+	}
+}
+
+// Measure the post-transform vertex cache efficiency of a sub-mesh with a simulated FIFO cache of
+// the given size
+SVertexCacheStats AnalyseVertexCache( const SSubMesh& subMesh, TUInt32 cacheSize /*= kiVertexCacheSize*/ )
+{
+	SVertexCacheStats stats;
+	stats.numFaces = subMesh.numFaces;
+	stats.numVertices = subMesh.numVertices;
+	stats.cacheMisses = 0;
+
+	// A vertex is in the cache if fewer than the cache size vertices have been added since it was
+	vector<TUInt32> cacheTime( subMesh.numVertices, 0 );
+	TUInt32 time = cacheSize;
+	for (TUInt32 face = 0; face < subMesh.numFaces; ++face)
+	{
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			TUInt32 vertex = GetFaceVertex( subMesh, face, corner );
+			if (time - cacheTime[vertex] >= cacheSize)
+			{
+				cacheTime[vertex] = time++;
+				++stats.cacheMisses;
+			}
+		}
+	}
+
+	stats.acmr = (stats.numFaces > 0) ? stats.cacheMisses / static_cast<TFloat32>(stats.numFaces) : 0.0f;
+	stats.atvr = (stats.numVertices > 0) ? stats.cacheMisses / static_cast<TFloat32>(stats.numVertices) : 0.0f;
+	return stats;
+}
+
+
+} // namespace gen
@@ -0,0 +1,51 @@
+/*******************************************
+	MeshOptimiser.h
+
+	Import-time reordering of sub-mesh faces
+	and vertices for the GPU: faces for reuse
+	of the post-transform vertex cache, then
+	in clusters to reduce overdraw, then the
+	vertices in the order the faces use them.
+	Also measures vertex cache efficiency
+********************************************/
+
+#pragma once
+
+#include "../Common/Defines.h"
+#include "MeshData.h"
+
+namespace gen
+{
+
+// Size of FIFO vertex cache assumed when measuring a sub-mesh - a typical hardware size
+const TUInt32 kiVertexCacheSize = 16;
+
+// Post-transform vertex cache efficiency of a sub-mesh, measured with a simulated FIFO cache
+struct SVertexCacheStats
+{
+	TUInt32  numFaces;
+	TUInt32  numVertices;
+	TUInt32  cacheMisses; // Vertices transformed to draw the sub-mesh
+
+	// Average cache miss ratio - vertices transformed per triangle. 3 at worst, approaching 0.5
+	// for a large regular grid
+	TFloat32 acmr;
+
+	// Average transform to vertex ratio - vertices transformed per vertex. 1 is ideal
+	TFloat32 atvr;
+};
+
+
+// Reorder the faces and vertices of a sub-mesh for rendering. Faces are first ordered for vertex
+// cache reuse (Forsyth's linear-speed method), then split into clusters where the cache restarts,
+// and the clusters sorted so outward-facing ones draw first, which reduces overdraw. Finally the
+// vertices are ordered by first use so vertex fetches move through memory in order. The geometry
+// is unchanged. The sub-mesh must own its data (i.e. be imported, not read from a cooked file)
+void OptimiseSubMesh( SSubMesh* subMesh );
+
+// Measure the post-transform vertex cache efficiency of a sub-mesh with a simulated FIFO cache of
+// the given size
+SVertexCacheStats AnalyseVertexCache( const SSubMesh& subMesh, TUInt32 cacheSize = kiVertexCacheSize );
+
+
+} // namespace gen
@@ -0,0 +1,567 @@
+/*******************************************
+	MeshSimplifier.cpp
+
+	Mesh simplifier implementation
+********************************************/
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <functional>
+using namespace std;
+
+#include "MeshSimplifier.h"
+#include "../Math/CVector3.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// Quadrics
+//-----------------------------------------------------------------------------
+
+// Weight of the planes added along open edges and seams, which hold them in place. The surface
+// planes each count 1
+static const TFloat64 kBorderWeight = 10.0;
+
+// A quadric measures the sum of squared distances of a point from a set of planes. For a plane
+// n.p + d = 0 the quadric is the symmetric matrix [nn^T n*d; n*d^T d*d], stored as its 10 unique
+// values. Sums of quadrics measure distance from all the planes of both
+struct SQuadric
+{
+	TFloat64 a00, a01, a02, a11, a12, a22; // nn^T
+	TFloat64 b0, b1, b2;                   // n*d
+	TFloat64 c;                            // d*d
+};
+
+// Add the plane with the given unit normal through the given point, with the given weight
+static void AddPlane( SQuadric* q, const CVector3& normal, const CVector3& point, TFloat64 weight )
+{
+	TFloat64 nx = normal.x, ny = normal.y, nz = normal.z;
+	TFloat64 d = -(nx * point.x + ny * point.y + nz * point.z);
+	q->a00 += weight * nx * nx;  q->a01 += weight * nx * ny;  q->a02 += weight * nx * nz;
+	q->a11 += weight * ny * ny;  q->a12 += weight * ny * nz;  q->a22 += weight * nz * nz;
+	q->b0 += weight * nx * d;    q->b1 += weight * ny * d;    q->b2 += weight * nz * d;
+	q->c += weight * d * d;
+}
+
+static void AddQuadric( SQuadric* q, const SQuadric& other )
+{
+	q->a00 += other.a00;  q->a01 += other.a01;  q->a02 += other.a02;
+	q->a11 += other.a11;  q->a12 += other.a12;  q->a22 += other.a22;
+	q->b0 += other.b0;    q->b1 += other.b1;    q->b2 += other.b2;
+	q->c += other.c;
+}
+
+// Sum of squared distances of a point from the planes of the sum of two quadrics
+static TFloat64 QuadricError( const SQuadric& q1, const SQuadric& q2, const CVector3& p )
+{
+	TFloat64 x = p.x, y = p.y, z = p.z;
+	TFloat64 error = (q1.a00 + q2.a00) * x * x + (q1.a11 + q2.a11) * y * y + (q1.a22 + q2.a22) * z * z +
+	                 2.0 * ((q1.a01 + q2.a01) * x * y + (q1.a02 + q2.a02) * x * z + (q1.a12 + q2.a12) * y * z) +
+	                 2.0 * ((q1.b0 + q2.b0) * x + (q1.b1 + q2.b1) * y + (q1.b2 + q2.b2) * z) + q1.c + q2.c;
+	return error > 0.0 ? error : 0.0; // Can be slightly negative from rounding
+}
+
+
+//-----------------------------------------------------------------------------
+// Simplification state
+//-----------------------------------------------------------------------------
+
+// Collapse of all vertices at one position onto the vertices at a neighbouring position
+struct SCollapse
+{
+	TFloat64 cost;
+	TUInt32  from, to;               // Positions
+	TUInt32  fromVersion, toVersion; // Versions of the positions when the cost was found
+
+	bool operator>( const SCollapse& other ) const
+	{
+		return cost > other.cost;
+	}
+};
+
+// Vertices are welded by position, as vertices split for normals or UVs must move together. The
+// faces keep their original vertex indices so each level can be drawn with the original vertices
+class CSimplifier
+{
+public:
+	CSimplifier( const SSubMesh& subMesh );
+
+	TUInt32 NumFaces()
+	{
+		return m_NumFaces;
+	}
+
+	// Largest distance so far of a remaining position from the planes of the original faces
+	// around the positions collapsed onto it
+	TFloat32 Error()
+	{
+		return m_MaxError;
+	}
+
+	// Make collapses until the number of faces reaches the target or no more can be made
+	void Simplify( TUInt32 targetFaces );
+
+	// Copy the indices of the remaining faces
+	void GetIndices( vector<TUInt32>* indices );
+
+private:
+	// Cost of moving the given position onto another
+	TFloat64 CollapseCost( TUInt32 from, TUInt32 to )
+	{
+		return QuadricError( m_Quadrics[from], m_Quadrics[to], m_Positions[to] );
+	}
+
+	// Queue the cheaper direction of collapse along the edge between two positions
+	void QueueEdge( TUInt32 pos1, TUInt32 pos2 );
+
+	// Make the given collapse if it is still valid and does not flip a face or tear a seam.
+	// Returns true if made
+	bool Collapse( const SCollapse& collapse );
+
+	// Unit normal of a face with the given corner positions, zero if degenerate
+	CVector3 FaceNormal( const CVector3& p0, const CVector3& p1, const CVector3& p2 )
+	{
+		return Normalise( Cross( p1 - p0, p2 - p0 ) );
+	}
+
+	// Distance of a point from the plane of an original face
+	TFloat32 PlaneDistance( TUInt32 face, const CVector3& p )
+	{
+		return Abs( Dot( m_FaceNormals[face], p ) + m_FacePlaneOffsets[face] );
+	}
+
+	// Welded positions, with the position of each vertex
+	vector<CVector3> m_Positions;
+	vector<TUInt32>  m_VertexPosition;
+
+	// Faces as three vertex indices each, with the faces using each position
+	vector<TUInt32>          m_Faces;
+	vector<bool>             m_FaceRemoved;
+	vector<vector<TUInt32> > m_PositionFaces;
+	TUInt32                  m_NumFaces;
+
+	// Plane of each original face (n.p + d = 0), and the original faces whose planes each
+	// position stands for - those around it and around all the positions collapsed onto it
+	vector<CVector3>         m_FaceNormals;
+	vector<TFloat32>         m_FacePlaneOffsets;
+	vector<vector<TUInt32> > m_PositionPlanes;
+
+	// Quadric for each position. Each position has a version that changes when it is collapsed
+	// or collapsed onto, so queued collapses using an old version are known to be out of date
+	vector<SQuadric> m_Quadrics;
+	vector<TUInt32>  m_Versions;
+	vector<bool>     m_Removed;
+
+	priority_queue<SCollapse, vector<SCollapse>, greater<SCollapse> > m_Queue;
+	TFloat32 m_MaxError;
+};
+
+
+// Weld the vertices, build the quadrics and queue the collapse of every edge
+CSimplifier::CSimplifier( const SSubMesh& subMesh )
+{
+	m_MaxError = 0.0f;
+	m_NumFaces = subMesh.numFaces;
+
+	// Weld vertices with exactly the same position by sorting them
+	TUInt32 numVertices = subMesh.numVertices;
+	const TUInt8* positions = subMesh.vertices + GetVertexLayout( subMesh ).position;
+	vector<CVector3> vertices( numVertices );
+	vector<TUInt32> order( numVertices );
+	for (TUInt32 vertex = 0; vertex < numVertices; ++vertex)
+	{
+		vertices[vertex] = CVector3( reinterpret_cast<const TFloat32*>(positions + vertex * subMesh.vertexSize) );
+		order[vertex] = vertex;
+	}
+	sort( order.begin(), order.end(), [&vertices]( TUInt32 a, TUInt32 b )
+	{
+		const CVector3& pa = vertices[a];
+		const CVector3& pb = vertices[b];
+		return pa.x < pb.x || (pa.x == pb.x && (pa.y < pb.y || (pa.y == pb.y && pa.z < pb.z)));
+	} );
+	m_VertexPosition.resize( numVertices );
+	for (TUInt32 sorted = 0; sorted < numVertices; ++sorted)
+	{
+		TUInt32 vertex = order[sorted];
+		if (sorted == 0 || vertices[vertex] != m_Positions.back())
+		{
+			m_Positions.push_back( vertices[vertex] );
+		}
+		m_VertexPosition[vertex] = static_cast<TUInt32>(m_Positions.size()) - 1;
+	}
+	TUInt32 numPositions = static_cast<TUInt32>(m_Positions.size());
+
+	// Faces and the faces around each position
+	m_Faces.resize( subMesh.numFaces * 3 );
+	m_FaceRemoved.assign( subMesh.numFaces, false );
+	m_PositionFaces.resize( numPositions );
+	for (TUInt32 face = 0; face < subMesh.numFaces; ++face)
+	{
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			m_Faces[face * 3 + corner] = GetFaceVertex( subMesh, face, corner );
+			m_PositionFaces[m_VertexPosition[m_Faces[face * 3 + corner]]].push_back( face );
+		}
+	}
+
+	// Quadric of each position from the planes of the faces around it
+	SQuadric zero = { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+	m_Quadrics.assign( numPositions, zero );
+	m_Versions.assign( numPositions, 0 );
+	m_Removed.assign( numPositions, false );
+	m_FaceNormals.resize( subMesh.numFaces );
+	m_FacePlaneOffsets.resize( subMesh.numFaces );
+	for (TUInt32 face = 0; face < subMesh.numFaces; ++face)
+	{
+		const TUInt32* corners = &m_Faces[face * 3];
+		m_FaceNormals[face] = FaceNormal( vertices[corners[0]], vertices[corners[1]], vertices[corners[2]] );
+		m_FacePlaneOffsets[face] = -Dot( m_FaceNormals[face], vertices[corners[0]] );
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			AddPlane( &m_Quadrics[m_VertexPosition[corners[corner]]], m_FaceNormals[face], vertices[corners[0]], 1.0 );
+		}
+	}
+	m_PositionPlanes = m_PositionFaces;
+
+	// Edges used by only one face (between the same two vertices, not positions) are open edges
+	// or seams. Add planes at right angles to the face along them, so they keep their shape
+	vector<TUInt64> edges;
+	edges.reserve( subMesh.numFaces * 3 );
+	for (TUInt32 face = 0; face < subMesh.numFaces; ++face)
+	{
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			TUInt64 v1 = m_Faces[face * 3 + corner];
+			TUInt64 v2 = m_Faces[face * 3 + (corner + 1) % 3];
+			edges.push_back( v1 < v2 ? (v1 << 32) | v2 : (v2 << 32) | v1 );
+		}
+	}
+	vector<TUInt64> sortedEdges( edges );
+	sort( sortedEdges.begin(), sortedEdges.end() );
+	for (TUInt32 edge = 0; edge < edges.size(); ++edge)
+	{
+		pair<vector<TUInt64>::iterator, vector<TUInt64>::iterator> range =
+			equal_range( sortedEdges.begin(), sortedEdges.end(), edges[edge] );
+		if (range.second - range.first != 1)
+		{
+			continue;
+		}
+		TUInt32 face = edge / 3;
+		const CVector3& p1 = vertices[m_Faces[edge]];
+		const CVector3& p2 = vertices[m_Faces[face * 3 + (edge % 3 + 1) % 3]];
+		CVector3 borderNormal = Normalise( Cross( p2 - p1, m_FaceNormals[face] ) );
+		AddPlane( &m_Quadrics[m_VertexPosition[m_Faces[edge]]], borderNormal, p1, kBorderWeight );
+		AddPlane( &m_Quadrics[m_VertexPosition[m_Faces[face * 3 + (edge % 3 + 1) % 3]]], borderNormal, p1,
+		          kBorderWeight );
+	}
+
+	// Queue every edge between positions. Edges shared by two faces are queued twice, the second
+	// is found to be out of date when reached
+	for (TUInt32 edge = 0; edge < edges.size(); ++edge)
+	{
+		TUInt32 face = edge / 3;
+		TUInt32 pos1 = m_VertexPosition[m_Faces[edge]];
+		TUInt32 pos2 = m_VertexPosition[m_Faces[face * 3 + (edge % 3 + 1) % 3]];
+		if (pos1 != pos2)
+		{
+			QueueEdge( pos1, pos2 );
+		}
+	}
+}
+
+
+// Queue the cheaper direction of collapse along the edge between two positions
+void CSimplifier::QueueEdge( TUInt32 pos1, TUInt32 pos2 )
+{
+	TFloat64 cost1 = CollapseCost( pos1, pos2 );
+	TFloat64 cost2 = CollapseCost( pos2, pos1 );
+	SCollapse collapse;
+	if (cost1 <= cost2)
+	{
+		collapse.cost = cost1;
+		collapse.from = pos1;
+		collapse.to = pos2;
+	}
+	else
+	{
+		collapse.cost = cost2;
+		collapse.from = pos2;
+		collapse.to = pos1;
+	}
+	collapse.fromVersion = m_Versions[collapse.from];
+	collapse.toVersion = m_Versions[collapse.to];
+	m_Queue.push( collapse );
+}
+
+
+// Make the given collapse if it is still valid and does not flip a face or tear a seam. Returns
+// true if made
+bool CSimplifier::Collapse( const SCollapse& collapse )
+{
+	TUInt32 from = collapse.from;
+	TUInt32 to = collapse.to;
+	if (m_Removed[from] || m_Removed[to] ||
+	    m_Versions[from] != collapse.fromVersion || m_Versions[to] != collapse.toVersion)
+	{
+		return false; // Out of date
+	}
+
+	// Faces using both positions are removed by the collapse. Each pairs a vertex at the old
+	// position with the vertex at the new position it will become
+	vector<TUInt32>& fromFaces = m_PositionFaces[from];
+	vector<pair<TUInt32, TUInt32> > vertexMap;
+	for (TUInt32 i = 0; i < fromFaces.size(); ++i)
+	{
+		TUInt32 face = fromFaces[i];
+		if (m_FaceRemoved[face]) continue;
+		const TUInt32* corners = &m_Faces[face * 3];
+		TUInt32 fromVertex = ~0u, toVertex = ~0u;
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			if (m_VertexPosition[corners[corner]] == from)  fromVertex = corners[corner];
+			else if (m_VertexPosition[corners[corner]] == to)  toVertex = corners[corner];
+		}
+		if (toVertex != ~0u)
+		{
+			vertexMap.push_back( make_pair( fromVertex, toVertex ) );
+		}
+	}
+	if (vertexMap.empty())
+	{
+		return false; // No longer an edge
+	}
+
+	// Check the faces that remain. Each of their vertices at the old position must have a vertex
+	// to become that shares its normal and UVs (i.e. shares a face with it), and the face must not
+	// flip over when moved
+	const CVector3& newPosition = m_Positions[to];
+	for (TUInt32 i = 0; i < fromFaces.size(); ++i)
+	{
+		TUInt32 face = fromFaces[i];
+		if (m_FaceRemoved[face]) continue;
+		const TUInt32* corners = &m_Faces[face * 3];
+		CVector3 oldCorners[3], newCorners[3];
+		bool sharesEdge = false;
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			TUInt32 position = m_VertexPosition[corners[corner]];
+			sharesEdge = sharesEdge || position == to;
+			oldCorners[corner] = m_Positions[position];
+			newCorners[corner] = (position == from) ? newPosition : oldCorners[corner];
+		}
+		if (sharesEdge) continue;
+
+		bool hasVertex = false;
+		for (TUInt32 corner = 0; corner < 3 && !hasVertex; ++corner)
+		{
+			for (TUInt32 mapped = 0; mapped < vertexMap.size() && !hasVertex; ++mapped)
+			{
+				hasVertex = (vertexMap[mapped].first == corners[corner]);
+			}
+		}
+		if (!hasVertex)
+		{
+			return false;
+		}
+
+		CVector3 oldNormal = FaceNormal( oldCorners[0], oldCorners[1], oldCorners[2] );
+		CVector3 newNormal = FaceNormal( newCorners[0], newCorners[1], newCorners[2] );
+		if (!IsZero( LengthSquared( oldNormal ) ) && Dot( oldNormal, newNormal ) < 0.2f)
+		{
+			return false; // Flipped, or folded too far (faces already degenerate can go either way)
+		}
+	}
+
+	// Make the collapse - remove faces with both positions, move the rest to the new position
+	for (TUInt32 i = 0; i < fromFaces.size(); ++i)
+	{
+		TUInt32 face = fromFaces[i];
+		if (m_FaceRemoved[face]) continue;
+		TUInt32* corners = &m_Faces[face * 3];
+		bool sharesEdge = false;
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			sharesEdge = sharesEdge || m_VertexPosition[corners[corner]] == to;
+		}
+		if (sharesEdge)
+		{
+			m_FaceRemoved[face] = true;
+			--m_NumFaces;
+			continue;
+		}
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			for (TUInt32 mapped = 0; mapped < vertexMap.size(); ++mapped)
+			{
+				if (vertexMap[mapped].first == corners[corner])
+				{
+					corners[corner] = vertexMap[mapped].second;
+					break;
+				}
+			}
+		}
+		m_PositionFaces[to].push_back( face );
+	}
+	fromFaces.clear();
+	m_Removed[from] = true;
+	AddQuadric( &m_Quadrics[to], m_Quadrics[from] );
+	++m_Versions[from];
+	++m_Versions[to];
+
+	// The error is how far the surface has moved from the original - the distance of the new
+	// position from the planes the old one stood for. The collapse cost is no use for this, it is
+	// a sum of squares with the border planes weighted up. The new position already lies on or
+	// has been measured against its own planes
+	vector<TUInt32>& fromPlanes = m_PositionPlanes[from];
+	vector<TUInt32>& toPlanes = m_PositionPlanes[to];
+	for (TUInt32 i = 0; i < fromPlanes.size(); ++i)
+	{
+		m_MaxError = Max( m_MaxError, PlaneDistance( fromPlanes[i], newPosition ) );
+	}
+	toPlanes.insert( toPlanes.end(), fromPlanes.begin(), fromPlanes.end() );
+	sort( toPlanes.begin(), toPlanes.end() );
+	toPlanes.erase( unique( toPlanes.begin(), toPlanes.end() ), toPlanes.end() );
+	vector<TUInt32>().swap( fromPlanes );
+
+	// Tidy the faces around the new position and queue collapses with its neighbours again
+	vector<TUInt32>& toFaces = m_PositionFaces[to];
+	TUInt32 numToFaces = 0;
+	for (TUInt32 i = 0; i < toFaces.size(); ++i)
+	{
+		if (m_FaceRemoved[toFaces[i]]) continue;
+		toFaces[numToFaces++] = toFaces[i];
+		for (TUInt32 corner = 0; corner < 3; ++corner)
+		{
+			TUInt32 position = m_VertexPosition[m_Faces[toFaces[i] * 3 + corner]];
+			if (position != to)
+			{
+				QueueEdge( to, position );
+			}
+		}
+	}
+	toFaces.resize( numToFaces );
+	return true;
+}
+
+
+// Make collapses until the number of faces reaches the target or no more can be made
+void CSimplifier::Simplify( TUInt32 targetFaces )
+{
+	while (m_NumFaces > targetFaces && !m_Queue.empty())
+	{
+		SCollapse collapse = m_Queue.top();
+		m_Queue.pop();
+		Collapse( collapse );
+	}
+}
+
+// Copy the indices of the remaining faces
+void CSimplifier::GetIndices( vector<TUInt32>* indices )
+{
+	indices->clear();
+	indices->reserve( m_NumFaces * 3 );
+	for (TUInt32 face = 0; face < m_FaceRemoved.size(); ++face)
+	{
+		if (!m_FaceRemoved[face])
+		{
+			indices->insert( indices->end(), &m_Faces[face * 3], &m_Faces[face * 3] + 3 );
+		}
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Simplification
+//-----------------------------------------------------------------------------
+
+// Simplify a sub-mesh by collapsing edges in order of least quadric error, producing a level for
+// each of the given target face counts, which must be decreasing. Each level continues from the
+// previous one, so the error only grows from level to level
+void SimplifySubMesh( const SSubMesh& subMesh, const TUInt32* targetFaces, TUInt32 numTargets,
+                      SSubMeshLod* levels )
+{
+	CSimplifier simplifier( subMesh );
+	for (TUInt32 level = 0; level < numTargets; ++level)
+	{
+		simplifier.Simplify( targetFaces[level] );
+		simplifier.GetIndices( &levels[level].indices );
+		levels[level].error = simplifier.Error();
+	}
+}
+
+
+// Proportion of the faces of each sub-mesh aimed for at each simplified level of detail
+static const TFloat32 kLodFaceRatios[kiMaxMeshLods - 1] = { 0.5f, 0.25f, 0.125f };
+
+// Meshes with fewer triangles than this are not simplified
+static const TUInt32 kiMinLodTriangles = 64;
+
+// A level is only kept if it has at most this proportion of the triangles of the level before -
+// when simplification stalls (e.g. on a mesh of separate flat-shaded faces) it is not worth the
+// index buffers
+static const TFloat32 kLodMinReduction = 0.8f;
+
+// Generate the levels of detail of a mesh. Each sub-mesh is reduced by the same proportion at each
+// level, and the level's error is the largest sub-mesh error
+TUInt32 SimplifyMesh( const SSubMesh* subMeshes, TUInt32 numSubMeshes, vector<SSubMeshLod>* subMeshLods,
+                      SMeshLod* levels )
+{
+	subMeshLods->clear();
+	levels[0].error = 0.0f;
+	levels[0].numTriangles = 0;
+	for (TUInt32 subMesh = 0; subMesh < numSubMeshes; ++subMesh)
+	{
+		levels[0].numTriangles += subMeshes[subMesh].numFaces;
+	}
+	if (levels[0].numTriangles < kiMinLodTriangles)
+	{
+		return 1;
+	}
+
+	subMeshLods->resize( numSubMeshes * (kiMaxMeshLods - 1) );
+	for (TUInt32 subMesh = 0; subMesh < numSubMeshes; ++subMesh)
+	{
+		TUInt32 targetFaces[kiMaxMeshLods - 1];
+		for (TUInt32 level = 0; level < kiMaxMeshLods - 1; ++level)
+		{
+			targetFaces[level] = static_cast<TUInt32>(subMeshes[subMesh].numFaces * kLodFaceRatios[level]);
+		}
+		SimplifySubMesh( subMeshes[subMesh], targetFaces, kiMaxMeshLods - 1,
+		                 &(*subMeshLods)[subMesh * (kiMaxMeshLods - 1)] );
+	}
+
+	TUInt32 numLevels = 1;
+	for (TUInt32 lod = 1; lod < kiMaxMeshLods; ++lod)
+	{
+		SMeshLod level = CombineSubMeshLods( *subMeshLods, numSubMeshes, lod );
+		if (level.numTriangles > levels[lod - 1].numTriangles * kLodMinReduction)
+		{
+			break;
+		}
+		levels[lod] = level;
+		numLevels = lod + 1;
+	}
+	if (numLevels == 1)
+	{
+		subMeshLods->clear();
+	}
+	return numLevels;
+}
+
+// Get a simplified level of detail (1 and above) of a whole mesh from the levels of its sub-meshes
+SMeshLod CombineSubMeshLods( const vector<SSubMeshLod>& subMeshLods, TUInt32 numSubMeshes, TUInt32 lod )
+{
+	SMeshLod level = { 0.0f, 0 };
+	for (TUInt32 subMesh = 0; subMesh < numSubMeshes; ++subMesh)
+	{
+		const SSubMeshLod& subMeshLod = subMeshLods[subMesh * (kiMaxMeshLods - 1) + lod - 1];
+		level.error = Max( level.error, subMeshLod.error );
+		level.numTriangles += static_cast<TUInt32>(subMeshLod.indices.size()) / 3;
+	}
+	return level;
+}
+
+
+} // namespace gen
@@ -0,0 +1,65 @@
+/*******************************************
+	MeshSimplifier.h
+
+	Import-time simplification of sub-meshes
+	into levels of detail by quadric error
+	metrics. Each level is a reduced list of
+	faces over the sub-mesh's own vertices,
+	so all levels share one vertex buffer
+********************************************/
+
+#pragma once
+
+#include <vector>
+using namespace std;
+
+#include "../Common/Defines.h"
+#include "MeshData.h"
+
+namespace gen
+{
+
+// Maximum number of levels of detail of a mesh, including the full detail level 0
+const TUInt32 kiMaxMeshLods = 4;
+
+// One simplified level of detail of a sub-mesh
+struct SSubMeshLod
+{
+	vector<TUInt32> indices; // Three vertex indices per face, into the original sub-mesh vertices
+
+	// Largest distance of a remaining vertex from the planes of the original faces around the
+	// vertices collapsed onto it, in the sub-mesh's model units - how far the surface has moved
+	TFloat32        error;
+};
+
+// A level of detail of a whole mesh - each sub-mesh simplified by the same proportion
+struct SMeshLod
+{
+	TFloat32 error;        // Largest error of the sub-meshes
+	TUInt32  numTriangles;
+};
+
+
+// Simplify a sub-mesh by collapsing edges in order of least quadric error (Garland & Heckbert),
+// producing a level for each of the given target face counts, which must be decreasing. Each
+// collapse moves a vertex onto a neighbour, so no new vertices are made. Collapses that would
+// flip a face, or tear a seam where vertices with the same position have different normals or
+// UVs, are not made - so a level may have more faces than its target if the sub-mesh can be
+// simplified no further. The levels array must have numTargets entries
+void SimplifySubMesh( const SSubMesh& subMesh, const TUInt32* targetFaces, TUInt32 numTargets,
+                      SSubMeshLod* levels );
+
+// Generate the levels of detail of a mesh, simplifying each sub-mesh by the same proportion at
+// each level. Fills the levels array (kiMaxMeshLods entries, level 0 is the full mesh) and returns
+// how many levels there are - small meshes are not simplified, and levels that reduce the mesh too
+// little are dropped. The faces of levels 1 and above are stored in subMeshLods, kiMaxMeshLods - 1
+// entries per sub-mesh, which is left empty if there is only level 0
+TUInt32 SimplifyMesh( const SSubMesh* subMeshes, TUInt32 numSubMeshes, vector<SSubMeshLod>* subMeshLods,
+                      SMeshLod* levels );
+
+// Get a simplified level of detail (1 and above) of a whole mesh from the levels of its sub-meshes,
+// laid out as by SimplifyMesh
+SMeshLod CombineSubMeshLods( const vector<SSubMeshLod>& subMeshLods, TUInt32 numSubMeshes, TUInt32 lod );
+
+
+} // namespace gen
@@ -0,0 +1,187 @@
+/*******************************************
+	ParticlePresetFile.cpp
+
+	Compiled particle preset file implementation
+********************************************/
+
+#include <fstream>
+#include <cstring>
+#include <type_traits>
+
+#include "ParticlePresetFile.h"
+
+namespace gen
+{
+
+// Layout of the file must not depend on the compiler. Descriptions are used in place, so they
+// must be plain data
+static_assert( sizeof(SPresetFileHeader) == 24, "Preset file header layout changed" );
+static_assert( sizeof(SParticleEffectDesc) == 64, "Effect description layout changed" );
+static_assert( sizeof(SPresetFilePreset) == 96, "Preset file preset layout changed" );
+static_assert( is_trivially_copyable<SParticleEffectDesc>::value, "Effect descriptions must be plain data" );
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+CParticlePresetFile::CParticlePresetFile()
+{
+	m_Data = 0;
+	m_Size = 0;
+}
+
+CParticlePresetFile::~CParticlePresetFile()
+{
+	Close();
+}
+
+
+//-----------------------------------------------------------------------------
+// Opening / closing
+//-----------------------------------------------------------------------------
+
+// Map the given compiled preset file and check its contents are valid. Returns false on failure
+bool CParticlePresetFile::Open( const string& fileName )
+{
+	Close();
+	if (!m_File.Open( fileName ) || m_File.Size() < sizeof(SPresetFileHeader))
+	{
+		Close();
+		return false;
+	}
+	m_Data = m_File.Data();
+	m_Size = m_File.Size();
+
+	if (!Validate())
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+// Unmap the file - any descriptions returned are no longer valid
+void CParticlePresetFile::Close()
+{
+	m_File.Close();
+	m_Data = 0;
+	m_Size = 0;
+}
+
+
+// Check the header, the preset array and every preset in the file
+bool CParticlePresetFile::Validate() const
+{
+	const SPresetFileHeader* header = Header();
+	if (memcmp( header->magic, kPresetFileMagic, sizeof(kPresetFileMagic) ) != 0 ||
+	    header->version != kPresetFileVersion || header->fileSize != m_Size ||
+	    header->presetSize != sizeof(SPresetFilePreset) || header->presetsOffset % kPresetFileAlignment != 0 ||
+	    static_cast<TUInt64>(header->presetsOffset) + header->numPresets * static_cast<TUInt64>(sizeof(SPresetFilePreset)) > m_Size)
+	{
+		return false;
+	}
+
+	const SPresetFilePreset* presets = Presets();
+	for (TUInt32 preset = 0; preset < header->numPresets; ++preset)
+	{
+		if (memchr( presets[preset].name, 0, kMaxPresetName ) == 0 || !IsValidEffectDesc( presets[preset].desc ))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Data access
+//-----------------------------------------------------------------------------
+
+// Find the description of the preset with the given name, 0 if there is none. Files hold a
+// handful of presets, so a linear search is fine
+const SParticleEffectDesc* CParticlePresetFile::Find( const string& name ) const
+{
+	for (TUInt32 preset = 0; preset < GetNumPresets(); ++preset)
+	{
+		if (name == Presets()[preset].name)
+		{
+			return &Presets()[preset].desc;
+		}
+	}
+	return 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Writing
+//-----------------------------------------------------------------------------
+
+// Write a compiled preset file. Returns false on failure, with a reason in the error string
+bool CParticlePresetFile::Write( const string& fileName, const vector<SParticlePreset>& presets,
+                                 string* error /*= 0*/ )
+{
+	string reason;
+	for (TUInt32 preset = 0; preset < presets.size() && reason.empty(); ++preset)
+	{
+		const string& name = presets[preset].name;
+		if (name.empty() || name.length() >= kMaxPresetName)
+		{
+			reason = "preset name '" + name + "' must be 1 to 31 characters";
+		}
+		else if (!IsValidEffectDesc( presets[preset].desc ))
+		{
+			reason = "preset '" + name + "' has invalid settings";
+		}
+		for (TUInt32 other = 0; other < preset && reason.empty(); ++other)
+		{
+			if (presets[other].name == name)
+			{
+				reason = "preset name '" + name + "' used more than once";
+			}
+		}
+	}
+	if (!reason.empty())
+	{
+		if (error)  *error = reason;
+		return false;
+	}
+
+	SPresetFileHeader header;
+	memset( &header, 0, sizeof(header) );
+	memcpy( header.magic, kPresetFileMagic, sizeof(kPresetFileMagic) );
+	header.version = kPresetFileVersion;
+	header.presetSize = sizeof(SPresetFilePreset);
+	header.numPresets = static_cast<TUInt32>(presets.size());
+	header.presetsOffset = (sizeof(SPresetFileHeader) + kPresetFileAlignment - 1) & ~(kPresetFileAlignment - 1);
+	header.fileSize = header.presetsOffset + header.numPresets * sizeof(SPresetFilePreset);
+
+	// Build the file in memory then write in one go. Zeroed first so unused name characters and
+	// padding are always the same
+	vector<TUInt8> data( header.fileSize, 0 );
+	memcpy( &data[0], &header, sizeof(header) );
+	for (TUInt32 preset = 0; preset < presets.size(); ++preset)
+	{
+		SPresetFilePreset* filePreset =
+			reinterpret_cast<SPresetFilePreset*>(&data[header.presetsOffset + preset * sizeof(SPresetFilePreset)]);
+		memcpy( filePreset->name, presets[preset].name.c_str(), presets[preset].name.length() );
+		filePreset->desc = presets[preset].desc;
+	}
+
+	ofstream file( fileName.c_str(), ios::binary | ios::trunc );
+	if (!file)
+	{
+		if (error)  *error = "cannot create " + fileName;
+		return false;
+	}
+	file.write( reinterpret_cast<const char*>(&data[0]), data.size() );
+	if (!file)
+	{
+		if (error)  *error = "cannot write " + fileName;
+		return false;
+	}
+	return true;
+}
+
+
+} // namespace gen
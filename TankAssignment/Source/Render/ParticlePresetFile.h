@@ -0,0 +1,168 @@
+/*******************************************
+	ParticlePresetFile.h
+
+	Compiled particle effect presets, written
+	by the particle tool from an XML preset
+	file. The file is memory-mapped when read
+	and each preset's effect description is
+	used in place by the emitter pool, so the
+	game does no parsing
+********************************************/
+
+#pragma once
+
+#include <vector>
+#include <string>
+using namespace std;
+
+#include "../Common/Defines.h"
+#include "../Common/CMappedFile.h"
+#include "EmitterPool.h"
+
+namespace gen
+{
+
+/////////////////////////////////////
+// File format
+
+// A compiled preset file is a header followed by an array of presets, each a fixed size name and
+// an SParticleEffectDesc exactly as the emitter pool uses it. Data is stored little-endian as on
+// all our target machines. Change the version if SParticleEffectDesc changes - old files will be
+// rejected and the built-in effects used until the presets are compiled again
+const char    kPresetFileMagic[4] = { 'T', 'P', 'F', 'X' };
+const TUInt32 kPresetFileVersion = 1;
+const TUInt32 kPresetFileAlignment = 16;
+
+// Longest preset name, including the terminator
+const TUInt32 kMaxPresetName = 32;
+
+struct SPresetFileHeader
+{
+	char    magic[4];      // kPresetFileMagic
+	TUInt32 version;       // kPresetFileVersion
+	TUInt32 fileSize;      // Size of whole file, to detect truncation
+	TUInt32 presetSize;    // sizeof(SPresetFilePreset), to detect layout changes
+	TUInt32 numPresets;
+	TUInt32 presetsOffset;
+};
+
+struct SPresetFilePreset
+{
+	char                name[kMaxPresetName]; // Null-terminated, unused characters are zero
+	SParticleEffectDesc desc;
+};
+
+
+/////////////////////////////////////
+// Presets in memory
+
+// A preset as authored, before compiling
+struct SParticlePreset
+{
+	string              name;
+	SParticleEffectDesc desc;
+};
+
+
+/////////////////////////////////////
+// Preset file reader
+
+// Reads a compiled preset file through a read-only memory mapping. Descriptions returned point
+// into the mapping, so the file must stay open while any effect started from them is running
+class CParticlePresetFile
+{
+public:
+	/////////////////////////////////////
+	// Constructors/Destructors
+
+	CParticlePresetFile();
+	~CParticlePresetFile();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CParticlePresetFile( const CParticlePresetFile& );
+	CParticlePresetFile& operator=( const CParticlePresetFile& );
+
+
+public:
+	/////////////////////////////////////
+	// Opening / closing
+
+	// Map the given compiled preset file and check its contents are valid (including every
+	// description, see IsValidEffectDesc). Returns false on failure
+	bool Open( const string& fileName );
+
+	// Unmap the file - any descriptions returned are no longer valid
+	void Close();
+
+	bool IsOpen() const
+	{
+		return m_Data != 0;
+	}
+
+	// Size of the mapped file in bytes, 0 if not open
+	TUInt32 FileSize() const
+	{
+		return m_Size;
+	}
+
+
+	/////////////////////////////////////
+	// Data access
+
+	TUInt32 GetNumPresets() const
+	{
+		return m_Data ? Header()->numPresets : 0;
+	}
+
+	const char* GetPresetName( TUInt32 preset ) const
+	{
+		return Presets()[preset].name;
+	}
+
+	const SParticleEffectDesc& GetPreset( TUInt32 preset ) const
+	{
+		return Presets()[preset].desc;
+	}
+
+	// Find the description of the preset with the given name, 0 if there is none
+	const SParticleEffectDesc* Find( const string& name ) const;
+
+
+	/////////////////////////////////////
+	// Writing
+
+	// Write a compiled preset file. Names must be unique and shorter than kMaxPresetName, and
+	// every description valid. Returns false on failure, with a reason in the error string if
+	// one is given
+	static bool Write( const string& fileName, const vector<SParticlePreset>& presets, string* error = 0 );
+
+
+private:
+	/////////////////////////////////////
+	// Support functions
+
+	const SPresetFileHeader* Header() const
+	{
+		return reinterpret_cast<const SPresetFileHeader*>(m_Data);
+	}
+
+	const SPresetFilePreset* Presets() const
+	{
+		return reinterpret_cast<const SPresetFilePreset*>(m_Data + Header()->presetsOffset);
+	}
+
+	// Check the header, the preset array and every preset in the file
+	bool Validate() const;
+
+
+	/////////////////////////////////////
+	// Data
+
+	CMappedFile   m_File;
+	const TUInt8* m_Data; // Start of mapped file, 0 if not open
+	TUInt32       m_Size;
+};
+
+
+} // namespace gen
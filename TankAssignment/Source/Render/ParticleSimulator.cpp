@@ -0,0 +1,288 @@
+/*******************************************
+	ParticleSimulator.cpp
+
+	CPU particle update, see header
+********************************************/
+
+#if defined(__AVX__)
+	#include <immintrin.h> // AVX intrinsics, when building with /arch:AVX or above
+#else
+	#include <xmmintrin.h> // SSE intrinsics
+#endif
+
+#include "ParticleSimulator.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// Vector width
+//-----------------------------------------------------------------------------
+
+// The integration is written once over these names, eight particles at a time with AVX and four
+// with SSE. Loads and stores are unaligned, vector data makes no alignment promises
+#if defined(__AVX__)
+	typedef __m256 TParticleVec;
+	const TUInt32 kParticleVecWidth = 8;
+	#define PV_LOAD(p)     _mm256_loadu_ps( p )
+	#define PV_STORE(p, v) _mm256_storeu_ps( p, v )
+	#define PV_SET1(f)     _mm256_set1_ps( f )
+	#define PV_ADD(a, b)   _mm256_add_ps( a, b )
+	#define PV_MUL(a, b)   _mm256_mul_ps( a, b )
+	#define PV_AND(a, b)   _mm256_and_ps( a, b )
+	#define PV_GT(a, b)    _mm256_cmp_ps( a, b, _CMP_GT_OQ )
+#else
+	typedef __m128 TParticleVec;
+	const TUInt32 kParticleVecWidth = 4;
+	#define PV_LOAD(p)     _mm_loadu_ps( p )
+	#define PV_STORE(p, v) _mm_storeu_ps( p, v )
+	#define PV_SET1(f)     _mm_set1_ps( f )
+	#define PV_ADD(a, b)   _mm_add_ps( a, b )
+	#define PV_MUL(a, b)   _mm_mul_ps( a, b )
+	#define PV_AND(a, b)   _mm_and_ps( a, b )
+	#define PV_GT(a, b)    _mm_cmpgt_ps( a, b )
+#endif
+
+
+//-----------------------------------------------------------------------------
+// Construction
+//-----------------------------------------------------------------------------
+
+// Construct a simulator for up to the given number of particles, all of them in use
+CParticleSimulator::CParticleSimulator( TUInt32 maxParticles, CThreadPool* pool /*= 0*/ )
+{
+	m_MaxParticles = maxParticles;
+	m_NumParticles = maxParticles;
+	m_NumLive = 0;
+	m_Pool = pool;
+
+	m_PositionX.resize( maxParticles );
+	m_PositionY.resize( maxParticles );
+	m_PositionZ.resize( maxParticles );
+	m_VelocityX.resize( maxParticles );
+	m_VelocityY.resize( maxParticles );
+	m_VelocityZ.resize( maxParticles );
+	m_Life.resize( maxParticles );
+	m_ChunkLive.resize( (maxParticles + kParticleChunkSize - 1) / kParticleChunkSize );
+
+	ResetParticles();
+}
+
+
+//-----------------------------------------------------------------------------
+// Particles
+//-----------------------------------------------------------------------------
+
+// Reset all the particles to their original positions, the same spread as CParticalSystem
+void CParticleSimulator::ResetParticles()
+{
+	for (TUInt32 p = 0; p < m_MaxParticles; ++p)
+	{
+		m_PositionX[p] = Random( -10.0f, 10.0f );
+		m_PositionY[p] = Random( -50.0f, 50.0f );
+		m_PositionZ[p] = Random( -10.0f, 10.0f );
+		m_VelocityX[p] = Random( -40.0f, 40.0f );
+		m_VelocityY[p] = Random( 0.0f, 60.0f );
+		m_VelocityZ[p] = Random( -40.0f, 40.0f );
+		m_Life[p] = (5.0f * p) / m_MaxParticles;
+	}
+	m_NumLive = (m_NumParticles > 0) ? m_NumParticles - 1 : 0; // All but the first, which has no life
+}
+
+void CParticleSimulator::SetParticle( TUInt32 particle, const CVector3& position, const CVector3& velocity,
+                                      TFloat32 life )
+{
+	m_PositionX[particle] = position.x;
+	m_PositionY[particle] = position.y;
+	m_PositionZ[particle] = position.z;
+	m_VelocityX[particle] = velocity.x;
+	m_VelocityY[particle] = velocity.y;
+	m_VelocityZ[particle] = velocity.z;
+	m_Life[particle] = life;
+}
+
+void CParticleSimulator::GetParticle( TUInt32 particle, CVector3* position, CVector3* velocity,
+                                      TFloat32* life ) const
+{
+	position->Set( m_PositionX[particle], m_PositionY[particle], m_PositionZ[particle] );
+	velocity->Set( m_VelocityX[particle], m_VelocityY[particle], m_VelocityZ[particle] );
+	*life = m_Life[particle];
+}
+
+// Copy the particles in the given range whose life has not run out to the output
+TUInt32 CParticleSimulator::GatherLive( TUInt32 first, TUInt32 count, SParticleVertex* output ) const
+{
+	TUInt32 numLive = 0;
+	for (TUInt32 p = first; p < first + count; ++p)
+	{
+		if (m_Life[p] > 0.0f)
+		{
+			SParticleVertex& vertex = output[numLive++];
+			vertex.position.Set( m_PositionX[p], m_PositionY[p], m_PositionZ[p] );
+			vertex.velocity.Set( m_VelocityX[p], m_VelocityY[p], m_VelocityZ[p] );
+			vertex.life = m_Life[p];
+		}
+	}
+	return numLive;
+}
+
+
+//-----------------------------------------------------------------------------
+// Update
+//-----------------------------------------------------------------------------
+
+// Move the particles in use on by the given time. Large sets are split into chunks for the
+// thread pool, each chunk writes only its own particles and live count
+void CParticleSimulator::Update( TFloat32 updateTime )
+{
+	const TUInt32 numChunks = (m_NumParticles + kParticleChunkSize - 1) / kParticleChunkSize;
+	auto updateChunk = [&]( TUInt32 chunk )
+	{
+		TUInt32 first = chunk * kParticleChunkSize;
+		m_ChunkLive[chunk] = UpdateRange( first, Min( kParticleChunkSize, m_NumParticles - first ), updateTime );
+	};
+	if (m_Pool && numChunks > 1)
+	{
+		m_Pool->ParallelFor( numChunks, updateChunk );
+	}
+	else
+	{
+		for (TUInt32 chunk = 0; chunk < numChunks; ++chunk)
+		{
+			updateChunk( chunk );
+		}
+	}
+
+	m_NumLive = 0;
+	for (TUInt32 chunk = 0; chunk < numChunks; ++chunk)
+	{
+		m_NumLive += m_ChunkLive[chunk];
+	}
+}
+
+// Update the given range of particles, returning the number still alive in it. The same sums as
+// DX10ParticlesUpdate.gsh - life, then position using the old velocity, then velocity
+TUInt32 CParticleSimulator::UpdateRange( TUInt32 first, TUInt32 count, TFloat32 updateTime )
+{
+	TFloat32* posX = &m_PositionX[first];
+	TFloat32* posY = &m_PositionY[first];
+	TFloat32* posZ = &m_PositionZ[first];
+	TFloat32* velX = &m_VelocityX[first];
+	TFloat32* velY = &m_VelocityY[first];
+	TFloat32* velZ = &m_VelocityZ[first];
+	TFloat32* life = &m_Life[first];
+
+	const TParticleVec time = PV_SET1( updateTime );
+	const TParticleVec negTime = PV_SET1( -updateTime );
+	const TParticleVec gravityStep = PV_SET1( kParticleGravity * updateTime );
+	const TParticleVec zero = PV_SET1( 0.0f );
+	const TParticleVec one = PV_SET1( 1.0f );
+
+	// Live particles are counted in float lanes (exact well beyond a chunk)
+	TParticleVec live = zero;
+	TUInt32 p = 0;
+	for (; p + kParticleVecWidth <= count; p += kParticleVecWidth)
+	{
+		TParticleVec newLife = PV_ADD( PV_LOAD( life + p ), negTime );
+		PV_STORE( life + p, newLife );
+		live = PV_ADD( live, PV_AND( PV_GT( newLife, zero ), one ) );
+
+		TParticleVec vy = PV_LOAD( velY + p );
+		PV_STORE( posX + p, PV_ADD( PV_LOAD( posX + p ), PV_MUL( PV_LOAD( velX + p ), time ) ) );
+		PV_STORE( posY + p, PV_ADD( PV_LOAD( posY + p ), PV_MUL( vy, time ) ) );
+		PV_STORE( posZ + p, PV_ADD( PV_LOAD( posZ + p ), PV_MUL( PV_LOAD( velZ + p ), time ) ) );
+		PV_STORE( velY + p, PV_ADD( vy, gravityStep ) );
+	}
+
+	TFloat32 lanes[kParticleVecWidth];
+	PV_STORE( lanes, live );
+	TUInt32 numLive = 0;
+	for (TUInt32 lane = 0; lane < kParticleVecWidth; ++lane)
+	{
+		numLive += static_cast<TUInt32>(lanes[lane]);
+	}
+
+	// Remaining particles one at a time
+	const TFloat32 gravityStepScalar = kParticleGravity * updateTime;
+	for (; p < count; ++p)
+	{
+		life[p] -= updateTime;
+		if (life[p] > 0.0f)  ++numLive;
+		posX[p] += velX[p] * updateTime;
+		posY[p] += velY[p] * updateTime;
+		posZ[p] += velZ[p] * updateTime;
+		velY[p] += gravityStepScalar;
+	}
+	return numLive;
+}
+
+// Update the given range of particles with the given acceleration and drag, returning the number
+// still alive. Position moves with the old velocity as above, then the velocity is scaled down
+// by the drag and takes the acceleration
+TUInt32 CParticleSimulator::UpdateRange( TUInt32 first, TUInt32 count, TFloat32 updateTime,
+                                         const CVector3& acceleration, TFloat32 drag )
+{
+	TFloat32* posX = &m_PositionX[first];
+	TFloat32* posY = &m_PositionY[first];
+	TFloat32* posZ = &m_PositionZ[first];
+	TFloat32* velX = &m_VelocityX[first];
+	TFloat32* velY = &m_VelocityY[first];
+	TFloat32* velZ = &m_VelocityZ[first];
+	TFloat32* life = &m_Life[first];
+
+	// Drag of a whole second or more in one update would reverse the velocity, so stop instead
+	const TFloat32 dragScaleScalar = Max( 1.0f - drag * updateTime, 0.0f );
+	const CVector3 accelerationStep = acceleration * updateTime;
+
+	const TParticleVec time = PV_SET1( updateTime );
+	const TParticleVec negTime = PV_SET1( -updateTime );
+	const TParticleVec dragScale = PV_SET1( dragScaleScalar );
+	const TParticleVec stepX = PV_SET1( accelerationStep.x );
+	const TParticleVec stepY = PV_SET1( accelerationStep.y );
+	const TParticleVec stepZ = PV_SET1( accelerationStep.z );
+	const TParticleVec zero = PV_SET1( 0.0f );
+	const TParticleVec one = PV_SET1( 1.0f );
+
+	TParticleVec live = zero;
+	TUInt32 p = 0;
+	for (; p + kParticleVecWidth <= count; p += kParticleVecWidth)
+	{
+		TParticleVec newLife = PV_ADD( PV_LOAD( life + p ), negTime );
+		PV_STORE( life + p, newLife );
+		live = PV_ADD( live, PV_AND( PV_GT( newLife, zero ), one ) );
+
+		TParticleVec vx = PV_LOAD( velX + p );
+		TParticleVec vy = PV_LOAD( velY + p );
+		TParticleVec vz = PV_LOAD( velZ + p );
+		PV_STORE( posX + p, PV_ADD( PV_LOAD( posX + p ), PV_MUL( vx, time ) ) );
+		PV_STORE( posY + p, PV_ADD( PV_LOAD( posY + p ), PV_MUL( vy, time ) ) );
+		PV_STORE( posZ + p, PV_ADD( PV_LOAD( posZ + p ), PV_MUL( vz, time ) ) );
+		PV_STORE( velX + p, PV_ADD( PV_MUL( vx, dragScale ), stepX ) );
+		PV_STORE( velY + p, PV_ADD( PV_MUL( vy, dragScale ), stepY ) );
+		PV_STORE( velZ + p, PV_ADD( PV_MUL( vz, dragScale ), stepZ ) );
+	}
+
+	TFloat32 lanes[kParticleVecWidth];
+	PV_STORE( lanes, live );
+	TUInt32 numLive = 0;
+	for (TUInt32 lane = 0; lane < kParticleVecWidth; ++lane)
+	{
+		numLive += static_cast<TUInt32>(lanes[lane]);
+	}
+
+	for (; p < count; ++p)
+	{
+		life[p] -= updateTime;
+		if (life[p] > 0.0f)  ++numLive;
+		posX[p] += velX[p] * updateTime;
+		posY[p] += velY[p] * updateTime;
+		posZ[p] += velZ[p] * updateTime;
+		velX[p] = velX[p] * dragScaleScalar + accelerationStep.x;
+		velY[p] = velY[p] * dragScaleScalar + accelerationStep.y;
+		velZ[p] = velZ[p] * dragScaleScalar + accelerationStep.z;
+	}
+	return numLive;
+}
+
+
+} // namespace gen
@@ -0,0 +1,146 @@
+/*******************************************
+	ParticleSimulator.h
+
+	CPU version of the CParticalSystem update,
+	for runs without a GPU and for measuring
+	effects. Particles are held as structure
+	of arrays and integrated with SSE (or AVX
+	where the compiler targets it) in chunks
+	shared out over a thread pool
+********************************************/
+
+#pragma once
+
+#include <vector>
+using namespace std;
+
+#include "../Common/Defines.h"
+#include "../Common/CThreadPool.h"
+#include "../Math/CVector3.h"
+
+namespace gen
+{
+
+// Gravity applied to every particle, as in DX10ParticlesUpdate.gsh
+const TFloat32 kParticleGravity = -9.8f;
+
+// Number of particles integrated by each item of work given to the thread pool
+const TUInt32 kParticleChunkSize = 16384;
+
+// A particle as sent to the GPU, matching the vertex layout of CParticalSystem
+struct SParticleVertex
+{
+	CVector3 position;
+	CVector3 velocity;
+	TFloat32 life;
+};
+
+
+class CParticleSimulator
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Construct a simulator for up to the given number of particles, all of them in use. Updates
+	// are shared out over the given thread pool if there is one. Particles are set up as for
+	// CParticalSystem, see ResetParticles
+	CParticleSimulator( TUInt32 maxParticles, CThreadPool* pool = 0 );
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CParticleSimulator( const CParticleSimulator& );
+	CParticleSimulator& operator=( const CParticleSimulator& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	/////////////////////////////////////
+	// Particles
+
+	// Reset all the particles to their original positions - a random spread below the origin,
+	// moving up and out, with lives staggered from 0 to 5 seconds
+	void ResetParticles();
+
+	// Set / get a single particle
+	void SetParticle( TUInt32 particle, const CVector3& position, const CVector3& velocity, TFloat32 life );
+	void GetParticle( TUInt32 particle, CVector3* position, CVector3* velocity, TFloat32* life ) const;
+
+	TUInt32 MaxParticles() const
+	{
+		return m_MaxParticles;
+	}
+
+	// Number of particles updated, the first particles of the full set
+	TUInt32 NumParticles() const
+	{
+		return m_NumParticles;
+	}
+	void SetNumParticles( TUInt32 numParticles )
+	{
+		m_NumParticles = Min( numParticles, m_MaxParticles );
+	}
+
+	// Copy the particles in the given range whose life has not run out to the output, which must
+	// have space for count particles. Returns the number copied
+	TUInt32 GatherLive( TUInt32 first, TUInt32 count, SParticleVertex* output ) const;
+
+	// Number of particles in use whose life has not run out, as of the last update
+	TUInt32 NumLiveParticles() const
+	{
+		return m_NumLive;
+	}
+
+	// Direct access to the particle components, one array per component of MaxParticles entries
+	const TFloat32* PositionsX() const { return &m_PositionX[0]; }
+	const TFloat32* PositionsY() const { return &m_PositionY[0]; }
+	const TFloat32* PositionsZ() const { return &m_PositionZ[0]; }
+	const TFloat32* Lives() const      { return &m_Life[0]; }
+
+	// Memory in bytes used by the particle arrays
+	TUInt64 MemorySize() const
+	{
+		return static_cast<TUInt64>(m_MaxParticles) * 7 * sizeof(TFloat32);
+	}
+
+
+	/////////////////////////////////////
+	// Update
+
+	// Move the particles in use on by the given time - lives reduce, positions move with the
+	// velocities, then the velocities take gravity. Particles whose life has run out carry on
+	// moving as they do on the GPU, it is up to the user to respawn them
+	void Update( TFloat32 updateTime );
+
+	// Update just the given range of particles on this thread, whether in use or not. Returns the
+	// number still alive in the range. Used where particles are shared out between several users
+	TUInt32 UpdateRange( TUInt32 first, TUInt32 count, TFloat32 updateTime );
+
+	// As above, but with the given acceleration in place of gravity and with drag - velocities
+	// lose the given proportion of themselves per second. Used for effects with their own forces
+	TUInt32 UpdateRange( TUInt32 first, TUInt32 count, TFloat32 updateTime,
+	                     const CVector3& acceleration, TFloat32 drag );
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	TUInt32 m_MaxParticles;
+	TUInt32 m_NumParticles;
+	TUInt32 m_NumLive;
+
+	// Particle components, structure of arrays
+	vector<TFloat32> m_PositionX, m_PositionY, m_PositionZ;
+	vector<TFloat32> m_VelocityX, m_VelocityY, m_VelocityZ;
+	vector<TFloat32> m_Life;
+
+	// Live counts of each chunk from the last parallel update
+	vector<TUInt32> m_ChunkLive;
+
+	CThreadPool* m_Pool;
+};
+
+
+} // namespace gen
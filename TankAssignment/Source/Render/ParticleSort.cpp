@@ -0,0 +1,240 @@
+/*******************************************
+	ParticleSort.cpp
+
+	Back to front particle ordering, see header
+********************************************/
+
+#include <cstring>
+#include "ParticleSort.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// Sort keys
+//-----------------------------------------------------------------------------
+
+// Key bits sorted by each radix pass - three passes of 11 bits. The counts of a block for a pass
+// (8KB) stay in the L1 cache
+static const TUInt32 kRadixBits = 11;
+static const TUInt32 kRadixBins = 1 << kRadixBits;
+
+// Key that sorts ascending for descending depth, i.e. furthest first. The float bits are made to
+// compare as unsigned integers (flip all bits of negatives, just the sign of positives), then
+// inverted to reverse the order
+static inline TUInt32 DepthKey( TFloat32 depth )
+{
+	TUInt32 bits;
+	memcpy( &bits, &depth, sizeof(bits) );
+	bits ^= (bits & 0x80000000u) ? 0xffffffffu : 0x80000000u;
+	return ~bits;
+}
+
+
+//-----------------------------------------------------------------------------
+// Construction
+//-----------------------------------------------------------------------------
+
+// Construct a sorter for up to the given number of particles. All memory is allocated here
+CParticleSorter::CParticleSorter( TUInt32 maxParticles, CThreadPool* pool /*= 0*/ )
+{
+	m_MaxParticles = maxParticles;
+	m_Keys.resize( maxParticles );
+	m_Order.resize( maxParticles );
+	m_SortKeys.resize( maxParticles );
+	m_TempKeys.resize( maxParticles );
+	m_TempOrder.resize( maxParticles );
+	m_BlockCounts.resize( kRadixBins * ((maxParticles + kSortBlockSize - 1) / kSortBlockSize) );
+	m_LastCount = 0;
+	m_Pool = pool;
+
+	m_Stats.radixSorts = 0;
+	m_Stats.incrementalSorts = 0;
+	m_Stats.failedResorts = 0;
+}
+
+
+//-----------------------------------------------------------------------------
+// Sorting
+//-----------------------------------------------------------------------------
+
+// Order particles given as separate x, y & z arrays back to front
+const TUInt32* CParticleSorter::Sort( const TFloat32* x, const TFloat32* y, const TFloat32* z, TUInt32 numParticles,
+                                      const CVector3& viewPosition, const CVector3& viewDirection )
+{
+	numParticles = Min( numParticles, m_MaxParticles );
+	CalculateKeys( x, y, z, 1, numParticles, viewPosition, viewDirection );
+	return SortKeys( numParticles );
+}
+
+// Order particle vertices back to front
+const TUInt32* CParticleSorter::Sort( const SParticleVertex* particles, TUInt32 numParticles,
+                                      const CVector3& viewPosition, const CVector3& viewDirection )
+{
+	const TUInt32 stride = sizeof(SParticleVertex) / sizeof(TFloat32);
+	numParticles = Min( numParticles, m_MaxParticles );
+	const TFloat32* position = &particles[0].position.x;
+	CalculateKeys( position, position + 1, position + 2, stride, numParticles, viewPosition, viewDirection );
+	return SortKeys( numParticles );
+}
+
+// Sort keys for each particle - the distance along the view direction
+void CParticleSorter::CalculateKeys( const TFloat32* x, const TFloat32* y, const TFloat32* z, TUInt32 stride,
+                                     TUInt32 numParticles, const CVector3& viewPosition, const CVector3& viewDirection )
+{
+	// Depth = position . direction - viewPosition . direction
+	const TFloat32 viewDepth = Dot( viewPosition, viewDirection );
+	ForEachBlock( numParticles, [&]( TUInt32 block )
+	{
+		TUInt32 first = block * kSortBlockSize;
+		TUInt32 last = Min( first + kSortBlockSize, numParticles );
+		for (TUInt32 p = first; p < last; ++p)
+		{
+			TUInt32 offset = p * stride;
+			TFloat32 depth = x[offset] * viewDirection.x + y[offset] * viewDirection.y + z[offset] * viewDirection.z;
+			m_Keys[p] = DepthKey( depth - viewDepth );
+		}
+	} );
+}
+
+// Sort from the keys calculated, re-sorting the last order if it is for the same particles
+const TUInt32* CParticleSorter::SortKeys( TUInt32 numParticles )
+{
+	if (numParticles > 0 && numParticles == m_LastCount)
+	{
+		if (Resort( numParticles ))
+		{
+			++m_Stats.incrementalSorts;
+			return &m_Order[0];
+		}
+		++m_Stats.failedResorts;
+	}
+
+	RadixSort( numParticles );
+	++m_Stats.radixSorts;
+	m_LastCount = numParticles;
+	return m_Order.empty() ? 0 : &m_Order[0];
+}
+
+// Insertion sort of the last order by the new keys - close to linear when the particles have
+// only moved a little since the last sort. Gives up after the allowed number of moves
+bool CParticleSorter::Resort( TUInt32 numParticles )
+{
+	TUInt32* order = &m_Order[0];
+	const TUInt32* keys = &m_Keys[0];
+	const TUInt32 maxMoves = static_cast<TUInt32>(numParticles * kMaxResortMoves);
+	TUInt32 moves = 0;
+	for (TUInt32 i = 1; i < numParticles; ++i)
+	{
+		TUInt32 particle = order[i];
+		TUInt32 key = keys[particle];
+		TUInt32 j = i;
+		while (j > 0 && keys[order[j - 1]] > key)
+		{
+			order[j] = order[j - 1];
+			--j;
+			if (++moves > maxMoves)
+			{
+				order[j] = particle; // Keep the order a permutation for the radix sort
+				return false;
+			}
+		}
+		order[j] = particle;
+	}
+	return true;
+}
+
+// Full radix sort by key. Each pass counts the digits of each block of particles, turns the counts
+// into output offsets (all blocks' 0s, then all blocks' 1s...) and scatters each block to its
+// offsets. Blocks keep their particles in order so each pass is stable. Passes where every
+// particle has the same digit are skipped
+void CParticleSorter::RadixSort( TUInt32 numParticles )
+{
+	TUInt32* keys = m_SortKeys.empty() ? 0 : &m_SortKeys[0];
+	TUInt32* order = m_Order.empty() ? 0 : &m_Order[0];
+	TUInt32* tempKeys = m_TempKeys.empty() ? 0 : &m_TempKeys[0];
+	TUInt32* tempOrder = m_TempOrder.empty() ? 0 : &m_TempOrder[0];
+	const TUInt32 numBlocks = (numParticles + kSortBlockSize - 1) / kSortBlockSize;
+
+	ForEachBlock( numParticles, [&]( TUInt32 block )
+	{
+		TUInt32 last = Min( (block + 1) * kSortBlockSize, numParticles );
+		for (TUInt32 p = block * kSortBlockSize; p < last; ++p)
+		{
+			keys[p] = m_Keys[p];
+			order[p] = p;
+		}
+	} );
+
+	for (TUInt32 shift = 0; shift < 32; shift += kRadixBits)
+	{
+		ForEachBlock( numParticles, [&]( TUInt32 block )
+		{
+			TUInt32* counts = &m_BlockCounts[block * kRadixBins];
+			memset( counts, 0, kRadixBins * sizeof(TUInt32) );
+			TUInt32 last = Min( (block + 1) * kSortBlockSize, numParticles );
+			for (TUInt32 p = block * kSortBlockSize; p < last; ++p)
+			{
+				++counts[(keys[p] >> shift) & (kRadixBins - 1)];
+			}
+		} );
+
+		TUInt32 offset = 0;
+		bool singleDigit = false;
+		for (TUInt32 digit = 0; digit < kRadixBins; ++digit)
+		{
+			TUInt32 digitStart = offset;
+			for (TUInt32 block = 0; block < numBlocks; ++block)
+			{
+				TUInt32 count = m_BlockCounts[block * kRadixBins + digit];
+				m_BlockCounts[block * kRadixBins + digit] = offset;
+				offset += count;
+			}
+			singleDigit = singleDigit || (offset - digitStart == numParticles);
+		}
+		if (singleDigit)
+		{
+			continue;
+		}
+
+		ForEachBlock( numParticles, [&]( TUInt32 block )
+		{
+			TUInt32* offsets = &m_BlockCounts[block * kRadixBins];
+			TUInt32 last = Min( (block + 1) * kSortBlockSize, numParticles );
+			for (TUInt32 p = block * kSortBlockSize; p < last; ++p)
+			{
+				TUInt32 target = offsets[(keys[p] >> shift) & (kRadixBins - 1)]++;
+				tempKeys[target] = keys[p];
+				tempOrder[target] = order[p];
+			}
+		} );
+		swap( keys, tempKeys );
+		swap( order, tempOrder );
+	}
+
+	// An odd number of passes leaves the result in the temporary buffer
+	if (numParticles > 0 && order != &m_Order[0])
+	{
+		memcpy( &m_Order[0], order, numParticles * sizeof(TUInt32) );
+	}
+}
+
+// Run work( block ) for each block of the given number of particles
+void CParticleSorter::ForEachBlock( TUInt32 numParticles, const function<void( TUInt32 )>& work )
+{
+	const TUInt32 numBlocks = (numParticles + kSortBlockSize - 1) / kSortBlockSize;
+	if (m_Pool && numBlocks > 1)
+	{
+		m_Pool->ParallelFor( numBlocks, work );
+	}
+	else
+	{
+		for (TUInt32 block = 0; block < numBlocks; ++block)
+		{
+			work( block );
+		}
+	}
+}
+
+
+} // namespace gen
@@ -0,0 +1,127 @@
+/*******************************************
+	ParticleSort.h
+
+	Back to front ordering of particles for
+	alpha blending. View depths are turned into
+	32-bit keys and radix sorted, the passes
+	shared over a thread pool. The order from
+	the last sort is re-sorted in place instead
+	when the particles have hardly moved
+********************************************/
+
+#pragma once
+
+#include <vector>
+using namespace std;
+
+#include "../Common/Defines.h"
+#include "../Common/CThreadPool.h"
+#include "../Math/CVector3.h"
+#include "ParticleSimulator.h"
+
+namespace gen
+{
+
+// Particles in each block of work of a parallel radix pass or key calculation
+const TUInt32 kSortBlockSize = 32768;
+
+// Most element moves an incremental re-sort may make, as a proportion of the particles, before
+// it gives up and a full radix sort is done instead
+const TFloat32 kMaxResortMoves = 0.25f;
+
+// Counts of each kind of sort since the sorter was created
+struct SParticleSortStats
+{
+	TUInt32 radixSorts;       // Full sorts
+	TUInt32 incrementalSorts; // Last order re-sorted successfully
+	TUInt32 failedResorts;    // Re-sorts given up as the order had changed too much
+};
+
+
+class CParticleSorter
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	// Construct a sorter for up to the given number of particles. Sorts are shared out over the
+	// given thread pool if there is one. All memory is allocated here
+	CParticleSorter( TUInt32 maxParticles, CThreadPool* pool = 0 );
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CParticleSorter( const CParticleSorter& );
+	CParticleSorter& operator=( const CParticleSorter& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Order particles back to front as seen from the given view position and (unit) direction.
+	// Returns the particle indices, furthest first, valid until the next sort. If the number of
+	// particles is the same as the last sort they are taken to be the same particles, and the
+	// last order is re-sorted if it is still nearly right. Positions are given as separate x, y &
+	// z arrays (e.g. from CParticleSimulator) or as particle vertices
+	const TUInt32* Sort( const TFloat32* x, const TFloat32* y, const TFloat32* z, TUInt32 numParticles,
+	                     const CVector3& viewPosition, const CVector3& viewDirection );
+	const TUInt32* Sort( const SParticleVertex* particles, TUInt32 numParticles,
+	                     const CVector3& viewPosition, const CVector3& viewDirection );
+
+	// Forget the last order so the next sort is a full one (e.g. when the particles are replaced)
+	void Invalidate()
+	{
+		m_LastCount = 0;
+	}
+
+	const SParticleSortStats& GetStats() const
+	{
+		return m_Stats;
+	}
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// Sort keys for each particle from positions with the given stride (in floats) between them
+	void CalculateKeys( const TFloat32* x, const TFloat32* y, const TFloat32* z, TUInt32 stride,
+	                    TUInt32 numParticles, const CVector3& viewPosition, const CVector3& viewDirection );
+
+	// Sort from the keys calculated, re-sorting the last order if possible
+	const TUInt32* SortKeys( TUInt32 numParticles );
+
+	// Insertion sort of the last order by the new keys. Returns false if more than the allowed
+	// moves were needed, leaving the order a valid but unsorted permutation
+	bool Resort( TUInt32 numParticles );
+
+	// Full least-significant digit radix sort of all particles by key, 11 bits per pass
+	void RadixSort( TUInt32 numParticles );
+
+	// Run work( block ) for each block of the given number of particles, on the pool if there is
+	// one and more than one block
+	void ForEachBlock( TUInt32 numParticles, const function<void( TUInt32 )>& work );
+
+
+	TUInt32 m_MaxParticles;
+
+	// Key of each particle by particle index, and the order to return
+	vector<TUInt32> m_Keys;
+	vector<TUInt32> m_Order;
+
+	// Keys in sorted order and double buffers for the radix passes
+	vector<TUInt32> m_SortKeys;
+	vector<TUInt32> m_TempKeys;
+	vector<TUInt32> m_TempOrder;
+
+	// Digit counts of each block for a radix pass. Become output offsets
+	vector<TUInt32> m_BlockCounts;
+
+	// Number of particles in the last sort, 0 if there is no order to re-sort
+	TUInt32 m_LastCount;
+
+	CThreadPool*       m_Pool;
+	SParticleSortStats m_Stats;
+};
+
+
+} // namespace gen
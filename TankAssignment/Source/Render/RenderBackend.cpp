@@ -0,0 +1,70 @@
+/*******************************************
+	RenderBackend.cpp
+
+	Null render backend implementation
+********************************************/
+
+#include "RenderBackend.h"
+
+namespace gen
+{
+
+// Construct with zeroed statistics - pass true to also record each call made
+CNullRenderBackend::CNullRenderBackend( bool record /*= false*/ )
+{
+	m_Record = record;
+	Reset();
+}
+
+// Zero the statistics and clear the recorded calls
+void CNullRenderBackend::Reset()
+{
+	m_Stats.techniqueChanges = 0;
+	m_Stats.materialChanges = 0;
+	m_Stats.geometryChanges = 0;
+	m_Stats.drawCalls = 0;
+	m_Stats.instances = 0;
+	m_Commands.clear();
+}
+
+
+void CNullRenderBackend::SetTechnique( ERenderMethod method )
+{
+	++m_Stats.techniqueChanges;
+	Record( Command_SetTechnique, method, 0, 0, 0, 0 );
+}
+
+void CNullRenderBackend::SetMaterial( CMesh* mesh, TUInt32 material )
+{
+	++m_Stats.materialChanges;
+	Record( Command_SetMaterial, PlainColour, mesh, material, 0, 0 );
+}
+
+void CNullRenderBackend::SetGeometry( CMesh* mesh, TUInt32 subMesh, TUInt32 lod )
+{
+	++m_Stats.geometryChanges;
+	Record( Command_SetGeometry, PlainColour, mesh, subMesh, lod, 0 );
+}
+
+void CNullRenderBackend::Draw( CMesh* mesh, TUInt32 subMesh, TUInt32 lod, const CMatrix4x4* worldMatrices,
+                               TUInt32 numInstances )
+{
+	++m_Stats.drawCalls;
+	m_Stats.instances += numInstances;
+	Record( Command_Draw, PlainColour, mesh, subMesh, lod, numInstances );
+}
+
+
+// Add a call to the log if recording
+void CNullRenderBackend::Record( ECommandType type, ERenderMethod method, CMesh* mesh, TUInt32 index,
+                                 TUInt32 lod, TUInt32 numInstances )
+{
+	if (m_Record)
+	{
+		SCommand command = { type, method, mesh, index, lod, numInstances };
+		m_Commands.push_back( command );
+	}
+}
+
+
+} // namespace gen
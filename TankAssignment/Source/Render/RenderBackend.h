@@ -0,0 +1,138 @@
+/*******************************************
+	RenderBackend.h
+
+	Interface between the render queue and
+	the graphics API. Also a null backend
+	that draws nothing but counts (and can
+	record) the calls it receives, so draw
+	submission can be measured without a
+	device
+********************************************/
+
+#pragma once
+
+#include <vector>
+using namespace std;
+
+#include "../Common/Defines.h"
+#include "../Math/CMatrix4x4.h"
+#include "RenderMethod.h"
+
+namespace gen
+{
+
+class CMesh;
+
+//-----------------------------------------------------------------------------
+// Backend interface
+//-----------------------------------------------------------------------------
+
+// Receives state changes and draws from CRenderQueue::Flush. The queue only calls a setter when
+// the state actually changes, so a backend can apply each call directly
+class IRenderBackend
+{
+public:
+	// Destructor - base class destructors should always be virtual
+	virtual ~IRenderBackend() {}
+
+	// Select the render method (technique) for following draws
+	virtual void SetTechnique( ERenderMethod method ) = 0;
+
+	// Select the given material of a mesh (colours and textures) for following draws
+	virtual void SetMaterial( CMesh* mesh, TUInt32 material ) = 0;
+
+	// Select the vertex / index data of the given sub-mesh and level of detail for following draws
+	virtual void SetGeometry( CMesh* mesh, TUInt32 subMesh, TUInt32 lod ) = 0;
+
+	// Draw the current geometry once for each of the given world matrices
+	virtual void Draw( CMesh* mesh, TUInt32 subMesh, TUInt32 lod, const CMatrix4x4* worldMatrices,
+	                   TUInt32 numInstances ) = 0;
+};
+
+
+//-----------------------------------------------------------------------------
+// Null backend
+//-----------------------------------------------------------------------------
+
+// Counts of the calls made to a backend
+struct SRenderStats
+{
+	TUInt32 techniqueChanges;
+	TUInt32 materialChanges;
+	TUInt32 geometryChanges;
+	TUInt32 drawCalls;
+	TUInt32 instances; // Total number of sub-meshes drawn over all draw calls
+};
+
+// Backend with no device - keeps statistics and optionally a log of the calls made to it
+class CNullRenderBackend : public IRenderBackend
+{
+public:
+	/////////////////////////////////////
+	// Types
+
+	enum ECommandType
+	{
+		Command_SetTechnique,
+		Command_SetMaterial,
+		Command_SetGeometry,
+		Command_Draw,
+	};
+
+	// A single recorded call - unused fields are 0
+	struct SCommand
+	{
+		ECommandType  type;
+		ERenderMethod method;       // SetTechnique
+		CMesh*        mesh;         // SetMaterial, SetGeometry, Draw
+		TUInt32       index;        // Material for SetMaterial, sub-mesh for SetGeometry / Draw
+		TUInt32       lod;          // SetGeometry, Draw
+		TUInt32       numInstances; // Draw
+	};
+
+
+	/////////////////////////////////////
+	// Constructor
+
+	// Construct with zeroed statistics - pass true to also record each call made
+	CNullRenderBackend( bool record = false );
+
+
+	/////////////////////////////////////
+	// Statistics / recording
+
+	const SRenderStats& GetStats()
+	{
+		return m_Stats;
+	}
+
+	const vector<SCommand>& Commands()
+	{
+		return m_Commands;
+	}
+
+	// Zero the statistics and clear the recorded calls
+	void Reset();
+
+
+	/////////////////////////////////////
+	// Backend interface
+
+	void SetTechnique( ERenderMethod method );
+	void SetMaterial( CMesh* mesh, TUInt32 material );
+	void SetGeometry( CMesh* mesh, TUInt32 subMesh, TUInt32 lod );
+	void Draw( CMesh* mesh, TUInt32 subMesh, TUInt32 lod, const CMatrix4x4* worldMatrices, TUInt32 numInstances );
+
+
+private:
+	// Add a call to the log if recording
+	void Record( ECommandType type, ERenderMethod method, CMesh* mesh, TUInt32 index, TUInt32 lod,
+	             TUInt32 numInstances );
+
+	SRenderStats     m_Stats;
+	bool             m_Record;
+	vector<SCommand> m_Commands;
+};
+
+
+} // namespace gen
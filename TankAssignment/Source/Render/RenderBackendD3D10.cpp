@@ -0,0 +1,72 @@
+/*******************************************
+	RenderBackendD3D10.cpp
+
+	DirectX 10 render backend implementation
+********************************************/
+
+#include <d3d10.h>
+#include "../Math/BaseMath.h"
+#include "RenderBackendD3D10.h"
+#include "Mesh.h"
+
+namespace gen
+{
+
+// Get reference to global variables from another source file
+// Not good practice - these functions should be part of a class with this as a member
+extern ID3D10Device* g_pd3dDevice;
+
+
+void CRenderBackendD3D10::SetTechnique( ERenderMethod method )
+{
+	// Technique is applied per-draw, as the instanced and single versions differ
+	m_Method = method;
+}
+
+void CRenderBackendD3D10::SetMaterial( CMesh* mesh, TUInt32 material )
+{
+	mesh->SetMaterialDX( material );
+}
+
+void CRenderBackendD3D10::SetGeometry( CMesh* mesh, TUInt32 subMesh, TUInt32 lod )
+{
+	mesh->SetGeometryDX( subMesh, lod );
+}
+
+// Single draws use the method's technique. Several instances use the instanced technique,
+// kMaxInstances at a time
+void CRenderBackendD3D10::Draw( CMesh* mesh, TUInt32 subMesh, TUInt32 lod, const CMatrix4x4* worldMatrices,
+                                TUInt32 numInstances )
+{
+	const TUInt32 numIndices = mesh->GetSubMeshNumIndices( subMesh, lod );
+	D3D10_TECHNIQUE_DESC techDesc;
+
+	if (numInstances == 1)
+	{
+		SetWorldMatrix( worldMatrices[0] );
+		ID3D10EffectTechnique* technique = GetRenderMethodTechnique( m_Method );
+		technique->GetDesc( &techDesc );
+		for (UINT p = 0; p < techDesc.Passes; ++p)
+		{
+			technique->GetPassByIndex( p )->Apply( 0 );
+			g_pd3dDevice->DrawIndexed( numIndices, 0, 0 );
+		}
+		return;
+	}
+
+	ID3D10EffectTechnique* technique = GetRenderMethodInstancedTechnique( m_Method );
+	technique->GetDesc( &techDesc );
+	for (TUInt32 first = 0; first < numInstances; first += kMaxInstances)
+	{
+		const TUInt32 batchSize = Min( numInstances - first, kMaxInstances );
+		SetInstanceWorldMatrices( worldMatrices + first, batchSize );
+		for (UINT p = 0; p < techDesc.Passes; ++p)
+		{
+			technique->GetPassByIndex( p )->Apply( 0 );
+			g_pd3dDevice->DrawIndexedInstanced( numIndices, batchSize, 0, 0, 0 );
+		}
+	}
+}
+
+
+} // namespace gen
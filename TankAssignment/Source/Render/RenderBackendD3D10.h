@@ -0,0 +1,38 @@
+/*******************************************
+	RenderBackendD3D10.h
+
+	Render backend drawing with DirectX 10
+	and the render methods in the .fx file
+********************************************/
+
+#pragma once
+
+#include "../Common/Defines.h"
+#include "RenderBackend.h"
+
+namespace gen
+{
+
+class CRenderBackendD3D10 : public IRenderBackend
+{
+public:
+	CRenderBackendD3D10()
+	{
+		m_Method = PlainColour;
+	}
+
+	void SetTechnique( ERenderMethod method );
+	void SetMaterial( CMesh* mesh, TUInt32 material );
+	void SetGeometry( CMesh* mesh, TUInt32 subMesh, TUInt32 lod );
+
+	// Single draws use the method's technique. Several instances use the instanced technique,
+	// kMaxInstances at a time
+	void Draw( CMesh* mesh, TUInt32 subMesh, TUInt32 lod, const CMatrix4x4* worldMatrices, TUInt32 numInstances );
+
+private:
+	// Render method selected by SetTechnique
+	ERenderMethod m_Method;
+};
+
+
+} // namespace gen
@@ -34,15 +34,16 @@ void RM_NormalMapping( D3DXCOLOR* diffuseColour, D3DXCOLOR* specularColour, floa
 // exact operation of each render method in turn. Each method has a technique and a function to
 // initialise the shaders in that technique for rendering. Also specify number of textures needed
 // (e.g. diffuse map, normal map) and a boolean indicating if the render method contains tangents
+// Each method also has an instanced technique, used to draw several copies of a mesh in one call
 //************************************************************************************************/
 SRenderMethod RenderMethods[NumRenderMethods] =
 {
-//	|Technique name|     |Method init fn|         |Num Tex|  |Tangents|  |for internal use|   |Method Name|
-	"PlainColour",       RM_TransformColour,      0,         false,      0,                // PlainColour   
-	"TexColour",         RM_TransformTexColour,   1,         false,      0,                // PlainTexture  
-	"PixelLit",          RM_TransformMaterial,    0,         false,      0,                // PixelLit      
-	"PixelLitTex",       RM_TransformTexMaterial, 1,         false,      0,                // PixelLitTex   
-	"CutoutPixelLitTex", RM_TransformTexMaterial, 1,         false,      0,                // CutoutPixelLitTex
+//	|Technique name|     |Method init fn|         |Num Tex|  |Tangents|  |for internal use|  |Instanced technique name|     |for internal use|   |Method Name|
+	"PlainColour",       RM_TransformColour,      0,         false,      0,                 "PlainColourInstanced",        0,                 // PlainColour   
+	"TexColour",         RM_TransformTexColour,   1,         false,      0,                 "TexColourInstanced",          0,                 // PlainTexture  
+	"PixelLit",          RM_TransformMaterial,    0,         false,      0,                 "PixelLitInstanced",           0,                 // PixelLit      
+	"PixelLitTex",       RM_TransformTexMaterial, 1,         false,      0,                 "PixelLitTexInstanced",        0,                 // PixelLitTex   
+	"CutoutPixelLitTex", RM_TransformTexMaterial, 1,         false,      0,                 "CutoutPixelLitTexInstanced",  0,                 // CutoutPixelLitTex
 };
 
 
@@ -108,6 +109,13 @@ ID3D10EffectTechnique* GetRenderMethodTechnique( ERenderMethod method )
 	return RenderMethods[method].technique;
 }
 
+// Return the .fx file technique used by given render method when drawing several instances of a
+// mesh at once. World matrices come from SetInstanceWorldMatrices rather than SetRenderMethod
+ID3D10EffectTechnique* GetRenderMethodInstancedTechnique( ERenderMethod method )
+{
+	return RenderMethods[method].instancedTechnique;
+}
+
 // Use the given method for rendering
 void SetRenderMethod( ERenderMethod method, D3DXCOLOR* diffuseColour, D3DXCOLOR* specularColour, float specularPower,
                       ID3D10ShaderResourceView** textures, CMatrix4x4* worldMatrix )
@@ -140,11 +148,17 @@ ID3D10Effect* Effect = NULL;
 
 // Matrices / camera
 ID3D10EffectMatrixVariable* WorldMatrixVar = NULL;
+ID3D10EffectMatrixVariable* InstanceWorldMatricesVar = NULL;
 ID3D10EffectMatrixVariable* ViewMatrixVar = NULL;
 ID3D10EffectMatrixVariable* ProjMatrixVar = NULL;
 ID3D10EffectMatrixVariable* ViewProjMatrixVar = NULL;
 ID3D10EffectVectorVariable* CameraPosVar = NULL;
 
+// Vertex decoding
+ID3D10EffectVectorVariable* PositionScaleVar = NULL;
+ID3D10EffectVectorVariable* PositionOffsetVar = NULL;
+ID3D10EffectScalarVariable* OctahedralNormalsVar = NULL;
+
 // Lighting
 ID3D10EffectVectorVariable* Light1PosVar = NULL;
 ID3D10EffectVectorVariable* Light1ColourVar = NULL;
@@ -184,11 +198,17 @@ bool InitialiseMethods()
 
 	// Access matrix / camera shader variables
 	WorldMatrixVar    = Effect->GetVariableByName( "WorldMatrix"    )->AsMatrix();
+	InstanceWorldMatricesVar = Effect->GetVariableByName( "InstanceWorldMatrices" )->AsMatrix();
 	ViewMatrixVar     = Effect->GetVariableByName( "ViewMatrix"     )->AsMatrix();
 	ProjMatrixVar     = Effect->GetVariableByName( "ProjMatrix"     )->AsMatrix();
 	ViewProjMatrixVar = Effect->GetVariableByName( "ViewProjMatrix" )->AsMatrix();
 	CameraPosVar      = Effect->GetVariableByName( "CameraPos"     )->AsVector();
 
+	// Vertex decoding
+	PositionScaleVar     = Effect->GetVariableByName( "PositionScale"     )->AsVector();
+	PositionOffsetVar    = Effect->GetVariableByName( "PositionOffset"    )->AsVector();
+	OctahedralNormalsVar = Effect->GetVariableByName( "OctahedralNormals" )->AsScalar();
+
 	// Access lighting shader variables
 	Light1PosVar     = Effect->GetVariableByName( "Light1Pos"     )->AsVector();
 	Light1ColourVar  = Effect->GetVariableByName( "Light1Colour"  )->AsVector();
@@ -223,6 +243,16 @@ bool PrepareMethod( ERenderMethod method )
 			return false;
 		}
 	}
+	if (!RenderMethods[method].instancedTechnique)
+	{
+		RenderMethods[method].instancedTechnique = Effect->GetTechniqueByName( RenderMethods[method].instancedTechniqueName.c_str() );
+		if (!RenderMethods[method].instancedTechnique->IsValid())
+		{
+			string errorMsg = "Error selecting technique " + RenderMethods[method].instancedTechniqueName;
+			SystemMessageBox( errorMsg.c_str(), "Shader Error" );
+			return false;
+		}
+	}
 
 	return true;
 }
@@ -268,6 +298,28 @@ void SetCamera( CCamera* camera )
 	CameraPosVar->SetRawValue( &camera->Position(), 0, 12 );
 }
 
+// Set the world matrix for the next (non-instanced) draw, leaving material settings unchanged
+void SetWorldMatrix( const CMatrix4x4& worldMatrix )
+{
+	WorldMatrixVar->SetMatrix( const_cast<float*>(&worldMatrix.e00) );
+}
+
+// Set the world matrices for the next instanced draw, at most kMaxInstances
+void SetInstanceWorldMatrices( const CMatrix4x4* worldMatrices, TUInt32 numInstances )
+{
+	// Matrices are contiguous 16 float blocks, so the array can be sent directly
+	InstanceWorldMatricesVar->SetMatrixArray( const_cast<float*>(&worldMatrices[0].e00), 0, numInstances );
+}
+
+// Set how the vertex shaders decode the vertices of the next draw - positions are stored 0->1
+// over a box given by a scale and offset, normals are either octahedral or plain floats
+void SetVertexDecoding( const CVector3& positionScale, const CVector3& positionOffset, bool octahedralNormals )
+{
+	PositionScaleVar->SetRawValue( const_cast<CVector3*>(&positionScale), 0, 12 );
+	PositionOffsetVar->SetRawValue( const_cast<CVector3*>(&positionOffset), 0, 12 );
+	OctahedralNormalsVar->SetBool( octahedralNormals );
+}
+
 
 //-----------------------------------------------------------------------------
 // Specific render method setup functions
@@ -15,6 +15,7 @@ using namespace std;
 
 #include "../Common/Defines.h"
 #include "../Math/CMatrix4x4.h"
+#include "MeshData.h"
 #include "../Scene/Camera.h"
 #include "../Scene/Light.h"
 
@@ -25,18 +26,8 @@ namespace gen
 // Render method types
 //-----------------------------------------------------------------------------
 
-// Customisable list of render methods available for use in materials and implemented in
-// RenderMethod.cpp/.h. This list can be changed to to support new rendering methods
-enum ERenderMethod
-{
-	PlainColour        = 0,
-	PlainTexture       = 1,
-	PixelLit           = 2,
-	PixelLitTex        = 3,
-	CutoutPixelLitTex  = 4,
-	NumRenderMethods  // Leave this entry at end
-};
-
+// The list of render methods, ERenderMethod, is in MeshData.h with the materials that use it, so
+// mesh data can be used without DirectX
 
 // Pointer to a function to initialise a render method - typically sets shader constants
 typedef void (*PRenderMethodFn)(D3DXCOLOR* diffuseColour, D3DXCOLOR* specularColour, float specularPower, ID3D10ShaderResourceView** textures, CMatrix4x4* worldMatrix);
@@ -53,8 +44,15 @@ struct SRenderMethod
 	bool                   usesTangents;  // Whether vertex tangents should be calculated for meshes using this method
 
 	ID3D10EffectTechnique* technique;     // Pointer to actual technique
+
+	string                 instancedTechniqueName; // Technique taking world matrices per-instance (see SetInstanceWorldMatrices)
+	ID3D10EffectTechnique* instancedTechnique;
 };
 
+// Maximum number of instances drawn in one instanced draw call - must match MAX_INSTANCES in
+// TankAssignment.fx. Larger batches are split into several draw calls
+const TUInt32 kMaxInstances = 64;
+
 
 
 //-----------------------------------------------------------------------------
@@ -82,6 +80,10 @@ bool RenderMethodUsesTangents( ERenderMethod method );
 // Return the .fx file technique used by given render method
 ID3D10EffectTechnique* GetRenderMethodTechnique( ERenderMethod method );
 
+// Return the .fx file technique used by given render method when drawing several instances of a
+// mesh at once. World matrices come from SetInstanceWorldMatrices rather than SetRenderMethod
+ID3D10EffectTechnique* GetRenderMethodInstancedTechnique( ERenderMethod method );
+
 // Use the given method for rendering
 void SetRenderMethod( ERenderMethod method, D3DXCOLOR* diffuseColour, D3DXCOLOR* specularColour, float specularPower,
                       ID3D10ShaderResourceView** textures, CMatrix4x4* worldMatrix );
@@ -114,5 +116,15 @@ void SetLights( CLight** lights );
 // Set the camera to use for all methods
 void SetCamera( CCamera* camera );
 
+// Set the world matrix for the next (non-instanced) draw, leaving material settings unchanged
+void SetWorldMatrix( const CMatrix4x4& worldMatrix );
+
+// Set the world matrices for the next instanced draw, at most kMaxInstances
+void SetInstanceWorldMatrices( const CMatrix4x4* worldMatrices, TUInt32 numInstances );
+
+// Set how the vertex shaders decode the vertices of the next draw - positions are stored 0->1
+// over a box given by a scale and offset, normals are either octahedral or plain floats
+void SetVertexDecoding( const CVector3& positionScale, const CVector3& positionOffset, bool octahedralNormals );
+
 
 } // namespace gen
\ No newline at end of file
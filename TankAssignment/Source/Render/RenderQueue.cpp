@@ -0,0 +1,95 @@
+/*******************************************
+	RenderQueue.cpp
+
+	Render queue implementation
+********************************************/
+
+#include <algorithm>
+
+#include "RenderQueue.h"
+
+namespace gen
+{
+
+namespace
+{
+	bool PacketLess( const CRenderQueue::SDrawPacket& a, const CRenderQueue::SDrawPacket& b )
+	{
+		return a.sortKey < b.sortKey;
+	}
+}
+
+
+// Sort the packets by key
+void CRenderQueue::Sort()
+{
+	sort( m_Packets.begin(), m_Packets.end(), PacketLess );
+}
+
+
+// Sort the packets then send them to the given backend, changing technique, material and
+// geometry only when they differ from the previous draw. Runs of packets with the same key are
+// sent as one draw with several world matrices. The queue is empty afterwards
+void CRenderQueue::Flush( IRenderBackend* backend )
+{
+	Sort();
+
+	// The material is identified by all the key bits above the level of detail and sub-mesh (method,
+	// mesh, material)
+	const TUInt64 kNoKey = ~static_cast<TUInt64>(0);
+	TUInt64 currentMethodKey = kNoKey;
+	TUInt64 currentMaterialKey = kNoKey;
+
+	const size_t numPackets = m_Packets.size();
+	size_t packet = 0;
+	while (packet < numPackets)
+	{
+		const TUInt64 key = m_Packets[packet].sortKey;
+		CMesh* mesh = m_Packets[packet].mesh;
+
+		// Find the run of packets with the same key
+		size_t runEnd = packet + 1;
+		while (runEnd < numPackets && m_Packets[runEnd].sortKey == key)
+		{
+			++runEnd;
+		}
+
+		if (key >> 56 != currentMethodKey)
+		{
+			currentMethodKey = key >> 56;
+			backend->SetTechnique( SortKeyMethod( key ) );
+		}
+		if (key >> 16 != currentMaterialKey)
+		{
+			currentMaterialKey = key >> 16;
+			backend->SetMaterial( mesh, SortKeyMaterial( key ) );
+		}
+
+		// Each key is a different sub-mesh or level of detail, so geometry always changes here
+		const TUInt32 subMesh = SortKeySubMesh( key );
+		const TUInt32 lod = SortKeyLod( key );
+		backend->SetGeometry( mesh, subMesh, lod );
+
+		const TUInt32 numInstances = static_cast<TUInt32>(runEnd - packet);
+		if (numInstances == 1)
+		{
+			backend->Draw( mesh, subMesh, lod, m_Packets[packet].worldMatrix, 1 );
+		}
+		else
+		{
+			m_InstanceMatrices.resize( numInstances );
+			for (TUInt32 instance = 0; instance < numInstances; ++instance)
+			{
+				m_InstanceMatrices[instance] = *m_Packets[packet + instance].worldMatrix;
+			}
+			backend->Draw( mesh, subMesh, lod, &m_InstanceMatrices[0], numInstances );
+		}
+
+		packet = runEnd;
+	}
+
+	m_Packets.clear();
+}
+
+
+} // namespace gen
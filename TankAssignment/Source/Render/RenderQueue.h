@@ -0,0 +1,130 @@
+/*******************************************
+	RenderQueue.h
+
+	Collects sub-mesh draws for a frame, sorts
+	them to minimise state changes and merges
+	repeated sub-meshes into instanced draws
+********************************************/
+
+#pragma once
+
+#include <vector>
+using namespace std;
+
+#include "../Common/Defines.h"
+#include "../Math/CMatrix4x4.h"
+#include "RenderMethod.h"
+#include "RenderBackend.h"
+
+namespace gen
+{
+
+class CMesh;
+
+class CRenderQueue
+{
+public:
+	/////////////////////////////////////
+	// Types
+
+	// A single sub-mesh to draw. The world matrix is not copied - it must remain valid until the
+	// queue is flushed
+	struct SDrawPacket
+	{
+		TUInt64           sortKey;
+		CMesh*            mesh;
+		const CMatrix4x4* worldMatrix;
+	};
+
+
+	/////////////////////////////////////
+	// Sort keys
+
+	// Packets are sorted by a 64-bit key, most significant field first: render method (technique),
+	// mesh, material, level of detail, sub-mesh. Materials belong to a mesh, so the mesh comes before
+	// the material. Packets with equal keys draw the same geometry in the same way and become one
+	// instanced draw. The level of detail and sub-mesh share the low 16 bits (4 and 12 bits)
+	static TUInt64 MakeSortKey( ERenderMethod method, TUInt32 meshID, TUInt32 material, TUInt32 subMesh,
+	                            TUInt32 lod = 0 )
+	{
+		return (static_cast<TUInt64>(method & 0xff) << 56) | (static_cast<TUInt64>(meshID & 0xffffff) << 32) |
+		       (static_cast<TUInt64>(material & 0xffff) << 16) | (static_cast<TUInt64>(lod & 0xf) << 12) |
+		       static_cast<TUInt64>(subMesh & 0xfff);
+	}
+
+	static ERenderMethod SortKeyMethod( TUInt64 key )
+	{
+		return static_cast<ERenderMethod>(key >> 56);
+	}
+	static TUInt32 SortKeyMaterial( TUInt64 key )
+	{
+		return static_cast<TUInt32>(key >> 16) & 0xffff;
+	}
+	static TUInt32 SortKeyLod( TUInt64 key )
+	{
+		return (static_cast<TUInt32>(key) >> 12) & 0xf;
+	}
+	static TUInt32 SortKeySubMesh( TUInt64 key )
+	{
+		return static_cast<TUInt32>(key) & 0xfff;
+	}
+
+
+	/////////////////////////////////////
+	// Constructor
+
+	CRenderQueue() {}
+
+
+	/////////////////////////////////////
+	// Submission
+
+	// Add a sub-mesh draw to the queue at the given level of detail. The mesh ID is any number
+	// unique to the mesh (see CMesh::GetMeshID) - the mesh pointer itself is only passed on to the
+	// backend
+	void Submit( ERenderMethod method, TUInt32 meshID, TUInt32 material, TUInt32 subMesh, TUInt32 lod,
+	             CMesh* mesh, const CMatrix4x4* worldMatrix )
+	{
+		SDrawPacket packet = { MakeSortKey( method, meshID, material, subMesh, lod ), mesh, worldMatrix };
+		m_Packets.push_back( packet );
+	}
+
+	TUInt32 NumPackets()
+	{
+		return static_cast<TUInt32>(m_Packets.size());
+	}
+
+	const vector<SDrawPacket>& Packets()
+	{
+		return m_Packets;
+	}
+
+	// Remove all packets without drawing them
+	void Clear()
+	{
+		m_Packets.clear();
+	}
+
+
+	/////////////////////////////////////
+	// Drawing
+
+	// Sort the packets by key
+	void Sort();
+
+	// Sort the packets then send them to the given backend, changing technique, material and
+	// geometry only when they differ from the previous draw. Runs of packets with the same key are
+	// sent as one draw with several world matrices. The queue is empty afterwards
+	void Flush( IRenderBackend* backend );
+
+
+private:
+	vector<SDrawPacket> m_Packets;
+
+	// World matrices for the current instanced draw gathered together. Kept between frames to
+	// avoid reallocation
+	vector<CMatrix4x4>  m_InstanceMatrices;
+};
+
+
+} // namespace gen
@@ -14,9 +14,23 @@ float4x4 WorldMatrix;
 float4x4 ViewMatrix;
 float4x4 ProjMatrix;
 
+// World matrices for instanced rendering - each instance in a batch selects its matrix with SV_InstanceID.
+// The array size must match kMaxInstances in RenderMethod.h
+#define MAX_INSTANCES 64
+cbuffer InstanceData
+{
+	float4x4 InstanceWorldMatrices[MAX_INSTANCES];
+};
+
 // Camera position (needed for specular lighting at least)
 float3 CameraPos;
 
+// Decoding of compressed vertices (see VertexCompression.h). Positions may be stored 0->1 over the
+// bounding box of the sub-mesh, and normals in octahedral form (x & y only)
+float3 PositionScale = { 1.0f, 1.0f, 1.0f };
+float3 PositionOffset = { 0.0f, 0.0f, 0.0f };
+bool   OctahedralNormals = false;
+
 // Light data
 float3 Light1Pos;
 float3 Light2Pos;
@@ -87,35 +101,72 @@ struct VS_LIGHTINGTEX_OUTPUT
 };
 
 
+//--------------------------------------------------------------------------------------
+// Vertex Decoding
+//--------------------------------------------------------------------------------------
+
+// Model space position from a vertex position, which may be relative to the sub-mesh bounding box
+float3 DecodePosition( float3 pos )
+{
+	return pos * PositionScale + PositionOffset;
+}
+
+// Model space normal from a vertex normal, which may be in octahedral form. Folds the lower half
+// of the octahedron back out, matching DecodeOctahedral in VertexCompression.cpp
+float3 DecodeNormal( float3 normal )
+{
+	if (OctahedralNormals)
+	{
+		normal = float3(normal.xy, 1.0f - abs(normal.x) - abs(normal.y));
+		float fold = saturate( -normal.z );
+		normal.xy += (normal.xy >= 0.0f) ? -fold : fold;
+		normal = normalize( normal );
+	}
+	return normal;
+}
+
+
 //--------------------------------------------------------------------------------------
 // Vertex Shaders
 //--------------------------------------------------------------------------------------
 
 // Basic vertex shader to transform 3D model vertices to 2D only
 //
-VS_BASIC_OUTPUT VSTransformOnly( VS_INPUT vIn )
+VS_BASIC_OUTPUT VSTransformOnlyCommon( VS_INPUT vIn, float4x4 worldMatrix )
 {
 	VS_BASIC_OUTPUT vOut;
 	
 	// Transform the input model vertex position into world space, then view space, then 2D projection space
-	float4 modelPos = float4(vIn.Pos, 1.0f); // Promote to 1x4 so we can multiply by 4x4 matrix, put 1.0 in 4th element for a point (0.0 for a vector)
-	float4 worldPos = mul( modelPos, WorldMatrix );
+	float4 modelPos = float4(DecodePosition( vIn.Pos ), 1.0f); // Promote to 1x4 so we can multiply by 4x4 matrix, put 1.0 in 4th element for a point (0.0 for a vector)
+	float4 worldPos = mul( modelPos, worldMatrix );
 	float4 viewPos  = mul( worldPos, ViewMatrix );
 	vOut.ProjPos    = mul( viewPos,  ProjMatrix );
 
 	return vOut;
 }
 
+// Single model version, using WorldMatrix
+VS_BASIC_OUTPUT VSTransformOnly( VS_INPUT vIn )
+{
+	return VSTransformOnlyCommon( vIn, WorldMatrix );
+}
+
+// Instanced version, using the matrix for this instance from InstanceWorldMatrices
+VS_BASIC_OUTPUT VSTransformOnlyInstanced( VS_INPUT vIn, uint instance : SV_InstanceID )
+{
+	return VSTransformOnlyCommon( vIn, InstanceWorldMatrices[instance] );
+}
+
 
 // Basic vertex shader to transform 3D model vertices to 2D and pass UVs to the pixel shader
 //
-VS_TEX_OUTPUT VSTransformTex( VS_INPUT vIn )
+VS_TEX_OUTPUT VSTransformTexCommon( VS_INPUT vIn, float4x4 worldMatrix )
 {
 	VS_TEX_OUTPUT vOut;
 	
 	// Transform the input model vertex position into world space, then view space, then 2D projection space
-	float4 modelPos = float4(vIn.Pos, 1.0f); // Promote to 1x4 so we can multiply by 4x4 matrix, put 1.0 in 4th element for a point (0.0 for a vector)
-	float4 worldPos = mul( modelPos, WorldMatrix );
+	float4 modelPos = float4(DecodePosition( vIn.Pos ), 1.0f); // Promote to 1x4 so we can multiply by 4x4 matrix, put 1.0 in 4th element for a point (0.0 for a vector)
+	float4 worldPos = mul( modelPos, worldMatrix );
 	float4 viewPos  = mul( worldPos, ViewMatrix );
 	vOut.ProjPos    = mul( viewPos,  ProjMatrix );
 	
@@ -125,20 +176,32 @@ VS_TEX_OUTPUT VSTransformTex( VS_INPUT vIn )
 	return vOut;
 }
 
+// Single model version, using WorldMatrix
+VS_TEX_OUTPUT VSTransformTex( VS_INPUT vIn )
+{
+	return VSTransformTexCommon( vIn, WorldMatrix );
+}
+
+// Instanced version, using the matrix for this instance from InstanceWorldMatrices
+VS_TEX_OUTPUT VSTransformTexInstanced( VS_INPUT vIn, uint instance : SV_InstanceID )
+{
+	return VSTransformTexCommon( vIn, InstanceWorldMatrices[instance] );
+}
+
 
 // Standard vertex shader for pixel-lit untextured models
 //
-VS_LIGHTING_OUTPUT VSPixelLit( VS_INPUT vIn )
+VS_LIGHTING_OUTPUT VSPixelLitCommon( VS_INPUT vIn, float4x4 worldMatrix )
 {
 	VS_LIGHTING_OUTPUT vOut;
 
 	// Add 4th element to position and normal (needed to multiply by 4x4 matrix. Recall lectures - set 1 for position, 0 for vector)
-	float4 modelPos = float4(vIn.Pos, 1.0f);
-	float4 modelNormal = float4(vIn.Normal, 0.0f);
+	float4 modelPos = float4(DecodePosition( vIn.Pos ), 1.0f);
+	float4 modelNormal = float4(DecodeNormal( vIn.Normal ), 0.0f);
 
 	// Transform model vertex position and normal to world space
-	float4 worldPos    = mul( modelPos,    WorldMatrix );
-	float3 worldNormal = mul( modelNormal, WorldMatrix ).xyz;
+	float4 worldPos    = mul( modelPos,    worldMatrix );
+	float3 worldNormal = mul( modelNormal, worldMatrix ).xyz;
 
 	// Pass world space position & normal to pixel shader for lighting calculations
    	vOut.WorldPos    = worldPos.xyz;
@@ -151,19 +214,31 @@ VS_LIGHTING_OUTPUT VSPixelLit( VS_INPUT vIn )
 	return vOut;
 }
 
+// Single model version, using WorldMatrix
+VS_LIGHTING_OUTPUT VSPixelLit( VS_INPUT vIn )
+{
+	return VSPixelLitCommon( vIn, WorldMatrix );
+}
+
+// Instanced version, using the matrix for this instance from InstanceWorldMatrices
+VS_LIGHTING_OUTPUT VSPixelLitInstanced( VS_INPUT vIn, uint instance : SV_InstanceID )
+{
+	return VSPixelLitCommon( vIn, InstanceWorldMatrices[instance] );
+}
+
 // Standard vertex shader for pixel-lit textured models
 //
-VS_LIGHTINGTEX_OUTPUT VSPixelLitTex( VS_INPUT vIn )
+VS_LIGHTINGTEX_OUTPUT VSPixelLitTexCommon( VS_INPUT vIn, float4x4 worldMatrix )
 {
 	VS_LIGHTINGTEX_OUTPUT vOut;
 
 	// Add 4th element to position and normal (needed to multiply by 4x4 matrix. Recall lectures - set 1 for position, 0 for vector)
-	float4 modelPos = float4(vIn.Pos, 1.0f);
-	float4 modelNormal = float4(vIn.Normal, 0.0f);
+	float4 modelPos = float4(DecodePosition( vIn.Pos ), 1.0f);
+	float4 modelNormal = float4(DecodeNormal( vIn.Normal ), 0.0f);
 
 	// Transform model vertex position and normal to world space
-	float4 worldPos    = mul( modelPos,    WorldMatrix );
-	float3 worldNormal = mul( modelNormal, WorldMatrix ).xyz;
+	float4 worldPos    = mul( modelPos,    worldMatrix );
+	float3 worldNormal = mul( modelNormal, worldMatrix ).xyz;
 
 	// Pass world space position & normal to pixel shader for lighting calculations
    	vOut.WorldPos    = worldPos.xyz;
@@ -179,6 +254,18 @@ VS_LIGHTINGTEX_OUTPUT VSPixelLitTex( VS_INPUT vIn )
 	return vOut;
 }
 
+// Single model version, using WorldMatrix
+VS_LIGHTINGTEX_OUTPUT VSPixelLitTex( VS_INPUT vIn )
+{
+	return VSPixelLitTexCommon( vIn, WorldMatrix );
+}
+
+// Instanced version, using the matrix for this instance from InstanceWorldMatrices
+VS_LIGHTINGTEX_OUTPUT VSPixelLitTexInstanced( VS_INPUT vIn, uint instance : SV_InstanceID )
+{
+	return VSPixelLitTexCommon( vIn, InstanceWorldMatrices[instance] );
+}
+
 
 //--------------------------------------------------------------------------------------
 // Pixel Shaders
@@ -493,3 +580,81 @@ technique10 CutoutPixelLitTex
 		SetDepthStencilState(DepthWritesOn, 0);
 	}
 }
+
+
+// Instanced versions of the techniques above - identical states and pixel shaders, but the vertex
+// shaders take each world matrix from InstanceWorldMatrices. Used for batches of the same mesh
+technique10 PlainColourInstanced
+{
+    pass P0
+    {
+        SetVertexShader( CompileShader( vs_4_0, VSTransformOnlyInstanced() ) );
+        SetGeometryShader( NULL );                                   
+        SetPixelShader( CompileShader( ps_4_0, PSPlainColour() ) );
+
+		// Switch off blending states
+		SetBlendState( NoBlending, float4( 0.0f, 0.0f, 0.0f, 0.0f ), 0xFFFFFFFF );
+		SetRasterizerState( CullBack ); 
+		SetDepthStencilState( DepthWritesOn, 0 );
+     }
+}
+
+technique10 TexColourInstanced
+{
+    pass P0
+    {
+        SetVertexShader( CompileShader( vs_4_0, VSTransformTexInstanced() ) );
+        SetGeometryShader( NULL );                                   
+        SetPixelShader( CompileShader( ps_4_0, PSTexColour() ) );
+
+		// Switch off blending states
+		SetBlendState( NoBlending, float4( 0.0f, 0.0f, 0.0f, 0.0f ), 0xFFFFFFFF );
+		SetRasterizerState( CullBack ); 
+		SetDepthStencilState( DepthWritesOn, 0 );
+     }
+}
+
+technique10 PixelLitInstanced
+{
+    pass P0
+    {
+        SetVertexShader( CompileShader( vs_4_0, VSPixelLitInstanced() ) );
+        SetGeometryShader( NULL );                                   
+        SetPixelShader( CompileShader( ps_4_0, PSPixelLit() ) );
+
+		// Switch off blending states
+		SetBlendState( NoBlending, float4( 0.0f, 0.0f, 0.0f, 0.0f ), 0xFFFFFFFF );
+		SetRasterizerState( CullBack ); 
+		SetDepthStencilState( DepthWritesOn, 0 );
+	}
+}
+
+technique10 PixelLitTexInstanced
+{
+    pass P0
+    {
+        SetVertexShader( CompileShader( vs_4_0, VSPixelLitTexInstanced() ) );
+        SetGeometryShader( NULL );                                   
+        SetPixelShader( CompileShader( ps_4_0, PSPixelLitTex() ) );
+
+		// Switch off blending states
+		SetBlendState( NoBlending, float4( 0.0f, 0.0f, 0.0f, 0.0f ), 0xFFFFFFFF );
+		SetRasterizerState( CullBack ); 
+		SetDepthStencilState( DepthWritesOn, 0 );
+	}
+}
+
+technique10 CutoutPixelLitTexInstanced
+{
+	pass P0
+	{
+		SetVertexShader(CompileShader(vs_4_0, VSPixelLitTexInstanced()));
+		SetGeometryShader(NULL);
+		SetPixelShader(CompileShader(ps_4_0, PSCutoutPixelLitTex()));
+
+		// Switch off blending states
+		SetBlendState(NoBlending, float4(0.0f, 0.0f, 0.0f, 0.0f), 0xFFFFFFFF);
+		SetRasterizerState(CullNone); // Show both sides of cutout polygons
+		SetDepthStencilState(DepthWritesOn, 0);
+	}
+}
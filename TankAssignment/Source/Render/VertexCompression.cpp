@@ -0,0 +1,321 @@
+/*******************************************
+	VertexCompression.cpp
+
+	Vertex compression implementation
+********************************************/
+
+#include <cstring>
+
+#include "VertexCompression.h"
+#include "../Math/BaseMath.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// Component encodings
+//-----------------------------------------------------------------------------
+
+// IEEE half float from a float, rounding to nearest (ties to even). Values too large become
+// infinity, values too small become zero
+TUInt16 FloatToHalf( TFloat32 value )
+{
+	TUInt32 bits;
+	memcpy( &bits, &value, sizeof(bits) );
+	TUInt32 sign = (bits >> 16) & 0x8000;
+	TUInt32 magnitude = bits & 0x7fffffff;
+
+	// Infinity and NaN keep their type, anything from 65536 up is infinity (65520 and up rounds to
+	// infinity below)
+	if (magnitude >= 0x7f800000)
+	{
+		return static_cast<TUInt16>(sign | 0x7c00 | (magnitude > 0x7f800000 ? 0x200 : 0));
+	}
+	if (magnitude >= 0x47800000)
+	{
+		return static_cast<TUInt16>(sign | 0x7c00);
+	}
+
+	// Below 2^-14 the half is denormal - shift the mantissa with its implicit 1 into place. Below
+	// 2^-25 it rounds to zero
+	if (magnitude < 0x38800000)
+	{
+		if (magnitude < 0x33000000)
+		{
+			return static_cast<TUInt16>(sign);
+		}
+		TUInt32 shift = 126 - (magnitude >> 23);
+		TUInt32 mantissa = (magnitude & 0x7fffff) | 0x800000;
+		TUInt32 result = mantissa >> shift;
+		TUInt32 remainder = mantissa & ((1u << shift) - 1);
+		TUInt32 halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (result & 1)))
+		{
+			++result;
+		}
+		return static_cast<TUInt16>(sign | result);
+	}
+
+	// Normal - rebias the exponent and round the mantissa to 10 bits. Rounding may carry into the
+	// exponent, which gives the correct result (up to infinity)
+	TUInt32 result = (magnitude - 0x38000000) >> 13;
+	TUInt32 remainder = magnitude & 0x1fff;
+	if (remainder > 0x1000 || (remainder == 0x1000 && (result & 1)))
+	{
+		++result;
+	}
+	return static_cast<TUInt16>(sign | result);
+}
+
+// Float from an IEEE half float (exact)
+TFloat32 HalfToFloat( TUInt16 half )
+{
+	TUInt32 sign = static_cast<TUInt32>(half & 0x8000) << 16;
+	TUInt32 exponent = (half >> 10) & 0x1f;
+	TUInt32 mantissa = half & 0x3ff;
+	TUInt32 bits;
+	if (exponent == 0x1f)
+	{
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else if (exponent != 0)
+	{
+		bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+	}
+	else if (mantissa == 0)
+	{
+		bits = sign;
+	}
+	else
+	{
+		// Denormal half - normalise for the float's wider exponent
+		exponent = 113;
+		while (!(mantissa & 0x400))
+		{
+			mantissa <<= 1;
+			--exponent;
+		}
+		bits = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+	}
+
+	TFloat32 value;
+	memcpy( &value, &bits, sizeof(value) );
+	return value;
+}
+
+
+// Signed / unsigned normalised 16-bit values, rounding to nearest. The GPU reads these back as
+// value / 32767 (clamped to -1) and value / 65535
+static inline TInt16 ToSNorm16( TFloat32 value )
+{
+	value = Min( Max( value, -1.0f ), 1.0f ) * 32767.0f;
+	return static_cast<TInt16>(value >= 0.0f ? value + 0.5f : value - 0.5f);
+}
+static inline TUInt16 ToUNorm16( TFloat32 value )
+{
+	return static_cast<TUInt16>(Min( Max( value, 0.0f ), 1.0f ) * 65535.0f + 0.5f);
+}
+
+// Unit vector to octahedral form: the vector is projected onto the octahedron |x|+|y|+|z| = 1,
+// and the lower half folded out over the corners of the upper half's square. Decoded in the same
+// way by the shaders (see TankAssignment.fx)
+void EncodeOctahedral( const CVector3& unitVector, TInt16* encoded )
+{
+	TFloat32 l1 = Abs( unitVector.x ) + Abs( unitVector.y ) + Abs( unitVector.z );
+	if (l1 <= 0.0f)
+	{
+		encoded[0] = encoded[1] = 0;
+		return;
+	}
+	TFloat32 u = unitVector.x / l1;
+	TFloat32 v = unitVector.y / l1;
+	if (unitVector.z < 0.0f)
+	{
+		TFloat32 foldedU = (1.0f - Abs( v )) * (u >= 0.0f ? 1.0f : -1.0f);
+		TFloat32 foldedV = (1.0f - Abs( u )) * (v >= 0.0f ? 1.0f : -1.0f);
+		u = foldedU;
+		v = foldedV;
+	}
+	encoded[0] = ToSNorm16( u );
+	encoded[1] = ToSNorm16( v );
+}
+
+// Unit vector from octahedral form
+CVector3 DecodeOctahedral( const TInt16* encoded )
+{
+	CVector3 vector( Max( encoded[0] / 32767.0f, -1.0f ), Max( encoded[1] / 32767.0f, -1.0f ), 0.0f );
+	vector.z = 1.0f - Abs( vector.x ) - Abs( vector.y );
+	TFloat32 fold = Max( -vector.z, 0.0f );
+	vector.x += (vector.x >= 0.0f) ? -fold : fold;
+	vector.y += (vector.y >= 0.0f) ? -fold : fold;
+	vector.Normalise();
+	return vector;
+}
+
+
+//-----------------------------------------------------------------------------
+// Sub-mesh compression
+//-----------------------------------------------------------------------------
+
+// Test if all texture coordinates of a sub-mesh can be stored accurately as half floats
+static bool TextureCoordsFitHalf( const SSubMesh& subMesh, TUInt32 offset )
+{
+	const TUInt8* vertex = subMesh.vertices + offset;
+	for (TUInt32 vert = 0; vert < subMesh.numVertices; ++vert, vertex += subMesh.vertexSize)
+	{
+		const TFloat32* uv = reinterpret_cast<const TFloat32*>(vertex);
+		if (Abs( uv[0] ) > kMaxHalfTextureCoord || Abs( uv[1] ) > kMaxHalfTextureCoord)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Get the layout of a sub-mesh's vertices compressed as requested. Positions are stored relative
+// to the given bounds of the sub-mesh
+void GetCompressedLayout( const SSubMesh& subMesh, const SMeshBounds& bounds,
+                          const SVertexCompression& compression, SCompressedLayout* layout )
+{
+	const SVertexLayout source = GetVertexLayout( subMesh );
+	layout->compression.positions = compression.positions;
+	layout->compression.normals = compression.normals && (subMesh.hasNormals || subMesh.hasTangents);
+	layout->compression.textureCoords = compression.textureCoords && subMesh.hasTextureCoords &&
+	                                    TextureCoordsFitHalf( subMesh, source.textureCoord );
+
+	// Components in the same order as the source, see SVertexLayout
+	TUInt32 offset = 0;
+	SVertexLayout& offsets = layout->offsets;
+	offsets.position = offset;
+	offset += layout->compression.positions ? 4 * sizeof(TUInt16) : 3 * sizeof(TFloat32);
+	offsets.skinning = subMesh.hasSkinningData ? offset : kNoVertexComponent;
+	offset += subMesh.hasSkinningData ? 4 * sizeof(TFloat32) + sizeof(TUInt32) : 0;
+	const TUInt32 directionSize = layout->compression.normals ? 2 * sizeof(TInt16) : 3 * sizeof(TFloat32);
+	offsets.normal = subMesh.hasNormals ? offset : kNoVertexComponent;
+	offset += subMesh.hasNormals ? directionSize : 0;
+	offsets.tangent = subMesh.hasTangents ? offset : kNoVertexComponent;
+	offset += subMesh.hasTangents ? directionSize : 0;
+	offsets.textureCoord = subMesh.hasTextureCoords ? offset : kNoVertexComponent;
+	offset += subMesh.hasTextureCoords ? (layout->compression.textureCoords ? 2 * sizeof(TUInt16) : 2 * sizeof(TFloat32)) : 0;
+	offsets.colour = subMesh.hasVertexColours ? offset : kNoVertexComponent;
+	offset += subMesh.hasVertexColours ? 4 : 0;
+	layout->vertexSize = offset;
+
+	if (layout->compression.positions)
+	{
+		layout->positionOffset = bounds.minBounds;
+		layout->positionScale = bounds.maxBounds - bounds.minBounds;
+	}
+	else
+	{
+		layout->positionOffset = CVector3::kZero;
+		layout->positionScale = CVector3( 1.0f, 1.0f, 1.0f );
+	}
+}
+
+// Store a direction (normal or tangent) as three floats or in octahedral form
+static inline void CompressDirection( const TUInt8* source, bool octahedral, TUInt8* output )
+{
+	if (octahedral)
+	{
+		TInt16 encoded[2];
+		EncodeOctahedral( CVector3( reinterpret_cast<const TFloat32*>(source) ), encoded );
+		memcpy( output, encoded, sizeof(encoded) );
+	}
+	else
+	{
+		memcpy( output, source, 3 * sizeof(TFloat32) );
+	}
+}
+
+// Compress the vertices of a sub-mesh into the given layout. The output must have space for
+// numVertices * layout.vertexSize bytes
+void CompressVertices( const SSubMesh& subMesh, const SCompressedLayout& layout, TUInt8* output )
+{
+	const SVertexLayout source = GetVertexLayout( subMesh );
+	const SVertexLayout& target = layout.offsets;
+	const SVertexCompression& compression = layout.compression;
+
+	// Reciprocal of the box size for positions, 0 on axes where the box is flat
+	CVector3 positionScale;
+	positionScale.x = (layout.positionScale.x > 0.0f) ? 1.0f / layout.positionScale.x : 0.0f;
+	positionScale.y = (layout.positionScale.y > 0.0f) ? 1.0f / layout.positionScale.y : 0.0f;
+	positionScale.z = (layout.positionScale.z > 0.0f) ? 1.0f / layout.positionScale.z : 0.0f;
+
+	const TUInt8* vertex = subMesh.vertices;
+	for (TUInt32 vert = 0; vert < subMesh.numVertices; ++vert)
+	{
+		if (compression.positions)
+		{
+			const TFloat32* position = reinterpret_cast<const TFloat32*>(vertex + source.position);
+			TUInt16 encoded[4] =
+			{
+				ToUNorm16( (position[0] - layout.positionOffset.x) * positionScale.x ),
+				ToUNorm16( (position[1] - layout.positionOffset.y) * positionScale.y ),
+				ToUNorm16( (position[2] - layout.positionOffset.z) * positionScale.z ),
+				0
+			};
+			memcpy( output + target.position, encoded, sizeof(encoded) );
+		}
+		else
+		{
+			memcpy( output + target.position, vertex + source.position, 3 * sizeof(TFloat32) );
+		}
+
+		if (subMesh.hasSkinningData)
+		{
+			memcpy( output + target.skinning, vertex + source.skinning, 4 * sizeof(TFloat32) + sizeof(TUInt32) );
+		}
+		if (subMesh.hasNormals)
+		{
+			CompressDirection( vertex + source.normal, compression.normals, output + target.normal );
+		}
+		if (subMesh.hasTangents)
+		{
+			CompressDirection( vertex + source.tangent, compression.normals, output + target.tangent );
+		}
+
+		if (subMesh.hasTextureCoords)
+		{
+			if (compression.textureCoords)
+			{
+				const TFloat32* uv = reinterpret_cast<const TFloat32*>(vertex + source.textureCoord);
+				TUInt16 encoded[2] = { FloatToHalf( uv[0] ), FloatToHalf( uv[1] ) };
+				memcpy( output + target.textureCoord, encoded, sizeof(encoded) );
+			}
+			else
+			{
+				memcpy( output + target.textureCoord, vertex + source.textureCoord, 2 * sizeof(TFloat32) );
+			}
+		}
+
+		if (subMesh.hasVertexColours)
+		{
+			const TFloat32* colour = reinterpret_cast<const TFloat32*>(vertex + source.colour);
+			for (TUInt32 component = 0; component < 4; ++component)
+			{
+				output[target.colour + component] =
+					static_cast<TUInt8>(Min( Max( colour[component], 0.0f ), 1.0f ) * 255.0f + 0.5f);
+			}
+		}
+
+		vertex += subMesh.vertexSize;
+		output += layout.vertexSize;
+	}
+}
+
+// Copy just the positions of a sub-mesh's vertices (x, y, z floats) to the output, which must
+// have space for numVertices * 3 floats
+void ExtractPositions( const SSubMesh& subMesh, TFloat32* output )
+{
+	const TUInt8* position = subMesh.vertices + GetVertexLayout( subMesh ).position;
+	for (TUInt32 vert = 0; vert < subMesh.numVertices; ++vert)
+	{
+		memcpy( output, position, 3 * sizeof(TFloat32) );
+		position += subMesh.vertexSize;
+		output += 3;
+	}
+}
+
+
+} // namespace gen
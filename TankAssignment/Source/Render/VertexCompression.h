@@ -0,0 +1,78 @@
+/*******************************************
+	VertexCompression.h
+
+	Compact encodings of sub-mesh vertices for
+	the GPU copy of a mesh: 16-bit positions
+	relative to the sub-mesh bounding box,
+	octahedral normals and tangents in two
+	16-bit values, and half float UVs. The
+	shaders decode positions and normals
+********************************************/
+
+#pragma once
+
+#include "../Common/Defines.h"
+#include "../Math/CVector3.h"
+#include "MeshData.h"
+#include "MeshBounds.h"
+
+namespace gen
+{
+
+// Which vertex components to store compactly. Components not selected are kept as floats
+struct SVertexCompression
+{
+	bool positions;     // 16-bit unsigned normalised x, y, z (+ padding) over the sub-mesh box
+	bool normals;       // Normals and tangents as octahedral 16-bit signed normalised x, y
+	bool textureCoords; // Half float u, v - only used where all UVs are in the accurate range
+};
+
+// No compression - vertices are sent to the GPU as imported (vertex colours excepted, below)
+const SVertexCompression kNoVertexCompression = { false, false, false };
+
+// Half floats keep UVs accurate to half a texel of a 1024 texture up to this size
+const TFloat32 kMaxHalfTextureCoord = 2.0f;
+
+
+// The layout of a sub-mesh's vertices once compressed. Vertex colours are always stored as four
+// bytes (0-255 per component) - the form the GPU is asked to read them in
+struct SCompressedLayout
+{
+	SVertexLayout offsets;
+	TUInt32       vertexSize;
+
+	// Compression used for this sub-mesh, which may be less than requested
+	SVertexCompression compression;
+
+	// Decoding of positions: position = (stored value 0->1) * scale + offset
+	CVector3      positionScale;
+	CVector3      positionOffset;
+};
+
+// Get the layout of a sub-mesh's vertices compressed as requested. Positions are stored relative
+// to the given bounds of the sub-mesh
+void GetCompressedLayout( const SSubMesh& subMesh, const SMeshBounds& bounds,
+                          const SVertexCompression& compression, SCompressedLayout* layout );
+
+// Compress the vertices of a sub-mesh into the given layout. The output must have space for
+// numVertices * layout.vertexSize bytes
+void CompressVertices( const SSubMesh& subMesh, const SCompressedLayout& layout, TUInt8* output );
+
+// Copy just the positions of a sub-mesh's vertices (x, y, z floats) to the output, which must
+// have space for numVertices * 3 floats
+void ExtractPositions( const SSubMesh& subMesh, TFloat32* output );
+
+
+/////////////////////////////////////
+// Component encodings
+
+// IEEE half float conversions, rounding to nearest
+TUInt16  FloatToHalf( TFloat32 value );
+TFloat32 HalfToFloat( TUInt16 half );
+
+// Unit vector to / from octahedral form in two signed normalised 16-bit values
+void     EncodeOctahedral( const CVector3& unitVector, TInt16* encoded );
+CVector3 DecodeOctahedral( const TInt16* encoded );
+
+
+} // namespace gen
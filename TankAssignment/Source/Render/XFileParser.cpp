@@ -0,0 +1,944 @@
+/*******************************************
+	XFileParser.cpp
+
+	Streaming .x file parser implementation
+********************************************/
+
+#include <cstring>
+#include <cmath>
+
+#include "XFileParser.h"
+#include "../Math/BaseMath.h"
+
+namespace gen
+{
+
+// All .x files start with a 16 byte header, e.g. "xof 0303txt 0032"
+static const TUInt32 kHeaderSize = 16;
+
+// Mantissa digits beyond this are not stored when parsing text numbers (leaves room to multiply
+// by 10 without overflow, and is well beyond float precision)
+static const TUInt64 kMaxTextMantissa = 100000000000000000ull;
+
+
+//-----------------------------------------------------------------------------
+// Character and number support
+//-----------------------------------------------------------------------------
+
+static bool IsDigit( TUInt8 c )
+{
+	return c >= '0' && c <= '9';
+}
+
+static bool IsNameStart( TUInt8 c )
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+// Names may contain any printable character other than the text format's punctuation
+static bool IsNameChar( TUInt8 c )
+{
+	return c > ' ' && c != '{' && c != '}' && c != '<' && c != '>' && c != ';' && c != ',' && c != '"';
+}
+
+// Characters that can appear in a number, used to skip unread numbers
+static bool IsNumberChar( TUInt8 c )
+{
+	return IsDigit( c ) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+static TFloat64 PowerOf10( TInt32 power )
+{
+	// Powers up to 22 are exact in a double
+	static const TFloat64 kPowers[] =
+	{
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	return (power <= 22) ? kPowers[power] : pow( 10.0, power );
+}
+
+static TUInt32 ReadLittleEndian( const TUInt8* data, TUInt32 size )
+{
+	TUInt32 value = 0;
+	for (TUInt32 byte = 0; byte < size; ++byte)
+	{
+		value |= static_cast<TUInt32>(data[byte]) << (byte * 8);
+	}
+	return value;
+}
+
+
+//-----------------------------------------------------------------------------
+// Object support
+//-----------------------------------------------------------------------------
+
+// Test the object's template name
+bool SXFileObject::IsType( const char* templateName ) const
+{
+	return strlen( templateName ) == typeLength && memcmp( type, templateName, typeLength ) == 0;
+}
+
+// Copy of the object name
+string SXFileObject::Name() const
+{
+	return string( name, nameLength );
+}
+
+
+//-----------------------------------------------------------------------------
+// Constructor / destructor
+//-----------------------------------------------------------------------------
+
+CXFileParser::CXFileParser()
+{
+	m_Position = 0;
+	m_End = 0;
+	m_Binary = false;
+	m_FloatSize = 4;
+	m_Failed = false;
+	m_ListToken = 0;
+	m_ListCount = 0;
+	m_Depth = 0;
+}
+
+CXFileParser::~CXFileParser()
+{
+	Close();
+}
+
+
+//-----------------------------------------------------------------------------
+// Public interface
+//-----------------------------------------------------------------------------
+
+// Map the given file and read its header. Only uncompressed text and binary files are supported.
+// Returns false on failure
+bool CXFileParser::Open( const string& fileName )
+{
+	Close();
+	if (!m_File.Open( fileName ) || m_File.Size() < kHeaderSize)
+	{
+		Close();
+		return false;
+	}
+
+	// Header is "xof ", a 4 digit version, the format and the float size in bits
+	const char* header = reinterpret_cast<const char*>(m_File.Data());
+	bool text = (memcmp( header + 8, "txt ", 4 ) == 0);
+	bool binary = (memcmp( header + 8, "bin ", 4 ) == 0);
+	bool floats64 = (memcmp( header + 12, "0064", 4 ) == 0);
+	if (memcmp( header, "xof ", 4 ) != 0 || (!text && !binary) ||
+	    (!floats64 && memcmp( header + 12, "0032", 4 ) != 0))
+	{
+		Close();
+		return false;
+	}
+
+	m_Binary = binary;
+	m_FloatSize = floats64 ? 8 : 4;
+	m_Position = m_File.Data() + kHeaderSize;
+	m_End = m_File.Data() + m_File.Size();
+	return true;
+}
+
+// Unmap the file - any objects returned are no longer valid
+void CXFileParser::Close()
+{
+	m_File.Close();
+	m_Position = 0;
+	m_End = 0;
+	m_Failed = false;
+	m_ListCount = 0;
+	m_Depth = 0;
+	m_NamedObjects.clear();
+	m_ReturnPoints.clear();
+}
+
+
+// Move to the next child object of the current object (or the next top-level object if none has
+// been entered), skipping any unread data members. Returns false when the current object has no
+// more children, which moves back to its parent, or at the end of the file, or on failure
+bool CXFileParser::NextObject( SXFileObject* object )
+{
+	if (m_Failed || !m_File.IsOpen())
+	{
+		return false;
+	}
+
+	if (m_Binary)
+	{
+		// Skip rest of any number list being read - its size was checked when it was started
+		m_Position += m_ListCount * (m_ListToken == kTokenFloatList ? m_FloatSize : 4);
+		m_ListCount = 0;
+
+		while (true)
+		{
+			if (m_Position == m_End)
+			{
+				return (m_Depth == 0) ? false : Fail();
+			}
+			TUInt32 token;
+			if (!ReadBinaryWord( &token ))
+			{
+				return false;
+			}
+
+			// Object - template name, optional object name, open brace, optional class GUID
+			if (token == kTokenName)
+			{
+				const char* type;
+				TUInt32 typeLength;
+				const char* name = 0;
+				TUInt32 nameLength = 0;
+				if (!ReadBinaryName( &type, &typeLength ) || !ReadBinaryWord( &token ))
+				{
+					return false;
+				}
+				if (token == kTokenName &&
+				    (!ReadBinaryName( &name, &nameLength ) || !ReadBinaryWord( &token )))
+				{
+					return false;
+				}
+				if (token != kTokenOpenBrace)
+				{
+					return Fail();
+				}
+				if (m_End - m_Position >= 2 && ReadLittleEndian( m_Position, 2 ) == kTokenGUID)
+				{
+					m_Position += 2;
+					if (!SkipBinaryToken( kTokenGUID ))
+					{
+						return false;
+					}
+				}
+				return EnterObject( type, typeLength, name, nameLength, object );
+			}
+
+			// Reference - open brace, name, optional GUID, close brace
+			else if (token == kTokenOpenBrace)
+			{
+				const char* name;
+				TUInt32 nameLength;
+				if (!ReadBinaryWord( &token ) || token != kTokenName ||
+				    !ReadBinaryName( &name, &nameLength ) || !ReadBinaryWord( &token ))
+				{
+					return Fail();
+				}
+				if (token == kTokenGUID && (!SkipBinaryToken( token ) || !ReadBinaryWord( &token )))
+				{
+					return false;
+				}
+				if (token != kTokenCloseBrace)
+				{
+					return Fail();
+				}
+				return EnterReference( name, nameLength, object );
+			}
+
+			else if (token == kTokenCloseBrace)
+			{
+				if (m_Depth == 0)
+				{
+					return Fail();
+				}
+				LeaveObject();
+				return false;
+			}
+
+			// Template definition - skipped
+			else if (token == kTokenTemplate)
+			{
+				if (!ReadBinaryWord( &token ) || token != kTokenName || !SkipBinaryToken( token ) ||
+				    !ReadBinaryWord( &token ) || token != kTokenOpenBrace || !SkipBinaryBlock())
+				{
+					return Fail();
+				}
+			}
+
+			// Unread data
+			else if (!SkipBinaryToken( token ))
+			{
+				return false;
+			}
+		}
+	}
+
+	while (true)
+	{
+		SkipTextSpace();
+		if (m_Position == m_End)
+		{
+			return (m_Depth == 0) ? false : Fail();
+		}
+
+		TUInt8 c = *m_Position;
+		if (c == '}')
+		{
+			++m_Position;
+			if (m_Depth == 0)
+			{
+				return Fail();
+			}
+			LeaveObject();
+			return false;
+		}
+
+		// Reference - name within braces, optionally followed by a GUID
+		else if (c == '{')
+		{
+			++m_Position;
+			SkipTextSpace();
+			const char* name;
+			TUInt32 nameLength;
+			if (!ReadTextName( &name, &nameLength ))
+			{
+				return false;
+			}
+			SkipTextSpace();
+			SkipTextGUID();
+			SkipTextSpace();
+			if (m_Position == m_End || *m_Position != '}')
+			{
+				return Fail();
+			}
+			++m_Position;
+			return EnterReference( name, nameLength, object );
+		}
+
+		// Object or template definition
+		else if (IsNameStart( c ))
+		{
+			const char* type;
+			TUInt32 typeLength;
+			ReadTextName( &type, &typeLength );
+			SkipTextSpace();
+
+			// Optional object name
+			const char* name = 0;
+			TUInt32 nameLength = 0;
+			if (m_Position < m_End && *m_Position != '{')
+			{
+				if (!ReadTextName( &name, &nameLength ))
+				{
+					return false;
+				}
+				SkipTextSpace();
+			}
+			if (m_Position == m_End || *m_Position != '{')
+			{
+				return Fail();
+			}
+			++m_Position;
+
+			if (typeLength == 8 && memcmp( type, "template", 8 ) == 0)
+			{
+				if (!SkipTextBlock())
+				{
+					return false;
+				}
+				continue;
+			}
+
+			// Optional class GUID
+			SkipTextSpace();
+			SkipTextGUID();
+			return EnterObject( type, typeLength, name, nameLength, object );
+		}
+
+		// Unread data - strings, GUIDs and numbers
+		else if (c == '"' || c == '<')
+		{
+			TUInt8 close = (c == '"') ? '"' : '>';
+			++m_Position;
+			while (m_Position < m_End && *m_Position != close)
+			{
+				++m_Position;
+			}
+			if (m_Position == m_End)
+			{
+				return Fail();
+			}
+			++m_Position;
+		}
+		else if (IsDigit( c ) || c == '-' || c == '+' || c == '.')
+		{
+			while (m_Position < m_End && IsNumberChar( *m_Position ))
+			{
+				++m_Position;
+			}
+		}
+		else
+		{
+			return Fail();
+		}
+	}
+}
+
+// Skip any unread data and children of the given object, which must be the current object or one
+// of its ancestors, moving back to its parent. Returns false on failure
+bool CXFileParser::EndObject( const SXFileObject& object )
+{
+	// Entering each child and returning false at each close brace steps through the nesting
+	SXFileObject child;
+	while (!m_Failed && m_Depth >= object.depth)
+	{
+		NextObject( &child );
+	}
+	return !m_Failed;
+}
+
+
+// Read data members of the current object. Each returns false on failure, or if the next member is
+// of a different type
+bool CXFileParser::ReadUInt( TUInt32* value )
+{
+	if (m_Failed || !m_File.IsOpen())
+	{
+		return false;
+	}
+
+	if (m_Binary)
+	{
+		if (m_ListCount == 0 && !StartBinaryList( kTokenIntegerList ))
+		{
+			return false;
+		}
+		if (m_ListToken != kTokenIntegerList)
+		{
+			return Fail();
+		}
+		*value = ReadLittleEndian( m_Position, 4 );
+		m_Position += 4;
+		--m_ListCount;
+		return true;
+	}
+
+	SkipTextSpace();
+	const TUInt8* position = m_Position;
+	if (position == m_End || !IsDigit( *position ))
+	{
+		return Fail();
+	}
+	TUInt64 number = 0;
+	while (position < m_End && IsDigit( *position ))
+	{
+		number = number * 10 + (*position - '0');
+		if (number > 0xffffffffu)
+		{
+			return Fail();
+		}
+		++position;
+	}
+	m_Position = position;
+	*value = static_cast<TUInt32>(number);
+	return true;
+}
+
+bool CXFileParser::ReadFloat( TFloat32* value )
+{
+	return ReadFloats( value, 1 );
+}
+
+bool CXFileParser::ReadFloats( TFloat32* values, TUInt32 count )
+{
+	if (m_Failed || !m_File.IsOpen())
+	{
+		return false;
+	}
+
+	if (!m_Binary)
+	{
+		for (TUInt32 i = 0; i < count; ++i)
+		{
+			if (!ReadTextFloat( &values[i] ))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Copy directly from the float lists in the file, which may be split across several lists
+	while (count > 0)
+	{
+		if (m_ListCount == 0 && !StartBinaryList( kTokenFloatList ))
+		{
+			return false;
+		}
+		if (m_ListToken != kTokenFloatList)
+		{
+			return Fail();
+		}
+		TUInt32 numFloats = Min( count, m_ListCount );
+		if (m_FloatSize == 4)
+		{
+			memcpy( values, m_Position, numFloats * 4 );
+			m_Position += numFloats * 4;
+		}
+		else
+		{
+			for (TUInt32 i = 0; i < numFloats; ++i)
+			{
+				TFloat64 doubleValue;
+				memcpy( &doubleValue, m_Position, 8 );
+				values[i] = static_cast<TFloat32>(doubleValue);
+				m_Position += 8;
+			}
+		}
+		values += numFloats;
+		count -= numFloats;
+		m_ListCount -= numFloats;
+	}
+	return true;
+}
+
+bool CXFileParser::ReadString( string* value )
+{
+	if (m_Failed || !m_File.IsOpen())
+	{
+		return false;
+	}
+
+	if (m_Binary)
+	{
+		// Strings are not in number lists, so must not be part way through one
+		if (m_ListCount != 0)
+		{
+			return Fail();
+		}
+		TUInt32 token;
+		do
+		{
+			if (!ReadBinaryWord( &token ))
+			{
+				return false;
+			}
+		} while (token == kTokenComma || token == kTokenSemicolon);
+
+		const char* text;
+		TUInt32 length;
+		if (token != kTokenString || !ReadBinaryName( &text, &length ))
+		{
+			return Fail();
+		}
+		while (length > 0 && text[length - 1] == '\0')
+		{
+			--length;
+		}
+		value->assign( text, length );
+		return true;
+	}
+
+	SkipTextSpace();
+	if (m_Position == m_End || *m_Position != '"')
+	{
+		return Fail();
+	}
+	const TUInt8* start = ++m_Position;
+	while (m_Position < m_End && *m_Position != '"')
+	{
+		++m_Position;
+	}
+	if (m_Position == m_End)
+	{
+		return Fail();
+	}
+	value->assign( reinterpret_cast<const char*>(start), m_Position - start );
+	++m_Position;
+	return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Text format support
+//-----------------------------------------------------------------------------
+
+// Skip white space, comments and separators. Commas and semicolons separate data members, but
+// data is read in the order the standard templates define so they carry no extra information
+void CXFileParser::SkipTextSpace()
+{
+	while (m_Position < m_End)
+	{
+		TUInt8 c = *m_Position;
+		if (c <= ' ' || c == ',' || c == ';')
+		{
+			++m_Position;
+		}
+		else if (c == '#' || (c == '/' && m_Position + 1 < m_End && m_Position[1] == '/'))
+		{
+			while (m_Position < m_End && *m_Position != '\n')
+			{
+				++m_Position;
+			}
+		}
+		else
+		{
+			break;
+		}
+	}
+}
+
+// Skip a GUID in angle brackets if there is one at the current position
+void CXFileParser::SkipTextGUID()
+{
+	if (m_Position < m_End && *m_Position == '<')
+	{
+		while (m_Position < m_End && *m_Position++ != '>');
+	}
+}
+
+bool CXFileParser::ReadTextName( const char** name, TUInt32* length )
+{
+	const TUInt8* start = m_Position;
+	while (m_Position < m_End && IsNameChar( *m_Position ))
+	{
+		++m_Position;
+	}
+	if (m_Position == start)
+	{
+		return Fail();
+	}
+	*name = reinterpret_cast<const char*>(start);
+	*length = static_cast<TUInt32>(m_Position - start);
+	return true;
+}
+
+// Parse a decimal number directly from the file - the standard library conversions need a
+// terminated string, but the mapped file may end part way through a number
+bool CXFileParser::ReadTextFloat( TFloat32* value )
+{
+	SkipTextSpace();
+	const TUInt8* position = m_Position;
+
+	bool negative = false;
+	if (position < m_End && (*position == '-' || *position == '+'))
+	{
+		negative = (*position == '-');
+		++position;
+	}
+
+	// Collect digits into an integer mantissa and a power of 10
+	TUInt64 mantissa = 0;
+	TInt32 exponent = 0;
+	TUInt32 numDigits = 0;
+	while (position < m_End && IsDigit( *position ))
+	{
+		if (mantissa < kMaxTextMantissa)
+		{
+			mantissa = mantissa * 10 + (*position - '0');
+		}
+		else
+		{
+			++exponent;
+		}
+		++numDigits;
+		++position;
+	}
+	if (position < m_End && *position == '.')
+	{
+		++position;
+		while (position < m_End && IsDigit( *position ))
+		{
+			if (mantissa < kMaxTextMantissa)
+			{
+				mantissa = mantissa * 10 + (*position - '0');
+				--exponent;
+			}
+			++numDigits;
+			++position;
+		}
+	}
+	if (numDigits == 0)
+	{
+		return Fail();
+	}
+
+	if (position < m_End && (*position == 'e' || *position == 'E'))
+	{
+		++position;
+		bool negativeExponent = false;
+		if (position < m_End && (*position == '-' || *position == '+'))
+		{
+			negativeExponent = (*position == '-');
+			++position;
+		}
+		if (position == m_End || !IsDigit( *position ))
+		{
+			return Fail();
+		}
+		TInt32 power = 0;
+		while (position < m_End && IsDigit( *position ))
+		{
+			if (power < 10000)
+			{
+				power = power * 10 + (*position - '0');
+			}
+			++position;
+		}
+		exponent += negativeExponent ? -power : power;
+	}
+	m_Position = position;
+
+	// A single multiply or divide by an exact power of 10 gives a correctly rounded result for
+	// all but very long mantissas
+	TFloat64 number = static_cast<TFloat64>(mantissa);
+	number = (exponent < 0) ? number / PowerOf10( -exponent ) : number * PowerOf10( exponent );
+	*value = static_cast<TFloat32>(negative ? -number : number);
+	return true;
+}
+
+// Skip to the end of a block whose opening brace has been read
+bool CXFileParser::SkipTextBlock()
+{
+	TUInt32 depth = 1;
+	while (m_Position < m_End)
+	{
+		TUInt8 c = *m_Position++;
+		if (c == '{')
+		{
+			++depth;
+		}
+		else if (c == '}')
+		{
+			if (--depth == 0)
+			{
+				return true;
+			}
+		}
+		else if (c == '"')
+		{
+			while (m_Position < m_End && *m_Position++ != '"');
+		}
+		else if (c == '#' || (c == '/' && m_Position < m_End && *m_Position == '/'))
+		{
+			while (m_Position < m_End && *m_Position != '\n')
+			{
+				++m_Position;
+			}
+		}
+	}
+	return Fail();
+}
+
+
+//-----------------------------------------------------------------------------
+// Binary format support
+//-----------------------------------------------------------------------------
+
+bool CXFileParser::ReadBinaryWord( TUInt32* value )
+{
+	if (m_End - m_Position < 2)
+	{
+		return Fail();
+	}
+	*value = ReadLittleEndian( m_Position, 2 );
+	m_Position += 2;
+	return true;
+}
+
+bool CXFileParser::ReadBinaryDWord( TUInt32* value )
+{
+	if (m_End - m_Position < 4)
+	{
+		return Fail();
+	}
+	*value = ReadLittleEndian( m_Position, 4 );
+	m_Position += 4;
+	return true;
+}
+
+// Read the count and characters of a name or string token
+bool CXFileParser::ReadBinaryName( const char** name, TUInt32* length )
+{
+	if (!ReadBinaryDWord( length ))
+	{
+		return false;
+	}
+	if (static_cast<TUInt32>(m_End - m_Position) < *length)
+	{
+		return Fail();
+	}
+	*name = reinterpret_cast<const char*>(m_Position);
+	m_Position += *length;
+	return true;
+}
+
+// Skip the data following a token that has been read
+bool CXFileParser::SkipBinaryToken( TUInt32 token )
+{
+	TUInt32 size = 0;
+	TUInt32 count;
+	switch (token)
+	{
+	case kTokenName:
+	case kTokenString:
+		if (!ReadBinaryDWord( &size ))
+		{
+			return false;
+		}
+		break;
+
+	case kTokenInteger:
+		size = 4;
+		break;
+
+	case kTokenGUID:
+		size = 16;
+		break;
+
+	case kTokenIntegerList:
+	case kTokenFloatList:
+	{
+		TUInt32 elementSize = (token == kTokenFloatList) ? m_FloatSize : 4;
+		if (!ReadBinaryDWord( &count ))
+		{
+			return false;
+		}
+		if (count > static_cast<TUInt32>(m_End - m_Position) / elementSize)
+		{
+			return Fail();
+		}
+		size = count * elementSize;
+		break;
+	}
+
+	default:
+		// All other tokens have no data
+		break;
+	}
+
+	if (static_cast<TUInt32>(m_End - m_Position) < size)
+	{
+		return Fail();
+	}
+	m_Position += size;
+	return true;
+}
+
+// Start reading the next list of numbers of the given kind, skipping separators. A single integer
+// token is treated as a list of one
+bool CXFileParser::StartBinaryList( TUInt32 listToken )
+{
+	while (true)
+	{
+		TUInt32 token;
+		if (!ReadBinaryWord( &token ))
+		{
+			return false;
+		}
+		if (token == kTokenComma || token == kTokenSemicolon)
+		{
+			continue;
+		}
+
+		if (token == kTokenInteger && listToken == kTokenIntegerList)
+		{
+			m_ListCount = 1;
+		}
+		else if (token != listToken || !ReadBinaryDWord( &m_ListCount ))
+		{
+			return Fail();
+		}
+
+		TUInt32 elementSize = (listToken == kTokenFloatList) ? m_FloatSize : 4;
+		if (m_ListCount > static_cast<TUInt32>(m_End - m_Position) / elementSize)
+		{
+			m_ListCount = 0;
+			return Fail();
+		}
+		m_ListToken = listToken;
+		if (m_ListCount > 0)
+		{
+			return true;
+		}
+	}
+}
+
+// Skip to the end of a block whose opening brace has been read
+bool CXFileParser::SkipBinaryBlock()
+{
+	TUInt32 depth = 1;
+	while (depth > 0)
+	{
+		TUInt32 token;
+		if (!ReadBinaryWord( &token ))
+		{
+			return false;
+		}
+		if (token == kTokenOpenBrace)
+		{
+			++depth;
+		}
+		else if (token == kTokenCloseBrace)
+		{
+			--depth;
+		}
+		else if (!SkipBinaryToken( token ))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+//-----------------------------------------------------------------------------
+// Common object support
+//-----------------------------------------------------------------------------
+
+// Make a new object current, its opening brace has been read. Named objects are remembered so
+// they can be referenced later
+bool CXFileParser::EnterObject( const char* type, TUInt32 typeLength, const char* name,
+                                TUInt32 nameLength, SXFileObject* object )
+{
+	++m_Depth;
+	object->type = type;
+	object->typeLength = typeLength;
+	object->name = name;
+	object->nameLength = nameLength;
+	object->depth = m_Depth;
+
+	if (nameLength > 0)
+	{
+		SNamedObject& namedObject = m_NamedObjects[string( name, nameLength )];
+		namedObject.object = *object;
+		namedObject.data = m_Position;
+	}
+	return true;
+}
+
+// Make a previously seen object current, returning to the current position when it is left
+bool CXFileParser::EnterReference( const char* name, TUInt32 nameLength, SXFileObject* object )
+{
+	map<string, SNamedObject>::const_iterator namedObject =
+		m_NamedObjects.find( string( name, nameLength ) );
+	if (namedObject == m_NamedObjects.end())
+	{
+		return Fail();
+	}
+
+	SReturnPoint returnPoint = { m_Position, m_Depth };
+	m_ReturnPoints.push_back( returnPoint );
+
+	++m_Depth;
+	m_Position = namedObject->second.data;
+	*object = namedObject->second.object;
+	object->depth = m_Depth;
+	return true;
+}
+
+// Leave the current object, its closing brace has been read
+void CXFileParser::LeaveObject()
+{
+	--m_Depth;
+	m_ListCount = 0;
+	if (!m_ReturnPoints.empty() && m_ReturnPoints.back().depth == m_Depth)
+	{
+		m_Position = m_ReturnPoints.back().position;
+		m_ReturnPoints.pop_back();
+	}
+}
+
+
+} // namespace gen
@@ -0,0 +1,191 @@
+/*******************************************
+	XFileParser.h
+
+	Streaming parser for Microsoft .x files in
+	text or binary format. Reads in place from
+	a memory-mapped file - objects are visited
+	in file order and their data members read
+	one value at a time, with no copies made
+********************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+using namespace std;
+
+#include "../Common/Types.h"
+#include "../Common/CMappedFile.h"
+
+namespace gen
+{
+
+// An object found in an .x file. The type and name point into the mapped file and are not
+// null-terminated, so are only valid while the file is open
+struct SXFileObject
+{
+	const char* type;       // Template name, e.g. "Mesh"
+	TUInt32     typeLength;
+	const char* name;       // Object name, length 0 if unnamed
+	TUInt32     nameLength;
+	TUInt32     depth;      // Nesting depth of the object, top-level objects are at depth 1
+
+	// Test the object's template name
+	bool IsType( const char* templateName ) const;
+
+	// Copy of the object name
+	string Name() const;
+};
+
+
+// The parser tracks a current position within the nesting of objects. Data members of the current
+// object are read in order with the Read functions, then child objects with NextObject. Objects
+// not understood are skipped with EndObject. References to other objects, e.g. "{ Material01 }",
+// are followed transparently - the referenced object is returned by NextObject as if it appeared
+// in place. Only objects already seen earlier in the file can be referenced. Template definitions
+// are skipped - data is read as the caller expects it, so it must follow the standard templates
+class CXFileParser
+{
+/////////////////////////////////////
+//	Constructors/Destructors
+public:
+	CXFileParser();
+	~CXFileParser();
+
+private:
+	// Prevent use of copy constructor and assignment operator (private and not defined)
+	CXFileParser( const CXFileParser& );
+	CXFileParser& operator=( const CXFileParser& );
+
+
+/////////////////////////////////////
+//	Public interface
+public:
+
+	// Map the given file and read its header. Only uncompressed text and binary files are
+	// supported. Returns false on failure
+	bool Open( const string& fileName );
+
+	// Unmap the file - any objects returned are no longer valid
+	void Close();
+
+	bool IsBinary() const
+	{
+		return m_Binary;
+	}
+
+	// True once any malformed data has been found. All further reads fail
+	bool HasFailed() const
+	{
+		return m_Failed;
+	}
+
+
+	/////////////////////////////////////
+	// Objects
+
+	// Move to the next child object of the current object (or the next top-level object if none
+	// has been entered), skipping any unread data members. The child becomes the current object.
+	// Returns false when the current object has no more children, which moves back to its parent,
+	// or at the end of the file, or on failure (see HasFailed)
+	bool NextObject( SXFileObject* object );
+
+	// Skip any unread data and children of the given object, which must be the current object or
+	// one of its ancestors, moving back to its parent. Returns false on failure
+	bool EndObject( const SXFileObject& object );
+
+
+	/////////////////////////////////////
+	// Data members of the current object
+
+	// Each returns false on failure, or if the next member is of a different type
+	bool ReadUInt( TUInt32* value );
+	bool ReadFloat( TFloat32* value );
+	bool ReadFloats( TFloat32* values, TUInt32 count );
+	bool ReadString( string* value );
+
+
+/////////////////////////////////////
+//	Private interface
+private:
+
+	// Binary format tokens (those used by the parser)
+	enum EBinaryToken
+	{
+		kTokenName        = 1,
+		kTokenString      = 2,
+		kTokenInteger     = 3,
+		kTokenGUID        = 5,
+		kTokenIntegerList = 6,
+		kTokenFloatList   = 7,
+		kTokenOpenBrace   = 10,
+		kTokenCloseBrace  = 11,
+		kTokenComma       = 19,
+		kTokenSemicolon   = 20,
+		kTokenTemplate    = 31,
+	};
+
+	// Object that can be the target of a reference
+	struct SNamedObject
+	{
+		SXFileObject  object;
+		const TUInt8* data; // Position of first data member
+	};
+
+	// Where to continue after leaving a referenced object
+	struct SReturnPoint
+	{
+		const TUInt8* position;
+		TUInt32       depth;
+	};
+
+
+	// Text format support
+	void SkipTextSpace();
+	void SkipTextGUID();
+	bool ReadTextName( const char** name, TUInt32* length );
+	bool ReadTextFloat( TFloat32* value );
+	bool SkipTextBlock();
+
+	// Binary format support
+	bool ReadBinaryWord( TUInt32* value );
+	bool ReadBinaryDWord( TUInt32* value );
+	bool ReadBinaryName( const char** name, TUInt32* length );
+	bool SkipBinaryToken( TUInt32 token );
+	bool StartBinaryList( TUInt32 listToken );
+	bool SkipBinaryBlock();
+
+	// Common object support
+	bool EnterObject( const char* type, TUInt32 typeLength, const char* name, TUInt32 nameLength,
+	                  SXFileObject* object );
+	bool EnterReference( const char* name, TUInt32 nameLength, SXFileObject* object );
+	void LeaveObject();
+
+	bool Fail()
+	{
+		m_Failed = true;
+		return false;
+	}
+
+
+	CMappedFile   m_File;
+	const TUInt8* m_Position; // Current position in the mapped file
+	const TUInt8* m_End;
+
+	bool          m_Binary;
+	TUInt32       m_FloatSize; // Size of floats in binary files - 4 or 8 bytes
+	bool          m_Failed;
+
+	// Binary numbers are held in lists, this is what remains of the list being read
+	TUInt32       m_ListToken;
+	TUInt32       m_ListCount;
+
+	TUInt32       m_Depth; // Number of objects currently entered
+
+	map<string, SNamedObject> m_NamedObjects;
+	vector<SReturnPoint>      m_ReturnPoints;
+};
+
+
+} // namespace gen
@@ -9,6 +9,41 @@
 namespace gen
 {
 
+/*-----------------------------------------------------------------------------------------
+-------------------------------------------------------------------------------------------
+	Entity Template Base Class
+-------------------------------------------------------------------------------------------
+-----------------------------------------------------------------------------------------*/
+
+// Calculate a bounding sphere radius around the root node for the given mesh. Each node's bounds
+// cover its vertices relative to the node, so add the furthest the node origin can be from the
+// root - the sum of the offsets down its chain of parents. Nodes are listed with parents before
+// their children, so this can be done in a single pass
+TFloat32 CEntityTemplate::CalculateCullRadius( const CMeshLayout& layout )
+{
+	TUInt32 numNodes = layout.GetNumNodes();
+	vector<TFloat32> nodeOffsets( numNodes, 0.0f );
+	TFloat32 cullRadius = 0.0f;
+	for (TUInt32 node = 0; node < numNodes; ++node)
+	{
+		const SMeshNode& meshNode = layout.GetNode( node );
+		if (node > 0)
+		{
+			nodeOffsets[node] = nodeOffsets[meshNode.parent] + meshNode.positionMatrix.GetPosition().Length();
+		}
+
+		// Smallest sphere around the node origin containing the node's own bounding sphere or vertices
+		const SMeshBounds& bounds = layout.GetNodeBounds( node );
+		if (!bounds.IsEmpty())
+		{
+			TFloat32 nodeRadius = Min( bounds.originRadius, bounds.centre.Length() + bounds.radius );
+			cullRadius = Max( cullRadius, nodeOffsets[node] + nodeRadius );
+		}
+	}
+	return cullRadius;
+}
+
+
 /*-----------------------------------------------------------------------------------------
 -------------------------------------------------------------------------------------------
 	Base Entity Class
@@ -30,16 +65,18 @@ CEntity::CEntity
 	m_Template = entityTemplate;
 	m_UID = UID;
 	m_Name = name;
+	m_Lod = 0;
 
 	// Allocate space for matrices
-	TUInt32 numNodes = m_Template->Mesh()->GetNumNodes();
-	m_RelMatrices = new CMatrix4x4[numNodes];
-	m_Matrices = new CMatrix4x4[numNodes];
+	const CMeshLayout& layout = m_Template->Layout();
+	TUInt32 numNodes = layout.GetNumNodes();
+	m_RelMatrices = TaggedNewArray<CMatrix4x4>( EMemoryTag::EntityMatrices, numNodes );
+	m_Matrices = TaggedNewArray<CMatrix4x4>( EMemoryTag::EntityMatrices, numNodes );
 
 	// Set initial matrices from mesh defaults
 	for (TUInt32 node = 0; node < numNodes; ++node)
 	{
-		m_RelMatrices[node] = m_Template->Mesh()->GetNode( node ).positionMatrix;
+		m_RelMatrices[node] = layout.GetNode( node ).positionMatrix;
 	}
 
 	// Override root matrix with constructor parameters
@@ -47,24 +84,207 @@ CEntity::CEntity
 }
 
 
-// Render the model
-void CEntity::Render()
+// Add the UID and each node's matrix to the given hash. Only the relative matrices are hashed, the
+// absolute ones are calculated from them
+void CEntity::HashState( CStateHash* hash )
 {
-	// Get pointer to mesh to simplify code
-	CMesh* Mesh = m_Template->Mesh();
+	hash->Add( m_UID );
+	TUInt32 numNodes = m_Template->Layout().GetNumNodes();
+	for (TUInt32 node = 0; node < numNodes; ++node)
+	{
+		hash->Add( m_RelMatrices[node] );
+	}
+}
+
 
-	// Calculate absolute matrices from relative node matrices & node heirarchy
+// Calculate absolute matrices from relative node matrices & node heirarchy
+void CEntity::CalculateMatrices()
+{
 	m_Matrices[0] = m_RelMatrices[0];
-	TUInt32 numNodes = Mesh->GetNumNodes();
+	const CMeshLayout& layout = m_Template->Layout();
+	TUInt32 numNodes = layout.GetNumNodes();
 	for (TUInt32 node = 1; node < numNodes; ++node)
 	{
-		m_Matrices[node] = m_RelMatrices[node] * m_Matrices[Mesh->GetNode( node ).parent];
+		m_Matrices[node] = m_RelMatrices[node] * m_Matrices[layout.GetNode( node ).parent];
 	}
 	// Incorporate any bone<->mesh offsets (only relevant for skinning)
 	// Don't need this step for this exercise
+}
+
+
+// Get the world space bounding sphere for visibility tests
+void CEntity::GetBoundingSphere( CVector3* centre, TFloat32* radius )
+{
+	const CMatrix4x4& root = m_RelMatrices[0];
+	*centre = root.GetPosition();
+
+	// Compare squared axis lengths to find the largest scale, so only one square root is needed
+	TFloat32 maxScaleSq = Max( root.XAxis().LengthSquared(),
+	                      Max( root.YAxis().LengthSquared(), root.ZAxis().LengthSquared() ) );
+	*radius = m_Template->CullRadius() * Sqrt( maxScaleSq );
+}
+
+// Get the world space bounding sphere of the given node's part of the mesh, as of the last call to
+// Render or IntersectsSphere. The radius is negative if no part of the mesh is controlled by the node
+void CEntity::GetNodeBoundingSphere( TUInt32 node, CVector3* centre, TFloat32* radius )
+{
+	const SMeshBounds& bounds = m_Template->Layout().GetNodeBounds( node );
+	if (bounds.IsEmpty())
+	{
+		*centre = m_Matrices[node].GetPosition();
+		*radius = -1.0f;
+		return;
+	}
+
+	const CMatrix4x4& matrix = m_Matrices[node];
+	TFloat32 maxScaleSq = Max( matrix.XAxis().LengthSquared(),
+	                      Max( matrix.YAxis().LengthSquared(), matrix.ZAxis().LengthSquared() ) );
+	*centre = matrix.TransformPoint( bounds.centre );
+	*radius = bounds.radius * Sqrt( maxScaleSq );
+}
+
+// Test if a world space sphere touches the oriented bounding box of any node's part of the mesh
+// (e.g. a tank's body or turret separately), optionally returning the first node hit. The sphere
+// is moved into the space of each node, with the radius scaled by the node's smallest scaling so
+// the test is conservative for non-uniform scaling
+bool CEntity::IntersectsSphere( const CVector3& centre, TFloat32 radius, TUInt32* hitNode /*= 0*/ )
+{
+	// Reject against the whole entity first
+	CVector3 entityCentre;
+	TFloat32 entityRadius;
+	GetBoundingSphere( &entityCentre, &entityRadius );
+	if (DistanceSquared( centre, entityCentre ) > (radius + entityRadius) * (radius + entityRadius))
+	{
+		return false;
+	}
+
+	CalculateMatrices();
+	const CMeshLayout& layout = m_Template->Layout();
+	TUInt32 numNodes = layout.GetNumNodes();
+	for (TUInt32 node = 0; node < numNodes; ++node)
+	{
+		const SMeshBounds& bounds = layout.GetNodeBounds( node );
+		if (bounds.IsEmpty()) continue;
+
+		const CMatrix4x4& matrix = m_Matrices[node];
+		TFloat32 minScaleSq = Min( matrix.XAxis().LengthSquared(),
+		                      Min( matrix.YAxis().LengthSquared(), matrix.ZAxis().LengthSquared() ) );
+		if (minScaleSq <= 0.0f) continue;
+
+		CVector3 nodeCentre = InverseAffine( matrix ).TransformPoint( centre );
+		if (SphereIntersectsBox( bounds, nodeCentre, radius / Sqrt( minScaleSq ) ))
+		{
+			if (hitNode) *hitNode = node;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// Test if a world space sphere moving from start to end touches the oriented bounding box of any
+// node's part of the mesh, optionally returning the first node hit. As IntersectsSphere, with the
+// segment moved into the space of each node
+bool CEntity::IntersectsMovingSphere( const CVector3& start, const CVector3& end, TFloat32 radius,
+                                      TUInt32* hitNode /*= 0*/ )
+{
+	// Reject against the whole entity first, using the point on the segment nearest its centre
+	CVector3 entityCentre;
+	TFloat32 entityRadius;
+	GetBoundingSphere( &entityCentre, &entityRadius );
+	CVector3 direction = end - start;
+	TFloat32 lengthSq = direction.LengthSquared();
+	TFloat32 t = (lengthSq > 0.0f) ? Dot( entityCentre - start, direction ) / lengthSq : 0.0f;
+	CVector3 nearest = start + direction * Min( Max( t, 0.0f ), 1.0f );
+	if (DistanceSquared( nearest, entityCentre ) > (radius + entityRadius) * (radius + entityRadius))
+	{
+		return false;
+	}
+
+	CalculateMatrices();
+	const CMeshLayout& layout = m_Template->Layout();
+	TUInt32 numNodes = layout.GetNumNodes();
+	for (TUInt32 node = 0; node < numNodes; ++node)
+	{
+		const SMeshBounds& bounds = layout.GetNodeBounds( node );
+		if (bounds.IsEmpty()) continue;
+
+		const CMatrix4x4& matrix = m_Matrices[node];
+		TFloat32 minScaleSq = Min( matrix.XAxis().LengthSquared(),
+		                      Min( matrix.YAxis().LengthSquared(), matrix.ZAxis().LengthSquared() ) );
+		if (minScaleSq <= 0.0f) continue;
+
+		CMatrix4x4 inverse = InverseAffine( matrix );
+		if (SegmentIntersectsBox( bounds, inverse.TransformPoint( start ), inverse.TransformPoint( end ),
+		                          radius / Sqrt( minScaleSq ) ))
+		{
+			if (hitNode) *hitNode = node;
+			return true;
+		}
+	}
+	return false;
+}
+
+
+// A coarser level of detail is only chosen when its error on screen is below this proportion of
+// the acceptable error. A finer level is chosen as soon as the current one exceeds it, so the gap
+// stops entities near a switching distance flicking between levels every frame
+static const TFloat32 kLodHysteresis = 0.75f;
+
+// Choose the mesh's level of detail for the given view, starting from the current one. The error
+// on screen is the level's error scaled by the entity, projected from the nearest point of the
+// entity's bounding sphere
+TUInt32 CEntity::SelectLod( CMesh* mesh, const CVector3& viewPoint, TFloat32 lodScale )
+{
+	TUInt32 numLods = mesh->GetNumLods();
+	if (lodScale <= 0.0f || numLods == 1)
+	{
+		return 0;
+	}
+
+	CVector3 centre;
+	TFloat32 radius;
+	GetBoundingSphere( &centre, &radius );
+	TFloat32 distance = Distance( viewPoint, centre ) - radius;
+	if (distance <= 0.0f)
+	{
+		return 0; // Inside bounding sphere
+	}
+
+	// Error in pixels over the acceptable error, per model unit of level error
+	const CMatrix4x4& root = m_RelMatrices[0];
+	TFloat32 maxScale = Sqrt( Max( root.XAxis().LengthSquared(),
+	                          Max( root.YAxis().LengthSquared(), root.ZAxis().LengthSquared() ) ) );
+	TFloat32 errorScale = lodScale * maxScale / distance;
+
+	TUInt32 lod = Min( m_Lod, numLods - 1 );
+	while (lod > 0 && mesh->GetLodError( lod ) * errorScale > 1.0f)
+	{
+		--lod;
+	}
+	while (lod < numLods - 1 && mesh->GetLodError( lod + 1 ) * errorScale < kLodHysteresis)
+	{
+		++lod;
+	}
+	return lod;
+}
+
+// Add the entity's sub-meshes to the given render queue. The entity must not be updated or
+// destroyed until the queue has been flushed. The mesh's level of detail is chosen from the size
+// its simplification error would appear on screen when seen from the given point, see SelectLod.
+// Sub-meshes outside the frustum are skipped if one is given. Returns the number of triangles
+// submitted
+TUInt32 CEntity::Render( CRenderQueue* queue, const CVector3& viewPoint /*= CVector3::kOrigin*/,
+                         TFloat32 lodScale /*= 0.0f*/, const CFrustum* frustum /*= 0*/ )
+{
+	// Get pointer to mesh to simplify code - loads the mesh on first use
+	CMesh* Mesh = m_Template->Mesh();
+	if (!Mesh) return 0;
 
-	// Render with absolute matrices
-	Mesh->Render( m_Matrices );
+	// Queue with absolute matrices
+	CalculateMatrices();
+	m_Lod = SelectLod( Mesh, viewPoint, lodScale );
+	return Mesh->Submit( m_Matrices, queue, m_Lod, frustum );
 }
 
 
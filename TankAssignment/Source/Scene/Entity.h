@@ -10,10 +10,14 @@
 using namespace std;
 
 #include "../Common/Defines.h"
+#include "../Common/MemoryTracker.h"
+#include "../Common/StateHash.h"
 #include "../Math/CVector3.h"
 #include "../Math/CMatrix4x4.h"
 #include "Camera.h"
 #include "../Render/Mesh.h"
+#include "../Render/MeshHandle.h"
+#include "../Render/AssetCache.h"
 
 namespace gen
 {
@@ -37,32 +41,38 @@ const TEntityUID TeamManagerUID = 0xfffffffd;
 // Base entity template only contains a mesh, i.e. the only common feature of all entities
 // is that they have some geometry. In fact, if we had cameras or lights as entities, we couldn't
 // even make this assumption. However, this is just a simple example of an entity system
+// Only the mesh layout (nodes and bounds) is read when the template is created. The geometry is
+// loaded when the mesh is first rendered, so runs that never render never load it. Templates using
+// the same mesh file share the mesh through an asset cache
 class CEntityTemplate
 {
 /////////////////////////////////////
 //	Constructors/Destructors
 public:
-	// Base entity template constructor needs template type (e.g. "Car"), name (e.g. "Fiat Panda")
-	// and the associated mesh (e.g. "panda.x")
-	CEntityTemplate( const string& type, const string& name, const string& meshFilename )
+	// Base entity template constructor needs template type (e.g. "Car"), name (e.g. "Fiat Panda"),
+	// the associated mesh (e.g. "panda.x") and the asset cache to get the mesh from
+	CEntityTemplate( const string& type, const string& name, const string& meshFilename,
+	                 CAssetCache* assets )
 	{
 		m_Type = type;
 		m_Name = name;
 
-		// Load mesh
-		m_Mesh = new CMesh();
-		if (!m_Mesh->Load( meshFilename ))
+		// Get mesh (with its layout) from cache
+		m_Assets = assets;
+		m_Mesh = m_Assets->AcquireMesh( meshFilename );
+		if (!m_Mesh)
 		{
 			string errorMsg = "Error loading mesh " + meshFilename;
 			SystemMessageBox( errorMsg.c_str(), "Mesh Error" );
 			throw; // failure in constructor can only be signalled with exception 
 		}
+		m_CullRadius = CalculateCullRadius( m_Mesh->Layout() );
 	}
 
 	// Destructor - base class destructors should always be virtual
 	virtual ~CEntityTemplate()
 	{
-		delete m_Mesh;
+		m_Assets->ReleaseMesh( m_Mesh );
 	}
 
 private:
@@ -70,6 +80,10 @@ private:
 	CEntityTemplate( const CEntityTemplate& );
 	CEntityTemplate& operator=( const CEntityTemplate& );
 
+public:
+	// Templates of all types are counted against the entities memory tag
+	GEN_MEMORY_TAG( EMemoryTag::Entities )
+
 
 /////////////////////////////////////
 //	Public interface
@@ -88,9 +102,30 @@ public:
 		return m_Name;
 	}
 
+	// Return the mesh, loading it on first use. Returns 0 if the mesh could not be loaded
 	CMesh* const Mesh()
 	{
-		return m_Mesh;
+		return m_Mesh->Get();
+	}
+
+	// Load the mesh now rather than when first rendered. Returns false if it failed to load
+	bool LoadMesh()
+	{
+		return m_Mesh->Load();
+	}
+
+	// Node hierarchy and bounds of the mesh - available without loading the mesh
+	const CMeshLayout& Layout()
+	{
+		return m_Mesh->Layout();
+	}
+
+	// Radius of a sphere around the root node that contains the whole mesh in any pose where the
+	// nodes only rotate (e.g. a turning turret). Used for visibility culling. Found from the bounds
+	// of each node, see CMeshLayout::GetNodeBounds
+	TFloat32 CullRadius()
+	{
+		return m_CullRadius;
 	}
 
 
@@ -102,8 +137,13 @@ private:
 	string m_Type;
 	string m_Name;
 
-	// The mesh representing this entity
-	CMesh* m_Mesh;
+	// Conservative bounding sphere radius for the mesh (see CullRadius)
+	static TFloat32 CalculateCullRadius( const CMeshLayout& layout );
+
+	// The mesh representing this entity, shared with other templates using the same mesh file
+	CAssetCache* m_Assets;
+	CMeshHandle* m_Mesh;
+	TFloat32     m_CullRadius;
 };
 
 
@@ -137,8 +177,8 @@ public:
 	// Destructor - base class destructors should always be virtual
 	virtual ~CEntity()
 	{
-		delete[] m_Matrices;
-		delete[] m_RelMatrices;
+		TaggedDeleteArray( m_Matrices );
+		TaggedDeleteArray( m_RelMatrices );
 	}
 
 private:
@@ -146,6 +186,10 @@ private:
 	CEntity( const CEntity& );
 	CEntity& operator=( const CEntity& );
 
+public:
+	// Entities of all types are counted against the entities memory tag
+	GEN_MEMORY_TAG( EMemoryTag::Entities )
+
 
 /////////////////////////////////////
 //	Public interface
@@ -183,6 +227,23 @@ public:
 		return m_RelMatrices[node];
 	}
 
+	// Get the world space bounding sphere for visibility tests, centred on the entity position
+	// and scaled by the largest scaling in the root matrix
+	void GetBoundingSphere( CVector3* centre, TFloat32* radius );
+
+	// Get the world space bounding sphere of the part of the mesh controlled by the given node, as
+	// positioned by the last call to Render or IntersectsSphere. The radius is negative if the
+	// node controls no part of the mesh
+	void GetNodeBoundingSphere( TUInt32 node, CVector3* centre, TFloat32* radius );
+
+	// Collision test of a world space sphere against the bounding box of each node's part of the
+	// mesh, so e.g. a tank's turret and body are hit separately. Optionally returns the node hit
+	bool IntersectsSphere( const CVector3& centre, TFloat32 radius, TUInt32* hitNode = 0 );
+
+	// As IntersectsSphere, but for a sphere moving from start to end, so fast objects can't pass
+	// through a node's box between one update and the next. See SegmentIntersectsBox
+	bool IntersectsMovingSphere( const CVector3& start, const CVector3& end, TFloat32 radius, TUInt32* hitNode = 0 );
+
 
 	/////////////////////////////////////
 	// Update / Render
@@ -191,15 +252,33 @@ public:
 	// Return false if the entity is to be destroyed
 	// Virtual function, base version does nothing
 	virtual bool Update( TFloat32 updateTime ) { return true; }
+
+	// Add everything about this entity that changes as the game runs to the given hash, to check
+	// that changes to the game keep its behaviour. The base version adds the UID and each node's
+	// matrix, derived classes add their own state after calling it
+	virtual void HashState( CStateHash* hash );
 	
-	// Render the entity
-	void Render();
+	// Add the entity's sub-meshes to the given render queue. The entity must not be updated or
+	// destroyed until the queue has been flushed. The mesh's level of detail is chosen from the
+	// size its simplification error would appear on screen when seen from the given point - the
+	// lod scale is the screen height in pixels at distance 1 divided by the largest acceptable
+	// error in pixels (0 to always draw full detail). If a frustum is given, sub-meshes outside it
+	// are skipped. Returns the number of triangles submitted
+	TUInt32 Render( CRenderQueue* queue, const CVector3& viewPoint = CVector3::kOrigin, TFloat32 lodScale = 0.0f,
+	                const CFrustum* frustum = 0 );
 
 
 /////////////////////////////////////
 //	Private interface
 private:
 
+	// Calculate absolute world matrices from the relative node matrices
+	void CalculateMatrices();
+
+	// Choose the mesh's level of detail for the given view, starting from the current one
+	TUInt32 SelectLod( CMesh* mesh, const CVector3& viewPoint, TFloat32 lodScale );
+
+
 	// The template used by this entity - the common data for all entities of this type
 	CEntityTemplate* m_Template;
 
@@ -210,6 +289,10 @@ private:
 	// Relative and absolute world matrices for each node in the template's mesh
 	CMatrix4x4* m_RelMatrices; // Dynamically allocated arrays
 	CMatrix4x4* m_Matrices;
+
+	// Level of detail drawn last frame, kept so the level only changes when the view has changed
+	// enough - see SelectLod
+	TUInt32     m_Lod;
 };
 
 
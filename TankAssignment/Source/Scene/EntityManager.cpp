@@ -6,6 +6,7 @@
 ********************************************/
 
 #include "EntityManager.h"
+#include "../Common/Profiler.h"
 
 namespace gen
 {
@@ -18,18 +19,24 @@ CEntityManager::CEntityManager()
 {
 	// Initialise list of entities and UID hash map
 	m_Entities.reserve( 1024 );
-	m_EntityUIDMap = new CHashTable<TEntityUID, TUInt32>( 2048, JOneAtATimeHash ); 
+	m_EntityUIDMap = new TEntityUIDMap( 2048, JOneAtATimeHash );
 
 	// Set first entity UID that will be used
 	m_NextUID = 0;
 
+	m_RenderBackend = 0;
+	m_LodPixelError = 1.0f;
+	m_LodViewportHeight = 768;
+	m_SubmittedTriangles = 0;
+	m_FullDetailTriangles = 0;
 	m_IsEnumerating = false;
 }
 
-// Destructor removes all entities
+// Destructor removes all entities and templates
 CEntityManager::~CEntityManager()
 {
 	DestroyAllEntities();
+	DestroyAllTemplates();
 	delete m_EntityUIDMap;
 }
 
@@ -42,7 +49,7 @@ CEntityManager::~CEntityManager()
 CEntityTemplate* CEntityManager::CreateTemplate( const string& type, const string& name, const string& mesh )
 {
 	// Create new entity template
-	CEntityTemplate* newTemplate = new CEntityTemplate( type, name, mesh );
+	CEntityTemplate* newTemplate = new CEntityTemplate( type, name, mesh, &m_AssetCache );
 
 	// Add the template name / template pointer pair to the map
     m_Templates[name] = newTemplate;
@@ -59,7 +66,7 @@ CTankTemplate* CEntityManager::CreateTankTemplate(const string& type, const stri
 	float shellAmmo)
 {
 	// Create new tank template
-	CTankTemplate* newTemplate = new CTankTemplate(type, name, mesh, maxSpeed, acceleration,
+	CTankTemplate* newTemplate = new CTankTemplate(type, name, mesh, &m_AssetCache, maxSpeed, acceleration,
 		turnSpeed, turretTurnSpeed, maxHP, shellDamage, shellAmmo);
 
 	// Add the template name / template pointer pair to the map
@@ -100,6 +107,15 @@ void CEntityManager::DestroyAllTemplates()
 	}
 }
 
+// Load the meshes of all templates now, rather than as each is first rendered. Requires a
+// device. The mesh files are imported on the given thread pool (may be 0). Returns false if any
+// mesh failed to load
+bool CEntityManager::LoadAllMeshes( CThreadPool* pool, TFloat32* importTime /*= 0*/, TFloat32* resourceTime /*= 0*/ )
+{
+	// All template meshes are held by the asset cache
+	return m_AssetCache.LoadAllMeshes( pool, importTime, resourceTime );
+}
+
 
 /////////////////////////////////////
 // Entity creation / destruction
@@ -269,6 +285,7 @@ void CEntityManager::DestroyAllEntities()
 		delete m_Entities.back();
 		m_Entities.pop_back();
 	}
+	m_NextUID = 0;
 
 	m_IsEnumerating = false; // Cancel any entity enumeration (entity list has changed)
 }
@@ -280,6 +297,7 @@ void CEntityManager::DestroyAllEntities()
 // Call all entity update functions. Pass the time since last update
 void CEntityManager::UpdateAllEntities( float updateTime )
 {
+	GEN_PROFILE_ZONE( "UpdateAllEntities" );
 	TUInt32 entity = 0;
 	while (entity < m_Entities.size())
 	{
@@ -295,15 +313,99 @@ void CEntityManager::UpdateAllEntities( float updateTime )
 	}
 }
 
-// Render all entities
-void CEntityManager::RenderAllEntities()
+// Add the state of every entity to the given hash
+void CEntityManager::HashState( CStateHash* hash )
+{
+	hash->Add( static_cast<TUInt32>(m_Entities.size()) );
+	for (TUInt32 entity = 0; entity < m_Entities.size(); ++entity)
+	{
+		m_Entities[entity]->HashState( hash );
+	}
+}
+
+// Find the entities inside the given camera's view frustum, returns the number found
+TUInt32 CEntityManager::CullEntities( CCamera* camera )
+{
+	TUInt32 numEntities = static_cast<TUInt32>(m_Entities.size());
+	m_CullX.resize( numEntities );
+	m_CullY.resize( numEntities );
+	m_CullZ.resize( numEntities );
+	m_CullRadius.resize( numEntities );
+	m_CullIndices.resize( numEntities );
+
+	// Gather bounding spheres into separate arrays
+	for (TUInt32 entity = 0; entity < numEntities; ++entity)
+	{
+		CVector3 centre;
+		m_Entities[entity]->GetBoundingSphere( &centre, &m_CullRadius[entity] );
+		m_CullX[entity] = centre.x;
+		m_CullY[entity] = centre.y;
+		m_CullZ[entity] = centre.z;
+	}
+
+	m_VisibleEntities.clear();
+	if (numEntities == 0)
+	{
+		return 0;
+	}
+
+	m_Frustum.Set( camera );
+	TUInt32 numVisible = m_Frustum.CullSpheres( &m_CullX[0], &m_CullY[0], &m_CullZ[0], &m_CullRadius[0],
+	                                          numEntities, &m_CullIndices[0] );
+	for (TUInt32 visible = 0; visible < numVisible; ++visible)
+	{
+		m_VisibleEntities.push_back( m_Entities[m_CullIndices[visible]] );
+	}
+	return numVisible;
+}
+
+// Render all entities, or only those visible to the given camera with levels of detail chosen
+// for its view
+void CEntityManager::RenderAllEntities( CCamera* camera /*= 0*/ )
 {
-	TEntityIter entity = m_Entities.begin();
-	while (entity != m_Entities.end())
+	// The lod scale is the viewport height in pixels of 1 unit at distance 1, over the acceptable
+	// error in pixels (see CEntity::Render)
+	// Sub-meshes of visible entities are culled against the same frustum
+	CVector3 viewPoint = CVector3::kOrigin;
+	TFloat32 lodScale = 0.0f;
+	const CFrustum* frustum = 0;
+	if (camera)
 	{
-		(*entity)->Render();
+		CullEntities( camera );
+		frustum = &m_Frustum;
+		viewPoint = camera->Position();
+		if (m_LodPixelError > 0.0f)
+		{
+			lodScale = m_LodViewportHeight / (2.0f * Tan( camera->GetFOV() * 0.5f ) * m_LodPixelError);
+		}
+	}
+	else
+	{
+		m_VisibleEntities = m_Entities;
+	}
+
+	m_SubmittedTriangles = 0;
+	m_FullDetailTriangles = 0;
+	TEntityIter entity = m_VisibleEntities.begin();
+	while (entity != m_VisibleEntities.end())
+	{
+		m_SubmittedTriangles += (*entity)->Render( &m_RenderQueue, viewPoint, lodScale, frustum );
+		CMesh* mesh = (*entity)->Template()->Mesh();
+		if (mesh)
+		{
+			m_FullDetailTriangles += mesh->GetLodNumTriangles( 0 );
+		}
 		++entity;
 	}
+
+	if (m_RenderBackend)
+	{
+		m_RenderQueue.Flush( m_RenderBackend );
+	}
+	else
+	{
+		m_RenderQueue.Clear();
+	}
 }
 
 
@@ -12,11 +12,16 @@ using namespace std;
 
 #include "../Common/Defines.h"
 #include "../Common/CHashTable.h"
+#include "../Common/MemoryTracker.h"
 #include "Entity.h"
 #include "TankEntity.h"
 #include "ShellEntity.h"
 #include "Camera.h"
+#include "Frustum.h"
 #include "Powerup.h"
+#include "../Render/RenderQueue.h"
+#include "../Render/RenderBackend.h"
+#include "../Render/AssetCache.h"
 
 namespace gen
 {
@@ -45,6 +50,9 @@ private:
 //	Public interface
 public:
 
+	// Lists of entities, with their memory counted against the entities
+	typedef vector<CEntity*, CTaggedAllocator<CEntity*, EMemoryTag::Entities>> TEntities;
+
 	/////////////////////////////////////
 	// Template creation / destruction
 
@@ -67,6 +75,17 @@ public:
 	// Destroy all templates held by the manager
 	void DestroyAllTemplates();
 
+	// Load the meshes of all templates now, rather than as each is first rendered. Requires a
+	// device. The mesh files are imported on the given thread pool (may be 0), see
+	// CAssetCache::LoadAllMeshes. Returns false if any mesh failed to load
+	bool LoadAllMeshes( CThreadPool* pool, TFloat32* importTime = 0, TFloat32* resourceTime = 0 );
+
+	// Cache sharing meshes and textures between templates
+	CAssetCache& AssetCache()
+	{
+		return m_AssetCache;
+	}
+
 
 	/////////////////////////////////////
 	// Entity creation / destruction
@@ -120,7 +139,8 @@ public:
 	// Destroy the given entity - returns true if the entity existed and was destroyed
 	bool DestroyEntity( TEntityUID UID );
 
-	// Destroy all entities held by the manager
+	// Destroy all entities held by the manager. UIDs start again from 0, so a level set up again
+	// gets the same UIDs - anything still holding a UID (e.g. a queued message) must be cleared too
 	void DestroyAllEntities();
 
 
@@ -274,8 +294,52 @@ public:
 	// Pass the time since last update
 	void UpdateAllEntities( float updateTime );
 
-	// Render all entities - not the ideal method, OK for this example
-	void RenderAllEntities();
+	// Add the state of every entity to the given hash, in the order they are held - the same
+	// sequence of creations, updates and destructions always gives the same order
+	void HashState( CStateHash* hash );
+
+	// Find the entities whose bounding spheres are inside the given camera's view frustum. The
+	// result is kept in the visible list (see VisibleEntities) and the count is returned. Does
+	// no rendering, so can be used without a device (e.g. to test culling for camera poses)
+	TUInt32 CullEntities( CCamera* camera );
+
+	// Return the entities found visible by the last call to CullEntities / RenderAllEntities
+	const TEntities& VisibleEntities()
+	{
+		return m_VisibleEntities;
+	}
+
+	// Set the backend that RenderAllEntities draws with. With no backend nothing is drawn
+	void SetRenderBackend( IRenderBackend* backend )
+	{
+		m_RenderBackend = backend;
+	}
+
+	// Set how levels of detail are chosen when rendering with a camera: the largest acceptable
+	// simplification error in pixels, and the height of the viewport in pixels. An error of 0
+	// always renders full detail
+	void SetLodSelection( TFloat32 maxPixelError, TUInt32 viewportHeight )
+	{
+		m_LodPixelError = maxPixelError;
+		m_LodViewportHeight = viewportHeight;
+	}
+
+	// Render entities - not the ideal method, OK for this example. If a camera is given then
+	// entities outside its view are culled first and each entity's level of detail is chosen from
+	// its distance, otherwise all entities are rendered at full detail. Visible entities are added
+	// to a render queue, which is sorted and drawn with the render backend
+	void RenderAllEntities( CCamera* camera = 0 );
+
+	// Number of triangles submitted by the last call to RenderAllEntities, and the number there
+	// would have been if every entity was at full detail
+	TUInt32 SubmittedTriangles()
+	{
+		return m_SubmittedTriangles;
+	}
+	TUInt32 FullDetailTriangles()
+	{
+		return m_FullDetailTriangles;
+	}
 
 		
 /////////////////////////////////////
@@ -286,13 +350,16 @@ private:
 	// Types
 
 	// Entity templates are held in a map, define some types for convenience
-	typedef map<string, CEntityTemplate*> TTemplates;
+	typedef map<string, CEntityTemplate*, less<string>,
+	            CTaggedAllocator<pair<const string, CEntityTemplate*>, EMemoryTag::Entities>> TTemplates;
 	typedef TTemplates::iterator TTemplateIter;
 
-	// Entity instances are held in a vector, define some types for convenience
-	typedef vector<CEntity*> TEntities;
+	// Entity instances are held in a vector (TEntities above), define some types for convenience
 	typedef TEntities::iterator TEntityIter;
 
+	// UID to entity index look-up
+	typedef CHashTable<TEntityUID, TUInt32, EMemoryTag::EntityLookUp> TEntityUIDMap;
+
 
 	/////////////////////////////////////
 	// Template Data
@@ -300,6 +367,9 @@ private:
 	// The map of template names / templates
 	TTemplates m_Templates;
 
+	// Meshes and textures used by the templates
+	CAssetCache m_AssetCache;
+
 
 	/////////////////////////////////////
 	// Entity Data
@@ -310,12 +380,43 @@ private:
 	TEntities m_Entities;
 
 	// A mapping from UIDs to indexes into the above array
-	CHashTable<TEntityUID, TUInt32>* m_EntityUIDMap;
+	TEntityUIDMap* m_EntityUIDMap;
 
 	// Entity IDs are provided using a single increasing integer
 	TEntityUID m_NextUID;
 
 
+	/////////////////////////////////////
+	// Culling Data
+
+	// Entities that passed the last frustum test, and the frustum used
+	TEntities m_VisibleEntities;
+	CFrustum  m_Frustum;
+
+	// Bounding spheres gathered for culling, as separate arrays for SIMD testing. Kept between
+	// frames so they are only reallocated when the number of entities grows
+	vector<TFloat32> m_CullX;
+	vector<TFloat32> m_CullY;
+	vector<TFloat32> m_CullZ;
+	vector<TFloat32> m_CullRadius;
+	vector<TUInt32>  m_CullIndices;
+
+
+	/////////////////////////////////////
+	// Rendering Data
+
+	CRenderQueue     m_RenderQueue;
+	IRenderBackend*  m_RenderBackend;
+
+	// Level of detail selection, see SetLodSelection
+	TFloat32         m_LodPixelError;
+	TUInt32          m_LodViewportHeight;
+
+	// Triangle counts from the last render
+	TUInt32          m_SubmittedTriangles;
+	TUInt32          m_FullDetailTriangles;
+
+
 	/////////////////////////////////////
 	// Data for Entity Enumeration
 
@@ -0,0 +1,149 @@
+/*******************************************
+	Frustum.cpp
+
+	View frustum culling implementation
+********************************************/
+
+#include <xmmintrin.h> // SSE intrinsics
+
+#include "Frustum.h"
+
+namespace gen
+{
+
+//-----------------------------------------------------------------------------
+// Setup
+//-----------------------------------------------------------------------------
+
+// Construct an empty frustum that culls nothing - all planes are infinitely far away
+CFrustum::CFrustum()
+{
+	for (TUInt32 plane = 0; plane < kNumPlanes; ++plane)
+	{
+		m_Normals[plane] = CVector3::kZero;
+		m_Distances[plane] = 0.0f;
+	}
+}
+
+// Take the planes from the given camera
+void CFrustum::Set( CCamera* camera )
+{
+	CVector3 points[kNumPlanes];
+	CVector3 normals[kNumPlanes];
+	camera->CalculateFrustrumPlanes( points, normals );
+	Set( points, normals );
+}
+
+// Set the planes directly, each as a point on the plane and an outward facing normal
+void CFrustum::Set( const CVector3 points[6], const CVector3 normals[6] )
+{
+	for (TUInt32 plane = 0; plane < kNumPlanes; ++plane)
+	{
+		m_Normals[plane] = Normalise( normals[plane] );
+		m_Distances[plane] = Dot( m_Normals[plane], points[plane] );
+	}
+}
+
+
+//-----------------------------------------------------------------------------
+// Visibility tests
+//-----------------------------------------------------------------------------
+
+// Return true if the given sphere is inside or touching the frustum
+bool CFrustum::IsSphereVisible( const CVector3& centre, TFloat32 radius ) const
+{
+	for (TUInt32 plane = 0; plane < kNumPlanes; ++plane)
+	{
+		if (Dot( m_Normals[plane], centre ) - m_Distances[plane] > radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Return true if the given axis-aligned box is inside or touching the frustum. For each plane
+// only the box corner furthest into the frustum needs testing - if that is outside, all are
+bool CFrustum::IsAABBVisible( const CVector3& minBounds, const CVector3& maxBounds ) const
+{
+	for (TUInt32 plane = 0; plane < kNumPlanes; ++plane)
+	{
+		const CVector3& normal = m_Normals[plane];
+		CVector3 nearCorner( normal.x > 0.0f ? minBounds.x : maxBounds.x,
+		                     normal.y > 0.0f ? minBounds.y : maxBounds.y,
+		                     normal.z > 0.0f ? minBounds.z : maxBounds.z );
+		if (Dot( normal, nearCorner ) - m_Distances[plane] > 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+// Test a batch of spheres held as structure of arrays, writing indexes of the visible ones.
+// Four spheres are tested against each plane at once. Each SSE lane keeps an "outside" flag,
+// set if the sphere is beyond any plane. The few left over at the end are tested one by one
+TUInt32 CFrustum::CullSpheres
+(
+	const TFloat32* centreX,
+	const TFloat32* centreY,
+	const TFloat32* centreZ,
+	const TFloat32* radius,
+	TUInt32         count,
+	TUInt32*        visibleIndices
+) const
+{
+	// Splat each plane across a register once, rather than per batch
+	__m128 planeX[kNumPlanes], planeY[kNumPlanes], planeZ[kNumPlanes], planeD[kNumPlanes];
+	for (TUInt32 plane = 0; plane < kNumPlanes; ++plane)
+	{
+		planeX[plane] = _mm_set1_ps( m_Normals[plane].x );
+		planeY[plane] = _mm_set1_ps( m_Normals[plane].y );
+		planeZ[plane] = _mm_set1_ps( m_Normals[plane].z );
+		planeD[plane] = _mm_set1_ps( m_Distances[plane] );
+	}
+
+	TUInt32 numVisible = 0;
+	TUInt32 sphere = 0;
+	for (; sphere + 4 <= count; sphere += 4)
+	{
+		const __m128 x = _mm_loadu_ps( centreX + sphere );
+		const __m128 y = _mm_loadu_ps( centreY + sphere );
+		const __m128 z = _mm_loadu_ps( centreZ + sphere );
+		const __m128 r = _mm_loadu_ps( radius + sphere );
+
+		__m128 outside = _mm_setzero_ps();
+		for (TUInt32 plane = 0; plane < kNumPlanes; ++plane)
+		{
+			__m128 dist = _mm_mul_ps( x, planeX[plane] );
+			dist = _mm_add_ps( dist, _mm_mul_ps( y, planeY[plane] ) );
+			dist = _mm_add_ps( dist, _mm_mul_ps( z, planeZ[plane] ) );
+			dist = _mm_sub_ps( dist, planeD[plane] );
+			outside = _mm_or_ps( outside, _mm_cmpgt_ps( dist, r ) );
+		}
+
+		// One bit per sphere, set if visible
+		const int visibleMask = ~_mm_movemask_ps( outside ) & 0xf;
+		for (TUInt32 lane = 0; lane < 4; ++lane)
+		{
+			if (visibleMask & (1 << lane))
+			{
+				visibleIndices[numVisible++] = sphere + lane;
+			}
+		}
+	}
+
+	for (; sphere < count; ++sphere)
+	{
+		if (IsSphereVisible( CVector3( centreX[sphere], centreY[sphere], centreZ[sphere] ), radius[sphere] ))
+		{
+			visibleIndices[numVisible++] = sphere;
+		}
+	}
+
+	return numVisible;
+}
+
+
+} // namespace gen
@@ -0,0 +1,73 @@
+/*******************************************
+	Frustum.h
+
+	View frustum for CPU visibility culling.
+	Tests bounding spheres against the six
+	camera planes, four spheres at a time
+	using SSE
+********************************************/
+
+#pragma once
+
+#include "../Common/Defines.h"
+#include "../Math/CVector3.h"
+#include "Camera.h"
+
+namespace gen
+{
+
+class CFrustum
+{
+public:
+
+	/////////////////////////////
+	// Constructors
+
+	// Construct an empty frustum that culls nothing - call Set before use
+	CFrustum();
+
+	// Construct the frustum of the given camera
+	CFrustum( CCamera* camera )
+	{
+		Set( camera );
+	}
+
+
+	/////////////////////////////
+	// Setup
+
+	// Take the planes from the given camera - call after the camera has moved
+	void Set( CCamera* camera );
+
+	// Set the planes directly - each as a point on the plane and a normal pointing away from the
+	// frustum (same form as CCamera::CalculateFrustrumPlanes)
+	void Set( const CVector3 points[6], const CVector3 normals[6] );
+
+
+	/////////////////////////////
+	// Visibility tests
+
+	// Return true if the given sphere is inside or touching the frustum
+	bool IsSphereVisible( const CVector3& centre, TFloat32 radius ) const;
+
+	// Return true if the given axis-aligned box is inside or touching the frustum
+	bool IsAABBVisible( const CVector3& minBounds, const CVector3& maxBounds ) const;
+
+	// Test a batch of spheres, given as separate arrays of centre x, y, z and radius (structure
+	// of arrays so four spheres can be loaded into each SSE register). Writes the indexes of
+	// visible spheres to visibleIndices (which must have space for count entries) in increasing
+	// order and returns the number of visible spheres
+	TUInt32 CullSpheres( const TFloat32* centreX, const TFloat32* centreY, const TFloat32* centreZ,
+	                     const TFloat32* radius, TUInt32 count, TUInt32* visibleIndices ) const;
+
+
+private:
+	// Planes stored as normal and distance from the origin: a point p is outside a plane when
+	// Dot(normal, p) - distance > 0. Normals are unit length so this is the true distance
+	static const TUInt32 kNumPlanes = 6;
+	CVector3 m_Normals[kNumPlanes];
+	TFloat32 m_Distances[kNumPlanes];
+};
+
+
+} // namespace gen
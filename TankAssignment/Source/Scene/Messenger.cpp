@@ -4,7 +4,13 @@
 	Entity messenger class implementation
 ********************************************/
 
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
 #include "Messenger.h"
+#include "EntityManager.h"
+#include "../Common/Profiler.h"
 
 namespace gen
 {
@@ -15,23 +21,59 @@ namespace gen
 // Define a single messenger object for the program
 CMessenger Messenger;
 
+// Names of each message type in reports
+static const char* const MessageTypeNames[static_cast<TUInt32>(EMessageType::NumMessageTypes)] =
+{
+	"TankStart", "TankStop", "TankHit", "TankAim", "TankEvade", "TankGoto", "TankBecomeTeamLeader",
+	"TankBecomeTeamMember", "TankHelp", "GiveAmmo", "EvadeToFormation", "DisplayEntityInfo"
+};
+
+
+/////////////////////////////////////
+// Constructor
+
+CMessenger::CMessenger()
+{
+	m_EntityManager = 0;
+	m_Tick = 0;
+	ResetStats();
+}
+
 
 /////////////////////////////////////
 // Message sending/receiving
 
-// Send the given message to a particular UID, does not check if the UID exists
+// Send the given message to a particular UID. If an entity manager is set, a message to a UID
+// that does not exist is counted as orphaned and dropped
 void CMessenger::SendMessage( TEntityUID to, const SMessage& msg )
 {
+	GEN_PROFILE_ZONE( "CMessenger::SendMessage" );
+
+	SMessageTypeStats& stats = m_TypeStats[static_cast<TUInt32>(msg.type)];
+	++stats.sent;
+	++stats.sentThisTick;
+	if (m_EntityManager && !m_EntityManager->GetEntity( to ))
+	{
+		++stats.orphaned;
+		return;
+	}
+
 	// Simply insert the UID/message pair into the message map. It will be inserted next
 	// to any other pairs with the same UID
-	m_Messages.insert( UIDMsgPair( to, msg ) );
+	SQueuedMessage queued;
+	queued.message = msg;
+	queued.sentTick = m_Tick;
+	m_Messages.insert( UIDMsgPair( to, queued ) );
+	++stats.queued;
 }
 
 
-// Fetch the next available message for the given UID, returns the message through the given 
+// Fetch the next available message for the given UID, returns the message through the given
 // pointer. Returns false if there are no messages for this UID
 bool CMessenger::FetchMessage( TEntityUID to, SMessage* msg )
 {
+	GEN_PROFILE_ZONE( "CMessenger::FetchMessage" );
+
 	// Find the first message for this UID in the message map
 	TMessageIter itMessage = m_Messages.find( to );
 
@@ -42,12 +84,169 @@ bool CMessenger::FetchMessage( TEntityUID to, SMessage* msg )
 	}
 
 	// Return message, then delete it
-	*msg = itMessage->second;
+	*msg = itMessage->second.message;
+	SMessageTypeStats& stats = m_TypeStats[static_cast<TUInt32>(msg->type)];
+	++stats.fetched;
+	--stats.queued;
+	stats.latency.Record( m_Tick - itMessage->second.sentTick );
 	m_Messages.erase( itMessage );
 
 	return true;
 }
 
 
+// End of a game tick - message latencies are counted in ticks
+void CMessenger::EndTick()
+{
+	++m_Tick;
+	if (m_EntityManager && m_Tick % kOrphanSweepTicks == 0)
+	{
+		ReclaimOrphans();
+	}
+
+	TUInt32 queued = static_cast<TUInt32>(m_Messages.size());
+	m_PeakQueued = max( m_PeakQueued, queued );
+	for (TUInt32 type = 0; type < static_cast<TUInt32>(EMessageType::NumMessageTypes); ++type)
+	{
+		m_TypeStats[type].sentLastTick = m_TypeStats[type].sentThisTick;
+		m_TypeStats[type].sentThisTick = 0;
+	}
+}
+
+// Discard all messages queued for entities that no longer exist, returns the number discarded.
+// Steps from one recipient to the next, so the cost is a look-up per recipient not per message
+TUInt32 CMessenger::ReclaimOrphans()
+{
+	if (!m_EntityManager)
+	{
+		return 0;
+	}
+
+	TUInt32 numReclaimed = 0;
+	TMessageIter itMessage = m_Messages.begin();
+	while (itMessage != m_Messages.end())
+	{
+		TMessageIter itNextRecipient = m_Messages.upper_bound( itMessage->first );
+		if (!m_EntityManager->GetEntity( itMessage->first ))
+		{
+			for (TMessageIter itOrphan = itMessage; itOrphan != itNextRecipient; ++itOrphan)
+			{
+				SMessageTypeStats& stats = m_TypeStats[static_cast<TUInt32>(itOrphan->second.message.type)];
+				++stats.orphaned;
+				--stats.queued;
+				++numReclaimed;
+			}
+			m_Messages.erase( itMessage, itNextRecipient );
+		}
+		itMessage = itNextRecipient;
+	}
+	return numReclaimed;
+}
+
+
+/////////////////////////////////////
+// Statistics
+
+// Totals over all message types
+SMessengerStats CMessenger::GetStats() const
+{
+	SMessengerStats totals;
+	totals.tick = m_Tick;
+	totals.sent = 0;
+	totals.fetched = 0;
+	totals.orphaned = 0;
+	totals.queued = static_cast<TUInt32>(m_Messages.size());
+	totals.peakQueued = max( m_PeakQueued, totals.queued );
+	totals.sentLastTick = 0;
+	for (TUInt32 type = 0; type < static_cast<TUInt32>(EMessageType::NumMessageTypes); ++type)
+	{
+		totals.sent += m_TypeStats[type].sent;
+		totals.fetched += m_TypeStats[type].fetched;
+		totals.orphaned += m_TypeStats[type].orphaned;
+		totals.sentLastTick += m_TypeStats[type].sentLastTick;
+	}
+	return totals;
+}
+
+// Entities with at least the given number of messages waiting, most messages first
+vector<SMessageBacklog> CMessenger::GetBacklogs( TUInt32 minMessages /*= 1*/ ) const
+{
+	vector<SMessageBacklog> backlogs;
+	TMessageConstIter itMessage = m_Messages.begin();
+	while (itMessage != m_Messages.end())
+	{
+		SMessageBacklog backlog;
+		backlog.to = itMessage->first;
+		backlog.numMessages = 0;
+		backlog.oldestAge = 0;
+		for (; itMessage != m_Messages.end() && itMessage->first == backlog.to; ++itMessage)
+		{
+			++backlog.numMessages;
+			backlog.oldestAge = max( backlog.oldestAge, m_Tick - itMessage->second.sentTick );
+		}
+		if (backlog.numMessages >= minMessages)
+		{
+			backlogs.push_back( backlog );
+		}
+	}
+	sort( backlogs.begin(), backlogs.end(),
+	      []( const SMessageBacklog& a, const SMessageBacklog& b ) { return a.numMessages > b.numMessages; } );
+	return backlogs;
+}
+
+// One line per message type that has been sent, then the totals and the longest backlogs
+string CMessenger::Report() const
+{
+	stringstream report;
+	SMessengerStats totals = GetStats();
+	report << "Messages (" << totals.tick << " ticks)" << endl;
+	report << "  " << left << setw( 22 ) << "Type" << right << setw( 9 ) << "Sent" << setw( 9 ) << "Fetched"
+	       << setw( 9 ) << "Orphaned" << setw( 8 ) << "Queued" << setw( 12 ) << "Latency p50" << setw( 6 ) << "p99"
+	       << setw( 6 ) << "max" << endl;
+	for (TUInt32 type = 0; type < static_cast<TUInt32>(EMessageType::NumMessageTypes); ++type)
+	{
+		const SMessageTypeStats& stats = m_TypeStats[type];
+		if (stats.sent == 0)
+		{
+			continue;
+		}
+		report << "  " << left << setw( 22 ) << MessageTypeNames[type] << right << setw( 9 ) << stats.sent
+		       << setw( 9 ) << stats.fetched << setw( 9 ) << stats.orphaned << setw( 8 ) << stats.queued
+		       << setw( 12 ) << stats.latency.Percentile( 50.0 ) << setw( 6 ) << stats.latency.Percentile( 99.0 )
+		       << setw( 6 ) << stats.latency.Max() << endl;
+	}
+	report << "  Total: " << totals.sent << " sent, " << totals.fetched << " fetched, " << totals.orphaned
+	       << " orphaned, " << totals.queued << " queued (peak " << totals.peakQueued << ")" << endl;
+
+	vector<SMessageBacklog> backlogs = GetBacklogs();
+	for (TUInt32 backlog = 0; backlog < backlogs.size() && backlog < 5; ++backlog)
+	{
+		report << "  Backlog: entity " << backlogs[backlog].to << " has " << backlogs[backlog].numMessages
+		       << " waiting, oldest " << backlogs[backlog].oldestAge << " ticks" << endl;
+	}
+	return report.str();
+}
+
+// Zero the counts and latencies (messages still queued stay queued)
+void CMessenger::ResetStats()
+{
+	for (TUInt32 type = 0; type < static_cast<TUInt32>(EMessageType::NumMessageTypes); ++type)
+	{
+		SMessageTypeStats& stats = m_TypeStats[type];
+		stats.sent = 0;
+		stats.fetched = 0;
+		stats.orphaned = 0;
+		stats.queued = 0;
+		stats.sentLastTick = 0;
+		stats.sentThisTick = 0;
+		stats.latency.Clear();
+	}
+	for (TMessageConstIter itMessage = m_Messages.begin(); itMessage != m_Messages.end(); ++itMessage)
+	{
+		++m_TypeStats[static_cast<TUInt32>(itMessage->second.message.type)].queued;
+	}
+	m_PeakQueued = static_cast<TUInt32>(m_Messages.size());
+}
+
 
 } // namespace gen
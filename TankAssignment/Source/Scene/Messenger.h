@@ -7,9 +7,13 @@
 #pragma once
 
 #include <map>
+#include <vector>
+#include <string>
 using namespace std;
 
 #include "../Common/Defines.h"
+#include "../Common/LatencyHistogram.h"
+#include "../Common/MemoryTracker.h"
 #include "Entity.h"
 
 namespace gen
@@ -33,7 +37,9 @@ enum class EMessageType
 	Msg_GiveAmmo,				// give a tank ammo
 	Msg_EvadeToFormation,		// forces tanks to formation waypoints
 
-	Msg_DisplayEntityInfo		// display message to screen
+	Msg_DisplayEntityInfo,		// display message to screen
+
+	NumMessageTypes				// Number of message types, not a message
 };
 
 // A message contains a type and the UID that sent it.
@@ -62,6 +68,45 @@ struct SMessage
 };
 
 
+class CEntityManager;
+
+// Ticks between checks for messages queued for entities that no longer exist
+const TUInt32 kOrphanSweepTicks = 30;
+
+// Traffic of one message type since the stats were last reset. Latency is the number of ticks
+// (see CMessenger::EndTick) from sending a message to it being fetched
+struct SMessageTypeStats
+{
+	TUInt64           sent;
+	TUInt64           fetched;
+	TUInt64           orphaned;     // Sent to, or left queued for, an entity that no longer exists
+	TUInt32           queued;       // Waiting to be fetched now
+	TUInt32           sentLastTick;
+	TUInt32           sentThisTick;
+	CLatencyHistogram latency;
+};
+
+// Totals over all message types
+struct SMessengerStats
+{
+	TUInt32 tick;          // Ticks so far
+	TUInt64 sent;
+	TUInt64 fetched;
+	TUInt64 orphaned;
+	TUInt32 queued;
+	TUInt32 peakQueued;    // Most messages queued at the end of a tick
+	TUInt32 sentLastTick;
+};
+
+// Messages waiting for one entity
+struct SMessageBacklog
+{
+	TEntityUID to;
+	TUInt32    numMessages;
+	TUInt32    oldestAge;  // Ticks since the oldest was sent
+};
+
+
 // Messenger class allows the sending and receipt of messages between entities - addressed by UID
 class CMessenger
 {
@@ -69,7 +114,7 @@ class CMessenger
 //	Constructors/Destructors
 public:
 	// Default constructor
-	CMessenger() {}
+	CMessenger();
 
 	// No destructor needed
 
@@ -86,13 +131,51 @@ public:
 	/////////////////////////////////////
 	// Message sending/receiving
 
-	// Send the given message to a particular UID, does not check if the UID exists
+	// Entity manager used to check that recipients exist, 0 to not check (then messages are never
+	// orphaned)
+	void SetEntityManager( CEntityManager* entityManager )
+	{
+		m_EntityManager = entityManager;
+	}
+
+	// Send the given message to a particular UID. If an entity manager is set, a message to a UID
+	// that does not exist is counted as orphaned and dropped
 	void SendMessage( TEntityUID to, const SMessage& msg );
 
 	// Fetch the next available message for the given UID, returns the message through the given 
 	// pointer. Returns false if there are no messages for this UID
 	bool FetchMessage( TEntityUID to, SMessage* msg );
 
+	// End of a game tick - message latencies are counted in ticks. Every kOrphanSweepTicks, the
+	// messages of entities that have been destroyed since they were sent are discarded
+	void EndTick();
+
+	// Discard all messages queued for entities that no longer exist, returns the number discarded.
+	// Does nothing if no entity manager is set
+	TUInt32 ReclaimOrphans();
+
+
+	/////////////////////////////////////
+	// Statistics
+
+	const SMessageTypeStats& GetTypeStats( EMessageType type ) const
+	{
+		return m_TypeStats[static_cast<TUInt32>(type)];
+	}
+
+	// Totals over all message types
+	SMessengerStats GetStats() const;
+
+	// Entities with at least the given number of messages waiting, most messages first
+	vector<SMessageBacklog> GetBacklogs( TUInt32 minMessages = 1 ) const;
+
+	// One line per message type that has been sent, with its counts and latency percentiles,
+	// then the totals and the longest backlogs
+	string Report() const;
+
+	// Zero the counts and latencies (messages still queued stay queued)
+	void ResetStats();
+
 
 /////////////////////////////////////
 //	Private interface
@@ -103,11 +186,27 @@ private:
 	// key/value pairs in a multimap are sorted by key, which means all the messages for a
 	// particular UID are together. Key look-up is somewhat slower than for a hash map though
 	// Define some types to make usage easier
-	typedef multimap<TEntityUID, SMessage> TMessages;
+	// Each message is stored with the tick it was sent on
+	struct SQueuedMessage
+	{
+		SMessage message;
+		TUInt32  sentTick;
+	};
+	typedef multimap<TEntityUID, SQueuedMessage, less<TEntityUID>,
+	                 CTaggedAllocator<pair<const TEntityUID, SQueuedMessage>, EMemoryTag::Messages>> TMessages;
 	typedef TMessages::iterator TMessageIter;
-    typedef pair<TEntityUID, SMessage> UIDMsgPair; // The type stored by the multimap
+	typedef TMessages::const_iterator TMessageConstIter;
+    typedef pair<TEntityUID, SQueuedMessage> UIDMsgPair; // The type stored by the multimap
 
 	TMessages m_Messages;
+
+	// Checks recipients exist, may be 0
+	CEntityManager* m_EntityManager;
+
+	// Traffic statistics
+	SMessageTypeStats m_TypeStats[static_cast<TUInt32>(EMessageType::NumMessageTypes)];
+	TUInt32           m_Tick;
+	TUInt32           m_PeakQueued;
 };
 
 
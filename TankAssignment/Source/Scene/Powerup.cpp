@@ -1,5 +1,7 @@
 #include "Powerup.h"
 #include "TeamManager.h"
+#include "EmitterPool.h"
+#include "../Common/Profiler.h"
 
 namespace gen
 {
@@ -7,11 +9,13 @@ namespace gen
 const TFloat32 powerupRotationSpeed = ToRadians( 30.0f );
 const CVector3 hiddenPos = {0, -100, 0 };
 const TFloat32 powerupCollisionDistance = 5.0f;
+const TFloat32 powerupRespawnTime = 10.0f;
 
 // externs
 extern CTeamManager TeamManager;
 extern CEntityManager EntityManager;
 extern CMessenger Messenger;
+extern CEmitterPool ParticleEffects;
 
 CPowerupEntity::CPowerupEntity
 (
@@ -25,9 +29,14 @@ CPowerupEntity::CPowerupEntity
 {
 	m_UID = UID;
 	m_State = state::active;
+	m_DefaultPos = position;
+	m_RespawnTimer = powerupRespawnTime;
+	m_CurrentTimer = 0.0f;
 }
 bool CPowerupEntity::Update(TFloat32 updateTime)
 {
+	GEN_PROFILE_ZONE("CPowerupEntity::Update");
+
 	if (m_State == state::active)
 	{
 		// rotate
@@ -49,10 +58,12 @@ bool CPowerupEntity::Update(TFloat32 updateTime)
 					msg.type = EMessageType::Msg_GiveAmmo;
 					msg.from = m_UID;
 					Messenger.SendMessage(tankUID, msg);
+					ParticleEffects.StartEffect(EParticleEffect::AmmoPickup, Position());
 
-					// go to respawning
+					// go to respawning, back where it was (the level places powerups after creating them)
 					m_State = state::respawning;
 					m_CurrentTimer = m_RespawnTimer;
+					m_DefaultPos = Position();
 					Matrix().SetPosition(hiddenPos);
 
 					return true; // no need to continue
@@ -76,4 +87,14 @@ bool CPowerupEntity::Update(TFloat32 updateTime)
 	// you must live
 	return true;
 }
+
+void CPowerupEntity::HashState(CStateHash* hash)
+{
+	CEntity::HashState(hash);
+	hash->Add(m_State);
+	if (m_State == state::respawning)
+	{
+		hash->Add(m_CurrentTimer);
+	}
+}
 }
\ No newline at end of file
@@ -30,6 +30,7 @@ public:
 	);
 
 	virtual bool Update(TFloat32 updateTime);
+	virtual void HashState(CStateHash* hash);	// adds state and respawn time to the hash
 
 private:
 	TEntityUID m_UID;			// my uid
@@ -9,10 +9,12 @@
 #include "EntityManager.h"
 #include "Messenger.h"
 #include "TeamManager.h"
+#include "../Common/Profiler.h"
 
 namespace gen
 {
-const TFloat32 bulletCollisionRadious = 3.0f;
+// Radius of the shell for collision against the bounding boxes of each part of a tank
+const TFloat32 shellCollisionRadius = 0.5f;
 
 // Reference to entity manager from TankAssignment.cpp, allows look up of entities by name, UID etc.
 // Can then access other entity's data. See the CEntityManager.h file for functions. Example:
@@ -49,6 +51,7 @@ CShellEntity::CShellEntity
 	// Initialise any shell data you add
 	m_Speed = 50.0f;
 	m_Life = 3.0f;
+	m_OwnerUID = SystemUID;
 }
 
 
@@ -57,7 +60,10 @@ CShellEntity::CShellEntity
 // Return false if the entity is to be destroyed
 bool CShellEntity::Update( TFloat32 updateTime )
 {
-	// movement
+	GEN_PROFILE_ZONE( "CShellEntity::Update" );
+
+	// movement, hits are tested along the whole move so a long update can't skip over a tank
+	CVector3 oldPosition = Position();
 	Matrix().MoveLocalZ(m_Speed * updateTime);
 
 	// hit detection
@@ -68,8 +74,10 @@ bool CShellEntity::Update( TFloat32 updateTime )
 		for (int j = 0; j < teamSize; ++j)
 		{
 			auto tankUID = TeamManager.GetTankUID(i, j);
+			if (tankUID == m_OwnerUID)
+				continue; // fired from inside its own tank's barrel
 			auto tank = EntityManager.GetEntity(tankUID);
-			if (tank != nullptr && Distance(Position(), tank->Position()) < bulletCollisionRadious)
+			if (tank != nullptr && tank->IntersectsMovingSphere(oldPosition, Position(), shellCollisionRadius))
 			{
 				SMessage msg;
 				msg.type = EMessageType::Msg_TankHit;
@@ -91,4 +99,13 @@ void CShellEntity::BulletOwner(TEntityUID tank)
 {
 	m_OwnerUID = tank;
 }
+
+// Add the shell's owner, speed and life left to the given hash
+void CShellEntity::HashState( CStateHash* hash )
+{
+	CEntity::HashState( hash );
+	hash->Add( m_OwnerUID );
+	hash->Add( m_Speed );
+	hash->Add( m_Life );
+}
 } // namespace gen
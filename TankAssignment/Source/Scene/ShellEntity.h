@@ -63,6 +63,9 @@ public:
 	// Keep as a virtual function in case of further derivation
 	virtual bool Update( TFloat32 updateTime );
 
+	// Add the shell's owner, speed and life left to the given hash
+	virtual void HashState( CStateHash* hash );
+
 	// store to which tank shot it, a kind of sudo ownership
 	void BulletOwner(TEntityUID tank); 
 	
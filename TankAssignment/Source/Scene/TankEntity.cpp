@@ -33,6 +33,8 @@
 #include "../Math/CVector3.h"	// temp for waypoints
 #include "../Math/CRay.h"		// Ray
 #include "TeamManager.h"// team manager
+#include "EmitterPool.h"   // particle effects
+#include "../Common/Profiler.h" // timing zones
 
 #include <random>		// random for random pos
 
@@ -77,6 +79,9 @@ extern CVector3 GetWaypoint(unsigned int team, unsigned int waypoint);
 // ray
 extern CRay Ray;
 
+// particle effects
+extern CEmitterPool ParticleEffects;
+
 /*-----------------------------------------------------------------------------------------
 -------------------------------------------------------------------------------------------
 	Tank Entity Class
@@ -206,6 +211,8 @@ void CTankEntity::GetPatrolWaypoint()
 // Return false if the entity is to be destroyed
 bool CTankEntity::Update( TFloat32 updateTime )
 {
+	GEN_PROFILE_ZONE( "CTankEntity::Update" );
+
 	if (m_State == EState::Dying)
 	{
 		// blow off top and then disapear
@@ -253,12 +260,22 @@ bool CTankEntity::Update( TFloat32 updateTime )
 				else
 					m_HP -= defaultBulletDamage;
 
+				CVector3 hitCentre;
+				TFloat32 hitRadius;
+				GetBoundingSphere(&hitCentre, &hitRadius);
+				ParticleEffects.StartEffect(EParticleEffect::ShellImpact, hitCentre);
+
 				if (m_HP <= 0)
 				{
-					// dye
+					// dye - explosion from the turret as it is blown off
 					m_HP = 0;
 					TeamManager.UpdateMembership(m_Team);
 					m_State = EState::Dying;
+
+					CVector3 turretCentre;
+					TFloat32 turretRadius;
+					GetNodeBoundingSphere(2, &turretCentre, &turretRadius);
+					ParticleEffects.StartEffect(EParticleEffect::TankDeath, turretRadius >= 0.0f ? turretCentre : Position());
 				}
 				else
 				{
@@ -303,8 +320,9 @@ bool CTankEntity::Update( TFloat32 updateTime )
 			{
 				m_State = EState::Evade;
 				auto hurtTank = EntityManager.GetEntity(msg.from);
-				auto normalVectorToTarget = Normalise(hurtTank->Position() - Position());
-				m_TargetPosition = hurtTank->Position() - normalVectorToTarget * teamMemberSpace;
+				const CVector3& hurtPosition = hurtTank->Position();
+				auto normalVectorToTarget = Normalise(hurtPosition - Position());
+				m_TargetPosition = MultiplyAdd(hurtPosition, normalVectorToTarget, -teamMemberSpace);
 			}
 
 			else if (msg.type == EMessageType::Msg_GiveAmmo)
@@ -403,7 +421,7 @@ bool CTankEntity::Update( TFloat32 updateTime )
 				if (distance <= bulletDistance && !Ray.HitBuilding(Position(), turret.ZAxis(), enemy->Position()))
 				{
 					// fire
-					auto bulletUID = EntityManager.CreateShell("Shell Type 1", "Bullet", turret.Position() + turret.ZAxis() * barrelLenght, CVector3(0, 0, 0));
+					auto bulletUID = EntityManager.CreateShell("Shell Type 1", "Bullet", MultiplyAdd(turret.Position(), turret.ZAxis(), barrelLenght), CVector3(0, 0, 0));
 					auto bullet = EntityManager.GetEntity(bulletUID);
 					bullet->Matrix().FaceDirection(turret.ZAxis());
 					auto shell = dynamic_cast<CShellEntity*>(bullet);
@@ -494,4 +512,26 @@ bool CTankEntity::Update( TFloat32 updateTime )
 }
 
 
+// Add the tank's movement, health, ammo, AI state and team membership to the given hash
+void CTankEntity::HashState( CStateHash* hash )
+{
+	CEntity::HashState( hash );
+	hash->Add( m_Team );
+	hash->Add( m_Speed );
+	hash->Add( m_TurnSpeed );
+	hash->Add( m_TurretSpeed );
+	hash->Add( m_HP );
+	hash->Add( m_Ammo );
+	hash->Add( m_State );
+	hash->Add( m_Timer );
+	hash->Add( m_Countdown );
+	hash->Add( m_MemberState );
+	hash->Add( m_TeamMemberNumber );
+	hash->Add( m_Waypoint );
+	hash->Add( m_TargetPosition );
+	hash->Add( m_Target );
+	hash->Add( m_DeathVec );
+}
+
+
 } // namespace gen
@@ -35,11 +35,11 @@ public:
 	// turn speed and passes the other parameters to construct the base class
 	CTankTemplate
 	(
-		const string& type, const string& name, const string& meshFilename,
+		const string& type, const string& name, const string& meshFilename, CAssetCache* assets,
 		TFloat32 maxSpeed, TFloat32 acceleration, TFloat32 turnSpeed,
 		TFloat32 turretTurnSpeed, TUInt32 maxHP, TUInt32 shellDamage, 
 		TFloat32 shellAmmo, TFloat32 deceleration = 0.8f
-	) : CEntityTemplate( type, name, meshFilename )
+	) : CEntityTemplate( type, name, meshFilename, assets )
 	{
 		// Set tank template values
 		m_MaxSpeed = maxSpeed;
@@ -234,6 +234,9 @@ public:
 	// Return false if the entity is to be destroyed
 	// Keep as a virtual function in case of further derivation
 	virtual bool Update( TFloat32 updateTime );
+
+	// Add the tank's movement, health, ammo, AI state and team membership to the given hash
+	virtual void HashState( CStateHash* hash );
 	
 
 /////////////////////////////////////
@@ -28,6 +28,15 @@ int gen::CTeamManager::AddTank(TEntityUID tankUID, int team)
 	return m_TeamSizes[team]++;
 }
 
+void gen::CTeamManager::Clear()
+{
+	m_NumOfTeams = 0;
+	m_Teams.clear();
+	m_TeamSizes.clear();
+	m_TeamLeaders.clear();
+	m_TeamFormation.clear();
+}
+
 int gen::CTeamManager::GetTeamSize(int team)
 {
 	if (m_NumOfTeams < team)
@@ -117,3 +126,15 @@ void gen::CTeamManager::ChangeFormation(int team)
 	// update overload if extra states added
 	m_TeamFormation.at(team) = ++m_TeamFormation.at(team);
 }
+
+void gen::CTeamManager::HashState(CStateHash* hash)
+{
+	hash->Add(m_NumOfTeams);
+	for (int i = 0; i < m_NumOfTeams; ++i)
+	{
+		hash->Add(m_TeamSizes[i]);
+		hash->AddBytes(m_Teams[i].data(), m_Teams[i].size() * sizeof(TEntityUID));
+		hash->Add(m_TeamLeaders[i]);
+		hash->Add(m_TeamFormation[i]);
+	}
+}
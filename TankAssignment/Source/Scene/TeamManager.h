@@ -50,8 +50,10 @@ public:
 	CVector3 GetTankPos(int team, int memberNumber);
 
 	int AddTank(TEntityUID tankUID, int team);	// adds a tank to a team
+	void Clear();								// removes all teams, e.g. when the level is unloaded
 	bool UpdateMembership(int team);			// checks team leader, re-asign team leader if ther is none and updates position in team
 	void ChangeFormation(int team);						// rotate between team formations
+	void HashState(CStateHash* hash);					// adds the teams, leaders and formations to the hash
 };
 }
 
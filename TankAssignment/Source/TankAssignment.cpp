@@ -5,6 +5,7 @@
 ********************************************/
 
 #include <sstream>
+#include <iomanip>
 #include <string>
 using namespace std;
 
@@ -19,9 +20,16 @@ using namespace std;
 #include "Messenger.h"
 #include "TankAssignment.h"
 #include "CParseLevel.h"
+#include "CThreadPool.h"
+#include "CTimer.h"
+#include "Profiler.h"
+#include "FrameStats.h"
+#include "MemoryTracker.h"
 #include "CRay.h"
 #include "TeamManager.h"
 #include "CParticalSystem.h"
+#include "ParticlePresetFile.h"
+#include "RenderBackendD3D10.h"
 
 namespace gen
 {
@@ -37,6 +45,9 @@ float CameraMoveSpeed = 80.0f;
 // Amount of time to pass before calculating new average update time
 const float UpdateTimePeriod = 1.0f;
 
+// File the profiler's recording is written to, see SaveProfile
+const string ProfileTraceFile = "Profile.json";
+
 
 //-----------------------------------------------------------------------------
 // Global system variables
@@ -59,6 +70,9 @@ extern CVector2 MousePixel;
 // Messenger class for sending messages to and between entities
 extern CMessenger Messenger;
 
+// Folder for all texture, mesh and preset files
+extern const string MediaFolder;
+
 
 //-----------------------------------------------------------------------------
 // Global game/scene variables
@@ -67,20 +81,39 @@ extern CMessenger Messenger;
 // Entity manager and level parser
 CEntityManager EntityManager;
 
+// Draws the entity manager's render queue with DirectX
+CRenderBackendD3D10 RenderBackend;
+
 // Tank UIDs
 CTeamManager TeamManager(&EntityManager);
 
 // Parse level
 CParseLevel LevelParser(&EntityManager, &TeamManager);
 
+// Time taken by each phase of scene setup, see StartupReport
+SLevelLoadTimes LevelLoadTimes = { 0.0f, 0.0f, 0.0f, 0.0f };
+float MethodsSetupTime = 0.0f;
+float MeshImportTime = 0.0f;
+float MeshResourceTime = 0.0f;
+TUInt32 LoadThreadCount = 1;
+
+// Geometry memory used by the meshes once loaded (before their CPU copies are released)
+SMeshMemory MeshMemory = { 0, 0, 0, 0, 0, 0 };
+
 // ray
 CRay Ray(&EntityManager);
 
-// partical system
-//CParticalSystem ParticalSystem;
+// partical system - the GPU fountain is unused, but its shaders draw the CPU effects
+CParticalSystem ParticalSystem;
+
+// Particle effects started by gameplay events (shell hits, deaths, pickups)
+CEmitterPool ParticleEffects;
+
+// Compiled effect presets, if any. Kept open while the effects use them
+CParticlePresetFile ParticlePresets;
 
 // Tank waypoints - list of lists of CVectro3 variable(team)(wapoint)
-vector<vector<CVector3>> TeamWaypoints;
+TTeamWaypoints TeamWaypoints;
 
 // Other scene elements
 const int NumLights = 2;
@@ -96,8 +129,12 @@ float SumUpdateTimes = 0.0f;
 int NumUpdateTimes = 0;
 float AverageUpdateTime = -1.0f; // Invalid value at first
 
+// Update and render times of each tick, for percentiles over the last few seconds and the whole run
+CFrameStats FrameStats;
+
 // User Interface
 bool ExtendedInfo = true;
+bool ShowFrameStats = false;
 TEntityUID nearestTank = -1;
 TEntityUID currentlySelectedTank = -1;
 CVector3 MouseTarget3DPos;
@@ -109,31 +146,80 @@ CVector3 MouseTarget3DPos;
 // Creates the scene geometry
 bool SceneSetup()
 {
-	//////////////////////////////////////////////
-	// Prepare render methods
-
-	InitialiseMethods();
+	return SimulationSetup() && RenderSetup();
+}
 
+// Creates the entities, teams and camera from the given level file - everything needed to update
+// the scene. Needs no device, and mesh geometry is not loaded (only the mesh layouts)
+bool SimulationSetup( const string& levelFile /*= "Entities.xml"*/ )
+{
 	//////////////////////////////////////////////
-	// Parse level's XML
-	LevelParser.ParseFile("Entities.xml");
+	// Parse level's XML, reading the template meshes on all cores
+	CThreadPool loadThreads;
+	LoadThreadCount = loadThreads.NumThreads();
+	LevelParser.LoadLevel(levelFile, &loadThreads, &LevelLoadTimes);
 
 	//////////////////////////////////////////////
 	// Setups
 	Ray.Setup();
+	Messenger.SetEntityManager(&EntityManager); // Drop messages to destroyed entities
 	const int teams = TeamManager.GetNumberOfTeams();
 	for(int i = 0; i < teams; ++i)
 		TeamManager.UpdateMembership(i);
-	//ParticalSystem.Setup();
+
+	// Effects with a compiled preset use it in place of the built-in description
+	if (ParticlePresets.Open( MediaFolder + "ParticlePresets.pfx" ))
+	{
+		for (int effect = 0; effect < static_cast<int>(EParticleEffect::NumEffects); ++effect)
+		{
+			EParticleEffect particleEffect = static_cast<EParticleEffect>(effect);
+			ParticleEffects.SetEffectDesc( particleEffect, ParticlePresets.Find( ParticleEffectName( particleEffect ) ) );
+		}
+	}
 
 
 	/////////////////////////////
-	// Camera / light setup
+	// Camera setup
 
 	// Set camera position and clip planes
 	MainCamera = new CCamera(CVector3(0.0f, 30.0f, -100.0f), CVector3(ToRadians(15.0f), 0, 0));
 	MainCamera->SetNearFarClip(1.0f, 20000.0f);
 
+	return true;
+}
+
+// Prepares for rendering the scene set up by SimulationSetup - render methods, lights and mesh
+// geometry. Requires a device
+bool RenderSetup()
+{
+	//////////////////////////////////////////////
+	// Prepare render methods
+
+	CTimer timer;
+	InitialiseMethods();
+	EntityManager.SetRenderBackend( &RenderBackend );
+	if (!ParticalSystem.Setup( ParticleEffects.ParticleBudget() ))
+	{
+		return false;
+	}
+	MethodsSetupTime = timer.GetLapTime();
+
+	// Load all meshes up front rather than as each is first seen. The files are imported on all
+	// cores, the DirectX resources are then created on this thread
+	CThreadPool loadThreads;
+	if (!EntityManager.LoadAllMeshes( &loadThreads, &MeshImportTime, &MeshResourceTime ))
+	{
+		return false;
+	}
+
+	// Each mesh keeps its positions and faces on the CPU for collision and enumeration, so read
+	// the memory used once all are loaded and any over the cache's CPU budget have been evicted
+	MeshMemory = EntityManager.AssetCache().GetMeshMemory();
+
+
+	/////////////////////////////
+	// Light setup
+
 	// Sunlight and light in building
 	Lights[0] = new CLight(CVector3(-5000.0f, 4000.0f, -10000.0f), SColourRGBA(1.0f, 0.9f, 0.6f), 15000.0f);
 	Lights[1] = new CLight(CVector3(6.0f, 7.5f, 40.0f), SColourRGBA(1.0f, 0.0f, 0.0f), 1.0f);
@@ -161,6 +247,48 @@ CVector3 GetWaypoint(unsigned int team, unsigned int waypoint)
 }
 
 
+// Report of the time taken by each phase of scene setup, one phase per line, and the memory used
+// by the mesh geometry. Phases that have not been run show as zero
+string StartupReport()
+{
+	stringstream report;
+	report << fixed << setprecision( 1 );
+	report << "Startup (" << LoadThreadCount << " loading threads)" << endl;
+	report << "  Parse level:       " << LevelLoadTimes.parse * 1000.0f << "ms" << endl;
+	report << "  Mesh layouts:      " << LevelLoadTimes.layouts * 1000.0f << "ms" << endl;
+	report << "  Create templates:  " << LevelLoadTimes.templates * 1000.0f << "ms" << endl;
+	report << "  Create entities:   " << LevelLoadTimes.entities * 1000.0f << "ms" << endl;
+	report << "  Render methods:    " << MethodsSetupTime * 1000.0f << "ms" << endl;
+	report << "  Mesh import:       " << MeshImportTime * 1000.0f << "ms" << endl;
+	report << "  Mesh resources:    " << MeshResourceTime * 1000.0f << "ms" << endl;
+
+	// Compressed sizes against those of uncompressed vertices / a full CPU copy
+	report << "Mesh memory" << endl;
+	report << "  GPU vertices:      " << MeshMemory.gpuVertices / 1024.0f << "KB (uncompressed "
+	       << MeshMemory.gpuVerticesFull / 1024.0f << "KB)" << endl;
+	report << "  GPU indices:       " << MeshMemory.gpuIndices / 1024.0f << "KB" << endl;
+	report << "  CPU vertices:      " << MeshMemory.cpuVertices / 1024.0f << "KB (full copy "
+	       << MeshMemory.cpuVerticesFull / 1024.0f << "KB)" << endl;
+	report << "  CPU faces:         " << MeshMemory.cpuIndices / 1024.0f << "KB" << endl;
+	return report.str();
+}
+
+// Write the zones recorded by the profiler to a Chrome trace file (ProfileTraceFile) and return a
+// table of the most expensive zones
+string SaveProfile()
+{
+	string report = Profiler.SummaryReport();
+	if (Profiler.WriteChromeTrace( ProfileTraceFile ))
+	{
+		report += "Trace written to " + ProfileTraceFile + "\n";
+	}
+	else
+	{
+		report += "Cannot write trace to " + ProfileTraceFile + "\n";
+	}
+	return report;
+}
+
 // Release everything in the scene
 void SceneShutdown()
 {
@@ -171,14 +299,31 @@ void SceneShutdown()
 	for (int light = NumLights - 1; light >= 0; --light)
 	{
 		delete Lights[light];
+		Lights[light] = 0;
 	}
 
 	// Release camera
 	delete MainCamera;
+	MainCamera = 0;
+
+	// Stop any effects still running, then release the presets they may use
+	ParticleEffects.StopAll();
+	for (int effect = 0; effect < static_cast<int>(EParticleEffect::NumEffects); ++effect)
+	{
+		ParticleEffects.SetEffectDesc( static_cast<EParticleEffect>(effect), 0 );
+	}
+	ParticlePresets.Close();
 
-	// Destroy all entities
+	// Destroy all entities, then the teams, waypoints, messages and selections that refer to them,
+	// so another level can be set up
 	EntityManager.DestroyAllEntities();
 	EntityManager.DestroyAllTemplates();
+	TeamManager.Clear();
+	TeamWaypoints.clear();
+	Messenger.ReclaimOrphans();
+	nearestTank = -1;
+	currentlySelectedTank = -1;
+	currentTankWatched[0] = currentTankWatched[1] = 0;
 }
 
 
@@ -186,6 +331,39 @@ void SceneShutdown()
 // Game Helper functions
 //-----------------------------------------------------------------------------
 
+// Send a system message of the given type to every tank in every team
+void SendToAllTanks( EMessageType type )
+{
+	const int NumOfTeams = TeamManager.GetNumberOfTeams();
+	SMessage msg;
+	msg.type = type;
+	msg.from = SystemUID;
+	for (int i = 0; i < NumOfTeams; ++i)
+	{
+		const int teamSize = TeamManager.GetTeamSize(i);
+		for (int j = 0; j < teamSize; ++j)
+		{
+			const auto tankUID = TeamManager.GetTankUID(i, j);
+			Messenger.SendMessage(tankUID, msg);
+		}
+	}
+}
+
+// Start every tank patrolling, as the 1 key does
+void StartAllTanks()
+{
+	SendToAllTanks(EMessageType::Msg_TankStart);
+}
+
+// Hash of the state of every entity and team
+TUInt64 SceneStateHash()
+{
+	CStateHash hash;
+	EntityManager.HashState( &hash );
+	TeamManager.HashState( &hash );
+	return hash.Value();
+}
+
 
 
 //-----------------------------------------------------------------------------
@@ -195,6 +373,8 @@ void SceneShutdown()
 // Draw one frame of the scene
 void RenderScene( float updateTime )
 {
+	GEN_PROFILE_ZONE( "RenderScene" );
+
 	// Setup the viewport - defines which part of the back-buffer we will render to (usually all of it)
 	D3D10_VIEWPORT vp;
 	vp.Width  = ViewportWidth;
@@ -221,8 +401,10 @@ void RenderScene( float updateTime )
 	SetAmbientLight(AmbientLight);
 	SetLights(&Lights[0]);
 
-	// Render entities and draw on-screen text
-	EntityManager.RenderAllEntities();
+	// Render entities and draw on-screen text. Levels of detail allow up to a pixel of error
+	EntityManager.SetLodSelection( 1.0f, ViewportHeight );
+	EntityManager.RenderAllEntities( MainCamera );
+	ParticalSystem.RenderEffects( ParticleEffects );
 	RenderSceneText( updateTime );
 	//ParticalSystem.Render();
 
@@ -322,7 +504,27 @@ void RenderSceneText( float updateTime )
 	// Write FPS text string
 	if (AverageUpdateTime >= 0.0f)
 	{
-		outText << "Frame Time: " << AverageUpdateTime * 1000.0f << "ms" << endl << "FPS:" << 1.0f / AverageUpdateTime;
+		outText << "Frame Time: " << AverageUpdateTime * 1000.0f << "ms" << endl << "FPS:" << 1.0f / AverageUpdateTime
+		        << (Profiler.IsRecording() ? "  (profiling)" : "");
+		outText << endl << "Visible: " << EntityManager.VisibleEntities().size() << '/' << EntityManager.NumEntities();
+		outText << endl << "Triangles: " << EntityManager.SubmittedTriangles() << " ("
+		        << EntityManager.FullDetailTriangles() << " at full detail)";
+		CAssetCache& assets = EntityManager.AssetCache();
+		outText << endl << "Meshes: " << assets.NumMeshes() << " (" << assets.GetStats().meshHits << " shared)"
+		        << "  Textures: " << assets.NumTextures() << " (" << assets.GetStats().textureHits << " shared)";
+		outText << endl << "Effects: " << ParticleEffects.NumActiveEmitters() << " emitters, "
+		        << ParticleEffects.NumLiveParticles() << '/' << ParticleEffects.ParticleBudget() << " particles ("
+		        << ParticleEffects.GetStats().emittersCulled << " culled)"
+		        << (ParticalSystem.GetSortEffects() ? " sorted" : "");
+		SMessengerStats messages = Messenger.GetStats();
+		outText << endl << "Messages: " << messages.sentLastTick << " last tick, " << messages.queued << " queued, "
+		        << messages.orphaned << " orphaned";
+		outText << endl << "Memory: " << MemoryTracker.LiveBytes() / 1024 << "KB tagged, "
+		        << MemoryTracker.AllocationsLastTick() << " allocations last tick";
+		if (ShowFrameStats)
+		{
+			outText << endl << "Last " << FrameStats.WindowTime() << "s" << endl << FrameStats.Report();
+		}
 		RenderText( outText.str(), 2, 2, 0.0f, 0.0f, 0.0f );
 		RenderText( outText.str(), 0, 0, 1.0f, 1.0f, 0.0f );
 		outText.str("");
@@ -333,8 +535,11 @@ void RenderSceneText( float updateTime )
 // Update the scene between rendering
 void UpdateScene( float updateTime )
 {
+	GEN_PROFILE_ZONE( "UpdateScene" );
+
 	// Call all entity update functions
 	EntityManager.UpdateAllEntities( updateTime );
+	ParticleEffects.Update( updateTime );
 	//ParticalSystem.Update(updateTime);
 
 	// Picker
@@ -366,37 +571,13 @@ void UpdateScene( float updateTime )
 	// Go
 	if (KeyHit(Key_1))
 	{
-		const int NumOfTeams = TeamManager.GetNumberOfTeams();
-		SMessage msg;
-		msg.type = EMessageType::Msg_TankStart;
-		msg.from = SystemUID;
-		for (int i = 0; i < NumOfTeams; ++i)
-		{
-			const int teamSize = TeamManager.GetTeamSize(i);
-			for (int j = 0; j < teamSize; ++j)
-			{
-				const auto tankUID = TeamManager.GetTankUID(i, j);
-				Messenger.SendMessage(tankUID, msg);
-			}
-		}
+		StartAllTanks();
 	}
 
 	// Stop
 	if (KeyHit(Key_2))
 	{
-		const int NumOfTeams = TeamManager.GetNumberOfTeams();
-		SMessage msg;
-		msg.type = EMessageType::Msg_TankStop;
-		msg.from = SystemUID;
-		for (int i = 0; i < NumOfTeams; ++i)
-		{
-			const int teamSize = TeamManager.GetTeamSize(i);
-			for (int j = 0; j < teamSize; ++j)
-			{
-				const auto tankUID = TeamManager.GetTankUID(i, j);
-				Messenger.SendMessage(tankUID, msg);
-			}
-		}
+		SendToAllTanks(EMessageType::Msg_TankStop);
 	}
 
 	// Aim
@@ -502,6 +683,20 @@ void UpdateScene( float updateTime )
 	//if (KeyHit(Key_F4))
 		//ParticalSystem.ResetParticles();
 
+	// Effects sorted back to front and alpha blended, or additive
+	if (KeyHit(Key_F5))
+		ParticalSystem.SetSortEffects(!ParticalSystem.GetSortEffects());
+
+	// Profiler recording on / off, and write what it has recorded (last few seconds)
+	if (KeyHit(Key_F6))
+		Profiler.SetRecording(!Profiler.IsRecording());
+	if (KeyHit(Key_F7))
+		OutputDebugStringA(SaveProfile().c_str());
+
+	// Update / render time percentiles on screen
+	if (KeyHit(Key_F8))
+		ShowFrameStats = !ShowFrameStats;
+
 	// Update chase cam
 	if (chaseCam)
 	{
@@ -519,5 +714,9 @@ void UpdateScene( float updateTime )
 		MainCamera->Control(Key_Up, Key_Down, Key_Left, Key_Right, Key_W, Key_S, Key_A, Key_D,
 			CameraMoveSpeed * updateTime, CameraRotSpeed * updateTime);
 	}
+
+	// Message latencies and allocation rates are counted in these ticks
+	Messenger.EndTick();
+	MemoryTracker.EndTick();
 }
 } // namespace gen
@@ -6,6 +6,11 @@
 
 #pragma once
 
+#include <string>
+using namespace std;
+
+#include "Defines.h"
+
 namespace gen
 {
 
@@ -15,9 +20,36 @@ namespace gen
 // Creates the scene geometry
 bool SceneSetup();
 
-// Release everything in the scene
+// Creates the entities, teams and camera from the given level file - everything needed to update
+// the scene. Needs no device, and mesh geometry is not loaded (only the mesh layouts)
+bool SimulationSetup( const string& levelFile = "Entities.xml" );
+
+// Prepares for rendering the scene set up by SimulationSetup - render methods, lights and mesh
+// geometry. Requires a device
+bool RenderSetup();
+
+// Report of the time taken by each phase of scene setup, one phase per line, and the memory used
+// by the mesh geometry
+string StartupReport();
+
+// Write the zones recorded by the profiler to a Chrome trace file and return a table of the most
+// expensive zones
+string SaveProfile();
+
+// Release everything in the scene. Another level may then be set up
 void SceneShutdown();
 
+///////////////////////////////
+// Game helper functions
+
+// Start every tank patrolling, as the 1 key does
+void StartAllTanks();
+
+// Hash of the state of every entity and team, see CStateHash. Two runs of the same level with the
+// same random seed and update times give the same hash at each tick unless the game's behaviour
+// has changed
+TUInt64 SceneStateHash();
+
 ///////////////////////////////
 // Game loop functions
 
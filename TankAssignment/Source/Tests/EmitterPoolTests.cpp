@@ -0,0 +1,98 @@
+/*******************************************
+	EmitterPoolTests.cpp
+
+	Tests of the particle emitter pool's
+	culling when the emitters or particle
+	budget run out
+********************************************/
+
+#include <gtest/gtest.h>
+
+#include "EmitterPool.h"
+
+using namespace gen;
+
+namespace
+{
+
+// A long-running effect with the given priority and particle budget, that spawns nothing so
+// tests are not affected by particle lifetimes
+SParticleEffectDesc EffectDesc( TUInt32 priority, TUInt32 maxParticles )
+{
+	SParticleEffectDesc desc = {};
+	desc.priority = priority;
+	desc.maxParticles = maxParticles;
+	desc.emitTime = 100.0f;
+	desc.minLife = desc.maxLife = 1.0f;
+	desc.shape = EEmitterShape::Point;
+	return desc;
+}
+
+} // namespace
+
+
+TEST( EmitterPool, CullsLowerPriorityToMakeRoom )
+{
+	CEmitterPool pool( 600 );
+	SParticleEffectDesc high = EffectDesc( 3, 512 );
+	SParticleEffectDesc low = EffectDesc( 1, 64 );
+	SParticleEffectDesc medium = EffectDesc( 2, 80 );
+
+	ASSERT_TRUE( pool.StartEffect( high, CVector3::kZero ) );
+	ASSERT_TRUE( pool.StartEffect( low, CVector3::kZero ) );
+
+	// 576 reserved, culling the low priority emitter leaves room for 80 more
+	EXPECT_TRUE( pool.StartEffect( medium, CVector3::kZero ) );
+	EXPECT_EQ( 2u, pool.NumActiveEmitters() );
+	EXPECT_EQ( 1u, pool.GetStats().emittersCulled );
+	EXPECT_EQ( 0u, pool.GetStats().effectsDropped );
+}
+
+TEST( EmitterPool, KeepsRunningEffectsWhenCullingCannotMakeRoom )
+{
+	CEmitterPool pool( 600 );
+	SParticleEffectDesc high = EffectDesc( 3, 512 );
+	SParticleEffectDesc low = EffectDesc( 1, 32 );
+	SParticleEffectDesc medium = EffectDesc( 2, 128 );
+
+	ASSERT_TRUE( pool.StartEffect( high, CVector3::kZero ) );
+	ASSERT_TRUE( pool.StartEffect( low, CVector3::kZero ) );
+	ASSERT_TRUE( pool.StartEffect( low, CVector3::kZero ) );
+
+	// 576 reserved, culling both low priority emitters would only leave room for 88
+	EXPECT_FALSE( pool.StartEffect( medium, CVector3::kZero ) );
+	EXPECT_EQ( 3u, pool.NumActiveEmitters() );
+	EXPECT_EQ( 0u, pool.GetStats().emittersCulled );
+	EXPECT_EQ( 1u, pool.GetStats().effectsDropped );
+}
+
+TEST( EmitterPool, KeepsRunningEffectsWhenNoEmitterCanBeFreed )
+{
+	CEmitterPool pool( kMaxEmitters * kMaxEmitterParticles );
+	SParticleEffectDesc high = EffectDesc( 3, 1 );
+	SParticleEffectDesc low = EffectDesc( 1, 1 );
+	for (TUInt32 emitter = 0; emitter < kMaxEmitters; ++emitter)
+	{
+		ASSERT_TRUE( pool.StartEffect( high, CVector3::kZero ) );
+	}
+
+	EXPECT_FALSE( pool.StartEffect( low, CVector3::kZero ) );
+	EXPECT_EQ( kMaxEmitters, pool.NumActiveEmitters() );
+	EXPECT_EQ( 0u, pool.GetStats().emittersCulled );
+
+	// Same priority is culled, oldest first
+	EXPECT_TRUE( pool.StartEffect( high, CVector3::kZero ) );
+	EXPECT_EQ( 1u, pool.GetStats().emittersCulled );
+}
+
+TEST( EmitterPool, DropsEffectLargerThanBudget )
+{
+	CEmitterPool pool( 256 );
+	SParticleEffectDesc low = EffectDesc( 1, 64 );
+	SParticleEffectDesc large = EffectDesc( 3, 512 );
+	ASSERT_TRUE( pool.StartEffect( low, CVector3::kZero ) );
+
+	EXPECT_FALSE( pool.StartEffect( large, CVector3::kZero ) );
+	EXPECT_EQ( 1u, pool.NumActiveEmitters() );
+	EXPECT_EQ( 0u, pool.GetStats().emittersCulled );
+}
@@ -0,0 +1,136 @@
+/*******************************************
+	MeshDataTests.cpp
+
+	Tests of the sub-mesh helpers in
+	MeshData.h - vertex sizes, and walking
+	the triangles and vertices of a list of
+	sub-meshes as CMesh's enumeration does
+********************************************/
+
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "MeshData.h"
+
+using namespace gen;
+
+namespace
+{
+
+// Vertex with a normal, so positions are not packed together
+struct STestVertex
+{
+	TFloat32 position[3];
+	TFloat32 normal[3];
+};
+
+// Two sub-meshes with a third, empty one between them. The first uses 16-bit faces, the last
+// 32-bit faces. Each vertex's x coordinate is its index over all sub-meshes, and each face's
+// vertices are in reverse order
+class MeshEnumeration : public testing::Test
+{
+protected:
+	void SetUp()
+	{
+		for (TUInt32 vertex = 0; vertex < 7; ++vertex)
+		{
+			STestVertex testVertex = { { static_cast<TFloat32>(vertex), 1.0f, 2.0f }, { 0.0f, 1.0f, 0.0f } };
+			m_Vertices.push_back( testVertex );
+		}
+		SMeshFace smallFaces[2] = { { { 2, 1, 0 } }, { { 3, 2, 1 } } };
+		m_SmallFaces.assign( smallFaces, smallFaces + 2 );
+		SMeshLargeFace largeFace = { { 2, 1, 0 } };
+		m_LargeFaces.push_back( largeFace );
+
+		SSubMesh subMesh = {};
+		subMesh.vertexSize = sizeof(STestVertex);
+		subMesh.hasNormals = true;
+
+		subMesh.numVertices = 4;
+		subMesh.vertices = reinterpret_cast<TUInt8*>(&m_Vertices[0]);
+		subMesh.numFaces = 2;
+		subMesh.faces = &m_SmallFaces[0];
+		m_SubMeshes[0] = subMesh;
+
+		m_SubMeshes[1] = subMesh;
+		m_SubMeshes[1].numVertices = 0;
+		m_SubMeshes[1].vertices = 0;
+		m_SubMeshes[1].numFaces = 0;
+		m_SubMeshes[1].faces = 0;
+
+		subMesh.numVertices = 3;
+		subMesh.vertices = reinterpret_cast<TUInt8*>(&m_Vertices[4]);
+		subMesh.numFaces = 1;
+		subMesh.faces = 0;
+		subMesh.largeFaces = &m_LargeFaces[0];
+		m_SubMeshes[2] = subMesh;
+	}
+
+	vector<STestVertex>    m_Vertices;
+	vector<SMeshFace>      m_SmallFaces;
+	vector<SMeshLargeFace> m_LargeFaces;
+	SSubMesh               m_SubMeshes[3];
+};
+
+} // namespace
+
+
+TEST_F( MeshEnumeration, TrianglesWalkToEnd )
+{
+	const TFloat32 expectedX[3][3] = { { 2, 1, 0 }, { 3, 2, 1 }, { 6, 5, 4 } };
+
+	TUInt32 subMesh = 0, face = 0;
+	CVector3 vertex1, vertex2, vertex3;
+	for (TUInt32 triangle = 0; triangle < 3; ++triangle)
+	{
+		ASSERT_TRUE( GetNextTriangle( m_SubMeshes, 3, &subMesh, &face, &vertex1, &vertex2, &vertex3 ) );
+		EXPECT_EQ( expectedX[triangle][0], vertex1.x );
+		EXPECT_EQ( expectedX[triangle][1], vertex2.x );
+		EXPECT_EQ( expectedX[triangle][2], vertex3.x );
+		EXPECT_EQ( 1.0f, vertex1.y );
+		EXPECT_EQ( 2.0f, vertex3.z );
+	}
+
+	// Finished, and stays finished
+	EXPECT_FALSE( GetNextTriangle( m_SubMeshes, 3, &subMesh, &face, &vertex1, &vertex2, &vertex3 ) );
+	EXPECT_FALSE( GetNextTriangle( m_SubMeshes, 3, &subMesh, &face, &vertex1, &vertex2, &vertex3 ) );
+}
+
+TEST_F( MeshEnumeration, VerticesWalkToEnd )
+{
+	TUInt32 subMesh = 0, vertex = 0;
+	CVector3 position;
+	for (TUInt32 expected = 0; expected < 7; ++expected)
+	{
+		ASSERT_TRUE( GetNextVertex( m_SubMeshes, 3, &subMesh, &vertex, &position ) );
+		EXPECT_EQ( static_cast<TFloat32>(expected), position.x );
+		EXPECT_EQ( 1.0f, position.y );
+		EXPECT_EQ( 2.0f, position.z );
+	}
+
+	EXPECT_FALSE( GetNextVertex( m_SubMeshes, 3, &subMesh, &vertex, &position ) );
+	EXPECT_FALSE( GetNextVertex( m_SubMeshes, 3, &subMesh, &vertex, &position ) );
+}
+
+TEST_F( MeshEnumeration, NoSubMeshesWithGeometry )
+{
+	TUInt32 subMesh = 0, item = 0;
+	CVector3 vertex1, vertex2, vertex3;
+	EXPECT_FALSE( GetNextTriangle( &m_SubMeshes[1], 1, &subMesh, &item, &vertex1, &vertex2, &vertex3 ) );
+	subMesh = item = 0;
+	EXPECT_FALSE( GetNextVertex( &m_SubMeshes[1], 1, &subMesh, &item, &vertex1 ) );
+	subMesh = item = 0;
+	EXPECT_FALSE( GetNextVertex( m_SubMeshes, 0, &subMesh, &item, &vertex1 ) );
+}
+
+TEST( VertexLayout, SizeMatchesComponents )
+{
+	SSubMesh subMesh = {};
+	EXPECT_EQ( sizeof(STestVertex) - 3 * sizeof(TFloat32), GetVertexSize( subMesh ) );
+	subMesh.hasNormals = true;
+	EXPECT_EQ( sizeof(STestVertex), GetVertexSize( subMesh ) );
+
+	// Colours are the last component
+	subMesh.hasSkinningData = subMesh.hasTangents = subMesh.hasTextureCoords = subMesh.hasVertexColours = true;
+	EXPECT_EQ( GetVertexLayout( subMesh ).colour + 4 * sizeof(TFloat32), GetVertexSize( subMesh ) );
+}
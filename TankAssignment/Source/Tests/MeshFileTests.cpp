@@ -0,0 +1,146 @@
+/*******************************************
+	MeshFileTests.cpp
+
+	Tests of cooked mesh files - levels of
+	detail surviving a write and read, and
+	files rejected when opened
+********************************************/
+
+#include <cstdio>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "MeshFile.h"
+
+namespace gen
+{
+
+// Referred to by MeshFile.cpp, defined with the render methods in the game
+extern const string MediaFolder = "Media\\";
+
+} // namespace gen
+
+using namespace gen;
+
+namespace
+{
+
+const char* const kTestFileName = "MeshFileTest.mesh";
+
+// A flat grid of 128 faces with a raised centre, so it simplifies into several levels with some
+// error. Vertices are positions only, a single root node and material
+class MeshFileTest : public testing::Test
+{
+protected:
+	void SetUp()
+	{
+		const TUInt32 size = 9;
+		for (TUInt32 z = 0; z < size; ++z)
+		{
+			for (TUInt32 x = 0; x < size; ++x)
+			{
+				m_Vertices.push_back( static_cast<TFloat32>(x) );
+				m_Vertices.push_back( (x == size / 2 && z == size / 2) ? 2.0f : 0.0f );
+				m_Vertices.push_back( static_cast<TFloat32>(z) );
+				if (x + 1 < size && z + 1 < size)
+				{
+					TUInt16 corner = static_cast<TUInt16>(z * size + x);
+					SMeshFace face1 = { { corner, static_cast<TUInt16>(corner + size), static_cast<TUInt16>(corner + 1) } };
+					SMeshFace face2 = { { static_cast<TUInt16>(corner + 1), static_cast<TUInt16>(corner + size),
+					                      static_cast<TUInt16>(corner + size + 1) } };
+					m_Faces.push_back( face1 );
+					m_Faces.push_back( face2 );
+				}
+			}
+		}
+		m_Vertices.resize( m_Vertices.size() * 2 ); // Room to write larger vertices than these
+
+		SSubMesh subMesh = {};
+		subMesh.numVertices = size * size;
+		subMesh.vertices = reinterpret_cast<TUInt8*>(&m_Vertices[0]);
+		subMesh.vertexSize = 3 * sizeof(TFloat32);
+		subMesh.numFaces = static_cast<TUInt32>(m_Faces.size());
+		subMesh.faces = &m_Faces[0];
+		m_SubMeshes.push_back( subMesh );
+
+		m_Nodes.resize( 1 );
+		m_Nodes[0].name = "Root";
+		m_Nodes[0].depth = 0;
+		m_Nodes[0].parent = 0;
+		m_Nodes[0].numChildren = 0;
+		m_Materials.resize( 1 );
+		m_Materials[0].renderMethod = PlainColour;
+		m_Materials[0].numTextures = 0;
+	}
+
+	void TearDown()
+	{
+		remove( kTestFileName );
+	}
+
+	// Write the test file with the current nodes and sub-meshes and the given levels of detail
+	bool WriteFile( TUInt32 numLods = 1, const vector<SSubMeshLod>& subMeshLods = vector<SSubMeshLod>() )
+	{
+		vector<SMeshBounds> nodeBounds( m_Nodes.size() ), subMeshBounds( m_SubMeshes.size() );
+		return CMeshFile::Write( kTestFileName, 0, 0, m_Nodes, m_Materials, m_SubMeshes, nodeBounds,
+		                         subMeshBounds, SMeshBounds(), numLods, subMeshLods );
+	}
+
+	vector<TFloat32>      m_Vertices;
+	vector<SMeshFace>     m_Faces;
+	vector<SSubMesh>      m_SubMeshes;
+	vector<SMeshNode>     m_Nodes;
+	vector<SMeshMaterial> m_Materials;
+};
+
+} // namespace
+
+
+TEST_F( MeshFileTest, LevelsOfDetailRoundTrip )
+{
+	vector<SSubMeshLod> subMeshLods;
+	SMeshLod lods[kiMaxMeshLods];
+	TUInt32 numLods = SimplifyMesh( &m_SubMeshes[0], 1, &subMeshLods, lods );
+	ASSERT_GT( numLods, 1u );
+	ASSERT_TRUE( WriteFile( numLods, subMeshLods ) );
+
+	CMeshFile file;
+	ASSERT_TRUE( file.Open( kTestFileName ) );
+	EXPECT_EQ( numLods, file.GetNumLods() );
+	for (TUInt32 lod = 1; lod < numLods; ++lod)
+	{
+		SSubMeshLod read;
+		file.GetSubMeshLod( 0, lod, &read );
+		EXPECT_EQ( subMeshLods[lod - 1].indices, read.indices );
+		EXPECT_EQ( subMeshLods[lod - 1].error, read.error );
+	}
+}
+
+TEST_F( MeshFileTest, RejectsVertexSizeNotMatchingComponents )
+{
+	ASSERT_TRUE( WriteFile() );
+	CMeshFile file;
+	EXPECT_TRUE( file.Open( kTestFileName ) );
+	file.Close();
+
+	m_SubMeshes[0].vertexSize = 4 * sizeof(TFloat32);
+	ASSERT_TRUE( WriteFile() );
+	EXPECT_FALSE( file.Open( kTestFileName ) );
+}
+
+TEST_F( MeshFileTest, RejectsChildBeforeParent )
+{
+	m_Nodes.resize( 3, m_Nodes[0] );
+	m_Nodes[0].numChildren = 2;
+	m_Nodes[1].depth = m_Nodes[2].depth = 1;
+	m_Nodes[1].parent = 0;
+	m_Nodes[2].parent = 0;
+	ASSERT_TRUE( WriteFile() );
+	CMeshFile file;
+	EXPECT_TRUE( file.Open( kTestFileName ) );
+	file.Close();
+
+	m_Nodes[1].parent = 2;
+	ASSERT_TRUE( WriteFile() );
+	EXPECT_FALSE( file.Open( kTestFileName ) );
+}
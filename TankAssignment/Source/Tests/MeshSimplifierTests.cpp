@@ -0,0 +1,87 @@
+/*******************************************
+	MeshSimplifierTests.cpp
+
+	Tests of the error measured when
+	simplifying sub-meshes into levels of
+	detail
+********************************************/
+
+#include <cmath>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include "MeshSimplifier.h"
+
+using namespace gen;
+
+namespace
+{
+
+// Positions-only sub-mesh over the given vertex coordinates and faces
+SSubMesh TestSubMesh( vector<TFloat32>& vertices, vector<SMeshFace>& faces )
+{
+	SSubMesh subMesh = {};
+	subMesh.numVertices = static_cast<TUInt32>(vertices.size()) / 3;
+	subMesh.vertices = reinterpret_cast<TUInt8*>(&vertices[0]);
+	subMesh.vertexSize = 3 * sizeof(TFloat32);
+	subMesh.numFaces = static_cast<TUInt32>(faces.size());
+	subMesh.faces = &faces[0];
+	return subMesh;
+}
+
+} // namespace
+
+
+// A square open pyramid of four faces. The cheapest collapse moves the apex onto a corner, leaving
+// the flat base. The corner lies on the planes of the two faces it was part of, and is 2h/sqrt(1+h^2)
+// from the planes of the other two - the error, not the sum of squares over both of them
+TEST( MeshSimplifier, ErrorIsLargestPlaneDistance )
+{
+	const TFloat32 height = 1.0f;
+	TFloat32 corners[] = { 0.0f, height, 0.0f,  -1.0f, 0.0f, -1.0f,  1.0f, 0.0f, -1.0f,
+	                       1.0f, 0.0f, 1.0f,  -1.0f, 0.0f, 1.0f };
+	vector<TFloat32> vertices( corners, corners + 15 );
+	SMeshFace pyramid[] = { { { 0, 1, 2 } }, { { 0, 2, 3 } }, { { 0, 3, 4 } }, { { 0, 4, 1 } } };
+	vector<SMeshFace> faces( pyramid, pyramid + 4 );
+
+	TUInt32 targetFaces = 2;
+	SSubMeshLod level;
+	SimplifySubMesh( TestSubMesh( vertices, faces ), &targetFaces, 1, &level );
+	EXPECT_EQ( 6u, level.indices.size() );
+	EXPECT_NEAR( 2.0f * height / sqrt( 1.0f + height * height ), level.error, 1e-5f );
+}
+
+// Collapses within a flat surface do not move it
+TEST( MeshSimplifier, FlatGridHasNoError )
+{
+	const TUInt32 size = 9;
+	vector<TFloat32> vertices;
+	vector<SMeshFace> faces;
+	for (TUInt32 z = 0; z < size; ++z)
+	{
+		for (TUInt32 x = 0; x < size; ++x)
+		{
+			vertices.push_back( static_cast<TFloat32>(x) );
+			vertices.push_back( 0.0f );
+			vertices.push_back( static_cast<TFloat32>(z) );
+			if (x + 1 < size && z + 1 < size)
+			{
+				TUInt16 corner = static_cast<TUInt16>(z * size + x);
+				SMeshFace face1 = { { corner, static_cast<TUInt16>(corner + size), static_cast<TUInt16>(corner + 1) } };
+				SMeshFace face2 = { { static_cast<TUInt16>(corner + 1), static_cast<TUInt16>(corner + size),
+				                      static_cast<TUInt16>(corner + size + 1) } };
+				faces.push_back( face1 );
+				faces.push_back( face2 );
+			}
+		}
+	}
+
+	TUInt32 targetFaces[] = { 64, 16 };
+	SSubMeshLod levels[2];
+	SimplifySubMesh( TestSubMesh( vertices, faces ), targetFaces, 2, levels );
+	for (TUInt32 level = 0; level < 2; ++level)
+	{
+		EXPECT_GE( targetFaces[level], levels[level].indices.size() / 3 );
+		EXPECT_EQ( 0.0f, levels[level].error );
+	}
+}
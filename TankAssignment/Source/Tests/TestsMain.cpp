@@ -0,0 +1,15 @@
+/*******************************************
+	TestsMain.cpp
+
+	Entry point for the unit test executable.
+	Tests register themselves from their own
+	files, see e.g. MeshDataTests.cpp
+********************************************/
+
+#include <gtest/gtest.h>
+
+int main( int argc, char** argv )
+{
+	testing::InitGoogleTest( &argc, argv );
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,107 @@
+"""
+	CompareBenchmarks.py
+
+	Compares a Google Benchmark JSON result file against a stored baseline
+	and reports any benchmark that has slowed down beyond a threshold.
+	Returns a non-zero exit code if there are regressions, so it can gate
+	a build step.
+
+	Typical use (from the TankAssignment folder):
+	  Benchmark.exe --benchmark_out=Current.json --benchmark_out_format=json
+	                --benchmark_repetitions=5
+	  python Tools\\CompareBenchmarks.py Current.json
+
+	Record a new baseline after an intended change (or on a new machine):
+	  python Tools\\CompareBenchmarks.py Current.json --update
+
+	Baselines are machine specific - only compare results from the same PC
+	and build configuration (Release).
+"""
+
+import argparse
+import json
+import os
+import shutil
+import sys
+
+DEFAULT_BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "BenchmarkBaseline.json")
+
+
+def load_times(path, metric):
+	"""Return {benchmark name: time in ns} from a benchmark JSON file.
+	If the run used repetitions, the median aggregate is used for stability"""
+	with open(path) as f:
+		data = json.load(f)
+
+	scale = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+	plain = {}
+	medians = {}
+	for b in data.get("benchmarks", []):
+		time = b[metric] * scale[b.get("time_unit", "ns")]
+		if b.get("run_type") == "aggregate":
+			if b.get("aggregate_name") == "median":
+				medians[b["run_name"]] = time
+		else:
+			# Repetitions without aggregates appear several times - keep the fastest
+			name = b.get("run_name", b["name"])
+			plain[name] = min(time, plain.get(name, time))
+
+	plain.update(medians)
+	return plain, data.get("context", {})
+
+
+def main():
+	parser = argparse.ArgumentParser(description="Compare benchmark results against a baseline")
+	parser.add_argument("current", help="JSON output from the benchmark executable")
+	parser.add_argument("--baseline", default=DEFAULT_BASELINE, help="baseline JSON file")
+	parser.add_argument("--threshold", type=float, default=5.0,
+	                    help="percentage slowdown reported as a regression (default 5)")
+	parser.add_argument("--metric", choices=["cpu_time", "real_time"], default="cpu_time")
+	parser.add_argument("--update", action="store_true",
+	                    help="replace the baseline with the current results")
+	args = parser.parse_args()
+
+	if args.update:
+		shutil.copyfile(args.current, args.baseline)
+		print("Baseline updated: " + os.path.normpath(args.baseline))
+		return 0
+
+	if not os.path.exists(args.baseline):
+		print("No baseline at " + os.path.normpath(args.baseline) + " - record one with --update")
+		return 2
+
+	base, base_context = load_times(args.baseline, args.metric)
+	curr, curr_context = load_times(args.current, args.metric)
+
+	if base_context.get("host_name") != curr_context.get("host_name"):
+		print("Warning: baseline was recorded on a different machine (%s)" %
+		      base_context.get("host_name", "unknown"))
+	if curr_context.get("library_build_type") == "debug":
+		print("Warning: benchmark library is a debug build, timings are unreliable")
+
+	regressions = []
+	width = max([len(n) for n in curr] + [9])
+	print("%-*s %12s %12s %8s" % (width, "Benchmark", "Base (ns)", "Curr (ns)", "Change"))
+	for name in sorted(curr):
+		if name not in base:
+			print("%-*s %12s %12.1f %8s" % (width, name, "-", curr[name], "new"))
+			continue
+		change = (curr[name] - base[name]) / base[name] * 100.0
+		flag = ""
+		if change > args.threshold:
+			flag = "  REGRESSION"
+			regressions.append(name)
+		print("%-*s %12.1f %12.1f %+7.1f%%%s" % (width, name, base[name], curr[name], change, flag))
+
+	for name in sorted(set(base) - set(curr)):
+		print("%-*s %12.1f %12s %8s" % (width, name, base[name], "-", "missing"))
+
+	if regressions:
+		print("\n%d benchmark(s) regressed by more than %.1f%%" % (len(regressions), args.threshold))
+		return 1
+	print("\nNo regressions beyond %.1f%%" % args.threshold)
+	return 0
+
+
+if __name__ == "__main__":
+	sys.exit(main())